@@ -52,6 +52,9 @@ int main(int argc, char** argv)
 		Console::write_line( string_format("aes = %1",  System::detect_cpu_extension(System::aes)) );
 		Console::write_line( string_format("fma3 = %1",  System::detect_cpu_extension(System::fma3)) );
 		Console::write_line( string_format("fma4 = %1",  System::detect_cpu_extension(System::fma4)) );
+		Console::write_line( string_format("pclmulqdq = %1",  System::detect_cpu_extension(System::pclmulqdq)) );
+		Console::write_line( string_format("avx2 = %1",  System::detect_cpu_extension(System::avx2)) );
+		Console::write_line( string_format("sha = %1",  System::detect_cpu_extension(System::sha)) );
 		Console::write_line( string_format("num cores = %1",  System::get_num_cores()) );
 		console.display_close_message();
 	} 
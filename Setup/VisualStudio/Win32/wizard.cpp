@@ -315,6 +315,14 @@ Workspace Wizard::create_workspace(bool target_android)
 		libs_list_release,
 		libs_list_debug, ignore_list, exclude_list);
 
+	Project clanSWRender(
+		"SWRender",
+		"clanSWRender",
+		"swrender.h",
+		libs_list_shared,
+		libs_list_release,
+		libs_list_debug, ignore_list, exclude_list);
+
 	Project clanUI(
 		"UI",
 		"clanUI",
@@ -339,6 +347,7 @@ Workspace Wizard::create_workspace(bool target_android)
 	workspace.projects.push_back(clanDisplay);
 	workspace.projects.push_back(clanSound);
 	workspace.projects.push_back(clanGL);
+	workspace.projects.push_back(clanSWRender);
 	workspace.projects.push_back(clanUI);
 	workspace.projects.push_back(clanXML);
 
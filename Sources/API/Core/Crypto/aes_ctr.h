@@ -0,0 +1,83 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class AES_CTR_Impl;
+
+	/// \brief AES encryption and decryption in Counter mode (AES-128, AES-192 or AES-256 depending on the key size)
+	///
+	/// Data is processed in place in any sized pieces, without padding or intermediate buffers.
+	/// Encryption and decryption are the same operation.\n
+	/// Uses AES-NI when the CPU supports it. The fallback table implementation is not constant-time.
+	class AES_CTR
+	{
+	public:
+		/// \brief Constructs an AES counter mode cipher
+		AES_CTR();
+
+		static const int iv_size = 16;
+		static const int block_size = 16;
+
+		/// \brief Returns true if the AES instructions of the CPU are used
+		static bool is_hardware_accelerated();
+
+		/// \brief Sets the cipher key
+		///
+		/// \param key = The key
+		/// \param key_size = 16, 24 or 32 bytes for AES-128, AES-192 or AES-256
+		void set_key(const unsigned char *key, int key_size);
+
+		/// \brief Sets the initial counter block
+		///
+		/// The 16 bytes are incremented as a big endian number for each block. A counter block must never be used twice with the same key.\n
+		/// This must be called after set_key() and before process()
+		void set_iv(const unsigned char iv[iv_size]);
+
+		/// \brief Encrypts or decrypts data in place
+		void process(void *data, int size);
+
+		/// \brief Encrypts or decrypts data from input into output (which may be the same buffer)
+		void process(const void *input, void *output, int size);
+
+		/// \brief Removes the key and counter from memory
+		void reset();
+
+	private:
+		std::shared_ptr<AES_CTR_Impl> impl;
+	};
+
+	/// \}
+}
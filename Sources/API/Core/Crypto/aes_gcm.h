@@ -0,0 +1,105 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class AES_GCM_Impl;
+
+	/// \brief AES authenticated encryption in Galois/Counter Mode (AES-128, AES-192 or AES-256 depending on the key size)
+	///
+	/// For each message: call set_iv(), add the additional authenticated data with add_aad(), encrypt or decrypt the message
+	/// in place in any sized pieces, and finish with get_tag() or verify_tag(). The key is kept between messages.\n
+	/// Uses AES-NI and PCLMULQDQ when the CPU supports them. The fallback table implementation is not constant-time.\n
+	/// Decrypted data must not be trusted before verify_tag() has returned true.
+	class AES_GCM
+	{
+	public:
+		/// \brief Constructs an AES-GCM cipher
+		AES_GCM();
+
+		static const int iv_size = 12;
+		static const int tag_size = 16;
+		static const int block_size = 16;
+
+		/// \brief Returns true if the AES and carry-less multiplication instructions of the CPU are used
+		static bool is_hardware_accelerated();
+
+		/// \brief Sets the cipher key
+		///
+		/// \param key = The key
+		/// \param key_size = 16, 24 or 32 bytes for AES-128, AES-192 or AES-256
+		void set_key(const unsigned char *key, int key_size);
+
+		/// \brief Starts a new message
+		///
+		/// An IV must never be used twice with the same key. 12 bytes (iv_size) is recommended, other sizes are hashed.
+		void set_iv(const unsigned char *iv, int size = iv_size);
+
+		/// \brief Adds data that is authenticated but not encrypted
+		///
+		/// This must be called before encrypt() or decrypt()
+		void add_aad(const void *data, int size);
+
+		/// \brief Encrypts data in place
+		void encrypt(void *data, int size);
+
+		/// \brief Encrypts data from input into output (which may be the same buffer)
+		void encrypt(const void *input, void *output, int size);
+
+		/// \brief Decrypts data in place
+		void decrypt(void *data, int size);
+
+		/// \brief Decrypts data from input into output (which may be the same buffer)
+		void decrypt(const void *input, void *output, int size);
+
+		/// \brief Finishes the message and returns the authentication tag
+		void get_tag(unsigned char tag[tag_size]);
+
+		/// \brief Finishes the message and compares the authentication tag in constant time
+		///
+		/// \param tag = The received tag
+		/// \param size = Size of the received tag (12 to 16 bytes). Shorter tags throw an exception, as they are too easy to forge
+		/// \return true if the message is authentic
+		bool verify_tag(const unsigned char *tag, int size = tag_size);
+
+		/// \brief Removes the key and message state from memory
+		void reset();
+
+	private:
+		std::shared_ptr<AES_GCM_Impl> impl;
+	};
+
+	/// \}
+}
@@ -36,6 +36,7 @@ namespace clan
 	/// \{
 
 	class DataBuffer;
+	class WorkQueue;
 	class SHA1_Impl;
 
 	/// \brief SHA-1 hash function class.
@@ -77,6 +78,18 @@ namespace clan
 		/// \brief Finalize hash calculation.
 		void calculate();
 
+		/// \brief Hashes many independent buffers
+		///
+		/// Uses the SHA extensions of the CPU when available, otherwise hashes several buffers at once in the
+		/// vector lanes when the CPU supports AVX2. With a work queue the buffers are also split across its workers.
+		///
+		/// \param count = Number of buffers
+		/// \param data = Pointers to the buffers
+		/// \param sizes = Size of each buffer
+		/// \param out_hashes = Receives count hashes, hash_size bytes each
+		/// \param work_queue = Optional thread pool to hash on
+		static void hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue = nullptr);
+
 	private:
 		std::shared_ptr<SHA1_Impl> impl;
 	};
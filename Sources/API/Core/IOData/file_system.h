@@ -41,6 +41,7 @@ namespace clan
 	class FileSystem_Impl;
 	class FileSystemProvider;
 	class DirectoryListing;
+	class ZipMappedArchive;
 
 	/// \brief Virtual File System (VFS).
 	class FileSystem
@@ -60,6 +61,11 @@ namespace clan
 		/// \param is_zip_file = bool
 		FileSystem(const std::string &path, bool is_zip_file = false);
 
+		/// \brief Constructs a FileSystem reading from a memory mapped zip archive
+		///
+		/// \param zip_archive = Archive to read from. Files prefetched on the archive are opened from memory.
+		FileSystem(const ZipMappedArchive &zip_archive);
+
 		~FileSystem();
 
 		/// \brief Returns true if the file system is null.
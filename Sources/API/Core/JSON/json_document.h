@@ -0,0 +1,168 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "json_value.h"
+#include <cstring>
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class DataBuffer;
+	class JsonDocument_Impl;
+	struct JsonDocumentNode;
+	struct JsonDocumentMember;
+
+	/// \brief Reference to a string stored in a JsonDocument
+	///
+	/// The string is not zero terminated and is only valid while the document exists.
+	class JsonStringRef
+	{
+	public:
+		JsonStringRef() { }
+		JsonStringRef(const char *data, size_t length) : _data(data), _length(length) { }
+
+		const char *data() const { return _data; }
+		size_t size() const { return _length; }
+		size_t length() const { return _length; }
+		bool empty() const { return _length == 0; }
+
+		const char *begin() const { return _data; }
+		const char *end() const { return _data + _length; }
+
+		std::string str() const { return std::string(_data, _length); }
+
+		bool equals(const char *str, size_t length) const { return _length == length && memcmp(_data, str, length) == 0; }
+
+		bool operator==(const std::string &other) const { return equals(other.data(), other.length()); }
+		bool operator==(const char *other) const { return equals(other, strlen(other)); }
+		bool operator!=(const std::string &other) const { return !(*this == other); }
+		bool operator!=(const char *other) const { return !(*this == other); }
+
+	private:
+		const char *_data = "";
+		size_t _length = 0;
+	};
+
+	/// \brief Read-only value in a JsonDocument
+	///
+	/// Nodes are small handles into the document and are only valid while the document exists.
+	/// Missing properties and out of range items are returned as undefined nodes.
+	class JsonNode
+	{
+	public:
+		JsonNode() { }
+		explicit JsonNode(const JsonDocumentNode *node) : node(node) { }
+
+		JsonType type() const;
+		bool is_undefined() const { return type() == JsonType::undefined; }
+		bool is_null() const { return type() == JsonType::null; }
+		bool is_object() const { return type() == JsonType::object; }
+		bool is_array() const { return type() == JsonType::array; }
+		bool is_number() const { return type() == JsonType::number; }
+		bool is_boolean() const { return type() == JsonType::boolean; }
+		bool is_string() const { return type() == JsonType::string; }
+
+		/// \brief Number of array items or object properties
+		size_t size() const;
+
+		/// \brief Array item
+		JsonNode at(size_t index) const;
+
+		/// \brief Object property, found by binary search
+		JsonNode prop(const char *name, size_t length) const;
+		JsonNode prop(const char *name) const { return prop(name, strlen(name)); }
+		JsonNode prop(const std::string &name) const { return prop(name.data(), name.length()); }
+
+		/// \brief Name of an object property. Properties are sorted by name
+		JsonStringRef key(size_t index) const;
+
+		/// \brief Value of an object property. Properties are sorted by name
+		JsonNode value(size_t index) const;
+
+		double to_number() const;
+		bool to_boolean() const;
+		JsonStringRef to_string() const;
+
+		double to_double() const { return to_number(); }
+		float to_float() const { return static_cast<float>(to_number()); }
+		int to_int() const { return static_cast<int>(to_number()); }
+		unsigned int to_uint() const { return static_cast<unsigned int>(to_number()); }
+
+		/// \brief Copies the node and its children into a JsonValue
+		JsonValue to_value() const;
+
+		JsonNode operator[](size_t index) const { return at(index); }
+		JsonNode operator[](const char *name) const { return prop(name); }
+		JsonNode operator[](const std::string &name) const { return prop(name); }
+
+	private:
+		const JsonDocumentNode *node = nullptr;
+	};
+
+	/// \brief Read-only JSON document
+	///
+	/// A faster alternative to JsonValue::parse for large documents. The document keeps its own copy
+	/// of the JSON text and decodes strings in place, so strings and property names point into it
+	/// instead of being allocated one by one. Nodes are allocated from a single block allocator, and
+	/// the properties of an object are stored in one array sorted by name.
+	class JsonDocument
+	{
+	public:
+		/// \brief Constructs a null document
+		JsonDocument();
+
+		/// \brief Parses a document. Throws JsonException on malformed JSON
+		static JsonDocument parse(const std::string &json);
+		static JsonDocument parse(const char *json, size_t length);
+		static JsonDocument parse(const DataBuffer &json);
+
+		/// \brief Reads the rest of the device and parses it
+		static JsonDocument parse(IODevice &device);
+
+		/// \brief Returns true if this object is invalid.
+		bool is_null() const { return !impl; }
+		explicit operator bool() const { return bool(impl); }
+
+		/// \brief Throw an exception if this object is invalid.
+		void throw_if_null() const;
+
+		/// \brief Returns the top level value
+		JsonNode root() const;
+
+	private:
+		std::shared_ptr<JsonDocument_Impl> impl;
+	};
+
+	/// \}
+}
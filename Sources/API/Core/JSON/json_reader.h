@@ -0,0 +1,78 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class DataBuffer;
+
+	/// \brief Receives the values of a JSON document while JsonReader parses it
+	///
+	/// Strings and keys are passed as pointer and length, without a terminating zero.
+	/// They are only valid until the function returns.
+	class JsonHandler
+	{
+	public:
+		virtual ~JsonHandler() { }
+
+		virtual void null_value() { }
+		virtual void boolean_value(bool value) { }
+		virtual void number_value(double value) { }
+		virtual void string_value(const char *data, size_t length) { }
+
+		virtual void begin_object() { }
+		virtual void object_key(const char *data, size_t length) { }
+		virtual void end_object() { }
+
+		virtual void begin_array() { }
+		virtual void end_array() { }
+	};
+
+	/// \brief Event based JSON parser
+	///
+	/// Reports every value of a document to a JsonHandler in document order, without building a tree.
+	/// When parsing from an IODevice, only a small window of the document is kept in memory.
+	/// Throws JsonException on malformed JSON, including anything but whitespace after the top-level value.
+	class JsonReader
+	{
+	public:
+		static void parse(const std::string &json, JsonHandler &handler);
+		static void parse(const char *json, size_t length, JsonHandler &handler);
+		static void parse(const DataBuffer &json, JsonHandler &handler);
+		static void parse(IODevice &device, JsonHandler &handler);
+	};
+
+	/// \}
+}
@@ -135,11 +135,11 @@ namespace clan
 
 		/// \brief  Compute c = (a ** b) mod m.
 		///
-		/// Uses a standard square-and-multiply
-		/// method with modular reductions at each step. (This is basically the
-		/// same code as expt(), except for the addition of the reductions)
+		/// For odd moduli, such as the ones used by RSA, this uses Montgomery multiplication
+		/// with a sliding window over the bits of the exponent.
 		///
-		/// The modular reductions are done using Barrett's algorithm (see reduce() for details)
+		/// Even moduli use a standard square-and-multiply method with the modular reductions
+		/// done using Barrett's algorithm (see reduce() for details)
 		void exptmod(const BigInt *b, const BigInt *m, BigInt *c) const;
 
 		/// \brief  Compute c = a (mod m).  Result will always be 0 <= c < m.
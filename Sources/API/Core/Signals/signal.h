@@ -32,6 +32,10 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <deque>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace clan
 {
@@ -63,78 +67,333 @@ namespace clan
 		virtual ~SlotImpl() { }
 	};
 
-	template<typename SlotImplType>
-	class SignalImpl
+	template<typename FuncType>
+	class SignalCallback;
+
+	/// \brief Callback stored by a signal
+	///
+	/// Callables up to inline_size bytes, such as member function bindings and lambdas capturing a few
+	/// pointers, are stored in place. Larger ones are allocated once when connected.
+	template<typename R, typename... Args>
+	class SignalCallback<R(Args...)>
 	{
 	public:
-		std::vector<std::weak_ptr<SlotImplType>> slots;
+		enum { inline_size = 32 };
+
+		SignalCallback() { }
+		SignalCallback(const SignalCallback &) = delete;
+		SignalCallback &operator=(const SignalCallback &) = delete;
+		~SignalCallback() { reset(); }
+
+		explicit operator bool() const { return invoke_func != nullptr; }
+
+		template<typename Func>
+		void assign(Func &&func)
+		{
+			typedef typename std::decay<Func>::type Functor;
+			reset();
+			assign_impl<Functor>(std::forward<Func>(func), std::integral_constant<bool, sizeof(Functor) <= sizeof(Storage) && alignof(Functor) <= alignof(Storage)>());
+		}
+
+		void reset()
+		{
+			if (destroy_func)
+				destroy_func(&storage);
+			invoke_func = nullptr;
+			destroy_func = nullptr;
+		}
+
+		template<typename... CallArgs>
+		R operator()(CallArgs&&... args)
+		{
+			return invoke_func(&storage, std::forward<CallArgs>(args)...);
+		}
+
+	private:
+		typedef typename std::aligned_storage<inline_size>::type Storage;
+
+		template<typename Functor, typename Func>
+		void assign_impl(Func &&func, std::true_type)
+		{
+			new (&storage) Functor(std::forward<Func>(func));
+			invoke_func = &invoke_inline<Functor>;
+			destroy_func = &destroy_inline<Functor>;
+		}
+
+		template<typename Functor, typename Func>
+		void assign_impl(Func &&func, std::false_type)
+		{
+			*reinterpret_cast<Functor **>(&storage) = new Functor(std::forward<Func>(func));
+			invoke_func = &invoke_heap<Functor>;
+			destroy_func = &destroy_heap<Functor>;
+		}
+
+		template<typename Functor>
+		static R invoke_inline(void *storage, Args... args) { return static_cast<R>((*static_cast<Functor *>(storage))(std::forward<Args>(args)...)); }
+
+		template<typename Functor>
+		static void destroy_inline(void *storage) { static_cast<Functor *>(storage)->~Functor(); }
+
+		template<typename Functor>
+		static R invoke_heap(void *storage, Args... args) { return static_cast<R>((**static_cast<Functor **>(storage))(std::forward<Args>(args)...)); }
+
+		template<typename Functor>
+		static void destroy_heap(void *storage) { delete *static_cast<Functor **>(storage); }
+
+		Storage storage;
+		R(*invoke_func)(void *, Args...) = nullptr;
+		void(*destroy_func)(void *) = nullptr;
 	};
 
 	template<typename FuncType>
-	class SlotImplT : public SlotImpl
+	class SignalImpl
 	{
 	public:
-		SlotImplT(const std::weak_ptr<SignalImpl<SlotImplT>> &signal, const std::function<FuncType> &callback) : signal(signal), callback(callback)
+		enum { end_of_list = 0xffffffff };
+
+		class Entry
 		{
+		public:
+			SignalCallback<FuncType> callback;
+			unsigned int generation = 0;
+			unsigned int next = end_of_list;
+			unsigned int prev = end_of_list;
+			bool connected = false;
+		};
+
+		template<typename Func>
+		unsigned int connect(Func &&func)
+		{
+			// Entries freed before an emit may not be reused during it, as the emit could still be walking past them
+			unsigned int index;
+			if (emit_depth == 0 && !free_entries.empty())
+			{
+				index = free_entries.back();
+				free_entries.pop_back();
+			}
+			else
+			{
+				index = (unsigned int)entries.size();
+				entries.emplace_back();
+			}
+
+			Entry &entry = entries[index];
+			entry.callback.assign(std::forward<Func>(func));
+			entry.connected = true;
+
+			// Slots are linked in connection order, which is the order they are called in
+			entry.prev = tail;
+			entry.next = end_of_list;
+			if (tail != end_of_list)
+				entries[tail].next = index;
+			else
+				head = index;
+			tail = index;
+
+			connected_count++;
+			return index;
 		}
 
-		~SlotImplT()
+		void disconnect(unsigned int index, unsigned int generation)
 		{
-			std::shared_ptr<SignalImpl<SlotImplT>> sig = signal.lock();
-			if (sig)
+			if (index >= entries.size())
+				return;
+
+			Entry &entry = entries[index];
+			if (entry.generation != generation || !entry.connected)
+				return;
+
+			entry.connected = false;
+			connected_count--;
+
+			// A callback being emitted may be the one disconnecting itself
+			if (emit_depth == 0)
+				release(index);
+			else
+				release_pending = true;
+		}
+
+		void begin_emit()
+		{
+			emit_depth++;
+		}
+
+		void end_emit()
+		{
+			if (--emit_depth == 0 && release_pending)
 			{
-				for (auto it = sig->slots.begin(); it != sig->slots.end(); ++it)
+				release_pending = false;
+				for (unsigned int i = 0; i < entries.size(); i++)
 				{
-					// todo: investigate if "it->lock().get() == this" is required
-					if (it->expired() || it->lock().get() == this)
-					{
-						it = sig->slots.erase(it);
-						if (it == sig->slots.end())
-							break;
-					}
+					if (!entries[i].connected && entries[i].callback)
+						release(i);
 				}
 			}
 		}
 
-		std::weak_ptr<SignalImpl<SlotImplT>> signal;
-		std::function<FuncType> callback;
+		// Stable addresses, so connecting during an emit never moves a callback that is running
+		std::deque<Entry> entries;
+		std::vector<unsigned int> free_entries;
+		unsigned int head = end_of_list;
+		unsigned int tail = end_of_list;
+		unsigned int connected_count = 0;
+		int emit_depth = 0;
+		bool release_pending = false;
+
+		// Keeps the implementation alive when the Signal is destroyed by one of its own slots
+		std::shared_ptr<SignalImpl> self;
+
+	private:
+		void release(unsigned int index)
+		{
+			Entry &entry = entries[index];
+			if (entry.prev != end_of_list)
+				entries[entry.prev].next = entry.next;
+			else
+				head = entry.next;
+			if (entry.next != end_of_list)
+				entries[entry.next].prev = entry.prev;
+			else
+				tail = entry.prev;
+
+			entry.callback.reset();
+			entry.generation++;
+			entry.next = end_of_list;
+			entry.prev = end_of_list;
+			free_entries.push_back(index);
+		}
+	};
+
+	template<typename FuncType>
+	class SlotImplT : public SlotImpl
+	{
+	public:
+		SlotImplT(const std::weak_ptr<SignalImpl<FuncType>> &signal, unsigned int index, unsigned int generation) : signal(signal), index(index), generation(generation)
+		{
+		}
+
+		~SlotImplT()
+		{
+			std::shared_ptr<SignalImpl<FuncType>> sig = signal.lock();
+			if (sig)
+				sig->disconnect(index, generation);
+		}
+
+		std::weak_ptr<SignalImpl<FuncType>> signal;
+		unsigned int index;
+		unsigned int generation;
+	};
+
+	template<typename InstanceType, typename MemberFuncType>
+	class SignalMemberCallback
+	{
+	public:
+		SignalMemberCallback(InstanceType instance, MemberFuncType func) : instance(instance), func(func) { }
+
+		template<typename... Args>
+		auto operator()(Args&&... args) -> decltype((std::declval<InstanceType>()->*std::declval<MemberFuncType>())(std::forward<Args>(args)...))
+		{
+			return (instance->*func)(std::forward<Args>(args)...);
+		}
+
+	private:
+		InstanceType instance;
+		MemberFuncType func;
 	};
 
+	/// \brief Calls every connected slot when invoked
+	///
+	/// Emitting neither allocates nor copies the slot list. Slots may connect and disconnect slots, or destroy the
+	/// signal, while it is being emitted. Slots connected during an emit are first called by the next one.
+	/// Signals are not thread safe; connect, disconnect and emit from one thread only.
 	template<typename FuncType>
 	class Signal
 	{
 	public:
-		Signal() : impl(std::make_shared<SignalImpl<SlotImplT<FuncType>>>()) { }
+		Signal() : impl(std::make_shared<SignalImpl<FuncType>>()) { }
+
+		Signal(const Signal &) = default;
+
+		~Signal()
+		{
+			keep_alive_while_emitting();
+		}
+
+		Signal &operator=(const Signal &other)
+		{
+			if (impl != other.impl)
+			{
+				keep_alive_while_emitting();
+				impl = other.impl;
+			}
+			return *this;
+		}
 
 		template<typename... Args>
 		void operator()(Args&&... args)
 		{
-			std::vector<std::weak_ptr<SlotImplT<FuncType>>> slots = impl->slots;
-			for (std::weak_ptr<SlotImplT<FuncType>> &weak_slot : slots)
+			if (impl->connected_count == 0)
+				return;
+
+			SignalImpl<FuncType> *sig = impl.get();
+			EmitScope scope(sig);
+
+			// Entries are only unlinked once the outermost emit is done, and slots connected meanwhile come after last
+			unsigned int last = sig->tail;
+			for (unsigned int i = sig->head; ; i = sig->entries[i].next)
 			{
-				std::shared_ptr<SlotImplT<FuncType>> slot = weak_slot.lock();
-				if (slot)
-				{
-					slot->callback(std::forward<Args>(args)...);
-				}
+				typename SignalImpl<FuncType>::Entry &entry = sig->entries[i];
+				if (entry.connected)
+					entry.callback(args...);
+				if (i == last)
+					break;
 			}
 		}
 
-		Slot connect(const std::function<FuncType> &func)
+		/// \brief Returns true if any slots are connected to the signal
+		bool has_slots() const
 		{
-			auto slot_impl = std::make_shared<SlotImplT<FuncType>>(impl, func);
-			impl->slots.push_back(slot_impl);
-			return Slot(slot_impl);
+			return impl->connected_count != 0;
+		}
+
+		template<typename Func>
+		Slot connect(Func &&func)
+		{
+			unsigned int index = impl->connect(std::forward<Func>(func));
+			return Slot(std::make_shared<SlotImplT<FuncType>>(impl, index, impl->entries[index].generation));
 		}
 
 		template<typename InstanceType, typename MemberFuncType>
 		Slot connect(InstanceType instance, MemberFuncType func)
 		{
-			return connect(bind_member(instance, func));
+			return connect(SignalMemberCallback<InstanceType, MemberFuncType>(instance, func));
 		}
 
 	private:
-		std::shared_ptr<SignalImpl<SlotImplT<FuncType>>> impl;
+		void keep_alive_while_emitting()
+		{
+			if (impl && impl->emit_depth > 0)
+				impl->self = impl;
+		}
+
+		class EmitScope
+		{
+		public:
+			EmitScope(SignalImpl<FuncType> *sig) : sig(sig) { sig->begin_emit(); }
+			~EmitScope()
+			{
+				sig->end_emit();
+				if (sig->emit_depth == 0 && sig->self)
+				{
+					std::shared_ptr<SignalImpl<FuncType>> release = std::move(sig->self);
+				}
+			}
+
+		private:
+			SignalImpl<FuncType> *sig;
+		};
+
+		std::shared_ptr<SignalImpl<FuncType>> impl;
 	};
 
 	class SlotContainer
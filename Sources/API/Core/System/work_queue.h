@@ -50,8 +50,12 @@ namespace clan
 	};
 
 	class WorkQueue_Impl;
+	class WorkGroup_Impl;
 
 	/// \brief Thread pool for worker threads
+	///
+	/// Each worker thread owns a deque of items. Items queued from a worker thread go to the
+	/// deque of that worker, while idle workers steal from the other deques.
 	class WorkQueue
 	{
 	public:
@@ -60,6 +64,9 @@ namespace clan
 		WorkQueue(bool serial_queue = false);
 		~WorkQueue();
 
+		/// \brief Returns the number of worker threads used by this queue
+		int get_num_workers() const;
+
 		/// \brief Queue some work to be executed on a worker thread
 		///
 		/// Transfers ownership of the item queued. WorkQueue will delete the item.
@@ -79,8 +86,56 @@ namespace clan
 		/// Needs to be called on the main WorkQueue thread periodically to finish queued work
 		void process_work_completed();
 
+		/// \brief Calls func for every index in [begin, end) on the worker threads and waits for it to finish
+		///
+		/// \param grain_size Minimum number of indices processed by each queued item
+		void parallel_for(int begin, int end, const std::function<void(int)> &func, int grain_size = 1);
+
 	private:
 		std::shared_ptr<WorkQueue_Impl> impl;
+
+		friend class WorkGroup;
+	};
+
+	/// \brief Group of work items that can be waited on as a whole
+	///
+	/// Items run by a group do not go through the work completed queue and do not need
+	/// process_work_completed to be called for them.
+	class WorkGroup
+	{
+	public:
+		/// \brief Constructs a work group executing its items on the specified queue
+		WorkGroup(WorkQueue &queue);
+		~WorkGroup();
+
+		/// \brief Run a function on a worker thread as part of this group
+		void run(const std::function<void()> &func);
+
+		/// \brief Run func for every index in [begin, end), split into items of at least grain_size indices
+		void parallel_for(int begin, int end, const std::function<void(int)> &func, int grain_size = 1);
+
+		/// \brief Run a function on a worker thread once all items currently in the group have finished
+		///
+		/// If the group is already idle the continuation is queued immediately.
+		void then(const std::function<void()> &continuation);
+
+		/// \brief Returns true if all items in the group have finished
+		bool is_done() const;
+
+		/// \brief Blocks until all items in the group have finished
+		///
+		/// The calling thread helps processing queued items while waiting, which makes it safe to
+		/// call from inside a worker thread. Rethrows the first exception thrown by an item.
+		/// Serial queues are never helped, as their items run one at a time on the queue's own thread.
+		/// Waiting inside a serial queue item for items queued after it to the same queue never returns.
+		void wait();
+
+	private:
+		WorkGroup(const WorkGroup &) = delete;
+		WorkGroup &operator=(const WorkGroup &) = delete;
+
+		std::shared_ptr<WorkGroup_Impl> impl;
+		std::shared_ptr<WorkQueue_Impl> queue_impl;
 	};
 
 	/// \}
@@ -0,0 +1,115 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "zip_file_entry.h"
+
+namespace clan
+{
+	/// \addtogroup clanCore_I_O_Data clanCore I/O Data
+	/// \{
+
+	class IODevice;
+	class DataBuffer;
+	class WorkQueue;
+	class ZipMappedArchive_Impl;
+
+	/// \brief Read-only zip archive mapped into memory.
+	///
+	/// The central directory is indexed in a hash table when the archive is opened, so opening
+	/// a file does not depend on the number of entries in the archive. Stored (uncompressed)
+	/// entries are read directly from the mapping, and compressed entries can be inflated in
+	/// advance on the worker threads of a WorkQueue.
+	///
+	/// The archive is unmapped when the last copy of this object, and of the devices opened from it, is destroyed.
+	class ZipMappedArchive
+	{
+	public:
+		/// \brief Constructs a null instance
+		ZipMappedArchive();
+
+		/// \brief Maps a zip archive and indexes its central directory
+		///
+		/// \param filename = Path to the .zip archive
+		ZipMappedArchive(const std::string &filename);
+
+		~ZipMappedArchive();
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid
+		void throw_if_null() const;
+
+		/// \brief Returns the path of the archive
+		std::string get_filename() const;
+
+		/// \brief Returns the number of entries in the central directory
+		int get_file_count() const;
+
+		/// \brief Returns the files and directories in a directory of the archive, like ZipArchive::get_file_list
+		std::vector<ZipFileEntry> get_file_list(const std::string &path) const;
+
+		/// \brief Returns true if the archive contains the file
+		bool has_file(const std::string &filename) const;
+
+		/// \brief Returns the uncompressed size of a file, or -1 if the archive does not contain it
+		int64_t get_file_size(const std::string &filename) const;
+
+		/// \brief Returns the contents of a stored file without copying it
+		///
+		/// The data points into the mapping and is valid for as long as the archive exists.
+		/// \return nullptr if the file is missing or compressed
+		const void *get_stored_data(const std::string &filename, size_t &out_size) const;
+
+		/// \brief Opens a file in the archive
+		///
+		/// Stored and prefetched files are read from memory. Other compressed files are inflated when opened.
+		IODevice open_file(const std::string &filename) const;
+
+		/// \brief Reads the whole contents of a file
+		DataBuffer read_file(const std::string &filename) const;
+
+		/// \brief Inflates files on the worker threads of a queue and keeps them for open_file
+		///
+		/// Blocks until all files have been inflated. Stored files are skipped as they need no work.
+		void prefetch(const std::vector<std::string> &filenames, WorkQueue &queue);
+
+		/// \brief Frees the files kept by prefetch
+		void clear_prefetched();
+
+	private:
+		std::shared_ptr<ZipMappedArchive_Impl> impl;
+	};
+
+	/// \}
+}
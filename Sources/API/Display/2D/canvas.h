@@ -132,6 +132,17 @@ namespace clan
 		/// \seealso Resolution Independence
 		float get_pixel_ratio() const { return get_gc().get_pixel_ratio(); }
 
+		/// \brief Returns true if draw calls are recorded into a draw list until the canvas is flushed
+		bool is_draw_list_enabled() const;
+
+		/// \brief Returns the layer new draw list commands are recorded into
+		int get_draw_layer() const;
+
+		/// \brief Returns how many draw calls the render batchers of this canvas have made so far
+		///
+		/// Canvases created from this one share its batchers and are included in the count.
+		int get_draw_call_count() const;
+
 		/// \brief Set active rasterizer state
 		void set_rasterizer_state(const RasterizerState &state);
 
@@ -210,6 +221,19 @@ namespace clan
 		/// \brief Flushes the render batcher currently active.
 		void flush();
 
+		/// \brief Enables or disables the deferred draw list
+		///
+		/// When enabled, triangles, lines and points are recorded instead of being batched in painter's order.
+		/// At flush the recorded commands are merged into as few draw calls as possible. Commands keep their
+		/// relative order only where their bounds overlap. Changes to state such as the clipping rectangle,
+		/// blend state or another render batcher flush the list first.
+		void set_draw_list_enabled(bool enable);
+
+		/// \brief Sets the layer new draw list commands are recorded into
+		///
+		/// Lower layers are drawn first when the draw list is flushed. Has no effect when the draw list is disabled.
+		void set_draw_layer(int layer);
+
 		/// \brief Draw a point.
 		void draw_point(float x1, float y1, const Colorf &color);
 
@@ -106,6 +106,11 @@ namespace clan
 		/// \brief Loads a Sprite from a XML resource definition
 		static Image load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc);
 
+		/// \brief Loads an Image from a XML resource definition
+		///
+		/// \param load_texture Called to create the texture of the image file used by the image
+		static Image load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(const std::string &filename, const FileSystem &fs)> &load_texture);
+
 		/// \brief Returns true if this object is invalid.
 		bool is_null() const { return !impl; }
 		explicit operator bool() const { return bool(impl); }
@@ -48,6 +48,7 @@ namespace clan
 	class ResourceManager;
 	class Font_Impl;
 	class Subtexture;
+	class Texture2D;
 	class XMLResourceDocument;
 
 	/// \brief Sprite class.
@@ -99,6 +100,11 @@ namespace clan
 		/// \brief Loads a Sprite from a XML resource definition
 		static Sprite load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc);
 
+		/// \brief Loads a Sprite from a XML resource definition
+		///
+		/// \param load_texture Called to create the texture of every image file used by the sprite
+		static Sprite load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(const std::string &filename, const FileSystem &fs)> &load_texture);
+
 		/// \brief Returns true if this object is invalid.
 		bool is_null() const { return !impl; }
 		explicit operator bool() const { return bool(impl); }
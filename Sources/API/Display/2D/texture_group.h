@@ -69,6 +69,12 @@ namespace clan
 		/// \brief Throw an exception if this object is invalid.
 		void throw_if_null() const;
 
+		/// \brief Equality operator
+		bool operator==(const TextureGroup &other) const { return impl == other.impl; }
+
+		/// \brief Inequality operator
+		bool operator!=(const TextureGroup &other) const { return impl != other.impl; }
+
 		/// \brief Returns the amount of sub-textures allocated in group.
 		int get_subtexture_count() const;
 
@@ -90,6 +96,12 @@ namespace clan
 		/// \brief Allocate space for another sub texture.
 		Subtexture add(GraphicContext &context, const Size &size);
 
+		/// \brief Allocate space for another sub texture in one of the existing textures.
+		///
+		/// Unlike add(), this never creates a new texture. All textures are searched regardless of the allocation policy.
+		/// \return The sub texture, or a null Subtexture if none of the textures have room for it
+		Subtexture try_add(const Size &size);
+
 		/// \brief Deallocate space, from a previously allocated texture
 		///
 		/// Warning - It is advised to set TextureAllocationPolicy to search_previous_textures
@@ -46,6 +46,7 @@ namespace clan
 	class Canvas;
 	class Font_Impl;
 	class GlyphMetrics;
+	class WorkQueue;
 
 	class FontHandle
 	{
@@ -132,6 +133,18 @@ namespace clan
 		void draw_text(Canvas &canvas, const Pointf &position, const std::string &text, const Colorf &color = StandardColorf::white());
 		void draw_text(Canvas &canvas, float xpos, float ypos, const std::string &text, const Colorf &color = StandardColorf::white()) { draw_text(canvas, Pointf(xpos, ypos), text, color); }
 
+		/// \brief Rasterizes the glyphs of a text ahead of drawing it
+		///
+		/// Drawing rasterizes missing glyphs one at a time. Preparing the text a frame earlier, for example
+		/// with all characters of a language, does them as one batch.
+		///
+		/// \param canvas = Canvas
+		/// \param text = The characters to prepare
+		void prepare_glyphs(Canvas &canvas, const std::string &text);
+
+		/// \brief Rasterizes the glyphs of a text ahead of drawing it, in parallel on the work queue when the font engine supports it
+		void prepare_glyphs(Canvas &canvas, const std::string &text, WorkQueue &queue);
+
 		/// \brief Gets the glyph metrics
 		///
 		/// \param glyph = The glyph to get
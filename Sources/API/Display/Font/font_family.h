@@ -57,7 +57,11 @@ namespace clan
 		FontFamily();
 
 		/// \brief Constructs a font family with the given family name
-		FontFamily(const std::string &family_name, const TextureGroup &new_texture_group = TextureGroup(Size(256, 256)));
+		///
+		/// Glyphs are rasterized into an atlas shared with all other families using the same texture group.
+		/// A null texture group uses the atlas shared by every family constructed without one.
+		/// When the atlas runs out of space, the least recently used glyphs are evicted.
+		FontFamily(const std::string &family_name, const TextureGroup &new_texture_group = TextureGroup());
 
 		/// \brief Returns true if this object is invalid.
 		bool is_null() const { return !impl; }
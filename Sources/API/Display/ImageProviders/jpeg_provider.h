@@ -37,6 +37,7 @@ namespace clan
 	/// \{
 
 	class FileSystem;
+	class WorkQueue;
 
 	/// \brief Image provider that can load JPEG (.jpg) files.
 	class JPEGProvider
@@ -59,27 +60,49 @@ namespace clan
 			IODevice &file,
 			bool srgb = false);
 
+		/// \brief Load an image using the worker threads of a work queue
+		///
+		/// The IDCT and color conversion are split into bands of MCU rows. Baseline images
+		/// with restart markers also have their restart intervals entropy decoded in parallel.
+		/// The result is identical to a serial load.
+		///
+		/// \param file File to load the image from.
+		/// \param queue Work queue to run the decoding on. Waits for the decoding to finish.
+		static PixelBuffer load(
+			IODevice &file,
+			WorkQueue &queue,
+			bool srgb = false);
+
+		static PixelBuffer load(
+			const std::string &fullname,
+			WorkQueue &queue,
+			bool srgb = false);
+
 		/// \brief Save the given PixelBuffer into a JPEG
 		///
 		/// \param buffer The PixelBuffer to save, format doesn't matter its converted if needed
 		/// \param filename File name of JPEG.
 		/// \param directory Directory that the file name is relative to.
 		/// \param quality The quality level of the JPEG (0-100), 100 being best quality.
+		/// \param restart_interval Number of MCUs between restart markers, or 0 for none. Restart markers allow the image to be decoded in parallel.
 		static void save(
 			PixelBuffer buffer,
 			const std::string &filename,
 			FileSystem &fs,
-			int quality = 85);
+			int quality = 85,
+			int restart_interval = 0);
 
 		static void save(
 			PixelBuffer buffer,
 			const std::string &fullname,
-			int quality = 85);
+			int quality = 85,
+			int restart_interval = 0);
 
 		static void save(
 			PixelBuffer buffer,
 			IODevice &file,
-			int quality = 85);
+			int quality = 85,
+			int restart_interval = 0);
 	};
 
 	/// \}
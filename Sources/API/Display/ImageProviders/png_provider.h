@@ -30,6 +30,7 @@
 
 #include "../Image/pixel_buffer.h"
 #include "../../Core/IOData/file_system.h"
+#include <functional>
 
 namespace clan
 {
@@ -62,6 +63,16 @@ namespace clan
 		/// \return Pixel Buffer
 		static PixelBuffer load(IODevice &dev, bool srgb = false);
 
+		/// \brief Load an image one scanline at a time
+		///
+		/// The image data is inflated and unfiltered as it is read, and each scanline is handed to the
+		/// callback without the whole image being kept in memory. Interlaced images can only be
+		/// completed after the last pass and are decoded to a full image before the rows are handed out.
+		///
+		/// \param dev = IODevice
+		/// \param row_callback Called for each scanline from top to bottom. The row is a one pixel high image in rgba8, srgb8_alpha8 or rgba16 format that is only valid during the call.
+		static void load_rows(IODevice &dev, const std::function<void(int y, const PixelBuffer &row)> &row_callback, bool srgb = false);
+
 		/// \brief Called to save a given PixelBuffer to a file
 		static void save(
 			PixelBuffer buffer,
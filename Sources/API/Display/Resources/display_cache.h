@@ -30,6 +30,10 @@
 
 #include "../../Core/Resources/resource.h"
 #include <memory>
+#include <functional>
+#include <vector>
+#include <string>
+#include <cstdint>
 
 namespace clan
 {
@@ -44,6 +48,30 @@ namespace clan
 	class Texture;
 	class Font;
 	class FontDescription;
+	class WorkQueue;
+
+	/// \brief Progress of the resources preloaded by a display cache
+	class DisplayPreloadProgress
+	{
+	public:
+		/// \brief Number of resources created so far
+		int resources_loaded = 0;
+
+		/// \brief Number of resources requested
+		int resources_total = 0;
+
+		/// \brief Number of image files decoded so far
+		int images_decoded = 0;
+
+		/// \brief Number of image files to decode
+		int images_total = 0;
+
+		/// \brief Time since the preload started, or the total load time once it is done
+		uint64_t microseconds = 0;
+
+		/// \brief Returns true when every requested resource has been created
+		bool is_done() const { return resources_loaded == resources_total; }
+	};
 
 	class DisplayCache
 	{
@@ -54,6 +82,20 @@ namespace clan
 		virtual Resource<Texture> get_texture(GraphicContext &gc, const std::string &id) = 0;
 		virtual Resource<Font> get_font(Canvas &canvas, const std::string &family_name, const FontDescription &desc) = 0;
 
+		/// \brief Starts loading sprites, images and textures in the background
+		///
+		/// The image files used by the resources are decoded on the work queue. update_preload then creates
+		/// the textures and must be called on the graphic context thread until the preload is done.
+		/// Resources requested before they are created are returned as empty placeholders that are set once
+		/// they are ready, which Resource::updated reports. Ids of other resource types are ignored.
+		/// The default implementation preloads nothing, leaving the resources to load when requested.
+		///
+		/// \param progress Called by update_preload after each resource has been created
+		virtual void preload(const std::vector<std::string> &ids, WorkQueue &queue, const std::function<void(const DisplayPreloadProgress &)> &progress = std::function<void(const DisplayPreloadProgress &)>()) { }
+
+		/// \brief Creates preloaded resources until the time budget is spent
+		virtual DisplayPreloadProgress update_preload(Canvas &canvas, int budget_microseconds) { return DisplayPreloadProgress(); }
+
 		static DisplayCache &get(const ResourceManager &resources);
 		static void set(ResourceManager &resources, const std::shared_ptr<DisplayCache> &cache);
 	};
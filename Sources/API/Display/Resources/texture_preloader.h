@@ -0,0 +1,83 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "display_cache.h"
+
+namespace clan
+{
+	/// \addtogroup clanDisplay_Resources clanDisplay Resources
+	/// \{
+
+	class GraphicContext;
+	class Texture2D;
+	class FileSystem;
+	class TexturePreloader_Impl;
+
+	/// \brief Decodes image files on worker threads and uploads them as textures in time budgeted slices
+	///
+	/// Used by the display caches to implement DisplayCache::preload. Every resource added lists the image
+	/// files it needs. The files are read by add on the calling thread, since a file system is not required to
+	/// be thread safe, and decoded in parallel on the work queue. update creates the textures on the graphic
+	/// context thread and calls the create function of each resource once all of its files have been uploaded.
+	class TexturePreloader
+	{
+	public:
+		TexturePreloader();
+		~TexturePreloader();
+
+		/// \brief Adds a resource to load
+		///
+		/// \param filenames Image files used by the resource. A file used by several pending resources is only decoded once.
+		/// \param create Called by update once the files are uploaded. get_texture returns the uploaded textures.
+		void add(WorkQueue &queue, const FileSystem &fs, const std::vector<std::string> &filenames, const std::function<void()> &create);
+
+		/// \brief Returns the texture uploaded for an image file of a pending resource
+		///
+		/// Files that have not been decoded yet, or were never added, are loaded synchronously.
+		Texture2D get_texture(GraphicContext &gc, const std::string &filename, const FileSystem &fs);
+
+		/// \brief Uploads decoded images and creates finished resources until the time budget is spent
+		///
+		/// Every call does at least one upload or creation if there is one ready. Exceptions thrown while
+		/// creating a resource are passed on to the caller. The resource is dropped from the preload.
+		DisplayPreloadProgress update(GraphicContext &gc, int budget_microseconds);
+
+		/// \brief Returns the progress of the resources added since the preloader was last idle
+		DisplayPreloadProgress get_progress() const;
+
+		/// \brief Sets the function called by update after each created resource
+		void set_progress_callback(const std::function<void(const DisplayPreloadProgress &)> &callback);
+
+	private:
+		std::shared_ptr<TexturePreloader_Impl> impl;
+	};
+
+	/// \}
+}
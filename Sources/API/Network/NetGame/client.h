@@ -30,6 +30,7 @@
 #pragma once
 
 #include "connection_site.h"	// TODO: Remove
+#include "channel.h"
 #include "../../Core/Signals/signal.h"
 
 namespace clan
@@ -38,6 +39,9 @@ namespace clan
 	/// \{
 
 	class NetGameEvent;
+	class NetGameEventView;
+	class NetGameSnapshot;
+	class NetGameSnapshotSchema;
 	class NetGameConnection;
 	class NetGameClient_Impl;
 
@@ -54,6 +58,12 @@ namespace clan
 		/// \param port = String
 		void connect(const std::string &server, const std::string &port);
 
+		/// \brief Connect to a server started with NetGameServer::start_udp
+		///
+		/// \param server = String
+		/// \param port = String
+		void connect_udp(const std::string &server, const std::string &port);
+
 		/// \brief Disconnect
 		void disconnect();
 
@@ -64,8 +74,28 @@ namespace clan
 		///
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
+
+		/// \brief Send event on a channel
+		///
+		/// \param game_event = Net Game Event
+		/// \param channel = Delivery guarantee. Ignored by TCP connections.
+		void send_event(const NetGameEvent &game_event, NetGameChannel channel);
 		Signal<void(const NetGameEvent &)> &sig_event_received();
 
+		/// \brief Event received, read straight from the receive buffer
+		///
+		/// The view is only valid for the duration of the callback. Events are only decoded
+		/// into a NetGameEvent for sig_event_received when that signal has slots connected.
+		Signal<void(const NetGameEventView &)> &sig_event_view_received();
+
+		/// \brief Sets the schema used to decode snapshots sent with NetGameServer::send_snapshot
+		///
+		/// Snapshots are ignored until a schema has been set.
+		void set_snapshot_schema(const NetGameSnapshotSchema &schema);
+
+		/// \brief Snapshot received from the server
+		Signal<void(const NetGameSnapshot &)> &sig_snapshot_received();
+
 		/// \brief Sig connected
 		///
 		/// \return Signal<void()>
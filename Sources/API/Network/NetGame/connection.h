@@ -31,6 +31,7 @@
 #include <vector>
 #include <string>
 #include "event.h"
+#include "channel.h"
 
 namespace clan
 {
@@ -41,6 +42,9 @@ namespace clan
 	class NetGameConnection_Impl;
 	class SocketName;
 	class TCPConnection;
+	class NetGameReactor;
+	class NetGameUDPHost;
+	class DataBuffer;
 
 	/// \brief NetGameConnection
 	class NetGameConnection
@@ -53,6 +57,12 @@ namespace clan
 		NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection);
 		NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name);
 
+		/// \internal Constructs a NetGameConnection that is driven by the I/O threads of a reactor instead of a thread of its own
+		NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor);
+
+		/// \internal Constructs a NetGameConnection over UDP. Without a host, the connection connects to socket_name from a UDP socket of its own
+		NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name, NetGameUDPHost *host);
+
 		~NetGameConnection();
 
 		/// \brief Set data
@@ -73,9 +83,39 @@ namespace clan
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
 
+		/// \brief Send event on a channel
+		///
+		/// \param game_event = Net Game Event
+		/// \param channel = Delivery guarantee. Ignored by TCP connections.
+		void send_event(const NetGameEvent &game_event, NetGameChannel channel);
+
+		/// \internal Queues an event already encoded for the wire. Used to encode broadcasts only once.
+		void send_packet(const DataBuffer &packet, NetGameChannel channel = NetGameChannel::reliable_ordered);
+
 		/// \brief Disconnects a client
 		void disconnect();
 
+		/// \brief Sets how long outgoing events may be held back to be sent together with later events
+		///
+		/// Events are written as soon as the queued data reaches flush_size bytes, or when the
+		/// connection is disconnected. UDP connections ignore the flush window, as they pack
+		/// everything queued into as few datagrams as possible anyway.
+		///
+		/// \param milliseconds = Flush window. Zero (the default) writes events as soon as possible.
+		void set_flush_delay(int milliseconds);
+
+		/// \brief Sets the maximum number of bytes that may be waiting to be sent
+		///
+		/// A connection whose peer does not keep up is disconnected once the limit is exceeded.
+		///
+		/// \param bytes = Send queue limit. Zero (the default) means no limit.
+		void set_send_queue_limit(int bytes);
+
+		/// \brief Returns the number of bytes queued but not yet written to the socket
+		int get_send_queue_size() const;
+
+		enum { flush_size = 16 * 1024 };
+
 		/// \brief Get Remote name
 		///
 		/// \return remote_name
@@ -0,0 +1,139 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "event_value.h"
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanNetwork_NetGame clanNetwork NetGame
+	/// \{
+
+	class NetGameEvent;
+
+	/// \brief Read-only view of one encoded NetGameEvent argument
+	///
+	/// Points into the buffer the event was received into. Strings and binary data are not copied.
+	class NetGameEventValueView
+	{
+	public:
+		NetGameEventValueView() { }
+		NetGameEventValueView(const unsigned char *data, unsigned int length) : data(data), length(length) { }
+
+		NetGameEventValue::Type get_type() const;
+
+		bool is_null() const { return get_type() == NetGameEventValue::Type::null; }
+		bool is_complex() const { return get_type() == NetGameEventValue::Type::complex; }
+
+		unsigned int get_uinteger() const;
+		int get_integer() const;
+		float get_number() const;
+		bool get_boolean() const;
+		char get_character() const;
+		unsigned char get_ucharacter() const;
+
+		/// \brief Returns the string characters. The string is not null terminated.
+		const char *get_string_data() const;
+		unsigned int get_string_length() const;
+
+		/// \brief Returns true if the value is a string equal to str
+		bool string_equals(const char *str) const;
+
+		/// \brief Copies the string out of the receive buffer
+		std::string get_string() const;
+
+		const void *get_binary_data() const;
+		unsigned int get_binary_size() const;
+
+		unsigned int get_member_count() const;
+		NetGameEventValueView get_member(unsigned int index) const;
+
+		/// \brief Decodes the value into a NetGameEventValue
+		NetGameEventValue to_value() const;
+
+		/// \brief Returns the number of bytes the encoded value occupies
+		unsigned int get_encoded_length() const;
+
+	private:
+		void check_type(unsigned char expected_type) const;
+
+		const unsigned char *data = nullptr;
+		unsigned int length = 0;
+	};
+
+	/// \brief Read-only view of an encoded NetGameEvent
+	///
+	/// The view validates the encoding once and then reads the name and arguments
+	/// straight from the buffer it points at, without any memory allocations.
+	/// The buffer must stay valid for as long as the view is used.
+	class NetGameEventView
+	{
+	public:
+		NetGameEventView() { }
+
+		/// \brief Points the view at an encoded event payload
+		///
+		/// Throws an exception if the payload is not a valid encoded event.
+		NetGameEventView(const void *payload, unsigned int size) { reset(payload, size); }
+
+		/// \brief Points the view at an encoded event payload
+		///
+		/// Throws an exception if the payload is not a valid encoded event.
+		void reset(const void *payload, unsigned int size);
+
+		/// \brief Returns the name characters. The name is not null terminated.
+		const char *get_name_data() const { return reinterpret_cast<const char *>(data + 2); }
+		unsigned int get_name_length() const { return name_length; }
+
+		/// \brief Returns true if the event name equals name
+		bool name_equals(const char *name) const;
+
+		/// \brief Copies the event name out of the receive buffer
+		std::string get_name() const { return std::string(get_name_data(), name_length); }
+
+		unsigned int get_argument_count() const { return argument_count; }
+		NetGameEventValueView get_argument(unsigned int index) const;
+
+		/// \brief Decodes the view into a NetGameEvent
+		NetGameEvent to_event() const;
+
+	private:
+		enum { max_cached_offsets = 16 };
+
+		const unsigned char *data = nullptr;
+		unsigned int size = 0;
+		unsigned int name_length = 0;
+		unsigned int argument_count = 0;
+		unsigned short argument_offsets[max_cached_offsets];
+	};
+
+	/// \}
+}
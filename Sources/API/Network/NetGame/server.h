@@ -31,6 +31,7 @@
 
 
 #include "connection_site.h"	// TODO: Remove
+#include "channel.h"
 #include "../../Core/Signals/signal.h"
 
 namespace clan
@@ -39,14 +40,20 @@ namespace clan
 	/// \{
 
 	class NetGameEvent;
+	class NetGameEventView;
+	class NetGameSnapshot;
 	class NetGameConnection;
 	class NetGameServer_Impl;
+	class SocketName;
 
 	/// \brief NetGameServer
 	class NetGameServer : NetGameConnectionSite
 	{
 	public:
-		NetGameServer();
+		/// \brief Constructs a server
+		///
+		/// \param io_thread_count = Number of I/O threads shared by all connections. If zero, every connection runs on a thread of its own.
+		NetGameServer(int io_thread_count = 0);
 		~NetGameServer();
 
 		/// \brief Start
@@ -60,26 +67,75 @@ namespace clan
 		/// \param port = String
 		void start(const std::string &address, const std::string &port);
 
+		/// \brief Start accepting UDP connections
+		///
+		/// Clients connect with NetGameClient::connect_udp. All connections share one socket and one I/O thread.
+		///
+		/// \param port = String
+		void start_udp(const std::string &port);
+
+		/// \brief Start accepting UDP connections
+		///
+		/// \param address = String
+		/// \param port = String
+		void start_udp(const std::string &address, const std::string &port);
+
 		/// \brief Process events
 		void process_events();
 
 		/// \brief Stop
 		void stop();
 
-		/// \brief Send event
+		/// \brief Send event to all connected clients
+		///
+		/// The event is encoded once and the encoded packet is shared by all connections.
 		///
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
 
+		/// \brief Send event to all connected clients on a channel
+		///
+		/// \param game_event = Net Game Event
+		/// \param channel = Delivery guarantee. Ignored by TCP connections.
+		void send_event(const NetGameEvent &game_event, NetGameChannel channel);
+
+		/// \brief Sets the flush window of all current and future connections
+		///
+		/// \param milliseconds = How long outgoing events may be held back to be sent together. See NetGameConnection::set_flush_delay.
+		void set_flush_delay(int milliseconds);
+
+		/// \brief Sets the send queue limit of all current and future connections
+		///
+		/// \param bytes = Maximum bytes waiting to be sent before a slow client is disconnected. Zero means no limit.
+		void set_send_queue_limit(int bytes);
+
+		/// \brief Sends a snapshot to all connected clients
+		///
+		/// Each client receives the changes since the newest snapshot it acknowledged, or the full
+		/// snapshot if it has not acknowledged any recent one. Payloads are compressed with zlib when
+		/// that makes them smaller. Clients receive the snapshot through NetGameClient::sig_snapshot_received.
+		///
+		/// \param snapshot = Current state of all replicated entities
+		void send_snapshot(const NetGameSnapshot &snapshot);
+
 		Signal<void(NetGameConnection *)> &sig_client_connected();
 		Signal<void(NetGameConnection *, const std::string &)> &sig_client_disconnected();
 		Signal<void(NetGameConnection *, const NetGameEvent &)> &sig_event_received();
 
+		/// \brief Event received, read straight from the receive buffer
+		///
+		/// The view is only valid for the duration of the callback. Events are only decoded
+		/// into a NetGameEvent for sig_event_received when that signal has slots connected.
+		Signal<void(NetGameConnection *, const NetGameEventView &)> &sig_event_view_received();
+
 	private:
 
 		/// \brief Listen thread main
 		void listen_thread_main();
 
+		/// \brief Creates the connection for a UDP client asking to connect
+		void udp_accept(const SocketName &peer_endpoint);
+
 		/// \brief Add network event
 		///
 		/// \param e = Net Game Network Event
@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanNetwork_NetGame clanNetwork NetGame
+	/// \{
+
+	class DataBuffer;
+	class NetGameSnapshotSchema_Impl;
+
+	/// \brief Describes the fields every entity in a snapshot has
+	///
+	/// Server and client must build identical schemas. Copies share the same field list.
+	class NetGameSnapshotSchema
+	{
+	public:
+		NetGameSnapshotSchema();
+
+		/// \brief Adds an integer field
+		/// \return Field index
+		int add_int();
+
+		/// \brief Adds a float field quantized to a fixed number of bits
+		///
+		/// \param min_value = Smallest value. Smaller values are clamped.
+		/// \param max_value = Largest value. Larger values are clamped.
+		/// \param bits = Precision in bits (1-24)
+		/// \return Field index
+		int add_float(float min_value, float max_value, int bits);
+
+		int get_field_count() const;
+		bool is_float(int field) const;
+		int get_bits(int field) const;
+
+		/// \brief Converts a float to the quantized integer stored for a field
+		int quantize(int field, float value) const;
+
+		/// \brief Converts a quantized integer back to a float
+		float dequantize(int field, int value) const;
+
+	private:
+		std::shared_ptr<NetGameSnapshotSchema_Impl> impl;
+	};
+
+	/// \brief State of all replicated entities at one point in time
+	///
+	/// Entities are identified by an id and are kept sorted by id. Float fields are quantized
+	/// when they are set, so a snapshot reads back exactly what the receiving end will see.
+	class NetGameSnapshot
+	{
+	public:
+		NetGameSnapshot() { }
+		NetGameSnapshot(const NetGameSnapshotSchema &schema);
+
+		const NetGameSnapshotSchema &get_schema() const { return schema; }
+
+		/// \brief Sequence number assigned by the snapshot channel. Zero for snapshots that were never sent.
+		unsigned int get_sequence() const { return sequence; }
+		void set_sequence(unsigned int value) { sequence = value; }
+
+		int get_entity_count() const { return (int)ids.size(); }
+
+		/// \brief Returns the id of the entity at index. Entities are sorted by id.
+		unsigned int get_entity_id(int index) const { return ids[index]; }
+
+		bool has_entity(unsigned int id) const { return find_entity(id) != -1; }
+		void remove_entity(unsigned int id);
+		void clear();
+
+		/// \brief Sets a field value. Adds the entity, with all fields zero, if it does not exist.
+		void set_int(unsigned int id, int field, int value);
+		void set_float(unsigned int id, int field, float value);
+
+		/// \brief Returns a field value. Throws an exception if the entity does not exist.
+		int get_int(unsigned int id, int field) const;
+		float get_float(unsigned int id, int field) const;
+
+		/// \brief Encodes the snapshot as bit packed changes against a baseline
+		///
+		/// Only added, removed and changed entities are written. Changed fields are written as
+		/// variable length deltas, new entities with all fields.
+		///
+		/// \param snapshot = Snapshot to encode
+		/// \param baseline = Snapshot the receiver already has, or nullptr to encode everything
+		static DataBuffer encode(const NetGameSnapshot &snapshot, const NetGameSnapshot *baseline);
+
+		/// \brief Decodes data written by encode
+		///
+		/// \param schema = Schema of the snapshot
+		/// \param data = Encoded data
+		/// \param size = Size of encoded data
+		/// \param baseline = The baseline the data was encoded against, or nullptr
+		static NetGameSnapshot decode(const NetGameSnapshotSchema &schema, const void *data, unsigned int size, const NetGameSnapshot *baseline);
+
+	private:
+		int find_entity(unsigned int id) const;
+		int find_or_add_entity(unsigned int id);
+
+		NetGameSnapshotSchema schema;
+		unsigned int sequence = 0;
+		std::vector<unsigned int> ids;
+		std::vector<int> values;
+	};
+
+	/// \}
+}
@@ -17,6 +17,7 @@ namespace clan
 		virtual SocketHandle *get_socket_handle() = 0;
 
 		friend class NetworkConditionVariable;
+		friend class NetGameReactor;
 	};
 
 	/// \brief Condition variable that also awaken on network events
@@ -43,11 +44,48 @@ namespace clan
 			}
 		}
 
+		/// \brief Registers an event source for wait_ready
+		///
+		/// The registration stays in place until remove is called, so idle sockets cost nothing per wait.
+		/// Must not be called while another thread is inside wait_ready.
+		void add(NetworkEvent *event);
+
+		/// \brief Unregisters an event source added with add
+		///
+		/// Must be called before the event source is destroyed.
+		void remove(NetworkEvent *event);
+
+		/// \brief Waits for registered event sources to become ready or until notify is called
+		///
+		/// Readiness is edge triggered: a socket is reported when it becomes readable or writable and may
+		/// not be reported again until it has been read or written until it would block.
+		///
+		/// \param out_events Receives the event sources that became ready
+		/// \param max_events Size of out_events. Sources beyond that are reported by the next wait
+		/// \return Number of event sources stored in out_events. Zero on timeout or notify
+		template<typename Lock>
+		int wait_ready(Lock &lock, NetworkEvent **out_events, int max_events, int timeout = -1)
+		{
+			lock.unlock();
+			try
+			{
+				int result = wait_ready_impl(out_events, max_events, timeout);
+				lock.lock();
+				return result;
+			}
+			catch (...)
+			{
+				lock.lock();
+				throw;
+			}
+		}
+
 		/// \brief Awakens any thread waiting for event changes
 		void notify();
 
 	private:
 		bool wait_impl(int count, NetworkEvent **events, int timeout);
+		int wait_ready_impl(NetworkEvent **out_events, int max_events, int timeout);
 
 		std::shared_ptr<NetworkConditionVariableImpl> impl;
 	};
@@ -43,6 +43,16 @@ namespace clan
 		/// \return Bytes written, or -1 if buffer is full
 		int write(const void *data, int size);
 
+		/// \brief Write several buffers to TCP socket with a single system call
+		///
+		/// \param data = Buffers to write, in order
+		/// \param sizes = Size of each buffer
+		/// \param count = Number of buffers. At most max_write_buffers are written per call.
+		/// \return Bytes written, or -1 if buffer is full
+		int write(const void * const *data, const int *sizes, int count);
+
+		enum { max_write_buffers = 64 };
+
 		/// \brief Read data from TCP socket
 		/// \return Bytes read, 0 if remote closed connection, or -1 if buffer is empty
 		int read(void *data, int size);
@@ -10,6 +10,29 @@ namespace clan
 	class SocketName;
 	class UDPSocketImpl;
 
+	/// \brief Datagram sent or received by the batched UDPSocket functions
+	class UDPDatagram
+	{
+	public:
+		/// \brief Packet data
+		void *data = nullptr;
+
+		/// \brief Packet size when sending. Buffer size before reading and packet size after
+		int size = 0;
+
+		/// \brief IPv4 address of the end point in network byte order
+		unsigned int address = 0;
+
+		/// \brief Port of the end point in network byte order
+		unsigned short port = 0;
+
+		/// \brief Set address and port from a socket name
+		void set_endpoint(const SocketName &endpoint);
+
+		/// \brief Returns the end point as a socket name
+		SocketName get_endpoint() const;
+	};
+
 	/// \brief UDP/IP socket class
 	class UDPSocket : public NetworkEvent
 	{
@@ -32,6 +55,17 @@ namespace clan
 		/// \return Bytes read or 0 if no packet was available
 		int read(void *data, int size, SocketName &endpoint);
 
+		/// \brief Send several UDP packets, using a single system call where the platform supports it
+		/// \return Packets handed to the network. Less than count if the send buffer of the socket is full
+		int send(const UDPDatagram *datagrams, int count);
+
+		/// \brief Read several received UDP packets, using a single system call where the platform supports it
+		/// \return Packets read or 0 if no packet was available
+		int read(UDPDatagram *datagrams, int count);
+
+		/// \brief Largest batch handed to the operating system in one call
+		enum { max_batch = 64 };
+
 	protected:
 		SocketHandle *get_socket_handle() override;
 
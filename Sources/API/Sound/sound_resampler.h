@@ -0,0 +1,88 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+namespace clan
+{
+	/// \addtogroup clanSound_Audio_Mixing clanSound Audio Mixing
+	/// \{
+
+	/// \brief Interpolation used when a sound plays at a different rate than the mixer
+	enum class SoundResampleMode
+	{
+		/// \brief Repeats or skips samples. Cheapest, but aliases audibly.
+		nearest,
+
+		/// \brief Linear interpolation between the two nearest samples
+		linear,
+
+		/// \brief Four point cubic (Catmull-Rom) interpolation
+		cubic,
+
+		/// \brief Sixteen tap windowed sinc read from a polyphase table. Lowers the cutoff when downsampling to avoid aliasing.
+		sinc
+	};
+
+	/// \brief Sample rate conversion implemented as SIMD using SSE
+	class SoundResampler
+	{
+	public:
+		/// \brief Number of input samples read before the integer part of a position
+		static int get_history(SoundResampleMode mode);
+
+		/// \brief Number of input samples read after the integer part of a position
+		static int get_lookahead(SoundResampleMode mode);
+
+		enum
+		{
+			/// \brief Largest history of any mode
+			max_history = 7,
+
+			/// \brief Largest lookahead of any mode
+			max_lookahead = 8
+		};
+
+		/// \brief Resamples one channel
+		///
+		/// Output sample i is interpolated at input position position + i * step. The input must
+		/// be readable from get_history samples before the first position to get_lookahead samples
+		/// after the last one. When step is 1 and position is a whole number the input is copied.
+		///
+		/// \param mode = Interpolation to use
+		/// \param input = Input samples
+		/// \param position = Input position of the first output sample
+		/// \param step = Input samples advanced per output sample (input rate divided by output rate)
+		/// \param output = Output samples
+		/// \param output_size = Number of samples to write
+		/// \return Input position of the sample following the last output sample
+		static double resample(SoundResampleMode mode, const float *input, double position, double step, float *output, int output_size);
+	};
+
+	/// \}
+}
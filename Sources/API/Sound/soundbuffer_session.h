@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include "sound_resampler.h"
 
 namespace clan
 {
@@ -99,6 +100,9 @@ namespace clan
 		/// \brief Returns true if the session is playing
 		bool is_playing();
 
+		/// \brief Returns the interpolation used when the session frequency differs from the mixing frequency
+		SoundResampleMode get_resample_mode() const;
+
 		/// \brief Sets the session position to 'new_pos'.
 		///
 		/// \param new_pos = The new position of the session.
@@ -157,6 +161,12 @@ namespace clan
 		/// \param loop true if session should loop, false otherwise
 		void set_looping(bool loop);
 
+		/// \brief Sets the interpolation used when the session frequency differs from the mixing frequency
+		///
+		/// The default is SoundResampleMode::linear. Sessions playing at the mixing frequency are copied
+		/// without interpolation regardless of the mode.
+		void set_resample_mode(SoundResampleMode mode);
+
 		/// \brief Adds the sound filter to the session. See SoundFilter for details.
 		///
 		/// \param filter Sound filter to pass sound through.
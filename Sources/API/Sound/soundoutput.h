@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
 
 namespace clan
 {
@@ -40,6 +41,31 @@ namespace clan
 	class SoundOutput_Description;
 	class SoundOutput_Impl;
 
+	/// \brief Time spent by the sound output mixer in each stage, in nanoseconds.
+	struct SoundOutput_Statistics
+	{
+		/// \brief Number of [stereo] samples mixed
+		int64_t samples_mixed = 0;
+
+		/// \brief Time spent mixing fragments, including all stages below
+		int64_t total_time = 0;
+
+		/// \brief Time spent mixing the sessions into the mixing buffers
+		int64_t fill_time = 0;
+
+		/// \brief Time spent in the filters of the output
+		int64_t filter_time = 0;
+
+		/// \brief Time spent applying the global volume and panning
+		int64_t volume_time = 0;
+
+		/// \brief Time spent clamping the mixing buffers
+		int64_t clamp_time = 0;
+
+		/// \brief Returns how many samples the mixer produces per second of mixing time
+		double get_samples_per_second() const { return total_time > 0 ? samples_mixed * 1e9 / total_time : 0.0; }
+	};
+
 	/// \brief SoundOutput interface in ClanLib.
 	///
 	///   <p>SoundOutput is the interface to a sound output device. It is used to
@@ -84,6 +110,12 @@ namespace clan
 		/// \brief Returns the main panning position of the sound output.
 		float get_global_pan() const;
 
+		/// \brief Returns the number of threads used to mix the playing sessions.
+		int get_mixing_threads() const;
+
+		/// \brief Returns the mixer statistics collected since the output was created or the statistics were reset.
+		SoundOutput_Statistics get_statistics() const;
+
 		/// \brief Stops all sample playbacks on the sound output.
 		void stop_all();
 
@@ -93,6 +125,25 @@ namespace clan
 		/// \brief Sets the main panning position on the sound output.
 		void set_global_pan(float pan);
 
+		/// \brief Sets the number of threads used to mix the playing sessions.
+		///
+		/// With more than one thread, the playing sessions are split between worker threads that
+		/// each mix into their own buffers, which are then summed by the mixer thread. Session
+		/// filters are then called from the worker threads. Defaults to 1, mixing every session on
+		/// the mixer thread.
+		void set_mixing_threads(int count);
+
+		/// \brief Resets the mixer statistics.
+		void reset_statistics();
+
+		/// \brief Mixes the next samples of an offline output on the calling thread.
+		///
+		/// Only one thread may render at a time. Throws an exception if the output is not offline.
+		///
+		/// \param out_samples Receives num_samples interleaved stereo samples. Can be null if only the WAV file should receive them.
+		/// \param num_samples Number of [stereo] samples to mix.
+		void render(float *out_samples, int num_samples);
+
 		/// \brief Adds the sound filter to the sound output.
 		///
 		/// \param filter Sound filter to pass sound through.
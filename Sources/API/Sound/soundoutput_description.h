@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 namespace clan
 {
@@ -51,12 +52,29 @@ namespace clan
 		/// \brief Returns the mixing latency in milliseconds.
 		int get_mixing_latency() const;
 
+		/// \brief Returns true if the output renders on demand instead of playing on a sound device.
+		bool is_offline() const;
+
+		/// \brief Returns the WAV file an offline output writes to, or an empty string if none.
+		const std::string &get_offline_filename() const;
+
 		/// \brief Sets the mixing frequency for the sound output device.
 		void set_mixing_frequency(int frequency);
 
 		/// \brief Sets the mixing latency in milliseconds.
+		///
+		/// For an offline output this sets the fragment size the mixer works with.
 		void set_mixing_latency(int latency);
 
+		/// \brief Sets if the output renders on demand instead of playing on a sound device.
+		///
+		/// An offline output has no mixer thread and never waits for hardware. Audio is only mixed
+		/// when SoundOutput::render is called, so the result does not depend on timing.
+		void set_offline(bool offline);
+
+		/// \brief Sets a WAV file that an offline output writes everything it renders to, as 16 bit stereo.
+		void set_offline_filename(const std::string &filename);
+
 	private:
 		std::shared_ptr<SoundOutput_Description_Impl> impl;
 	};
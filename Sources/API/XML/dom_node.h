@@ -397,6 +397,8 @@ namespace clan
 
 		friend class DomDocument;
 		friend class DomNamedNodeMap;
+		friend class XPathExpression_Impl;
+		friend class XPathIndex_Impl;
 	};
 
 	/// \}
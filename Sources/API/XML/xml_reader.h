@@ -0,0 +1,159 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "xml_token.h"
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanXML_XML clanXML XML
+	/// \{
+
+	class IODevice;
+	class XMLReader_Impl;
+
+	/// \brief Reference to a string in the buffer of a XMLReader
+	///
+	/// The string is not zero terminated and is only valid until the reader moves to the next node.
+	class XMLStringRef
+	{
+	public:
+		XMLStringRef() { }
+		XMLStringRef(const char *data, size_t length) : _data(data), _length(length) { }
+
+		const char *data() const { return _data; }
+		size_t size() const { return _length; }
+		size_t length() const { return _length; }
+		bool empty() const { return _length == 0; }
+
+		const char *begin() const { return _data; }
+		const char *end() const { return _data + _length; }
+
+		std::string str() const { return std::string(_data, _length); }
+
+		bool equals(const char *str, size_t length) const { return _length == length && memcmp(_data, str, length) == 0; }
+
+		bool operator==(const std::string &other) const { return equals(other.data(), other.length()); }
+		bool operator==(const char *other) const { return equals(other, strlen(other)); }
+		bool operator!=(const std::string &other) const { return !(*this == other); }
+		bool operator!=(const char *other) const { return !(*this == other); }
+
+	private:
+		const char *_data = "";
+		size_t _length = 0;
+	};
+
+	/// \brief Streaming XML pull parser.
+	///
+	/// Reads the input in blocks and returns one node at a time without building a document.
+	/// The nodes are the same as the tokens returned by XMLTokenizer, but names and values are
+	/// returned as references into the reader's buffer instead of being copied into strings.
+	/// They are only valid until the next call to read() or skip().
+	///
+	/// The memory used is the size of the largest node in the input, not the size of the input.
+	class XMLReader
+	{
+	public:
+		/// \brief Constructs a null instance
+		XMLReader();
+
+		/// \brief Constructs a XMLReader
+		///
+		/// \param input = IODevice to read the XML from, starting at its current position
+		XMLReader(IODevice &input);
+
+		~XMLReader();
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid
+		void throw_if_null() const;
+
+		/// \brief Returns true if eat whitespace flag is set.
+		bool get_eat_whitespace() const;
+
+		/// \brief If enabled, will skip whitespace only text and trim whitespace around text and comments.
+		void set_eat_whitespace(bool enable);
+
+		/// \brief Moves to the next node.
+		///
+		/// \return false when the end of the input has been reached
+		bool read();
+
+		/// \brief Skips the children of the current element.
+		///
+		/// If the current node is the beginning of an element, moves to its end element.
+		/// For other nodes this does nothing.
+		void skip();
+
+		/// \brief Returns the type of the current node, or XMLToken::NULL_TOKEN at the end of the input.
+		XMLToken::TokenType get_type() const;
+
+		/// \brief Returns if the current node begins, ends or is a complete element.
+		XMLToken::TokenVariant get_variant() const;
+
+		/// \brief Returns the nesting level of the current node.
+		///
+		/// The root element has depth 0. The end of an element has the same depth as its beginning.
+		int get_depth() const;
+
+		/// \brief Returns the element or processing instruction name.
+		XMLStringRef get_name() const;
+
+		/// \brief Returns the text, comment, CDATA section or processing instruction value.
+		XMLStringRef get_value() const;
+
+		/// \brief Returns the number of attributes of the current element.
+		int get_attribute_count() const;
+
+		/// \brief Returns the name of an attribute of the current element.
+		XMLStringRef get_attribute_name(int index) const;
+
+		/// \brief Returns the value of an attribute of the current element.
+		XMLStringRef get_attribute_value(int index) const;
+
+		/// \brief Returns true if the current element has an attribute with the given name.
+		bool has_attribute(const char *name) const;
+
+		/// \brief Returns the value of an attribute of the current element, or an empty string if it is missing.
+		XMLStringRef get_attribute(const char *name) const;
+
+		/// \brief Copies the current node into a XMLToken.
+		void get_token(XMLToken *out_token) const;
+
+	private:
+		std::shared_ptr<XMLReader_Impl> impl;
+	};
+
+	/// \}
+}
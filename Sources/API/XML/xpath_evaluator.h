@@ -48,6 +48,9 @@ namespace clan
 
 		/// \brief Evaluate
 		///
+		/// The expression is compiled on first use and the compiled XPathExpression is
+		/// reused by later calls with the same expression text.
+		///
 		/// \param expression = String Ref
 		/// \param context_node = Dom Node
 		///
@@ -29,7 +29,7 @@
 
 #pragma once
 
-#include "API/Core/System/exception.h"
+#include "../Core/System/exception.h"
 
 namespace clan
 {
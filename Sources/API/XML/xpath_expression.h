@@ -0,0 +1,91 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "xpath_object.h"
+
+namespace clan
+{
+	/// \addtogroup clanXML_XML clanXML XML
+	/// \{
+
+	class DomNode;
+	class XPathIndex;
+	class XPathExpression_Impl;
+
+	/// \brief Compiled XPath expression.
+	///
+	/// The expression is parsed once and can then be evaluated any number of times
+	/// against any context node. Location paths made of child, descendant, attribute,
+	/// self and parent steps with position or attribute predicates are evaluated
+	/// directly on the document tree. Other expressions are evaluated by the
+	/// XPathEvaluator interpreter using the tokens read at compile time.
+	class XPathExpression
+	{
+	public:
+		/// \brief Constructs a null instance
+		XPathExpression();
+
+		/// \brief Compiles an expression
+		///
+		/// Throws XPathException if the expression contains invalid tokens.
+		XPathExpression(const std::string &expression);
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid
+		void throw_if_null() const;
+
+		/// \brief Returns the source text of the expression
+		const std::string &get_expression() const;
+
+		/// \brief Returns true if the expression is a location path evaluated without the interpreter
+		bool is_location_path() const;
+
+		/// \brief Evaluates the expression
+		XPathObject evaluate(const DomNode &context_node) const;
+
+		/// \brief Evaluates the expression, using the index to find the first step of '//name' paths
+		///
+		/// The index is only used if it was built for the document of the context node.
+		XPathObject evaluate(const DomNode &context_node, const XPathIndex &index) const;
+
+		/// \brief Returns the nodes selected by the expression, or an empty list if it does not evaluate to a node-set
+		std::vector<DomNode> select_nodes(const DomNode &context_node) const;
+		std::vector<DomNode> select_nodes(const DomNode &context_node, const XPathIndex &index) const;
+
+	private:
+		std::shared_ptr<XPathExpression_Impl> impl;
+	};
+
+	/// \}
+}
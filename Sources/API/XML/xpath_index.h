@@ -0,0 +1,67 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanXML_XML clanXML XML
+	/// \{
+
+	class DomDocument;
+	class XPathIndex_Impl;
+
+	/// \brief Element lookup tables of a document for XPathExpression.
+	///
+	/// Indexes elements by name and by the values of their 'id' and 'name' attributes,
+	/// so that paths such as //resource[@name='x'] do not have to visit the whole tree.
+	///
+	/// The index is a snapshot of the document. Build it after loading the document and
+	/// build a new one after modifying it.
+	class XPathIndex
+	{
+	public:
+		/// \brief Constructs a null instance
+		XPathIndex();
+
+		/// \brief Indexes the elements of a document
+		XPathIndex(const DomDocument &document);
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+	private:
+		std::shared_ptr<XPathIndex_Impl> impl;
+
+		friend class XPathExpression;
+	};
+
+	/// \}
+}
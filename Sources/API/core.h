@@ -83,6 +83,8 @@
 #include "Core/Resources/file_resource_document.h"
 #include "Core/Resources/file_resource_manager.h"
 #include "Core/JSON/json_value.h"
+#include "Core/JSON/json_reader.h"
+#include "Core/JSON/json_document.h"
 #include "Core/IOData/file.h"
 #include "Core/IOData/file_help.h"
 #include "Core/IOData/path_help.h"
@@ -97,6 +99,7 @@
 #include "Core/IOData/memory_device.h"
 #include "Core/IOData/html_url.h"
 #include "Core/Zip/zip_archive.h"
+#include "Core/Zip/zip_mapped_archive.h"
 #include "Core/Zip/zip_writer.h"
 #include "Core/Zip/zip_reader.h"
 #include "Core/Zip/zip_file_entry.h"
@@ -149,6 +152,8 @@
 #include "Core/Crypto/aes192_decrypt.h"
 #include "Core/Crypto/aes256_encrypt.h"
 #include "Core/Crypto/aes256_decrypt.h"
+#include "Core/Crypto/aes_ctr.h"
+#include "Core/Crypto/aes_gcm.h"
 #include "Core/Crypto/rsa.h"
 #include "Core/Crypto/tls_client.h"
 #include "Core/Math/size.h"
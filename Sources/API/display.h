@@ -40,6 +40,7 @@
 #include "Display/display_target.h"
 #include "Display/screen_info.h"
 #include "Display/Resources/display_cache.h"
+#include "Display/Resources/texture_preloader.h"
 #include "Display/2D/canvas.h"
 #include "Display/2D/color.h"
 #include "Display/2D/color_hsv.h"
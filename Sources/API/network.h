@@ -46,12 +46,15 @@
 #include "Network/Socket/tcp_listen.h"
 #include "Network/Socket/udp_socket.h"
 
+#include "Network/NetGame/channel.h"
 #include "Network/NetGame/client.h"
 #include "Network/NetGame/connection.h"
 #include "Network/NetGame/event.h"
 #include "Network/NetGame/event_dispatcher.h"
 #include "Network/NetGame/event_value.h"
+#include "Network/NetGame/event_view.h"
 #include "Network/NetGame/server.h"
+#include "Network/NetGame/snapshot.h"
 
 #ifdef __cplusplus_cli
 #pragma managed(pop)
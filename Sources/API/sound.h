@@ -50,6 +50,7 @@
 #include "Sound/soundbuffer_session.h"
 #include "Sound/soundfilter.h"
 #include "Sound/sound_sse.h"
+#include "Sound/sound_resampler.h"
 
 #include "Sound/SoundProviders/soundprovider_wave.h"
 #include "Sound/SoundProviders/soundprovider_raw.h"
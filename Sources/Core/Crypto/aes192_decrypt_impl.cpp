@@ -75,6 +75,7 @@ namespace clan
 		cipher_key_set = true;
 		extract_encrypt_key192(key, key_expanded);
 		extract_decrypt_key(key_expanded, aes192_num_rounds_nr);
+		set_hardware_round_keys(key_expanded, aes192_num_rounds_nr);
 	}
 
 	void AES192_Decrypt_Impl::add(const void *_data, int size)
@@ -173,6 +174,7 @@ namespace clan
 		initialisation_vector_set = false;	// Force to reset after each call
 		cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
 		memset(key_expanded, 0, sizeof(key_expanded));
+		memset(hardware_round_keys, 0, sizeof(hardware_round_keys));
 
 		return true;
 
@@ -180,6 +182,21 @@ namespace clan
 
 	void AES192_Decrypt_Impl::process_chunk()
 	{
+		if (use_hardware)
+		{
+			// Cipher Block Chaining Mode using AES-NI
+			unsigned char block[aes192_block_size_bytes];
+			memcpy(block, chunk, aes192_block_size_bytes);
+			decrypt_block_hardware(aes192_num_rounds_nr, block);
+			store_block(get_word(block) ^ initialisation_vector_1, get_word(block + 4) ^ initialisation_vector_2, get_word(block + 8) ^ initialisation_vector_3, get_word(block + 12) ^ initialisation_vector_4, databuffer);
+
+			initialisation_vector_1 = get_word(chunk);
+			initialisation_vector_2 = get_word(chunk + 4);
+			initialisation_vector_3 = get_word(chunk + 8);
+			initialisation_vector_4 = get_word(chunk + 12);
+			return;
+		}
+
 		const uint32_t *key_expanded_ptr = key_expanded;
 
 		uint32_t chunk1 = get_word(chunk);
@@ -77,6 +77,7 @@ namespace clan
 	{
 		cipher_key_set = true;
 		extract_encrypt_key256(key, key_expanded);
+		set_hardware_round_keys(key_expanded, aes256_num_rounds_nr);
 	}
 
 	void AES256_Encrypt_Impl::add(const void *_data, int size)
@@ -144,10 +145,29 @@ namespace clan
 		initialisation_vector_set = false;	// Force to reset after each call
 		cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
 		memset(key_expanded, 0, sizeof(key_expanded));	// Remove the key from memory
+		memset(hardware_round_keys, 0, sizeof(hardware_round_keys));
 	}
 
 	void AES256_Encrypt_Impl::process_chunk()
 	{
+		if (use_hardware)
+		{
+			// Cipher Block Chaining Mode using AES-NI
+			unsigned char block[aes256_block_size_bytes];
+			put_word(initialisation_vector_1 ^ get_word(chunk), block);
+			put_word(initialisation_vector_2 ^ get_word(chunk + 4), block + 4);
+			put_word(initialisation_vector_3 ^ get_word(chunk + 8), block + 8);
+			put_word(initialisation_vector_4 ^ get_word(chunk + 12), block + 12);
+			encrypt_block_hardware(aes256_num_rounds_nr, block);
+
+			initialisation_vector_1 = get_word(block);
+			initialisation_vector_2 = get_word(block + 4);
+			initialisation_vector_3 = get_word(block + 8);
+			initialisation_vector_4 = get_word(block + 12);
+			store_block(initialisation_vector_1, initialisation_vector_2, initialisation_vector_3, initialisation_vector_4, databuffer);
+			return;
+		}
+
 		const uint32_t *key_expanded_ptr = key_expanded;
 
 		/* Electronic Codebook Mode
@@ -0,0 +1,70 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Crypto/aes_ctr.h"
+#include "aes_ctr_impl.h"
+#include "aes_ni.h"
+
+namespace clan
+{
+	AES_CTR::AES_CTR()
+		: impl(std::make_shared<AES_CTR_Impl>())
+	{
+	}
+
+	bool AES_CTR::is_hardware_accelerated()
+	{
+		return AES_NI::is_supported();
+	}
+
+	void AES_CTR::set_key(const unsigned char *key, int key_size)
+	{
+		impl->set_key(key, key_size);
+	}
+
+	void AES_CTR::set_iv(const unsigned char iv[iv_size])
+	{
+		impl->set_iv(iv);
+	}
+
+	void AES_CTR::process(void *data, int size)
+	{
+		impl->process(static_cast<const unsigned char*>(data), static_cast<unsigned char*>(data), size);
+	}
+
+	void AES_CTR::process(const void *input, void *output, int size)
+	{
+		impl->process(static_cast<const unsigned char*>(input), static_cast<unsigned char*>(output), size);
+	}
+
+	void AES_CTR::reset()
+	{
+		impl->reset();
+	}
+}
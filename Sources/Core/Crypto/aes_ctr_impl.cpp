@@ -0,0 +1,105 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "aes_ctr_impl.h"
+
+namespace clan
+{
+	AES_CTR_Impl::AES_CTR_Impl() : num_rounds(0)
+	{
+		reset();
+	}
+
+	AES_CTR_Impl::~AES_CTR_Impl()
+	{
+		reset();
+	}
+
+	void AES_CTR_Impl::set_key(const unsigned char *key, int key_size)
+	{
+		num_rounds = extract_encrypt_key(key, key_size, key_expanded);
+		set_hardware_round_keys(key_expanded, num_rounds);
+		cipher_key_set = true;
+	}
+
+	void AES_CTR_Impl::set_iv(const unsigned char iv[16])
+	{
+		if (!cipher_key_set)
+			throw Exception("AES-CTR cipher key has not been set");
+
+		memcpy(counter, iv, aes128_block_size_bytes);
+		key_stream_used = aes128_block_size_bytes;
+		initialisation_vector_set = true;
+	}
+
+	void AES_CTR_Impl::process(const unsigned char *input, unsigned char *output, int size)
+	{
+		if (!initialisation_vector_set)
+			throw Exception("AES-CTR initialisation vector has not been set");
+
+		int pos = 0;
+
+		// Use up the key stream left over from the previous call
+		while (key_stream_used < aes128_block_size_bytes && pos < size)
+		{
+			output[pos] = input[pos] ^ key_stream[key_stream_used++];
+			pos++;
+		}
+
+		int num_blocks = (size - pos) / aes128_block_size_bytes;
+		if (num_blocks > 0)
+		{
+			ctr_blocks(key_expanded, num_rounds, counter, false, input + pos, output + pos, num_blocks);
+			pos += num_blocks * aes128_block_size_bytes;
+		}
+
+		if (pos < size)
+		{
+			memset(key_stream, 0, sizeof(key_stream));
+			ctr_blocks(key_expanded, num_rounds, counter, false, key_stream, key_stream, 1);
+			key_stream_used = 0;
+			while (pos < size)
+			{
+				output[pos] = input[pos] ^ key_stream[key_stream_used++];
+				pos++;
+			}
+		}
+	}
+
+	void AES_CTR_Impl::reset()
+	{
+		memset(key_expanded, 0, sizeof(key_expanded));
+		memset(hardware_round_keys, 0, sizeof(hardware_round_keys));
+		memset(counter, 0, sizeof(counter));
+		memset(key_stream, 0, sizeof(key_stream));
+		key_stream_used = aes128_block_size_bytes;
+		cipher_key_set = false;
+		initialisation_vector_set = false;
+	}
+}
@@ -0,0 +1,61 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/databuffer.h"
+#include "aes_impl.h"
+
+namespace clan
+{
+	class AES_CTR_Impl : public AES_Impl
+	{
+	public:
+		AES_CTR_Impl();
+		~AES_CTR_Impl();
+
+		void set_key(const unsigned char *key, int key_size);
+		void set_iv(const unsigned char iv[16]);
+		void process(const unsigned char *input, unsigned char *output, int size);
+		void reset();
+
+	private:
+		uint32_t key_expanded[aes256_nb_mult_nr_plus1];
+		int num_rounds;
+
+		unsigned char counter[aes128_block_size_bytes];
+
+		/// \brief Key stream of the last partially used block
+		unsigned char key_stream[aes128_block_size_bytes];
+		int key_stream_used;
+
+		bool cipher_key_set;
+		bool initialisation_vector_set;
+	};
+}
@@ -0,0 +1,95 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Crypto/aes_gcm.h"
+#include "aes_gcm_impl.h"
+#include "aes_ni.h"
+
+namespace clan
+{
+	AES_GCM::AES_GCM()
+		: impl(std::make_shared<AES_GCM_Impl>())
+	{
+	}
+
+	bool AES_GCM::is_hardware_accelerated()
+	{
+		return AES_NI::is_ghash_supported();
+	}
+
+	void AES_GCM::set_key(const unsigned char *key, int key_size)
+	{
+		impl->set_key(key, key_size);
+	}
+
+	void AES_GCM::set_iv(const unsigned char *iv, int size)
+	{
+		impl->set_iv(iv, size);
+	}
+
+	void AES_GCM::add_aad(const void *data, int size)
+	{
+		impl->add_aad(static_cast<const unsigned char*>(data), size);
+	}
+
+	void AES_GCM::encrypt(void *data, int size)
+	{
+		impl->crypt(static_cast<const unsigned char*>(data), static_cast<unsigned char*>(data), size, true);
+	}
+
+	void AES_GCM::encrypt(const void *input, void *output, int size)
+	{
+		impl->crypt(static_cast<const unsigned char*>(input), static_cast<unsigned char*>(output), size, true);
+	}
+
+	void AES_GCM::decrypt(void *data, int size)
+	{
+		impl->crypt(static_cast<const unsigned char*>(data), static_cast<unsigned char*>(data), size, false);
+	}
+
+	void AES_GCM::decrypt(const void *input, void *output, int size)
+	{
+		impl->crypt(static_cast<const unsigned char*>(input), static_cast<unsigned char*>(output), size, false);
+	}
+
+	void AES_GCM::get_tag(unsigned char tag[tag_size])
+	{
+		impl->get_tag(tag);
+	}
+
+	bool AES_GCM::verify_tag(const unsigned char *tag, int size)
+	{
+		return impl->verify_tag(tag, size);
+	}
+
+	void AES_GCM::reset()
+	{
+		impl->reset();
+	}
+}
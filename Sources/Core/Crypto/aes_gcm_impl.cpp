@@ -0,0 +1,360 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Math/cl_math.h"
+#include "aes_gcm_impl.h"
+#include "aes_ni.h"
+
+namespace clan
+{
+	AES_GCM_Impl::AES_GCM_Impl() : num_rounds(0), use_clmul(AES_NI::is_ghash_supported())
+	{
+		reset();
+	}
+
+	AES_GCM_Impl::~AES_GCM_Impl()
+	{
+		reset();
+	}
+
+	void AES_GCM_Impl::set_key(const unsigned char *key, int key_size)
+	{
+		num_rounds = extract_encrypt_key(key, key_size, key_expanded);
+		set_hardware_round_keys(key_expanded, num_rounds);
+
+		// The hash key H is the encrypted zero block
+		unsigned char hash_key[aes128_block_size_bytes] = { 0 };
+		unsigned char zero_counter[aes128_block_size_bytes] = { 0 };
+		ctr_blocks(key_expanded, num_rounds, zero_counter, true, hash_key, hash_key, 1);
+		if (use_clmul)
+			AES_NI::ghash_init(hash_key, hash_key_powers);
+		else
+			software_ghash_init(hash_key);
+		memset(hash_key, 0, sizeof(hash_key));
+
+		cipher_key_set = true;
+		initialisation_vector_set = false;
+	}
+
+	void AES_GCM_Impl::set_iv(const unsigned char *iv, int size)
+	{
+		if (!cipher_key_set)
+			throw Exception("AES-GCM cipher key has not been set");
+		if (size <= 0)
+			throw Exception("AES-GCM initialisation vector cannot be empty");
+
+		memset(ghash_state, 0, sizeof(ghash_state));
+		partial_block_filled = 0;
+		aad_length = 0;
+		text_length = 0;
+		text_started = false;
+
+		if (size == 12)
+		{
+			// J0 = IV || 0^31 || 1
+			memcpy(counter, iv, 12);
+			counter[12] = 0;
+			counter[13] = 0;
+			counter[14] = 0;
+			counter[15] = 1;
+		}
+		else
+		{
+			// J0 = GHASH(IV || padding || 0^64 || bit length of IV)
+			int num_blocks = size / aes128_block_size_bytes;
+			ghash_blocks(iv, num_blocks);
+			add_aad(iv + num_blocks * aes128_block_size_bytes, size - num_blocks * aes128_block_size_bytes);
+			ghash_flush();
+
+			unsigned char length_block[aes128_block_size_bytes] = { 0 };
+			uint64_t bit_length = (uint64_t)size * 8;
+			put_word((uint32_t)(bit_length >> 32), length_block + 8);
+			put_word((uint32_t)bit_length, length_block + 12);
+			ghash_blocks(length_block, 1);
+
+			memcpy(counter, ghash_state, aes128_block_size_bytes);
+			memset(ghash_state, 0, sizeof(ghash_state));
+			aad_length = 0;
+		}
+
+		// The tag is masked with E(K, J0) and the message starts at J0 + 1
+		memset(tag_mask, 0, sizeof(tag_mask));
+		ctr_blocks(key_expanded, num_rounds, counter, true, tag_mask, tag_mask, 1);
+
+		initialisation_vector_set = true;
+	}
+
+	void AES_GCM_Impl::add_aad(const unsigned char *data, int size)
+	{
+		if (text_started)
+			throw Exception("AES-GCM additional data must be added before encrypting or decrypting");
+
+		aad_length += size;
+
+		int pos = 0;
+		if (partial_block_filled > 0)
+		{
+			int data_used = min(aes128_block_size_bytes - partial_block_filled, size);
+			memcpy(partial_block + partial_block_filled, data, data_used);
+			partial_block_filled += data_used;
+			pos += data_used;
+			if (partial_block_filled == aes128_block_size_bytes)
+			{
+				ghash_blocks(partial_block, 1);
+				partial_block_filled = 0;
+			}
+		}
+
+		int num_blocks = (size - pos) / aes128_block_size_bytes;
+		ghash_blocks(data + pos, num_blocks);
+		pos += num_blocks * aes128_block_size_bytes;
+
+		if (pos < size)
+		{
+			memcpy(partial_block, data + pos, size - pos);
+			partial_block_filled = size - pos;
+		}
+	}
+
+	void AES_GCM_Impl::crypt(const unsigned char *input, unsigned char *output, int size, bool encrypting)
+	{
+		if (!initialisation_vector_set)
+			throw Exception("AES-GCM initialisation vector has not been set");
+
+		if (!text_started)
+		{
+			if (aad_length > ((uint64_t)1 << 61) - 1)
+				throw Exception("AES-GCM additional data is too long");
+			ghash_flush();
+			text_started = true;
+		}
+
+		text_length += size;
+		if (text_length > ((uint64_t)1 << 36) - 32)
+			throw Exception("AES-GCM message is too long");
+
+		int pos = 0;
+
+		// Complete the block left partially filled by the previous call
+		while (partial_block_filled > 0 && pos < size)
+		{
+			unsigned char input_byte = input[pos];
+			unsigned char output_byte = input_byte ^ key_stream[partial_block_filled];
+			partial_block[partial_block_filled++] = encrypting ? output_byte : input_byte;
+			output[pos++] = output_byte;
+			if (partial_block_filled == aes128_block_size_bytes)
+			{
+				ghash_blocks(partial_block, 1);
+				partial_block_filled = 0;
+			}
+		}
+
+		// Whole blocks are processed in chunks small enough to stay in the L1 cache between the CTR and GHASH passes
+		const int chunk_blocks = 256;
+		while (size - pos >= aes128_block_size_bytes)
+		{
+			int num_blocks = min((size - pos) / aes128_block_size_bytes, chunk_blocks);
+			if (!encrypting)
+				ghash_blocks(input + pos, num_blocks);
+			ctr_blocks(key_expanded, num_rounds, counter, true, input + pos, output + pos, num_blocks);
+			if (encrypting)
+				ghash_blocks(output + pos, num_blocks);
+			pos += num_blocks * aes128_block_size_bytes;
+		}
+
+		if (pos < size)
+		{
+			memset(key_stream, 0, sizeof(key_stream));
+			ctr_blocks(key_expanded, num_rounds, counter, true, key_stream, key_stream, 1);
+			while (pos < size)
+			{
+				unsigned char input_byte = input[pos];
+				unsigned char output_byte = input_byte ^ key_stream[partial_block_filled];
+				partial_block[partial_block_filled++] = encrypting ? output_byte : input_byte;
+				output[pos++] = output_byte;
+			}
+		}
+	}
+
+	void AES_GCM_Impl::get_tag(unsigned char tag[16])
+	{
+		if (!initialisation_vector_set)
+			throw Exception("AES-GCM initialisation vector has not been set");
+
+		ghash_flush();
+
+		unsigned char length_block[aes128_block_size_bytes];
+		uint64_t aad_bits = aad_length * 8;
+		uint64_t text_bits = text_length * 8;
+		put_word((uint32_t)(aad_bits >> 32), length_block);
+		put_word((uint32_t)aad_bits, length_block + 4);
+		put_word((uint32_t)(text_bits >> 32), length_block + 8);
+		put_word((uint32_t)text_bits, length_block + 12);
+		ghash_blocks(length_block, 1);
+
+		for (int cnt = 0; cnt < aes128_block_size_bytes; cnt++)
+			tag[cnt] = ghash_state[cnt] ^ tag_mask[cnt];
+
+		// Force a new IV for the next message
+		initialisation_vector_set = false;
+		memset(ghash_state, 0, sizeof(ghash_state));
+		memset(tag_mask, 0, sizeof(tag_mask));
+		memset(key_stream, 0, sizeof(key_stream));
+	}
+
+	bool AES_GCM_Impl::verify_tag(const unsigned char *tag, int size)
+	{
+		// Shorter tags make forging a message practical, so they are not accepted (NIST SP 800-38D allows 12 to 16 bytes for general use)
+		if (size < 12 || size > aes128_block_size_bytes)
+			throw Exception("AES-GCM tag must be 12 to 16 bytes");
+
+		unsigned char expected_tag[aes128_block_size_bytes];
+		get_tag(expected_tag);
+
+		unsigned char difference = 0;
+		for (int cnt = 0; cnt < size; cnt++)
+			difference |= expected_tag[cnt] ^ tag[cnt];
+		return difference == 0;
+	}
+
+	void AES_GCM_Impl::reset()
+	{
+		memset(key_expanded, 0, sizeof(key_expanded));
+		memset(hardware_round_keys, 0, sizeof(hardware_round_keys));
+		memset(hash_key_powers, 0, sizeof(hash_key_powers));
+		memset(hash_table_high, 0, sizeof(hash_table_high));
+		memset(hash_table_low, 0, sizeof(hash_table_low));
+		memset(counter, 0, sizeof(counter));
+		memset(tag_mask, 0, sizeof(tag_mask));
+		memset(ghash_state, 0, sizeof(ghash_state));
+		memset(partial_block, 0, sizeof(partial_block));
+		memset(key_stream, 0, sizeof(key_stream));
+		partial_block_filled = 0;
+		aad_length = 0;
+		text_length = 0;
+		cipher_key_set = false;
+		initialisation_vector_set = false;
+		text_started = false;
+	}
+
+	void AES_GCM_Impl::ghash_blocks(const unsigned char *data, int num_blocks)
+	{
+		if (use_clmul)
+		{
+			AES_NI::ghash(hash_key_powers, ghash_state, data, num_blocks);
+			return;
+		}
+
+		for (int block = 0; block < num_blocks; block++)
+		{
+			for (int cnt = 0; cnt < aes128_block_size_bytes; cnt++)
+				ghash_state[cnt] ^= data[cnt];
+			software_ghash_multiply(ghash_state);
+			data += aes128_block_size_bytes;
+		}
+	}
+
+	void AES_GCM_Impl::ghash_flush()
+	{
+		if (partial_block_filled > 0)
+		{
+			memset(partial_block + partial_block_filled, 0, aes128_block_size_bytes - partial_block_filled);
+			ghash_blocks(partial_block, 1);
+			partial_block_filled = 0;
+		}
+	}
+
+	void AES_GCM_Impl::software_ghash_init(const unsigned char hash_key[16])
+	{
+		uint64_t high = ((uint64_t)get_word(hash_key) << 32) | get_word(hash_key + 4);
+		uint64_t low = ((uint64_t)get_word(hash_key + 8) << 32) | get_word(hash_key + 12);
+
+		// Entry 8 is H, entries 4, 2 and 1 are H multiplied by x, x^2 and x^3
+		hash_table_high[0] = 0;
+		hash_table_low[0] = 0;
+		hash_table_high[8] = high;
+		hash_table_low[8] = low;
+		for (int index = 4; index > 0; index >>= 1)
+		{
+			uint64_t reduce = (low & 1) ? ((uint64_t)0xe1000000 << 32) : 0;
+			low = (high << 63) | (low >> 1);
+			high = (high >> 1) ^ reduce;
+			hash_table_high[index] = high;
+			hash_table_low[index] = low;
+		}
+
+		// The remaining entries are sums of those
+		for (int index = 2; index <= 8; index *= 2)
+		{
+			for (int cnt = 1; cnt < index; cnt++)
+			{
+				hash_table_high[index + cnt] = hash_table_high[index] ^ hash_table_high[cnt];
+				hash_table_low[index + cnt] = hash_table_low[index] ^ hash_table_low[cnt];
+			}
+		}
+	}
+
+	void AES_GCM_Impl::software_ghash_multiply(unsigned char x[16]) const
+	{
+		static const uint64_t remainder_table[16] =
+		{
+			0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+			0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+		};
+
+		int nibble = x[15] & 0xf;
+		uint64_t high = hash_table_high[nibble];
+		uint64_t low = hash_table_low[nibble];
+
+		for (int cnt = 15; cnt >= 0; cnt--)
+		{
+			if (cnt != 15)
+			{
+				nibble = x[cnt] & 0xf;
+				int remainder = (int)(low & 0xf);
+				low = (high << 60) | (low >> 4);
+				high = (high >> 4) ^ (remainder_table[remainder] << 48);
+				high ^= hash_table_high[nibble];
+				low ^= hash_table_low[nibble];
+			}
+
+			nibble = x[cnt] >> 4;
+			int remainder = (int)(low & 0xf);
+			low = (high << 60) | (low >> 4);
+			high = (high >> 4) ^ (remainder_table[remainder] << 48);
+			high ^= hash_table_high[nibble];
+			low ^= hash_table_low[nibble];
+		}
+
+		put_word((uint32_t)(high >> 32), x);
+		put_word((uint32_t)high, x + 4);
+		put_word((uint32_t)(low >> 32), x + 8);
+		put_word((uint32_t)low, x + 12);
+	}
+}
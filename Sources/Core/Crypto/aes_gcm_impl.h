@@ -0,0 +1,83 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/databuffer.h"
+#include "aes_impl.h"
+
+namespace clan
+{
+	class AES_GCM_Impl : public AES_Impl
+	{
+	public:
+		AES_GCM_Impl();
+		~AES_GCM_Impl();
+
+		void set_key(const unsigned char *key, int key_size);
+		void set_iv(const unsigned char *iv, int size);
+		void add_aad(const unsigned char *data, int size);
+		void crypt(const unsigned char *input, unsigned char *output, int size, bool encrypting);
+		void get_tag(unsigned char tag[16]);
+		bool verify_tag(const unsigned char *tag, int size);
+		void reset();
+
+	private:
+		void ghash_blocks(const unsigned char *data, int num_blocks);
+		void ghash_flush();
+		void software_ghash_init(const unsigned char hash_key[16]);
+		void software_ghash_multiply(unsigned char x[16]) const;
+
+		uint32_t key_expanded[aes256_nb_mult_nr_plus1];
+		int num_rounds;
+
+		bool use_clmul;
+		unsigned char hash_key_powers[4 * aes128_block_size_bytes];
+
+		// 4 bit multiplication tables for the software GHASH (Shoup's method)
+		uint64_t hash_table_high[16];
+		uint64_t hash_table_low[16];
+
+		unsigned char counter[aes128_block_size_bytes];
+		unsigned char tag_mask[aes128_block_size_bytes];
+		unsigned char ghash_state[aes128_block_size_bytes];
+
+		/// \brief Last incomplete block of additional data or cipher text, and the key stream it was encrypted with
+		unsigned char partial_block[aes128_block_size_bytes];
+		unsigned char key_stream[aes128_block_size_bytes];
+		int partial_block_filled;
+
+		uint64_t aad_length;
+		uint64_t text_length;
+
+		bool cipher_key_set;
+		bool initialisation_vector_set;
+		bool text_started;
+	};
+}
@@ -32,6 +32,7 @@
 #include "API/Core/System/databuffer.h"
 #include "API/Core/Math/cl_math.h"
 #include "aes_impl.h"
+#include "aes_ni.h"
 
 #ifndef WIN32
 #include <cstring>
@@ -39,13 +40,14 @@
 
 namespace clan
 {
-	AES_Impl::AES_Impl()
+	AES_Impl::AES_Impl() : use_hardware(AES_NI::is_supported())
 	{
 		if (!is_tables_created)
 		{
 			create_tables();
 			is_tables_created = true;
 		}
+		memset(hardware_round_keys, 0, sizeof(hardware_round_keys));
 	}
 
 	bool AES_Impl::is_tables_created = false;
@@ -168,7 +170,7 @@ namespace clan
 		int available = current_capacity - current_size;
 		if (available < aes128_block_size_bytes)	// Increase capacity required
 		{
-			databuffer.set_capacity(current_capacity + 1024);	// Increase in blocks of 1K
+			databuffer.set_capacity(current_capacity + max(current_capacity, 1024));	// Double the capacity, starting at 1K
 		}
 		databuffer.set_size(current_size + aes128_block_size_bytes);
 		unsigned char *dest_ptr = (unsigned char *)databuffer.get_data();
@@ -180,6 +182,103 @@ namespace clan
 		put_word(s3, dest_ptr + 12);
 	}
 
+	int AES_Impl::extract_encrypt_key(const unsigned char *key, int key_size, uint32_t key_expanded[aes256_nb_mult_nr_plus1])
+	{
+		switch (key_size)
+		{
+		case aes128_key_length_bytes:
+			extract_encrypt_key128(key, key_expanded);
+			return aes128_num_rounds_nr;
+		case aes192_key_length_bytes:
+			extract_encrypt_key192(key, key_expanded);
+			return aes192_num_rounds_nr;
+		case aes256_key_length_bytes:
+			extract_encrypt_key256(key, key_expanded);
+			return aes256_num_rounds_nr;
+		default:
+			throw Exception("AES cipher key must be 16, 24 or 32 bytes");
+		}
+	}
+
+	void AES_Impl::encrypt_block(const uint32_t *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const
+	{
+		uint32_t s0 = get_word(input) ^ key_expanded[0];
+		uint32_t s1 = get_word(input + 4) ^ key_expanded[1];
+		uint32_t s2 = get_word(input + 8) ^ key_expanded[2];
+		uint32_t s3 = get_word(input + 12) ^ key_expanded[3];
+
+		for (int round = 1; round < num_rounds; round++)
+		{
+			key_expanded += 4;
+			uint32_t t0 = table_e0[s0 >> 24] ^ table_e1[(s1 >> 16) & 0xff] ^ table_e2[(s2 >> 8) & 0xff] ^ table_e3[s3 & 0xff] ^ key_expanded[0];
+			uint32_t t1 = table_e0[s1 >> 24] ^ table_e1[(s2 >> 16) & 0xff] ^ table_e2[(s3 >> 8) & 0xff] ^ table_e3[s0 & 0xff] ^ key_expanded[1];
+			uint32_t t2 = table_e0[s2 >> 24] ^ table_e1[(s3 >> 16) & 0xff] ^ table_e2[(s0 >> 8) & 0xff] ^ table_e3[s1 & 0xff] ^ key_expanded[2];
+			uint32_t t3 = table_e0[s3 >> 24] ^ table_e1[(s0 >> 16) & 0xff] ^ table_e2[(s1 >> 8) & 0xff] ^ table_e3[s2 & 0xff] ^ key_expanded[3];
+			s0 = t0;
+			s1 = t1;
+			s2 = t2;
+			s3 = t3;
+		}
+
+		key_expanded += 4;
+
+		// Apply last round
+		put_word((sbox_substitution_values[(s0 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s1 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s2 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s3)& 0xff] & 0x000000ff) ^ key_expanded[0], output);
+		put_word((sbox_substitution_values[(s1 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s2 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s3 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s0)& 0xff] & 0x000000ff) ^ key_expanded[1], output + 4);
+		put_word((sbox_substitution_values[(s2 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s3 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s0 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s1)& 0xff] & 0x000000ff) ^ key_expanded[2], output + 8);
+		put_word((sbox_substitution_values[(s3 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s0 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s1 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s2)& 0xff] & 0x000000ff) ^ key_expanded[3], output + 12);
+	}
+
+	void AES_Impl::ctr_blocks(const uint32_t *key_expanded, int num_rounds, unsigned char counter[16], bool increment_32bit, const unsigned char *input, unsigned char *output, int num_blocks) const
+	{
+		if (use_hardware)
+		{
+			AES_NI::ctr(hardware_round_keys, num_rounds, counter, increment_32bit, input, output, num_blocks);
+			return;
+		}
+
+		unsigned char key_stream[aes128_block_size_bytes];
+		for (int block = 0; block < num_blocks; block++)
+		{
+			encrypt_block(key_expanded, num_rounds, counter, key_stream);
+			increment_counter(counter, increment_32bit);
+			for (int cnt = 0; cnt < aes128_block_size_bytes; cnt++)
+				output[cnt] = input[cnt] ^ key_stream[cnt];
+			input += aes128_block_size_bytes;
+			output += aes128_block_size_bytes;
+		}
+		memset(key_stream, 0, sizeof(key_stream));
+	}
+
+	void AES_Impl::increment_counter(unsigned char counter[16], bool increment_32bit)
+	{
+		int last = increment_32bit ? 12 : 0;
+		for (int cnt = 15; cnt >= last; cnt--)
+		{
+			if (++counter[cnt] != 0)
+				break;
+		}
+	}
+
+	void AES_Impl::set_hardware_round_keys(const uint32_t *key_expanded, int num_rounds)
+	{
+		if (use_hardware)
+		{
+			for (int cnt = 0; cnt < (num_rounds + 1) * 4; cnt++)
+				put_word(key_expanded[cnt], hardware_round_keys + cnt * 4);
+		}
+	}
+
+	void AES_Impl::encrypt_block_hardware(int num_rounds, unsigned char block[16]) const
+	{
+		AES_NI::encrypt_block(hardware_round_keys, num_rounds, block);
+	}
+
+	void AES_Impl::decrypt_block_hardware(int num_rounds, unsigned char block[16]) const
+	{
+		AES_NI::decrypt_block(hardware_round_keys, num_rounds, block);
+	}
+
 	void AES_Impl::extract_decrypt_key(uint32_t *key_expanded, int num_rounds)
 	{
 		// Invert the order of the round keys
@@ -77,6 +77,32 @@ namespace clan
 		void extract_decrypt_key(uint32_t *key_expanded, int num_rounds);
 		void store_block(uint32_t s0, uint32_t s1, uint32_t s2, uint32_t s3, DataBuffer &databuffer);
 
+		/// \brief Expands a 16, 24 or 32 byte cipher key and returns the number of rounds
+		int extract_encrypt_key(const unsigned char *key, int key_size, uint32_t key_expanded[aes256_nb_mult_nr_plus1]);
+
+		/// \brief Encrypts a single block using the lookup tables
+		///
+		/// The table lookups depend on the data and the key, so this is not constant-time. The AES-NI path is.
+		void encrypt_block(const uint32_t *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const;
+
+		/// \brief Counter mode: XORs input with the encrypted counter blocks and advances the counter
+		///
+		/// The counter is a 128 bit big endian number, or only the last 32 bits of it when increment_32bit is set (as used by GCM)
+		void ctr_blocks(const uint32_t *key_expanded, int num_rounds, unsigned char counter[16], bool increment_32bit, const unsigned char *input, unsigned char *output, int num_blocks) const;
+
+		static void increment_counter(unsigned char counter[16], bool increment_32bit);
+
+		/// \brief Copies the expanded key into hardware_round_keys
+		void set_hardware_round_keys(const uint32_t *key_expanded, int num_rounds);
+
+		/// \brief Encrypts or decrypts a block in place using hardware_round_keys
+		void encrypt_block_hardware(int num_rounds, unsigned char block[16]) const;
+		void decrypt_block_hardware(int num_rounds, unsigned char block[16]) const;
+
+		/// \brief True when the CPU supports AES-NI, in which case the hardware round keys are used instead of the tables
+		bool use_hardware;
+		unsigned char hardware_round_keys[(aes256_num_rounds_nr + 1) * 16];
+
 		inline uint32_t get_word(const unsigned char *data) const
 		{
 			return ((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | (data[3]));
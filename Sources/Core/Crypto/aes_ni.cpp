@@ -0,0 +1,298 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/system.h"
+#include "aes_ni.h"
+#include "target_attribute.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#define CL_AES_NI_TARGET CL_TARGET("aes,pclmul,ssse3")
+#endif
+
+namespace clan
+{
+#if defined(__SSE2__)
+
+	namespace
+	{
+		CL_AES_NI_TARGET inline __m128i byte_swap(__m128i value)
+		{
+			return _mm_shuffle_epi8(value, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+		}
+
+		// Carry-less multiplication of two byte reflected values, accumulating the 256 bit product in low and high
+		CL_AES_NI_TARGET inline void clmul_add(__m128i a, __m128i b, __m128i &low, __m128i &high)
+		{
+			__m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+			__m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+			__m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+			__m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+			t1 = _mm_xor_si128(t1, t2);
+			low = _mm_xor_si128(low, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+			high = _mm_xor_si128(high, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+		}
+
+		// Reduces a 256 bit product modulo x^128 + x^7 + x^2 + x + 1 (Intel carry-less multiplication white paper, algorithm 5)
+		CL_AES_NI_TARGET inline __m128i ghash_reduce(__m128i low, __m128i high)
+		{
+			// The operands are bit reflected, so the product must be shifted left by one
+			__m128i carry_low = _mm_srli_epi32(low, 31);
+			__m128i carry_high = _mm_srli_epi32(high, 31);
+			low = _mm_slli_epi32(low, 1);
+			high = _mm_slli_epi32(high, 1);
+			__m128i carry_middle = _mm_srli_si128(carry_low, 12);
+			carry_high = _mm_slli_si128(carry_high, 4);
+			carry_low = _mm_slli_si128(carry_low, 4);
+			low = _mm_or_si128(low, carry_low);
+			high = _mm_or_si128(high, carry_high);
+			high = _mm_or_si128(high, carry_middle);
+
+			__m128i a = _mm_slli_epi32(low, 31);
+			__m128i b = _mm_slli_epi32(low, 30);
+			__m128i c = _mm_slli_epi32(low, 25);
+			a = _mm_xor_si128(a, b);
+			a = _mm_xor_si128(a, c);
+			__m128i d = _mm_srli_si128(a, 4);
+			a = _mm_slli_si128(a, 12);
+			low = _mm_xor_si128(low, a);
+
+			__m128i e = _mm_srli_epi32(low, 1);
+			b = _mm_srli_epi32(low, 2);
+			c = _mm_srli_epi32(low, 7);
+			e = _mm_xor_si128(e, b);
+			e = _mm_xor_si128(e, c);
+			e = _mm_xor_si128(e, d);
+			low = _mm_xor_si128(low, e);
+			return _mm_xor_si128(high, low);
+		}
+
+		CL_AES_NI_TARGET inline __m128i ghash_multiply(__m128i a, __m128i b)
+		{
+			__m128i low = _mm_setzero_si128();
+			__m128i high = _mm_setzero_si128();
+			clmul_add(a, b, low, high);
+			return ghash_reduce(low, high);
+		}
+	}
+
+	bool AES_NI::is_supported()
+	{
+		static bool supported = System::detect_cpu_extension(System::aes) && System::detect_cpu_extension(System::ssse3);
+		return supported;
+	}
+
+	bool AES_NI::is_ghash_supported()
+	{
+		static bool supported = is_supported() && System::detect_cpu_extension(System::pclmulqdq);
+		return supported;
+	}
+
+	CL_AES_NI_TARGET void AES_NI::encrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16])
+	{
+		const __m128i *keys = reinterpret_cast<const __m128i*>(round_keys);
+		__m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)block), _mm_loadu_si128(keys));
+		for (int round = 1; round < num_rounds; round++)
+			value = _mm_aesenc_si128(value, _mm_loadu_si128(keys + round));
+		value = _mm_aesenclast_si128(value, _mm_loadu_si128(keys + num_rounds));
+		_mm_storeu_si128((__m128i*)block, value);
+	}
+
+	CL_AES_NI_TARGET void AES_NI::decrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16])
+	{
+		const __m128i *keys = reinterpret_cast<const __m128i*>(round_keys);
+		__m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)block), _mm_loadu_si128(keys));
+		for (int round = 1; round < num_rounds; round++)
+			value = _mm_aesdec_si128(value, _mm_loadu_si128(keys + round));
+		value = _mm_aesdeclast_si128(value, _mm_loadu_si128(keys + num_rounds));
+		_mm_storeu_si128((__m128i*)block, value);
+	}
+
+	CL_AES_NI_TARGET void AES_NI::ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], bool increment_32bit, const unsigned char *input, unsigned char *output, int num_blocks)
+	{
+		__m128i keys[15];
+		for (int round = 0; round <= num_rounds; round++)
+			keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys) + round);
+
+		// Keep the counter as two native integers and byte swap it into each block
+		uint64_t counter_high = 0;
+		uint64_t counter_low = 0;
+		for (int cnt = 0; cnt < 8; cnt++)
+		{
+			counter_high = (counter_high << 8) | counter[cnt];
+			counter_low = (counter_low << 8) | counter[cnt + 8];
+		}
+
+		const int parallel_blocks = 8;
+		__m128i blocks[parallel_blocks];
+		while (num_blocks > 0)
+		{
+			int count = num_blocks < parallel_blocks ? num_blocks : parallel_blocks;
+
+			// Encrypting eight independent blocks at a time hides the latency of the AES instructions
+			for (int cnt = 0; cnt < count; cnt++)
+			{
+				blocks[cnt] = _mm_xor_si128(byte_swap(_mm_set_epi64x((long long)counter_high, (long long)counter_low)), keys[0]);
+				if (increment_32bit)
+				{
+					counter_low = (counter_low & 0xffffffff00000000ULL) | (uint32_t)(counter_low + 1);
+				}
+				else if (++counter_low == 0)
+				{
+					counter_high++;
+				}
+			}
+
+			if (count == parallel_blocks)
+			{
+				for (int round = 1; round < num_rounds; round++)
+				{
+					blocks[0] = _mm_aesenc_si128(blocks[0], keys[round]);
+					blocks[1] = _mm_aesenc_si128(blocks[1], keys[round]);
+					blocks[2] = _mm_aesenc_si128(blocks[2], keys[round]);
+					blocks[3] = _mm_aesenc_si128(blocks[3], keys[round]);
+					blocks[4] = _mm_aesenc_si128(blocks[4], keys[round]);
+					blocks[5] = _mm_aesenc_si128(blocks[5], keys[round]);
+					blocks[6] = _mm_aesenc_si128(blocks[6], keys[round]);
+					blocks[7] = _mm_aesenc_si128(blocks[7], keys[round]);
+				}
+			}
+			else
+			{
+				for (int round = 1; round < num_rounds; round++)
+				{
+					for (int cnt = 0; cnt < count; cnt++)
+						blocks[cnt] = _mm_aesenc_si128(blocks[cnt], keys[round]);
+				}
+			}
+
+			for (int cnt = 0; cnt < count; cnt++)
+			{
+				__m128i key_stream = _mm_aesenclast_si128(blocks[cnt], keys[num_rounds]);
+				__m128i data = _mm_loadu_si128((const __m128i*)input + cnt);
+				_mm_storeu_si128((__m128i*)output + cnt, _mm_xor_si128(data, key_stream));
+			}
+
+			input += count * 16;
+			output += count * 16;
+			num_blocks -= count;
+		}
+
+		for (int cnt = 7; cnt >= 0; cnt--)
+		{
+			counter[cnt] = (unsigned char)counter_high;
+			counter[cnt + 8] = (unsigned char)counter_low;
+			counter_high >>= 8;
+			counter_low >>= 8;
+		}
+	}
+
+	CL_AES_NI_TARGET void AES_NI::ghash_init(const unsigned char hash_key[16], unsigned char out_powers[64])
+	{
+		__m128i h1 = byte_swap(_mm_loadu_si128((const __m128i*)hash_key));
+		__m128i h2 = ghash_multiply(h1, h1);
+		__m128i h3 = ghash_multiply(h2, h1);
+		__m128i h4 = ghash_multiply(h3, h1);
+		_mm_storeu_si128((__m128i*)out_powers, h1);
+		_mm_storeu_si128((__m128i*)out_powers + 1, h2);
+		_mm_storeu_si128((__m128i*)out_powers + 2, h3);
+		_mm_storeu_si128((__m128i*)out_powers + 3, h4);
+	}
+
+	CL_AES_NI_TARGET void AES_NI::ghash(const unsigned char powers[64], unsigned char state[16], const unsigned char *data, int num_blocks)
+	{
+		__m128i h1 = _mm_loadu_si128((const __m128i*)powers);
+		__m128i h2 = _mm_loadu_si128((const __m128i*)powers + 1);
+		__m128i h3 = _mm_loadu_si128((const __m128i*)powers + 2);
+		__m128i h4 = _mm_loadu_si128((const __m128i*)powers + 3);
+		__m128i x = byte_swap(_mm_loadu_si128((const __m128i*)state));
+
+		// Four blocks at a time with a single reduction: X' = (X + D0)H^4 + D1 H^3 + D2 H^2 + D3 H
+		while (num_blocks >= 4)
+		{
+			const __m128i *blocks = (const __m128i*)data;
+			__m128i low = _mm_setzero_si128();
+			__m128i high = _mm_setzero_si128();
+			clmul_add(_mm_xor_si128(x, byte_swap(_mm_loadu_si128(blocks))), h4, low, high);
+			clmul_add(byte_swap(_mm_loadu_si128(blocks + 1)), h3, low, high);
+			clmul_add(byte_swap(_mm_loadu_si128(blocks + 2)), h2, low, high);
+			clmul_add(byte_swap(_mm_loadu_si128(blocks + 3)), h1, low, high);
+			x = ghash_reduce(low, high);
+			data += 64;
+			num_blocks -= 4;
+		}
+
+		while (num_blocks > 0)
+		{
+			x = ghash_multiply(_mm_xor_si128(x, byte_swap(_mm_loadu_si128((const __m128i*)data))), h1);
+			data += 16;
+			num_blocks--;
+		}
+
+		_mm_storeu_si128((__m128i*)state, byte_swap(x));
+	}
+
+#else
+
+	bool AES_NI::is_supported()
+	{
+		return false;
+	}
+
+	bool AES_NI::is_ghash_supported()
+	{
+		return false;
+	}
+
+	void AES_NI::encrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16])
+	{
+	}
+
+	void AES_NI::decrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16])
+	{
+	}
+
+	void AES_NI::ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], bool increment_32bit, const unsigned char *input, unsigned char *output, int num_blocks)
+	{
+	}
+
+	void AES_NI::ghash_init(const unsigned char hash_key[16], unsigned char out_powers[64])
+	{
+	}
+
+	void AES_NI::ghash(const unsigned char powers[64], unsigned char state[16], const unsigned char *data, int num_blocks)
+	{
+	}
+
+#endif
+}
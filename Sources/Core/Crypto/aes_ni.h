@@ -0,0 +1,62 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+namespace clan
+{
+	/// \brief AES-NI and PCLMULQDQ versions of the AES and GHASH inner loops
+	///
+	/// Round keys are the AES_Impl expanded key words stored as big endian bytes, (num_rounds + 1) * 16 bytes in total.
+	/// Decryption expects the equivalent inverse cipher key schedule produced by AES_Impl::extract_decrypt_key.
+	/// The functions must only be called when is_supported() (and is_ghash_supported() for GHASH) returns true.
+	class AES_NI
+	{
+	public:
+		/// \brief True if the CPU supports the AES instructions (and SSSE3 used for byte swapping)
+		static bool is_supported();
+
+		/// \brief True if the CPU also supports carry-less multiplication
+		static bool is_ghash_supported();
+
+		static void encrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16]);
+		static void decrypt_block(const unsigned char *round_keys, int num_rounds, unsigned char block[16]);
+
+		/// \brief Counter mode, see AES_Impl::ctr_blocks
+		static void ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], bool increment_32bit, const unsigned char *input, unsigned char *output, int num_blocks);
+
+		/// \brief Calculates the powers of the hash key used by ghash()
+		///
+		/// \param hash_key = H, the encrypted zero block
+		/// \param out_powers = H, H^2, H^3 and H^4 in the byte reflected form used by the multiplication
+		static void ghash_init(const unsigned char hash_key[16], unsigned char out_powers[64]);
+
+		/// \brief Folds whole blocks into the GHASH state (stored in GCM byte order)
+		static void ghash(const unsigned char powers[64], unsigned char state[16], const unsigned char *data, int num_blocks);
+	};
+}
@@ -208,6 +208,36 @@ namespace clan
 		cipher->exptmod(d, modulus, msg);
 	}
 
+	void RSA_Impl::rsadp_crt(BigInt *cipher, const RSAPrivateKey &key, BigInt *msg)
+	{
+		// Insure that ciphertext representative is in range of modulus
+		if ((cipher->cmp_z() < 0) || (cipher->cmp(&key.modulus) >= 0))
+		{
+			throw Exception("ciphertext is out of range of modulus");
+		}
+
+		// m1 = c^dP mod p, m2 = c^dQ mod q
+		BigInt m1, m2;
+		cipher->exptmod(&key.exponent1, &key.prime1, &m1);
+		cipher->exptmod(&key.exponent2, &key.prime2, &m2);
+
+		// h = qInv * (m1 - m2) mod p
+		BigInt h = m1 - m2;
+		h.mod(&key.prime1, &h);
+		h = h * key.coefficient;
+		h.mod(&key.prime1, &h);
+
+		// m = m2 + h * q
+		*msg = m2 + h * key.prime2;
+	}
+
+	Secret RSA_Impl::to_secret(const BigInt &value)
+	{
+		Secret secret(value.unsigned_octet_size());
+		value.to_unsigned_octets(secret.get_data(), secret.get_size());
+		return secret;
+	}
+
 	void RSA_Impl::pkcs1v15_encode(int block_type, Random &random, const char *msg, int mlen, char *emsg, int emlen)
 	{
 		if (mlen > emlen - 11)
@@ -320,6 +350,24 @@ namespace clan
 		return pkcs1v15_decode((char *)key_buffer.get_data(), k);
 	}
 
+	Secret RSA_Impl::pkcs1v15_decrypt_crt(const char *msg, int mlen, const RSAPrivateKey &key)
+	{
+		int k = key.modulus.unsigned_octet_size();		// size of modulus, in bytes
+		if (mlen != k)
+			throw Exception("Invalid message length");
+
+		// Convert ciphertext to integer representative
+		BigInt mrep;
+		mrep.read_unsigned_octets((const unsigned char *)msg, mlen);
+
+		// Decrypt ...
+		rsadp_crt(&mrep, key, &mrep);
+
+		Secret key_buffer(k);
+		mrep.to_unsigned_octets(key_buffer.get_data(), k);
+		return pkcs1v15_decode((char *)key_buffer.get_data(), k);
+	}
+
 	DataBuffer RSA_Impl::encrypt(int block_type, Random &random, const void *in_public_exponent, unsigned int in_public_exponent_size, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size)
 	{
 		BigInt exponent;
@@ -342,6 +390,19 @@ namespace clan
 		return pkcs1v15_decrypt((const char *)in_data, in_data_size, &exponent, &modulus);
 	}
 
+	Secret RSA_Impl::decrypt_crt(const Secret &in_prime1, const Secret &in_prime2, const Secret &in_exponent1, const Secret &in_exponent2, const Secret &in_coefficient, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size)
+	{
+		RSAPrivateKey key;
+		key.prime1.read_unsigned_octets(in_prime1.get_data(), in_prime1.get_size());
+		key.prime2.read_unsigned_octets(in_prime2.get_data(), in_prime2.get_size());
+		key.exponent1.read_unsigned_octets(in_exponent1.get_data(), in_exponent1.get_size());
+		key.exponent2.read_unsigned_octets(in_exponent2.get_data(), in_exponent2.get_size());
+		key.coefficient.read_unsigned_octets(in_coefficient.get_data(), in_coefficient.get_size());
+		key.modulus.read_unsigned_octets((const unsigned char *)in_modulus, in_modulus_size);
+
+		return pkcs1v15_decrypt_crt((const char *)in_data, in_data_size, key);
+	}
+
 	void RSA_Impl::create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value)
 	{
 		create(random, key_size_in_bits, public_exponent_value);
@@ -354,4 +415,13 @@ namespace clan
 		out_modulus = DataBuffer(rsa_private_key.modulus.unsigned_octet_size());
 		rsa_private_key.modulus.to_unsigned_octets((unsigned char *)out_modulus.get_data(), out_modulus.get_size());
 	}
+
+	void RSA_Impl::get_crt_values(Secret &out_prime1, Secret &out_prime2, Secret &out_exponent1, Secret &out_exponent2, Secret &out_coefficient) const
+	{
+		out_prime1 = to_secret(rsa_private_key.prime1);
+		out_prime2 = to_secret(rsa_private_key.prime2);
+		out_exponent1 = to_secret(rsa_private_key.exponent1);
+		out_exponent2 = to_secret(rsa_private_key.exponent2);
+		out_coefficient = to_secret(rsa_private_key.coefficient);
+	}
 }
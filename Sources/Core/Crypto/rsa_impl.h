@@ -77,6 +77,7 @@ namespace clan
 
 		static DataBuffer encrypt(int block_type, Random &random, const void *in_public_exponent, unsigned int in_public_exponent_size, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
 		static Secret decrypt(const Secret &in_private_exponent, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+		static Secret decrypt_crt(const Secret &in_prime1, const Secret &in_prime2, const Secret &in_exponent1, const Secret &in_exponent2, const Secret &in_coefficient, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
 
 		/// \brief Create the keypair
 		void create(Random &random, int key_size_in_bits, int public_exponent_value);
@@ -91,12 +92,18 @@ namespace clan
 		/// \param public_exponent_value = public exponent value
 		void create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value);
 
+		/// \brief Get the values for decrypting using the Chinese remainder theorem, after create_keypair()
+		void get_crt_values(Secret &out_prime1, Secret &out_prime2, Secret &out_exponent1, Secret &out_exponent2, Secret &out_coefficient) const;
+
 	private:
 		void generate_prime(Random &random, BigInt &prime, int prime_len);
 		bool build_from_primes(BigInt *p, BigInt *q, BigInt *e, BigInt *d, unsigned int key_size_in_bits);
 
 		static void rsaep(BigInt *msg, const BigInt *e, const BigInt *modulus, BigInt *cipher);
 		static void rsadp(BigInt *cipher, const BigInt *d, const BigInt *modulus, BigInt *msg);
+		static void rsadp_crt(BigInt *cipher, const RSAPrivateKey &key, BigInt *msg);
+
+		static Secret to_secret(const BigInt &value);
 
 		// PKCS#1 v.1.5 message padding and encoding
 		// msg       - input message
@@ -125,6 +132,12 @@ namespace clan
 		// modulus   - decryption key modulus
 		static Secret pkcs1v15_decrypt(const char *msg, int mlen, const BigInt *d, const BigInt *modulus);
 
+		// Decrypt a message using RSA with the Chinese remainder theorem and PKCS#1 v.1.5 padding
+		// msg       - input message (ciphertext)
+		// mlen      - length of input message, in bytes
+		// key       - modulus, primes, exponents and coefficient of the private key
+		static Secret pkcs1v15_decrypt_crt(const char *msg, int mlen, const RSAPrivateKey &key);
+
 		RSAPrivateKey rsa_private_key;
 	};
 }
@@ -72,4 +72,9 @@ namespace clan
 	{
 		impl->calculate();
 	}
+
+	void SHA1::hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue)
+	{
+		SHA1_Impl::hash_many(count, data, sizes, out_hashes, work_queue);
+	}
 }
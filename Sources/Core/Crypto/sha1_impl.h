@@ -32,6 +32,8 @@
 
 namespace clan
 {
+	class WorkQueue;
+
 	class SHA1_Impl : private SHA
 	{
 	public:
@@ -45,8 +47,12 @@ namespace clan
 		void add(const void *data, int size);
 		void calculate();
 
+		static void hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue);
+
 	private:
-		void process_chunk();
+		static void hash_batch(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+		void process_blocks(const unsigned char *data, int num_blocks);
+		void process_block(const unsigned char *block);
 
 		inline unsigned int leftrotate_uint32(unsigned int value, int shift) const
 		{
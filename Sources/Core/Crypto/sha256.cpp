@@ -68,6 +68,11 @@ namespace clan
 		impl->calculate();
 	}
 
+	void SHA256::hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue)
+	{
+		SHA256_Impl::hash_many(count, data, sizes, out_hashes, work_queue);
+	}
+
 	void SHA256::set_hmac(const void *key_data, int key_size)
 	{
 		impl->set_hmac(key_data, key_size);
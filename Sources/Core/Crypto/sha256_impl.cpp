@@ -28,6 +28,9 @@
 
 #include "Core/precomp.h"
 #include "sha256_impl.h"
+#include "sha_ni.h"
+#include "sha_multi_buffer.h"
+#include "API/Core/System/work_queue.h"
 #include "API/Core/Math/cl_math.h"
 #include "API/Core/Crypto/sha224.h"
 #include "API/Core/Crypto/sha256.h"
@@ -159,6 +162,15 @@ namespace clan
 		int pos = 0;
 		while (pos < size)
 		{
+			// Whole blocks are hashed directly from the input without copying them to the chunk
+			if (chunk_filled == 0 && size - pos >= block_size)
+			{
+				int num_blocks = (size - pos) / block_size;
+				process_blocks(data + pos, num_blocks);
+				pos += num_blocks * block_size;
+				continue;
+			}
+
 			int data_left = size - pos;
 			int buffer_space = block_size - chunk_filled;
 			int data_used = min(buffer_space, data_left);
@@ -167,7 +179,7 @@ namespace clan
 			pos += data_used;
 			if (chunk_filled == block_size)
 			{
-				process_chunk();
+				process_blocks(chunk, 1);
 				chunk_filled = 0;
 			}
 		}
@@ -286,7 +298,70 @@ namespace clan
 		}
 	}
 
-	void SHA256_Impl::process_chunk()
+	void SHA256_Impl::hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue)
+	{
+		if (work_queue && count > 1)
+		{
+			// A few batches per worker evens out buffers of different sizes
+			int num_batches = min(count, work_queue->get_num_workers() * 4);
+			WorkGroup group(*work_queue);
+			group.parallel_for(0, num_batches, [=](int batch)
+			{
+				int first = (int)((int64_t)count * batch / num_batches);
+				int last = (int)((int64_t)count * (batch + 1) / num_batches);
+				hash_batch(last - first, data + first, sizes + first, out_hashes + first * 32);
+			});
+			group.wait();
+		}
+		else
+		{
+			hash_batch(count, data, sizes, out_hashes);
+		}
+	}
+
+	void SHA256_Impl::hash_batch(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+	{
+		// The SHA extensions beat eight AVX2 lanes, so the lanes are only used without them
+		if (!SHA_NI::is_supported() && SHA_MultiBuffer::is_supported())
+		{
+			SHA_MultiBuffer::sha256_hash_many(count, data, sizes, out_hashes);
+		}
+		else
+		{
+			SHA256_Impl hash(cl_sha_256);
+			for (int i = 0; i < count; i++)
+			{
+				hash.reset();
+				hash.add(data[i], sizes[i]);
+				hash.calculate();
+				hash.get_hash(out_hashes + i * 32);
+			}
+		}
+	}
+
+	void SHA256_Impl::process_blocks(const unsigned char *data, int num_blocks)
+	{
+		if (SHA_NI::is_supported())
+		{
+			uint32_t state[8] = { h0, h1, h2, h3, h4, h5, h6, h7 };
+			SHA_NI::sha256_blocks(state, data, num_blocks);
+			h0 = state[0];
+			h1 = state[1];
+			h2 = state[2];
+			h3 = state[3];
+			h4 = state[4];
+			h5 = state[5];
+			h6 = state[6];
+			h7 = state[7];
+		}
+		else
+		{
+			for (int block = 0; block < num_blocks; block++)
+				process_block(data + block * block_size);
+		}
+	}
+
+	void SHA256_Impl::process_block(const unsigned char *block)
 	{
 		// Constants defined in FIPS 180-3, section 4.2.2
 		static const uint32_t constant_K[64] = {
@@ -310,10 +385,10 @@ namespace clan
 
 		for (i = 0; i < 16; i++)
 		{
-			unsigned int b1 = chunk[i * 4];
-			unsigned int b2 = chunk[i * 4 + 1];
-			unsigned int b3 = chunk[i * 4 + 2];
-			unsigned int b4 = chunk[i * 4 + 3];
+			unsigned int b1 = block[i * 4];
+			unsigned int b2 = block[i * 4 + 1];
+			unsigned int b3 = block[i * 4 + 2];
+			unsigned int b4 = block[i * 4 + 3];
 			w[i] = (b1 << 24) + (b2 << 16) + (b3 << 8) + b4;
 		}
 
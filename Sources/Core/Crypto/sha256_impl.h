@@ -32,6 +32,8 @@
 
 namespace clan
 {
+	class WorkQueue;
+
 	class SHA256_Impl : private SHA
 	{
 	public:
@@ -45,6 +47,8 @@ namespace clan
 		void add(const void *data, int size);
 		void calculate();
 
+		static void hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes, WorkQueue *work_queue);
+
 	private:
 		inline uint32_t sigma_rr2_rr13_rr22(uint32_t value) const
 		{
@@ -76,7 +80,9 @@ namespace clan
 			return  (((x)& ((y) | (z))) | ((y)& (z)));
 		}
 
-		void process_chunk();
+		static void hash_batch(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+		void process_blocks(const unsigned char *data, int num_blocks);
+		void process_block(const unsigned char *block);
 
 		uint32_t h0, h1, h2, h3, h4, h5, h6, h7;
 		const static int block_size = 64;
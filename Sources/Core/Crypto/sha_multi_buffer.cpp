@@ -0,0 +1,357 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/system.h"
+#include "sha_multi_buffer.h"
+#include "target_attribute.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+
+#define CL_SHA_AVX2_TARGET CL_TARGET("avx2")
+#endif
+
+namespace clan
+{
+#if defined(__SSE2__)
+
+	namespace
+	{
+		const int lanes = SHA_MultiBuffer::lanes;
+
+		// Message words are stored transposed, word t of all lanes in one vector
+		CL_SHA_AVX2_TARGET inline __m256i load_word(const unsigned char * const blocks[lanes], int t)
+		{
+			uint32_t words[lanes];
+			for (int lane = 0; lane < lanes; lane++)
+				memcpy(&words[lane], blocks[lane] + t * 4, 4);
+			__m256i value = _mm256_loadu_si256((const __m256i*)words);
+			const __m256i byte_swap = _mm256_set_epi8(
+				12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+				12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+			return _mm256_shuffle_epi8(value, byte_swap);
+		}
+
+		CL_SHA_AVX2_TARGET inline __m256i rotate_left(__m256i value, int shift)
+		{
+			return _mm256_or_si256(_mm256_slli_epi32(value, shift), _mm256_srli_epi32(value, 32 - shift));
+		}
+
+		CL_SHA_AVX2_TARGET inline __m256i rotate_right(__m256i value, int shift)
+		{
+			return _mm256_or_si256(_mm256_srli_epi32(value, shift), _mm256_slli_epi32(value, 32 - shift));
+		}
+
+		struct SHA1_Lanes
+		{
+			static const int state_words = 5;
+			static const int hash_size = 20;
+
+			static void init(uint32_t state[state_words][lanes], int lane)
+			{
+				state[0][lane] = 0x67452301;
+				state[1][lane] = 0xEFCDAB89;
+				state[2][lane] = 0x98BADCFE;
+				state[3][lane] = 0x10325476;
+				state[4][lane] = 0xC3D2E1F0;
+			}
+
+			CL_SHA_AVX2_TARGET static void process_block(uint32_t state[state_words][lanes], const unsigned char * const blocks[lanes])
+			{
+				__m256i w[16];
+				for (int t = 0; t < 16; t++)
+					w[t] = load_word(blocks, t);
+
+				__m256i a = _mm256_loadu_si256((const __m256i*)state[0]);
+				__m256i b = _mm256_loadu_si256((const __m256i*)state[1]);
+				__m256i c = _mm256_loadu_si256((const __m256i*)state[2]);
+				__m256i d = _mm256_loadu_si256((const __m256i*)state[3]);
+				__m256i e = _mm256_loadu_si256((const __m256i*)state[4]);
+
+				for (int t = 0; t < 80; t++)
+				{
+					if (t >= 16)
+						w[t & 15] = rotate_left(_mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]), _mm256_xor_si256(w[(t - 14) & 15], w[t & 15])), 1);
+
+					__m256i f, k;
+					if (t < 20)
+					{
+						f = _mm256_xor_si256(_mm256_and_si256(b, _mm256_xor_si256(c, d)), d);
+						k = _mm256_set1_epi32(0x5A827999);
+					}
+					else if (t < 40)
+					{
+						f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+						k = _mm256_set1_epi32(0x6ED9EBA1);
+					}
+					else if (t < 60)
+					{
+						f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+						k = _mm256_set1_epi32((int)0x8F1BBCDC);
+					}
+					else
+					{
+						f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+						k = _mm256_set1_epi32((int)0xCA62C1D6);
+					}
+
+					__m256i temp = _mm256_add_epi32(_mm256_add_epi32(rotate_left(a, 5), f), _mm256_add_epi32(_mm256_add_epi32(e, k), w[t & 15]));
+					e = d;
+					d = c;
+					c = rotate_left(b, 30);
+					b = a;
+					a = temp;
+				}
+
+				_mm256_storeu_si256((__m256i*)state[0], _mm256_add_epi32(a, _mm256_loadu_si256((const __m256i*)state[0])));
+				_mm256_storeu_si256((__m256i*)state[1], _mm256_add_epi32(b, _mm256_loadu_si256((const __m256i*)state[1])));
+				_mm256_storeu_si256((__m256i*)state[2], _mm256_add_epi32(c, _mm256_loadu_si256((const __m256i*)state[2])));
+				_mm256_storeu_si256((__m256i*)state[3], _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i*)state[3])));
+				_mm256_storeu_si256((__m256i*)state[4], _mm256_add_epi32(e, _mm256_loadu_si256((const __m256i*)state[4])));
+			}
+		};
+
+		struct SHA256_Lanes
+		{
+			static const int state_words = 8;
+			static const int hash_size = 32;
+
+			static void init(uint32_t state[state_words][lanes], int lane)
+			{
+				state[0][lane] = 0x6a09e667;
+				state[1][lane] = 0xbb67ae85;
+				state[2][lane] = 0x3c6ef372;
+				state[3][lane] = 0xa54ff53a;
+				state[4][lane] = 0x510e527f;
+				state[5][lane] = 0x9b05688c;
+				state[6][lane] = 0x1f83d9ab;
+				state[7][lane] = 0x5be0cd19;
+			}
+
+			CL_SHA_AVX2_TARGET static void process_block(uint32_t state[state_words][lanes], const unsigned char * const blocks[lanes])
+			{
+				// Constants defined in FIPS 180-3, section 4.2.2
+				static const uint32_t constant_K[64] = {
+					0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+					0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+					0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+					0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+					0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+					0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+					0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+					0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+				};
+
+				__m256i w[16];
+				for (int t = 0; t < 16; t++)
+					w[t] = load_word(blocks, t);
+
+				__m256i a = _mm256_loadu_si256((const __m256i*)state[0]);
+				__m256i b = _mm256_loadu_si256((const __m256i*)state[1]);
+				__m256i c = _mm256_loadu_si256((const __m256i*)state[2]);
+				__m256i d = _mm256_loadu_si256((const __m256i*)state[3]);
+				__m256i e = _mm256_loadu_si256((const __m256i*)state[4]);
+				__m256i f = _mm256_loadu_si256((const __m256i*)state[5]);
+				__m256i g = _mm256_loadu_si256((const __m256i*)state[6]);
+				__m256i h = _mm256_loadu_si256((const __m256i*)state[7]);
+
+				for (int t = 0; t < 64; t++)
+				{
+					if (t >= 16)
+					{
+						__m256i w2 = w[(t - 2) & 15];
+						__m256i w15 = w[(t - 15) & 15];
+						__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotate_right(w2, 17), rotate_right(w2, 19)), _mm256_srli_epi32(w2, 10));
+						__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotate_right(w15, 7), rotate_right(w15, 18)), _mm256_srli_epi32(w15, 3));
+						w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(s1, w[(t - 7) & 15]), _mm256_add_epi32(s0, w[t & 15]));
+					}
+
+					__m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(rotate_right(e, 6), rotate_right(e, 11)), rotate_right(e, 25));
+					__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, _mm256_xor_si256(f, g)), g);
+					__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sum1), _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32((int)constant_K[t]), w[t & 15])));
+					__m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(rotate_right(a, 2), rotate_right(a, 13)), rotate_right(a, 22));
+					__m256i maj = _mm256_or_si256(_mm256_and_si256(a, _mm256_or_si256(b, c)), _mm256_and_si256(b, c));
+					__m256i t2 = _mm256_add_epi32(sum0, maj);
+					h = g;
+					g = f;
+					f = e;
+					e = _mm256_add_epi32(d, t1);
+					d = c;
+					c = b;
+					b = a;
+					a = _mm256_add_epi32(t1, t2);
+				}
+
+				_mm256_storeu_si256((__m256i*)state[0], _mm256_add_epi32(a, _mm256_loadu_si256((const __m256i*)state[0])));
+				_mm256_storeu_si256((__m256i*)state[1], _mm256_add_epi32(b, _mm256_loadu_si256((const __m256i*)state[1])));
+				_mm256_storeu_si256((__m256i*)state[2], _mm256_add_epi32(c, _mm256_loadu_si256((const __m256i*)state[2])));
+				_mm256_storeu_si256((__m256i*)state[3], _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i*)state[3])));
+				_mm256_storeu_si256((__m256i*)state[4], _mm256_add_epi32(e, _mm256_loadu_si256((const __m256i*)state[4])));
+				_mm256_storeu_si256((__m256i*)state[5], _mm256_add_epi32(f, _mm256_loadu_si256((const __m256i*)state[5])));
+				_mm256_storeu_si256((__m256i*)state[6], _mm256_add_epi32(g, _mm256_loadu_si256((const __m256i*)state[6])));
+				_mm256_storeu_si256((__m256i*)state[7], _mm256_add_epi32(h, _mm256_loadu_si256((const __m256i*)state[7])));
+			}
+		};
+
+		// A message in a lane: the whole blocks are read from the message itself, the padded end from a copy
+		struct LaneJob
+		{
+			int index;
+			const unsigned char *data;
+			int data_blocks;
+			int total_blocks;
+			int next_block;
+			unsigned char end_blocks[128];
+		};
+
+		void start_job(LaneJob &job, int index, const void *data, int size)
+		{
+			job.index = index;
+			job.data = static_cast<const unsigned char*>(data);
+			job.data_blocks = size / 64;
+			job.next_block = 0;
+
+			int remaining = size % 64;
+			int end_size = remaining + 9 <= 64 ? 64 : 128;
+			job.total_blocks = job.data_blocks + end_size / 64;
+
+			memset(job.end_blocks, 0, end_size);
+			memcpy(job.end_blocks, job.data + job.data_blocks * 64, remaining);
+			job.end_blocks[remaining] = 0x80;
+			uint64_t length_bits = (uint64_t)size * 8;
+			for (int cnt = 0; cnt < 8; cnt++)
+				job.end_blocks[end_size - 1 - cnt] = (unsigned char)(length_bits >> (cnt * 8));
+		}
+
+		template<typename Lanes>
+		void hash_many_lanes(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+		{
+			static const unsigned char idle_block[64] = { 0 };
+
+			uint32_t state[Lanes::state_words][lanes];
+			LaneJob jobs[lanes];
+			const unsigned char *blocks[lanes];
+			int next_index = 0;
+			int active = 0;
+
+			for (int lane = 0; lane < lanes; lane++)
+			{
+				Lanes::init(state, lane);
+				if (next_index < count)
+				{
+					start_job(jobs[lane], next_index, data[next_index], sizes[next_index]);
+					next_index++;
+					active++;
+				}
+				else
+				{
+					jobs[lane].index = -1;
+				}
+			}
+
+			while (active > 0)
+			{
+				for (int lane = 0; lane < lanes; lane++)
+				{
+					LaneJob &job = jobs[lane];
+					if (job.index == -1)
+						blocks[lane] = idle_block;
+					else if (job.next_block < job.data_blocks)
+						blocks[lane] = job.data + job.next_block * 64;
+					else
+						blocks[lane] = job.end_blocks + (job.next_block - job.data_blocks) * 64;
+				}
+
+				Lanes::process_block(state, blocks);
+
+				for (int lane = 0; lane < lanes; lane++)
+				{
+					LaneJob &job = jobs[lane];
+					if (job.index == -1 || ++job.next_block < job.total_blocks)
+						continue;
+
+					unsigned char *hash = out_hashes + job.index * Lanes::hash_size;
+					for (int word = 0; word < Lanes::state_words; word++)
+					{
+						uint32_t value = state[word][lane];
+						hash[word * 4] = (unsigned char)(value >> 24);
+						hash[word * 4 + 1] = (unsigned char)(value >> 16);
+						hash[word * 4 + 2] = (unsigned char)(value >> 8);
+						hash[word * 4 + 3] = (unsigned char)value;
+					}
+
+					Lanes::init(state, lane);
+					if (next_index < count)
+					{
+						start_job(job, next_index, data[next_index], sizes[next_index]);
+						next_index++;
+					}
+					else
+					{
+						job.index = -1;
+						active--;
+					}
+				}
+			}
+		}
+	}
+
+	bool SHA_MultiBuffer::is_supported()
+	{
+		static bool supported = System::detect_cpu_extension(System::avx2);
+		return supported;
+	}
+
+	void SHA_MultiBuffer::sha1_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+	{
+		hash_many_lanes<SHA1_Lanes>(count, data, sizes, out_hashes);
+	}
+
+	void SHA_MultiBuffer::sha256_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+	{
+		hash_many_lanes<SHA256_Lanes>(count, data, sizes, out_hashes);
+	}
+
+#else
+
+	bool SHA_MultiBuffer::is_supported()
+	{
+		return false;
+	}
+
+	void SHA_MultiBuffer::sha1_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+	{
+	}
+
+	void SHA_MultiBuffer::sha256_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes)
+	{
+	}
+
+#endif
+}
@@ -0,0 +1,52 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+
+namespace clan
+{
+	/// \brief Multi-buffer SHA-1 and SHA-256 using AVX2
+	///
+	/// Hashes eight independent messages at a time, one in each 32 bit lane. When a message finishes its lane
+	/// continues with the next one, so messages of different sizes keep all lanes busy.
+	/// The functions must only be called when is_supported() returns true.
+	class SHA_MultiBuffer
+	{
+	public:
+		static const int lanes = 8;
+
+		/// \brief True if the CPU and OS support AVX2
+		static bool is_supported();
+
+		/// \brief Hashes count messages into out_hashes (20 bytes per message for SHA-1, 32 for SHA-256)
+		static void sha1_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+		static void sha256_hash_many(int count, const void * const *data, const int *sizes, unsigned char *out_hashes);
+	};
+}
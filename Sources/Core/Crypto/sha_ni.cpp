@@ -0,0 +1,226 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/system.h"
+#include "sha_ni.h"
+#include "target_attribute.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+#include <immintrin.h>
+
+#define CL_SHA_NI_TARGET CL_TARGET("sha,sse4.1,ssse3")
+#endif
+
+namespace clan
+{
+#if defined(__SSE2__)
+
+	namespace
+	{
+		const uint32_t sha256_constant_K[64] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+
+		// Four SHA-1 rounds. The message words of group i are in msg[i % 4], and the schedule for the following groups
+		// is calculated on the way, so that msg[(i + 1) % 4] is ready for the next group.
+		template<int i>
+		CL_SHA_NI_TARGET inline void sha1_rounds(__m128i &abcd, __m128i &e0, __m128i &e1, __m128i msg[4], const unsigned char *data)
+		{
+			if (i < 4)
+				msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL));
+
+			if (i >= 3 && i <= 18)
+				msg[(i + 1) % 4] = _mm_sha1msg2_epu32(msg[(i + 1) % 4], msg[i % 4]);
+
+			if (i == 0)
+			{
+				e0 = _mm_add_epi32(e0, msg[0]);
+				e1 = abcd;
+				abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+			}
+			else if (i % 2 == 1)
+			{
+				e1 = _mm_sha1nexte_epu32(e1, msg[i % 4]);
+				e0 = abcd;
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, i / 5);
+			}
+			else
+			{
+				e0 = _mm_sha1nexte_epu32(e0, msg[i % 4]);
+				e1 = abcd;
+				abcd = _mm_sha1rnds4_epu32(abcd, e0, i / 5);
+			}
+
+			if (i >= 1 && i <= 16)
+				msg[(i + 3) % 4] = _mm_sha1msg1_epu32(msg[(i + 3) % 4], msg[i % 4]);
+			if (i >= 2 && i <= 17)
+				msg[(i + 2) % 4] = _mm_xor_si128(msg[(i + 2) % 4], msg[i % 4]);
+		}
+
+		// Four SHA-256 rounds, with the message schedule calculated the same way as for SHA-1
+		template<int i>
+		CL_SHA_NI_TARGET inline void sha256_rounds(__m128i &state0, __m128i &state1, __m128i msg[4], const unsigned char *data)
+		{
+			if (i < 4)
+				msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL));
+
+			__m128i words = _mm_add_epi32(msg[i % 4], _mm_loadu_si128((const __m128i*)(sha256_constant_K + i * 4)));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+
+			if (i >= 3 && i <= 14)
+			{
+				__m128i shifted = _mm_alignr_epi8(msg[i % 4], msg[(i + 3) % 4], 4);
+				msg[(i + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[(i + 1) % 4], shifted), msg[i % 4]);
+			}
+
+			words = _mm_shuffle_epi32(words, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, words);
+
+			if (i >= 1 && i <= 12)
+				msg[(i + 3) % 4] = _mm_sha256msg1_epu32(msg[(i + 3) % 4], msg[i % 4]);
+		}
+	}
+
+	bool SHA_NI::is_supported()
+	{
+		static bool supported = System::detect_cpu_extension(System::sha) && System::detect_cpu_extension(System::sse4_1) && System::detect_cpu_extension(System::ssse3);
+		return supported;
+	}
+
+	CL_SHA_NI_TARGET void SHA_NI::sha1_blocks(uint32_t state[5], const unsigned char *data, int num_blocks)
+	{
+		__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+		__m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+		__m128i e1;
+		__m128i msg[4];
+
+		for (int block = 0; block < num_blocks; block++)
+		{
+			__m128i abcd_save = abcd;
+			__m128i e0_save = e0;
+
+			sha1_rounds<0>(abcd, e0, e1, msg, data);
+			sha1_rounds<1>(abcd, e0, e1, msg, data);
+			sha1_rounds<2>(abcd, e0, e1, msg, data);
+			sha1_rounds<3>(abcd, e0, e1, msg, data);
+			sha1_rounds<4>(abcd, e0, e1, msg, data);
+			sha1_rounds<5>(abcd, e0, e1, msg, data);
+			sha1_rounds<6>(abcd, e0, e1, msg, data);
+			sha1_rounds<7>(abcd, e0, e1, msg, data);
+			sha1_rounds<8>(abcd, e0, e1, msg, data);
+			sha1_rounds<9>(abcd, e0, e1, msg, data);
+			sha1_rounds<10>(abcd, e0, e1, msg, data);
+			sha1_rounds<11>(abcd, e0, e1, msg, data);
+			sha1_rounds<12>(abcd, e0, e1, msg, data);
+			sha1_rounds<13>(abcd, e0, e1, msg, data);
+			sha1_rounds<14>(abcd, e0, e1, msg, data);
+			sha1_rounds<15>(abcd, e0, e1, msg, data);
+			sha1_rounds<16>(abcd, e0, e1, msg, data);
+			sha1_rounds<17>(abcd, e0, e1, msg, data);
+			sha1_rounds<18>(abcd, e0, e1, msg, data);
+			sha1_rounds<19>(abcd, e0, e1, msg, data);
+
+			e0 = _mm_sha1nexte_epu32(e0, e0_save);
+			abcd = _mm_add_epi32(abcd, abcd_save);
+			data += 64;
+		}
+
+		_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+		state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+	}
+
+	CL_SHA_NI_TARGET void SHA_NI::sha256_blocks(uint32_t state[8], const unsigned char *data, int num_blocks)
+	{
+		// The round instructions want the state as ABEF and CDGH
+		__m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xb1);
+		__m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1b);
+		__m128i state0 = _mm_alignr_epi8(cdab, efgh, 8);
+		__m128i state1 = _mm_blend_epi16(efgh, cdab, 0xf0);
+		__m128i msg[4];
+
+		for (int block = 0; block < num_blocks; block++)
+		{
+			__m128i abef_save = state0;
+			__m128i cdgh_save = state1;
+
+			sha256_rounds<0>(state0, state1, msg, data);
+			sha256_rounds<1>(state0, state1, msg, data);
+			sha256_rounds<2>(state0, state1, msg, data);
+			sha256_rounds<3>(state0, state1, msg, data);
+			sha256_rounds<4>(state0, state1, msg, data);
+			sha256_rounds<5>(state0, state1, msg, data);
+			sha256_rounds<6>(state0, state1, msg, data);
+			sha256_rounds<7>(state0, state1, msg, data);
+			sha256_rounds<8>(state0, state1, msg, data);
+			sha256_rounds<9>(state0, state1, msg, data);
+			sha256_rounds<10>(state0, state1, msg, data);
+			sha256_rounds<11>(state0, state1, msg, data);
+			sha256_rounds<12>(state0, state1, msg, data);
+			sha256_rounds<13>(state0, state1, msg, data);
+			sha256_rounds<14>(state0, state1, msg, data);
+			sha256_rounds<15>(state0, state1, msg, data);
+
+			state0 = _mm_add_epi32(state0, abef_save);
+			state1 = _mm_add_epi32(state1, cdgh_save);
+			data += 64;
+		}
+
+		__m128i feba = _mm_shuffle_epi32(state0, 0x1b);
+		__m128i dchg = _mm_shuffle_epi32(state1, 0xb1);
+		_mm_storeu_si128((__m128i*)state, _mm_blend_epi16(feba, dchg, 0xf0));
+		_mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+	}
+
+#else
+
+	bool SHA_NI::is_supported()
+	{
+		return false;
+	}
+
+	void SHA_NI::sha1_blocks(uint32_t state[5], const unsigned char *data, int num_blocks)
+	{
+	}
+
+	void SHA_NI::sha256_blocks(uint32_t state[8], const unsigned char *data, int num_blocks)
+	{
+	}
+
+#endif
+}
@@ -45,13 +45,20 @@ namespace clan
 {
 	TLSClient_Impl::TLSClient_Impl() :
 		recv_in_data_read_pos(0), recv_out_data_read_pos(0), send_in_data_read_pos(0), send_out_data_read_pos(0), handshake_in_read_pos(0),
-		conversation_state(cl_tls_state_send_client_hello), security_parameters(), protocol(), is_protocol_chosen()
+		conversation_state(cl_tls_state_send_client_hello), security_parameters(), protocol(), client_hello_protocol(), is_protocol_chosen()
 	{
-		// Set TLS 3.1
+		// Offer TLS 1.2 (3.3). The server may choose TLS 1.0 or 1.1 instead
 		protocol.major = 3;
-		protocol.minor = 1;
+		protocol.minor = 3;
+		client_hello_protocol = protocol;
 		is_protocol_chosen = false;
 
+		// Reserve the largest sizes the buffers can reach, so that the record pipeline does not allocate memory
+		recv_in_data.set_capacity(desired_buffer_size);
+		recv_out_data.set_capacity(desired_buffer_size * 2 + max_record_length);
+		send_in_data.set_capacity(desired_buffer_size);
+		send_out_data.set_capacity(desired_buffer_size * 2 + max_record_length);
+
 		create_security_parameters_client_random();
 	}
 
@@ -84,6 +91,28 @@ namespace clan
 		if (size == 0)
 			return 0;
 
+		// Once connected, seal records straight from the caller's buffer unless data is already queued ahead of it
+		if (conversation_state == cl_tls_state_connected && send_in_data_read_pos == (int)send_in_data.get_size())
+		{
+			int bytes_consumed = 0;
+			try
+			{
+				while (bytes_consumed < size && can_send_record())
+					bytes_consumed += send_application_record(static_cast<const char *>(data) + bytes_consumed, size - bytes_consumed);
+			}
+			catch (...)
+			{
+				conversation_state = cl_tls_state_error;
+				throw;
+			}
+
+			if (bytes_consumed > 0)
+			{
+				progress_conversation();
+				return bytes_consumed;
+			}
+		}
+
 		int insert_pos = send_in_data.get_size();
 		int buffer_space_available = desired_buffer_size - insert_pos;
 		int bytes_consumed = clan::min(size, buffer_space_available);
@@ -216,24 +245,7 @@ namespace clan
 		const char *data = send_in_data.get_data() + send_in_data_read_pos;
 		int size = send_in_data.get_size() - send_in_data_read_pos;
 
-		unsigned int max_record_length_gcc_fix = max_record_length;
-		unsigned int data_in_record = clan::min((unsigned int)size, max_record_length_gcc_fix);
-
-		int offset = 0;
-		int offset_tls_record = offset;					offset += sizeof(TLS_Record);
-		int offset_tls_appdata = offset;				offset += data_in_record;
-
-		Secret message(offset);
-		unsigned char *message_ptr = message.get_data();
-
-		set_tls_record(message_ptr + offset_tls_record, cl_tls_content_application_data, offset - offset_tls_record);
-
-		memcpy(message_ptr + offset_tls_appdata, data, data_in_record);
-
-		send_record(message_ptr, offset);
-
-
-		send_in_data_read_pos += data_in_record;
+		send_in_data_read_pos += send_application_record(data, size);
 		if (send_in_data_read_pos > desired_buffer_size / 2 || send_in_data_read_pos == 0)
 		{
 			int available = send_in_data.get_size() - send_in_data_read_pos;
@@ -245,6 +257,15 @@ namespace clan
 		return true;
 	}
 
+	unsigned int TLSClient_Impl::send_application_record(const void *data_ptr, unsigned int data_size)
+	{
+		unsigned int max_plaintext_length_gcc_fix = max_plaintext_length;
+		unsigned int data_in_record = clan::min(data_size, max_plaintext_length_gcc_fix);
+
+		seal_record(cl_tls_content_application_data, data_ptr, data_in_record);
+		return data_in_record;
+	}
+
 	bool TLSClient_Impl::receive_record()
 	{
 		// Do not read more records if our application data output buffer is full
@@ -280,23 +301,33 @@ namespace clan
 			// We set the protocol version in ServerHello
 		}
 
-		record_data_buffer.set_size(record_length);
-		memcpy(record_data_buffer.get_data(), recv_in_data.get_data() + recv_in_data_read_pos + sizeof(TLS_Record), record_length);
+		// The record is decrypted where it lies in the input buffer, except application data which is decrypted straight into the output buffer
+		unsigned char *fragment_ptr = (unsigned char *) recv_in_data.get_data() + recv_in_data_read_pos + sizeof(TLS_Record);
+		const unsigned char *plaintext = nullptr;
+		unsigned int plaintext_size = 0;
 
-		recv_in_data_read_pos += sizeof(TLS_Record) + record_length;
-		if (recv_in_data_read_pos > desired_buffer_size / 2)
+		if (record.type == cl_tls_content_application_data)
 		{
-			int available = recv_in_data.get_size() - recv_in_data_read_pos;
-			memmove(recv_in_data.get_data(), recv_in_data.get_data() + recv_in_data_read_pos, available);
-			recv_in_data.set_size(available);
-			recv_in_data_read_pos = 0;
-		}
+			if (conversation_state != cl_tls_state_connected)
+				throw Exception("Unexpected application data record received");
 
-		DataBuffer plaintext;
-		if (security_parameters.is_receive_encrypted)
-			plaintext = decrypt_record(record, record_data_buffer);
+			int pos = recv_out_data.get_size();
+			recv_out_data.set_size(pos + record_length);
+			try
+			{
+				plaintext = open_record(record, fragment_ptr, record_length, (unsigned char *) recv_out_data.get_data() + pos, plaintext_size);
+			}
+			catch (...)
+			{
+				recv_out_data.set_size(pos);
+				throw;
+			}
+			recv_out_data.set_size(pos + plaintext_size);
+		}
 		else
-			plaintext = record_data_buffer;
+		{
+			plaintext = open_record(record, fragment_ptr, record_length, nullptr, plaintext_size);
+		}
 
 		security_parameters.read_sequence_number++;
 		if (security_parameters.read_sequence_number == 0)
@@ -305,19 +336,19 @@ namespace clan
 		switch (record.type)
 		{
 		case cl_tls_content_change_cipher_spec:
-			change_cipher_spec_data(plaintext);
+			change_cipher_spec_data(plaintext, plaintext_size);
 			break;
 
 		case cl_tls_content_alert:
-			alert_data(plaintext);
+			alert_data(plaintext, plaintext_size);
 			break;
 
 		case cl_tls_content_handshake:
-			handshake_data(plaintext);
+			handshake_data(plaintext, plaintext_size);
 			break;
 
 		case cl_tls_content_application_data:
-			application_data(plaintext);
+			// Already decrypted into recv_out_data
 			break;
 
 		default:
@@ -326,20 +357,29 @@ namespace clan
 			break;
 		}
 
+		recv_in_data_read_pos += sizeof(TLS_Record) + record_length;
+		if (recv_in_data_read_pos > desired_buffer_size / 2)
+		{
+			int available = recv_in_data.get_size() - recv_in_data_read_pos;
+			memmove(recv_in_data.get_data(), recv_in_data.get_data() + recv_in_data_read_pos, available);
+			recv_in_data.set_size(available);
+			recv_in_data_read_pos = 0;
+		}
+
 		return true;
 	}
 
-	void TLSClient_Impl::change_cipher_spec_data(DataBuffer record_plaintext)
+	void TLSClient_Impl::change_cipher_spec_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size)
 	{
 		if (conversation_state != cl_tls_state_receive_change_cipher_spec)
 			throw Exception("Unexpected TLS change cipher record received");
 
-		if (record_plaintext.get_size() != 1)
+		if (record_plaintext_size != 1)
 			throw Exception("Invalid TLS content change cipher spec size");
 
 		security_parameters.read_sequence_number = 0;
 
-		uint8_t value = record_plaintext.get_data<uint8_t>()[0];
+		uint8_t value = record_plaintext[0];
 		if (value != 1)
 			throw Exception("TLS server change cipher spec did not send 1");
 
@@ -348,12 +388,12 @@ namespace clan
 		conversation_state = cl_tls_state_receive_finished;
 	}
 
-	void TLSClient_Impl::alert_data(DataBuffer record_plaintext)
+	void TLSClient_Impl::alert_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size)
 	{
-		if (record_plaintext.get_size() != 2) // To do: theoretically this is not safe - it could be split into two 1 byte records.
+		if (record_plaintext_size != 2) // To do: theoretically this is not safe - it could be split into two 1 byte records.
 			throw Exception("Invalid TLS content alert message");
 
-		uint8_t *alert_data = record_plaintext.get_data<uint8_t>();
+		const uint8_t *alert_data = record_plaintext;
 
 		if (alert_data[0] == cl_tls_warning)
 			return;
@@ -459,92 +499,87 @@ namespace clan
 		throw Exception(string);
 	}
 
-	void TLSClient_Impl::handshake_data(DataBuffer record_plaintext)
+	void TLSClient_Impl::handshake_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size)
 	{
 		// Copy handshake data into input buffer for easier processing:
 		// "RFC 2246 (5.2.1) multiple client messages of the same ContentType may be coalesced into a single TLSPlaintext record"
 		int pos = handshake_in_data.get_size();
-		handshake_in_data.set_size(pos + record_plaintext.get_size());
-		memcpy(handshake_in_data.get_data() + pos, record_plaintext.get_data(), record_plaintext.get_size());
+		handshake_in_data.set_size(pos + record_plaintext_size);
+		memcpy(handshake_in_data.get_data() + pos, record_plaintext, record_plaintext_size);
 
-		// Check if we have received enough data to peek at the handshake header:
-		int available = handshake_in_data.get_size() - handshake_in_read_pos;
-		if (available < sizeof(TLS_Handshake))
-			return;
+		// A record may carry several handshake messages, process all the complete ones:
+		while (true)
+		{
+			// Check if we have received enough data to peek at the handshake header:
+			int available = handshake_in_data.get_size() - handshake_in_read_pos;
+			if (available < sizeof(TLS_Handshake))
+				return;
 
-		// Check if we have received enough data to read the entire handshake message:
-		TLS_Handshake &handshake = *reinterpret_cast<TLS_Handshake*>(handshake_in_data.get_data() + handshake_in_read_pos);
-		int length = handshake.length[0] << 16 | handshake.length[1] << 8 | handshake.length[2];
-		if (sizeof(TLS_Handshake) + length > available)
-			return;
+			// Check if we have received enough data to read the entire handshake message:
+			TLS_Handshake &handshake = *reinterpret_cast<TLS_Handshake*>(handshake_in_data.get_data() + handshake_in_read_pos);
+			int length = handshake.length[0] << 16 | handshake.length[1] << 8 | handshake.length[2];
+			if (sizeof(TLS_Handshake) + length > available)
+				return;
 
-		const char *data = handshake_in_data.get_data() + handshake_in_read_pos + sizeof(TLS_Handshake);
+			const char *data = handshake_in_data.get_data() + handshake_in_read_pos + sizeof(TLS_Handshake);
 
-		// We got a full message.
+			// We got a full message.
 
-		// All handshake messages except handshake_finished needs to be included in the handshake hash calculation:
-		if (handshake.msg_type != cl_tls_handshake_finished)
-		{
-			hash_handshake(&handshake, length + sizeof(TLS_Handshake));
-		}
+			// All handshake messages except handshake_finished needs to be included in the handshake hash calculation:
+			if (handshake.msg_type != cl_tls_handshake_finished)
+			{
+				hash_handshake(&handshake, length + sizeof(TLS_Handshake));
+			}
 
-		// Dispatch message for further parsing:
-		switch (handshake.msg_type)
-		{
-		case cl_tls_handshake_hello_request:
-			handshake_hello_request_received(data, length);
-			break;
-		case cl_tls_handshake_client_hello:
-			handshake_client_hello_received(data, length);
-			break;
-		case cl_tls_handshake_server_hello:
-			handshake_server_hello_received(data, length);
-			break;
-		case cl_tls_handshake_certificate:
-			handshake_certificate_received(data, length);
-			break;
-		case cl_tls_handshake_server_key_exchange:
-			handshake_server_key_exchange_received(data, length);
-			break;
-		case cl_tls_handshake_certificate_request:
-			handshake_certificate_request_received(data, length);
-			break;
-		case cl_tls_handshake_server_hello_done:
-			handshake_server_hello_done_received(data, length);
-			break;
-		case cl_tls_handshake_certificate_verify:
-			handshake_certificate_verify_received(data, length);
-			break;
-		case cl_tls_handshake_client_key_exchange:
-			handshake_client_key_exchange_received(data, length);
-			break;
-		case cl_tls_handshake_finished:
-			handshake_finished_received(data, length);
-			break;
-		default:
-			throw Exception("Unknown handshake type");
-		}
+			// Dispatch message for further parsing:
+			switch (handshake.msg_type)
+			{
+			case cl_tls_handshake_hello_request:
+				handshake_hello_request_received(data, length);
+				break;
+			case cl_tls_handshake_client_hello:
+				handshake_client_hello_received(data, length);
+				break;
+			case cl_tls_handshake_server_hello:
+				handshake_server_hello_received(data, length);
+				break;
+			case cl_tls_handshake_certificate:
+				handshake_certificate_received(data, length);
+				break;
+			case cl_tls_handshake_server_key_exchange:
+				handshake_server_key_exchange_received(data, length);
+				break;
+			case cl_tls_handshake_certificate_request:
+				handshake_certificate_request_received(data, length);
+				break;
+			case cl_tls_handshake_server_hello_done:
+				handshake_server_hello_done_received(data, length);
+				break;
+			case cl_tls_handshake_certificate_verify:
+				handshake_certificate_verify_received(data, length);
+				break;
+			case cl_tls_handshake_client_key_exchange:
+				handshake_client_key_exchange_received(data, length);
+				break;
+			case cl_tls_handshake_finished:
+				handshake_finished_received(data, length);
+				break;
+			default:
+				throw Exception("Unknown handshake type");
+			}
 
-		// Remove processed handshake message from the input buffer:
-		handshake_in_read_pos += sizeof(TLS_Handshake) + length;
-		if (handshake_in_read_pos >= desired_buffer_size / 2)
-		{
-			available = handshake_in_data.get_size() - handshake_in_read_pos;
-			memmove(handshake_in_data.get_data(), handshake_in_data.get_data() + handshake_in_read_pos, available);
-			handshake_in_data.set_size(available);
+			// Remove processed handshake message from the input buffer:
+			handshake_in_read_pos += sizeof(TLS_Handshake) + length;
+			if (handshake_in_read_pos >= desired_buffer_size / 2)
+			{
+				available = handshake_in_data.get_size() - handshake_in_read_pos;
+				memmove(handshake_in_data.get_data(), handshake_in_data.get_data() + handshake_in_read_pos, available);
+				handshake_in_data.set_size(available);
+				handshake_in_read_pos = 0;
+			}
 		}
 	}
 
-	void TLSClient_Impl::application_data(DataBuffer record_plaintext)
-	{
-		if (conversation_state != cl_tls_state_connected)
-			throw Exception("Unexpected application data record received");
-
-		int pos = recv_out_data.get_size();
-		recv_out_data.set_size(pos + record_plaintext.get_size());
-		memcpy(recv_out_data.get_data() + pos, record_plaintext.get_data(), record_plaintext.get_size());
-	}
-
 	void TLSClient_Impl::handshake_hello_request_received(const void *data, int size)
 	{
 		// RFC 2246:
@@ -703,17 +738,7 @@ namespace clan
 		copy_data(server_verify_data.get_data(), verify_data_size, data, size);
 
 		Secret client_verify_data(verify_data_size);
-
-		Secret md5_handshake_messages(16);
-		Secret sha1_handshake_messages(20);
-
-		server_handshake_md5_hash.calculate();
-		server_handshake_sha1_hash.calculate();
-
-		server_handshake_md5_hash.get_hash(md5_handshake_messages.get_data());
-		server_handshake_sha1_hash.get_hash(sha1_handshake_messages.get_data());
-
-		PRF(client_verify_data.get_data(), verify_data_size, security_parameters.master_secret, "server finished", md5_handshake_messages, sha1_handshake_messages);
+		calculate_verify_data(client_verify_data.get_data(), verify_data_size, false);
 
 		if (memcmp(client_verify_data.get_data(), server_verify_data.get_data(), verify_data_size))
 			throw Exception("TLS server finished verify data failed");
@@ -740,29 +765,64 @@ namespace clan
 		if (record_length + sizeof(TLS_Record) != data_size)
 			throw Exception("Record length mismatch");
 
-		if (security_parameters.is_send_encrypted)
+		seal_record((TLS_ContentType) record_ptr->type, record_ptr + 1, record_length);
+	}
+
+	void TLSClient_Impl::seal_record(TLS_ContentType content_type, const void *data_ptr, unsigned int data_size)
+	{
+		int pos = send_out_data.get_size();
+
+		if (!security_parameters.is_send_encrypted)
 		{
-			// "the encryption and MAC functions convert TLSCompressed.fragment structures to and from block TLSCiphertext.fragment structures."
-			const unsigned char *input_ptr = (const unsigned char *) data_ptr + sizeof(TLS_Record);
-			unsigned int input_size = data_size - sizeof(TLS_Record);
-			Secret mac = calculate_mac(data_ptr, data_size, nullptr, 0, security_parameters.write_sequence_number, security_parameters.client_write_mac_secret);	// MAC includes the header and sequence number
-			DataBuffer encrypted = encrypt_data(input_ptr , input_size, mac.get_data(), mac.get_size());
-
-			// Update the length
-			int new_length = encrypted.get_size();
-			record_ptr->length[0] = new_length >> 8;
-			record_ptr->length[1] = new_length;
-
-			int pos = send_out_data.get_size();
-			send_out_data.set_size(pos + sizeof(TLS_Record) + new_length);
-			memcpy(send_out_data.get_data() + pos, data_ptr, sizeof(TLS_Record));
-			memcpy(send_out_data.get_data() + pos + sizeof(TLS_Record), encrypted.get_data(), new_length);
+			send_out_data.set_size(pos + sizeof(TLS_Record) + data_size);
+			unsigned char *record_ptr = (unsigned char *) send_out_data.get_data() + pos;
+			set_tls_record(record_ptr, content_type, sizeof(TLS_Record) + data_size);
+			memcpy(record_ptr + sizeof(TLS_Record), data_ptr, data_size);
+		}
+		else if (security_parameters.cipher_type == cl_tls_cipher_type_aead)
+		{
+			// RFC 5246 (6.2.3.3): explicit nonce, ciphertext and tag. The plaintext is encrypted straight into the output buffer
+			unsigned int fragment_size = security_parameters.record_iv_size + data_size + AES_GCM::tag_size;
+			send_out_data.set_size(pos + sizeof(TLS_Record) + fragment_size);
+			unsigned char *record_ptr = (unsigned char *) send_out_data.get_data() + pos;
+			unsigned char *record_iv_ptr = record_ptr + sizeof(TLS_Record);
+			unsigned char *ciphertext_ptr = record_iv_ptr + security_parameters.record_iv_size;
+			set_tls_record(record_ptr, content_type, sizeof(TLS_Record) + fragment_size);
+
+			// The sequence number never repeats for a key, so it is used as the explicit part of the nonce
+			set_sequence_number(record_iv_ptr, security_parameters.write_sequence_number);
+
+			unsigned char nonce[AES_GCM::iv_size];
+			unsigned char additional_data[aead_additional_data_size];
+			set_aead_nonce(nonce, security_parameters.client_write_iv, record_iv_ptr);
+			set_aead_additional_data(additional_data, security_parameters.write_sequence_number, content_type, data_size);
+
+			write_cipher.set_iv(nonce);
+			write_cipher.add_aad(additional_data, aead_additional_data_size);
+			write_cipher.encrypt(data_ptr, ciphertext_ptr, data_size);
+			write_cipher.get_tag(ciphertext_ptr + data_size);
 		}
 		else
 		{
-			int pos = send_out_data.get_size();
-			send_out_data.set_size(pos + data_size);
-			memcpy(send_out_data.get_data() + pos, data_ptr, data_size);
+			// "the encryption and MAC functions convert TLSCompressed.fragment structures to and from block TLSCiphertext.fragment structures."
+			unsigned char header[sizeof(TLS_Record)];
+			set_tls_record(header, content_type, sizeof(TLS_Record) + data_size);
+			Secret mac = calculate_mac(header, sizeof(TLS_Record), data_ptr, data_size, security_parameters.write_sequence_number, security_parameters.client_write_mac_secret);	// MAC includes the header and sequence number
+
+			// TLS 1.1 and later send a new random IV in front of every record
+			unsigned int record_iv_size = security_parameters.record_iv_size;
+			if (record_iv_size)
+				m_Random.get_random_bytes(security_parameters.client_write_iv.get_data(), record_iv_size);
+			send_out_data.set_size(pos + sizeof(TLS_Record) + record_iv_size);
+			memcpy(send_out_data.get_data() + pos + sizeof(TLS_Record), security_parameters.client_write_iv.get_data(), record_iv_size);
+
+			DataBuffer encrypted = encrypt_data(data_ptr, data_size, mac.get_data(), mac.get_size());
+
+			unsigned int fragment_size = record_iv_size + encrypted.get_size();
+			send_out_data.set_size(pos + sizeof(TLS_Record) + fragment_size);
+			unsigned char *record_ptr = (unsigned char *) send_out_data.get_data() + pos;
+			set_tls_record(record_ptr, content_type, sizeof(TLS_Record) + fragment_size);
+			memcpy(record_ptr + sizeof(TLS_Record) + record_iv_size, encrypted.get_data(), encrypted.get_size());
 		}
 
 		security_parameters.write_sequence_number++;
@@ -770,6 +830,51 @@ namespace clan
 			throw Exception("Sequence number wraparound");
 	}
 
+	const unsigned char *TLSClient_Impl::open_record(TLS_Record &record, unsigned char *fragment_ptr, unsigned int fragment_size, unsigned char *output_ptr, unsigned int &out_plaintext_size)
+	{
+		if (!security_parameters.is_receive_encrypted)
+		{
+			out_plaintext_size = fragment_size;
+			if (!output_ptr)
+				return fragment_ptr;
+			memcpy(output_ptr, fragment_ptr, fragment_size);
+			return output_ptr;
+		}
+
+		if (security_parameters.cipher_type == cl_tls_cipher_type_aead)
+		{
+			unsigned int record_iv_size = security_parameters.record_iv_size;
+			if (fragment_size < record_iv_size + AES_GCM::tag_size)
+				throw Exception("Invalid AEAD record size");
+
+			unsigned int plaintext_size = fragment_size - record_iv_size - AES_GCM::tag_size;
+			unsigned char *ciphertext_ptr = fragment_ptr + record_iv_size;
+			if (!output_ptr)
+				output_ptr = ciphertext_ptr;
+
+			unsigned char nonce[AES_GCM::iv_size];
+			unsigned char additional_data[aead_additional_data_size];
+			set_aead_nonce(nonce, security_parameters.server_write_iv, fragment_ptr);
+			set_aead_additional_data(additional_data, security_parameters.read_sequence_number, record.type, plaintext_size);
+
+			read_cipher.set_iv(nonce);
+			read_cipher.add_aad(additional_data, aead_additional_data_size);
+			read_cipher.decrypt(ciphertext_ptr, output_ptr, plaintext_size);
+			if (!read_cipher.verify_tag(ciphertext_ptr + plaintext_size))
+				throw Exception("TLS record authentication failed");
+
+			out_plaintext_size = plaintext_size;
+			return output_ptr;
+		}
+
+		DataBuffer decrypted = decrypt_record(record, fragment_ptr, fragment_size);
+		if (!output_ptr)
+			output_ptr = fragment_ptr;
+		memcpy(output_ptr, decrypted.get_data(), decrypted.get_size());
+		out_plaintext_size = decrypted.get_size();
+		return output_ptr;
+	}
+
 	void TLSClient_Impl::reset()
 	{
 		security_parameters.reset();
@@ -778,6 +883,10 @@ namespace clan
 		client_handshake_sha1_hash.reset();
 		server_handshake_md5_hash.reset();
 		server_handshake_sha1_hash.reset();
+		client_handshake_sha256_hash.reset();
+		server_handshake_sha256_hash.reset();
+		client_handshake_sha384_hash.reset();
+		server_handshake_sha384_hash.reset();
 	}
 
 	void TLSClient_Impl::copy_data(void *out_data, int size, const void *&data, int &data_left)
@@ -886,17 +995,20 @@ namespace clan
 	int TLSClient_Impl::get_cipher_suites_length() const
 	{
 		// CipherSuite cipher_suites<2..2^16-1>;
-		return 2 + (4*2);	// We support 4 cipher suites, each id contains 2 bytes
+		return 2 + (6*2);	// We support 6 cipher suites, each id contains 2 bytes
 	}
 
 	void TLSClient_Impl::set_cipher_suites(unsigned char *dest_ptr) const
 	{
-		const int num_ciphers = 4;	// If changing, you MUST change get_cipher_suites_length
+		const int num_ciphers = 6;	// If changing, you MUST change get_cipher_suites_length
 		int length = num_ciphers * 2;
 		*(dest_ptr++) = length >> 8;
 		*(dest_ptr++) = length;
 
 		// Strongest first ... maybe that should be controlled by the user, strong and fast first
+		// The AES-GCM suites (TLS 1.2 only) encrypt and authenticate in a single pass
+		*(dest_ptr++) = 0x00;	*(dest_ptr++) = 0x9D;	// TLS_RSA_WITH_AES_256_GCM_SHA384
+		*(dest_ptr++) = 0x00;	*(dest_ptr++) = 0x9C;	// TLS_RSA_WITH_AES_128_GCM_SHA256
 		*(dest_ptr++) = 0x00;	*(dest_ptr++) = 0x3D;	// TLS_RSA_WITH_AES_256_CBC_SHA256
 		*(dest_ptr++) = 0x00;	*(dest_ptr++) = 0x3C;	// TLS_RSA_WITH_AES_128_CBC_SHA256
 		*(dest_ptr++) = 0x00;	*(dest_ptr++) = 0x35;	// TLS_RSA_WITH_AES_256_CBC_SHA
@@ -905,32 +1017,65 @@ namespace clan
 
 	void TLSClient_Impl::select_cipher_suite(uint8_t value1, uint8_t value2)
 	{
+		bool requires_tls12 = false;
 		if (value1 == 0)
 		{
 			switch (value2)
 			{
+				case 0x9D:	// TLS_RSA_WITH_AES_256_GCM_SHA384
+				{
+					security_parameters.cipher_type = cl_tls_cipher_type_aead;
+					security_parameters.mac_algorithm = cl_tls_mac_algorithm_null;
+					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes256;
+					security_parameters.prf_algorithm = cl_tls_prf_sha384;
+					security_parameters.hash_size = 0;
+					security_parameters.iv_size = AES_GCM::iv_size;
+					security_parameters.key_material_length = AES256_Encrypt::key_size;
+					requires_tls12 = true;
+					break;
+				}
+				case 0x9C:	// TLS_RSA_WITH_AES_128_GCM_SHA256
+				{
+					security_parameters.cipher_type = cl_tls_cipher_type_aead;
+					security_parameters.mac_algorithm = cl_tls_mac_algorithm_null;
+					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes128;
+					security_parameters.prf_algorithm = cl_tls_prf_sha256;
+					security_parameters.hash_size = 0;
+					security_parameters.iv_size = AES_GCM::iv_size;
+					security_parameters.key_material_length = AES128_Encrypt::key_size;
+					requires_tls12 = true;
+					break;
+				}
 				case 0x3D:	// TLS_RSA_WITH_AES_256_CBC_SHA256
 				{
+					security_parameters.cipher_type = cl_tls_cipher_type_block;
 					security_parameters.mac_algorithm = cl_tls_mac_algorithm_sha256;
 					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes256;
+					security_parameters.prf_algorithm = cl_tls_prf_sha256;
 					security_parameters.hash_size = SHA256::hash_size;
 					security_parameters.iv_size = AES256_Encrypt::iv_size;
 					security_parameters.key_material_length = AES256_Encrypt::key_size;
+					requires_tls12 = true;
 					break;
 				}
 				case 0x3C:	// TLS_RSA_WITH_AES_128_CBC_SHA256
 				{
+					security_parameters.cipher_type = cl_tls_cipher_type_block;
 					security_parameters.mac_algorithm = cl_tls_mac_algorithm_sha256;
 					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes128;
+					security_parameters.prf_algorithm = cl_tls_prf_sha256;
 					security_parameters.hash_size = SHA256::hash_size;
 					security_parameters.iv_size = AES128_Encrypt::iv_size;
 					security_parameters.key_material_length = AES128_Encrypt::key_size;
+					requires_tls12 = true;
 					break;
 				}
 				case 0x35:	// TLS_RSA_WITH_AES_256_CBC_SHA
 				{
+					security_parameters.cipher_type = cl_tls_cipher_type_block;
 					security_parameters.mac_algorithm = cl_tls_mac_algorithm_sha;
 					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes256;
+					security_parameters.prf_algorithm = cl_tls_prf_sha256;
 					security_parameters.hash_size = SHA1::hash_size;
 					security_parameters.iv_size = AES256_Encrypt::iv_size;
 					security_parameters.key_material_length = AES256_Encrypt::key_size;
@@ -938,8 +1083,10 @@ namespace clan
 				}
 				case 0x2F:	// TLS_RSA_WITH_AES_128_CBC_SHA
 				{
+					security_parameters.cipher_type = cl_tls_cipher_type_block;
 					security_parameters.mac_algorithm = cl_tls_mac_algorithm_sha;
 					security_parameters.bulk_cipher_algorithm = cl_tls_cipher_algorithm_aes128;
+					security_parameters.prf_algorithm = cl_tls_prf_sha256;
 					security_parameters.hash_size = SHA1::hash_size;
 					security_parameters.iv_size = AES128_Encrypt::iv_size;
 					security_parameters.key_material_length = AES128_Encrypt::key_size;
@@ -954,6 +1101,33 @@ namespace clan
 		{
 			throw Exception("TLS unsupported cipher suite");
 		}
+
+		// The server hello has already chosen the protocol version
+		bool is_tls12 = protocol.minor >= 3;
+		if (requires_tls12 && !is_tls12)
+			throw Exception("TLS cipher suite requires TLS 1.2");
+
+		// TLS 1.0 and 1.1 use the MD5 and SHA-1 based PRF for every cipher suite
+		if (!is_tls12)
+			security_parameters.prf_algorithm = cl_tls_prf_md5_sha1;
+
+		if (security_parameters.cipher_type == cl_tls_cipher_type_aead)
+		{
+			// RFC 5288 (3): 4 byte salt from the key block followed by an 8 byte nonce sent in each record
+			security_parameters.fixed_iv_size = 4;
+			security_parameters.record_iv_size = security_parameters.iv_size - 4;
+		}
+		else if (protocol.minor >= 2)
+		{
+			// RFC 4346 (6.2.3.2): TLS 1.1 and later send an explicit IV with each CBC record
+			security_parameters.fixed_iv_size = 0;
+			security_parameters.record_iv_size = security_parameters.iv_size;
+		}
+		else
+		{
+			security_parameters.fixed_iv_size = security_parameters.iv_size;
+			security_parameters.record_iv_size = 0;
+		}
 	}
 
 	bool TLSClient_Impl::send_client_hello()
@@ -1010,14 +1184,14 @@ namespace clan
 		Secret pre_master_secret(48);
 		unsigned char *pms_ptr = pre_master_secret.get_data();
 		m_Random.get_random_bytes(pms_ptr + 2, 46);
-		pms_ptr[0] = protocol.major;	// Version number
-		pms_ptr[1] = protocol.minor;
+		pms_ptr[0] = client_hello_protocol.major;	// Version number (RFC 5246 (7.4.7.1) the offered version, not the negotiated one)
+		pms_ptr[1] = client_hello_protocol.minor;
 
 		DataBuffer wrapped_pre_master_secret = RSA::encrypt(2, m_Random, server_public_exponent,  server_public_modulus, pre_master_secret);
 
 		PRF(security_parameters.master_secret.get_data(), security_parameters.master_secret.get_size(), pre_master_secret, "master secret", security_parameters.client_random, security_parameters.server_random);
 
-		Secret key_block( 2 * (security_parameters.hash_size + security_parameters.key_material_length + security_parameters.iv_size ) );
+		Secret key_block( 2 * (security_parameters.hash_size + security_parameters.key_material_length + security_parameters.fixed_iv_size ) );
 		PRF(key_block.get_data(), key_block.get_size(), security_parameters.master_secret, "key expansion", security_parameters.server_random, security_parameters.client_random);
 
 		security_parameters.client_write_mac_secret = Secret(security_parameters.hash_size);
@@ -1041,11 +1215,17 @@ namespace clan
 		memcpy(security_parameters.server_write_key.get_data(), key_block_ptr, security_parameters.server_write_key.get_size());
 		key_block_ptr+=security_parameters.server_write_key.get_size();
 
-		memcpy(security_parameters.client_write_iv.get_data(), key_block_ptr, security_parameters.client_write_iv.get_size());
-		key_block_ptr+=security_parameters.client_write_iv.get_size();
+		memcpy(security_parameters.client_write_iv.get_data(), key_block_ptr, security_parameters.fixed_iv_size);
+		key_block_ptr+=security_parameters.fixed_iv_size;
 
-		memcpy(security_parameters.server_write_iv.get_data(), key_block_ptr, security_parameters.server_write_iv.get_size());
-		key_block_ptr+=security_parameters.server_write_iv.get_size();
+		memcpy(security_parameters.server_write_iv.get_data(), key_block_ptr, security_parameters.fixed_iv_size);
+		key_block_ptr+=security_parameters.fixed_iv_size;
+
+		if (security_parameters.cipher_type == cl_tls_cipher_type_aead)
+		{
+			write_cipher.set_key(security_parameters.client_write_key.get_data(), security_parameters.client_write_key.get_size());
+			read_cipher.set_key(security_parameters.server_write_key.get_data(), security_parameters.server_write_key.get_size());
+		}
 
 		const int wrapped_pre_master_secret_length = wrapped_pre_master_secret.get_size();
 
@@ -1073,6 +1253,63 @@ namespace clan
 	}
 
 	void TLSClient_Impl::PRF(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2)
+	{
+		switch (security_parameters.prf_algorithm)
+		{
+		case cl_tls_prf_sha256:
+			P_hash<SHA256>(output_ptr, output_size, secret, label_ptr, seed_part1, seed_part2);
+			break;
+		case cl_tls_prf_sha384:
+			P_hash<SHA384>(output_ptr, output_size, secret, label_ptr, seed_part1, seed_part2);
+			break;
+		default:
+			PRF_md5_sha1(output_ptr, output_size, secret, label_ptr, seed_part1, seed_part2);
+			break;
+		}
+	}
+
+	template<typename HashFunction>
+	void TLSClient_Impl::P_hash(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2)
+	{
+		// RFC 5246 (5): P_hash(secret, seed) = HMAC_hash(secret, A(1) + seed) + HMAC_hash(secret, A(2) + seed) + ...
+		// where A(0) = seed and A(i) = HMAC_hash(secret, A(i-1)). The seed is the label followed by both seed parts
+		int label_length = strlen(label_ptr);
+
+		Secret a(HashFunction::hash_size);
+		Secret output(HashFunction::hash_size);
+
+		HashFunction hash;
+		hash.set_hmac(secret.get_data(), secret.get_size());
+		hash.add(label_ptr, label_length);
+		hash.add(seed_part1.get_data(), seed_part1.get_size());
+		hash.add(seed_part2.get_data(), seed_part2.get_size());
+		hash.calculate();
+		hash.get_hash(a.get_data());
+
+		unsigned char *out_ptr = (unsigned char *) output_ptr;
+		while (output_size > 0)
+		{
+			hash.set_hmac(secret.get_data(), secret.get_size());
+			hash.add(a.get_data(), a.get_size());
+			hash.add(label_ptr, label_length);
+			hash.add(seed_part1.get_data(), seed_part1.get_size());
+			hash.add(seed_part2.get_data(), seed_part2.get_size());
+			hash.calculate();
+			hash.get_hash(output.get_data());
+
+			unsigned int copy_size = clan::min(output_size, (unsigned int) HashFunction::hash_size);
+			memcpy(out_ptr, output.get_data(), copy_size);
+			out_ptr += copy_size;
+			output_size -= copy_size;
+
+			hash.set_hmac(secret.get_data(), secret.get_size());
+			hash.add(a.get_data(), a.get_size());
+			hash.calculate();
+			hash.get_hash(a.get_data());
+		}
+	}
+
+	void TLSClient_Impl::PRF_md5_sha1(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2)
 	{
 		const uint8_t *secret_part1 = secret.get_data();
 		int secret_length = secret.get_size();
@@ -1160,6 +1397,48 @@ namespace clan
 
 	}
 
+	void TLSClient_Impl::calculate_verify_data(void *output_ptr, unsigned int output_size, bool client_finished)
+	{
+		// The server finished message covers the client finished message, so the client and server each have their own handshake hashes
+		const char *label = client_finished ? "client finished" : "server finished";
+		Secret no_seed;
+
+		switch (security_parameters.prf_algorithm)
+		{
+		case cl_tls_prf_sha256:
+		{
+			SHA256 &sha256 = client_finished ? client_handshake_sha256_hash : server_handshake_sha256_hash;
+			Secret handshake_messages(SHA256::hash_size);
+			sha256.calculate();
+			sha256.get_hash(handshake_messages.get_data());
+			PRF(output_ptr, output_size, security_parameters.master_secret, label, handshake_messages, no_seed);
+			break;
+		}
+		case cl_tls_prf_sha384:
+		{
+			SHA384 &sha384 = client_finished ? client_handshake_sha384_hash : server_handshake_sha384_hash;
+			Secret handshake_messages(SHA384::hash_size);
+			sha384.calculate();
+			sha384.get_hash(handshake_messages.get_data());
+			PRF(output_ptr, output_size, security_parameters.master_secret, label, handshake_messages, no_seed);
+			break;
+		}
+		default:
+		{
+			MD5 &md5 = client_finished ? client_handshake_md5_hash : server_handshake_md5_hash;
+			SHA1 &sha1 = client_finished ? client_handshake_sha1_hash : server_handshake_sha1_hash;
+			Secret md5_handshake_messages(MD5::hash_size);
+			Secret sha1_handshake_messages(SHA1::hash_size);
+			md5.calculate();
+			sha1.calculate();
+			md5.get_hash(md5_handshake_messages.get_data());
+			sha1.get_hash(sha1_handshake_messages.get_data());
+			PRF(output_ptr, output_size, security_parameters.master_secret, label, md5_handshake_messages, sha1_handshake_messages);
+			break;
+		}
+		}
+	}
+
 	void TLSClient_Impl::set_server_public_key()
 	{
 		if (certificate_chain.empty())
@@ -1209,16 +1488,7 @@ namespace clan
 		set_tls_record(message_ptr + offset_tls_record, cl_tls_content_handshake, offset - offset_tls_record);
 		set_tls_handshake(message_ptr + offset_tls_handshake, cl_tls_handshake_finished, offset - offset_tls_handshake);
 
-		Secret md5_handshake_messages(MD5::hash_size);
-		Secret sha1_handshake_messages(SHA1::hash_size);
-
-		client_handshake_md5_hash.calculate();
-		client_handshake_sha1_hash.calculate();
-
-		client_handshake_md5_hash.get_hash(md5_handshake_messages.get_data());
-		client_handshake_sha1_hash.get_hash(sha1_handshake_messages.get_data());
-
-		PRF(message_ptr + offset_tls_finished, verify_data_size, security_parameters.master_secret, "client finished", md5_handshake_messages, sha1_handshake_messages);
+		calculate_verify_data(message_ptr + offset_tls_finished, verify_data_size, true);
 
 		hash_handshake( message_ptr + offset_tls_handshake, offset - offset_tls_handshake);
 		send_record(message_ptr, offset);
@@ -1267,15 +1537,7 @@ namespace clan
 	Secret TLSClient_Impl::calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret)
 	{
 		unsigned char sequence_number_buffer[8];
-
-		sequence_number_buffer[0] = sequence_number >> 56; 
-		sequence_number_buffer[1] = sequence_number >> 48; 
-		sequence_number_buffer[2] = sequence_number >> 40; 
-		sequence_number_buffer[3] = sequence_number >> 32; 
-		sequence_number_buffer[4] = sequence_number >> 24; 
-		sequence_number_buffer[5] = sequence_number >> 16; 
-		sequence_number_buffer[6] = sequence_number >> 8; 
-		sequence_number_buffer[7] = sequence_number; 
+		set_sequence_number(sequence_number_buffer, sequence_number);
 
 		if (security_parameters.mac_algorithm == cl_tls_mac_algorithm_sha)
 		{
@@ -1311,12 +1573,45 @@ namespace clan
 		}
 	}
 
+	void TLSClient_Impl::set_sequence_number(unsigned char *dest_ptr, uint64_t sequence_number) const
+	{
+		dest_ptr[0] = sequence_number >> 56;
+		dest_ptr[1] = sequence_number >> 48;
+		dest_ptr[2] = sequence_number >> 40;
+		dest_ptr[3] = sequence_number >> 32;
+		dest_ptr[4] = sequence_number >> 24;
+		dest_ptr[5] = sequence_number >> 16;
+		dest_ptr[6] = sequence_number >> 8;
+		dest_ptr[7] = sequence_number;
+	}
+
+	void TLSClient_Impl::set_aead_nonce(unsigned char *dest_ptr, const Secret &fixed_iv, const unsigned char *record_iv) const
+	{
+		memcpy(dest_ptr, fixed_iv.get_data(), security_parameters.fixed_iv_size);
+		memcpy(dest_ptr + security_parameters.fixed_iv_size, record_iv, security_parameters.record_iv_size);
+	}
+
+	void TLSClient_Impl::set_aead_additional_data(unsigned char *dest_ptr, uint64_t sequence_number, uint8_t content_type, unsigned int length) const
+	{
+		// additional_data = seq_num + TLSCompressed.type + TLSCompressed.version + TLSCompressed.length
+		set_sequence_number(dest_ptr, sequence_number);
+		dest_ptr[8] = content_type;
+		dest_ptr[9] = protocol.major;
+		dest_ptr[10] = protocol.minor;
+		dest_ptr[11] = length >> 8;
+		dest_ptr[12] = length;
+	}
+
 	void TLSClient_Impl::hash_handshake(const void *data_ptr, unsigned int data_size)
 	{
 		client_handshake_md5_hash.add(data_ptr, data_size);
 		client_handshake_sha1_hash.add(data_ptr, data_size);
 		server_handshake_md5_hash.add(data_ptr, data_size);
 		server_handshake_sha1_hash.add(data_ptr, data_size);
+		client_handshake_sha256_hash.add(data_ptr, data_size);
+		server_handshake_sha256_hash.add(data_ptr, data_size);
+		client_handshake_sha384_hash.add(data_ptr, data_size);
+		server_handshake_sha384_hash.add(data_ptr, data_size);
 	}
 
 	DataBuffer TLSClient_Impl::decrypt_data(const void *data_ptr, unsigned int data_size)
@@ -1353,9 +1648,15 @@ namespace clan
 
 	}
 
-	DataBuffer TLSClient_Impl::decrypt_record(TLS_Record &record, const DataBuffer &record_data)
+	DataBuffer TLSClient_Impl::decrypt_record(TLS_Record &record, const void *data_ptr, unsigned int data_size)
 	{
-		DataBuffer decrypted = decrypt_data(record_data.get_data(), record_data.get_size());
+		// TLS 1.1 and later send the IV in front of the record
+		unsigned int record_iv_size = security_parameters.record_iv_size;
+		if (data_size < record_iv_size + security_parameters.iv_size)
+			throw Exception("Invalid record size");
+		memcpy(security_parameters.server_write_iv.get_data(), data_ptr, record_iv_size);
+
+		DataBuffer decrypted = decrypt_data((const unsigned char *) data_ptr + record_iv_size, data_size - record_iv_size);
 
 		unsigned char *decrypted_data = (unsigned char *) decrypted.get_data();
 
@@ -35,6 +35,7 @@
 #include "API/Core/Crypto/random.h"
 #include "API/Core/Crypto/rsa.h"
 #include "API/Core/Crypto/hash_functions.h"
+#include "API/Core/Crypto/aes_gcm.h"
 #include "x509.h"
 
 namespace clan
@@ -60,7 +61,8 @@ namespace clan
 	enum TLS_CipherType
 	{
 		cl_tls_cipher_type_stream,
-		cl_tls_cipher_type_block
+		cl_tls_cipher_type_block,
+		cl_tls_cipher_type_aead
 	};
 
 	enum TLS_MACAlgorithm
@@ -71,6 +73,13 @@ namespace clan
 		cl_tls_mac_algorithm_sha256
 	};
 
+	enum TLS_PRFAlgorithm
+	{
+		cl_tls_prf_md5_sha1,	// TLS 1.0 and 1.1
+		cl_tls_prf_sha256,
+		cl_tls_prf_sha384
+	};
+
 	enum TLS_CompressionMethod
 	{
 		cl_tls_compression_null = 0
@@ -168,9 +177,12 @@ namespace clan
 			key_size = 0;
 			key_material_length = 0;
 			iv_size = 0;
+			fixed_iv_size = 0;
+			record_iv_size = 0;
 			is_exportable = false;
 			mac_algorithm = cl_tls_mac_algorithm_null;
 			hash_size = 0;
+			prf_algorithm = cl_tls_prf_md5_sha1;
 			compression_algorithm = cl_tls_compression_null;
 			master_secret = Secret(48);
 			client_random = Secret(32);
@@ -194,9 +206,12 @@ namespace clan
 		uint8_t key_size;
 		uint8_t key_material_length;
 		uint8_t iv_size;
+		uint8_t fixed_iv_size;	// Part of the IV taken from the key block
+		uint8_t record_iv_size;	// Part of the IV sent in front of every record
 		bool is_exportable;
 		TLS_MACAlgorithm mac_algorithm;
 		uint8_t hash_size;
+		TLS_PRFAlgorithm prf_algorithm;
 		TLS_CompressionMethod compression_algorithm;
 		Secret master_secret;
 		Secret client_random;
@@ -255,12 +270,23 @@ namespace clan
 		bool can_send_record() const;
 		void send_record(void *data_ptr, unsigned int data_size);	// !< Note "data_ptr" may be written to
 
+		/// \brief Appends a record to send_out_data, encrypting the plaintext straight into it
+		void seal_record(TLS_ContentType content_type, const void *data_ptr, unsigned int data_size);
+
+		/// \brief Seals as much of the data as fits in one record and returns the number of bytes used
+		unsigned int send_application_record(const void *data_ptr, unsigned int data_size);
+
 		bool receive_record();
 
-		void change_cipher_spec_data(DataBuffer record_plaintext);
-		void alert_data(DataBuffer record_plaintext);
-		void handshake_data(DataBuffer record_plaintext);
-		void application_data(DataBuffer record_plaintext);
+		/// \brief Decrypts and authenticates a received record fragment
+		///
+		/// The plaintext is written to output_ptr, or in place inside the fragment when output_ptr is null.
+		/// \return Pointer to the plaintext, its size is returned in out_plaintext_size
+		const unsigned char *open_record(TLS_Record &record, unsigned char *fragment_ptr, unsigned int fragment_size, unsigned char *output_ptr, unsigned int &out_plaintext_size);
+
+		void change_cipher_spec_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size);
+		void alert_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size);
+		void handshake_data(const unsigned char *record_plaintext, unsigned int record_plaintext_size);
 
 		void handshake_hello_request_received(const void *data, int size);
 		void handshake_client_hello_received(const void *data, int size);
@@ -299,15 +325,25 @@ namespace clan
 		void inspect_certificate(std::vector<unsigned char> &cert);
 		void set_server_public_key();
 		void PRF(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2);
+		void PRF_md5_sha1(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2);
+		template<typename HashFunction>
+		void P_hash(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2);
+		void calculate_verify_data(void *output_ptr, unsigned int output_size, bool client_finished);
 		void hash_handshake(const void *data_ptr, unsigned int data_size);
 
-		DataBuffer decrypt_record(TLS_Record &record, const DataBuffer &record_data);
+		DataBuffer decrypt_record(TLS_Record &record, const void *data_ptr, unsigned int data_size);
 		DataBuffer decrypt_data(const void *data_ptr, unsigned int data_size);
 
 		Secret calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret);
 		DataBuffer encrypt_data(const void *data_ptr, unsigned int data_size, const void *mac_ptr, unsigned int mac_size);
 
+		void set_sequence_number(unsigned char *dest_ptr, uint64_t sequence_number) const;
+		void set_aead_nonce(unsigned char *dest_ptr, const Secret &fixed_iv, const unsigned char *record_iv) const;
+		void set_aead_additional_data(unsigned char *dest_ptr, uint64_t sequence_number, uint8_t content_type, unsigned int length) const;
+
 		static const unsigned int max_record_length = 2 << 14;	// RFC 2246 (6.2.1)
+		static const unsigned int max_plaintext_length = 1 << 14;	// Application data is split into records of at most 16 KB
+		static const unsigned int aead_additional_data_size = 13;	// RFC 5246 (6.2.3.3)
 		static const unsigned int max_handshake_length = 2 << 24;	// RFC 2246 (implied by length in7.4)
 
 		static const int desired_buffer_size = 64 * 1024;
@@ -331,8 +367,12 @@ namespace clan
 
 		DataBuffer record_data_buffer; // local variable of receive_record(). Placed here to avoid allocating memory each time a record is processed
 
+		AES_GCM write_cipher;	// Keyed once when the handshake derives the keys for an AEAD cipher suite
+		AES_GCM read_cipher;
+
 		TLS_SecurityParameters security_parameters;
 		TLS_ProtocolVersion protocol;
+		TLS_ProtocolVersion client_hello_protocol;	// The version offered in the client hello, which the pre-master secret must contain
 
 		DataBuffer server_public_exponent;
 		DataBuffer server_public_modulus;
@@ -345,6 +385,10 @@ namespace clan
 		SHA1 client_handshake_sha1_hash;
 		MD5 server_handshake_md5_hash;
 		SHA1 server_handshake_sha1_hash;
+		SHA256 client_handshake_sha256_hash;
+		SHA256 server_handshake_sha256_hash;
+		SHA384 client_handshake_sha384_hash;
+		SHA384 server_handshake_sha384_hash;
 
 		std::vector<X509> certificate_chain;
 	};
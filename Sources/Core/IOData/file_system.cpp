@@ -36,6 +36,7 @@
 #include "API/Core/Text/string_format.h"
 #include "file_system_provider_file.h"
 #include "file_system_provider_zip.h"
+#include "file_system_provider_mapped_zip.h"
 
 namespace clan
 {
@@ -84,6 +85,12 @@ namespace clan
 			impl->provider = new FileSystemProvider_File(path);
 	}
 
+	FileSystem::FileSystem(const ZipMappedArchive &zip_archive)
+		: impl(std::make_shared<FileSystem_Impl>())
+	{
+		impl->provider = new FileSystemProvider_MappedZip(zip_archive);
+	}
+
 	FileSystem::~FileSystem()
 	{
 	}
@@ -0,0 +1,87 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "file_system_provider_mapped_zip.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/IOData/directory_listing_entry.h"
+
+namespace clan
+{
+	FileSystemProvider_MappedZip::FileSystemProvider_MappedZip(const ZipMappedArchive &zip_archive)
+		: zip_archive(zip_archive), index(0)
+	{
+		zip_archive.throw_if_null();
+	}
+
+	FileSystemProvider_MappedZip::~FileSystemProvider_MappedZip()
+	{
+	}
+
+	std::string FileSystemProvider_MappedZip::get_path() const
+	{
+		return std::string();
+	}
+
+	std::string FileSystemProvider_MappedZip::get_identifier() const
+	{
+		return zip_archive.get_filename();
+	}
+
+	IODevice FileSystemProvider_MappedZip::open_file(const std::string &filename,
+		File::OpenMode mode,
+		unsigned int access,
+		unsigned int share,
+		unsigned int flags)
+	{
+		return zip_archive.open_file(filename);
+	}
+
+	bool FileSystemProvider_MappedZip::initialize_directory_listing(const std::string &path)
+	{
+		file_list = zip_archive.get_file_list(path);
+		index = 0;
+
+		return true;	// Empty directories should be valid
+	}
+
+	bool FileSystemProvider_MappedZip::next_file(DirectoryListingEntry &entry)
+	{
+		if (index >= file_list.size())
+			return false;
+
+		entry.set_filename(file_list[index].get_archive_filename());
+		entry.set_readable(true);
+		entry.set_directory(file_list[index].is_directory());
+		entry.set_hidden(false);
+		entry.set_writable(false);
+		index++;
+
+		return true;
+	}
+}
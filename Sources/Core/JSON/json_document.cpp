@@ -0,0 +1,383 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_document.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/block_allocator.h"
+#include "json_parser.h"
+#include <algorithm>
+
+namespace clan
+{
+	struct JsonDocumentNode
+	{
+		JsonType type;
+		uint32_t count;	// Array items, object properties or string length
+		union
+		{
+			double number;
+			bool boolean;
+			const char *string;
+			const JsonDocumentNode *items;
+			const JsonDocumentMember *members;
+		};
+	};
+
+	struct JsonDocumentMember
+	{
+		const char *key;
+		uint32_t key_length;
+		JsonDocumentNode value;
+	};
+
+	class JsonDocument_Impl
+	{
+	public:
+		/// \brief Parses the text, which is modified in place and kept for the strings pointing into it
+		void parse(const DataBuffer &new_text, size_t length);
+
+		DataBuffer text;
+		BlockAllocator allocator;
+		JsonDocumentNode root;
+	};
+
+	/// \brief JsonParser handler building the nodes of a JsonDocument
+	///
+	/// Values are collected on a stack until their container ends. The container then copies
+	/// them into one array from the block allocator.
+	class JsonDocumentBuilder
+	{
+	public:
+		JsonDocumentBuilder(BlockAllocator &allocator) : allocator(allocator)
+		{
+		}
+
+		const JsonDocumentNode &get_root() const { return stack.front().value; }
+
+		void null_value() { push(node(JsonType::null, 0)); }
+		void boolean_value(bool value) { JsonDocumentNode n = node(JsonType::boolean, 0); n.boolean = value; push(n); }
+		void number_value(double value) { JsonDocumentNode n = node(JsonType::number, 0); n.number = value; push(n); }
+		void string_value(const char *data, size_t length) { JsonDocumentNode n = node(JsonType::string, length); n.string = data; push(n); }
+
+		void begin_object() { begin_container(); }
+		void begin_array() { begin_container(); }
+
+		void object_key(const char *data, size_t length)
+		{
+			key = data;
+			key_length = checked_length(length);
+		}
+
+		void end_object()
+		{
+			Container container = containers.back();
+			containers.pop_back();
+
+			size_t count = stack.size() - container.start;
+			JsonDocumentMember *members = allocate<JsonDocumentMember>(count);
+			std::copy(stack.begin() + container.start, stack.end(), members);
+
+			// Keys point into the document text, so equal keys are ordered by their position in the text.
+			// Of duplicated keys only the last one is kept, like JsonValue::parse does.
+			std::sort(members, members + count, [](const JsonDocumentMember &a, const JsonDocumentMember &b)
+			{
+				int result = compare(a.key, a.key_length, b.key, b.key_length);
+				return result != 0 ? result < 0 : a.key < b.key;
+			});
+			size_t unique = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				if (unique > 0 && compare(members[unique - 1].key, members[unique - 1].key_length, members[i].key, members[i].key_length) == 0)
+					members[unique - 1] = members[i];
+				else
+					members[unique++] = members[i];
+			}
+
+			end_container(container);
+			JsonDocumentNode n = node(JsonType::object, unique);
+			n.members = members;
+			push(n);
+		}
+
+		void end_array()
+		{
+			Container container = containers.back();
+			containers.pop_back();
+
+			size_t count = stack.size() - container.start;
+			JsonDocumentNode *items = allocate<JsonDocumentNode>(count);
+			for (size_t i = 0; i < count; i++)
+				items[i] = stack[container.start + i].value;
+
+			end_container(container);
+			JsonDocumentNode n = node(JsonType::array, count);
+			n.items = items;
+			push(n);
+		}
+
+		static int compare(const char *a, size_t a_length, const char *b, size_t b_length)
+		{
+			int result = memcmp(a, b, std::min(a_length, b_length));
+			if (result != 0)
+				return result;
+			return a_length < b_length ? -1 : (a_length > b_length ? 1 : 0);
+		}
+
+	private:
+		struct Container
+		{
+			size_t start;
+			const char *key;
+			uint32_t key_length;
+		};
+
+		static uint32_t checked_length(size_t length)
+		{
+			if (length > 0xffffffff)
+				throw JsonException("JSON value too large");
+			return (uint32_t)length;
+		}
+
+		static JsonDocumentNode node(JsonType type, size_t count)
+		{
+			JsonDocumentNode n;
+			n.type = type;
+			n.count = checked_length(count);
+			n.number = 0.0;
+			return n;
+		}
+
+		void push(const JsonDocumentNode &value)
+		{
+			JsonDocumentMember member;
+			member.key = key;
+			member.key_length = key_length;
+			member.value = value;
+			stack.push_back(member);
+		}
+
+		void begin_container()
+		{
+			Container container;
+			container.start = stack.size();
+			container.key = key;
+			container.key_length = key_length;
+			containers.push_back(container);
+		}
+
+		void end_container(const Container &container)
+		{
+			stack.resize(container.start);
+			key = container.key;
+			key_length = container.key_length;
+		}
+
+		template<typename Type>
+		Type *allocate(size_t count)
+		{
+			if (count == 0)
+				return nullptr;
+			// Keep every allocation 8 byte aligned
+			size_t size = (sizeof(Type) * count + 7) & ~(size_t)7;
+			return static_cast<Type*>(allocator.allocate((int)size));
+		}
+
+		BlockAllocator &allocator;
+		std::vector<JsonDocumentMember> stack;
+		std::vector<Container> containers;
+		const char *key = "";
+		uint32_t key_length = 0;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonType JsonNode::type() const
+	{
+		return node ? node->type : JsonType::undefined;
+	}
+
+	size_t JsonNode::size() const
+	{
+		return node && (node->type == JsonType::array || node->type == JsonType::object) ? node->count : 0;
+	}
+
+	JsonNode JsonNode::at(size_t index) const
+	{
+		if (node && node->type == JsonType::array && index < node->count)
+			return JsonNode(node->items + index);
+		return JsonNode();
+	}
+
+	JsonNode JsonNode::prop(const char *name, size_t length) const
+	{
+		if (!node || node->type != JsonType::object)
+			return JsonNode();
+
+		const JsonDocumentMember *first = node->members;
+		const JsonDocumentMember *last = node->members + node->count;
+		const JsonDocumentMember *it = std::lower_bound(first, last, 0, [&](const JsonDocumentMember &member, int)
+		{
+			return JsonDocumentBuilder::compare(member.key, member.key_length, name, length) < 0;
+		});
+		if (it != last && it->key_length == length && memcmp(it->key, name, length) == 0)
+			return JsonNode(&it->value);
+		return JsonNode();
+	}
+
+	JsonStringRef JsonNode::key(size_t index) const
+	{
+		if (node && node->type == JsonType::object && index < node->count)
+			return JsonStringRef(node->members[index].key, node->members[index].key_length);
+		return JsonStringRef();
+	}
+
+	JsonNode JsonNode::value(size_t index) const
+	{
+		if (node && node->type == JsonType::object && index < node->count)
+			return JsonNode(&node->members[index].value);
+		return JsonNode();
+	}
+
+	double JsonNode::to_number() const
+	{
+		return node && node->type == JsonType::number ? node->number : 0.0;
+	}
+
+	bool JsonNode::to_boolean() const
+	{
+		return node && node->type == JsonType::boolean ? node->boolean : false;
+	}
+
+	JsonStringRef JsonNode::to_string() const
+	{
+		if (node && node->type == JsonType::string)
+			return JsonStringRef(node->string, node->count);
+		return JsonStringRef();
+	}
+
+	JsonValue JsonNode::to_value() const
+	{
+		switch (type())
+		{
+		default:
+		case JsonType::undefined:
+			return JsonValue::undefined();
+		case JsonType::null:
+			return JsonValue::null();
+		case JsonType::boolean:
+			return JsonValue::boolean(node->boolean);
+		case JsonType::number:
+			return JsonValue::number(node->number);
+		case JsonType::string:
+			return JsonValue::string(to_string().str());
+		case JsonType::array:
+		{
+			JsonValue result = JsonValue::array();
+			result.items().reserve(node->count);
+			for (size_t i = 0; i < node->count; i++)
+				result.items().push_back(JsonNode(node->items + i).to_value());
+			return result;
+		}
+		case JsonType::object:
+		{
+			JsonValue result = JsonValue::object();
+			for (size_t i = 0; i < node->count; i++)
+				result.properties()[key(i).str()] = JsonNode(&node->members[i].value).to_value();
+			return result;
+		}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonDocument::JsonDocument()
+	{
+	}
+
+	JsonDocument JsonDocument::parse(const std::string &json)
+	{
+		return parse(json.data(), json.length());
+	}
+
+	JsonDocument JsonDocument::parse(const DataBuffer &json)
+	{
+		return parse(json.get_data(), json.get_size());
+	}
+
+	JsonDocument JsonDocument::parse(const char *json, size_t length)
+	{
+		JsonDocument document;
+		document.impl = std::make_shared<JsonDocument_Impl>();
+		document.impl->parse(DataBuffer(json, length), length);
+		return document;
+	}
+
+	JsonDocument JsonDocument::parse(IODevice &device)
+	{
+		DataBuffer text(64 * 1024);
+		size_t size = 0;
+		while (true)
+		{
+			if (size == text.get_size())
+				text.set_size(text.get_size() * 2);
+			size_t received = device.read(text.get_data() + size, text.get_size() - size, false);
+			if (received == 0)
+				break;
+			size += received;
+		}
+
+		JsonDocument document;
+		document.impl = std::make_shared<JsonDocument_Impl>();
+		document.impl->parse(text, size);
+		return document;
+	}
+
+	void JsonDocument::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("JsonDocument is null");
+	}
+
+	JsonNode JsonDocument::root() const
+	{
+		return impl ? JsonNode(&impl->root) : JsonNode();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void JsonDocument_Impl::parse(const DataBuffer &new_text, size_t length)
+	{
+		text = new_text;
+
+		JsonDocumentBuilder builder(allocator);
+		JsonParser<JsonDocumentBuilder> parser(builder, text.get_data(), length, true);
+		parser.parse();
+		root = builder.get_root();
+	}
+}
@@ -0,0 +1,585 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/JSON/json_value.h"
+#include "API/Core/IOData/iodevice.h"
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Iterative JSON parser calling a handler for every value
+	///
+	/// The handler receives null_value, boolean_value, number_value, string_value, begin_object,
+	/// object_key, end_object, begin_array and end_array. Strings are passed as pointer and length
+	/// and are only valid during the call.
+	///
+	/// In memory mode with in_situ set, escaped strings are decoded in place in the input.
+	/// Otherwise they are decoded into a scratch buffer. In stream mode, the input is read in
+	/// blocks into a buffer that only grows if a single string or number is larger than a block.
+	template<typename Handler>
+	class JsonParser
+	{
+	public:
+		JsonParser(Handler &handler, const char *data, size_t size, bool in_situ) : handler(handler), data(const_cast<char*>(data)), size(size), in_situ(in_situ)
+		{
+		}
+
+		JsonParser(Handler &handler, IODevice &device) : handler(handler), device(&device), in_situ(true)
+		{
+			buffer.resize(block_size);
+			data = buffer.data();
+		}
+
+		void parse()
+		{
+			bool expect_value = true;
+			while (true)
+			{
+				if (expect_value)
+				{
+					skip_whitespace();
+					switch (peek())
+					{
+					case '{':
+						pos++;
+						handler.begin_object();
+						skip_whitespace();
+						if (peek() == '}')
+						{
+							pos++;
+							handler.end_object();
+							expect_value = false;
+						}
+						else
+						{
+							containers.push_back('{');
+							read_key();
+						}
+						break;
+					case '[':
+						pos++;
+						handler.begin_array();
+						skip_whitespace();
+						if (peek() == ']')
+						{
+							pos++;
+							handler.end_array();
+							expect_value = false;
+						}
+						else
+						{
+							containers.push_back('[');
+						}
+						break;
+					case '"':
+						read_string();
+						handler.string_value(string_data, string_length);
+						expect_value = false;
+						break;
+					case 't':
+						read_literal("true", 4);
+						handler.boolean_value(true);
+						expect_value = false;
+						break;
+					case 'f':
+						read_literal("false", 5);
+						handler.boolean_value(false);
+						expect_value = false;
+						break;
+					case 'n':
+						read_literal("null", 4);
+						handler.null_value();
+						expect_value = false;
+						break;
+					default:
+						handler.number_value(read_number());
+						expect_value = false;
+						break;
+					}
+				}
+				else
+				{
+					if (containers.empty())
+					{
+						// Only whitespace may follow the top-level value
+						skip_whitespace();
+						if (pos < size || fill(1))
+							throw JsonException("Unexpected character in JSON data");
+						return;
+					}
+
+					skip_whitespace();
+					char c = peek();
+					if (c == ',')
+					{
+						pos++;
+						if (containers.back() == '{')
+						{
+							skip_whitespace();
+							read_key();
+						}
+						expect_value = true;
+					}
+					else if (c == '}' && containers.back() == '{')
+					{
+						pos++;
+						containers.pop_back();
+						handler.end_object();
+					}
+					else if (c == ']' && containers.back() == '[')
+					{
+						pos++;
+						containers.pop_back();
+						handler.end_array();
+					}
+					else
+					{
+						throw JsonException("Unexpected character in JSON data");
+					}
+				}
+			}
+		}
+
+	private:
+		static bool is_whitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f'; }
+		static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+		static bool is_control(char c) { return (unsigned char)c < 0x20; }
+
+		static int first_bit(unsigned int mask)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (int)index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+
+		char peek()
+		{
+			if (pos == size && !fill(1))
+				throw JsonException("Unexpected end of JSON data");
+			return data[pos];
+		}
+
+		// Makes count bytes from pos available. Returns false if the input ends before that
+		bool fill(size_t count)
+		{
+			if (size - pos >= count)
+				return true;
+			if (!device)
+				return false;
+
+			// Keep the unread part, which may be a partially read string or number
+			size_t remaining = size - pos;
+			if (buffer.size() < count + block_size)
+				buffer.resize(count + block_size);
+			memmove(buffer.data(), data + pos, remaining);
+			data = buffer.data();
+			pos = 0;
+			size = remaining;
+
+			while (size < count)
+			{
+				size_t received = device->read(data + size, buffer.size() - size, false);
+				if (received == 0)
+					return false;
+				size += received;
+			}
+			return true;
+		}
+
+		void skip_whitespace()
+		{
+			while (true)
+			{
+				// Compact JSON mostly has no whitespace at all
+				if (pos < size && !is_whitespace(data[pos]))
+					return;
+
+#ifndef CL_DISABLE_SSE2
+				const __m128i space = _mm_set1_epi8(' ');
+				const __m128i newline = _mm_set1_epi8('\n');
+				const __m128i carriage_return = _mm_set1_epi8('\r');
+				const __m128i tab = _mm_set1_epi8('\t');
+				const __m128i form_feed = _mm_set1_epi8('\f');
+				while (size - pos >= 16)
+				{
+					__m128i chars = _mm_loadu_si128((const __m128i*)(data + pos));
+					__m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, space), _mm_cmpeq_epi8(chars, newline)), _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, carriage_return), _mm_cmpeq_epi8(chars, tab)), _mm_cmpeq_epi8(chars, form_feed)));
+					unsigned int mask = ~_mm_movemask_epi8(whitespace) & 0xffff;
+					if (mask)
+					{
+						pos += first_bit(mask);
+						return;
+					}
+					pos += 16;
+				}
+#endif
+				while (pos < size)
+				{
+					if (!is_whitespace(data[pos]))
+						return;
+					pos++;
+				}
+
+				if (!fill(1))
+					return;
+			}
+		}
+
+		void read_key()
+		{
+			if (peek() != '"')
+				throw JsonException("Unexpected character in JSON data");
+			read_string();
+			handler.object_key(string_data, string_length);
+
+			skip_whitespace();
+			if (peek() != ':')
+				throw JsonException("Unexpected character in JSON data");
+			pos++;
+		}
+
+		void read_literal(const char *literal, size_t length)
+		{
+			if (!fill(length) || memcmp(data + pos, literal, length) != 0)
+				throw JsonException("Unexpected character in JSON data");
+			pos += length;
+		}
+
+		// Reads the string at pos into string_data and string_length
+		void read_string()
+		{
+			// Offsets are relative to the opening quote, as filling the buffer may move it
+			size_t offset = 1;
+			bool escaped = false;
+			while (true)
+			{
+#ifndef CL_DISABLE_SSE2
+				const __m128i quote = _mm_set1_epi8('"');
+				const __m128i backslash = _mm_set1_epi8('\\');
+				const __m128i last_control = _mm_set1_epi8(0x1f);
+				while (size - pos - offset >= 16)
+				{
+					__m128i chars = _mm_loadu_si128((const __m128i*)(data + pos + offset));
+					__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chars, last_control), chars);
+					unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)), control));
+					if (mask)
+					{
+						offset += first_bit(mask);
+						break;
+					}
+					offset += 16;
+				}
+#endif
+				while (pos + offset < size && data[pos + offset] != '"' && data[pos + offset] != '\\' && !is_control(data[pos + offset]))
+					offset++;
+
+				if (pos + offset == size)
+				{
+					if (!fill(offset + 1))
+						throw JsonException("Unexpected end of JSON data");
+					continue;
+				}
+
+				if (data[pos + offset] == '"')
+					break;
+
+				// Control characters must be escaped inside strings
+				if (is_control(data[pos + offset]))
+					throw JsonException("Unexpected character in JSON data");
+
+				// Skip the escape sequence so an escaped quote does not end the string
+				escaped = true;
+				if (!fill(offset + 2))
+					throw JsonException("Unexpected end of JSON data");
+				offset += data[pos + offset + 1] == 'u' ? 6 : 2;
+				if (!fill(offset))
+					throw JsonException("Unexpected end of JSON data");
+			}
+
+			char *begin = data + pos + 1;
+			size_t length = offset - 1;
+			pos += offset + 1;
+
+			if (!escaped)
+			{
+				string_data = begin;
+				string_length = length;
+			}
+			else if (in_situ)
+			{
+				string_data = begin;
+				string_length = unescape(begin, length, begin);
+			}
+			else
+			{
+				scratch.resize(length);
+				string_data = scratch.data();
+				string_length = unescape(begin, length, &scratch[0]);
+			}
+		}
+
+		static unsigned int read_hex4(const char *src)
+		{
+			unsigned int value = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				char c = src[i];
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					value |= c - 'A' + 10;
+				else
+					throw JsonException("Invalid unicode escape");
+			}
+			return value;
+		}
+
+		// Decodes escape sequences. The output is never longer than the input, so src and dest may be the same
+		static size_t unescape(const char *src, size_t length, char *dest)
+		{
+			const char *end = src + length;
+			char *out = dest;
+			while (src != end)
+			{
+				if (*src != '\\')
+				{
+					*(out++) = *(src++);
+					continue;
+				}
+
+				src++;
+				switch (*(src++))
+				{
+				case '"': *(out++) = '"'; break;
+				case '\\': *(out++) = '\\'; break;
+				case '/': *(out++) = '/'; break;
+				case 'b': *(out++) = '\b'; break;
+				case 'f': *(out++) = '\f'; break;
+				case 'n': *(out++) = '\n'; break;
+				case 'r': *(out++) = '\r'; break;
+				case 't': *(out++) = '\t'; break;
+				case 'u':
+				{
+					unsigned int codepoint = read_hex4(src);
+					src += 4;
+
+					// Combine UTF-16 surrogate pairs
+					if (codepoint >= 0xd800 && codepoint < 0xdc00 && end - src >= 6 && src[0] == '\\' && src[1] == 'u')
+					{
+						unsigned int low = read_hex4(src + 2);
+						if (low >= 0xdc00 && low < 0xe000)
+						{
+							codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+							src += 6;
+						}
+					}
+
+					if (codepoint < 0x80)
+					{
+						*(out++) = (char)codepoint;
+					}
+					else if (codepoint < 0x800)
+					{
+						*(out++) = (char)(0xc0 | (codepoint >> 6));
+						*(out++) = (char)(0x80 | (codepoint & 0x3f));
+					}
+					else if (codepoint < 0x10000)
+					{
+						*(out++) = (char)(0xe0 | (codepoint >> 12));
+						*(out++) = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+						*(out++) = (char)(0x80 | (codepoint & 0x3f));
+					}
+					else
+					{
+						*(out++) = (char)(0xf0 | (codepoint >> 18));
+						*(out++) = (char)(0x80 | ((codepoint >> 12) & 0x3f));
+						*(out++) = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+						*(out++) = (char)(0x80 | (codepoint & 0x3f));
+					}
+					break;
+				}
+				default:
+					throw JsonException("Unexpected character in JSON data");
+				}
+			}
+			return out - dest;
+		}
+
+		double read_number()
+		{
+			// Find the end of the number first, so that it is contiguous in the buffer
+			size_t length = 0;
+			while (true)
+			{
+				while (pos + length < size)
+				{
+					char c = data[pos + length];
+					if (!is_digit(c) && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E')
+						break;
+					length++;
+				}
+				if (pos + length < size || !fill(length + 1))
+					break;
+			}
+
+			const char *src = data + pos;
+			const char *end = src + length;
+
+			bool negative = false;
+			if (src != end && *src == '-')
+			{
+				negative = true;
+				src++;
+			}
+			if (src == end || !is_digit(*src))
+				throw JsonException("Unexpected character in JSON data");
+
+			// Up to 19 significant digits fit in the mantissa. Leading zeros are not significant
+			unsigned long long mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			bool truncated = false;
+			while (src != end && is_digit(*src))
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + (*src - '0');
+					if (mantissa)
+						digits++;
+				}
+				else
+				{
+					exponent++;
+					truncated = true;
+				}
+				src++;
+			}
+
+			if (src != end && *src == '.')
+			{
+				src++;
+				if (src == end || !is_digit(*src))
+					throw JsonException("Unexpected character in JSON data");
+				while (src != end && is_digit(*src))
+				{
+					if (digits < 19)
+					{
+						mantissa = mantissa * 10 + (*src - '0');
+						if (mantissa)
+							digits++;
+						exponent--;
+					}
+					else
+					{
+						truncated = true;
+					}
+					src++;
+				}
+			}
+
+			if (src != end && (*src == 'e' || *src == 'E'))
+			{
+				src++;
+				bool negative_exponent = false;
+				if (src != end && (*src == '+' || *src == '-'))
+				{
+					negative_exponent = *src == '-';
+					src++;
+				}
+				if (src == end || !is_digit(*src))
+					throw JsonException("Unexpected character in JSON data");
+				int value = 0;
+				while (src != end && is_digit(*src))
+				{
+					if (value < 100000)
+						value = value * 10 + (*src - '0');
+					src++;
+				}
+				exponent += negative_exponent ? -value : value;
+			}
+
+			if (src != end)
+				throw JsonException("Unexpected character in JSON data");
+
+			double result;
+			if (mantissa == 0)
+			{
+				result = 0.0;
+			}
+			else if (!truncated && digits <= 15 && exponent >= -22 && exponent <= 22)
+			{
+				// Both the mantissa and the power of ten are exact doubles, so one operation rounds correctly
+				static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+				result = exponent >= 0 ? (double)mantissa * powers[exponent] : (double)mantissa / powers[-exponent];
+			}
+			else
+			{
+				std::string number(data + pos, length);
+				result = std::strtod(number.c_str(), nullptr);
+				negative = false;
+			}
+
+			pos += length;
+			return negative ? -result : result;
+		}
+
+		static const size_t block_size = 64 * 1024;
+
+		Handler &handler;
+		IODevice *device = nullptr;
+		std::vector<char> buffer;
+		char *data = nullptr;
+		size_t size = 0;
+		size_t pos = 0;
+		bool in_situ = false;
+
+		std::vector<char> containers;
+		std::string scratch;
+		const char *string_data = nullptr;
+		size_t string_length = 0;
+	};
+}
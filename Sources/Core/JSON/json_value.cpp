@@ -244,6 +244,11 @@ namespace clan
 		case 'f':
 		case 't':
 			return read_boolean(json, pos);
+		case 'n':
+			if (pos + 4 > json.length() || memcmp(&json[pos], "null", 4) != 0)
+				throw JsonException("Unexpected character in JSON data");
+			pos += 4;
+			return JsonValue::null();
 		default:
 			throw JsonException("Unexpected character in JSON data");
 		}
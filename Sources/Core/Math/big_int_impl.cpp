@@ -47,8 +47,10 @@
 
 #include "Core/precomp.h"
 #include "big_int_impl.h"
+#include "big_int_limbs.h"
 #include "API/Core/Math/big_int.h"
 #include <cstdlib>
+#include <algorithm>
 
 namespace clan
 {
@@ -1320,6 +1322,12 @@ namespace clan
 		const uint32_t *pb;
 		uint32_t *pt, *pbt;
 
+		if (internal_use_karatsuba(ua, ub))
+		{
+			internal_mul_karatsuba(b);
+			return;
+		}
+
 		BigInt_Impl tmp_impl(ua + ub);
 
 		// This has the effect of left-padding with zeroes...
@@ -1510,6 +1518,12 @@ namespace clan
 		unsigned int  ix, jx, kx, used = digits_used;
 		uint32_t *pa1, *pa2, *pt, *pbt;
 
+		if (internal_use_karatsuba(used, used))
+		{
+			internal_mul_karatsuba(this);
+			return;
+		}
+
 		BigInt_Impl tmp_impl( 2 * used);
 
 		// Left-pad with zeroes
@@ -1599,6 +1613,174 @@ namespace clan
 		tmp_impl.internal_exch(this);
 	}
 
+	bool BigInt_Impl::internal_use_karatsuba(unsigned int ua, unsigned int ub) const
+	{
+		// Both operands are padded to the size of the largest, so they must be of similar size
+		unsigned int threshold = 2 * BigInt_Limbs::karatsuba_threshold;
+		return ua >= threshold && ub >= threshold && ua <= 2 * ub && ub <= 2 * ua;
+	}
+
+	void BigInt_Impl::internal_mul_karatsuba(const BigInt_Impl *b)
+	{
+		// Compute a = |a| * |b|
+		unsigned int n = (std::max(digits_used, b->digits_used) + 1) / 2;
+		std::vector<uint64_t> limbs(4 * n + BigInt_Limbs::scratch_size(n));
+		uint64_t *la = limbs.data();
+		uint64_t *lb = la + n;
+		uint64_t *product = lb + n;
+		uint64_t *scratch = product + 2 * n;
+
+		internal_to_limbs(la, n);
+		if (b == this)
+		{
+			BigInt_Limbs::sqr(product, la, n, scratch);
+		}
+		else
+		{
+			b->internal_to_limbs(lb, n);
+			BigInt_Limbs::mul(product, la, lb, n, scratch);
+		}
+
+		bool negative = digits_negative;
+		internal_from_limbs(product, 2 * n);
+		digits_negative = negative;
+	}
+
+	void BigInt_Impl::internal_to_limbs(uint64_t *limbs, unsigned int num_limbs) const
+	{
+		for (unsigned int i = 0; i < num_limbs; i++)
+		{
+			uint64_t low = 2 * i < digits_used ? digits[2 * i] : 0;
+			uint64_t high = 2 * i + 1 < digits_used ? digits[2 * i + 1] : 0;
+			limbs[i] = low | (high << num_bits_in_digit);
+		}
+	}
+
+	void BigInt_Impl::internal_from_limbs(const uint64_t *limbs, unsigned int num_limbs)
+	{
+		zero();
+		internal_pad(2 * num_limbs);
+		for (unsigned int i = 0; i < num_limbs; i++)
+		{
+			digits[2 * i] = (uint32_t)limbs[i];
+			digits[2 * i + 1] = (uint32_t)(limbs[i] >> num_bits_in_digit);
+		}
+		internal_clamp();
+	}
+
+	void BigInt_Impl::internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const
+	{
+		// Montgomery multiplication replaces the division of each modular reduction with multiplications
+		// by working on x * R mod m, where R = 2^(64n) and n is the number of limbs of the modulus.
+		// The exponent is processed from the top using a sliding window over a table of odd powers.
+
+		unsigned int n = (m->digits_used + 1) / 2;
+
+		BigInt_Impl x(*this);
+		x.mod(m, &x);
+
+		// R^2 mod m, for converting into Montgomery form
+		BigInt_Impl r_squared;
+		r_squared.set((uint32_t)1);
+		r_squared.internal_lshd(4 * n);
+		r_squared.mod(m, &r_squared);
+
+		int exponent_bits = b->significant_bits();
+		int window_bits = 1;
+		if (exponent_bits > 671)
+			window_bits = 6;
+		else if (exponent_bits > 239)
+			window_bits = 5;
+		else if (exponent_bits > 79)
+			window_bits = 4;
+		else if (exponent_bits > 23)
+			window_bits = 3;
+		int table_size = 1 << (window_bits - 1);
+
+		std::vector<uint64_t> limbs((5 + table_size) * n + BigInt_Limbs::scratch_size(n));
+		uint64_t *modulus = limbs.data();
+		uint64_t *product = modulus + n;
+		uint64_t *result = product + 2 * n;
+		uint64_t *value = result + n;
+		uint64_t *table = value + n;
+		uint64_t *scratch = table + table_size * n;
+
+		m->internal_to_limbs(modulus, n);
+		uint64_t inverse = BigInt_Limbs::montgomery_inverse(modulus[0]);
+
+		auto montgomery_mul = [&](uint64_t *out, const uint64_t *a, const uint64_t *b)
+		{
+			if (a == b)
+				BigInt_Limbs::sqr(product, a, n, scratch);
+			else
+				BigInt_Limbs::mul(product, a, b, n, scratch);
+			BigInt_Limbs::montgomery_reduce(out, product, modulus, n, inverse);
+		};
+
+		// table[i] = x^(2i + 1) * R mod m
+		x.internal_to_limbs(value, n);
+		r_squared.internal_to_limbs(result, n);
+		montgomery_mul(table, value, result);
+		if (table_size > 1)
+		{
+			montgomery_mul(value, table, table);
+			for (int i = 1; i < table_size; i++)
+				montgomery_mul(table + i * n, table + (i - 1) * n, value);
+		}
+
+		// result = 1 * R mod m
+		memset(product, 0, 2 * n * sizeof(uint64_t));
+		r_squared.internal_to_limbs(product, n);
+		BigInt_Limbs::montgomery_reduce(result, product, modulus, n, inverse);
+
+		auto exponent_bit = [&](int bit) -> unsigned int
+		{
+			return (b->digits[bit / num_bits_in_digit] >> (bit % num_bits_in_digit)) & 1;
+		};
+
+		bool started = false;
+		int bit = exponent_bits - 1;
+		while (bit >= 0)
+		{
+			if (!exponent_bit(bit))
+			{
+				if (started)
+					montgomery_mul(result, result, result);
+				bit--;
+				continue;
+			}
+
+			// Longest window of at most window_bits that ends with a set bit
+			int low_bit = std::max(bit - window_bits + 1, 0);
+			while (!exponent_bit(low_bit))
+				low_bit++;
+
+			unsigned int window = 0;
+			for (int i = bit; i >= low_bit; i--)
+				window = (window << 1) | exponent_bit(i);
+
+			const uint64_t *power = table + (window >> 1) * n;
+			if (started)
+			{
+				for (int i = bit; i >= low_bit; i--)
+					montgomery_mul(result, result, result);
+				montgomery_mul(result, result, power);
+			}
+			else
+			{
+				memcpy(result, power, n * sizeof(uint64_t));
+				started = true;
+			}
+			bit = low_bit - 1;
+		}
+
+		// Convert out of Montgomery form
+		memset(product, 0, 2 * n * sizeof(uint64_t));
+		memcpy(product, result, n * sizeof(uint64_t));
+		BigInt_Limbs::montgomery_reduce(result, product, modulus, n, inverse);
+		c->internal_from_limbs(result, n);
+	}
+
 	void BigInt_Impl::exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const
 	{
 		BigInt_Impl s, mu;
@@ -1611,6 +1793,12 @@ namespace clan
 		if (b->cmp_z() < 0 || m->cmp_z() <= 0)
 			throw Exception("Divide by zero");
 
+		if (m->isodd())
+		{
+			internal_exptmod_montgomery(b, m, c);
+			return;
+		}
+
 		BigInt_Impl x(*this);
 
 		x.mod(m, &x);
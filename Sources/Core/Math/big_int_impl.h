@@ -168,6 +168,15 @@ namespace clan
 		void internal_reduce(const BigInt_Impl *m, BigInt_Impl *mu);
 		void internal_sqr();
 
+		// Karatsuba multiplication and squaring using 64 bit limbs, for large operands
+		bool internal_use_karatsuba(unsigned int ua, unsigned int ub) const;
+		void internal_mul_karatsuba(const BigInt_Impl *b);
+
+		// Modular exponentiation for odd moduli using Montgomery multiplication and a sliding window
+		void internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const;
+		void internal_to_limbs(uint64_t *limbs, unsigned int num_limbs) const;
+		void internal_from_limbs(const uint64_t *limbs, unsigned int num_limbs);
+
 		bool digits_negative;	// True if the value is negative
 		unsigned int digits_alloc;		// How many digits allocated
 		unsigned int digits_used;		// How many digits used
@@ -0,0 +1,296 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "big_int_limbs.h"
+#include <algorithm>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		typedef BigInt_Limbs::Limb Limb;
+
+		// Returns the low half of a * b and stores the high half in high
+		inline Limb mul_limb(Limb a, Limb b, Limb &high)
+		{
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 product = (unsigned __int128)a * b;
+			high = (Limb)(product >> 64);
+			return (Limb)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+			return _umul128(a, b, &high);
+#else
+			uint64_t a_low = (uint32_t)a, a_high = a >> 32;
+			uint64_t b_low = (uint32_t)b, b_high = b >> 32;
+			uint64_t low_low = a_low * b_low;
+			uint64_t high_low = a_high * b_low;
+			uint64_t low_high = a_low * b_high;
+			uint64_t high_high = a_high * b_high;
+			uint64_t middle = (low_low >> 32) + (uint32_t)high_low + (uint32_t)low_high;
+			high = high_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+			return (middle << 32) | (uint32_t)low_low;
+#endif
+		}
+
+		// out[0..n) += a[0..n) * b, returns the carry out
+		inline Limb mul_add_row(Limb *out, const Limb *a, int n, Limb b)
+		{
+			Limb carry = 0;
+			for (int i = 0; i < n; i++)
+			{
+				Limb high;
+				Limb low = mul_limb(a[i], b, high);
+				low += carry;
+				high += low < carry;
+				low += out[i];
+				high += low < out[i];
+				out[i] = low;
+				carry = high;
+			}
+			return carry;
+		}
+
+		// out[0..n) = a + b, returns the carry out
+		inline Limb add_limbs(Limb *out, const Limb *a, const Limb *b, int n)
+		{
+			Limb carry = 0;
+			for (int i = 0; i < n; i++)
+			{
+				Limb sum = a[i] + carry;
+				carry = sum < carry;
+				sum += b[i];
+				carry += sum < b[i];
+				out[i] = sum;
+			}
+			return carry;
+		}
+
+		// out[0..n) = a - b, returns the borrow out
+		inline Limb sub_limbs(Limb *out, const Limb *a, const Limb *b, int n)
+		{
+			Limb borrow = 0;
+			for (int i = 0; i < n; i++)
+			{
+				Limb value = a[i];
+				Limb difference = value - b[i] - borrow;
+				borrow = (value < b[i]) || (value == b[i] && borrow);
+				out[i] = difference;
+			}
+			return borrow;
+		}
+
+		// Adds carry to out[0..n), returns the carry out
+		inline Limb propagate_carry(Limb *out, int n, Limb carry)
+		{
+			for (int i = 0; carry && i < n; i++)
+			{
+				out[i] += carry;
+				carry = out[i] < carry;
+			}
+			return carry;
+		}
+
+		// out[0..h) = |a[0..h) - b[0..l)| with l <= h, returns true if a < b
+		bool abs_difference(Limb *out, const Limb *a, int h, const Limb *b, int l)
+		{
+			Limb borrow = sub_limbs(out, a, b, l);
+			for (int i = l; i < h; i++)
+			{
+				out[i] = a[i] - borrow;
+				borrow = a[i] < borrow;
+			}
+
+			if (borrow)
+			{
+				// Two's complement negation
+				Limb carry = 1;
+				for (int i = 0; i < h; i++)
+				{
+					out[i] = ~out[i] + carry;
+					carry = carry && out[i] == 0;
+				}
+			}
+			return borrow != 0;
+		}
+	}
+
+	int BigInt_Limbs::scratch_size(int n)
+	{
+		int size = 0;
+		while (n >= karatsuba_threshold)
+		{
+			int h = (n + 1) / 2;
+			size += 6 * h + 1;
+			n = h;
+		}
+		return size;
+	}
+
+	void BigInt_Limbs::mul(Limb *out, const Limb *a, const Limb *b, int n, Limb *scratch)
+	{
+		if (n < karatsuba_threshold)
+			mul_schoolbook(out, a, n, b, n);
+		else
+			karatsuba(out, a, b, n, scratch);
+	}
+
+	void BigInt_Limbs::sqr(Limb *out, const Limb *a, int n, Limb *scratch)
+	{
+		if (n < karatsuba_threshold)
+			sqr_schoolbook(out, a, n);
+		else
+			karatsuba(out, a, a, n, scratch);
+	}
+
+	void BigInt_Limbs::mul_schoolbook(Limb *out, const Limb *a, int na, const Limb *b, int nb)
+	{
+		memset(out, 0, (na + nb) * sizeof(Limb));
+		for (int i = 0; i < nb; i++)
+			out[i + na] = mul_add_row(out + i, a, na, b[i]);
+	}
+
+	void BigInt_Limbs::sqr_schoolbook(Limb *out, const Limb *a, int n)
+	{
+		// Each product a[i] * a[j] with i < j appears twice in the square, so they are calculated once and doubled
+		memset(out, 0, 2 * n * sizeof(Limb));
+		for (int i = 0; i < n - 1; i++)
+			out[i + n] = mul_add_row(out + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+
+		Limb shifted_out = 0;
+		for (int i = 0; i < 2 * n; i++)
+		{
+			Limb value = out[i];
+			out[i] = (value << 1) | shifted_out;
+			shifted_out = value >> 63;
+		}
+
+		// Add the squares on the diagonal
+		Limb carry = 0;
+		for (int i = 0; i < n; i++)
+		{
+			Limb high;
+			Limb low = mul_limb(a[i], a[i], high);
+
+			low += carry;
+			high += low < carry;
+			out[2 * i] += low;
+			high += out[2 * i] < low;
+
+			out[2 * i + 1] += high;
+			carry = out[2 * i + 1] < high;
+		}
+	}
+
+	void BigInt_Limbs::karatsuba(Limb *out, const Limb *a, const Limb *b, int n, Limb *scratch)
+	{
+		// With a = a1 * B^h + a0 and b = b1 * B^h + b0:
+		// a * b = a1 * b1 * B^2h + (a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)) * B^h + a0 * b0
+		bool square = a == b;
+		int h = (n + 1) / 2;
+		int l = n - h;
+
+		Limb *difference_a = scratch;
+		Limb *difference_b = scratch + h;
+		Limb *difference_product = scratch + 2 * h;
+		Limb *middle = scratch + 4 * h;
+		Limb *next_scratch = scratch + 6 * h + 1;
+
+		if (square)
+		{
+			sqr(out, a, h, next_scratch);
+			sqr(out + 2 * h, a + h, l, next_scratch);
+		}
+		else
+		{
+			mul(out, a, b, h, next_scratch);
+			mul(out + 2 * h, a + h, b + h, l, next_scratch);
+		}
+
+		bool negative = abs_difference(difference_a, a, h, a + h, l);
+		if (square)
+		{
+			negative = false;
+			sqr(difference_product, difference_a, h, next_scratch);
+		}
+		else
+		{
+			negative = abs_difference(difference_b, b, h, b + h, l) != negative;
+			mul(difference_product, difference_a, difference_b, h, next_scratch);
+		}
+
+		// middle = a0 * b0 + a1 * b1 -/+ |a0 - a1| * |b0 - b1|
+		memcpy(middle, out, 2 * h * sizeof(Limb));
+		Limb carry = add_limbs(middle, middle, out + 2 * h, 2 * l);
+		middle[2 * h] = propagate_carry(middle + 2 * l, 2 * h - 2 * l, carry);
+		if (negative)
+			middle[2 * h] += add_limbs(middle, middle, difference_product, 2 * h);
+		else
+			middle[2 * h] -= sub_limbs(middle, middle, difference_product, 2 * h);
+
+		// The full product fits in 2n limbs, so anything carried past the end is zero
+		int middle_size = std::min(2 * h + 1, 2 * n - h);
+		carry = add_limbs(out + h, out + h, middle, middle_size);
+		propagate_carry(out + h + middle_size, 2 * n - h - middle_size, carry);
+	}
+
+	BigInt_Limbs::Limb BigInt_Limbs::montgomery_inverse(Limb m0)
+	{
+		// Newton iteration, each step doubles the number of correct low bits
+		Limb inverse = m0;
+		for (int i = 0; i < 5; i++)
+			inverse *= 2 - m0 * inverse;
+		return (Limb)0 - inverse;
+	}
+
+	void BigInt_Limbs::montgomery_reduce(Limb *out, Limb *t, const Limb *m, int n, Limb inverse)
+	{
+		Limb top_carry = 0;
+		for (int i = 0; i < n; i++)
+		{
+			Limb u = t[i] * inverse;
+			Limb carry = mul_add_row(t + i, m, n, u);
+
+			Limb sum = t[i + n] + carry;
+			Limb next_carry = sum < carry;
+			sum += top_carry;
+			next_carry += sum < top_carry;
+			t[i + n] = sum;
+			top_carry = next_carry;
+		}
+
+		// The result is less than 2m, so at most one subtraction is needed
+		Limb borrow = sub_limbs(out, t + n, m, n);
+		if (borrow && !top_carry)
+			memcpy(out, t + n, n * sizeof(Limb));
+	}
+}
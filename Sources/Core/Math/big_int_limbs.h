@@ -0,0 +1,71 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+
+namespace clan
+{
+	/// \brief Arithmetic on little endian arrays of 64 bit limbs
+	///
+	/// Used by BigInt_Impl for the operations where most of the time is spent: multiplication of
+	/// large numbers and the Montgomery multiplications of exptmod.
+	class BigInt_Limbs
+	{
+	public:
+		typedef uint64_t Limb;
+
+		/// \brief Operands of at least this many limbs are multiplied using Karatsuba
+		static const int karatsuba_threshold = 32;
+
+		/// \brief Number of limbs of scratch memory needed by mul() and sqr() for n limb operands
+		static int scratch_size(int n);
+
+		/// \brief out[0..2n) = a * b
+		static void mul(Limb *out, const Limb *a, const Limb *b, int n, Limb *scratch);
+
+		/// \brief out[0..2n) = a * a
+		static void sqr(Limb *out, const Limb *a, int n, Limb *scratch);
+
+		/// \brief out[0..na+nb) = a * b, using schoolbook multiplication
+		static void mul_schoolbook(Limb *out, const Limb *a, int na, const Limb *b, int nb);
+
+		/// \brief Returns -m^-1 mod 2^64 for an odd m0, the lowest limb of the modulus
+		static Limb montgomery_inverse(Limb m0);
+
+		/// \brief out[0..n) = t * R^-1 mod m, where R = 2^(64n)
+		///
+		/// t has 2n limbs, must be less than m * R and is overwritten.
+		static void montgomery_reduce(Limb *out, Limb *t, const Limb *m, int n, Limb inverse);
+
+	private:
+		static void sqr_schoolbook(Limb *out, const Limb *a, int n);
+		static void karatsuba(Limb *out, const Limb *a, const Limb *b, int n, Limb *scratch);
+	};
+}
@@ -54,6 +54,8 @@ namespace clan
 
 #define __cpuid(out, infoType)\
 	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
+#define __cpuidex(out, infoType, subleaf)\
+	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subleaf));
 #else
 
 #define __cpuid(out, infoType) \
@@ -63,6 +65,13 @@ namespace clan
 			"popl %%ebx" \
 		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
 
+#define __cpuidex(out, infoType, subleaf) \
+	asm volatile(	"pushl %%ebx \n" \
+			"cpuid \n" \
+			"movl %%ebx, %1 \n" \
+			"popl %%ebx" \
+		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subleaf));
+
 #endif
 
 #endif
@@ -72,6 +81,35 @@ namespace clan
 		throw ("Congratulations, you've just been selected to code this feature!");
 	}
 
+	// Structured extended feature flags (leaf 7) are only valid if the CPU reports that leaf
+	static bool cpuid_leaf7(unsigned int cpuinfo[4])
+	{
+		__cpuid((int*)cpuinfo, 0x0);
+		if (cpuinfo[0] < 7)
+			return false;
+
+		__cpuidex((int*)cpuinfo, 0x7, 0x0);
+		return true;
+	}
+
+	// The OS must save the YMM registers on context switches before AVX instructions can be used
+	static bool os_supports_avx()
+	{
+		unsigned int cpuinfo[4] = { 0 };
+		__cpuid((int*)cpuinfo, 0x1);
+		if ((cpuinfo[2] & (1 << 27)) == 0)	// OSXSAVE
+			return false;
+
+#if (defined(WIN32) || defined(_WIN32) || defined(_WIN64)) && !defined __MINGW32__
+		unsigned long long xcr0 = _xgetbv(0);
+#else
+		unsigned int xcr0_low, xcr0_high;
+		asm volatile("xgetbv" : "=a" (xcr0_low), "=d" (xcr0_high) : "c" (0));
+		unsigned long long xcr0 = xcr0_low | ((unsigned long long)xcr0_high << 32);
+#endif
+		return (xcr0 & 6) == 6;
+	}
+
 	bool System::detect_cpu_extension(CPU_ExtensionX86 ext)
 	{
 		unsigned int cpuinfo[4] = { 0 };
@@ -181,6 +219,23 @@ namespace clan
 			__cpuid((int*)cpuinfo, 0x80000001);
 			return ((cpuinfo[2] & (1 << 16)) != 0);
 		}
+		else if (ext == pclmulqdq)
+		{
+			__cpuid((int*)cpuinfo, 0x1);
+			return ((cpuinfo[2] & (1 << 1)) != 0);
+		}
+		else if (ext == avx2)
+		{
+			if (!cpuid_leaf7(cpuinfo))
+				return false;
+			return ((cpuinfo[1] & (1 << 5)) != 0) && os_supports_avx();
+		}
+		else if (ext == sha)
+		{
+			if (!cpuid_leaf7(cpuinfo))
+				return false;
+			return ((cpuinfo[1] & (1 << 29)) != 0);
+		}
 		return false;
 	}
 
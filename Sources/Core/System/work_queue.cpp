@@ -33,7 +33,11 @@
 #include "API/Core/Math/cl_math.h"
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <deque>
 #include <condition_variable>
+#include <exception>
+#include <chrono>
 
 namespace clan
 {
@@ -60,6 +64,22 @@ namespace clan
 		std::function<void()> func;
 	};
 
+	class WorkQueueTask
+	{
+	public:
+		WorkQueueTask(WorkItem *item = nullptr, bool detached = false) : item(item), detached(detached) { }
+
+		WorkItem *item;
+		bool detached; // Detached items are deleted by the worker thread and never reach the work completed queue
+	};
+
+	class WorkQueueDeque
+	{
+	public:
+		std::mutex mutex;
+		std::deque<WorkQueueTask> tasks;
+	};
+
 	class WorkQueue_Impl
 	{
 	public:
@@ -67,23 +87,88 @@ namespace clan
 		~WorkQueue_Impl();
 
 		void queue(WorkItem *item); // transfers ownership
+		void queue_detached(WorkItem *item); // transfers ownership
 		void work_completed(WorkItem *item); // transfers ownership
 
 		int get_items_queued() const { return items_queued; }
+		int get_num_workers() const { return num_workers; }
 
 		void process_work_completed();
 
+		bool try_process_one();
+
 	private:
-		void worker_main();
+		void start_threads();
+		void push(const WorkQueueTask &task);
+		bool try_pop(int worker_index, WorkQueueTask &out_task);
+		void run_task(const WorkQueueTask &task);
+		void worker_main(int worker_index);
 
 		bool serial_queue = false;
+		int num_workers = 1;
+		std::once_flag threads_started;
 		std::vector<std::thread> threads;
-		std::mutex mutex;
+		std::vector<std::unique_ptr<WorkQueueDeque>> deques;
+		std::atomic_uint next_deque;
+		std::atomic_int pending_tasks;
+		std::atomic_int sleeping_workers;
+		std::atomic_bool stop_flag;
+		std::mutex sleep_mutex;
 		std::condition_variable worker_event;
-		bool stop_flag = false;
-		std::vector<WorkItem *> queued_items;
+		std::mutex finished_mutex;
 		std::vector<WorkItem *> finished_items;
 		std::atomic_int items_queued;
+
+		static thread_local WorkQueue_Impl *current_queue;
+		static thread_local int current_worker;
+	};
+
+	thread_local WorkQueue_Impl *WorkQueue_Impl::current_queue = nullptr;
+	thread_local int WorkQueue_Impl::current_worker = -1;
+
+	class WorkGroup_Impl
+	{
+	public:
+		WorkGroup_Impl(WorkQueue_Impl *queue) : queue(queue), pending(0) { }
+
+		void run(const std::shared_ptr<WorkGroup_Impl> &self, const std::function<void()> &func);
+		void then(const std::shared_ptr<WorkGroup_Impl> &self, const std::function<void()> &continuation);
+		void task_finished(const std::shared_ptr<WorkGroup_Impl> &self);
+		void task_failed(std::exception_ptr exception);
+		bool is_done();
+		void wait();
+
+		WorkQueue_Impl *queue;
+
+	private:
+		std::atomic_int pending;
+		std::mutex mutex;
+		std::condition_variable done_event;
+		std::vector<std::function<void()>> continuations;
+		std::exception_ptr first_exception;
+	};
+
+	class WorkItemGroupTask : public WorkItem
+	{
+	public:
+		WorkItemGroupTask(const std::shared_ptr<WorkGroup_Impl> &group, const std::function<void()> &func) : group(group), func(func) { }
+
+		void process_work() override
+		{
+			try
+			{
+				func();
+			}
+			catch (...)
+			{
+				group->task_failed(std::current_exception());
+			}
+			group->task_finished(group);
+		}
+
+	private:
+		std::shared_ptr<WorkGroup_Impl> group;
+		std::function<void()> func;
 	};
 
 	WorkQueue::WorkQueue(bool serial_queue)
@@ -95,6 +180,11 @@ namespace clan
 	{
 	}
 
+	int WorkQueue::get_num_workers() const
+	{
+		return impl->get_num_workers();
+	}
+
 	void WorkQueue::queue(WorkItem *item) // transfers ownership
 	{
 		impl->queue(item);
@@ -120,56 +210,198 @@ namespace clan
 		impl->process_work_completed();
 	}
 
+	void WorkQueue::parallel_for(int begin, int end, const std::function<void(int)> &func, int grain_size)
+	{
+		WorkGroup group(*this);
+		group.parallel_for(begin, end, func, grain_size);
+		group.wait();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	WorkGroup::WorkGroup(WorkQueue &queue)
+		: impl(std::make_shared<WorkGroup_Impl>(queue.impl.get())), queue_impl(queue.impl)
+	{
+	}
+
+	WorkGroup::~WorkGroup()
+	{
+		try
+		{
+			impl->wait();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WorkGroup::run(const std::function<void()> &func)
+	{
+		impl->run(impl, func);
+	}
+
+	void WorkGroup::parallel_for(int begin, int end, const std::function<void(int)> &func, int grain_size)
+	{
+		int count = end - begin;
+		if (count <= 0)
+			return;
+
+		int max_chunks = impl->queue->get_num_workers() * 4;
+		int num_chunks = clan::max(clan::min(count / clan::max(grain_size, 1), max_chunks), 1);
+		int chunk_size = (count + num_chunks - 1) / num_chunks;
+
+		auto shared_func = std::make_shared<std::function<void(int)>>(func);
+		for (int chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size)
+		{
+			int chunk_end = clan::min(chunk_begin + chunk_size, end);
+			impl->run(impl, [=]()
+			{
+				for (int i = chunk_begin; i < chunk_end; i++)
+					(*shared_func)(i);
+			});
+		}
+	}
+
+	void WorkGroup::then(const std::function<void()> &continuation)
+	{
+		impl->then(impl, continuation);
+	}
+
+	bool WorkGroup::is_done() const
+	{
+		return impl->is_done();
+	}
+
+	void WorkGroup::wait()
+	{
+		impl->wait();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void WorkGroup_Impl::run(const std::shared_ptr<WorkGroup_Impl> &self, const std::function<void()> &func)
+	{
+		++pending;
+		queue->queue_detached(new WorkItemGroupTask(self, func));
+	}
+
+	void WorkGroup_Impl::then(const std::shared_ptr<WorkGroup_Impl> &self, const std::function<void()> &continuation)
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		if (pending == 0)
+		{
+			++pending;
+			mutex_lock.unlock();
+			queue->queue_detached(new WorkItemGroupTask(self, continuation));
+		}
+		else
+		{
+			continuations.push_back(continuation);
+		}
+	}
+
+	void WorkGroup_Impl::task_finished(const std::shared_ptr<WorkGroup_Impl> &self)
+	{
+		if (--pending != 0)
+			return;
+
+		// The continuations must be moved into the queue while holding the lock, or a waiter could observe an idle group in between
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::vector<std::function<void()>> ready;
+		ready.swap(continuations);
+		pending += (int)ready.size();
+		mutex_lock.unlock();
+
+		if (ready.empty())
+			done_event.notify_all();
+
+		for (auto &continuation : ready)
+			queue->queue_detached(new WorkItemGroupTask(self, continuation));
+	}
+
+	void WorkGroup_Impl::task_failed(std::exception_ptr exception)
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		if (!first_exception)
+			first_exception = exception;
+	}
+
+	bool WorkGroup_Impl::is_done()
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		return pending == 0 && continuations.empty();
+	}
+
+	void WorkGroup_Impl::wait()
+	{
+		while (!is_done())
+		{
+			// Help out instead of blocking, so waiting from inside a worker thread cannot starve the pool
+			if (queue->try_process_one())
+				continue;
+
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			done_event.wait_for(mutex_lock, std::chrono::milliseconds(1), [&]() { return pending == 0 && continuations.empty(); });
+		}
+
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::exception_ptr exception = first_exception;
+		first_exception = std::exception_ptr();
+		mutex_lock.unlock();
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
 	/////////////////////////////////////////////////////////////////////////////
 
 	WorkQueue_Impl::WorkQueue_Impl(bool serial_queue)
-		: serial_queue(serial_queue)
+		: serial_queue(serial_queue), next_deque(0), pending_tasks(0), sleeping_workers(0), stop_flag(false), items_queued(0)
 	{
+		num_workers = serial_queue ? 1 : clan::max(System::get_num_cores() - 1, 1);
+		for (int i = 0; i < num_workers; i++)
+			deques.push_back(std::unique_ptr<WorkQueueDeque>(new WorkQueueDeque()));
 	}
 
 	WorkQueue_Impl::~WorkQueue_Impl()
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::unique_lock<std::mutex> mutex_lock(sleep_mutex);
 		stop_flag = true;
 		mutex_lock.unlock();
 		worker_event.notify_all();
 
 		for (auto & elem : threads)
 			elem.join();
-		for (auto & elem : queued_items)
-			delete elem;
+		for (auto & deque : deques)
+		{
+			for (auto & task : deque->tasks)
+				delete task.item;
+		}
 		for (auto & elem : finished_items)
 			delete elem;
 	}
 
 	void WorkQueue_Impl::queue(WorkItem *item) // transfers ownership
 	{
-		if (threads.empty())
-		{
-			int num_cores = serial_queue ? 1 : clan::max(System::get_num_cores() - 1, 1);
-			for (int i = 0; i < num_cores; i++)
-			{
-				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this));
-			}
-		}
-
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		queued_items.push_back(item);
 		++items_queued;
-		mutex_lock.unlock();
-		worker_event.notify_one();
+		push(WorkQueueTask(item, false));
+	}
+
+	void WorkQueue_Impl::queue_detached(WorkItem *item) // transfers ownership
+	{
+		push(WorkQueueTask(item, true));
 	}
 
 	void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::unique_lock<std::mutex> mutex_lock(finished_mutex);
 		finished_items.push_back(item);
 		++items_queued;
 	}
 
 	void WorkQueue_Impl::process_work_completed()
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::unique_lock<std::mutex> mutex_lock(finished_mutex);
 		std::vector<WorkItem *> items;
 		items.swap(finished_items);
 		mutex_lock.unlock();
@@ -190,25 +422,135 @@ namespace clan
 		}
 	}
 
-	void WorkQueue_Impl::worker_main()
+	bool WorkQueue_Impl::try_process_one()
+	{
+		// Items of a serial queue must only ever run on its worker thread, one after another.
+		// That thread only waits from inside an item, so helping would nest the next item inside it.
+		if (serial_queue)
+			return false;
+
+		int worker_index = current_queue == this ? current_worker : -1;
+
+		WorkQueueTask task;
+		if (!try_pop(worker_index, task))
+			return false;
+		run_task(task);
+		return true;
+	}
+
+	void WorkQueue_Impl::start_threads()
 	{
-		while (true)
+		std::call_once(threads_started, [&]()
 		{
-			std::unique_lock<std::mutex> mutex_lock(mutex);
-			worker_event.wait(mutex_lock, [&]() { return stop_flag || !queued_items.empty(); });
+			for (int i = 0; i < num_workers; i++)
+			{
+				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this, i));
+			}
+		});
+	}
 
-			if (stop_flag)
-				break;
+	void WorkQueue_Impl::push(const WorkQueueTask &task)
+	{
+		start_threads();
 
-			WorkItem *item = queued_items.front();
-			queued_items.erase(queued_items.begin());
-			mutex_lock.unlock();
+		// Work spawned by a worker stays on its own deque, everything else is spread round robin
+		int index = (current_queue == this) ? current_worker : (int)(next_deque++ % (unsigned int)num_workers);
 
-			item->process_work();
+		std::unique_lock<std::mutex> deque_lock(deques[index]->mutex);
+		deques[index]->tasks.push_back(task);
+		deque_lock.unlock();
 
-			mutex_lock.lock();
-			finished_items.push_back(item);
+		++pending_tasks;
+		if (sleeping_workers > 0)
+		{
+			std::unique_lock<std::mutex> mutex_lock(sleep_mutex);
 			mutex_lock.unlock();
+			worker_event.notify_one();
+		}
+	}
+
+	bool WorkQueue_Impl::try_pop(int worker_index, WorkQueueTask &out_task)
+	{
+		if (pending_tasks == 0)
+			return false;
+
+		// The owner takes the newest item from its own deque, unless the queue must preserve the queued order
+		if (worker_index != -1)
+		{
+			WorkQueueDeque *deque = deques[worker_index].get();
+			std::unique_lock<std::mutex> deque_lock(deque->mutex);
+			if (!deque->tasks.empty())
+			{
+				if (serial_queue)
+				{
+					out_task = deque->tasks.front();
+					deque->tasks.pop_front();
+				}
+				else
+				{
+					out_task = deque->tasks.back();
+					deque->tasks.pop_back();
+				}
+				--pending_tasks;
+				return true;
+			}
+		}
+
+		// Steal the oldest item from one of the other deques
+		int start = worker_index != -1 ? worker_index + 1 : 0;
+		for (int i = 0; i < num_workers; i++)
+		{
+			int victim = (start + i) % num_workers;
+			if (victim == worker_index)
+				continue;
+
+			WorkQueueDeque *deque = deques[victim].get();
+			std::unique_lock<std::mutex> deque_lock(deque->mutex);
+			if (!deque->tasks.empty())
+			{
+				out_task = deque->tasks.front();
+				deque->tasks.pop_front();
+				--pending_tasks;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void WorkQueue_Impl::run_task(const WorkQueueTask &task)
+	{
+		task.item->process_work();
+
+		if (task.detached)
+		{
+			delete task.item;
+		}
+		else
+		{
+			std::unique_lock<std::mutex> mutex_lock(finished_mutex);
+			finished_items.push_back(task.item);
+		}
+	}
+
+	void WorkQueue_Impl::worker_main(int worker_index)
+	{
+		current_queue = this;
+		current_worker = worker_index;
+
+		while (!stop_flag)
+		{
+			WorkQueueTask task;
+			if (try_pop(worker_index, task))
+			{
+				run_task(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> mutex_lock(sleep_mutex);
+			++sleeping_workers;
+			worker_event.wait(mutex_lock, [&]() { return stop_flag || pending_tasks > 0; });
+			--sleeping_workers;
 		}
 	}
 }
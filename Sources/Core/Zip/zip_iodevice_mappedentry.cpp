@@ -0,0 +1,107 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "zip_iodevice_mappedentry.h"
+#include "zip_mapped_archive_impl.h"
+#include "API/Core/Math/cl_math.h"
+
+namespace clan
+{
+	ZipIODevice_MappedEntry::ZipIODevice_MappedEntry(const std::shared_ptr<ZipMappedArchive_Impl> &archive, const char *data, size_t size)
+		: archive(archive), data(data), size(size)
+	{
+	}
+
+	ZipIODevice_MappedEntry::ZipIODevice_MappedEntry(const DataBuffer &buffer)
+		: buffer(buffer), data(buffer.get_data()), size(buffer.get_size())
+	{
+	}
+
+	size_t ZipIODevice_MappedEntry::get_size() const
+	{
+		return size;
+	}
+
+	size_t ZipIODevice_MappedEntry::get_position() const
+	{
+		return position;
+	}
+
+	size_t ZipIODevice_MappedEntry::send(const void *data, size_t len, bool send_all)
+	{
+		throw Exception("Read-only device.");
+	}
+
+	size_t ZipIODevice_MappedEntry::receive(void *recv_data, size_t len, bool receive_all)
+	{
+		len = peek(recv_data, len);
+		position += len;
+		return len;
+	}
+
+	size_t ZipIODevice_MappedEntry::peek(void *recv_data, size_t len)
+	{
+		len = min(len, size - position);
+		memcpy(recv_data, data + position, len);
+		return len;
+	}
+
+	bool ZipIODevice_MappedEntry::seek(int requested_position, IODevice::SeekMode mode)
+	{
+		int64_t new_position = 0;
+		switch (mode)
+		{
+		case IODevice::SeekMode::set:
+			new_position = requested_position;
+			break;
+		case IODevice::SeekMode::cur:
+			new_position = (int64_t)position + requested_position;
+			break;
+		case IODevice::SeekMode::end:
+			new_position = (int64_t)size + requested_position;
+			break;
+		default:
+			return false;
+		}
+
+		if (new_position < 0 || new_position > (int64_t)size)
+			return false;
+
+		position = (size_t)new_position;
+		return true;
+	}
+
+	IODeviceProvider *ZipIODevice_MappedEntry::duplicate()
+	{
+		if (archive)
+			return new ZipIODevice_MappedEntry(archive, data, size);
+		else
+			return new ZipIODevice_MappedEntry(buffer);
+	}
+}
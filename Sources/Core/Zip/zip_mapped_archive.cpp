@@ -0,0 +1,567 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Zip/zip_mapped_archive.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/IOData/path_help.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/Text/string_format.h"
+#include "API/Core/Text/string_help.h"
+#include "zip_mapped_archive_impl.h"
+#include "zip_iodevice_mappedentry.h"
+#include "zip_compression_method.h"
+#include "zip_file_entry_impl.h"
+#include "zip_flags.h"
+#include "Core/Zip/miniz.h"
+#include <algorithm>
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		inline uint16_t read_uint16(const char *p)
+		{
+			const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+			return b[0] | (b[1] << 8);
+		}
+
+		inline uint32_t read_uint32(const char *p)
+		{
+			const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+			return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+		}
+
+		inline uint64_t read_uint64(const char *p)
+		{
+			return read_uint32(p) | ((uint64_t)read_uint32(p + 4) << 32);
+		}
+
+		bool is_ascii(const char *text, size_t length)
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				if (text[i] & 0x80)
+					return false;
+			}
+			return true;
+		}
+
+		std::string strip_leading_slash(const std::string &filename)
+		{
+			return (!filename.empty() && filename[0] == '/') ? filename.substr(1) : filename;
+		}
+	}
+
+	ZipMappedArchive::ZipMappedArchive()
+	{
+	}
+
+	ZipMappedArchive::ZipMappedArchive(const std::string &filename) : impl(std::make_shared<ZipMappedArchive_Impl>(filename))
+	{
+	}
+
+	ZipMappedArchive::~ZipMappedArchive()
+	{
+	}
+
+	void ZipMappedArchive::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("ZipMappedArchive is null");
+	}
+
+	std::string ZipMappedArchive::get_filename() const
+	{
+		return impl->filename;
+	}
+
+	int ZipMappedArchive::get_file_count() const
+	{
+		return (int)impl->entries.size();
+	}
+
+	std::vector<ZipFileEntry> ZipMappedArchive::get_file_list(const std::string &dirpath) const
+	{
+		std::string path = dirpath;
+		if (path.empty())
+			path = "/";
+
+		// Entry names are stored without the leading slash
+		path = PathHelp::make_absolute("/", path, PathHelp::path_type_virtual);
+		path = PathHelp::add_trailing_slash(path, PathHelp::path_type_virtual);
+		path = strip_leading_slash(path);
+
+		std::vector<ZipFileEntry> files;
+		std::vector<std::string> added_directories;
+
+		for (const auto &entry : impl->entries)
+		{
+			if (entry.name_length < path.size() || memcmp(entry.name, path.data(), path.size()) != 0)
+				continue;
+
+			const char *name = entry.name + path.size();
+			size_t name_length = entry.name_length - path.size();
+			if (name_length == 0)
+				continue;
+
+			const char *subdir_slash = static_cast<const char *>(memchr(name, '/', name_length));
+			if (subdir_slash) // subdirectory or files in a subdirectory
+			{
+				std::string directory_name(name, subdir_slash);
+				if (std::find(added_directories.begin(), added_directories.end(), directory_name) == added_directories.end())
+				{
+					ZipFileEntry dir_entry;
+					dir_entry.set_archive_filename(directory_name);
+					dir_entry.set_directory(true);
+					files.push_back(dir_entry);
+
+					added_directories.push_back(directory_name);
+				}
+			}
+			else
+			{
+				ZipFileEntry file_entry;
+				file_entry.set_archive_filename(std::string(name, name_length));
+				files.push_back(file_entry);
+			}
+		}
+
+		return files;
+	}
+
+	bool ZipMappedArchive::has_file(const std::string &filename) const
+	{
+		return impl->find(filename) != -1;
+	}
+
+	int64_t ZipMappedArchive::get_file_size(const std::string &filename) const
+	{
+		int index = impl->find(filename);
+		return index != -1 ? (int64_t)impl->entries[index].uncompressed_size : -1;
+	}
+
+	const void *ZipMappedArchive::get_stored_data(const std::string &filename, size_t &out_size) const
+	{
+		out_size = 0;
+		int index = impl->find(filename);
+		if (index == -1 || impl->entries[index].compression_method != zip_compress_store)
+			return nullptr;
+
+		const ZipMappedArchive_Impl::Entry &entry = impl->entries[index];
+		out_size = (size_t)entry.uncompressed_size;
+		return impl->get_file_data(entry);
+	}
+
+	IODevice ZipMappedArchive::open_file(const std::string &filename) const
+	{
+		int index = impl->find(filename);
+		if (index == -1)
+			throw Exception(string_format("Unable to find zip index %1", filename));
+
+		const ZipMappedArchive_Impl::Entry &entry = impl->entries[index];
+		if (entry.compression_method == zip_compress_store)
+			return IODevice(new ZipIODevice_MappedEntry(impl, impl->get_file_data(entry), (size_t)entry.uncompressed_size));
+
+		DataBuffer buffer = impl->get_prefetched(index);
+		if (buffer.is_null())
+			buffer = impl->read_file(entry);
+		return IODevice(new ZipIODevice_MappedEntry(buffer));
+	}
+
+	DataBuffer ZipMappedArchive::read_file(const std::string &filename) const
+	{
+		int index = impl->find(filename);
+		if (index == -1)
+			throw Exception(string_format("Unable to find zip index %1", filename));
+
+		DataBuffer buffer = impl->get_prefetched(index);
+		if (buffer.is_null())
+			buffer = impl->read_file(impl->entries[index]);
+		return buffer;
+	}
+
+	void ZipMappedArchive::prefetch(const std::vector<std::string> &filenames, WorkQueue &queue)
+	{
+		std::vector<int> indexes;
+		{
+			std::unique_lock<std::mutex> lock(impl->mutex);
+			for (const auto &filename : filenames)
+			{
+				int index = impl->find(filename);
+				if (index == -1)
+					throw Exception(string_format("Unable to find zip index %1", filename));
+				if (impl->entries[index].compression_method != zip_compress_store && impl->prefetched.find(index) == impl->prefetched.end())
+					indexes.push_back(index);
+			}
+		}
+
+		ZipMappedArchive_Impl *archive = impl.get();
+		WorkGroup group(queue);
+		group.parallel_for(0, (int)indexes.size(), [&](int i)
+		{
+			DataBuffer buffer = archive->read_file(archive->entries[indexes[i]]);
+			std::unique_lock<std::mutex> lock(archive->mutex);
+			archive->prefetched[indexes[i]] = buffer;
+		});
+		group.wait();
+	}
+
+	void ZipMappedArchive::clear_prefetched()
+	{
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		impl->prefetched.clear();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	ZipMappedArchive_Impl::ZipMappedArchive_Impl(const std::string &filename) : filename(filename)
+	{
+		map_file();
+		try
+		{
+			load_central_directory();
+			build_index();
+		}
+		catch (...)
+		{
+			unmap_file();
+			throw;
+		}
+	}
+
+	ZipMappedArchive_Impl::~ZipMappedArchive_Impl()
+	{
+		unmap_file();
+	}
+
+	int ZipMappedArchive_Impl::find(const std::string &filename) const
+	{
+		const char *name = filename.data();
+		size_t length = filename.length();
+		if (length > 0 && name[0] == '/')
+		{
+			name++;
+			length--;
+		}
+
+		size_t mask = index.size() - 1;
+		for (size_t slot = hash(name, length) & mask; index[slot] != 0; slot = (slot + 1) & mask)
+		{
+			const Entry &entry = entries[index[slot] - 1];
+			if (entry.name_length == length && memcmp(entry.name, name, length) == 0)
+				return index[slot] - 1;
+		}
+		return -1;
+	}
+
+	const char *ZipMappedArchive_Impl::get_file_data(const Entry &entry) const
+	{
+		// Stored entries are returned directly from the mapping using their uncompressed size
+		if (entry.compression_method == zip_compress_store && entry.uncompressed_size != entry.compressed_size)
+			throw Exception("Stored zip file entry has different compressed and uncompressed sizes");
+
+		// The local header is only read when the file is used, as touching every header would page in the whole archive
+		if (size < 30 || entry.local_header_offset > size - 30 || read_uint32(data + entry.local_header_offset) != 0x04034b50)
+			throw Exception("Incorrect local file header signature");
+
+		const char *header = data + entry.local_header_offset;
+		uint64_t data_offset = entry.local_header_offset + 30 + read_uint16(header + 26) + read_uint16(header + 28);
+		if (data_offset > size || entry.compressed_size > size - data_offset)
+			throw Exception("Zip file entry extends past the end of the archive");
+		return data + data_offset;
+	}
+
+	DataBuffer ZipMappedArchive_Impl::read_file(const Entry &entry) const
+	{
+		const char *file_data = get_file_data(entry);
+		switch (entry.compression_method)
+		{
+		case zip_compress_store:
+			return DataBuffer(file_data, (size_t)entry.uncompressed_size);
+
+		case zip_compress_deflate:
+		{
+			DataBuffer buffer((size_t)entry.uncompressed_size);
+			size_t result = tinfl_decompress_mem_to_mem(buffer.get_data(), buffer.get_size(), file_data, (size_t)entry.compressed_size, 0);
+			if (result != buffer.get_size())
+				throw Exception(string_format("Zlib inflate failed while decompressing %1", std::string(entry.name, entry.name_length)));
+			return buffer;
+		}
+
+		default:
+			throw Exception(string_format("Unsupported compression method %1", entry.compression_method));
+		}
+	}
+
+	DataBuffer ZipMappedArchive_Impl::get_prefetched(int index)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto it = prefetched.find(index);
+		return it != prefetched.end() ? it->second : DataBuffer();
+	}
+
+	void ZipMappedArchive_Impl::map_file()
+	{
+#ifdef WIN32
+		file_handle = CreateFile(StringHelp::utf8_to_ucs2(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			throw Exception(string_format("Unable to open zip archive %1", filename));
+
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(file_handle, &file_size) == FALSE || file_size.QuadPart == 0)
+		{
+			unmap_file();
+			throw Exception(string_format("Unable to map zip archive %1", filename));
+		}
+		size = (size_t)file_size.QuadPart;
+
+		mapping_handle = CreateFileMapping(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle)
+			data = static_cast<const char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		if (!data)
+		{
+			unmap_file();
+			throw Exception(string_format("Unable to map zip archive %1", filename));
+		}
+#else
+		file_handle = open(filename.c_str(), O_RDONLY);
+		if (file_handle == -1)
+			throw Exception(string_format("Unable to open zip archive %1", filename));
+
+		struct stat file_stat;
+		if (fstat(file_handle, &file_stat) == -1 || file_stat.st_size == 0)
+		{
+			unmap_file();
+			throw Exception(string_format("Unable to map zip archive %1", filename));
+		}
+		size = (size_t)file_stat.st_size;
+
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, file_handle, 0);
+		if (mapping == MAP_FAILED)
+		{
+			unmap_file();
+			throw Exception(string_format("Unable to map zip archive %1", filename));
+		}
+		data = static_cast<const char *>(mapping);
+#endif
+	}
+
+	void ZipMappedArchive_Impl::unmap_file()
+	{
+#ifdef WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping_handle)
+			CloseHandle(mapping_handle);
+		if (file_handle != INVALID_HANDLE_VALUE)
+			CloseHandle(file_handle);
+		mapping_handle = nullptr;
+		file_handle = INVALID_HANDLE_VALUE;
+#else
+		if (data)
+			munmap(const_cast<char *>(data), size);
+		if (file_handle != -1)
+			close(file_handle);
+		file_handle = -1;
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
+	void ZipMappedArchive_Impl::load_central_directory()
+	{
+		// Find end of central directory record, which is followed by a comment of at most 64 KB:
+		if (size < 22)
+			throw Exception("This appear not to be a zip file");
+
+		size_t end_record_pos = std::string::npos;
+		size_t search_start = size > 22 + 0xffff ? size - 22 - 0xffff : 0;
+		for (size_t pos = size - 22 + 1; pos-- > search_start;)
+		{
+			if (read_uint32(data + pos) == 0x06054b50)
+			{
+				end_record_pos = pos;
+				break;
+			}
+		}
+		if (end_record_pos == std::string::npos)
+			throw Exception("This appear not to be a zip file");
+
+		const char *end_record = data + end_record_pos;
+		uint64_t num_entries = read_uint16(end_record + 10);
+		uint64_t directory_size = read_uint32(end_record + 12);
+		uint64_t directory_offset = read_uint32(end_record + 16);
+
+		// Look for zip64 central directory locator:
+		if (end_record_pos >= 20 && read_uint32(end_record - 20) == 0x07064b50)
+		{
+			uint64_t zip64_end_record_pos = read_uint64(end_record - 20 + 8);
+			if (size < 56 || zip64_end_record_pos > size - 56 || read_uint32(data + zip64_end_record_pos) != 0x06064b50)
+				throw Exception("Incorrect zip64 end of central directory signature");
+
+			const char *zip64_end_record = data + zip64_end_record_pos;
+			num_entries = read_uint64(zip64_end_record + 32);
+			directory_size = read_uint64(zip64_end_record + 40);
+			directory_offset = read_uint64(zip64_end_record + 48);
+		}
+
+		if (directory_size > size || directory_offset > size - directory_size)
+			throw Exception("Zip central directory extends past the end of the archive");
+
+		// Load central directory records:
+		//
+		// Archives written without zip64 records by some tools have more than 65535 entries with
+		// the count wrapped around, so all records in the central directory are loaded.
+		// The entry count comes from the file, so it is capped by how many 46 byte records fit in the directory.
+		entries.reserve((size_t)std::min(std::max(num_entries, directory_size / 80), directory_size / 46));
+		const char *pos = data + directory_offset;
+		const char *directory_end = pos + directory_size;
+		while (directory_end - pos >= 46 && read_uint32(pos) == 0x02014b50)
+		{
+
+			uint16_t name_length = read_uint16(pos + 28);
+			uint16_t extra_length = read_uint16(pos + 30);
+			uint16_t comment_length = read_uint16(pos + 32);
+			const char *name = pos + 46;
+			const char *extra = name + name_length;
+			const char *next = extra + extra_length + comment_length;
+			if (next > directory_end)
+				throw Exception("Incorrect File Header signature");
+
+			Entry entry;
+			entry.flags = read_uint16(pos + 8);
+			entry.compression_method = read_uint16(pos + 10);
+			entry.crc32 = read_uint32(pos + 16);
+			entry.compressed_size = read_uint32(pos + 20);
+			entry.uncompressed_size = read_uint32(pos + 24);
+			entry.local_header_offset = read_uint32(pos + 42);
+
+			// Sizes and offset that do not fit are stored in the zip64 extended information extra field,
+			// and names in the DOS code page may have a UTF-8 version in the Info-ZIP unicode path extra field:
+			const char *unicode_name = nullptr;
+			uint16_t unicode_name_length = 0;
+			for (const char *field = extra; field + 4 <= extra + extra_length;)
+			{
+				uint16_t field_id = read_uint16(field);
+				uint16_t field_size = read_uint16(field + 2);
+				const char *value = field + 4;
+				const char *field_end = value + field_size;
+				if (field_end > extra + extra_length)
+					break;
+
+				if (field_id == 0x7075 && field_size >= 5 && value[0] == 1)
+				{
+					unicode_name = value + 5;
+					unicode_name_length = field_size - 5;
+				}
+				else if (field_id == 0x0001)
+				{
+					if (entry.uncompressed_size == 0xffffffff && value + 8 <= field_end)
+					{
+						entry.uncompressed_size = read_uint64(value);
+						value += 8;
+					}
+					if (entry.compressed_size == 0xffffffff && value + 8 <= field_end)
+					{
+						entry.compressed_size = read_uint64(value);
+						value += 8;
+					}
+					if (entry.local_header_offset == 0xffffffff && value + 8 <= field_end)
+						entry.local_header_offset = read_uint64(value);
+				}
+				field = field_end;
+			}
+
+			// Names are used directly from the mapping, unless they have to be converted from the DOS code page
+			if (unicode_name)
+			{
+				entry.name = unicode_name;
+				entry.name_length = unicode_name_length;
+			}
+			else if (!(entry.flags & ZIP_USE_UTF8) && !is_ascii(name, name_length))
+			{
+				converted_names.push_back(StringHelp::cp437_to_text(std::string(name, name_length)));
+				entry.name = converted_names.back().data();
+				entry.name_length = (uint32_t)converted_names.back().length();
+			}
+			else
+			{
+				entry.name = name;
+				entry.name_length = name_length;
+			}
+
+			if (entry.name_length > 0 && entry.name[0] == '/')
+			{
+				entry.name++;
+				entry.name_length--;
+			}
+
+			entries.push_back(entry);
+			pos = next;
+		}
+
+		if (entries.size() < num_entries || (entries.size() - num_entries) % 0x10000 != 0)
+			throw Exception("Incorrect File Header signature");
+	}
+
+	void ZipMappedArchive_Impl::build_index()
+	{
+		size_t slots = 16;
+		while (slots < entries.size() * 2)
+			slots *= 2;
+		index.resize(slots, 0);
+
+		size_t mask = slots - 1;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			size_t slot = hash(entries[i].name, entries[i].name_length) & mask;
+			while (index[slot] != 0)
+				slot = (slot + 1) & mask;
+			index[slot] = (uint32_t)i + 1;
+		}
+	}
+
+	uint32_t ZipMappedArchive_Impl::hash(const char *name, size_t length)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (unsigned char)name[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,102 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/databuffer.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace clan
+{
+	class ZipMappedArchive_Impl
+	{
+	public:
+		/// \brief Central directory record of a file in the archive
+		struct Entry
+		{
+			const char *name; // Without leading slash, not zero terminated
+			uint32_t name_length;
+			uint16_t flags;
+			uint16_t compression_method;
+			uint32_t crc32;
+			uint64_t compressed_size;
+			uint64_t uncompressed_size;
+			uint64_t local_header_offset;
+		};
+
+		ZipMappedArchive_Impl(const std::string &filename);
+		~ZipMappedArchive_Impl();
+
+		/// \brief Returns the index of a file, or -1 if the archive does not contain it
+		int find(const std::string &filename) const;
+
+		/// \brief Returns the compressed data of a file in the mapping
+		const char *get_file_data(const Entry &entry) const;
+
+		/// \brief Inflates or copies a file into a new buffer
+		DataBuffer read_file(const Entry &entry) const;
+
+		/// \brief Returns a prefetched file, or a null buffer if it has not been prefetched
+		DataBuffer get_prefetched(int index);
+
+		std::string filename;
+		const char *data = nullptr;
+		size_t size = 0;
+
+		std::vector<Entry> entries;
+
+		std::mutex mutex;
+		std::unordered_map<int, DataBuffer> prefetched;
+
+	private:
+		void map_file();
+		void unmap_file();
+		void load_central_directory();
+		void build_index();
+
+		static uint32_t hash(const char *name, size_t length);
+
+		/// \brief Entry index plus one for each slot, with zero for empty slots
+		std::vector<uint32_t> index;
+
+		/// \brief Names that were converted from the DOS code page
+		std::deque<std::string> converted_names;
+
+#ifdef WIN32
+		HANDLE file_handle = INVALID_HANDLE_VALUE;
+		HANDLE mapping_handle = nullptr;
+#else
+		int file_handle = -1;
+#endif
+	};
+}
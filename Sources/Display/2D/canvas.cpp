@@ -237,6 +237,31 @@ namespace clan
 		impl->flush();
 	}
 
+	void Canvas::set_draw_list_enabled(bool enable)
+	{
+		impl->batcher.set_draw_list_enabled(enable);
+	}
+
+	bool Canvas::is_draw_list_enabled() const
+	{
+		return impl->batcher.is_draw_list_enabled();
+	}
+
+	void Canvas::set_draw_layer(int layer)
+	{
+		impl->batcher.set_draw_layer(layer);
+	}
+
+	int Canvas::get_draw_layer() const
+	{
+		return impl->batcher.get_draw_layer();
+	}
+
+	int Canvas::get_draw_call_count() const
+	{
+		return impl->batcher.get_draw_call_count();
+	}
+
 	void Canvas::set_transform(const Mat4f &matrix)
 	{
 		impl->set_transform(matrix);
@@ -44,9 +44,13 @@ namespace clan
 		void flush();
 		bool set_batcher(GraphicContext &gc, RenderBatcher *batcher);
 		void update_batcher_matrix(GraphicContext &gc, const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis);
+		void set_draw_list_enabled(bool enable);
 
 		GraphicContext current_gc;
 
+		CanvasDrawList draw_list;
+		bool replaying = false;
+
 		RenderBatcher *active_batcher;
 		RenderBatchBuffer render_batcher_buffer;
 
@@ -55,14 +59,19 @@ namespace clan
 		RenderBatchLineTexture render_batcher_line_texture;
 		RenderBatchPoint render_batcher_point;
 		RenderBatchPath render_batcher_path;
+
+	private:
+		bool is_recorder(RenderBatcher *batcher) const;
+		void set_recording(bool enable);
+		void replay();
 	};
 
 	CanvasBatcher_Impl::CanvasBatcher_Impl(GraphicContext &gc) : active_batcher(nullptr),
 		render_batcher_buffer(gc),
-		render_batcher_triangle(gc, &render_batcher_buffer),
-		render_batcher_line(gc, &render_batcher_buffer),
+		render_batcher_triangle(gc, &render_batcher_buffer, &draw_list),
+		render_batcher_line(gc, &render_batcher_buffer, &draw_list),
 		render_batcher_line_texture(gc, &render_batcher_buffer),
-		render_batcher_point(gc, &render_batcher_buffer),
+		render_batcher_point(gc, &render_batcher_buffer, &draw_list),
 		render_batcher_path(gc, &render_batcher_buffer)
 	{
 
@@ -111,12 +120,30 @@ namespace clan
 
 	void CanvasBatcher_Impl::flush()
 	{
+		bool replayed = false;
+		if (draw_list.is_enabled() && !replaying)
+		{
+			if (!draw_list.empty())
+			{
+				replay();
+				replayed = true;
+			}
+			else if (is_recorder(active_batcher))
+			{
+				// A recording batcher has nothing in the batch buffer
+				active_batcher = nullptr;
+			}
+		}
+
 		if (active_batcher)
 		{
 			RenderBatcher *batcher = active_batcher;
 			active_batcher = nullptr;
 			batcher->flush(current_gc);
 		}
+
+		if (replayed)
+			set_recording(true);
 	}
 
 	void CanvasBatcher_Impl::update_batcher_matrix(GraphicContext &gc, const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis)
@@ -137,6 +164,15 @@ namespace clan
 	{
 		if ((active_batcher != batcher) || (gc != current_gc))
 		{
+			if (draw_list.is_enabled() && !replaying && gc == current_gc && is_recorder(batcher))
+			{
+				// Switching between recording batchers draws nothing, only what another batcher has pending
+				if (active_batcher && !is_recorder(active_batcher))
+					active_batcher->flush(current_gc);
+				active_batcher = batcher;
+				return true;
+			}
+
 			flush();
 			current_gc = gc;
 			active_batcher = batcher;
@@ -145,11 +181,97 @@ namespace clan
 		return false;
 	}
 
+	bool CanvasBatcher_Impl::is_recorder(RenderBatcher *batcher) const
+	{
+		return batcher == &render_batcher_triangle || batcher == &render_batcher_line || batcher == &render_batcher_point;
+	}
+
+	void CanvasBatcher_Impl::set_recording(bool enable)
+	{
+		CanvasDrawListRecorder *recorders[] = { &render_batcher_triangle, &render_batcher_line, &render_batcher_point };
+		for (CanvasDrawListRecorder *recorder : recorders)
+			recorder->set_recording(enable);
+	}
+
+	void CanvasBatcher_Impl::set_draw_list_enabled(bool enable)
+	{
+		if (draw_list.is_enabled() != enable)
+		{
+			flush();
+			draw_list.set_enabled(enable);
+			set_recording(enable);
+		}
+	}
+
+	void CanvasBatcher_Impl::replay()
+	{
+		// Recorded vertices are already transformed, so they are copied into the batch buffer as they are
+		Size size = current_gc.get_size();
+		draw_list.set_pixel_size(Sizef(2.0f / std::max(size.width, 1), 2.0f / std::max(size.height, 1)));
+		const std::vector<const CanvasDrawCommand *> &commands = draw_list.sort();
+
+		replaying = true;
+		set_recording(false);
+		if (active_batcher && !is_recorder(active_batcher))
+			active_batcher->flush(current_gc);
+		active_batcher = nullptr;
+		try
+		{
+			for (const CanvasDrawCommand *command : commands)
+			{
+				if (active_batcher != command->batcher)
+				{
+					if (active_batcher)
+						active_batcher->flush(current_gc);
+					active_batcher = command->batcher;
+				}
+				command->recorder->replay(current_gc, *command);
+			}
+		}
+		catch (...)
+		{
+			active_batcher = nullptr;
+			draw_list.clear();
+			set_recording(true);
+			replaying = false;
+			throw;
+		}
+
+		// The last batch is drawn by flush before recording starts over
+		draw_list.clear();
+		replaying = false;
+	}
+
 	void CanvasBatcher::flush()
 	{
 		impl->flush();
 	}
 
+	void CanvasBatcher::set_draw_list_enabled(bool enable)
+	{
+		impl->set_draw_list_enabled(enable);
+	}
+
+	bool CanvasBatcher::is_draw_list_enabled() const
+	{
+		return impl->draw_list.is_enabled();
+	}
+
+	void CanvasBatcher::set_draw_layer(int layer)
+	{
+		impl->draw_list.set_layer(layer);
+	}
+
+	int CanvasBatcher::get_draw_layer() const
+	{
+		return impl->draw_list.get_layer();
+	}
+
+	int CanvasBatcher::get_draw_call_count() const
+	{
+		return impl->render_batcher_buffer.get_draw_call_count();
+	}
+
 	void CanvasBatcher::update_batcher_matrix(GraphicContext &gc, const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis)
 	{
 		impl->update_batcher_matrix(gc, modelview, projection, image_yaxis);
@@ -57,6 +57,12 @@ namespace clan
 		bool set_batcher(GraphicContext &gc, RenderBatcher *batcher);
 		void update_batcher_matrix(GraphicContext &gc, const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis);
 
+		void set_draw_list_enabled(bool enable);
+		bool is_draw_list_enabled() const;
+		void set_draw_layer(int layer);
+		int get_draw_layer() const;
+		int get_draw_call_count() const;
+
 		RenderBatchTriangle *get_triangle_batcher();
 		RenderBatchLine *get_line_batcher();
 		RenderBatchLineTexture *get_line_texture_batcher();
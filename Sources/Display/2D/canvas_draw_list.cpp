@@ -0,0 +1,177 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "canvas_draw_list.h"
+#include <algorithm>
+
+namespace clan
+{
+	void CanvasDrawList::begin_command(RenderBatcher *batcher, CanvasDrawListRecorder *recorder, const Texture2D &texture, bool glyph_program, const Colorf &constant_color, int first_vertex)
+	{
+		close_command();
+
+		commands.emplace_back();
+		CanvasDrawCommand &command = commands.back();
+		command.batcher = batcher;
+		command.recorder = recorder;
+		command.layer = layer;
+		command.texture = texture;
+		command.glyph_program = glyph_program;
+		command.constant_color = constant_color;
+		command.first_vertex = first_vertex;
+		command_open = true;
+	}
+
+	void CanvasDrawList::close_command()
+	{
+		if (!command_open)
+			return;
+		command_open = false;
+
+		CanvasDrawCommand &command = commands.back();
+		command.num_vertices = command.recorder->get_recorded_vertex_count() - command.first_vertex;
+		if (command.num_vertices <= 0)
+		{
+			commands.pop_back();
+			return;
+		}
+
+		command.bounds = command.recorder->get_recorded_bounds(command.first_vertex, command.num_vertices);
+	}
+
+	const std::vector<const CanvasDrawCommand *> &CanvasDrawList::sort()
+	{
+		close_command();
+
+		layer_order.resize(commands.size());
+		for (size_t i = 0; i < commands.size(); i++)
+			layer_order[i] = (int)i;
+		std::stable_sort(layer_order.begin(), layer_order.end(), [&](int a, int b) { return commands[a].layer < commands[b].layer; });
+
+		batches.clear();
+		for (int index : layer_order)
+		{
+			CanvasDrawCommand &command = commands[index];
+			command.next_in_batch = -1;
+
+			// Rasterization may touch pixels just outside the exact bounds of the vertices
+			command.bounds = Rectf(command.bounds.left - pixel_size.width, command.bounds.top - pixel_size.height, command.bounds.right + pixel_size.width, command.bounds.bottom + pixel_size.height);
+
+			// Walk back through the batches until one accepts the command or one it overlaps must stay below it
+			bool joined = false;
+			int stop = std::max((int)batches.size() - max_search_batches, 0);
+			for (int i = (int)batches.size() - 1; i >= stop; i--)
+			{
+				Batch &batch = batches[i];
+				if (batch.layer != command.layer)
+					break;
+				if (try_join(batch, command, index))
+				{
+					joined = true;
+					break;
+				}
+				if (is_overlapping(batch.bounds, command.bounds))
+					break;
+			}
+
+			if (!joined)
+			{
+				batches.emplace_back();
+				Batch &batch = batches.back();
+				batch.layer = command.layer;
+				batch.first_command = index;
+				batch.last_command = index;
+				batch.bounds = command.bounds;
+				batch.num_textures = 0;
+				if (!command.texture.is_null())
+					batch.textures[batch.num_textures++] = &command.texture;
+			}
+		}
+
+		sorted.clear();
+		for (const Batch &batch : batches)
+		{
+			for (int i = batch.first_command; i != -1; i = commands[i].next_in_batch)
+				sorted.push_back(&commands[i]);
+		}
+		return sorted;
+	}
+
+	bool CanvasDrawList::try_join(Batch &batch, const CanvasDrawCommand &command, int command_index)
+	{
+		const CanvasDrawCommand &first = commands[batch.first_command];
+		if (first.recorder != command.recorder || first.glyph_program != command.glyph_program)
+			return false;
+		if (command.glyph_program && first.constant_color != command.constant_color)
+			return false;
+
+		if (!command.texture.is_null())
+		{
+			int slot = -1;
+			for (int i = 0; i < batch.num_textures; i++)
+			{
+				if (*batch.textures[i] == command.texture)
+				{
+					slot = i;
+					break;
+				}
+			}
+
+			if (slot == -1)
+			{
+				int max_textures = std::min(command.recorder->get_max_batch_textures(), (int)Batch::max_textures);
+				if (batch.num_textures >= max_textures)
+					return false;
+				batch.textures[batch.num_textures++] = &command.texture;
+			}
+		}
+
+		commands[batch.last_command].next_in_batch = command_index;
+		batch.last_command = command_index;
+		batch.bounds = Rectf(
+			std::min(batch.bounds.left, command.bounds.left),
+			std::min(batch.bounds.top, command.bounds.top),
+			std::max(batch.bounds.right, command.bounds.right),
+			std::max(batch.bounds.bottom, command.bounds.bottom));
+		return true;
+	}
+
+	bool CanvasDrawList::is_overlapping(const Rectf &a, const Rectf &b)
+	{
+		return a.left <= b.right && a.right >= b.left && a.top <= b.bottom && a.bottom >= b.top;
+	}
+
+	void CanvasDrawList::clear()
+	{
+		commands.clear();
+		batches.clear();
+		sorted.clear();
+		command_open = false;
+	}
+}
@@ -0,0 +1,141 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Render/render_batcher.h"
+#include "API/Display/Render/texture_2d.h"
+#include "API/Display/2D/color.h"
+#include "API/Core/Math/rect.h"
+#include <vector>
+
+namespace clan
+{
+	class CanvasDrawListRecorder;
+
+	/// \brief Vertices recorded by one batcher with one set of render state
+	class CanvasDrawCommand
+	{
+	public:
+		RenderBatcher *batcher = nullptr;
+		CanvasDrawListRecorder *recorder = nullptr;
+		int layer = 0;
+		Texture2D texture;
+		bool glyph_program = false;
+		Colorf constant_color;
+		int first_vertex = 0;
+		int num_vertices = 0;
+		Rectf bounds;
+		int next_in_batch = -1;
+	};
+
+	/// \brief Implemented by the batchers that can record into a CanvasDrawList
+	class CanvasDrawListRecorder
+	{
+	public:
+		virtual ~CanvasDrawListRecorder() { }
+
+		/// \brief Switches between writing into the recorded vertices and into the shared batch buffer
+		virtual void set_recording(bool enable) = 0;
+
+		/// \brief Number of vertices recorded so far
+		virtual int get_recorded_vertex_count() const = 0;
+
+		/// \brief Bounding box of recorded vertices, in clip space
+		virtual Rectf get_recorded_bounds(int first_vertex, int num_vertices) const = 0;
+
+		/// \brief Textures one draw call of the batcher can use
+		virtual int get_max_batch_textures() const { return 0; }
+
+		/// \brief Adds the vertices of a recorded command to the current batch
+		virtual void replay(GraphicContext &gc, const CanvasDrawCommand &command) = 0;
+	};
+
+	/// \brief Deferred draw commands of a canvas, grouped into as few batches as painter's order allows
+	class CanvasDrawList
+	{
+	public:
+		bool is_enabled() const { return enabled; }
+		void set_enabled(bool enable) { enabled = enable; }
+
+		int get_layer() const { return layer; }
+		void set_layer(int new_layer) { layer = new_layer; }
+
+		/// \brief Size of one pixel in clip space, used by sort to widen the bounds of recorded commands
+		void set_pixel_size(const Sizef &size) { pixel_size = size; }
+
+		bool empty() const { return commands.empty(); }
+
+		/// \brief Starts recording a command at first_vertex
+		///
+		/// The vertex count and bounds of a command are taken from its recorder when the next command starts or the list is sorted.
+		void begin_command(RenderBatcher *batcher, CanvasDrawListRecorder *recorder, const Texture2D &texture, bool glyph_program, const Colorf &constant_color, int first_vertex);
+
+		/// \brief Returns the commands in the order they should be replayed
+		///
+		/// Commands are ordered by layer. Within a layer, a command joins the latest compatible batch unless it overlaps
+		/// a later batch, so painter's order is only kept between primitives that overlap.
+		const std::vector<const CanvasDrawCommand *> &sort();
+
+		/// \brief Number of batches found by the last sort
+		int get_batch_count() const { return (int)batches.size(); }
+
+		void clear();
+
+	private:
+		class Batch
+		{
+		public:
+			enum { max_textures = 32 };
+
+			int layer;
+			int first_command;
+			int last_command;
+			Rectf bounds;
+			const Texture2D *textures[max_textures];
+			int num_textures;
+		};
+
+		void close_command();
+		bool try_join(Batch &batch, const CanvasDrawCommand &command, int command_index);
+		static bool is_overlapping(const Rectf &a, const Rectf &b);
+
+		bool enabled = false;
+		int layer = 0;
+		Sizef pixel_size;
+		bool command_open = false;
+
+		std::vector<CanvasDrawCommand> commands;
+		std::vector<int> layer_order;
+		std::vector<Batch> batches;
+		std::vector<const CanvasDrawCommand *> sorted;
+
+		// How many batches back a command looks for one it can join
+		static const int max_search_batches = 64;
+	};
+}
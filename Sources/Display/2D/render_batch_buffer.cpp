@@ -46,6 +46,7 @@ namespace clan
 	VertexArrayBuffer RenderBatchBuffer::get_vertex_buffer(GraphicContext &gc, int &out_index)
 	{
 		out_index = current_vertex_buffer;
+		draw_call_count++;
 
 		current_vertex_buffer++;
 		if (current_vertex_buffer == num_vertex_buffers)
@@ -49,6 +49,10 @@ namespace clan
 		TransferTexture get_transfer_rgba32f(GraphicContext &gc);
 
 		TransferTexture get_transfer_r8(GraphicContext &gc, int &out_index);
+
+		/// \brief Number of vertex buffers handed out, one for each draw call of the batchers
+		int get_draw_call_count() const { return draw_call_count; }
+
 		static const int num_vertex_buffers = 4;
 		enum { vertex_buffer_size = 1024 * 1024 };
 		char buffer[vertex_buffer_size];
@@ -62,6 +66,7 @@ namespace clan
 	private:
 		VertexArrayBuffer vertex_buffers[num_vertex_buffers];
 		int current_vertex_buffer = 0;
+		int draw_call_count = 0;
 
 		Texture2D textures_rgba32f[num_rgba32f_buffers];
 		int current_rgba32f_texture = 0;
@@ -33,15 +33,16 @@
 #include "API/Display/Render/graphic_context.h"
 #include "API/Display/Render/blend_state.h"
 #include "render_batch_buffer.h"
+#include "canvas_draw_list.h"
 
 namespace clan
 {
 	class RenderBatchBuffer;
 
-	class RenderBatchLine : public RenderBatcher
+	class RenderBatchLine : public RenderBatcher, public CanvasDrawListRecorder
 	{
 	public:
-		RenderBatchLine(GraphicContext &gc, RenderBatchBuffer *batch_buffer);
+		RenderBatchLine(GraphicContext &gc, RenderBatchBuffer *batch_buffer, CanvasDrawList *draw_list);
 		void draw_line_strip(Canvas &canvas, const Vec2f *line_positions, const Vec4f &line_color, int num_vertices);
 		void draw_lines(Canvas &canvas, const Vec2f *line_positions, const Vec4f &line_color, int num_vertices);
 
@@ -57,11 +58,21 @@ namespace clan
 		void flush(GraphicContext &gc) override;
 		void matrix_changed(const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis, float pixel_ratio) override;
 
+		void set_recording(bool enable) override;
+		int get_recorded_vertex_count() const override;
+		Rectf get_recorded_bounds(int first_vertex, int num_vertices) const override;
+		void replay(GraphicContext &gc, const CanvasDrawCommand &command) override;
+
 		enum { max_vertices = RenderBatchBuffer::vertex_buffer_size / sizeof(LineVertex) };
 		LineVertex *vertices;
 		RenderBatchBuffer *batch_buffer;
 		PrimitivesArray prim_array[RenderBatchBuffer::num_vertex_buffers];
 		int position;
 		Mat4f modelview_projection_matrix;
+
+		CanvasDrawList *draw_list;
+		bool recording = false;
+		std::vector<LineVertex> recorded_vertices;
+		int recorded_count = 0;
 	};
 }
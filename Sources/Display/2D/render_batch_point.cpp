@@ -34,8 +34,8 @@
 
 namespace clan
 {
-	RenderBatchPoint::RenderBatchPoint(GraphicContext &gc, RenderBatchBuffer *batch_buffer)
-		: batch_buffer(batch_buffer)
+	RenderBatchPoint::RenderBatchPoint(GraphicContext &gc, RenderBatchBuffer *batch_buffer, CanvasDrawList *draw_list)
+		: batch_buffer(batch_buffer), draw_list(draw_list)
 	{
 		vertices = (PointVertex *)batch_buffer->buffer;
 	}
@@ -64,6 +64,19 @@ namespace clan
 
 	void RenderBatchPoint::set_batcher_active(Canvas &canvas, int num_vertices)
 	{
+		if (recording)
+		{
+			// Switching to another gc replays the draw list, so this must happen before the vertex position is taken
+			canvas.set_batcher(this);
+			if (position + num_vertices > (int)recorded_vertices.size())
+			{
+				recorded_vertices.resize(std::max(position + num_vertices, (int)recorded_vertices.size() * 2));
+				vertices = recorded_vertices.data();
+			}
+			draw_list->begin_command(this, this, Texture2D(), false, StandardColorf::black(), position);
+			return;
+		}
+
 		if (position + num_vertices > max_vertices)
 			canvas.flush();
 
@@ -73,6 +86,66 @@ namespace clan
 		canvas.set_batcher(this);
 	}
 
+	void RenderBatchPoint::set_recording(bool enable)
+	{
+		if (recording == enable)
+			return;
+
+		if (enable)
+		{
+			vertices = recorded_vertices.data();
+			recorded_count = 0;
+		}
+		else
+		{
+			vertices = (PointVertex *)batch_buffer->buffer;
+			recorded_count = position;
+		}
+		position = 0;
+		recording = enable;
+	}
+
+	int RenderBatchPoint::get_recorded_vertex_count() const
+	{
+		return recording ? position : recorded_count;
+	}
+
+	Rectf RenderBatchPoint::get_recorded_bounds(int first_vertex, int num_vertices) const
+	{
+		const PointVertex *v = recorded_vertices.data() + first_vertex;
+		Rectf bounds(v->position.x / v->position.w, v->position.y / v->position.w, v->position.x / v->position.w, v->position.y / v->position.w);
+		for (int i = 1; i < num_vertices; i++)
+		{
+			float x = v[i].position.x / v[i].position.w;
+			float y = v[i].position.y / v[i].position.w;
+			bounds.left = std::min(bounds.left, x);
+			bounds.top = std::min(bounds.top, y);
+			bounds.right = std::max(bounds.right, x);
+			bounds.bottom = std::max(bounds.bottom, y);
+		}
+		return bounds;
+	}
+
+	void RenderBatchPoint::replay(GraphicContext &gc, const CanvasDrawCommand &command)
+	{
+		const PointVertex *src = recorded_vertices.data() + command.first_vertex;
+		int num_vertices = command.num_vertices;
+		while (num_vertices > 0)
+		{
+			int count = std::min(num_vertices, (max_vertices - position));
+			if (count == 0)
+			{
+				flush(gc);
+				continue;
+			}
+
+			std::copy(src, src + count, vertices + position);
+			position += count;
+			src += count;
+			num_vertices -= count;
+		}
+	}
+
 	void RenderBatchPoint::flush(GraphicContext &gc)
 	{
 		if (position > 0)
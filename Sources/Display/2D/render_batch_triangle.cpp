@@ -40,8 +40,8 @@ namespace clan
 	// Warning: Ensure this number does not exceed RenderBatchTriangle::max_number_of_texture_coords
 	int RenderBatchTriangle::max_textures = 4;
 
-	RenderBatchTriangle::RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *batch_buffer)
-		: batch_buffer(batch_buffer)
+	RenderBatchTriangle::RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *batch_buffer, CanvasDrawList *draw_list)
+		: batch_buffer(batch_buffer), draw_list(draw_list)
 	{
 		vertices = (SpriteVertex *)batch_buffer->buffer;
 	}
@@ -92,7 +92,7 @@ namespace clan
 
 	void RenderBatchTriangle::fill_triangles(Canvas &canvas, const Vec2f *positions, const Vec2f *texture_positions, int num_vertices, const Texture2D &texture, const Colorf &color)
 	{
-		int texindex = set_batcher_active(canvas, texture);
+		int texindex = set_batcher_active(canvas, texture, false, StandardColorf::black(), num_vertices);
 
 		for (; num_vertices > 0; num_vertices--)
 		{
@@ -108,7 +108,7 @@ namespace clan
 
 	void RenderBatchTriangle::fill_triangles(Canvas &canvas, const Vec2f *positions, const Vec2f *texture_positions, int num_vertices, const Texture2D &texture, const Colorf *colors)
 	{
-		int texindex = set_batcher_active(canvas, texture);
+		int texindex = set_batcher_active(canvas, texture, false, StandardColorf::black(), num_vertices);
 
 		for (; num_vertices > 0; num_vertices--)
 		{
@@ -242,8 +242,11 @@ namespace clan
 	}
 
 
-	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program, const Colorf &new_constant_color)
+	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program, const Colorf &new_constant_color, int num_vertices)
 	{
+		if (recording)
+			return record(canvas, texture, glyph_program, new_constant_color, num_vertices);
+
 		if (use_glyph_program != glyph_program || constant_color != new_constant_color)
 		{
 			canvas.flush();
@@ -267,9 +270,13 @@ namespace clan
 			tex_sizes[texindex] = Sizef((float)current_textures[texindex].get_width(), (float)current_textures[texindex].get_height());
 		}
 
-		if (position == 0 || position + 6 > max_vertices || texindex == -1)
+		if (position == 0 || position + num_vertices > max_vertices || texindex == -1)
 		{
 			canvas.flush();
+
+			if (num_vertices > max_vertices)
+				throw Exception("Too many vertices for RenderBatchTriangle");
+
 			texindex = 0;
 			current_textures[texindex] = texture;
 			num_current_textures = 1;
@@ -281,6 +288,9 @@ namespace clan
 
 	int RenderBatchTriangle::set_batcher_active(Canvas &canvas)
 	{
+		if (recording)
+			return record(canvas, Texture2D(), false, StandardColorf::black(), 6);
+
 		if (use_glyph_program != false)
 		{
 			canvas.flush();
@@ -295,6 +305,9 @@ namespace clan
 
 	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, int num_vertices)
 	{
+		if (recording)
+			return record(canvas, Texture2D(), false, StandardColorf::black(), num_vertices);
+
 		if (use_glyph_program != false)
 		{
 			canvas.flush();
@@ -311,6 +324,120 @@ namespace clan
 		return RenderBatchTriangle::max_textures;
 	}
 
+	int RenderBatchTriangle::record(Canvas &canvas, const Texture2D &texture, bool glyph_program, const Colorf &new_constant_color, int num_vertices)
+	{
+		// Switching to another gc replays the draw list, so this must happen before the vertex position is taken
+		canvas.set_batcher(this);
+
+		if (position + num_vertices > (int)recorded_vertices.size())
+		{
+			recorded_vertices.resize(std::max(position + num_vertices, (int)recorded_vertices.size() * 2));
+			vertices = recorded_vertices.data();
+		}
+
+		draw_list->begin_command(this, this, texture, glyph_program, new_constant_color, position);
+
+		if (texture.is_null())
+			return RenderBatchTriangle::max_textures;
+
+		// The texture index is assigned when the command is replayed
+		tex_sizes[0] = Sizef((float)texture.get_width(), (float)texture.get_height());
+		return 0;
+	}
+
+	void RenderBatchTriangle::set_recording(bool enable)
+	{
+		if (recording == enable)
+			return;
+
+		if (enable)
+		{
+			vertices = recorded_vertices.data();
+			recorded_count = 0;
+		}
+		else
+		{
+			vertices = (SpriteVertex *)batch_buffer->buffer;
+			recorded_count = position;
+		}
+		position = 0;
+		recording = enable;
+	}
+
+	int RenderBatchTriangle::get_recorded_vertex_count() const
+	{
+		return recording ? position : recorded_count;
+	}
+
+	Rectf RenderBatchTriangle::get_recorded_bounds(int first_vertex, int num_vertices) const
+	{
+		const SpriteVertex *v = recorded_vertices.data() + first_vertex;
+		Rectf bounds(v->position.x / v->position.w, v->position.y / v->position.w, v->position.x / v->position.w, v->position.y / v->position.w);
+		for (int i = 1; i < num_vertices; i++)
+		{
+			float x = v[i].position.x / v[i].position.w;
+			float y = v[i].position.y / v[i].position.w;
+			bounds.left = std::min(bounds.left, x);
+			bounds.top = std::min(bounds.top, y);
+			bounds.right = std::max(bounds.right, x);
+			bounds.bottom = std::max(bounds.bottom, y);
+		}
+		return bounds;
+	}
+
+	void RenderBatchTriangle::replay(GraphicContext &gc, const CanvasDrawCommand &command)
+	{
+		if (use_glyph_program != command.glyph_program || (command.glyph_program && constant_color != command.constant_color))
+		{
+			flush(gc);
+			use_glyph_program = command.glyph_program;
+			constant_color = command.constant_color;
+		}
+
+		const SpriteVertex *src = recorded_vertices.data() + command.first_vertex;
+		int num_vertices = command.num_vertices;
+		while (num_vertices > 0)
+		{
+			int texindex = RenderBatchTriangle::max_textures;
+			if (!command.texture.is_null())
+			{
+				texindex = -1;
+				for (int i = 0; i < num_current_textures; i++)
+				{
+					if (current_textures[i] == command.texture)
+					{
+						texindex = i;
+						break;
+					}
+				}
+				if (texindex == -1)
+				{
+					if (num_current_textures == max_textures)
+						flush(gc);
+					texindex = num_current_textures;
+					current_textures[num_current_textures++] = command.texture;
+				}
+			}
+
+			// Only whole triangles may end up in the same draw call
+			int count = std::min(num_vertices, (max_vertices - position) / 3 * 3);
+			if (count == 0)
+			{
+				flush(gc);
+				continue;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				vertices[position + i] = src[i];
+				vertices[position + i].texindex = texindex;
+			}
+			position += count;
+			src += count;
+			num_vertices -= count;
+		}
+	}
+
 	void RenderBatchTriangle::flush(GraphicContext &gc)
 	{
 		if (position > 0)
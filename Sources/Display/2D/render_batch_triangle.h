@@ -35,6 +35,7 @@
 #include "API/Display/Render/render_batcher.h"
 #include "API/Display/Render/texture_2d.h"
 #include "render_batch_buffer.h"
+#include "canvas_draw_list.h"
 
 namespace clan
 {
@@ -42,10 +43,10 @@ namespace clan
 	class RenderBatchBuffer;
 	class Quadf;
 
-	class RenderBatchTriangle : public RenderBatcher
+	class RenderBatchTriangle : public RenderBatcher, public CanvasDrawListRecorder
 	{
 	public:
-		RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *batch_buffer);
+		RenderBatchTriangle(GraphicContext &gc, RenderBatchBuffer *batch_buffer, CanvasDrawList *draw_list);
 		void draw_sprite(Canvas &canvas, const Pointf texture_position[4], const Pointf dest_position[4], const Texture2D &texture, const Colorf &color);
 		void draw_image(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture);
 		void draw_image(Canvas &canvas, const Rectf &src, const Quadf &dest, const Colorf &color, const Texture2D &texture);
@@ -68,12 +69,19 @@ namespace clan
 			int texindex;
 		};
 
-		int set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program = false, const Colorf &constant_color = StandardColorf::black());
+		int set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program = false, const Colorf &constant_color = StandardColorf::black(), int num_vertices = 6);
 		int set_batcher_active(Canvas &canvas);
 		int set_batcher_active(Canvas &canvas, int num_vertices);
+		int record(Canvas &canvas, const Texture2D &texture, bool glyph_program, const Colorf &constant_color, int num_vertices);
 		void flush(GraphicContext &gc) override;
 		void matrix_changed(const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis, float pixel_ratio) override;
 
+		void set_recording(bool enable) override;
+		int get_recorded_vertex_count() const override;
+		Rectf get_recorded_bounds(int first_vertex, int num_vertices) const override;
+		int get_max_batch_textures() const override { return max_textures; }
+		void replay(GraphicContext &gc, const CanvasDrawCommand &command) override;
+
 		inline void to_sprite_vertex(const Pointf &texture_position, const Pointf &dest_position, RenderBatchTriangle::SpriteVertex &v, int texindex, const Colorf &color) const;
 		inline Vec4f to_position(float x, float y) const;
 
@@ -94,5 +102,10 @@ namespace clan
 		bool use_glyph_program = false;
 		Colorf constant_color;
 		BlendState glyph_blend;
+
+		CanvasDrawList *draw_list;
+		bool recording = false;
+		std::vector<SpriteVertex> recorded_vertices;
+		int recorded_count = 0;
 	};
 }
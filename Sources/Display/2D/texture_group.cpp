@@ -88,6 +88,11 @@ namespace clan
 		return impl->add_new_node(context, size);
 	}
 
+	Subtexture TextureGroup::try_add(const Size &size)
+	{
+		return impl->try_add_node(size);
+	}
+
 	void TextureGroup::remove(Subtexture &subtexture)
 	{
 		impl->remove(subtexture);
@@ -89,11 +89,11 @@ namespace clan
 	Subtexture TextureGroup_Impl::add_new_node(GraphicContext &context, const Size &texture_size)
 	{
 		// Try inserting in current active texture
-		Node *node;
+		Node *node = nullptr;
+		RootNode *root = active_root;
 		if (!active_root)
 		{
 			// Create an initial root, if it does not exist
-			node = nullptr;
 			next_id = 1;
 		}
 		else
@@ -105,28 +105,20 @@ namespace clan
 		{
 			// Search previous textures if policy says so
 			if (texture_allocation_policy == TextureGroup::search_previous_textures)
-			{
-				std::vector<RootNode *>::size_type index, size;
-				size = root_nodes.size();
-				for (index = 0; index < size; ++index)
-				{
-					node = root_nodes[index]->node.insert(texture_size, next_id);
-					if (node)	// We found space in a previous texture
-						break;
-				}
-			}
+				node = insert_existing(texture_size, root);
 
 			if (node == nullptr) // Couldn't find a fit, so create a new texture
 			{
 				if (texture_size.width > initial_texture_size.width || texture_size.height > initial_texture_size.height)
 				{
 					// If the specified size is greater than the initial size,  then create a texture using the specified size
-					node = add_new_root(context, texture_size)->node.insert(texture_size, next_id);
+					root = add_new_root(context, texture_size);
 				}
 				else
 				{
-					node = add_new_root(context, initial_texture_size)->node.insert(texture_size, next_id);
+					root = add_new_root(context, initial_texture_size);
 				}
+				node = root->node.insert(texture_size, next_id);
 			}
 
 			if (node == nullptr)
@@ -135,7 +127,40 @@ namespace clan
 
 		next_id++;
 
-		return Subtexture(active_root->texture, node->image_rect);
+		return Subtexture(root->texture, node->image_rect);
+	}
+
+	Subtexture TextureGroup_Impl::try_add_node(const Size &texture_size)
+	{
+		if (root_nodes.empty())
+			return Subtexture();
+
+		RootNode *root = active_root;
+		Node *node = active_root->node.insert(texture_size, next_id);
+		if (node == nullptr)
+			node = insert_existing(texture_size, root);
+		if (node == nullptr)
+			return Subtexture();
+
+		next_id++;
+
+		return Subtexture(root->texture, node->image_rect);
+	}
+
+	TextureGroup_Impl::Node *TextureGroup_Impl::insert_existing(const Size &texture_size, RootNode *&out_root)
+	{
+		std::vector<RootNode *>::size_type index, size;
+		size = root_nodes.size();
+		for (index = 0; index < size; ++index)
+		{
+			Node *node = root_nodes[index]->node.insert(texture_size, next_id);
+			if (node)	// We found space in a previous texture
+			{
+				out_root = root_nodes[index];
+				return node;
+			}
+		}
+		return nullptr;
 	}
 
 	TextureGroup_Impl::RootNode *TextureGroup_Impl::add_new_root(GraphicContext &context, const Size &texture_size)
@@ -79,6 +79,7 @@ namespace clan
 		std::vector<Texture2D> get_textures() const;
 
 		Subtexture add_new_node(GraphicContext &context, const Size &texture_size);
+		Subtexture try_add_node(const Size &texture_size);
 
 		std::vector<RootNode *> root_nodes;
 
@@ -87,6 +88,7 @@ namespace clan
 
 	private:
 		RootNode *add_new_root(GraphicContext &context, const Size &texture_size);
+		Node *insert_existing(const Size &texture_size, RootNode *&out_root);
 
 		RootNode *active_root;
 		int next_id;
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "API/Display/Image/pixel_buffer.h"
 #include "API/Display/Font/glyph_metrics.h"
 
@@ -42,6 +43,7 @@ namespace clan
 	class FontDescription;
 	class DataBuffer;
 	class FontHandle;
+	class WorkQueue;
 
 	/// \brief Font pixel buffer format (holds a pixel buffer containing a glyph)
 	class FontPixelBuffer
@@ -80,6 +82,15 @@ namespace clan
 		virtual bool is_automatic_recreation_allowed() const = 0;		// true if the engine supports dynamic recreation of the font (false for sprite fonts)
 		virtual const FontMetrics &get_metrics() const = 0;
 		virtual FontPixelBuffer get_font_glyph(int glyph) = 0;
+		// Rasterizes several glyphs at once. Engines that can rasterize concurrently use the work queue when one is given
+		virtual std::vector<FontPixelBuffer> get_font_glyphs(const std::vector<unsigned int> &glyphs, WorkQueue *queue)
+		{
+			std::vector<FontPixelBuffer> buffers;
+			buffers.reserve(glyphs.size());
+			for (unsigned int glyph : glyphs)
+				buffers.push_back(get_font_glyph(glyph));
+			return buffers;
+		}
 		virtual const FontDescription &get_desc() const = 0;
 		virtual void load_glyph_path(unsigned int glyph_index, Path &out_path, GlyphMetrics &out_metrics) = 0;
 		virtual FontHandle *get_handle() { return nullptr; }
@@ -36,6 +36,7 @@
 #include "font_engine_freetype.h"
 #include "API/Core/IOData/iodevice.h"
 #include "API/Display/2D/path.h"
+#include "API/Core/System/work_queue.h"
 
 namespace clan
 {
@@ -95,9 +96,32 @@ FontEngine_Freetype::FontEngine_Freetype(const FontDescription &description, Dat
 
 	data_buffer = font_databuffer;
 
+	pixel_width = (int)std::round(description.get_average_width() * pixel_ratio);
+	pixel_height = (int)std::round(height * pixel_ratio);
+
+	face = create_face();
+
+	calculate_font_metrics();
+}
+
+FontEngine_Freetype::~FontEngine_Freetype()
+{
+	for (FT_Face band_face : band_faces)
+	{
+		FT_Done_Face(band_face);
+	}
+	if (face)
+	{
+		FT_Done_Face(face);
+	}
+}
+
+FT_Face FontEngine_Freetype::create_face()
+{
 	FontEngine_Freetype_Library &library = FontEngine_Freetype_Library::instance();
 
-	FT_Error error = FT_New_Memory_Face( library.library, (FT_Byte*)data_buffer.get_data(), data_buffer.get_size(), 0, &face);
+	FT_Face new_face = nullptr;
+	FT_Error error = FT_New_Memory_Face( library.library, (FT_Byte*)data_buffer.get_data(), data_buffer.get_size(), 0, &new_face);
 
 	if ( error == FT_Err_Unknown_File_Format )
 	{
@@ -108,34 +132,59 @@ FontEngine_Freetype::FontEngine_Freetype(const FontDescription &description, Dat
 		throw Exception("Freetype error: Font file could not be opened or read, or is corrupted.");
 	}
 
-	int pixel_width = (int)std::round(description.get_average_width() * pixel_ratio);
-	int pixel_height = (int)std::round(height * pixel_ratio);
+	FT_Set_Pixel_Sizes(new_face, pixel_width, pixel_height);
+	return new_face;
+}
 
-	FT_Set_Pixel_Sizes(face, pixel_width, pixel_height);
+/////////////////////////////////////////////////////////////////////////////
+// FontEngine_Freetype Attributes:
 
-	calculate_font_metrics();
+FontPixelBuffer FontEngine_Freetype::get_font_glyph(int glyph)
+{
+	return get_font_glyph(face, glyph);
 }
 
-FontEngine_Freetype::~FontEngine_Freetype()
+std::vector<FontPixelBuffer> FontEngine_Freetype::get_font_glyphs(const std::vector<unsigned int> &glyphs, WorkQueue *queue)
 {
-	if (face)
+	std::vector<FontPixelBuffer> buffers(glyphs.size());
+
+	// A FT_Face can only be used by one thread at a time, so each band of glyphs gets a face of its own
+	const int min_glyphs_per_band = 8;
+	int num_bands = queue ? std::min((int)glyphs.size() / min_glyphs_per_band, queue->get_num_workers() + 1) : 1;
+	if (!concurrent_rendering || num_bands <= 1)
 	{
-		FT_Done_Face(face);
+		for (size_t i = 0; i < glyphs.size(); i++)
+			buffers[i] = get_font_glyph(face, glyphs[i]);
+		return buffers;
 	}
-}
 
-/////////////////////////////////////////////////////////////////////////////
-// FontEngine_Freetype Attributes:
+	// Faces are created on this thread as the library itself is not thread safe
+	while ((int)band_faces.size() < num_bands - 1)
+		band_faces.push_back(create_face());
 
-FontPixelBuffer FontEngine_Freetype::get_font_glyph(int glyph)
+	WorkGroup group(*queue);
+	group.parallel_for(0, num_bands, [&](int band)
+	{
+		FT_Face band_face = band == 0 ? face : band_faces[band - 1];
+		size_t begin = glyphs.size() * band / num_bands;
+		size_t end = glyphs.size() * (band + 1) / num_bands;
+		for (size_t i = begin; i < end; i++)
+			buffers[i] = get_font_glyph(band_face, glyphs[i]);
+	});
+	group.wait();
+
+	return buffers;
+}
+
+FontPixelBuffer FontEngine_Freetype::get_font_glyph(FT_Face glyph_face, int glyph)
 {
 	if (font_description.get_subpixel())
 	{
-		return get_font_glyph_subpixel(glyph);
+		return get_font_glyph_subpixel(glyph_face, glyph);
 	}
 	else
 	{
-		return get_font_glyph_standard(glyph, font_description.get_anti_alias());
+		return get_font_glyph_standard(glyph_face, glyph, font_description.get_anti_alias());
 	}
 }
 
@@ -230,30 +279,30 @@ void FontEngine_Freetype::load_glyph_path(unsigned int c, Path &out_path, GlyphM
 
 }
 
-FontPixelBuffer FontEngine_Freetype::get_font_glyph_standard(int glyph, bool anti_alias)
+FontPixelBuffer FontEngine_Freetype::get_font_glyph_standard(FT_Face glyph_face, int glyph, bool anti_alias)
 {
 	FontPixelBuffer font_buffer;
-	FT_GlyphSlot slot = face->glyph;
+	FT_GlyphSlot slot = glyph_face->glyph;
 	FT_UInt glyph_index;
 	// Get glyph index
-	glyph_index = FT_Get_Char_Index(face, glyph);
+	glyph_index = FT_Get_Char_Index(glyph_face, glyph);
 
 	FT_Error error;
 
 	// Use FT_RENDER_MODE_NORMAL for 8bit anti-aliased bitmaps. Use FT_RENDER_MODE_MONO for 1-bit bitmaps
 	if (anti_alias)
 	{
-		error = FT_Load_Glyph(face, glyph_index, FT_LOAD_TARGET_LIGHT );
+		error = FT_Load_Glyph(glyph_face, glyph_index, FT_LOAD_TARGET_LIGHT );
 		if (error) return font_buffer;
 
-		error = FT_Render_Glyph( face->glyph, FT_RENDER_MODE_NORMAL);
+		error = FT_Render_Glyph( glyph_face->glyph, FT_RENDER_MODE_NORMAL);
 	}
 	else
 	{
-		error = FT_Load_Glyph(face, glyph_index, FT_LOAD_TARGET_MONO);
+		error = FT_Load_Glyph(glyph_face, glyph_index, FT_LOAD_TARGET_MONO);
 		if (error) return font_buffer;
 
-		error = FT_Render_Glyph( face->glyph, FT_RENDER_MODE_MONO);
+		error = FT_Render_Glyph( glyph_face->glyph, FT_RENDER_MODE_MONO);
 	}
 
 	font_buffer.glyph = glyph;
@@ -352,20 +401,20 @@ FontPixelBuffer FontEngine_Freetype::get_font_glyph_standard(int glyph, bool ant
 	return font_buffer;
 }
 
-FontPixelBuffer FontEngine_Freetype::get_font_glyph_subpixel(int glyph)
+FontPixelBuffer FontEngine_Freetype::get_font_glyph_subpixel(FT_Face glyph_face, int glyph)
 {
 	FontPixelBuffer font_buffer;
-	FT_GlyphSlot slot = face->glyph;
+	FT_GlyphSlot slot = glyph_face->glyph;
 	FT_UInt glyph_index;
 
 	// Get glyph index
-	glyph_index = FT_Get_Char_Index(face, glyph);
+	glyph_index = FT_Get_Char_Index(glyph_face, glyph);
 	FT_Error error;
 
-	error = FT_Load_Glyph(face, glyph_index, FT_LOAD_TARGET_LCD );
+	error = FT_Load_Glyph(glyph_face, glyph_index, FT_LOAD_TARGET_LCD );
 	if (error) return font_buffer;
 
-	error = FT_Render_Glyph( face->glyph, FT_RENDER_MODE_LCD);
+	error = FT_Render_Glyph( glyph_face->glyph, FT_RENDER_MODE_LCD);
 
 	font_buffer.glyph = glyph;
 	// Set Increment pen position
@@ -77,10 +77,11 @@ public:
 	const FontMetrics &get_metrics() const override { return font_metrics; }
 
 	FontPixelBuffer get_font_glyph(int glyph) override;
+	std::vector<FontPixelBuffer> get_font_glyphs(const std::vector<unsigned int> &glyphs, WorkQueue *queue) override;
 
-	FontPixelBuffer get_font_glyph_standard(int glyph, bool anti_alias);
+	FontPixelBuffer get_font_glyph_standard(FT_Face glyph_face, int glyph, bool anti_alias);
 
-	FontPixelBuffer get_font_glyph_subpixel(int glyph);
+	FontPixelBuffer get_font_glyph_subpixel(FT_Face glyph_face, int glyph);
 	const FontDescription &get_desc() const override { return font_description; }
 	
 /// \}
@@ -95,6 +96,8 @@ public:
 /// \{
 
 private:
+	FT_Face create_face();
+	FontPixelBuffer get_font_glyph(FT_Face glyph_face, int glyph);
 	void calculate_font_metrics();
 	TagStruct get_tag_struct(int cont, int index, FT_Outline *outline);
 	int get_index_of_next_contour_point(int cont, int index, FT_Outline *outline);
@@ -102,6 +105,12 @@ private:
 	Pointf FT_Vector_to_Pointf(const FT_Vector &);
 
 	FT_Face face;
+	std::vector<FT_Face> band_faces;	// Extra faces for rasterizing on worker threads
+	int pixel_width = 0;
+	int pixel_height = 0;
+
+	// Before 2.6.2 all faces of a library shared one rasterizer pool
+	static const bool concurrent_rendering = FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && (FREETYPE_MINOR > 6 || (FREETYPE_MINOR == 6 && FREETYPE_PATCH >= 2)));
 
 	std::vector<TaggedPoint> get_contour_points(int cont, FT_Outline *outline);
 
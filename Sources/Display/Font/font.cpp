@@ -140,6 +140,18 @@ namespace clan
 			impl->set_scalable(height_threshold);
 	}
 
+	void Font::prepare_glyphs(Canvas &canvas, const std::string &text)
+	{
+		if (impl)
+			impl->prepare_glyphs(canvas, text, nullptr);
+	}
+
+	void Font::prepare_glyphs(Canvas &canvas, const std::string &text, WorkQueue &queue)
+	{
+		if (impl)
+			impl->prepare_glyphs(canvas, text, &queue);
+	}
+
 	GlyphMetrics Font::get_metrics(Canvas &canvas, unsigned int glyph) const
 	{
 		if (impl)
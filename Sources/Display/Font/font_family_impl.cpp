@@ -76,7 +76,7 @@ namespace clan
 		FontMetrics font_metrics;
 	};
 
-	FontFamily_Impl::FontFamily_Impl(const std::string &family_name, const TextureGroup &new_texture_group) : family_name(family_name), texture_group(new_texture_group)
+	FontFamily_Impl::FontFamily_Impl(const std::string &family_name, const TextureGroup &new_texture_group) : family_name(family_name), glyph_atlas(new_texture_group.is_null() ? GlyphAtlas::get_default() : GlyphAtlas::get(new_texture_group))
 	{
 	}
 
@@ -112,7 +112,7 @@ namespace clan
 		std::shared_ptr<FontEngine> engine = std::make_shared<FontEngine_Freetype>(desc, font_databuffer, pixel_ratio);
 		font_cache.push_back(Font_Cache(engine));
 #endif
-		font_cache.back().glyph_cache->set_texture_group(texture_group);
+		font_cache.back().glyph_cache->set_atlas(glyph_atlas);
 		font_cache.back().pixel_ratio = pixel_ratio;
 	}
 
@@ -121,12 +121,12 @@ namespace clan
 #if defined(WIN32)
 		std::shared_ptr<FontEngine> engine = std::make_shared<FontEngine_Win32>(desc, typeface_name, pixel_ratio);
 		font_cache.push_back(Font_Cache(engine));
-		font_cache.back().glyph_cache->set_texture_group(texture_group);
+		font_cache.back().glyph_cache->set_atlas(glyph_atlas);
 		font_cache.back().pixel_ratio = pixel_ratio;
 #elif defined(__APPLE__)
 		std::shared_ptr<FontEngine> engine = std::make_shared<FontEngine_Cocoa>(desc, typeface_name, pixel_ratio);
 		font_cache.push_back(Font_Cache(engine));
-		font_cache.back().glyph_cache->set_texture_group(texture_group);
+		font_cache.back().glyph_cache->set_atlas(glyph_atlas);
 		font_cache.back().pixel_ratio = pixel_ratio;
 #elif defined(__ANDROID__)
 		throw Exception("automatic typeface to ttf file selection is not supported on android");
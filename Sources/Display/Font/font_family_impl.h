@@ -38,6 +38,7 @@
 #include <map>
 #include "glyph_cache.h"
 #include "path_cache.h"
+#include "glyph_atlas.h"
 
 namespace clan
 {
@@ -86,7 +87,7 @@ namespace clan
 		void font_face_load(const FontDescription &desc, DataBuffer &font_databuffer, float pixel_ratio);
 
 		std::string family_name;
-		TextureGroup texture_group;		// Shared texture group between glyph cache's
+		std::shared_ptr<GlyphAtlas> glyph_atlas;		// Shared between glyph caches, and with other families using the same texture group
 		std::vector<Font_Cache> font_cache;
 		std::vector<FontFamily_Definition> font_definitions;
 	};
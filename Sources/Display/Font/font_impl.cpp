@@ -77,7 +77,7 @@ namespace clan
 				font_cache = font_family.impl->copy_font(new_selected, pixel_ratio);
 
 			font_engine = font_cache.engine.get();
-			GlyphCache *glyph_cache = font_cache.glyph_cache.get();
+			glyph_cache = font_cache.glyph_cache.get();
 			PathCache *path_cache = font_cache.path_cache.get();
 
 			const FontMetrics &metrics = font_engine->get_metrics();
@@ -263,6 +263,15 @@ namespace clan
 		font_draw->draw_text(canvas, pos, text, color, line_spacing);
 	}
 
+	void Font_Impl::prepare_glyphs(Canvas &canvas, const std::string &text, WorkQueue *queue)
+	{
+		select_font_family(canvas);
+
+		// Path fonts are drawn from outlines and do not use the glyph cache
+		if (!selected_pathfont)
+			glyph_cache->prepare_glyphs(canvas, font_engine, text, queue);
+	}
+
 	GlyphMetrics Font_Impl::get_metrics(Canvas &canvas, unsigned int glyph)
 	{
 		select_font_family(canvas);
@@ -49,6 +49,7 @@
 namespace clan
 {
 	class FontEngine;
+	class WorkQueue;
 	class XMLResourceNode;
 	class DomElement;
 
@@ -71,6 +72,8 @@ namespace clan
 
 		void draw_text(Canvas &canvas, const Pointf &position, const std::string &text, const Colorf &color);
 
+		void prepare_glyphs(Canvas &canvas, const std::string &text, WorkQueue *queue);
+
 		void get_glyph_path(Canvas &canvas, unsigned int glyph_index, Path &out_path, GlyphMetrics &out_metrics);
 
 		void set_height(float value);
@@ -93,6 +96,7 @@ namespace clan
 		FontMetrics selected_metrics;
 
 		FontEngine *font_engine = nullptr;	// If null, use select_font_family() to update
+		GlyphCache *glyph_cache = nullptr;
 		FontFamily font_family;
 
 		Font_Draw *font_draw = nullptr;
@@ -0,0 +1,146 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+*/
+
+#include "Display/precomp.h"
+#include "glyph_atlas.h"
+#include "glyph_cache.h"
+#include "API/Display/2D/canvas.h"
+#include <algorithm>
+#include <mutex>
+
+namespace clan
+{
+	namespace
+	{
+		std::mutex atlas_mutex;
+		std::vector<std::weak_ptr<GlyphAtlas>> group_atlases;
+		std::weak_ptr<GlyphAtlas> default_atlas;
+	}
+
+	GlyphAtlas::GlyphAtlas(const TextureGroup &texture_group, int max_textures) : texture_group(texture_group), max_textures(max_textures)
+	{
+		texture_group.throw_if_null();
+	}
+
+	GlyphAtlas::~GlyphAtlas()
+	{
+	}
+
+	std::shared_ptr<GlyphAtlas> GlyphAtlas::get(const TextureGroup &texture_group)
+	{
+		std::unique_lock<std::mutex> lock(atlas_mutex);
+
+		group_atlases.erase(std::remove_if(group_atlases.begin(), group_atlases.end(), [](const std::weak_ptr<GlyphAtlas> &atlas) { return atlas.expired(); }), group_atlases.end());
+		for (auto &weak_atlas : group_atlases)
+		{
+			std::shared_ptr<GlyphAtlas> atlas = weak_atlas.lock();
+			if (atlas && atlas->texture_group == texture_group)
+				return atlas;
+		}
+
+		auto atlas = std::make_shared<GlyphAtlas>(texture_group);
+		group_atlases.push_back(atlas);
+		return atlas;
+	}
+
+	std::shared_ptr<GlyphAtlas> GlyphAtlas::get_default()
+	{
+		std::unique_lock<std::mutex> lock(atlas_mutex);
+
+		std::shared_ptr<GlyphAtlas> atlas = default_atlas.lock();
+		if (!atlas)
+		{
+			atlas = std::make_shared<GlyphAtlas>(TextureGroup(Size(512, 512)));
+			default_atlas = atlas;
+		}
+		return atlas;
+	}
+
+	Subtexture GlyphAtlas::add(Canvas &canvas, const Size &size, GlyphCache *owner, Font_TextureGlyph *glyph)
+	{
+		Subtexture subtexture = texture_group.try_add(size);
+		if (!subtexture && texture_group.get_texture_count() >= max_textures)
+		{
+			evict(canvas);
+			subtexture = texture_group.try_add(size);
+		}
+
+		// Grow the group if eviction did not free a large enough area
+		if (!subtexture)
+		{
+			GraphicContext gc = canvas.get_gc();
+			subtexture = texture_group.add(gc, size);
+		}
+
+		Entry entry;
+		entry.owner = owner;
+		entry.glyph = glyph;
+		entry.subtexture = subtexture;
+		entries.push_back(entry);
+
+		touch(glyph);
+		return subtexture;
+	}
+
+	void GlyphAtlas::remove_owner(GlyphCache *owner)
+	{
+		auto it = std::remove_if(entries.begin(), entries.end(), [&](Entry &entry)
+		{
+			if (entry.owner != owner)
+				return false;
+			texture_group.remove(entry.subtexture);
+			return true;
+		});
+		entries.erase(it, entries.end());
+	}
+
+	void GlyphAtlas::touch(Font_TextureGlyph *glyph)
+	{
+		glyph->last_used = ++use_counter;
+	}
+
+	void GlyphAtlas::evict(Canvas &canvas)
+	{
+		if (entries.empty())
+			return;
+
+		// Text already batched by the canvas may refer to the areas that are about to be reused
+		canvas.flush();
+
+		// Evict the least recently used quarter, which leaves the glyphs of the text currently being drawn alone
+		size_t count = std::max(entries.size() / 4, (size_t)1);
+		std::nth_element(entries.begin(), entries.begin() + count - 1, entries.end(), [](const Entry &a, const Entry &b) { return a.glyph->last_used < b.glyph->last_used; });
+
+		for (size_t i = 0; i < count; i++)
+		{
+			texture_group.remove(entries[i].subtexture);
+			entries[i].owner->remove_glyph(entries[i].glyph->glyph);
+		}
+		entries.erase(entries.begin(), entries.begin() + count);
+	}
+}
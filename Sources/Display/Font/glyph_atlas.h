@@ -0,0 +1,87 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+*/
+
+#pragma once
+
+#include "API/Display/2D/texture_group.h"
+#include "API/Display/2D/subtexture.h"
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	class Canvas;
+	class GlyphCache;
+	class Font_TextureGlyph;
+
+	/// \brief Texture space for rasterized glyphs, shared by the glyph caches of several font sizes and families
+	///
+	/// Once the texture group holds max_textures textures, the least recently used glyphs are evicted to make room.
+	class GlyphAtlas
+	{
+	public:
+		GlyphAtlas(const TextureGroup &texture_group, int max_textures = default_max_textures);
+		~GlyphAtlas();
+
+		/// \brief Returns the atlas for a texture group, so that font families using the same group share it
+		static std::shared_ptr<GlyphAtlas> get(const TextureGroup &texture_group);
+
+		/// \brief Returns the atlas shared by font families that were not given a texture group
+		static std::shared_ptr<GlyphAtlas> get_default();
+
+		int get_glyph_count() const { return (int)entries.size(); }
+
+		/// \brief Allocate space for a glyph owned by a glyph cache
+		///
+		/// This may evict other glyphs, including glyphs from the same cache.
+		Subtexture add(Canvas &canvas, const Size &size, GlyphCache *owner, Font_TextureGlyph *glyph);
+
+		/// \brief Release the space of all glyphs owned by a glyph cache
+		void remove_owner(GlyphCache *owner);
+
+		/// \brief Marks a glyph as the most recently used
+		void touch(Font_TextureGlyph *glyph);
+
+		static const int default_max_textures = 8;
+
+	private:
+		void evict(Canvas &canvas);
+
+		struct Entry
+		{
+			GlyphCache *owner;
+			Font_TextureGlyph *glyph;
+			Subtexture subtexture;
+		};
+
+		TextureGroup texture_group;
+		int max_textures;
+		std::vector<Entry> entries;
+		uint64_t use_counter = 0;
+	};
+}
@@ -29,6 +29,7 @@
 
 #include "Display/precomp.h"
 #include "glyph_cache.h"
+#include "glyph_atlas.h"
 #include "FontEngine/font_engine.h"
 #include "API/Display/Image/pixel_buffer.h"
 #include "API/Display/Image/pixel_buffer_help.h"
@@ -46,46 +47,72 @@
 #include "API/Core/Text/utf8_reader.h"
 #include "Display/2D/render_batch_triangle.h"
 #include "Display/Render/graphic_context_impl.h"
+#include <algorithm>
 
 namespace clan
 {
 	GlyphCache::GlyphCache()
 	{
-		glyph_list.reserve(256);
 	}
 
 	GlyphCache::~GlyphCache()
 	{
+		if (atlas)
+			atlas->remove_owner(this);
 	}
 
 	Font_TextureGlyph *GlyphCache::get_glyph(Canvas &canvas, FontEngine *font_engine, unsigned int glyph)
 	{
-		auto size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
+		Font_TextureGlyph *font_glyph = find_glyph(glyph);
+		if (!font_glyph && invalid_glyphs.find(glyph) == invalid_glyphs.end())
 		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
+			// If glyph does not exist, create one automatically
+			FontPixelBuffer pb = font_engine->get_font_glyph(glyph);
+			if (pb.glyph)	// Ignore invalid glyphs
+				insert_glyph(canvas, pb);
+
+			font_glyph = find_glyph(glyph);
+			if (!font_glyph)
+				invalid_glyphs.insert(glyph);
 		}
 
-		// If glyph does not exist, create one automatically
-		FontPixelBuffer pb = font_engine->get_font_glyph(glyph);
-		if (pb.glyph)	// Ignore invalid glyphs
-			insert_glyph(canvas, pb);
+		if (font_glyph && atlas)
+			atlas->touch(font_glyph);
+		return font_glyph;
+	}
 
-		// Search for the glyph again
-		size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
+	void GlyphCache::prepare_glyphs(Canvas &canvas, FontEngine *font_engine, const std::string &text, WorkQueue *queue)
+	{
+		std::vector<unsigned int> missing_glyphs;
+		UTF8_Reader reader(text.data(), text.length());
+		while (!reader.is_end())
 		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
+			unsigned int glyph = reader.get_char();
+			reader.next();
+			if (!find_glyph(glyph) && invalid_glyphs.find(glyph) == invalid_glyphs.end())
+				missing_glyphs.push_back(glyph);
 		}
 
-		return nullptr;
+		std::sort(missing_glyphs.begin(), missing_glyphs.end());
+		missing_glyphs.erase(std::unique(missing_glyphs.begin(), missing_glyphs.end()), missing_glyphs.end());
+		if (missing_glyphs.empty())
+			return;
+
+		std::vector<FontPixelBuffer> buffers = font_engine->get_font_glyphs(missing_glyphs, queue);
+		for (size_t i = 0; i < missing_glyphs.size(); i++)
+		{
+			if (buffers[i].glyph)
+				insert_glyph(canvas, buffers[i]);
+			if (!find_glyph(missing_glyphs[i]))
+				invalid_glyphs.insert(missing_glyphs[i]);
+		}
 	}
 
-	void GlyphCache::set_texture_group(TextureGroup &new_texture_group)
+	void GlyphCache::set_atlas(const std::shared_ptr<GlyphAtlas> &new_atlas)
 	{
-		texture_group = new_texture_group;
+		if (atlas)
+			atlas->remove_owner(this);
+		atlas = new_atlas;
 	}
 
 	GlyphMetrics GlyphCache::get_metrics(FontEngine *font_engine, Canvas &canvas, unsigned int glyph)
@@ -108,16 +135,19 @@ namespace clan
 
 		if (!pb.empty_buffer)
 		{
+			if (!atlas)
+				throw Exception("Glyph cache has no atlas for rasterized glyphs");
+
 			PixelBuffer buffer_with_border = PixelBufferHelp::add_border(pb.buffer, glyph_border_size, pb.buffer_rect);
 			GraphicContext gc = canvas.get_gc();
-			Subtexture sub_texture = texture_group.add(gc, buffer_with_border.get_size());
+			Subtexture sub_texture = atlas->add(canvas, buffer_with_border.get_size(), this, font_glyph.get());
 			font_glyph->texture = sub_texture.get_texture();
 			font_glyph->geometry = Rect(sub_texture.get_geometry().left + glyph_border_size, sub_texture.get_geometry().top + glyph_border_size, pb.buffer_rect.get_size());
 			font_glyph->size = pb.size;
 			sub_texture.get_texture().set_subimage(gc, sub_texture.get_geometry().left, sub_texture.get_geometry().top, buffer_with_border, buffer_with_border.get_size());
 		}
 
-		glyph_list.push_back(std::move(font_glyph));
+		add_glyph(std::move(font_glyph));
 	}
 
 	void GlyphCache::insert_glyph(Canvas &canvas, unsigned int glyph, Subtexture &sub_texture, const Pointf &offset, const Sizef &size, const GlyphMetrics &glyph_metrics)
@@ -135,6 +165,30 @@ namespace clan
 			font_glyph->geometry = sub_texture.get_geometry();
 		}
 
-		glyph_list.push_back(std::move(font_glyph));
+		add_glyph(std::move(font_glyph));
+	}
+
+	void GlyphCache::remove_glyph(unsigned int glyph)
+	{
+		if (glyph < glyph_table.size())
+			glyph_table[glyph] = nullptr;
+		glyph_map.erase(glyph);
+	}
+
+	void GlyphCache::add_glyph(std::unique_ptr<Font_TextureGlyph> font_glyph)
+	{
+		// Sprite fonts may list a glyph twice, the first one is used
+		unsigned int glyph = font_glyph->glyph;
+		if (find_glyph(glyph))
+			return;
+
+		if (glyph < direct_glyph_limit)
+		{
+			if (glyph >= glyph_table.size())
+				glyph_table.resize(glyph + 1, nullptr);
+			glyph_table[glyph] = font_glyph.get();
+		}
+
+		glyph_map[glyph] = std::move(font_glyph);
 	}
 }
@@ -35,8 +35,8 @@
 #include "API/Display/2D/texture_group.h"
 #include "API/Display/2D/subtexture.h"
 #include "API/Display/Render/texture_2d.h"
-#include <list>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace clan
 {
@@ -48,6 +48,8 @@ namespace clan
 	class FontPixelBuffer;
 	class Path;
 	class RenderBatchTriangle;
+	class GlyphAtlas;
+	class WorkQueue;
 
 	/// \brief Font texture format (holds a pixel buffer containing a glyph)
 	class Font_TextureGlyph
@@ -76,6 +78,9 @@ namespace clan
 		Sizef size;
 
 		GlyphMetrics metrics;
+
+		/// \brief Use counter value of the last lookup, for evicting glyphs from the atlas
+		uint64_t last_used = 0;
 	};
 
 	class GlyphCache
@@ -87,17 +92,38 @@ namespace clan
 		/// \brief Get a glyph. Returns NULL if the glyph was not found
 		Font_TextureGlyph *get_glyph(Canvas &canvas, FontEngine *font_engine, unsigned int glyph);
 
+		/// \brief Rasterize all glyphs of a text that are not in the cache yet
+		///
+		/// If a work queue is given, the font engine may rasterize them on its worker threads.
+		void prepare_glyphs(Canvas &canvas, FontEngine *font_engine, const std::string &text, WorkQueue *queue);
+
 		GlyphMetrics get_metrics(FontEngine *font_engine, Canvas &canvas, unsigned int glyph);
 
 		void insert_glyph(Canvas &canvas, unsigned int glyph, Subtexture &sub_texture, const Pointf &offset, const Sizef &size, const GlyphMetrics &glyph_metrics);
 		void insert_glyph(Canvas &canvas, FontPixelBuffer &pb);
 
-		void set_texture_group(TextureGroup &new_texture_group);
+		/// \brief Remove a glyph evicted from the atlas
+		void remove_glyph(unsigned int glyph);
 
-	private:
-		std::vector<std::unique_ptr<Font_TextureGlyph>> glyph_list;
-		TextureGroup texture_group;
+		void set_atlas(const std::shared_ptr<GlyphAtlas> &new_atlas);
 
+	private:
+		Font_TextureGlyph *find_glyph(unsigned int glyph) const
+		{
+			if (glyph < glyph_table.size())
+				return glyph_table[glyph];
+			auto it = glyph_map.find(glyph);
+			return it != glyph_map.end() ? it->second.get() : nullptr;
+		}
+
+		void add_glyph(std::unique_ptr<Font_TextureGlyph> font_glyph);
+
+		std::unordered_map<unsigned int, std::unique_ptr<Font_TextureGlyph>> glyph_map;
+		std::vector<Font_TextureGlyph *> glyph_table;	// Direct lookup of glyphs below direct_glyph_limit
+		std::unordered_set<unsigned int> invalid_glyphs;	// Glyphs the font engine could not create
+		std::shared_ptr<GlyphAtlas> atlas;
+
+		static const unsigned int direct_glyph_limit = 0x800;
 		static const int glyph_border_size = 1;
 	};
 }
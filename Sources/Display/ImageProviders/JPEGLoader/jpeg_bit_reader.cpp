@@ -38,6 +38,11 @@ namespace clan
 		buffer.resize(16 * 1024);
 	}
 
+	JPEGBitReader::JPEGBitReader(const std::vector<unsigned char> &data)
+		: reader(nullptr), buffer(data), length((int)data.size()), pos(0), bitpos(0)
+	{
+	}
+
 	void JPEGBitReader::reset()
 	{
 		length = 0;
@@ -55,7 +60,7 @@ namespace clan
 		}
 		if (pos == length)
 		{
-			length = reader->read_entropy_data(&buffer[0], buffer.size());
+			length = reader ? reader->read_entropy_data(&buffer[0], buffer.size()) : 0;
 			if (length == 0)
 			{
 				//JPEGMarker marker = reader->read_marker();
@@ -37,6 +37,9 @@ namespace clan
 	public:
 		JPEGBitReader(JPEGFileReader *reader);
 
+		// Reads from entropy data already extracted from the file, such as one restart interval
+		JPEGBitReader(const std::vector<unsigned char> &data);
+
 		void reset();
 		unsigned int get_bit();
 		unsigned int get_bits(int count);
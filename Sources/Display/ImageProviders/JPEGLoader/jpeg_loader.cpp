@@ -32,53 +32,69 @@
 #include "jpeg_huffman_decoder.h"
 #include "jpeg_mcu_decoder.h"
 #include "jpeg_rgb_decoder.h"
+#include "API/Core/System/work_queue.h"
 
 namespace clan
 {
-	PixelBuffer JPEGLoader::load(IODevice iodevice, bool srgb)
+	PixelBuffer JPEGLoader::load(IODevice iodevice, bool srgb, WorkQueue *queue)
 	{
-		JPEGLoader loader(iodevice);
-		JPEGMCUDecoder mcu_decoder(&loader);
-		JPEGRGBDecoder rgb_decoder(&loader);
+		JPEGLoader loader(iodevice, queue);
 
 		int image_width = loader.start_of_frame.width;
 		int image_height = loader.start_of_frame.height;
 		PixelBuffer image(image_width, image_height, srgb ? TextureFormat::srgb8_alpha8 : TextureFormat::rgba8);
 		unsigned int *image_pixels = reinterpret_cast<unsigned int *>(image.get_data());
 
+		if (queue && loader.mcu_height > 1)
+		{
+			// Each item reconstructs a band of MCU rows with its own decoders, as they keep their output in member buffers
+			int num_items = min(loader.mcu_height, (queue->get_num_workers() + 1) * 4);
+			WorkGroup group(*queue);
+			for (int i = 0; i < num_items; i++)
+			{
+				int first_row = loader.mcu_height * i / num_items;
+				int end_row = loader.mcu_height * (i + 1) / num_items;
+				group.run([&loader, first_row, end_row, image_pixels, image_width, image_height]()
+				{
+					loader.decode_mcu_rows(first_row, end_row, image_pixels, image_width, image_height);
+				});
+			}
+			group.wait();
+		}
+		else
+		{
+			loader.decode_mcu_rows(0, loader.mcu_height, image_pixels, image_width, image_height);
+		}
+
+		return image;
+	}
+
+	void JPEGLoader::decode_mcu_rows(int first_row, int end_row, unsigned int *image_pixels, int image_width, int image_height)
+	{
+		JPEGMCUDecoder mcu_decoder(this);
+		JPEGRGBDecoder rgb_decoder(this);
+
 		const unsigned int *block_pixels = rgb_decoder.get_pixels();
 		int block_width = rgb_decoder.get_width();
 		int block_height = rgb_decoder.get_height();
 
-		for (int curMcuY = 0, y = 0; curMcuY < loader.mcu_height; curMcuY++, y += block_height)
+		for (int curMcuY = first_row, y = first_row * block_height; curMcuY < end_row; curMcuY++, y += block_height)
 		{
-			for (int curMcuX = 0, x = 0; curMcuX < loader.mcu_width; curMcuX++, x += block_width)
+			for (int curMcuX = 0, x = 0; curMcuX < mcu_width; curMcuX++, x += block_width)
 			{
-				mcu_decoder.decode(curMcuX + curMcuY * loader.mcu_width);
+				mcu_decoder.decode(curMcuX + curMcuY * mcu_width);
 				rgb_decoder.decode(&mcu_decoder);
 
 				int w = min(block_width, image_width - x);
 				int h = min(block_height, image_height - y);
 				for (int yy = 0; yy < h; yy++)
-				{
-					for (int xx = 0; xx < w; xx++)
-					{
-						unsigned int p = block_pixels[xx + yy*block_width];
-						unsigned int red = (p >> 16) & 0xff;
-						unsigned int green = (p >> 8) & 0xff;
-						unsigned int blue = p & 0xff;
-						unsigned int alpha = (p >> 24) & 0xff;
-						image_pixels[x + xx + (y + yy)*image_width] = (alpha << 24) | (blue << 16) | (green << 8) | red;
-					}
-				}
+					memcpy(image_pixels + x + (y + yy)*image_width, block_pixels + yy*block_width, w * sizeof(unsigned int));
 			}
 		}
-
-		return image;
 	}
 
-	JPEGLoader::JPEGLoader(IODevice iodevice)
-		: progressive(false), scan_count(0), mcu_x(0), mcu_y(0), mcu_width(0), mcu_height(0), restart_interval(0), eobrun(0), is_jfif_jpeg(false), is_adobe_jpeg(false), adobe_app14_transform(1)
+	JPEGLoader::JPEGLoader(IODevice iodevice, WorkQueue *queue)
+		: progressive(false), scan_count(0), mcu_x(0), mcu_y(0), mcu_width(0), mcu_height(0), restart_interval(0), eobrun(0), is_jfif_jpeg(false), is_adobe_jpeg(false), adobe_app14_transform(1), queue(queue)
 	{
 		JPEGFileReader reader(iodevice);
 
@@ -305,6 +321,12 @@ namespace clan
 		verify_dc_table_selector(start_of_scan);
 		verify_ac_table_selector(start_of_scan);
 
+		if (queue && restart_interval != 0 && mcu_width*mcu_height > restart_interval)
+		{
+			process_sos_sequential_parallel(start_of_scan, component_to_sof, reader);
+			return;
+		}
+
 		JPEGBitReader bit_reader(&reader);
 		int restart_counter = 0;
 		for (int mcu_block = 0; mcu_block < mcu_width*mcu_height; mcu_block++)
@@ -324,46 +346,95 @@ namespace clan
 			}
 			restart_counter++;
 
-			for (size_t c = 0; c < start_of_scan.components.size(); c++)
+			decode_sequential_mcu(mcu_block, start_of_scan, component_to_sof, bit_reader, last_dc_values.data());
+		}
+	}
+
+	void JPEGLoader::process_sos_sequential_parallel(JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader)
+	{
+		// The DC predictors restart at every restart marker, which makes each interval decodable on its own.
+		// The intervals are extracted from the file first, as finding a marker requires reading everything before it.
+		int mcu_count = mcu_width*mcu_height;
+		int num_intervals = (mcu_count + restart_interval - 1) / restart_interval;
+
+		std::vector<std::vector<unsigned char>> intervals(num_intervals);
+		std::vector<unsigned char> chunk(16 * 1024);
+		for (int i = 0; i < num_intervals; i++)
+		{
+			if (i != 0)
+			{
+				JPEGMarker marker = reader.read_marker();
+				if (marker < marker_rst0 || marker > marker_rst7)
+				{
+					throw Exception("Restart marker missing between JPEG entropy data");
+				}
+			}
+
+			while (true)
 			{
-				int c_sof = component_to_sof[c];
-				const JPEGHuffmanTable &dc_table = huffman_dc_tables[start_of_scan.components[c].dc_table_selector];
-				const JPEGHuffmanTable &ac_table = huffman_ac_tables[start_of_scan.components[c].ac_table_selector];
-				int scale_x = start_of_frame.components[c_sof].horz_sampling_factor;
-				int scale_y = start_of_frame.components[c_sof].vert_sampling_factor;
-				for (int i = 0; i < scale_x * scale_y; i++)
+				int length = reader.read_entropy_data(&chunk[0], chunk.size());
+				if (length == 0)
+					break;
+				intervals[i].insert(intervals[i].end(), chunk.begin(), chunk.begin() + length);
+			}
+		}
+
+		WorkGroup group(*queue);
+		group.parallel_for(0, num_intervals, [&](int i)
+		{
+			std::vector<short> dc_values(start_of_frame.components.size());
+			JPEGBitReader bit_reader(intervals[i]);
+			int end_block = min((i + 1) * restart_interval, mcu_count);
+			for (int mcu_block = i * restart_interval; mcu_block < end_block; mcu_block++)
+				decode_sequential_mcu(mcu_block, start_of_scan, component_to_sof, bit_reader, dc_values.data());
+		}, max(4096 / restart_interval, 1));
+		group.wait();
+
+		for (auto & elem : last_dc_values)
+			elem = 0;
+	}
+
+	void JPEGLoader::decode_sequential_mcu(int mcu_block, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGBitReader &bit_reader, short *dc_values)
+	{
+		for (size_t c = 0; c < start_of_scan.components.size(); c++)
+		{
+			int c_sof = component_to_sof[c];
+			const JPEGHuffmanTable &dc_table = huffman_dc_tables[start_of_scan.components[c].dc_table_selector];
+			const JPEGHuffmanTable &ac_table = huffman_ac_tables[start_of_scan.components[c].ac_table_selector];
+			int scale_x = start_of_frame.components[c_sof].horz_sampling_factor;
+			int scale_y = start_of_frame.components[c_sof].vert_sampling_factor;
+			for (int i = 0; i < scale_x * scale_y; i++)
+			{
+				short *dct = component_dcts[c_sof].get(mcu_block*scale_x*scale_y + i);
+				for (int j = start_of_scan.start_dct_coefficient; j <= start_of_scan.end_dct_coefficient; j++)
 				{
-					short *dct = component_dcts[c_sof].get(mcu_block*scale_x*scale_y + i);
-					for (int j = start_of_scan.start_dct_coefficient; j <= start_of_scan.end_dct_coefficient; j++)
+					if (j == 0) // DCT DC coefficient
 					{
-						if (j == 0) // DCT DC coefficient
-						{
-							unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, dc_table);
-							if (code != huffman_eob)
-								dct[0] = JPEGHuffmanDecoder::decode_number(bit_reader, code);
-							dct[0] <<= start_of_scan.point_transform;
+						unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, dc_table);
+						if (code != huffman_eob)
+							dct[0] = JPEGHuffmanDecoder::decode_number(bit_reader, code);
+						dct[0] <<= start_of_scan.point_transform;
 
-							dct[0] += last_dc_values[c_sof];
-							last_dc_values[c_sof] = dct[0];
-						}
-						else // DCT AC coefficient
+						dct[0] += dc_values[c_sof];
+						dc_values[c_sof] = dct[0];
+					}
+					else // DCT AC coefficient
+					{
+						unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, ac_table);
+						if (code != huffman_eob)
 						{
-							unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, ac_table);
-							if (code != huffman_eob)
+							unsigned int zeros = (code >> 4);
+							j += zeros;
+							if (j <= start_of_scan.end_dct_coefficient)
 							{
-								unsigned int zeros = (code >> 4);
-								j += zeros;
-								if (j <= start_of_scan.end_dct_coefficient)
-								{
-									dct[zigzag_map[j]] = JPEGHuffmanDecoder::decode_number(bit_reader, code & 0x0f);
-									dct[zigzag_map[j]] <<= start_of_scan.point_transform;
-								}
-							}
-							else
-							{
-								break;
+								dct[zigzag_map[j]] = JPEGHuffmanDecoder::decode_number(bit_reader, code & 0x0f);
+								dct[zigzag_map[j]] <<= start_of_scan.point_transform;
 							}
 						}
+						else
+						{
+							break;
+						}
 					}
 				}
 			}
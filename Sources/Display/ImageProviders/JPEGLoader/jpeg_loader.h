@@ -41,11 +41,13 @@
 namespace clan
 {
 	class JPEGBitReader;
+	class WorkQueue;
 
 	class JPEGLoader
 	{
 	public:
-		static PixelBuffer load(IODevice iodevice, bool srgb);
+		// Decodes on the worker threads of queue when one is passed in
+		static PixelBuffer load(IODevice iodevice, bool srgb, WorkQueue *queue = nullptr);
 
 	private:
 		enum ColorSpace
@@ -57,13 +59,15 @@ namespace clan
 			colorspace_grayscale
 		};
 
-		JPEGLoader(IODevice iodevice);
+		JPEGLoader(IODevice iodevice, WorkQueue *queue);
 
 		void process_app0(JPEGFileReader &reader);
 		void process_app14(JPEGFileReader &reader);
 		void process_dnl(JPEGFileReader &reader);
 		void process_sos(JPEGFileReader &reader);
 		void process_sos_sequential(JPEGStartOfScan &start_of_scan, std::vector<int> component_to_sof, JPEGFileReader &reader);
+		void process_sos_sequential_parallel(JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader);
+		void decode_sequential_mcu(int mcu_block, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGBitReader &bit_reader, short *dc_values);
 		void process_sos_progressive(JPEGStartOfScan &start_of_scan, std::vector<int> component_to_sof, JPEGFileReader &reader);
 		void process_dqt(JPEGFileReader &reader);
 		void process_dht(JPEGFileReader &reader);
@@ -71,6 +75,7 @@ namespace clan
 		void verify_dc_table_selector(const JPEGStartOfScan &start_of_scan);
 		void verify_ac_table_selector(const JPEGStartOfScan &start_of_scan);
 		ColorSpace get_colorspace() const;
+		void decode_mcu_rows(int first_row, int end_row, unsigned int *image_pixels, int image_width, int image_height);
 
 		JPEGStartOfFrame start_of_frame;
 		JPEGHuffmanTable huffman_dc_tables[4];
@@ -91,6 +96,8 @@ namespace clan
 		bool is_adobe_jpeg;
 		int adobe_app14_transform;
 
+		WorkQueue *queue;
+
 		static int zigzag_map[64];
 
 		friend class JPEGMCUDecoder;
@@ -42,8 +42,11 @@
 namespace clan
 {
 	JPEGRGBDecoder::JPEGRGBDecoder(JPEGLoader *loader)
-		: loader(loader), mcu_x(0), mcu_y(0), pixels(nullptr)
+		: loader(loader), colorspace(loader->get_colorspace()), use_sse2(false), mcu_x(0), mcu_y(0), pixels(nullptr)
 	{
+#ifndef CL_DISABLE_SSE2
+		use_sse2 = System::detect_cpu_extension(System::sse2);
+#endif
 		mcu_x = loader->mcu_x;
 		mcu_y = loader->mcu_y;
 		try
@@ -72,14 +75,14 @@ namespace clan
 	{
 		upsample(mcu_decoder);
 
-		switch (loader->get_colorspace())
+		switch (colorspace)
 		{
 		case JPEGLoader::colorspace_grayscale:
 			convert_monochrome();
 			break;
 		case JPEGLoader::colorspace_ycrcb:
 #ifndef CL_DISABLE_SSE2
-			if (System::detect_cpu_extension(System::sse2))
+			if (use_sse2)
 				convert_ycrcb_sse();
 			else
 				convert_ycrcb_float();
@@ -202,7 +205,7 @@ namespace clan
 				G = _mm_add_ps(_mm_min_ps(_mm_max_ps(G, _mm_setzero_ps()), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
 				B = _mm_add_ps(_mm_min_ps(_mm_max_ps(B, _mm_setzero_ps()), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
 
-				_mm_store_si128(reinterpret_cast<__m128i*>(p_line + x), _mm_add_epi32(_mm_set1_epi32(0xff000000), _mm_add_epi32(_mm_add_epi32(_mm_cvttps_epi32(B), _mm_slli_epi32(_mm_cvttps_epi32(G), 8)), _mm_slli_epi32(_mm_cvttps_epi32(R), 16))));
+				_mm_store_si128(reinterpret_cast<__m128i*>(p_line + x), _mm_add_epi32(_mm_set1_epi32(0xff000000), _mm_add_epi32(_mm_add_epi32(_mm_cvttps_epi32(R), _mm_slli_epi32(_mm_cvttps_epi32(G), 8)), _mm_slli_epi32(_mm_cvttps_epi32(B), 16))));
 			}
 		}
 	}
@@ -238,7 +241,7 @@ namespace clan
 				G += 0.5f;
 				B += 0.5f;
 
-				pixels[x + y*width] = 0xff000000 + ((unsigned int)B) + (((unsigned int)G) << 8) + (((unsigned int)R) << 16);
+				pixels[x + y*width] = 0xff000000 + ((unsigned int)R) + (((unsigned int)G) << 8) + (((unsigned int)B) << 16);
 			}
 		}
 	}
@@ -254,7 +257,7 @@ namespace clan
 				int R = channels[0][x + y*width];
 				int G = channels[1][x + y*width];
 				int B = channels[2][x + y*width];
-				pixels[x + y*width] = 0xff000000 + ((unsigned int)B) + (((unsigned int)G) << 8) + (((unsigned int)R) << 16);
+				pixels[x + y*width] = 0xff000000 + ((unsigned int)R) + (((unsigned int)G) << 8) + (((unsigned int)B) << 16);
 			}
 		}
 	}
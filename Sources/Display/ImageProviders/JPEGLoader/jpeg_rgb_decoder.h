@@ -43,6 +43,8 @@ namespace clan
 
 		int get_width() const { return mcu_x * 8; }
 		int get_height() const { return mcu_y * 8; }
+
+		// Pixels in rgba8 byte order, ready to be copied into a PixelBuffer
 		const unsigned int *get_pixels() const { return pixels; }
 
 	private:
@@ -53,6 +55,8 @@ namespace clan
 		void convert_rgb();
 
 		JPEGLoader *loader;
+		int colorspace;
+		bool use_sse2;
 		int mcu_x, mcu_y;
 		unsigned int *pixels;
 		std::vector<unsigned char *> channels;
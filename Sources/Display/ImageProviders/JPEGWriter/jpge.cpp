@@ -26,7 +26,7 @@ namespace clan_jpge {
 	static inline void jpge_free(void *p) { free(p); }
 
 	// Various JPEG enums and tables.
-	enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_APP0 = 0xE0 };
+	enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_APP0 = 0xE0, M_DRI = 0xDD, M_RST0 = 0xD0 };
 	enum { DC_LUM_CODES = 12, AC_LUM_CODES = 256, DC_CHROMA_CODES = 12, AC_CHROMA_CODES = 256, MAX_HUFF_SYMBOLS = 257, MAX_HUFF_CODESIZE = 32 };
 
 	static uint8 s_zag[64] = { 0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
@@ -338,6 +338,14 @@ namespace clan_jpge {
 		}
 	}
 
+	// Emit restart interval.
+	void jpeg_encoder::emit_dri()
+	{
+		emit_marker(M_DRI);
+		emit_word(4);
+		emit_word(m_params.m_restart_interval);
+	}
+
 	// emit start of scan
 	void jpeg_encoder::emit_sos()
 	{
@@ -365,6 +373,8 @@ namespace clan_jpge {
 		emit_dqt();
 		emit_sof();
 		emit_dhts();
+		if (m_params.m_restart_interval)
+			emit_dri();
 		emit_sos();
 	}
 
@@ -422,6 +432,8 @@ namespace clan_jpge {
 	{
 		m_bit_buffer = 0; m_bits_in = 0;
 		memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
+		m_mcus_in_interval = 0;
+		m_restart_num = 0;
 		m_mcu_y_ofs = 0;
 		m_pass_num = 1;
 	}
@@ -733,12 +745,34 @@ namespace clan_jpge {
 			code_coefficients_pass_two(component_num);
 	}
 
+	// Called before each MCU. Ends the current restart interval when it is full.
+	void jpeg_encoder::code_restart()
+	{
+		if (!m_params.m_restart_interval)
+			return;
+		if (m_mcus_in_interval == m_params.m_restart_interval)
+		{
+			if (m_pass_num == 2)
+			{
+				put_bits(0x7F, 7);
+				m_bit_buffer = 0; m_bits_in = 0;
+				JPGE_PUT_BYTE(0xFF);
+				JPGE_PUT_BYTE(M_RST0 + m_restart_num);
+				m_restart_num = (m_restart_num + 1) & 7;
+			}
+			memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
+			m_mcus_in_interval = 0;
+		}
+		m_mcus_in_interval++;
+	}
+
 	void jpeg_encoder::process_mcu_row()
 	{
 		if (m_num_components == 1)
 		{
 			for (int i = 0; i < m_mcus_per_row; i++)
 			{
+				code_restart();
 				load_block_8_8_grey(i); code_block(0);
 			}
 		}
@@ -746,6 +780,7 @@ namespace clan_jpge {
 		{
 			for (int i = 0; i < m_mcus_per_row; i++)
 			{
+				code_restart();
 				load_block_8_8(i, 0, 0); code_block(0); load_block_8_8(i, 0, 1); code_block(1); load_block_8_8(i, 0, 2); code_block(2);
 			}
 		}
@@ -753,6 +788,7 @@ namespace clan_jpge {
 		{
 			for (int i = 0; i < m_mcus_per_row; i++)
 			{
+				code_restart();
 				load_block_8_8(i * 2 + 0, 0, 0); code_block(0); load_block_8_8(i * 2 + 1, 0, 0); code_block(0);
 				load_block_16_8_8(i, 1); code_block(1); load_block_16_8_8(i, 2); code_block(2);
 			}
@@ -761,6 +797,7 @@ namespace clan_jpge {
 		{
 			for (int i = 0; i < m_mcus_per_row; i++)
 			{
+				code_restart();
 				load_block_8_8(i * 2 + 0, 0, 0); code_block(0); load_block_8_8(i * 2 + 1, 0, 0); code_block(0);
 				load_block_8_8(i * 2 + 0, 1, 0); code_block(0); load_block_8_8(i * 2 + 1, 1, 0); code_block(0);
 				load_block_16_8(i, 1); code_block(1); load_block_16_8(i, 2); code_block(2);
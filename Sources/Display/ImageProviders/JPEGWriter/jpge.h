@@ -19,12 +19,13 @@ namespace clan_jpge
 	// JPEG compression parameters structure.
 	struct params
 	{
-		inline params() : m_quality(85), m_subsampling(H2V2), m_no_chroma_discrim_flag(false), m_two_pass_flag(false) { }
+		inline params() : m_quality(85), m_subsampling(H2V2), m_no_chroma_discrim_flag(false), m_two_pass_flag(false), m_restart_interval(0) { }
 
 		inline bool check() const
 		{
 			if ((m_quality < 1) || (m_quality > 100)) return false;
 			if ((uint)m_subsampling > (uint)H2V2) return false;
+			if ((m_restart_interval < 0) || (m_restart_interval > 65535)) return false;
 			return true;
 		}
 
@@ -43,6 +44,10 @@ namespace clan_jpge
 		bool m_no_chroma_discrim_flag;
 
 		bool m_two_pass_flag;
+
+		// Number of MCU's between restart markers, or 0 to not emit any.
+		// Restart intervals can be decoded independently of each other.
+		int m_restart_interval;
 	};
 
 	// Writes JPEG image to a file. 
@@ -119,6 +124,8 @@ namespace clan_jpge
 		uint8 m_huff_val[4][256];
 		uint32 m_huff_count[4][256];
 		int m_last_dc_val[3];
+		int m_mcus_in_interval;
+		uint8 m_restart_num;
 		enum { JPGE_OUT_BUF_SIZE = 2048 };
 		uint8 m_out_buf[JPGE_OUT_BUF_SIZE];
 		uint8 *m_pOut_buf;
@@ -137,6 +144,7 @@ namespace clan_jpge
 		void emit_sof();
 		void emit_dht(uint8 *bits, uint8 *val, int index, bool ac_flag);
 		void emit_dhts();
+		void emit_dri();
 		void emit_sos();
 		void emit_markers();
 		void compute_huffman_table(uint *codes, uint8 *code_sizes, uint8 *bits, uint8 *val);
@@ -155,6 +163,7 @@ namespace clan_jpge
 		void code_coefficients_pass_one(int component_num);
 		void code_coefficients_pass_two(int component_num);
 		void code_block(int component_num);
+		void code_restart();
 		void process_mcu_row();
 		bool terminate_pass_one();
 		bool terminate_pass_two();
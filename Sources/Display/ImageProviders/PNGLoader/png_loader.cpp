@@ -28,34 +28,47 @@
 
 #include "Display/precomp.h"
 #include "png_loader.h"
-#include "API/Display/Image/pixel_buffer_lock.h"
-#include "API/Core/Zip/zlib_compression.h"
 #include "API/Core/System/system.h"
 #include "Display/ImageProviders/PNGWriter/png_writer.h"
 
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace clan
 {
 	PixelBuffer PNGLoader::load(IODevice iodevice, bool srgb)
 	{
-		PNGLoader loader(iodevice, srgb);
+		PNGLoader loader(iodevice, srgb, nullptr);
+		loader.read_magic();
+		loader.read_chunks();
 		return loader.image;
 	}
 
-	PNGLoader::PNGLoader(IODevice iodevice, bool force_srgb)
-		: file(iodevice), force_srgb(force_srgb), scanline(nullptr), prev_scanline(nullptr), scanline_4ub(nullptr), scanline_4us(nullptr), palette(nullptr)
+	void PNGLoader::load(IODevice iodevice, bool srgb, const RowCallback &row_callback)
+	{
+		PNGLoader loader(iodevice, srgb, &row_callback);
+		loader.read_magic();
+		loader.read_chunks();
+	}
+
+	PNGLoader::PNGLoader(IODevice iodevice, bool force_srgb, const RowCallback *row_callback)
+		: file(iodevice), force_srgb(force_srgb), row_callback(row_callback), use_sse2(false), zstream_initialized(false), pass(0), row_y(0), row_pixel_length(0), row_byte_length(0), row_pos(0), rows_done(false), scanline_size(0),
+		scanline(nullptr), prev_scanline(nullptr), scanline_4ub(nullptr), scanline_4us(nullptr), palette(nullptr)
 	{
-		read_magic();
-		read_chunks();
-		decode_header();
-		decode_palette();
-		decode_colorkey();
-		decode_image();
+#ifndef CL_DISABLE_SSE2
+		use_sse2 = System::detect_cpu_extension(System::sse2);
+#endif
 	}
 
 	PNGLoader::~PNGLoader()
 	{
-		System::aligned_free(scanline);
-		System::aligned_free(prev_scanline);
+		if (zstream_initialized)
+			mz_inflateEnd(&zstream);
+		if (scanline)
+			System::aligned_free(scanline - 16);
+		if (prev_scanline)
+			System::aligned_free(prev_scanline - 16);
 		System::aligned_free(scanline_4ub);
 		System::aligned_free(scanline_4us);
 		System::aligned_free(palette);
@@ -76,8 +89,8 @@ namespace clan
 
 		std::map<std::string, DataBuffer> chunks;
 
-		std::vector<DataBuffer> idat_chunks;
-		uint64_t total_idat_size = 0;
+		bool idat_started = false;
+		bool idat_ended = false;
 
 		while (true)
 		{
@@ -86,8 +99,46 @@ namespace clan
 			name[4] = 0;
 			file.read(name, 4);
 
+			if (length >= (1u << 31))
+				throw Exception("Invalid PNG image file");
+
+			if (name == std::string("IDAT")) // The image data is inflated while it is read, as the chunks arrive
+			{
+				if (idat_ended) // IDAT chunks must be consecutive
+					throw Exception("Invalid PNG image file");
+
+				if (!idat_started)
+				{
+					// All chunks needed to decode the image have to come before the image data
+					ihdr = chunks["IHDR"];
+					plte = chunks["PLTE"];
+
+					trns = chunks["tRNS"];
+					chrm = chunks["cHRM"];
+					gama = chunks["gAMA"];
+					iccp = chunks["iCCP"];
+					sbit = chunks["sBIT"];
+					srgb = chunks["sRGB"];
+
+					if (ihdr.is_null() || ihdr.get_size() != 13) // Always required chunks
+						throw Exception("Invalid PNG image file");
+
+					decode_header();
+					decode_palette();
+					decode_colorkey();
+					begin_image();
+					idat_started = true;
+				}
+
+				read_idat(length);
+				continue;
+			}
+
+			idat_ended = idat_started;
+
 			DataBuffer data(length);
-			file.read(data.get_data(), data.get_size());
+			if (file.read(data.get_data(), data.get_size()) != data.get_size())
+				throw Exception("Invalid PNG image file");
 
 			unsigned int crc32 = file.read_uint32();
 
@@ -95,42 +146,33 @@ namespace clan
 			if (crc32 != compare_crc32)
 				throw Exception("CRC32 error");
 
-			if (name == std::string("IDAT")) // Concatenate all IDAT chunks to one big
-			{
-				total_idat_size += length;
-				idat_chunks.push_back(data);
-			}
-			else
-			{
-				chunks[name] = data;
-				if (name == std::string("IEND")) // image trailer, which is the last chunk in a PNG datastream.
-					break;
-			}
+			chunks[name] = data;
+			if (name == std::string("IEND")) // image trailer, which is the last chunk in a PNG datastream.
+				break;
 		}
 
-		if (total_idat_size >= (1 << 31))
-			throw Exception("PNG image file too big!");
+		if (!idat_started)
+			throw Exception("Invalid PNG image file");
 
-		idat = DataBuffer((int)total_idat_size);
-		int idat_pos = 0;
-		for (auto & idat_chunk : idat_chunks)
-		{
-			memcpy(idat.get_data() + idat_pos, idat_chunk.get_data(), idat_chunk.get_size());
-			idat_pos += idat_chunk.get_size();
-		}
+		end_image();
+	}
 
-		ihdr = chunks["IHDR"];
-		plte = chunks["PLTE"];
+	void PNGLoader::read_idat(unsigned int length)
+	{
+		unsigned int crc32 = PNGCRC32::begin("IDAT");
+		while (length > 0)
+		{
+			int size = (int)min(length, (unsigned int)idat_buffer.size());
+			if (file.read(idat_buffer.data(), size) != size)
+				throw Exception("Invalid PNG image file");
 
-		trns = chunks["tRNS"];
-		chrm = chunks["cHRM"];
-		gama = chunks["gAMA"];
-		iccp = chunks["iCCP"];
-		sbit = chunks["sBIT"];
-		srgb = chunks["sRGB"];
+			crc32 = PNGCRC32::update(crc32, idat_buffer.data(), size);
+			inflate_image_data(idat_buffer.data(), size);
+			length -= size;
+		}
 
-		if (ihdr.is_null() || idat_chunks.empty() || ihdr.get_size() != 13) // Always required chunks
-			throw Exception("Invalid PNG image file");
+		if (file.read_uint32() != PNGCRC32::end(crc32))
+			throw Exception("CRC32 error");
 	}
 
 	void PNGLoader::decode_header()
@@ -160,6 +202,8 @@ namespace clan
 		// Guard against possible buffer overruns and other edge-cases when image size is gigantic:
 		if (image_width >= (1 << 23) || image_height >= (1 << 23))
 			throw Exception("PNG image is too big");
+		if (image_width == 0 || image_height == 0)
+			throw Exception("Invalid PNG image file");
 	}
 
 	void PNGLoader::decode_palette()
@@ -217,40 +261,201 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::decode_image()
+	namespace
 	{
-		DataBuffer image_data = ZLibCompression::decompress(idat, false);
+		const int adam7_starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
+		const int adam7_starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
+		const int adam7_row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
+		const int adam7_col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	}
 
-		create_image();
+	void PNGLoader::begin_image()
+	{
 		create_scanline_buffers();
+		create_image();
+
+		idat_buffer.resize(64 * 1024);
+
+		memset(&zstream, 0, sizeof(zstream));
+		if (mz_inflateInit(&zstream) != MZ_OK)
+			throw Exception("Zlib inflateInit failed");
+		zstream_initialized = true;
+
+		pass = 0;
+		row_y = 0;
+		memset(prev_scanline, 0, scanline_size);
+		begin_row();
+	}
+
+	void PNGLoader::inflate_image_data(const unsigned char *data, int length)
+	{
+		if (!zstream_initialized) // Anything after the end of the zlib stream is ignored
+			return;
+
+		zstream.next_in = data;
+		zstream.avail_in = length;
+		while (true)
+		{
+			// Each scanline is inflated directly into the scanline buffer, including its filter type byte
+			unsigned char discard[256];
+			if (!rows_done)
+			{
+				zstream.next_out = scanline - 1 + row_pos;
+				zstream.avail_out = row_byte_length + 1 - row_pos;
+			}
+			else
+			{
+				zstream.next_out = discard;
+				zstream.avail_out = sizeof(discard);
+			}
+
+			int result = mz_inflate(&zstream, MZ_NO_FLUSH);
+			if (result != MZ_OK && result != MZ_STREAM_END && result != MZ_BUF_ERROR)
+				throw Exception("PNG image data is corrupted");
 
+			if (!rows_done)
+			{
+				row_pos = row_byte_length + 1 - zstream.avail_out;
+				if (row_pos == row_byte_length + 1)
+				{
+					decode_row();
+					next_row();
+				}
+			}
+
+			if (result == MZ_STREAM_END)
+			{
+				mz_inflateEnd(&zstream);
+				zstream_initialized = false;
+				break;
+			}
+
+			// Inflate may still hold output after consuming all input, so only stop when the output buffer was not filled
+			if (result == MZ_BUF_ERROR || (zstream.avail_in == 0 && zstream.avail_out != 0))
+				break;
+		}
+	}
+
+	void PNGLoader::end_image()
+	{
+		if (!rows_done)
+			throw Exception("Invalid PNG image file");
+
+		if (row_callback && interlace_method == 1)
+			emit_rows();
+	}
+
+	void PNGLoader::begin_row()
+	{
 		if (interlace_method == 0)
 		{
-			decode_interlace_none(reinterpret_cast<const unsigned char*>(image_data.get_data()), image_data.get_size());
+			rows_done = (row_y == image_height);
+			row_pixel_length = image_width;
 		}
-		else if (interlace_method == 1)
+		else
 		{
-			decode_interlace_adam7(reinterpret_cast<const unsigned char*>(image_data.get_data()), image_data.get_size());
+			// Small images have Adam7 passes without any pixels
+			while (pass < 7 && (row_y >= (int)image_height || adam7_starting_col[pass] >= (int)image_width))
+			{
+				pass++;
+				if (pass < 7)
+					row_y = adam7_starting_row[pass];
+				memset(prev_scanline, 0, scanline_size);
+			}
+
+			rows_done = (pass == 7);
+			if (!rows_done)
+				row_pixel_length = (image_width - adam7_starting_col[pass] + adam7_col_increment[pass] - 1) / adam7_col_increment[pass];
+		}
+
+		row_byte_length = (row_pixel_length * bit_depth * get_image_data_channels() + 7) / 8;
+		row_pos = 0;
+	}
+
+	void PNGLoader::next_row()
+	{
+		unsigned char *tmp = scanline;
+		scanline = prev_scanline;
+		prev_scanline = tmp;
+
+		row_y += (interlace_method == 0) ? 1 : adam7_row_increment[pass];
+		begin_row();
+	}
+
+	void PNGLoader::decode_row()
+	{
+		filter_scanline(scanline[-1], row_byte_length);
+
+		if (interlace_method == 0)
+		{
+			if (row_callback)
+			{
+				if (bit_depth <= 8)
+					convert_scanline_4ub(row_pixel_length, scanline_4ub);
+				else
+					convert_scanline_4us(row_pixel_length, scanline_4us);
+				(*row_callback)(row_y, row_image);
+			}
+			else
+			{
+				if (bit_depth <= 8)
+					convert_scanline_4ub(row_pixel_length, reinterpret_cast<Vec4ub*>(image.get_line(row_y)));
+				else
+					convert_scanline_4us(row_pixel_length, reinterpret_cast<Vec4us*>(image.get_line(row_y)));
+			}
 		}
 		else
 		{
-			throw Exception("Invalid PNG image file");
+			if (bit_depth <= 8)
+				convert_scanline_4ub(row_pixel_length, scanline_4ub);
+			else
+				convert_scanline_4us(row_pixel_length, scanline_4us);
+
+			unsigned char *output_line = image.get_line_uint8(row_y);
+			int scanline_pos = 0;
+			for (int x = adam7_starting_col[pass]; x < image_width; x += adam7_col_increment[pass])
+			{
+				if (bit_depth <= 8)
+					*reinterpret_cast<Vec4ub*>(output_line + x * 4) = scanline_4ub[scanline_pos++];
+				else
+					*reinterpret_cast<Vec4us*>(output_line + x * 8) = scanline_4us[scanline_pos++];
+			}
+		}
+	}
+
+	void PNGLoader::emit_rows()
+	{
+		int row_size = image_width * (bit_depth <= 8 ? 4 : 8);
+		void *row_data = bit_depth <= 8 ? static_cast<void*>(scanline_4ub) : static_cast<void*>(scanline_4us);
+		for (int y = 0; y < image_height; y++)
+		{
+			memcpy(row_data, image.get_line(y), row_size);
+			(*row_callback)(y, row_image);
 		}
 	}
 
 	void PNGLoader::create_image()
 	{
+		TextureFormat format = TextureFormat::rgba16;
 		if (bit_depth <= 8)
-			image = PixelBuffer(image_width, image_height, force_srgb ? TextureFormat::srgb8_alpha8 : TextureFormat::rgba8);
-		else
-			image = PixelBuffer(image_width, image_height, TextureFormat::rgba16);
+			format = force_srgb ? TextureFormat::srgb8_alpha8 : TextureFormat::rgba8;
+
+		if (row_callback)
+		{
+			void *row_data = bit_depth <= 8 ? static_cast<void*>(scanline_4ub) : static_cast<void*>(scanline_4us);
+			row_image = PixelBuffer(image_width, 1, format, row_data, true);
+		}
+
+		if (!row_callback || interlace_method == 1)
+			image = PixelBuffer(image_width, image_height, format);
 	}
 
 	void PNGLoader::create_scanline_buffers()
 	{
-		int size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
-		scanline = static_cast<unsigned char *>(System::aligned_alloc(size));
-		prev_scanline = static_cast<unsigned char *>(System::aligned_alloc(size));
+		// 16 bytes in front of the scanlines for the filter type byte
+		scanline_size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
+		scanline = static_cast<unsigned char *>(System::aligned_alloc(scanline_size + 16)) + 16;
+		prev_scanline = static_cast<unsigned char *>(System::aligned_alloc(scanline_size + 16)) + 16;
 		scanline_4ub = static_cast<Vec4ub *>(System::aligned_alloc(image_width * sizeof(Vec4ub)));
 		scanline_4us = static_cast<Vec4us *>(System::aligned_alloc(image_width * sizeof(Vec4us)));
 	}
@@ -268,115 +473,179 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::decode_interlace_none(const unsigned char *data, int data_length)
+	void PNGLoader::filter_scanline(int predictor_type, int scanline_byte_length)
 	{
-		int scanline_size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
-		if ((1 + scanline_size) * image_height > data_length)
-			throw Exception("Invalid PNG image file");
-
-		for (size_t i = 0; i < scanline_size; i++)
-			scanline[i] = 0;
+#ifndef CL_DISABLE_SSE2
+		if (use_sse2 && filter_scanline_sse(predictor_type, scanline_byte_length))
+			return;
+#endif
 
-		int data_pos = 0;
-		PixelBufferLockAny pixels(image);
-		for (int y = 0; y < image_height; y++)
+		int channels = get_image_data_channels();
+		switch (predictor_type)
 		{
-			unsigned char *tmp = scanline;
-			scanline = prev_scanline;
-			prev_scanline = tmp;
-
-			int predictor_type = data[data_pos++];
-			memcpy(scanline, data + data_pos, scanline_size);
-			data_pos += scanline_size;
-
-			filter_scanline(predictor_type, scanline_size);
+		case 0: break; // none
+		case 1: predictor_sub(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
+		case 2: predictor_up(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
+		case 3: predictor_average(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
+		case 4: predictor_paeth(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
+		default: throw Exception("Invalid PNG image file");
+		}
+	}
 
-			if (bit_depth <= 8)
-				convert_scanline_4ub(image_width);
+#ifndef CL_DISABLE_SSE2
+	namespace
+	{
+		// The Sub, Average and Paeth predictors depend on the pixel to the left, so they are
+		// vectorized across the bytes of one pixel while stepping through the scanline.
+		template<int bytes_per_pixel>
+		inline __m128i load_pixel(const unsigned char *p)
+		{
+			if (bytes_per_pixel == 4)
+			{
+				int v;
+				memcpy(&v, p, 4);
+				return _mm_cvtsi32_si128(v);
+			}
+			else if (bytes_per_pixel == 8)
+			{
+				return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+			}
 			else
-				convert_scanline_4us(image_width);
+			{
+				unsigned char v[8] = { 0 };
+				memcpy(v, p, bytes_per_pixel);
+				return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v));
+			}
+		}
 
-			unsigned char *output_line = pixels.get_row(y);
-			if (bit_depth <= 8)
-				memcpy(output_line, scanline_4ub, image_width * 4);
+		template<int bytes_per_pixel>
+		inline void store_pixel(unsigned char *p, __m128i pixel)
+		{
+			if (bytes_per_pixel == 4)
+			{
+				int v = _mm_cvtsi128_si32(pixel);
+				memcpy(p, &v, 4);
+			}
+			else if (bytes_per_pixel == 8)
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(p), pixel);
+			}
 			else
-				memcpy(output_line, scanline_4us, image_width * 8);
+			{
+				unsigned char v[8];
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(v), pixel);
+				memcpy(p, v, bytes_per_pixel);
+			}
 		}
-	}
-
-	void PNGLoader::decode_interlace_adam7(const unsigned char *data, int data_length)
-	{
-		int scanline_size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
 
-		int data_pos = 0;
-		int channels = get_image_data_channels();
+		inline __m128i abs_epi16(__m128i v)
+		{
+			return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+		}
 
-		int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
-		int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
-		int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
-		int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
-		//int block_height[7]  = { 8, 8, 4, 4, 2, 2, 1 };
-		//int block_width[7]   = { 8, 4, 4, 2, 2, 1, 1 };
+		inline __m128i select_si128(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
 
-		PixelBufferLockAny pixels(image);
-		unsigned char *output = pixels.get_data();
-		int output_pitch = pixels.get_pitch();
-		for (int pass = 0; pass < 7; pass++)
+		template<int bytes_per_pixel>
+		void predictor_sub_sse(unsigned char *scanline, int byte_length)
 		{
-			for (size_t i = 0; i < scanline_size; i++)
-				scanline[i] = 0;
+			__m128i a = _mm_setzero_si128();
+			for (int i = 0; i < byte_length; i += bytes_per_pixel)
+			{
+				a = _mm_add_epi8(load_pixel<bytes_per_pixel>(scanline + i), a);
+				store_pixel<bytes_per_pixel>(scanline + i, a);
+			}
+		}
 
-			for (int y = starting_row[pass]; y < image_height; y += row_increment[pass])
+		template<int bytes_per_pixel>
+		void predictor_average_sse(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length)
+		{
+			__m128i a = _mm_setzero_si128();
+			for (int i = 0; i < byte_length; i += bytes_per_pixel)
 			{
-				if (starting_col[pass] < image_width)
-				{
-					unsigned char *tmp = scanline;
-					scanline = prev_scanline;
-					prev_scanline = tmp;
+				__m128i b = load_pixel<bytes_per_pixel>(prev_scanline + i);
+				__m128i x = load_pixel<bytes_per_pixel>(scanline + i);
 
-					int scanline_pixel_length = (image_width - starting_col[pass] + col_increment[pass] - 1) / col_increment[pass];
-					int scanline_byte_length = (scanline_pixel_length * bit_depth * channels + 7) / 8;
+				// _mm_avg_epu8 rounds up, while the predictor rounds down
+				__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+				a = _mm_add_epi8(x, average);
+				store_pixel<bytes_per_pixel>(scanline + i, a);
+			}
+		}
 
-					if (data_pos + scanline_byte_length > data_length)
-						throw Exception("Invalid PNG image file");
+		template<int bytes_per_pixel>
+		void predictor_paeth_sse(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length)
+		{
+			__m128i zero = _mm_setzero_si128();
+			__m128i a = zero;
+			__m128i c = zero;
+			for (int i = 0; i < byte_length; i += bytes_per_pixel)
+			{
+				__m128i b = _mm_unpacklo_epi8(load_pixel<bytes_per_pixel>(prev_scanline + i), zero);
+				__m128i x = _mm_unpacklo_epi8(load_pixel<bytes_per_pixel>(scanline + i), zero);
+
+				// With p = a + b - c: p - a = b - c, p - b = a - c and p - c = (p - a) + (p - b)
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = abs_epi16(pa);
+				pb = abs_epi16(pb);
+				pc = abs_epi16(pc);
+
+				__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				__m128i nearest = select_si128(_mm_cmpeq_epi16(smallest, pa), a, select_si128(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+				a = _mm_and_si128(_mm_add_epi16(x, nearest), _mm_set1_epi16(0xff));
+				store_pixel<bytes_per_pixel>(scanline + i, _mm_packus_epi16(a, a));
+				c = b;
+			}
+		}
 
-					int predictor_type = data[data_pos++];
-					memcpy(scanline, data + data_pos, scanline_byte_length);
-					data_pos += scanline_byte_length;
-
-					filter_scanline(predictor_type, scanline_byte_length);
-
-					if (bit_depth <= 8)
-						convert_scanline_4ub(scanline_pixel_length);
-					else
-						convert_scanline_4us(scanline_pixel_length);
-
-					int scanline_pos = 0;
-					for (int x = starting_col[pass]; x < image_width; x += col_increment[pass])
-					{
-						if (bit_depth <= 8)
-							*reinterpret_cast<Vec4ub*>(output + y * output_pitch + x * 4) = scanline_4ub[scanline_pos++];
-						else
-							*reinterpret_cast<Vec4us*>(output + y * output_pitch + x * 8) = scanline_4us[scanline_pos++];
-					}
-				}
+		template<int bytes_per_pixel>
+		bool filter_pixels_sse(int predictor_type, unsigned char *scanline, const unsigned char *prev_scanline, int byte_length)
+		{
+			switch (predictor_type)
+			{
+			case 1: predictor_sub_sse<bytes_per_pixel>(scanline, byte_length); return true;
+			case 3: predictor_average_sse<bytes_per_pixel>(scanline, prev_scanline, byte_length); return true;
+			case 4: predictor_paeth_sse<bytes_per_pixel>(scanline, prev_scanline, byte_length); return true;
+			default: return false;
 			}
 		}
 	}
 
-	void PNGLoader::filter_scanline(int predictor_type, int scanline_byte_length)
+	bool PNGLoader::filter_scanline_sse(int predictor_type, int scanline_byte_length)
 	{
-		int channels = get_image_data_channels();
-		switch (predictor_type)
+		if (predictor_type == 0)
+			return true;
+
+		if (predictor_type == 2) // Up does not depend on neighbour pixels and works on whole registers
 		{
-		case 0: break; // none
-		case 1: predictor_sub(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 2: predictor_up(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 3: predictor_average(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 4: predictor_paeth(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		default: throw Exception("Invalid PNG image file");
+			int i = 0;
+			for (; i + 16 <= scanline_byte_length; i += 16)
+			{
+				__m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(scanline + i));
+				__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(prev_scanline + i));
+				_mm_store_si128(reinterpret_cast<__m128i*>(scanline + i), _mm_add_epi8(x, b));
+			}
+			for (; i < scanline_byte_length; i++)
+				scanline[i] += prev_scanline[i];
+			return true;
+		}
+
+		int bytes_per_pixel = get_image_data_channels() * ((bit_depth + 7) / 8);
+		switch (bytes_per_pixel)
+		{
+		case 3: return filter_pixels_sse<3>(predictor_type, scanline, prev_scanline, scanline_byte_length);
+		case 4: return filter_pixels_sse<4>(predictor_type, scanline, prev_scanline, scanline_byte_length);
+		case 6: return filter_pixels_sse<6>(predictor_type, scanline, prev_scanline, scanline_byte_length);
+		case 8: return filter_pixels_sse<8>(predictor_type, scanline, prev_scanline, scanline_byte_length);
+		default: return false;
 		}
 	}
+#endif
 
 	void PNGLoader::predictor_sub(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth)
 	{
@@ -436,32 +705,32 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::convert_scanline_4ub(int scanline_pixel_length)
+	void PNGLoader::convert_scanline_4ub(int scanline_pixel_length, Vec4ub *output)
 	{
 		switch (color_type)
 		{
-		case 0: grayscale_to_4ub(scanline_pixel_length); break;
-		case 2: truecolor_to_4ub(scanline_pixel_length); break;
-		case 3: indexed_to_4ub(scanline_pixel_length); break;
-		case 4: grayscale_alpha_to_4ub(scanline_pixel_length); break;
-		case 6: truecolor_alpha_to_4ub(scanline_pixel_length); break;
+		case 0: grayscale_to_4ub(scanline_pixel_length, output); break;
+		case 2: truecolor_to_4ub(scanline_pixel_length, output); break;
+		case 3: indexed_to_4ub(scanline_pixel_length, output); break;
+		case 4: grayscale_alpha_to_4ub(scanline_pixel_length, output); break;
+		case 6: truecolor_alpha_to_4ub(scanline_pixel_length, output); break;
 		default: throw Exception("Invalid PNG image file");
 		}
 	}
 
-	void PNGLoader::convert_scanline_4us(int scanline_pixel_length)
+	void PNGLoader::convert_scanline_4us(int scanline_pixel_length, Vec4us *output)
 	{
 		switch (color_type)
 		{
-		case 0: grayscale_to_4us(scanline_pixel_length); break;
-		case 2: truecolor_to_4us(scanline_pixel_length); break;
-		case 4: grayscale_alpha_to_4us(scanline_pixel_length); break;
-		case 6: truecolor_alpha_to_4us(scanline_pixel_length); break;
+		case 0: grayscale_to_4us(scanline_pixel_length, output); break;
+		case 2: truecolor_to_4us(scanline_pixel_length, output); break;
+		case 4: grayscale_alpha_to_4us(scanline_pixel_length, output); break;
+		case 6: truecolor_alpha_to_4us(scanline_pixel_length, output); break;
 		default: throw Exception("Invalid PNG image file");
 		}
 	}
 
-	void PNGLoader::grayscale_to_4ub(int count)
+	void PNGLoader::grayscale_to_4ub(int count, Vec4ub *output)
 	{
 		unsigned char *input = scanline;
 		if (bit_depth == 1)
@@ -470,21 +739,21 @@ namespace clan
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = i % 8;
+					int shift = 7 - i % 8;
 					unsigned char value = (input[i / 8] >> shift) & 1;
 					value = static_cast<int>(value)* 255;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
+					output[i] = Vec4ub(value, value, value, 255);
 				}
 			}
 			else
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = i % 8;
+					int shift = 7 - i % 8;
 					unsigned char value = (input[i / 8] >> shift) & 1;
 					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
 					value = static_cast<int>(value)* 255;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+					output[i] = Vec4ub(value, value, value, alpha);
 				}
 			}
 		}
@@ -494,21 +763,21 @@ namespace clan
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 4) * 2;
+					int shift = (3 - i % 4) * 2;
 					unsigned char value = (input[i / 4] >> shift) & 3;
-					value = (static_cast<int>(value)* 255 + 1) / 2;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
+					value = static_cast<int>(value)* 85;
+					output[i] = Vec4ub(value, value, value, 255);
 				}
 			}
 			else
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 4) * 2;
+					int shift = (3 - i % 4) * 2;
 					unsigned char value = (input[i / 4] >> shift) & 3;
 					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					value = (static_cast<int>(value)* 255 + 1) / 2;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+					value = static_cast<int>(value)* 85;
+					output[i] = Vec4ub(value, value, value, alpha);
 				}
 			}
 		}
@@ -518,21 +787,21 @@ namespace clan
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 2) * 4;
-					unsigned char value = (input[i / 4] >> shift) & 15;
-					value = (static_cast<int>(value)* 255 + 8) / 16;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
+					int shift = (1 - i % 2) * 4;
+					unsigned char value = (input[i / 2] >> shift) & 15;
+					value = static_cast<int>(value)* 17;
+					output[i] = Vec4ub(value, value, value, 255);
 				}
 			}
 			else
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 2) * 4;
-					unsigned char value = (input[i / 4] >> shift) & 15;
+					int shift = (1 - i % 2) * 4;
+					unsigned char value = (input[i / 2] >> shift) & 15;
 					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					value = (static_cast<int>(value)* 255 + 8) / 16;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+					value = static_cast<int>(value)* 17;
+					output[i] = Vec4ub(value, value, value, alpha);
 				}
 			}
 		}
@@ -543,7 +812,7 @@ namespace clan
 				for (int i = 0; i < count; i++)
 				{
 					unsigned char value = input[i];
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
+					output[i] = Vec4ub(value, value, value, 255);
 				}
 			}
 			else
@@ -552,7 +821,7 @@ namespace clan
 				{
 					unsigned char value = input[i];
 					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+					output[i] = Vec4ub(value, value, value, alpha);
 				}
 			}
 		}
@@ -562,7 +831,7 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::truecolor_to_4ub(int count)
+	void PNGLoader::truecolor_to_4ub(int count, Vec4ub *output)
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
@@ -576,7 +845,7 @@ namespace clan
 				unsigned char red = input[i * 3 + 0];
 				unsigned char green = input[i * 3 + 1];
 				unsigned char blue = input[i * 3 + 2];
-				scanline_4ub[i] = Vec4ub(red, green, blue, 255);
+				output[i] = Vec4ub(red, green, blue, 255);
 			}
 		}
 		else
@@ -589,39 +858,39 @@ namespace clan
 				unsigned char alpha = 255;
 				if (red == colorkey.r && green == colorkey.g && blue == colorkey.b)
 					alpha = 0;
-				scanline_4ub[i] = Vec4ub(red, green, blue, alpha);
+				output[i] = Vec4ub(red, green, blue, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::indexed_to_4ub(int count)
+	void PNGLoader::indexed_to_4ub(int count, Vec4ub *output)
 	{
 		unsigned char *input = scanline;
 		if (bit_depth == 1)
 		{
 			for (int i = 0; i < count; i++)
 			{
-				int shift = i % 8;
+				int shift = 7 - i % 8;
 				unsigned char value = (input[i / 8] >> shift) & 1;
-				scanline_4ub[i] = palette[value];
+				output[i] = palette[value];
 			}
 		}
 		else if (bit_depth == 2)
 		{
 			for (int i = 0; i < count; i++)
 			{
-				int shift = (i % 4) * 2;
+				int shift = (3 - i % 4) * 2;
 				unsigned char value = (input[i / 4] >> shift) & 3;
-				scanline_4ub[i] = palette[value];
+				output[i] = palette[value];
 			}
 		}
 		else if (bit_depth == 4)
 		{
 			for (int i = 0; i < count; i++)
 			{
-				int shift = (i % 2) * 4;
-				unsigned char value = (input[i / 4] >> shift) & 15;
-				scanline_4ub[i] = palette[value];
+				int shift = (1 - i % 2) * 4;
+				unsigned char value = (input[i / 2] >> shift) & 15;
+				output[i] = palette[value];
 			}
 		}
 		else if (bit_depth == 8)
@@ -629,7 +898,7 @@ namespace clan
 			for (int i = 0; i < count; i++)
 			{
 				unsigned char value = input[i];
-				scanline_4ub[i] = palette[value];
+				output[i] = palette[value];
 			}
 		}
 		else
@@ -638,7 +907,7 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::grayscale_alpha_to_4ub(int count)
+	void PNGLoader::grayscale_alpha_to_4ub(int count, Vec4ub *output)
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
@@ -648,27 +917,19 @@ namespace clan
 		{
 			unsigned char value = input[i * 2];
 			unsigned char alpha = input[i * 2 + 1];
-			scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+			output[i] = Vec4ub(value, value, value, alpha);
 		}
 	}
 
-	void PNGLoader::truecolor_alpha_to_4ub(int count)
+	void PNGLoader::truecolor_alpha_to_4ub(int count, Vec4ub *output)
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
 
-		unsigned char *input = scanline;
-		for (int i = 0; i < count; i++)
-		{
-			unsigned char red = input[i * 4 + 0];
-			unsigned char green = input[i * 4 + 1];
-			unsigned char blue = input[i * 4 + 2];
-			unsigned char alpha = input[i * 4 + 3];
-			scanline_4ub[i] = Vec4ub(red, green, blue, alpha);
-		}
+		std::copy(scanline, scanline + count * 4, reinterpret_cast<unsigned char*>(output));
 	}
 
-	void PNGLoader::grayscale_to_4us(int count)
+	void PNGLoader::grayscale_to_4us(int count, Vec4us *output)
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
@@ -679,7 +940,7 @@ namespace clan
 			for (int i = 0; i < count; i++)
 			{
 				unsigned short value = from_network_order(input[i]);
-				scanline_4us[i] = Vec4us(value, value, value, 65535);
+				output[i] = Vec4us(value, value, value, 65535);
 			}
 		}
 		else
@@ -688,12 +949,12 @@ namespace clan
 			{
 				unsigned short value = from_network_order(input[i]);
 				unsigned short alpha = (value != colorkey.r) ? 65535 : 0;
-				scanline_4us[i] = Vec4us(value, value, value, alpha);
+				output[i] = Vec4us(value, value, value, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::truecolor_to_4us(int count)
+	void PNGLoader::truecolor_to_4us(int count, Vec4us *output)
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
@@ -706,7 +967,7 @@ namespace clan
 				unsigned short red = from_network_order(input[i * 3 + 0]);
 				unsigned short green = from_network_order(input[i * 3 + 1]);
 				unsigned short blue = from_network_order(input[i * 3 + 2]);
-				scanline_4us[i] = Vec4us(red, green, blue, 65535);
+				output[i] = Vec4us(red, green, blue, 65535);
 			}
 		}
 		else
@@ -719,12 +980,12 @@ namespace clan
 				unsigned short alpha = 65535;
 				if (red == colorkey.r && green == colorkey.g && blue == colorkey.b)
 					alpha = 0;
-				scanline_4us[i] = Vec4us(red, green, blue, alpha);
+				output[i] = Vec4us(red, green, blue, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::grayscale_alpha_to_4us(int count)
+	void PNGLoader::grayscale_alpha_to_4us(int count, Vec4us *output)
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
@@ -734,11 +995,11 @@ namespace clan
 		{
 			unsigned short value = from_network_order(input[i * 2]);
 			unsigned short alpha = from_network_order(input[i * 2 + 1]);
-			scanline_4us[i] = Vec4us(value, value, value, alpha);
+			output[i] = Vec4us(value, value, value, alpha);
 		}
 	}
 
-	void PNGLoader::truecolor_alpha_to_4us(int count)
+	void PNGLoader::truecolor_alpha_to_4us(int count, Vec4us *output)
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
@@ -750,7 +1011,7 @@ namespace clan
 			unsigned short green = from_network_order(input[i * 4 + 1]);
 			unsigned short blue = from_network_order(input[i * 4 + 2]);
 			unsigned short alpha = from_network_order(input[i * 4 + 3]);
-			scanline_4us[i] = Vec4us(red, green, blue, alpha);
+			output[i] = Vec4us(red, green, blue, alpha);
 		}
 	}
 }
@@ -31,6 +31,8 @@
 #include "API/Core/IOData/iodevice.h"
 #include "API/Display/Image/pixel_buffer.h"
 #include "API/Core/System/databuffer.h"
+#include "Core/Zip/miniz.h"
+#include <functional>
 #include <map>
 
 namespace clan
@@ -38,19 +40,31 @@ namespace clan
 	class PNGLoader
 	{
 	public:
+		typedef std::function<void(int y, const PixelBuffer &row)> RowCallback;
+
 		static PixelBuffer load(IODevice iodevice, bool srgb);
 
+		// Calls row_callback for each scanline from top to bottom instead of keeping the image in memory.
+		// Interlaced images are only complete after the last pass and are therefore still decoded to an image first.
+		static void load(IODevice iodevice, bool srgb, const RowCallback &row_callback);
+
 	private:
-		PNGLoader(IODevice iodevice, bool force_srgb);
+		PNGLoader(IODevice iodevice, bool force_srgb, const RowCallback *row_callback);
 		~PNGLoader();
 		void read_magic();
 		void read_chunks();
+		void read_idat(unsigned int length);
 		void decode_header();
 		void decode_palette();
 		void decode_colorkey();
-		void decode_image();
-		void decode_interlace_none(const unsigned char *data, int data_length);
-		void decode_interlace_adam7(const unsigned char *data, int data_length);
+
+		void begin_image();
+		void inflate_image_data(const unsigned char *data, int length);
+		void end_image();
+		void begin_row();
+		void next_row();
+		void decode_row();
+		void emit_rows();
 
 		void create_image();
 		void create_scanline_buffers();
@@ -61,20 +75,21 @@ namespace clan
 		static void predictor_up(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
 		static void predictor_average(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
 		static void predictor_paeth(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
+		bool filter_scanline_sse(int predictor_type, int scanline_byte_length);
 
-		void convert_scanline_4ub(int scanline_pixel_length);
-		void convert_scanline_4us(int scanline_pixel_length);
+		void convert_scanline_4ub(int scanline_pixel_length, Vec4ub *output);
+		void convert_scanline_4us(int scanline_pixel_length, Vec4us *output);
 
-		void grayscale_to_4ub(int count);
-		void truecolor_to_4ub(int count);
-		void indexed_to_4ub(int count);
-		void grayscale_alpha_to_4ub(int count);
-		void truecolor_alpha_to_4ub(int count);
+		void grayscale_to_4ub(int count, Vec4ub *output);
+		void truecolor_to_4ub(int count, Vec4ub *output);
+		void indexed_to_4ub(int count, Vec4ub *output);
+		void grayscale_alpha_to_4ub(int count, Vec4ub *output);
+		void truecolor_alpha_to_4ub(int count, Vec4ub *output);
 
-		void grayscale_to_4us(int count);
-		void truecolor_to_4us(int count);
-		void grayscale_alpha_to_4us(int count);
-		void truecolor_alpha_to_4us(int count);
+		void grayscale_to_4us(int count, Vec4us *output);
+		void truecolor_to_4us(int count, Vec4us *output);
+		void grayscale_alpha_to_4us(int count, Vec4us *output);
+		void truecolor_alpha_to_4us(int count, Vec4us *output);
 
 		static int abs(int a) { return a >= 0 ? a : -a; }
 
@@ -92,12 +107,14 @@ namespace clan
 
 		IODevice file;
 		bool force_srgb;
+		const RowCallback *row_callback;
+		bool use_sse2;
 
 		PixelBuffer image;
+		PixelBuffer row_image; // Wraps the converted scanline passed to the row callback
 
 		DataBuffer ihdr; // image header, which is the first chunk in a PNG datastream.
 		DataBuffer plte; // palette table associated with indexed PNG images.
-		DataBuffer idat; // image data chunks.
 
 		DataBuffer trns; // Transparency information
 		DataBuffer chrm; // Colour space information (5 chunks)
@@ -114,6 +131,19 @@ namespace clan
 		unsigned char filter_method;
 		unsigned char interlace_method;
 
+		// Image data is inflated one scanline at a time. The filter type byte of a scanline is
+		// stored just before it, which keeps the scanline itself 16 byte aligned.
+		mz_stream zstream;
+		bool zstream_initialized;
+		std::vector<unsigned char> idat_buffer;
+		int pass;
+		int row_y;
+		int row_pixel_length;
+		int row_byte_length;
+		int row_pos;
+		bool rows_done;
+		int scanline_size;
+
 		unsigned char *scanline;
 		unsigned char *prev_scanline;
 		Vec4ub *scanline_4ub;
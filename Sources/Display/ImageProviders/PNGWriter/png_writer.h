@@ -58,22 +58,36 @@ namespace clan
 	public:
 		static unsigned long crc(const char name[4], const void *data, int len)
 		{
-			static PNGCRC32 impl;
-			
-			const unsigned char *buf = reinterpret_cast<const unsigned char*>(data);
-			
-			unsigned int c = 0xffffffff;
+			return end(update(begin(name), data, len));
+		}
 
-			for (int n = 0; n < 4; n++)
-				c = impl.crc_table[(c ^ name[n]) & 0xff] ^ (c >> 8);
+		/// \brief Starts a CRC of a chunk whose data is processed in several parts
+		static unsigned int begin(const char name[4])
+		{
+			return update(0xffffffff, name, 4);
+		}
 
+		static unsigned int update(unsigned int c, const void *data, int len)
+		{
+			const PNGCRC32 &impl = instance();
+			const unsigned char *buf = reinterpret_cast<const unsigned char*>(data);
 			for (int n = 0; n < len; n++)
 				c = impl.crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
+			return c;
+		}
 
+		static unsigned int end(unsigned int c)
+		{
 			return c ^ 0xffffffff;
 		}
-		
+
 	private:
+		static const PNGCRC32 &instance()
+		{
+			static PNGCRC32 impl;
+			return impl;
+		}
+
 		unsigned int crc_table[256];
 		
 		PNGCRC32()
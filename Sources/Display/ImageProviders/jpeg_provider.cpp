@@ -64,21 +64,42 @@ namespace clan
 		return JPEGProvider::load(filename, vfs, srgb);
 	}
 
+	PixelBuffer JPEGProvider::load(
+		IODevice &file,
+		WorkQueue &queue,
+		bool srgb)
+	{
+		return JPEGLoader::load(file, srgb, &queue);
+	}
+
+	PixelBuffer JPEGProvider::load(
+		const std::string &fullname,
+		WorkQueue &queue,
+		bool srgb)
+	{
+		std::string path = PathHelp::get_fullpath(fullname, PathHelp::path_type_file);
+		std::string filename = PathHelp::get_filename(fullname, PathHelp::path_type_file);
+		FileSystem vfs(path);
+		return JPEGLoader::load(vfs.open_file(filename), srgb, &queue);
+	}
+
 	void JPEGProvider::save(
 		PixelBuffer buffer,
 		const std::string &fullname,
-		int quality)
+		int quality,
+		int restart_interval)
 	{
 		std::string path = PathHelp::get_fullpath(fullname, PathHelp::path_type_file);
 		std::string filename = PathHelp::get_filename(fullname, PathHelp::path_type_file);
 		FileSystem vfs(path);
-		return JPEGProvider::save(buffer, filename, vfs, quality);
+		return JPEGProvider::save(buffer, filename, vfs, quality, restart_interval);
 	}
 
 	void JPEGProvider::save(
 		PixelBuffer buffer,
 		IODevice &file,
-		int quality)
+		int quality,
+		int restart_interval)
 	{
 		if (buffer.get_format() != TextureFormat::rgb8)
 		{
@@ -87,12 +108,14 @@ namespace clan
 			buffer = newbuf;
 		}
 
-		DataBuffer output(buffer.get_width() * buffer.get_height() * 5);
+		// Room for the headers even if the image is tiny
+		DataBuffer output(max(buffer.get_width() * buffer.get_height() * 5, 4096));
 		int size = output.get_size();
 
 		clan_jpge::params desc;
 		desc.m_quality = quality;
-		bool result = clan_jpge::compress_image_to_jpeg_file_in_memory(output.get_data(), size, buffer.get_width(), buffer.get_height(), 3, output.get_data<clan_jpge::uint8>(), desc);
+		desc.m_restart_interval = restart_interval;
+		bool result = clan_jpge::compress_image_to_jpeg_file_in_memory(output.get_data(), size, buffer.get_width(), buffer.get_height(), 3, buffer.get_data<clan_jpge::uint8>(), desc);
 		if (!result)
 			throw Exception("Unable to compress JPEG image");
 
@@ -103,9 +126,10 @@ namespace clan
 		PixelBuffer buffer,
 		const std::string &filename,
 		FileSystem &fs,
-		int quality)
+		int quality,
+		int restart_interval)
 	{
 		IODevice iodev = fs.open_file(filename, File::create_always, File::access_read_write);
-		save(buffer, iodev, quality);
+		save(buffer, iodev, quality, restart_interval);
 	}
 }
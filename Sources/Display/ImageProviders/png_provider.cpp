@@ -62,6 +62,11 @@ namespace clan
 		return PNGLoader::load(file, srgb);
 	}
 
+	void PNGProvider::load_rows(IODevice &file, const std::function<void(int y, const PixelBuffer &row)> &row_callback, bool srgb)
+	{
+		PNGLoader::load(file, srgb, row_callback);
+	}
+
 	void PNGProvider::save(
 		PixelBuffer buffer,
 		const std::string &filename,
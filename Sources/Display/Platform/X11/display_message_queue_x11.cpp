@@ -137,11 +137,12 @@ namespace clan
 	bool DisplayMessageQueue_X11::process(int timeout_ms)
 	{
 		auto time_start = System::get_time();
-		int x11_handle = ConnectionNumber(display);
 
 		while (true)
 		{
-			process_message();
+			// The display is opened by the first window. Targets without X11 windows, such as clanSWRender, never open it.
+			if (display)
+				process_message();
 
 			auto time_now = System::get_time();
 			int time_remaining_ms = timeout_ms - (time_now - time_start);
@@ -161,11 +162,17 @@ namespace clan
 			fd_set rfds;
 			FD_ZERO(&rfds);
 
-			FD_SET(x11_handle, &rfds);
 			FD_SET(async_work_event.read_fd(), &rfds);
 			FD_SET(exit_event.read_fd(), &rfds);
+			int max_handle = std::max(async_work_event.read_fd(), exit_event.read_fd());
+			if (display)
+			{
+				int x11_handle = ConnectionNumber(display);
+				FD_SET(x11_handle, &rfds);
+				max_handle = std::max(max_handle, x11_handle);
+			}
 
-			int result = select(std::max(std::max(async_work_event.read_fd(), x11_handle), exit_event.read_fd()) + 1, &rfds, nullptr, nullptr, &tv);
+			int result = select(max_handle + 1, &rfds, nullptr, nullptr, &tv);
 			if (result > 0)
 			{
 				if (FD_ISSET(async_work_event.read_fd(), &rfds))
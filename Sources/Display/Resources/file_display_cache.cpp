@@ -58,11 +58,21 @@ namespace clan
 		auto it = sprites.find(id);
 		if (it != sprites.end())
 		{
+			if (preloading.find(id) != preloading.end())
+				return it->second;
+
 			Resource<Sprite> sprite = it->second;
 			sprite.get() = sprite.get().clone();
 			return sprite;
 		}
 
+		if (preloading.find(id) != preloading.end())
+		{
+			Resource<Sprite> placeholder;
+			sprites[id] = placeholder;
+			return placeholder;
+		}
+
 		Resource<Sprite> sprite = Sprite(canvas, id, doc.get_file_system());
 		sprites[id] = sprite;
 		sprite.get() = sprite.get().clone();
@@ -74,11 +84,21 @@ namespace clan
 		auto it = images.find(id);
 		if (it != images.end())
 		{
+			if (preloading.find(id) != preloading.end())
+				return it->second;
+
 			Resource<Image> image = it->second;
 			image.get() = image.get().clone();
 			return image;
 		}
 
+		if (preloading.find(id) != preloading.end())
+		{
+			Resource<Image> placeholder;
+			images[id] = placeholder;
+			return placeholder;
+		}
+
 		Resource<Image> image = Image(canvas, id, doc.get_file_system());
 		images[id] = image;
 		image.get() = image.get().clone();
@@ -111,4 +131,59 @@ namespace clan
 
 		return font;
 	}
+
+	void FileDisplayCache::preload(const std::vector<std::string> &ids, WorkQueue &queue, const std::function<void(const DisplayPreloadProgress &)> &progress)
+	{
+		preloader.set_progress_callback(progress);
+		for (const auto &id : ids)
+		{
+			if (sprites.find(id) != sprites.end() || images.find(id) != images.end() || textures.find(id) != textures.end())
+				continue;
+
+			// The type is not known before the file is requested, so the texture is preloaded and sprites and images are created from it
+			preloading.insert(id);
+			textures[id] = Resource<Texture>();
+			preloader.add(queue, doc.get_file_system(), { id }, [this, id]() { preload_completed(id); });
+		}
+	}
+
+	DisplayPreloadProgress FileDisplayCache::update_preload(Canvas &canvas, int budget_microseconds)
+	{
+		preload_canvas = &canvas;
+		return preloader.update(canvas, budget_microseconds);
+	}
+
+	void FileDisplayCache::preload_completed(const std::string &id)
+	{
+		preloading.erase(id);
+
+		Texture2D texture;
+		try
+		{
+			texture = preloader.get_texture(*preload_canvas, id, doc.get_file_system());
+		}
+		catch (...)
+		{
+			// Leave it to the next get call to load and report the error
+			sprites.erase(id);
+			images.erase(id);
+			textures.erase(id);
+			throw;
+		}
+
+		textures[id].set(texture);
+
+		auto sprite_it = sprites.find(id);
+		if (sprite_it != sprites.end())
+		{
+			Sprite sprite(*preload_canvas);
+			sprite.add_frame(texture);
+			sprite.restart();
+			sprite_it->second.set(sprite);
+		}
+
+		auto image_it = images.find(id);
+		if (image_it != images.end())
+			image_it->second.set(Image(texture, texture.get_size()));
+	}
 }
@@ -30,7 +30,9 @@
 #pragma once
 
 #include "API/Display/Resources/display_cache.h"
+#include "API/Display/Resources/texture_preloader.h"
 #include "API/Core/Resources/file_resource_document.h"
+#include <set>
 
 namespace clan
 {
@@ -47,9 +49,18 @@ namespace clan
 		Resource<Texture> get_texture(GraphicContext &gc, const std::string &id) override;
 		Resource<Font> get_font(Canvas &canvas, const std::string &family_name, const FontDescription &desc) override;
 
+		void preload(const std::vector<std::string> &ids, WorkQueue &queue, const std::function<void(const DisplayPreloadProgress &)> &progress) override;
+		DisplayPreloadProgress update_preload(Canvas &canvas, int budget_microseconds) override;
+
 	private:
+		void preload_completed(const std::string &id);
+
 		FileResourceDocument doc;
 
+		TexturePreloader preloader;
+		std::set<std::string> preloading;
+		Canvas *preload_canvas = nullptr;
+
 		std::map<std::string, Resource<Sprite> > sprites;
 		std::map<std::string, Resource<Image> > images;
 		std::map<std::string, Resource<Texture> > textures;
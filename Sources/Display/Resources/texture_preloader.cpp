@@ -0,0 +1,257 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "API/Display/Resources/texture_preloader.h"
+#include "API/Display/ImageProviders/provider_factory.h"
+#include "API/Display/Image/image_import_description.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/IOData/memory_device.h"
+#include "API/Core/IOData/path_help.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/Text/string_help.h"
+#include "texture_preloader_impl.h"
+
+namespace clan
+{
+	TexturePreloader::TexturePreloader()
+		: impl(std::make_shared<TexturePreloader_Impl>())
+	{
+	}
+
+	TexturePreloader::~TexturePreloader()
+	{
+	}
+
+	void TexturePreloader::add(WorkQueue &queue, const FileSystem &fs, const std::vector<std::string> &filenames, const std::function<void()> &create)
+	{
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		if (impl->resources.empty())
+		{
+			impl->progress = DisplayPreloadProgress();
+			impl->start_time = System::get_microseconds();
+		}
+
+		TexturePreloadResource resource;
+		resource.create = create;
+		for (const auto &filename : filenames)
+		{
+			std::shared_ptr<TexturePreloadFile> &file = impl->files[filename];
+			if (!file)
+			{
+				file = std::make_shared<TexturePreloadFile>();
+				file->filename = filename;
+				impl->progress.images_total++;
+
+				// The file system is only used on this thread. The workers just decode the bytes read here.
+				try
+				{
+					IODevice device = fs.open_file(filename);
+					file->data = DataBuffer(device.get_size());
+					device.read(file->data.get_data(), file->data.get_size());
+				}
+				catch (...)
+				{
+					file->failed = true;
+				}
+
+				if (file->failed)
+				{
+					// The upload loads the file again on the graphic context thread, which reports the error
+					file->decoded = true;
+					impl->progress.images_decoded++;
+				}
+				else
+				{
+					std::shared_ptr<TexturePreloader_Impl> preloader = impl;
+					std::shared_ptr<TexturePreloadFile> decode_file = file;
+					queue.queue([preloader, decode_file]() { preloader->decode(decode_file); });
+				}
+			}
+			file->resources++;
+			resource.files.push_back(file);
+		}
+		impl->resources.push_back(resource);
+		impl->progress.resources_total++;
+	}
+
+	Texture2D TexturePreloader::get_texture(GraphicContext &gc, const std::string &filename, const FileSystem &fs)
+	{
+		auto it = impl->files.find(filename);
+		if (it == impl->files.end())
+			return Texture2D(gc, filename, fs);
+
+		TexturePreloadFile &file = *it->second;
+		if (file.texture.is_null() && !impl->upload(gc, file))
+			file.texture = Texture2D(gc, filename, fs);
+		if (file.texture.is_null())
+			return Texture2D(gc, filename, fs);	// Decoding failed. Load again to throw the error
+		return file.texture;
+	}
+
+	DisplayPreloadProgress TexturePreloader::update(GraphicContext &gc, int budget_microseconds)
+	{
+		uint64_t start = System::get_microseconds();
+		auto out_of_time = [&]() { return System::get_microseconds() - start >= (uint64_t)budget_microseconds; };
+
+		bool work_done = true;
+		while (work_done && !impl->resources.empty())
+		{
+			work_done = false;
+			for (auto it = impl->resources.begin(); it != impl->resources.end();)
+			{
+				bool ready = true;
+				for (auto &file : it->files)
+				{
+					if (file->texture.is_null())
+					{
+						if (!impl->upload(gc, *file))
+						{
+							ready = false;
+							break;
+						}
+						work_done = true;
+						if (out_of_time())
+							return impl->get_progress();
+					}
+				}
+
+				if (!ready)
+				{
+					++it;
+					continue;
+				}
+
+				TexturePreloadResource resource = *it;
+				it = impl->resources.erase(it);
+				{
+					std::unique_lock<std::mutex> lock(impl->mutex);
+					impl->progress.resources_loaded++;
+					if (impl->resources.empty())
+						impl->progress.microseconds = System::get_microseconds() - impl->start_time;
+				}
+
+				try
+				{
+					resource.create();
+				}
+				catch (...)
+				{
+					impl->release(resource);
+					throw;
+				}
+				impl->release(resource);
+
+				if (impl->progress_callback)
+					impl->progress_callback(impl->get_progress());
+
+				work_done = true;
+				if (out_of_time())
+					return impl->get_progress();
+			}
+		}
+		return impl->get_progress();
+	}
+
+	DisplayPreloadProgress TexturePreloader::get_progress() const
+	{
+		return impl->get_progress();
+	}
+
+	void TexturePreloader::set_progress_callback(const std::function<void(const DisplayPreloadProgress &)> &callback)
+	{
+		impl->progress_callback = callback;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void TexturePreloader_Impl::decode(const std::shared_ptr<TexturePreloadFile> &file)
+	{
+		PixelBuffer pixels;
+		bool failed = false;
+		try
+		{
+			MemoryDevice memory(file->data);
+			std::string type = StringHelp::text_to_lower(PathHelp::get_extension(file->filename, PathHelp::path_type_virtual));
+			pixels = ImageProviderFactory::load(memory, type);
+			pixels = ImageImportDescription().process(pixels);
+		}
+		catch (...)
+		{
+			// The upload loads the file again on the graphic context thread, which reports the error
+			failed = true;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		file->data = DataBuffer();
+		file->pixels = pixels;
+		file->decoded = true;
+		file->failed = failed;
+		progress.images_decoded++;
+	}
+
+	bool TexturePreloader_Impl::upload(GraphicContext &gc, TexturePreloadFile &file)
+	{
+		PixelBuffer pixels;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (!file.decoded)
+				return false;
+			if (file.failed)
+				return true;
+			pixels = file.pixels;
+			file.pixels = PixelBuffer();
+		}
+		file.texture = Texture2D(gc, pixels);
+		return true;
+	}
+
+	void TexturePreloader_Impl::release(const TexturePreloadResource &resource)
+	{
+		for (auto &file : resource.files)
+		{
+			if (--file->resources == 0)
+			{
+				auto it = files.find(file->filename);
+				if (it != files.end() && it->second == file)
+					files.erase(it);
+			}
+		}
+	}
+
+	DisplayPreloadProgress TexturePreloader_Impl::get_progress()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		DisplayPreloadProgress result = progress;
+		if (!resources.empty())
+			result.microseconds = System::get_microseconds() - start_time;
+		return result;
+	}
+}
@@ -0,0 +1,86 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Resources/texture_preloader.h"
+#include "API/Display/Render/texture_2d.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Core/System/databuffer.h"
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace clan
+{
+	class TexturePreloadFile
+	{
+	public:
+		std::string filename;
+
+		/// \brief File contents, read on the thread adding the file and released once decoded
+		DataBuffer data;
+
+		/// \brief Number of pending resources using the file
+		int resources = 0;
+
+		// Set by the worker thread, guarded by TexturePreloader_Impl::mutex
+		PixelBuffer pixels;
+		bool decoded = false;
+		bool failed = false;
+
+		Texture2D texture;
+	};
+
+	class TexturePreloadResource
+	{
+	public:
+		std::vector<std::shared_ptr<TexturePreloadFile> > files;
+		std::function<void()> create;
+	};
+
+	class TexturePreloader_Impl
+	{
+	public:
+		void decode(const std::shared_ptr<TexturePreloadFile> &file);
+
+		/// \brief Uploads a decoded file. Returns false if the file is still being decoded.
+		bool upload(GraphicContext &gc, TexturePreloadFile &file);
+
+		void release(const TexturePreloadResource &resource);
+		DisplayPreloadProgress get_progress();
+
+		std::map<std::string, std::shared_ptr<TexturePreloadFile> > files;
+		std::list<TexturePreloadResource> resources;
+		std::function<void(const DisplayPreloadProgress &)> progress_callback;
+
+		std::mutex mutex;
+		DisplayPreloadProgress progress;
+		uint64_t start_time = 0;
+	};
+}
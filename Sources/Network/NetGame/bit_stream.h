@@ -0,0 +1,145 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/exception.h"
+#include <vector>
+#include <cstdint>
+
+namespace clan
+{
+	/// \brief Writes values packed at bit granularity, least significant bit first
+	class NetGameBitWriter
+	{
+	public:
+		void write_bits(uint32_t value, int bits)
+		{
+			accumulator |= (uint64_t)value << accumulator_bits;
+			accumulator_bits += bits;
+			while (accumulator_bits >= 8)
+			{
+				data.push_back((unsigned char)accumulator);
+				accumulator >>= 8;
+				accumulator_bits -= 8;
+			}
+		}
+
+		void write_bool(bool value) { write_bits(value ? 1 : 0, 1); }
+
+		/// \brief Writes an unsigned value in groups of four bits, each followed by a continuation bit
+		void write_varint(uint32_t value)
+		{
+			while (value >= 16)
+			{
+				write_bits((value & 15) | 16, 5);
+				value >>= 4;
+			}
+			write_bits(value, 5);
+		}
+
+		/// \brief Writes a signed value as a zigzag encoded varint, so small negative numbers stay short
+		void write_signed_varint(int32_t value)
+		{
+			write_varint(zigzag(value));
+		}
+
+		/// \brief Pads to a whole byte and returns the written data
+		const std::vector<unsigned char> &finish()
+		{
+			if (accumulator_bits > 0)
+				write_bits(0, 8 - accumulator_bits);
+			return data;
+		}
+
+		static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+		static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+		static int varint_bits(uint32_t value)
+		{
+			int bits = 5;
+			while (value >= 16)
+			{
+				bits += 5;
+				value >>= 4;
+			}
+			return bits;
+		}
+
+	private:
+		std::vector<unsigned char> data;
+		uint64_t accumulator = 0;
+		int accumulator_bits = 0;
+	};
+
+	/// \brief Reads values written by NetGameBitWriter. Throws an exception when reading past the end.
+	class NetGameBitReader
+	{
+	public:
+		NetGameBitReader(const void *data, unsigned int size) : data(static_cast<const unsigned char *>(data)), size(size) { }
+
+		uint32_t read_bits(int bits)
+		{
+			while (accumulator_bits < bits)
+			{
+				if (pos == size)
+					throw Exception("Snapshot data is truncated");
+				accumulator |= (uint64_t)data[pos++] << accumulator_bits;
+				accumulator_bits += 8;
+			}
+			uint32_t value = (uint32_t)(accumulator & ((((uint64_t)1) << bits) - 1));
+			accumulator >>= bits;
+			accumulator_bits -= bits;
+			return value;
+		}
+
+		bool read_bool() { return read_bits(1) != 0; }
+
+		uint32_t read_varint()
+		{
+			uint32_t value = 0;
+			for (int shift = 0; shift < 32; shift += 4)
+			{
+				uint32_t group = read_bits(5);
+				value |= (group & 15) << shift;
+				if ((group & 16) == 0)
+					return value;
+			}
+			throw Exception("Invalid varint in snapshot data");
+		}
+
+		int32_t read_signed_varint() { return NetGameBitWriter::unzigzag(read_varint()); }
+
+	private:
+		const unsigned char *data;
+		unsigned int size;
+		unsigned int pos = 0;
+		uint64_t accumulator = 0;
+		int accumulator_bits = 0;
+	};
+}
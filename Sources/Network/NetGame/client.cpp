@@ -30,6 +30,7 @@
 #include "API/Network/NetGame/client.h"
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/NetGame/event.h"
+#include "API/Network/NetGame/snapshot.h"
 #include "API/Network/Socket/socket_name.h"
 #include "network_event.h"
 #include "client_impl.h"
@@ -49,9 +50,17 @@ namespace clan
 	void NetGameClient::connect(const std::string &server, const std::string &port)
 	{
 		disconnect();
+		impl->snapshot_receiver.reset();
 		impl->connection.reset(new NetGameConnection(this, SocketName(server, port)));
 	}
 
+	void NetGameClient::connect_udp(const std::string &server, const std::string &port)
+	{
+		disconnect();
+		impl->snapshot_receiver.reset();
+		impl->connection.reset(new NetGameConnection(this, SocketName(server, port), nullptr));
+	}
+
 	void NetGameClient::disconnect()
 	{
 		if (impl->connection.get() != nullptr)
@@ -71,11 +80,33 @@ namespace clan
 			impl->connection->send_event(game_event);
 	}
 
+	void NetGameClient::send_event(const NetGameEvent &game_event, NetGameChannel channel)
+	{
+		if (impl->connection.get() != nullptr)
+			impl->connection->send_event(game_event, channel);
+	}
+
 	Signal<void(const NetGameEvent &)> &NetGameClient::sig_event_received()
 	{
 		return impl->sig_game_event_received;
 	}
 
+	Signal<void(const NetGameEventView &)> &NetGameClient::sig_event_view_received()
+	{
+		return impl->sig_game_event_view_received;
+	}
+
+	void NetGameClient::set_snapshot_schema(const NetGameSnapshotSchema &schema)
+	{
+		impl->snapshot_receiver.schema = schema;
+		impl->snapshot_receiver.has_schema = true;
+	}
+
+	Signal<void(const NetGameSnapshot &)> &NetGameClient::sig_snapshot_received()
+	{
+		return impl->sig_game_snapshot_received;
+	}
+
 	Signal<void()> &NetGameClient::sig_connected()
 	{
 		return impl->sig_game_connected;
@@ -106,7 +137,25 @@ namespace clan
 				sig_game_connected();
 				break;
 			case NetGameNetworkEvent::Type::event_received:
-				sig_game_event_received(new_event.game_event);
+				if (new_event.packet && new_event.packet->view.name_equals("_snapshot"))
+				{
+					if (snapshot_receiver.has_schema && snapshot_receiver.receive(new_event.packet->view, snapshot))
+					{
+						if (connection)
+							connection->send_event(NetGameEvent("_snapshot_ack", { snapshot.get_sequence() }));
+						sig_game_snapshot_received(snapshot);
+					}
+				}
+				else if (new_event.packet)
+				{
+					sig_game_event_view_received(new_event.packet->view);
+					if (sig_game_event_received.has_slots())
+						sig_game_event_received(new_event.packet->view.to_event());
+				}
+				else
+				{
+					sig_game_event_received(new_event.game_event);
+				}
 				break;
 			case NetGameNetworkEvent::Type::client_disconnected:
 				sig_game_disconnected();
@@ -30,6 +30,7 @@
 
 #include <memory>
 #include <mutex>
+#include "snapshot_channel.h"
 
 namespace clan
 {
@@ -42,7 +43,11 @@ namespace clan
 		std::vector<NetGameNetworkEvent> events;
 
 		std::unique_ptr<NetGameConnection> connection;
+		NetGameSnapshotReceiver snapshot_receiver;
+		NetGameSnapshot snapshot;
+		Signal<void(const NetGameSnapshot &)> sig_game_snapshot_received;
 		Signal<void(const NetGameEvent &)> sig_game_event_received;
+		Signal<void(const NetGameEventView &)> sig_game_event_view_received;
 		Signal<void()> sig_game_connected;
 		Signal<void()> sig_game_disconnected;
 	};
@@ -47,6 +47,18 @@ namespace clan
 		impl->start(this, site, socket_name);
 	}
 
+	NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor)
+		: impl(new NetGameConnection_Impl)
+	{
+		impl->start(this, site, connection, reactor);
+	}
+
+	NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name, NetGameUDPHost *host)
+		: impl(new NetGameConnection_Impl)
+	{
+		impl->start(this, site, socket_name, host);
+	}
+
 	NetGameConnection::~NetGameConnection()
 	{
 		delete impl;
@@ -67,11 +79,36 @@ namespace clan
 		impl->send_event(game_event);
 	}
 
+	void NetGameConnection::send_event(const NetGameEvent &game_event, NetGameChannel channel)
+	{
+		impl->send_packet(NetGameNetworkData::send_data(game_event), channel);
+	}
+
+	void NetGameConnection::send_packet(const DataBuffer &packet, NetGameChannel channel)
+	{
+		impl->send_packet(packet, channel);
+	}
+
 	void NetGameConnection::disconnect()
 	{
 		impl->disconnect();
 	}
 
+	void NetGameConnection::set_flush_delay(int milliseconds)
+	{
+		impl->set_flush_delay(milliseconds);
+	}
+
+	void NetGameConnection::set_send_queue_limit(int bytes)
+	{
+		impl->set_send_queue_limit(bytes);
+	}
+
+	int NetGameConnection::get_send_queue_size() const
+	{
+		return impl->get_send_queue_size();
+	}
+
 	SocketName NetGameConnection::get_remote_name() const
 	{
 		return impl->get_remote_name();
@@ -31,9 +31,12 @@
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/NetGame/connection_site.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/System/system.h"
 #include "network_event.h"
 #include "network_data.h"
 #include "connection_impl.h"
+#include "reactor.h"
+#include "udp_host.h"
 
 namespace clan
 {
@@ -60,8 +63,74 @@ namespace clan
 		thread = std::thread(&NetGameConnection_Impl::connection_main, this);
 	}
 
+	void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const TCPConnection &xconnection, NetGameReactor *xreactor)
+	{
+		base = xbase;
+		site = xsite;
+		connection = xconnection;
+		socket_name = connection.get_remote_name();
+		is_connected = true;
+		reactor = xreactor;
+
+		const int max_event_packet_size = 32000 + 2;
+		receive_buffer.set_size(max_event_packet_size);
+
+		uint64_t id = reactor->allocate_id();
+		reactor_id = id;
+		reactor->add(id, this, connection);
+	}
+
+	void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const SocketName &xsocket_name, NetGameUDPHost *host)
+	{
+		base = xbase;
+		site = xsite;
+		socket_name = xsocket_name;
+		is_udp = true;
+
+		if (host)
+		{
+			udp_host = host;
+			udp_peer = udp_host->add(base, site, socket_name, false);
+			is_connected = true;
+			return;
+		}
+
+		// Like TCP, a client connection reports failure with a disconnect event rather than an exception
+		try
+		{
+			udp_client_host.reset(new NetGameUDPHost(SocketName(), std::function<void(const SocketName &)>()));
+			udp_host = udp_client_host.get();
+			udp_peer = udp_host->add(base, site, socket_name, true);
+			udp_host->start();
+		}
+		catch (const Exception& e)
+		{
+			udp_peer.reset();
+			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(e.message)));
+		}
+		is_connected = false;
+	}
+
 	NetGameConnection_Impl::~NetGameConnection_Impl()
 	{
+		if (is_udp)
+		{
+			// Stopping the client host first lets it tell the server that the connection is gone
+			if (udp_client_host)
+				udp_client_host->stop();
+			if (udp_peer)
+				udp_host->remove(udp_peer);
+			return;
+		}
+
+		if (reactor)
+		{
+			uint64_t id = reactor_id.exchange(0);
+			if (id != 0)
+				reactor->remove(id);
+			return;
+		}
+
 		std::unique_lock<std::mutex> mutex_lock(mutex);
 		stop_flag = true;
 		mutex_lock.unlock();
@@ -98,23 +167,91 @@ namespace clan
 
 	void NetGameConnection_Impl::send_event(const NetGameEvent &game_event)
 	{
+		send_packet(NetGameNetworkData::send_data(game_event), NetGameChannel::reliable_ordered);
+	}
+
+	void NetGameConnection_Impl::send_packet(const DataBuffer &packet, NetGameChannel channel)
+	{
+		if (is_udp)
+		{
+			if (udp_peer && udp_peer->queue(packet, channel))
+				wake();
+			return;
+		}
+
 		std::unique_lock<std::mutex> mutex_lock(mutex);
+		if (send_queue_overflow)
+			return;
+
+		int size = packet.get_size();
+		int queued = send_queue_size;
+		if (send_queue_limit > 0 && queued + size > send_queue_limit)
+		{
+			send_queue_overflow = true;
+			mutex_lock.unlock();
+			wake();
+			return;
+		}
+
+		// The I/O thread drains the whole queue per wakeup, so it only needs waking when the queue
+		// goes from empty to non-empty, or when held back events have filled the flush window.
+		bool was_empty = send_queue.empty();
+		if (was_empty)
+			send_queue_start = System::get_microseconds();
+
 		Message message;
 		message.type = Message::Type::type_message;
-		message.event = game_event;
+		message.packet = packet;
 		send_queue.push_back(message);
+		send_queue_size += size;
+
+		bool window_full = flush_delay > 0 && queued < NetGameConnection::flush_size && queued + size >= NetGameConnection::flush_size;
 		mutex_lock.unlock();
-		worker_event.notify();
+
+		if (was_empty || window_full)
+			wake();
 	}
 
 	void NetGameConnection_Impl::disconnect()
 	{
+		if (is_udp)
+		{
+			if (udp_peer)
+				udp_peer->request_disconnect();
+			wake();
+			return;
+		}
+
 		std::unique_lock<std::mutex> mutex_lock(mutex);
 		Message message;
 		message.type = Message::Type::type_disconnect;
 		send_queue.push_back(message);
 		mutex_lock.unlock();
-		worker_event.notify();
+		wake();
+	}
+
+	void NetGameConnection_Impl::set_flush_delay(int milliseconds)
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		flush_delay = milliseconds;
+		mutex_lock.unlock();
+		wake();
+	}
+
+	void NetGameConnection_Impl::set_send_queue_limit(int bytes)
+	{
+		if (udp_peer)
+			udp_peer->set_send_queue_limit(bytes);
+
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		send_queue_limit = bytes;
+	}
+
+	int NetGameConnection_Impl::get_send_queue_size() const
+	{
+		if (udp_peer)
+			return udp_peer->get_send_queue_size();
+		return send_queue_size;
 	}
 
 	SocketName NetGameConnection_Impl::get_remote_name() const
@@ -122,6 +259,25 @@ namespace clan
 		return socket_name;
 	}
 
+	void NetGameConnection_Impl::wake()
+	{
+		if (is_udp)
+		{
+			if (udp_host)
+				udp_host->wake();
+		}
+		else if (reactor)
+		{
+			uint64_t id = reactor_id;
+			if (id != 0)
+				reactor->wake(id);
+		}
+		else
+		{
+			worker_event.notify();
+		}
+	}
+
 	bool NetGameConnection_Impl::read_connection_data(DataBuffer &receive_buffer, int &bytes_received)
 	{
 		while (true)
@@ -153,31 +309,60 @@ namespace clan
 
 	}
 
-	bool NetGameConnection_Impl::write_connection_data(DataBuffer &send_buffer, int &bytes_sent, bool &send_graceful_close)
+	bool NetGameConnection_Impl::write_connection_data()
 	{
-		while (true)
-		{
-			int bytes = connection.write(send_buffer.get_data() + bytes_sent, send_buffer.get_size() - bytes_sent);
-			if (bytes < 0)
-				return false;
+		flush_deadline = 0;
 
-			bytes_sent += bytes;
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		bool overflow = send_queue_overflow;
+		mutex_lock.unlock();
+		if (overflow)
+		{
+			connection.close();
+			disconnect_reason = "Send queue limit exceeded";
+			return true;
+		}
 
-			if (bytes_sent == send_buffer.get_size())
+		while (true)
+		{
+			if (send_pending_index == send_pending.size())
 			{
+				send_pending.clear();
+				send_pending_index = 0;
+				send_pending_offset = 0;
+
 				if (send_graceful_close)
 				{
 					connection.close();
 					return true;
 				}
-				else
-				{
-					bytes_sent = 0;
-					send_buffer.set_size(0);
-					send_graceful_close = write_data(send_buffer);
-					if (send_buffer.get_size() == 0)
-						return false;
-				}
+
+				if (!take_send_queue())
+					return false;
+				continue;
+			}
+
+			// Everything pending goes out with one gather write per call
+			const void *buffers[TCPConnection::max_write_buffers];
+			int sizes[TCPConnection::max_write_buffers];
+			int count = 0;
+			for (size_t i = send_pending_index; i < send_pending.size() && count < TCPConnection::max_write_buffers; i++, count++)
+			{
+				int offset = (i == send_pending_index) ? send_pending_offset : 0;
+				buffers[count] = send_pending[i].get_data() + offset;
+				sizes[count] = send_pending[i].get_size() - offset;
+			}
+
+			int bytes = connection.write(buffers, sizes, count);
+			if (bytes < 0)
+				return false;
+
+			send_queue_size -= bytes;
+			send_pending_offset += bytes;
+			while (send_pending_index < send_pending.size() && send_pending_offset >= (int)send_pending[send_pending_index].get_size())
+			{
+				send_pending_offset -= send_pending[send_pending_index].get_size();
+				send_pending_index++;
 			}
 		}
 	}
@@ -190,81 +375,127 @@ namespace clan
 				connection = TCPConnection(socket_name);
 			is_connected = true;
 			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_connected));
+		}
+		catch (const Exception& e)
+		{
+			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(e.message)));
+			return;
+		}
 
-			int bytes_received = 0;
-			int bytes_sent = 0;
-			const int max_event_packet_size = 32000 + 2;
-			DataBuffer receive_buffer(max_event_packet_size);
-			DataBuffer send_buffer;
-
-			bool send_graceful_close = false;
+		const int max_event_packet_size = 32000 + 2;
+		receive_buffer.set_size(max_event_packet_size);
 
-			while (true)
+		while (!process_io())
+		{
+			int timeout = -1;
+			if (flush_deadline != 0)
 			{
-				if (read_connection_data(receive_buffer, bytes_received))
-					break;
-				if (write_connection_data(send_buffer, bytes_sent, send_graceful_close))
-					break;
-
-				std::unique_lock<std::mutex> lock(mutex);
-				if (stop_flag)
-					break;
-				NetworkEvent *events[] = { &connection };
-				worker_event.wait(lock, 1, events);
+				uint64_t now = System::get_microseconds();
+				timeout = flush_deadline > now ? (int)((flush_deadline - now + 999) / 1000) : 0;
 			}
 
-			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected));
+			std::unique_lock<std::mutex> lock(mutex);
+			if (stop_flag)
+				break;
+			NetworkEvent *events[] = { &connection };
+			worker_event.wait(lock, 1, events, timeout);
+		}
+
+		site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(disconnect_reason)));
+	}
+
+	bool NetGameConnection_Impl::process_io()
+	{
+		try
+		{
+			if (read_connection_data(receive_buffer, bytes_received))
+				return true;
+			if (write_connection_data())
+				return true;
+			return false;
 		}
 		catch (const Exception& e)
 		{
-			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(e.message)));
+			disconnect_reason = e.message;
+			return true;
 		}
 	}
 
+	bool NetGameConnection_Impl::reactor_process()
+	{
+		// Announced from the I/O thread, as the site may be locked while the connection is constructed
+		if (!connect_announced)
+		{
+			connect_announced = true;
+			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_connected));
+		}
+		return process_io();
+	}
+
+	void NetGameConnection_Impl::reactor_finished(const std::string &error)
+	{
+		if (!error.empty())
+			disconnect_reason = error;
+		reactor_id = 0;
+		site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(disconnect_reason)));
+	}
+
 	bool NetGameConnection_Impl::read_data(const void *data, int size, int &bytes_consumed)
 	{
 		bytes_consumed = 0;
 		while (bytes_consumed != size)
 		{
 			int bytes = 0;
-			NetGameEvent incoming_event = NetGameNetworkData::receive_data(static_cast<const char*>(data)+bytes_consumed, size - bytes_consumed, bytes);
+			NetGamePacketRef packet = NetGameNetworkData::receive_packet(static_cast<const char*>(data)+bytes_consumed, size - bytes_consumed, bytes);
 			bytes_consumed += bytes;
 
 			if (bytes == 0)
 			{
 				return false;
 			}
-			else if (incoming_event.get_name() == "_close")
+			else if (packet->view.name_equals("_close"))
 			{
 				return true;
 			}
 
-			site->add_network_event(NetGameNetworkEvent(base, incoming_event));
+			site->add_network_event(NetGameNetworkEvent(base, packet));
 		}
 		return false;
 	}
 
-	bool NetGameConnection_Impl::write_data(DataBuffer &buffer)
+	bool NetGameConnection_Impl::take_send_queue()
 	{
 		std::unique_lock<std::mutex> mutex_lock(mutex);
-		std::vector<Message> new_send_queue;
-		send_queue.swap(new_send_queue);
+		if (send_queue.empty())
+			return false;
+
+		// Nagle-style flush window: hold back small amounts of data so they go out with later events
+		if (flush_delay > 0 && send_queue_size < NetGameConnection::flush_size && send_queue.back().type == Message::Type::type_message)
+		{
+			uint64_t deadline = send_queue_start + (uint64_t)flush_delay * 1000;
+			if (System::get_microseconds() < deadline)
+			{
+				flush_deadline = deadline;
+				return false;
+			}
+		}
+
+		send_queue.swap(send_batch);
 		mutex_lock.unlock();
-		for (auto & elem : new_send_queue)
+
+		for (auto & elem : send_batch)
 		{
 			if (elem.type == Message::Type::type_message)
 			{
-				DataBuffer packet = NetGameNetworkData::send_data(elem.event);
-
-				int pos = buffer.get_size();
-				buffer.set_size(pos + packet.get_size());
-				memcpy(buffer.get_data() + pos, packet.get_data(), packet.get_size());
+				send_pending.push_back(elem.packet);
 			}
 			else if (elem.type == Message::Type::type_disconnect)
 			{
-				return true;
+				send_graceful_close = true;
+				break;
 			}
 		}
-		return false;
+		send_batch.clear();
+		return true;
 	}
 }
@@ -31,11 +31,19 @@
 
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include "API/Network/Socket/tcp_connection.h"
 #include "API/Network/Socket/socket_name.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Network/NetGame/channel.h"
 
 namespace clan
 {
+	class NetGameReactor;
+	class NetGameUDPHost;
+	class NetGameUDPPeer;
+
 	class NetGameConnection_Impl
 	{
 	public:
@@ -43,20 +51,37 @@ namespace clan
 		~NetGameConnection_Impl();
 		void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection);
 		void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name);
+		void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor);
+		void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name, NetGameUDPHost *host);
 		void set_data(const std::string &name, void *data);
 		void *get_data(const std::string &name) const;
 		void send_event(const NetGameEvent &game_event);
+		void send_packet(const DataBuffer &packet, NetGameChannel channel);
 		void disconnect();
 		SocketName get_remote_name() const;
+		void set_flush_delay(int milliseconds);
+		void set_send_queue_limit(int bytes);
+		int get_send_queue_size() const;
+
+		/// \brief Called by a reactor I/O thread when the socket is ready or the connection was woken. Returns true when the connection is done.
+		bool reactor_process();
+
+		/// \brief Called by the reactor after it stopped processing a finished connection
+		void reactor_finished(const std::string &error);
+
+		/// \brief Time (System::get_microseconds) when held back events must be written, or 0 if none are held back. Only valid on the I/O thread.
+		uint64_t get_flush_deadline() const { return flush_deadline; }
 
 	private:
 		void connection_main();
+		void wake();
+		bool process_io();
 
 		bool read_connection_data(DataBuffer &receive_buffer, int &bytes_received);
-		bool write_connection_data(DataBuffer &send_buffer, int &bytes_sent, bool &send_graceful_close);
+		bool write_connection_data();
 
 		bool read_data(const void *data, int size, int &out_bytes_consumed);
-		bool write_data(DataBuffer &buffer);
+		bool take_send_queue();
 
 		NetGameConnection *base;
 
@@ -69,18 +94,45 @@ namespace clan
 		std::thread thread;
 		bool stop_flag = false;
 		std::mutex mutex;
+
+		NetGameReactor *reactor = nullptr;
+		std::atomic<uint64_t> reactor_id{0};
+		bool connect_announced = false;
+
+		// UDP connections are driven by the I/O thread of a host. Client connections own theirs
+		bool is_udp = false;
+		NetGameUDPHost *udp_host = nullptr;
+		std::unique_ptr<NetGameUDPHost> udp_client_host;
+		std::shared_ptr<NetGameUDPPeer> udp_peer;
+
+		int bytes_received = 0;
+		DataBuffer receive_buffer;
+		bool send_graceful_close = false;
+		std::string disconnect_reason;
+
 		struct Message
 		{
-			Message() : type(Type::type_message), event(std::string()) { }
 			enum class Type
 			{
 				type_message,
 				type_disconnect
 			};
-			Type type;
-			NetGameEvent event;
+			Type type = Type::type_message;
+			DataBuffer packet;
 		};
 		std::vector<Message> send_queue;
+		uint64_t send_queue_start = 0;
+		std::atomic<int> send_queue_size{0};
+		int send_queue_limit = 0;
+		bool send_queue_overflow = false;
+		int flush_delay = 0;
+		uint64_t flush_deadline = 0;
+
+		// Owned by the I/O thread: packets taken from send_queue that are still being written
+		std::vector<Message> send_batch;
+		std::vector<DataBuffer> send_pending;
+		size_t send_pending_index = 0;
+		int send_pending_offset = 0;
 		struct AttachedData
 		{
 			std::string name;
@@ -0,0 +1,344 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/event_view.h"
+#include "API/Network/NetGame/event.h"
+
+namespace clan
+{
+	namespace
+	{
+		enum WireType
+		{
+			wire_end = 0,
+			wire_null = 1,
+			wire_uinteger = 2,
+			wire_integer = 3,
+			wire_number = 4,
+			wire_false = 5,
+			wire_true = 6,
+			wire_string = 7,
+			wire_complex = 8,
+			wire_ucharacter = 9,
+			wire_character = 10,
+			wire_binary = 11
+		};
+
+		unsigned short read_ushort(const unsigned char *d)
+		{
+			unsigned short v;
+			memcpy(&v, d, sizeof(unsigned short));
+			return v;
+		}
+
+		// Returns the position after the value starting at pos. Throws if the value does not fit the buffer.
+		unsigned int skip_value(const unsigned char *d, unsigned int length, unsigned int pos)
+		{
+			if (pos >= length)
+				throw Exception("Invalid network data");
+
+			unsigned char type = d[pos++];
+			switch (type)
+			{
+			case wire_null:
+			case wire_false:
+			case wire_true:
+				return pos;
+			case wire_ucharacter:
+			case wire_character:
+				if (pos + 1 > length)
+					throw Exception("Invalid network data");
+				return pos + 1;
+			case wire_uinteger:
+			case wire_integer:
+			case wire_number:
+				if (pos + 4 > length)
+					throw Exception("Invalid network data");
+				return pos + 4;
+			case wire_string:
+			case wire_binary:
+			{
+				if (pos + 2 > length)
+					throw Exception("Invalid network data");
+				unsigned int data_length = read_ushort(d + pos);
+				pos += 2;
+				if (pos + data_length > length)
+					throw Exception("Invalid network data");
+				return pos + data_length;
+			}
+			case wire_complex:
+				while (true)
+				{
+					if (pos >= length)
+						throw Exception("Invalid network data");
+					if (d[pos] == wire_end)
+						return pos + 1;
+					pos = skip_value(d, length, pos);
+				}
+			default:
+				throw Exception("Invalid network data");
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	NetGameEventValue::Type NetGameEventValueView::get_type() const
+	{
+		switch (data[0])
+		{
+		case wire_null: return NetGameEventValue::Type::null;
+		case wire_uinteger: return NetGameEventValue::Type::uinteger;
+		case wire_integer: return NetGameEventValue::Type::integer;
+		case wire_number: return NetGameEventValue::Type::number;
+		case wire_false:
+		case wire_true: return NetGameEventValue::Type::boolean;
+		case wire_string: return NetGameEventValue::Type::string;
+		case wire_complex: return NetGameEventValue::Type::complex;
+		case wire_ucharacter: return NetGameEventValue::Type::ucharacter;
+		case wire_character: return NetGameEventValue::Type::character;
+		case wire_binary: return NetGameEventValue::Type::binary;
+		default: throw Exception("Invalid network data");
+		}
+	}
+
+	void NetGameEventValueView::check_type(unsigned char expected_type) const
+	{
+		if (data == nullptr || data[0] != expected_type)
+			throw Exception("NetGameEventValueView is not of the requested type");
+	}
+
+	unsigned int NetGameEventValueView::get_uinteger() const
+	{
+		check_type(wire_uinteger);
+		unsigned int v;
+		memcpy(&v, data + 1, sizeof(unsigned int));
+		return v;
+	}
+
+	int NetGameEventValueView::get_integer() const
+	{
+		check_type(wire_integer);
+		int v;
+		memcpy(&v, data + 1, sizeof(int));
+		return v;
+	}
+
+	float NetGameEventValueView::get_number() const
+	{
+		check_type(wire_number);
+		float v;
+		memcpy(&v, data + 1, sizeof(float));
+		return v;
+	}
+
+	bool NetGameEventValueView::get_boolean() const
+	{
+		if (data == nullptr || (data[0] != wire_false && data[0] != wire_true))
+			throw Exception("NetGameEventValueView is not of the requested type");
+		return data[0] == wire_true;
+	}
+
+	char NetGameEventValueView::get_character() const
+	{
+		check_type(wire_character);
+		return static_cast<char>(data[1]);
+	}
+
+	unsigned char NetGameEventValueView::get_ucharacter() const
+	{
+		check_type(wire_ucharacter);
+		return data[1];
+	}
+
+	const char *NetGameEventValueView::get_string_data() const
+	{
+		check_type(wire_string);
+		return reinterpret_cast<const char *>(data + 3);
+	}
+
+	unsigned int NetGameEventValueView::get_string_length() const
+	{
+		check_type(wire_string);
+		return read_ushort(data + 1);
+	}
+
+	bool NetGameEventValueView::string_equals(const char *str) const
+	{
+		if (data == nullptr || data[0] != wire_string)
+			return false;
+		unsigned int str_length = strlen(str);
+		return str_length == read_ushort(data + 1) && memcmp(data + 3, str, str_length) == 0;
+	}
+
+	std::string NetGameEventValueView::get_string() const
+	{
+		return std::string(get_string_data(), get_string_length());
+	}
+
+	const void *NetGameEventValueView::get_binary_data() const
+	{
+		check_type(wire_binary);
+		return data + 3;
+	}
+
+	unsigned int NetGameEventValueView::get_binary_size() const
+	{
+		check_type(wire_binary);
+		return read_ushort(data + 1);
+	}
+
+	unsigned int NetGameEventValueView::get_member_count() const
+	{
+		check_type(wire_complex);
+		unsigned int count = 0;
+		unsigned int pos = 1;
+		while (data[pos] != wire_end)
+		{
+			pos = skip_value(data, length, pos);
+			count++;
+		}
+		return count;
+	}
+
+	NetGameEventValueView NetGameEventValueView::get_member(unsigned int index) const
+	{
+		check_type(wire_complex);
+		unsigned int pos = 1;
+		for (unsigned int i = 0; i < index; i++)
+		{
+			if (data[pos] == wire_end)
+				throw Exception("Member index out of bounds");
+			pos = skip_value(data, length, pos);
+		}
+		if (data[pos] == wire_end)
+			throw Exception("Member index out of bounds");
+		return NetGameEventValueView(data + pos, length - pos);
+	}
+
+	unsigned int NetGameEventValueView::get_encoded_length() const
+	{
+		return skip_value(data, length, 0);
+	}
+
+	NetGameEventValue NetGameEventValueView::to_value() const
+	{
+		switch (data[0])
+		{
+		case wire_null: return NetGameEventValue(NetGameEventValue::Type::null);
+		case wire_uinteger: return NetGameEventValue(get_uinteger());
+		case wire_integer: return NetGameEventValue(get_integer());
+		case wire_number: return NetGameEventValue(get_number());
+		case wire_false: return NetGameEventValue(false);
+		case wire_true: return NetGameEventValue(true);
+		case wire_string: return NetGameEventValue(get_string());
+		case wire_ucharacter: return NetGameEventValue(get_ucharacter());
+		case wire_character: return NetGameEventValue(get_character());
+		case wire_binary: return NetGameEventValue(DataBuffer(get_binary_data(), get_binary_size()));
+		case wire_complex:
+		{
+			NetGameEventValue value(NetGameEventValue::Type::complex);
+			unsigned int pos = 1;
+			while (data[pos] != wire_end)
+			{
+				NetGameEventValueView member(data + pos, length - pos);
+				value.add_member(member.to_value());
+				pos = skip_value(data, length, pos);
+			}
+			return value;
+		}
+		default:
+			throw Exception("Invalid network data");
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void NetGameEventView::reset(const void *payload, unsigned int payload_size)
+	{
+		data = static_cast<const unsigned char *>(payload);
+		size = payload_size;
+		name_length = 0;
+		argument_count = 0;
+
+		if (size < 3)
+			throw Exception("Invalid network data");
+
+		name_length = read_ushort(data);
+		if (size < 2 + name_length + 1)
+			throw Exception("Invalid network data");
+
+		unsigned int pos = 2 + name_length;
+		while (true)
+		{
+			if (pos >= size)
+				throw Exception("Invalid network data");
+			if (data[pos] == wire_end)
+				break;
+
+			if (argument_count < max_cached_offsets)
+				argument_offsets[argument_count] = pos;
+			pos = skip_value(data, size, pos);
+			argument_count++;
+		}
+	}
+
+	bool NetGameEventView::name_equals(const char *name) const
+	{
+		unsigned int length = strlen(name);
+		return length == name_length && memcmp(get_name_data(), name, length) == 0;
+	}
+
+	NetGameEventValueView NetGameEventView::get_argument(unsigned int index) const
+	{
+		if (index >= argument_count)
+			throw Exception("Arguments out of bounds for game event " + get_name());
+
+		unsigned int pos;
+		if (index < max_cached_offsets)
+		{
+			pos = argument_offsets[index];
+		}
+		else
+		{
+			pos = argument_offsets[max_cached_offsets - 1];
+			for (unsigned int i = max_cached_offsets - 1; i < index; i++)
+				pos = skip_value(data, size, pos);
+		}
+		return NetGameEventValueView(data + pos, size - pos);
+	}
+
+	NetGameEvent NetGameEventView::to_event() const
+	{
+		NetGameEvent e(get_name());
+		for (unsigned int i = 0; i < argument_count; i++)
+			e.add_argument(get_argument(i).to_value());
+		return e;
+	}
+}
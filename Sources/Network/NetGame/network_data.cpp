@@ -32,10 +32,11 @@
 #include "API/Core/Text/string_help.h"
 #include "API/Core/Zip/zlib_compression.h"
 #include "network_data.h"
+#include "packet_pool.h"
 
 namespace clan
 {
-	NetGameEvent NetGameNetworkData::receive_data(const void *data, int size, int &out_bytes_consumed)
+	NetGamePacketRef NetGameNetworkData::receive_packet(const void *data, int size, int &out_bytes_consumed)
 	{
 		if (size >= 2)
 		{
@@ -46,13 +47,12 @@ namespace clan
 			if (size >= 2 + payload_size)
 			{
 				out_bytes_consumed = 2 + payload_size;
-				DataBuffer buffer(static_cast<const char*>(data)+2, payload_size);
-				return decode_event(buffer);
+				return NetGamePacketPool::acquire(static_cast<const char*>(data) + 2, payload_size);
 			}
 		}
 
 		out_bytes_consumed = 0;
-		return NetGameEvent(std::string());
+		return NetGamePacketRef();
 	}
 
 	DataBuffer NetGameNetworkData::send_data(const NetGameEvent &e)
@@ -63,125 +63,6 @@ namespace clan
 		return buffer;
 	}
 
-	NetGameEvent NetGameNetworkData::decode_event(const DataBuffer &data)
-	{
-		const unsigned char *d = data.get_data<unsigned char>();
-		unsigned int length = data.get_size();
-		if (length < 3)
-			throw Exception("Invalid network data");
-
-		unsigned int name_length = *reinterpret_cast<const unsigned short*>(d);
-		if (length < 2 + name_length + 1)
-			throw Exception("Invalid network data");
-		std::string name = std::string(reinterpret_cast<const char*>(d + 2), name_length);
-
-		NetGameEvent e(name);
-		unsigned int pos = 2 + name_length;
-		while (true)
-		{
-			if (pos >= length)
-				throw Exception("Invalid network data");
-			unsigned char type = d[pos++];
-			if (type == 0)
-				break;
-			e.add_argument(decode_value(type, d, length, pos));
-		}
-		return e;
-	}
-
-	NetGameEventValue NetGameNetworkData::decode_value(unsigned char type, const unsigned char *d, unsigned int length, unsigned int &pos)
-	{
-		switch (type)
-		{
-		case 1: // null
-			return NetGameEventValue(NetGameEventValue::Type::null);
-		case 2: // uint
-		{
-			if (pos + 4 > length)
-				throw Exception("Invalid network data");
-			unsigned int v = *reinterpret_cast<const unsigned int*>(d + pos);
-			pos += 4;
-			return NetGameEventValue(v);
-		}
-		case 3: // int
-		{
-			if (pos + 4 > length)
-				throw Exception("Invalid network data");
-			int v = *reinterpret_cast<const int*>(d + pos);
-			pos += 4;
-			return NetGameEventValue(v);
-		}
-		case 4: // number
-		{
-			if (pos + 4 > length)
-				throw Exception("Invalid network data");
-			float v = *reinterpret_cast<const float*>(d + pos);
-			pos += 4;
-			return NetGameEventValue(v);
-		}
-		case 5: // false boolean
-			return NetGameEventValue(false);
-		case 6: // true boolean
-			return NetGameEventValue(true);
-		case 7: // string
-		{
-			if (pos + 2 > length)
-				throw Exception("Invalid network data");
-			unsigned short name_length = *reinterpret_cast<const unsigned short*>(d + pos);
-			pos += 2;
-			if (pos + name_length > length)
-				throw Exception("Invalid network data");
-			std::string value(reinterpret_cast<const char*>(d + pos), name_length);
-			pos += name_length;
-			return NetGameEventValue(value);
-		}
-		case 8: // complex
-		{
-			NetGameEventValue value(NetGameEventValue::Type::complex);
-			while (true)
-			{
-				if (pos >= length)
-					throw Exception("Invalid network data");
-				unsigned char type = d[pos++];
-				if (type == 0)
-					break;
-				value.add_member(decode_value(type, d, length, pos));
-			}
-			return value;
-		}
-		case 9: // uchar
-		{
-			if (pos + 1 > length)
-				throw Exception("Invalid network data");
-			unsigned char v = *reinterpret_cast<const unsigned char*>(d + pos);
-			pos += 1;
-			return NetGameEventValue(v);
-		}
-		case 10: // char
-		{
-			if (pos + 1 > length)
-				throw Exception("Invalid network data");
-			char v = *reinterpret_cast<const char*>(d + pos);
-			pos += 1;
-			return NetGameEventValue(v);
-		}
-		case 11: // binary
-		{
-			if (pos + 2 > length)
-				throw Exception("Invalid network data");
-			unsigned short binary_length = *reinterpret_cast<const unsigned short*>(d + pos);
-			pos += 2;
-			if (pos + binary_length > length)
-				throw Exception("Invalid network data");
-			DataBuffer value(reinterpret_cast<const char*>(d + pos), binary_length);
-			pos += binary_length;
-			return NetGameEventValue(value);
-		}
-		default:
-			throw Exception("Invalid network data");
-		}
-	}
-
 	DataBuffer NetGameNetworkData::encode_event(const NetGameEvent &e)
 	{
 		unsigned int length = 3 + e.get_name().length();
@@ -29,6 +29,7 @@
 #pragma once
 
 #include "API/Network/NetGame/event.h"
+#include "packet_pool.h"
 
 namespace clan
 {
@@ -59,8 +60,14 @@ namespace clan
 		{
 		}
 
+		NetGameNetworkEvent(NetGameConnection *connection, const NetGamePacketRef &packet)
+			: connection(connection), type(Type::event_received), game_event(std::string()), packet(packet)
+		{
+		}
+
 		NetGameConnection *connection;
 		Type type;
 		NetGameEvent game_event;
+		NetGamePacketRef packet;
 	};
 }
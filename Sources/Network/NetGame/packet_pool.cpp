@@ -0,0 +1,103 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "packet_pool.h"
+#include <mutex>
+
+namespace clan
+{
+	namespace
+	{
+		class PacketFreeList
+		{
+		public:
+			~PacketFreeList()
+			{
+				for (auto packet : packets)
+					delete packet;
+			}
+
+			std::mutex mutex;
+			std::vector<NetGamePacket *> packets;
+
+			// Larger bursts than this are served by the heap and trimmed again on release
+			enum { max_free_packets = 1024 };
+		};
+
+		PacketFreeList &get_free_list()
+		{
+			static PacketFreeList free_list;
+			return free_list;
+		}
+	}
+
+	void NetGamePacketRef::release()
+	{
+		if (packet && --packet->ref_count == 0)
+			NetGamePacketPool::release(packet);
+		packet = nullptr;
+	}
+
+	NetGamePacketRef NetGamePacketPool::acquire(const void *payload, unsigned int size)
+	{
+		NetGamePacket *packet = nullptr;
+
+		PacketFreeList &free_list = get_free_list();
+		std::unique_lock<std::mutex> lock(free_list.mutex);
+		if (!free_list.packets.empty())
+		{
+			packet = free_list.packets.back();
+			free_list.packets.pop_back();
+		}
+		lock.unlock();
+
+		if (packet == nullptr)
+			packet = new NetGamePacket();
+
+		NetGamePacketRef ref(packet);
+		packet->payload.assign(static_cast<const unsigned char *>(payload), static_cast<const unsigned char *>(payload) + size);
+		packet->view.reset(packet->payload.data(), size);
+		return ref;
+	}
+
+	void NetGamePacketPool::release(NetGamePacket *packet)
+	{
+		PacketFreeList &free_list = get_free_list();
+		std::unique_lock<std::mutex> lock(free_list.mutex);
+		if (free_list.packets.size() < PacketFreeList::max_free_packets)
+		{
+			free_list.packets.push_back(packet);
+		}
+		else
+		{
+			lock.unlock();
+			delete packet;
+		}
+	}
+}
@@ -0,0 +1,101 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/event_view.h"
+#include <atomic>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Received event payload together with a validated view into it
+	class NetGamePacket
+	{
+	public:
+		NetGamePacket() : ref_count(0) { }
+
+		std::vector<unsigned char> payload;
+		NetGameEventView view;
+		std::atomic_int ref_count;
+	};
+
+	/// \brief Reference counted handle to a pooled packet. The packet returns to the pool with the last reference.
+	class NetGamePacketRef
+	{
+	public:
+		NetGamePacketRef() { }
+		explicit NetGamePacketRef(NetGamePacket *packet) : packet(packet) { add_ref(); }
+		NetGamePacketRef(const NetGamePacketRef &other) : packet(other.packet) { add_ref(); }
+		NetGamePacketRef(NetGamePacketRef &&other) : packet(other.packet) { other.packet = nullptr; }
+		~NetGamePacketRef() { release(); }
+
+		NetGamePacketRef &operator=(const NetGamePacketRef &other)
+		{
+			if (packet != other.packet)
+			{
+				release();
+				packet = other.packet;
+				add_ref();
+			}
+			return *this;
+		}
+
+		NetGamePacketRef &operator=(NetGamePacketRef &&other)
+		{
+			if (this != &other)
+			{
+				release();
+				packet = other.packet;
+				other.packet = nullptr;
+			}
+			return *this;
+		}
+
+		explicit operator bool() const { return packet != nullptr; }
+		NetGamePacket *operator->() const { return packet; }
+		NetGamePacket *get() const { return packet; }
+
+	private:
+		void add_ref() { if (packet) ++packet->ref_count; }
+		void release();
+
+		NetGamePacket *packet = nullptr;
+	};
+
+	/// \brief Recycles packet storage so the receive path stops allocating once warmed up
+	class NetGamePacketPool
+	{
+	public:
+		/// \brief Copies an encoded event into a pooled packet and validates it
+		static NetGamePacketRef acquire(const void *payload, unsigned int size);
+
+		/// \brief Returns a packet with no references left to the pool
+		static void release(NetGamePacket *packet);
+	};
+}
@@ -0,0 +1,384 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/Socket/tcp_connection.h"
+#include "API/Network/NetGame/connection.h"
+#include "API/Core/System/system.h"
+#include "Network/Socket/tcp_socket.h"
+#include "reactor.h"
+#include "connection_impl.h"
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace clan
+{
+#if defined(__linux__)
+
+	class NetGameReactorThread
+	{
+	public:
+		struct PendingAdd
+		{
+			uint64_t id;
+			NetGameConnection_Impl *connection;
+			int socket_handle;
+		};
+
+		NetGameReactorThread()
+		{
+			epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+			if (epoll_handle == -1)
+				throw Exception("Unable to create epoll handle");
+
+			wake_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (wake_handle == -1)
+			{
+				::close(epoll_handle);
+				throw Exception("Unable to create eventfd handle");
+			}
+
+			epoll_event event;
+			memset(&event, 0, sizeof(epoll_event));
+			event.events = EPOLLIN;
+			event.data.u64 = 0;
+			if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, wake_handle, &event) == -1)
+			{
+				::close(wake_handle);
+				::close(epoll_handle);
+				throw Exception("Unable to add eventfd to epoll");
+			}
+
+			thread = std::thread(&NetGameReactorThread::thread_main, this);
+		}
+
+		~NetGameReactorThread()
+		{
+			stop_flag = true;
+			signal_wake();
+			thread.join();
+			::close(wake_handle);
+			::close(epoll_handle);
+		}
+
+		void add(uint64_t id, NetGameConnection_Impl *connection, int socket_handle)
+		{
+			std::unique_lock<std::mutex> lock(wake_mutex);
+			PendingAdd pending;
+			pending.id = id;
+			pending.connection = connection;
+			pending.socket_handle = socket_handle;
+			added.push_back(pending);
+			lock.unlock();
+			signal_wake();
+		}
+
+		void remove(uint64_t id)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			detach(id);
+
+			std::unique_lock<std::mutex> wake_lock(wake_mutex);
+			for (auto it = added.begin(); it != added.end(); ++it)
+			{
+				if (it->id == id)
+				{
+					added.erase(it);
+					break;
+				}
+			}
+		}
+
+		void wake(uint64_t id)
+		{
+			std::unique_lock<std::mutex> lock(wake_mutex);
+			woken.push_back(id);
+			lock.unlock();
+			signal_wake();
+		}
+
+	private:
+		void signal_wake()
+		{
+			uint64_t value = 1;
+			ssize_t result = ::write(wake_handle, &value, sizeof(uint64_t));
+			(void)result;
+		}
+
+		// Caller must hold the mutex
+		void attach(const PendingAdd &pending)
+		{
+			// Edge triggered: the connection always reads and writes until the socket would block
+			epoll_event event;
+			memset(&event, 0, sizeof(epoll_event));
+			event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+			event.data.u64 = pending.id;
+			if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, pending.socket_handle, &event) == -1)
+				throw Exception("Unable to add socket to epoll");
+
+			connections[pending.id] = pending.connection;
+			socket_handles[pending.id] = pending.socket_handle;
+		}
+
+		// Caller must hold the mutex
+		void detach(uint64_t id)
+		{
+			auto it = socket_handles.find(id);
+			if (it != socket_handles.end())
+			{
+				epoll_ctl(epoll_handle, EPOLL_CTL_DEL, it->second, nullptr);
+				socket_handles.erase(it);
+			}
+			connections.erase(id);
+			flush_timers.erase(id);
+		}
+
+		// Caller must hold the mutex
+		int get_wait_timeout()
+		{
+			if (flush_timers.empty())
+				return -1;
+
+			uint64_t deadline = flush_timers.begin()->second;
+			for (const auto &timer : flush_timers)
+				deadline = std::min(deadline, timer.second);
+
+			uint64_t now = System::get_microseconds();
+			return deadline > now ? (int)((deadline - now + 999) / 1000) : 0;
+		}
+
+		// Caller must hold the mutex
+		void add_expired_timers(std::vector<uint64_t> &ready)
+		{
+			if (flush_timers.empty())
+				return;
+
+			uint64_t now = System::get_microseconds();
+			for (const auto &timer : flush_timers)
+			{
+				if (timer.second <= now)
+					ready.push_back(timer.first);
+			}
+		}
+
+		void thread_main()
+		{
+			const int max_events = 256;
+			epoll_event events[max_events];
+			std::vector<uint64_t> ready;
+			std::vector<PendingAdd> new_connections;
+
+			while (!stop_flag)
+			{
+				std::unique_lock<std::mutex> timer_lock(mutex);
+				int timeout = get_wait_timeout();
+				timer_lock.unlock();
+
+				int count = epoll_wait(epoll_handle, events, max_events, timeout);
+				if (count == -1)
+				{
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+
+				ready.clear();
+				bool woken_up = false;
+				for (int i = 0; i < count; i++)
+				{
+					if (events[i].data.u64 == 0)
+					{
+						uint64_t value = 0;
+						while (::read(wake_handle, &value, sizeof(uint64_t)) == sizeof(uint64_t));
+						woken_up = true;
+					}
+					else
+					{
+						ready.push_back(events[i].data.u64);
+					}
+				}
+
+				std::unique_lock<std::mutex> lock(mutex);
+				add_expired_timers(ready);
+
+				if (woken_up)
+				{
+					// Pending adds must be taken under the same lock as they are attached with,
+					// or a remove() in between would miss them and leave a dangling connection behind
+					std::unique_lock<std::mutex> wake_lock(wake_mutex);
+					ready.insert(ready.end(), woken.begin(), woken.end());
+					woken.clear();
+					new_connections.swap(added);
+				}
+
+				for (const PendingAdd &pending : new_connections)
+				{
+					try
+					{
+						attach(pending);
+						ready.push_back(pending.id); // Data may already have arrived before the socket got registered
+					}
+					catch (const Exception &e)
+					{
+						pending.connection->reactor_finished(e.message);
+					}
+				}
+				new_connections.clear();
+
+				for (uint64_t id : ready)
+				{
+					auto it = connections.find(id);
+					if (it == connections.end())
+						continue;
+
+					NetGameConnection_Impl *connection = it->second;
+					if (connection->reactor_process())
+					{
+						// Detach before announcing the disconnect, as the site may destroy the connection right away
+						detach(id);
+						connection->reactor_finished(std::string());
+					}
+					else if (connection->get_flush_deadline() != 0)
+					{
+						flush_timers[id] = connection->get_flush_deadline();
+					}
+					else
+					{
+						flush_timers.erase(id);
+					}
+				}
+			}
+		}
+
+		int epoll_handle = -1;
+		int wake_handle = -1;
+		std::thread thread;
+		std::atomic_bool stop_flag{false};
+
+		std::mutex mutex;
+		std::unordered_map<uint64_t, NetGameConnection_Impl *> connections;
+		std::unordered_map<uint64_t, int> socket_handles;
+		std::unordered_map<uint64_t, uint64_t> flush_timers;
+
+		std::mutex wake_mutex;
+		std::vector<uint64_t> woken;
+		std::vector<PendingAdd> added;
+	};
+
+	bool NetGameReactor::is_supported()
+	{
+		return true;
+	}
+
+	NetGameReactor::NetGameReactor(int num_threads) : next_id(1)
+	{
+		for (int i = 0; i < num_threads; i++)
+			threads.push_back(std::unique_ptr<NetGameReactorThread>(new NetGameReactorThread()));
+	}
+
+	NetGameReactor::~NetGameReactor()
+	{
+	}
+
+	uint64_t NetGameReactor::allocate_id()
+	{
+		return next_id++;
+	}
+
+	void NetGameReactor::add(uint64_t id, NetGameConnection_Impl *connection, TCPConnection &socket)
+	{
+		TCPSocket *tcp_socket = static_cast<TCPSocket*>(static_cast<NetworkEvent&>(socket).get_socket_handle());
+		get_thread(id)->add(id, connection, tcp_socket->handle);
+	}
+
+	void NetGameReactor::remove(uint64_t id)
+	{
+		get_thread(id)->remove(id);
+	}
+
+	void NetGameReactor::wake(uint64_t id)
+	{
+		get_thread(id)->wake(id);
+	}
+
+	NetGameReactorThread *NetGameReactor::get_thread(uint64_t id)
+	{
+		return threads[id % threads.size()].get();
+	}
+
+#else
+
+	class NetGameReactorThread
+	{
+	};
+
+	bool NetGameReactor::is_supported()
+	{
+		return false;
+	}
+
+	NetGameReactor::NetGameReactor(int num_threads) : next_id(1)
+	{
+	}
+
+	NetGameReactor::~NetGameReactor()
+	{
+	}
+
+	uint64_t NetGameReactor::allocate_id()
+	{
+		return next_id++;
+	}
+
+	void NetGameReactor::add(uint64_t id, NetGameConnection_Impl *connection, TCPConnection &socket)
+	{
+		throw Exception("NetGameReactor is not supported on this platform");
+	}
+
+	void NetGameReactor::remove(uint64_t id)
+	{
+	}
+
+	void NetGameReactor::wake(uint64_t id)
+	{
+	}
+
+	NetGameReactorThread *NetGameReactor::get_thread(uint64_t id)
+	{
+		return nullptr;
+	}
+
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace clan
+{
+	class NetGameConnection_Impl;
+	class NetGameReactorThread;
+	class TCPConnection;
+
+	/// \brief Fixed pool of I/O threads that drives the sockets of many NetGame connections
+	///
+	/// Only available where epoll exists. Elsewhere is_supported() returns false and
+	/// connections fall back to running on a thread of their own.
+	class NetGameReactor
+	{
+	public:
+		NetGameReactor(int num_threads);
+		~NetGameReactor();
+
+		static bool is_supported();
+
+		/// \brief Returns a new id for a connection
+		uint64_t allocate_id();
+
+		/// \brief Starts delivering socket readiness for the connection to one of the I/O threads
+		///
+		/// The registration itself happens on the I/O thread, so this never blocks on a busy thread.
+		void add(uint64_t id, NetGameConnection_Impl *connection, TCPConnection &socket);
+
+		/// \brief Stops processing the connection. Blocks while an I/O thread is busy with it.
+		void remove(uint64_t id);
+
+		/// \brief Makes the I/O thread process the connection, for example after data was queued for sending
+		void wake(uint64_t id);
+
+	private:
+		NetGameReactorThread *get_thread(uint64_t id);
+
+		std::vector<std::unique_ptr<NetGameReactorThread>> threads;
+		std::atomic<uint64_t> next_id;
+	};
+}
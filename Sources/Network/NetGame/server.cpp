@@ -30,16 +30,24 @@
 #include "API/Network/NetGame/server.h"
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/Socket/socket_name.h"
+#include "API/Core/System/databuffer.h"
 #include "network_event.h"
+#include "network_data.h"
 #include "server_impl.h"
 #include <algorithm>
 #include "API/Network/Socket/tcp_connection.h"
 
+#if !defined(WIN32)
+#include <sys/socket.h>
+#endif
+
 namespace clan
 {
-	NetGameServer::NetGameServer()
+	NetGameServer::NetGameServer(int io_thread_count)
 		: impl(std::make_shared<NetGameServer_Impl>())
 	{
+		if (io_thread_count > 0 && NetGameReactor::is_supported())
+			impl->reactor.reset(new NetGameReactor(io_thread_count));
 	}
 
 	NetGameServer::~NetGameServer()
@@ -60,20 +68,51 @@ namespace clan
 
 	void NetGameServer::send_event(const NetGameEvent &game_event)
 	{
+		send_event(game_event, NetGameChannel::reliable_ordered);
+	}
+
+	void NetGameServer::send_event(const NetGameEvent &game_event, NetGameChannel channel)
+	{
+		// Encode once and share the packet between all connections
+		DataBuffer packet = NetGameNetworkData::send_data(game_event);
+
 		std::unique_lock<std::mutex> mutex_lock(impl->mutex);
 		for (auto & elem : impl->connections)
 		{
-			elem->send_event(game_event);
+			elem->send_packet(packet, channel);
 		}
 	}
 
+	void NetGameServer::send_snapshot(const NetGameSnapshot &snapshot)
+	{
+		std::unique_lock<std::mutex> mutex_lock(impl->mutex);
+		impl->snapshot_sender.send(snapshot, impl->connections);
+	}
+
+	void NetGameServer::set_flush_delay(int milliseconds)
+	{
+		std::unique_lock<std::mutex> mutex_lock(impl->mutex);
+		impl->flush_delay = milliseconds;
+		for (auto & elem : impl->connections)
+			elem->set_flush_delay(milliseconds);
+	}
+
+	void NetGameServer::set_send_queue_limit(int bytes)
+	{
+		std::unique_lock<std::mutex> mutex_lock(impl->mutex);
+		impl->send_queue_limit = bytes;
+		for (auto & elem : impl->connections)
+			elem->set_send_queue_limit(bytes);
+	}
+
+	// A backlog of SOMAXCONN lets a few hundred clients connect at once without waiting for SYN retries
 	void NetGameServer::start(const std::string &port)
 	{
 		stop();
 		std::unique_lock<std::mutex> lock(impl->mutex);
 		impl->stop_flag = false;
 		lock.unlock();
-		impl->tcp_listen.reset(new TCPListen(SocketName(port)));
+		impl->tcp_listen.reset(new TCPListen(SocketName(port), SOMAXCONN));
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
@@ -83,10 +122,25 @@ namespace clan
 		std::unique_lock<std::mutex> lock(impl->mutex);
 		impl->stop_flag = false;
 		lock.unlock();
-		impl->tcp_listen.reset(new TCPListen(SocketName(address, port)));
+		impl->tcp_listen.reset(new TCPListen(SocketName(address, port), SOMAXCONN));
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
+	void NetGameServer::start_udp(const std::string &port)
+	{
+		start_udp(std::string(), port);
+	}
+
+	void NetGameServer::start_udp(const std::string &address, const std::string &port)
+	{
+		stop();
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		impl->stop_flag = false;
+		lock.unlock();
+		impl->udp_host.reset(new NetGameUDPHost(SocketName(address, port), [this](const SocketName &peer_endpoint) { udp_accept(peer_endpoint); }));
+		impl->udp_host->start();
+	}
+
 	void NetGameServer::stop()
 	{
 		std::unique_lock<std::mutex> lock(impl->mutex);
@@ -97,11 +151,27 @@ namespace clan
 			impl->listen_thread.join();
 		impl->tcp_listen.reset();
 
+		// No events may be posted for the connections while they are deleted
+		if (impl->udp_host)
+			impl->udp_host->stop();
+
 		for (auto & elem : impl->connections)
 		{
 			delete elem;
 		}
 		impl->connections.clear();
+		impl->udp_host.reset();
+	}
+
+	void NetGameServer::udp_accept(const SocketName &peer_endpoint)
+	{
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		if (impl->stop_flag)
+			return;
+
+		std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, peer_endpoint, impl->udp_host.get()));
+		game_connection->set_send_queue_limit(impl->send_queue_limit);
+		impl->connections.push_back(game_connection.release());
 	}
 
 	void NetGameServer::listen_thread_main()
@@ -119,7 +189,13 @@ namespace clan
 			TCPConnection connection = impl->tcp_listen->accept(peer_endpoint);
 			if (!connection.is_null())
 			{
-				std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, connection));
+				std::unique_ptr<NetGameConnection> game_connection;
+				if (impl->reactor)
+					game_connection.reset(new NetGameConnection(this, connection, impl->reactor.get()));
+				else
+					game_connection.reset(new NetGameConnection(this, connection));
+				game_connection->set_flush_delay(impl->flush_delay);
+				game_connection->set_send_queue_limit(impl->send_queue_limit);
 				impl->connections.push_back(game_connection.release());
 			}
 		}
@@ -140,6 +216,11 @@ namespace clan
 		return impl->sig_game_event_received;
 	}
 
+	Signal<void(NetGameConnection *, const NetGameEventView &)> &NetGameServer::sig_event_view_received()
+	{
+		return impl->sig_game_event_view_received;
+	}
+
 	void NetGameServer_Impl::process()
 	{
 		std::unique_lock<std::mutex> mutex_lock(mutex);
@@ -155,12 +236,26 @@ namespace clan
 				sig_game_client_connected(new_event.connection);
 				break;
 			case NetGameNetworkEvent::Type::event_received:
-				sig_game_event_received(new_event.connection, new_event.game_event);
+				if (new_event.packet && new_event.packet->view.name_equals("_snapshot_ack"))
+				{
+					snapshot_sender.acknowledge(new_event.connection, new_event.packet->view.get_argument(0).get_uinteger());
+				}
+				else if (new_event.packet)
+				{
+					sig_game_event_view_received(new_event.connection, new_event.packet->view);
+					if (sig_game_event_received.has_slots())
+						sig_game_event_received(new_event.connection, new_event.packet->view.to_event());
+				}
+				else
+				{
+					sig_game_event_received(new_event.connection, new_event.game_event);
+				}
 				break;
 			case NetGameNetworkEvent::Type::client_disconnected:
 			{
 				std::string reason = new_event.game_event.get_name();
 				sig_game_client_disconnected(new_event.connection, reason);
+				snapshot_sender.remove(new_event.connection);
 			}
 
 			// Destroy connection object
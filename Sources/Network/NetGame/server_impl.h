@@ -29,6 +29,9 @@
 #pragma once
 
 #include "API/Network/Socket/tcp_listen.h"
+#include "reactor.h"
+#include "snapshot_channel.h"
+#include "udp_host.h"
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -42,15 +45,21 @@ namespace clan
 
 		std::unique_ptr<TCPListen> tcp_listen;
 		std::thread listen_thread;
+		std::unique_ptr<NetGameReactor> reactor;
+		std::unique_ptr<NetGameUDPHost> udp_host;
 
 		NetworkConditionVariable worker_event;
 		std::mutex mutex;
 		bool stop_flag = false;
+		int flush_delay = 0;
+		int send_queue_limit = 0;
 		std::vector<NetGameConnection *> connections;
 		std::vector<NetGameNetworkEvent> events;
+		NetGameSnapshotSender snapshot_sender;
 
 		Signal<void(NetGameConnection *)> sig_game_client_connected;
 		Signal<void(NetGameConnection *, const std::string &)> sig_game_client_disconnected;
 		Signal<void(NetGameConnection *, const NetGameEvent &)> sig_game_event_received;
+		Signal<void(NetGameConnection *, const NetGameEventView &)> sig_game_event_view_received;
 	};
 }
@@ -0,0 +1,412 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/snapshot.h"
+#include "API/Core/System/databuffer.h"
+#include "bit_stream.h"
+#include <algorithm>
+
+namespace clan
+{
+	class NetGameSnapshotSchema_Impl
+	{
+	public:
+		struct Field
+		{
+			bool is_float = false;
+			float min_value = 0.0f;
+			float max_value = 0.0f;
+			int bits = 0;
+			int max_quantized = 0;
+		};
+
+		std::vector<Field> fields;
+	};
+
+	NetGameSnapshotSchema::NetGameSnapshotSchema()
+		: impl(std::make_shared<NetGameSnapshotSchema_Impl>())
+	{
+	}
+
+	int NetGameSnapshotSchema::add_int()
+	{
+		impl->fields.push_back(NetGameSnapshotSchema_Impl::Field());
+		return (int)impl->fields.size() - 1;
+	}
+
+	int NetGameSnapshotSchema::add_float(float min_value, float max_value, int bits)
+	{
+		if (bits < 1 || bits > 24)
+			throw Exception("Snapshot float fields must use 1 to 24 bits");
+		if (!(max_value > min_value))
+			throw Exception("Invalid snapshot float field range");
+
+		NetGameSnapshotSchema_Impl::Field field;
+		field.is_float = true;
+		field.min_value = min_value;
+		field.max_value = max_value;
+		field.bits = bits;
+		field.max_quantized = (1 << bits) - 1;
+		impl->fields.push_back(field);
+		return (int)impl->fields.size() - 1;
+	}
+
+	int NetGameSnapshotSchema::get_field_count() const
+	{
+		return (int)impl->fields.size();
+	}
+
+	bool NetGameSnapshotSchema::is_float(int field) const
+	{
+		return impl->fields[field].is_float;
+	}
+
+	int NetGameSnapshotSchema::get_bits(int field) const
+	{
+		return impl->fields[field].bits;
+	}
+
+	int NetGameSnapshotSchema::quantize(int field, float value) const
+	{
+		const auto &f = impl->fields[field];
+		float t = (value - f.min_value) / (f.max_value - f.min_value);
+		t = std::max(0.0f, std::min(1.0f, t));
+		return (int)(t * f.max_quantized + 0.5f);
+	}
+
+	float NetGameSnapshotSchema::dequantize(int field, int value) const
+	{
+		const auto &f = impl->fields[field];
+		return f.min_value + value * (f.max_value - f.min_value) / f.max_quantized;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	NetGameSnapshot::NetGameSnapshot(const NetGameSnapshotSchema &schema) : schema(schema)
+	{
+	}
+
+	void NetGameSnapshot::remove_entity(unsigned int id)
+	{
+		int index = find_entity(id);
+		if (index != -1)
+		{
+			int field_count = schema.get_field_count();
+			ids.erase(ids.begin() + index);
+			values.erase(values.begin() + index * field_count, values.begin() + (index + 1) * field_count);
+		}
+	}
+
+	void NetGameSnapshot::clear()
+	{
+		ids.clear();
+		values.clear();
+	}
+
+	void NetGameSnapshot::set_int(unsigned int id, int field, int value)
+	{
+		if (schema.is_float(field))
+			throw Exception("Snapshot field is not an integer field");
+		values[find_or_add_entity(id) * schema.get_field_count() + field] = value;
+	}
+
+	void NetGameSnapshot::set_float(unsigned int id, int field, float value)
+	{
+		if (!schema.is_float(field))
+			throw Exception("Snapshot field is not a float field");
+		values[find_or_add_entity(id) * schema.get_field_count() + field] = schema.quantize(field, value);
+	}
+
+	int NetGameSnapshot::get_int(unsigned int id, int field) const
+	{
+		int index = find_entity(id);
+		if (index == -1)
+			throw Exception("No such entity in snapshot");
+		return values[index * schema.get_field_count() + field];
+	}
+
+	float NetGameSnapshot::get_float(unsigned int id, int field) const
+	{
+		int index = find_entity(id);
+		if (index == -1)
+			throw Exception("No such entity in snapshot");
+		return schema.dequantize(field, values[index * schema.get_field_count() + field]);
+	}
+
+	int NetGameSnapshot::find_entity(unsigned int id) const
+	{
+		auto it = std::lower_bound(ids.begin(), ids.end(), id);
+		if (it != ids.end() && *it == id)
+			return (int)(it - ids.begin());
+		else
+			return -1;
+	}
+
+	int NetGameSnapshot::find_or_add_entity(unsigned int id)
+	{
+		// Entities are usually added in id order, which makes this an append
+		if (ids.empty() || ids.back() < id)
+		{
+			ids.push_back(id);
+			values.resize(values.size() + schema.get_field_count(), 0);
+			return (int)ids.size() - 1;
+		}
+
+		auto it = std::lower_bound(ids.begin(), ids.end(), id);
+		int index = (int)(it - ids.begin());
+		if (it == ids.end() || *it != id)
+		{
+			int field_count = schema.get_field_count();
+			ids.insert(it, id);
+			values.insert(values.begin() + index * field_count, field_count, 0);
+		}
+		return index;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+	// Encoding:
+	//
+	// varint removed count, then the removed ids
+	// varint changed count, then for each changed entity:
+	//   id, new entity bit
+	//   new entity: every field (zigzag varint for ints, raw quantized bits for floats)
+	//   changed entity: one bit per field, followed by the delta for changed fields
+	//
+	// Ids are sorted and written as the gap to the previous id plus one.
+
+	DataBuffer NetGameSnapshot::encode(const NetGameSnapshot &snapshot, const NetGameSnapshot *baseline)
+	{
+		const NetGameSnapshotSchema &schema = snapshot.schema;
+		int field_count = schema.get_field_count();
+		if (baseline && baseline->schema.get_field_count() != field_count)
+			throw Exception("Snapshot baseline uses a different schema");
+
+		static const std::vector<unsigned int> no_ids;
+		static const std::vector<int> no_values;
+		const std::vector<unsigned int> &base_ids = baseline ? baseline->ids : no_ids;
+		const std::vector<int> &base_values = baseline ? baseline->values : no_values;
+		const std::vector<unsigned int> &ids = snapshot.ids;
+		const std::vector<int> &values = snapshot.values;
+
+		// Find removed and changed entities with a merge of the two sorted id lists
+		std::vector<unsigned int> removed;
+		std::vector<std::pair<int, int>> changed; // index, baseline index or -1
+		size_t i = 0, b = 0;
+		while (i < ids.size() || b < base_ids.size())
+		{
+			if (b == base_ids.size() || (i < ids.size() && ids[i] < base_ids[b]))
+			{
+				changed.push_back(std::make_pair((int)i, -1));
+				i++;
+			}
+			else if (i == ids.size() || base_ids[b] < ids[i])
+			{
+				removed.push_back(base_ids[b]);
+				b++;
+			}
+			else
+			{
+				if (memcmp(&values[i * field_count], &base_values[b * field_count], field_count * sizeof(int)) != 0)
+					changed.push_back(std::make_pair((int)i, (int)b));
+				i++;
+				b++;
+			}
+		}
+
+		NetGameBitWriter writer;
+
+		writer.write_varint(removed.size());
+		unsigned int next_id = 0;
+		for (unsigned int id : removed)
+		{
+			writer.write_varint(id - next_id);
+			next_id = id + 1;
+		}
+
+		writer.write_varint(changed.size());
+		next_id = 0;
+		for (const auto &entity : changed)
+		{
+			unsigned int id = ids[entity.first];
+			writer.write_varint(id - next_id);
+			next_id = id + 1;
+
+			const int *v = &values[entity.first * field_count];
+			writer.write_bool(entity.second == -1);
+			if (entity.second == -1)
+			{
+				for (int field = 0; field < field_count; field++)
+				{
+					if (schema.is_float(field))
+						writer.write_bits(v[field], schema.get_bits(field));
+					else
+						writer.write_signed_varint(v[field]);
+				}
+			}
+			else
+			{
+				const int *base = &base_values[entity.second * field_count];
+				for (int field = 0; field < field_count; field++)
+				{
+					writer.write_bool(v[field] != base[field]);
+					if (v[field] == base[field])
+						continue;
+
+					uint32_t delta = NetGameBitWriter::zigzag((int32_t)((uint32_t)v[field] - (uint32_t)base[field]));
+					if (schema.is_float(field))
+					{
+						// Small movements are cheaper as a delta, big jumps as the raw value
+						int bits = schema.get_bits(field);
+						bool raw = NetGameBitWriter::varint_bits(delta) >= bits;
+						writer.write_bool(raw);
+						if (raw)
+							writer.write_bits(v[field], bits);
+						else
+							writer.write_varint(delta);
+					}
+					else
+					{
+						writer.write_varint(delta);
+					}
+				}
+			}
+		}
+
+		const std::vector<unsigned char> &data = writer.finish();
+		return DataBuffer(data.data(), data.size());
+	}
+
+	NetGameSnapshot NetGameSnapshot::decode(const NetGameSnapshotSchema &schema, const void *data, unsigned int size, const NetGameSnapshot *baseline)
+	{
+		int field_count = schema.get_field_count();
+		if (baseline && baseline->schema.get_field_count() != field_count)
+			throw Exception("Snapshot baseline uses a different schema");
+
+		static const std::vector<unsigned int> no_ids;
+		static const std::vector<int> no_values;
+		const std::vector<unsigned int> &base_ids = baseline ? baseline->ids : no_ids;
+		const std::vector<int> &base_values = baseline ? baseline->values : no_values;
+
+		NetGameBitReader reader(data, size);
+
+		unsigned int removed_count = reader.read_varint();
+		if (removed_count > base_ids.size())
+			throw Exception("Invalid snapshot data");
+
+		std::vector<unsigned int> removed;
+		removed.reserve(removed_count);
+		unsigned int next_id = 0;
+		for (unsigned int i = 0; i < removed_count; i++)
+		{
+			unsigned int id = next_id + reader.read_varint();
+			removed.push_back(id);
+			next_id = id + 1;
+		}
+
+		NetGameSnapshot result(schema);
+		result.ids.reserve(base_ids.size());
+		result.values.reserve(base_values.size());
+
+		size_t b = 0, r = 0;
+		auto copy_baseline_until = [&](uint64_t end_id)
+		{
+			while (b < base_ids.size() && base_ids[b] < end_id)
+			{
+				if (r < removed.size() && removed[r] == base_ids[b])
+				{
+					r++;
+				}
+				else
+				{
+					result.ids.push_back(base_ids[b]);
+					result.values.insert(result.values.end(), base_values.begin() + b * field_count, base_values.begin() + (b + 1) * field_count);
+				}
+				b++;
+			}
+		};
+
+		unsigned int changed_count = reader.read_varint();
+		next_id = 0;
+		for (unsigned int i = 0; i < changed_count; i++)
+		{
+			unsigned int id = next_id + reader.read_varint();
+			next_id = id + 1;
+			if (!result.ids.empty() && result.ids.back() >= id)
+				throw Exception("Invalid snapshot data");
+
+			copy_baseline_until(id);
+
+			bool is_new = reader.read_bool();
+			bool in_baseline = b < base_ids.size() && base_ids[b] == id;
+			if (is_new == in_baseline)
+				throw Exception("Snapshot does not match its baseline");
+
+			result.ids.push_back(id);
+			size_t pos = result.values.size();
+			if (is_new)
+			{
+				result.values.resize(pos + field_count);
+				for (int field = 0; field < field_count; field++)
+				{
+					if (schema.is_float(field))
+						result.values[pos + field] = reader.read_bits(schema.get_bits(field));
+					else
+						result.values[pos + field] = reader.read_signed_varint();
+				}
+			}
+			else
+			{
+				result.values.insert(result.values.end(), base_values.begin() + b * field_count, base_values.begin() + (b + 1) * field_count);
+				b++;
+				for (int field = 0; field < field_count; field++)
+				{
+					if (!reader.read_bool())
+						continue;
+
+					int &value = result.values[pos + field];
+					if (schema.is_float(field) && reader.read_bool())
+					{
+						value = reader.read_bits(schema.get_bits(field));
+					}
+					else
+					{
+						int32_t delta = reader.read_signed_varint();
+						value = (int)((uint32_t)value + (uint32_t)delta);
+					}
+				}
+			}
+		}
+
+		copy_baseline_until(((uint64_t)1) << 32);
+		if (r != removed.size())
+			throw Exception("Snapshot removes entities not in its baseline");
+
+		return result;
+	}
+}
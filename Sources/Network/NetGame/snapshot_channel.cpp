@@ -0,0 +1,197 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/connection.h"
+#include "API/Network/NetGame/event.h"
+#include "API/Network/NetGame/event_view.h"
+#include "API/Core/Zip/zlib_compression.h"
+#include "snapshot_channel.h"
+#include "network_data.h"
+#include <algorithm>
+
+namespace clan
+{
+	void NetGameSnapshotSender::send(const NetGameSnapshot &snapshot, const std::vector<NetGameConnection *> &connections)
+	{
+		history.push_back(snapshot);
+		NetGameSnapshot &current = history.back();
+		current.set_sequence(next_sequence++);
+		if (next_sequence == 0)
+			next_sequence = 1;
+
+		// Clients acknowledging the same snapshot share one encoding
+		std::vector<std::pair<unsigned int, std::vector<DataBuffer>>> encodings;
+		for (NetGameConnection *connection : connections)
+		{
+			auto it_ack = acks.find(connection);
+			const NetGameSnapshot *baseline = find(it_ack != acks.end() ? it_ack->second : 0);
+			unsigned int baseline_sequence = baseline ? baseline->get_sequence() : 0;
+
+			size_t index;
+			for (index = 0; index < encodings.size(); index++)
+			{
+				if (encodings[index].first == baseline_sequence)
+					break;
+			}
+			if (index == encodings.size())
+				encodings.push_back(std::make_pair(baseline_sequence, encode(current, baseline)));
+
+			for (const DataBuffer &packet : encodings[index].second)
+				connection->send_packet(packet);
+		}
+
+		if (history.size() > netgame_snapshot_server_history)
+			history.pop_front();
+	}
+
+	void NetGameSnapshotSender::acknowledge(NetGameConnection *connection, unsigned int sequence)
+	{
+		unsigned int &ack = acks[connection];
+		if (sequence > ack)
+			ack = sequence;
+	}
+
+	void NetGameSnapshotSender::remove(NetGameConnection *connection)
+	{
+		acks.erase(connection);
+	}
+
+	std::vector<DataBuffer> NetGameSnapshotSender::encode(const NetGameSnapshot &snapshot, const NetGameSnapshot *baseline)
+	{
+		DataBuffer payload = NetGameSnapshot::encode(snapshot, baseline);
+
+		unsigned int flags = 0;
+		if (payload.get_size() >= netgame_snapshot_compress_threshold)
+		{
+			DataBuffer compressed = ZLibCompression::compress(payload, true, 1);
+			if (compressed.get_size() < payload.get_size())
+			{
+				payload = compressed;
+				flags |= netgame_snapshot_flag_zlib;
+			}
+		}
+
+		unsigned int baseline_sequence = baseline ? baseline->get_sequence() : 0;
+		unsigned int payload_size = payload.get_size();
+		unsigned int part_count = std::max((payload_size + netgame_snapshot_max_part_size - 1) / netgame_snapshot_max_part_size, 1u);
+
+		std::vector<DataBuffer> packets;
+		for (unsigned int part = 0; part < part_count; part++)
+		{
+			unsigned int offset = part * netgame_snapshot_max_part_size;
+			unsigned int size = std::min(payload_size - offset, (unsigned int)netgame_snapshot_max_part_size);
+			NetGameEvent e("_snapshot", { snapshot.get_sequence(), baseline_sequence, flags, part, part_count, DataBuffer(payload, offset, size) });
+			packets.push_back(NetGameNetworkData::send_data(e));
+		}
+		return packets;
+	}
+
+	const NetGameSnapshot *NetGameSnapshotSender::find(unsigned int sequence) const
+	{
+		if (sequence == 0)
+			return nullptr;
+		for (const auto &snapshot : history)
+		{
+			if (snapshot.get_sequence() == sequence)
+				return &snapshot;
+		}
+		return nullptr;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	bool NetGameSnapshotReceiver::receive(const NetGameEventView &e, NetGameSnapshot &out_snapshot)
+	{
+		unsigned int sequence = e.get_argument(0).get_uinteger();
+		unsigned int baseline_sequence = e.get_argument(1).get_uinteger();
+		unsigned int flags = e.get_argument(2).get_uinteger();
+		unsigned int part = e.get_argument(3).get_uinteger();
+		unsigned int part_count = e.get_argument(4).get_uinteger();
+		NetGameEventValueView data = e.get_argument(5);
+
+		if (part == 0)
+		{
+			parts.clear();
+			parts_sequence = sequence;
+			parts_received = 0;
+		}
+		else if (sequence != parts_sequence || part != parts_received)
+		{
+			throw Exception("Snapshot parts received out of order");
+		}
+
+		const unsigned char *part_data = static_cast<const unsigned char *>(data.get_binary_data());
+		parts.insert(parts.end(), part_data, part_data + data.get_binary_size());
+		parts_received++;
+
+		if (parts_received != part_count)
+			return false;
+
+		const NetGameSnapshot *baseline = find(baseline_sequence);
+		if (baseline_sequence != 0 && !baseline)
+			throw Exception("Snapshot baseline is no longer available");
+
+		if (flags & netgame_snapshot_flag_zlib)
+		{
+			DataBuffer payload = ZLibCompression::decompress(DataBuffer(parts.data(), parts.size()), true);
+			out_snapshot = NetGameSnapshot::decode(schema, payload.get_data(), payload.get_size(), baseline);
+		}
+		else
+		{
+			out_snapshot = NetGameSnapshot::decode(schema, parts.data(), parts.size(), baseline);
+		}
+		out_snapshot.set_sequence(sequence);
+
+		history.push_back(out_snapshot);
+		if (history.size() > netgame_snapshot_client_history)
+			history.pop_front();
+		parts.clear();
+		return true;
+	}
+
+	void NetGameSnapshotReceiver::reset()
+	{
+		history.clear();
+		parts.clear();
+		parts_sequence = 0;
+		parts_received = 0;
+	}
+
+	const NetGameSnapshot *NetGameSnapshotReceiver::find(unsigned int sequence) const
+	{
+		if (sequence == 0)
+			return nullptr;
+		for (const auto &snapshot : history)
+		{
+			if (snapshot.get_sequence() == sequence)
+				return &snapshot;
+		}
+		return nullptr;
+	}
+}
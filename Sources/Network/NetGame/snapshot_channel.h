@@ -0,0 +1,91 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/snapshot.h"
+#include "API/Core/System/databuffer.h"
+#include <deque>
+#include <unordered_map>
+
+namespace clan
+{
+	class NetGameConnection;
+	class NetGameEventView;
+
+	/// \brief Server end of the snapshot channel
+	///
+	/// Snapshots travel as "_snapshot" events. Large payloads are split over several events.
+	/// Clients answer every snapshot with a "_snapshot_ack" event, and the next snapshot a
+	/// client receives is encoded against the newest one it acknowledged.
+	class NetGameSnapshotSender
+	{
+	public:
+		void send(const NetGameSnapshot &snapshot, const std::vector<NetGameConnection *> &connections);
+		void acknowledge(NetGameConnection *connection, unsigned int sequence);
+		void remove(NetGameConnection *connection);
+
+	private:
+		std::vector<DataBuffer> encode(const NetGameSnapshot &snapshot, const NetGameSnapshot *baseline);
+		const NetGameSnapshot *find(unsigned int sequence) const;
+
+		std::deque<NetGameSnapshot> history;
+		unsigned int next_sequence = 1;
+		std::unordered_map<NetGameConnection *, unsigned int> acks;
+	};
+
+	/// \brief Client end of the snapshot channel
+	class NetGameSnapshotReceiver
+	{
+	public:
+		/// \brief Processes a "_snapshot" event. Returns true when a complete snapshot was decoded.
+		bool receive(const NetGameEventView &e, NetGameSnapshot &out_snapshot);
+		void reset();
+
+		NetGameSnapshotSchema schema;
+		bool has_schema = false;
+
+	private:
+		const NetGameSnapshot *find(unsigned int sequence) const;
+
+		std::deque<NetGameSnapshot> history;
+		std::vector<unsigned char> parts;
+		unsigned int parts_sequence = 0;
+		unsigned int parts_received = 0;
+	};
+
+	enum
+	{
+		// Client keeps more history than the server, so any baseline the server picks is still known
+		netgame_snapshot_server_history = 32,
+		netgame_snapshot_client_history = 64,
+		netgame_snapshot_max_part_size = 30000,
+		netgame_snapshot_compress_threshold = 256,
+		netgame_snapshot_flag_zlib = 1
+	};
+}
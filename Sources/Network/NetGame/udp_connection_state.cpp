@@ -0,0 +1,496 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "udp_connection_state.h"
+#include <algorithm>
+
+namespace clan
+{
+	namespace
+	{
+		void invalid_data()
+		{
+			throw Exception("Invalid network data");
+		}
+	}
+
+	NetGameUDPConnectionState::NetGameUDPConnectionState()
+		: sent_packets(netgame_udp_sent_packet_window)
+	{
+	}
+
+	void NetGameUDPConnectionState::queue(const DataBuffer &packet, NetGameChannel channel)
+	{
+		SendChannel &send_channel = send_channels[(int)channel];
+
+		// Events that fit a packet on their own are never fragmented. Larger ones are split into equally sized fragments
+		int payload_size = packet.get_size() - 2;
+		int count = 1;
+		int fragment_size = payload_size;
+		if (payload_size > netgame_udp_mtu - netgame_udp_data_header_size - netgame_udp_message_header_size)
+		{
+			int max_fragment_size = netgame_udp_mtu - netgame_udp_data_header_size - netgame_udp_fragment_header_size;
+			count = (payload_size + max_fragment_size - 1) / max_fragment_size;
+			fragment_size = (payload_size + count - 1) / count;
+		}
+
+		NetGameUDPFragment fragment;
+		fragment.message = packet;
+		fragment.message_id = send_channel.next_message_id++;
+		fragment.channel = (unsigned char)channel;
+		fragment.count = count;
+		for (int i = 0; i < count; i++)
+		{
+			fragment.index = i;
+			fragment.offset = i * fragment_size;
+			fragment.size = std::min(fragment_size, payload_size - i * fragment_size);
+			send_channel.queue.push_back(fragment);
+		}
+
+		if (is_reliable(channel))
+			send_channel.unacked_fragments.push_back(count);
+		queued_bytes += packet.get_size();
+	}
+
+	int NetGameUDPConnectionState::write_packet(uint64_t now, unsigned char *buffer, bool force)
+	{
+		unsigned short sequence = local_sequence;
+		SentPacket &sent = sent_packets[sequence % netgame_udp_sent_packet_window];
+		if (sent.in_use)
+			requeue(sent);
+
+		// Unreliable events go first as they are the most latency sensitive, and resends before new reliable data
+		int pos = netgame_udp_data_header_size;
+		write_fragments(send_channels[(int)NetGameChannel::unreliable_sequenced].queue, false, buffer, pos, sent);
+		if (packets_in_flight < netgame_udp_max_packets_in_flight)
+		{
+			write_fragments(resend_queue, true, buffer, pos, sent);
+			write_fragments(send_channels[(int)NetGameChannel::reliable_ordered].queue, false, buffer, pos, sent);
+			write_fragments(send_channels[(int)NetGameChannel::reliable_unordered].queue, false, buffer, pos, sent);
+		}
+
+		bool has_messages = pos != netgame_udp_data_header_size;
+		if (!has_messages && !force)
+			return 0;
+
+		write_uint16(buffer, netgame_udp_protocol_id);
+		buffer[2] = (unsigned char)NetGameUDPPacketType::data;
+		write_uint16(buffer + 3, sequence);
+		write_uint16(buffer + 5, remote_sequence);
+		write_uint32(buffer + 7, received_bits);
+		local_sequence++;
+		received_since_ack = 0;
+
+		// Packets without messages are not acked promptly by the peer, so only packets with messages are tracked
+		if (has_messages)
+		{
+			sent.in_use = true;
+			sent.sequence = sequence;
+			sent.send_time = now;
+			sent_order.push_back(sequence);
+			packets_in_flight++;
+		}
+		return pos;
+	}
+
+	void NetGameUDPConnectionState::write_fragments(std::deque<NetGameUDPFragment> &queue, bool resend, unsigned char *buffer, int &pos, SentPacket &sent)
+	{
+		while (!queue.empty())
+		{
+			NetGameUDPFragment &fragment = queue.front();
+			bool reliable = is_reliable((NetGameChannel)fragment.channel);
+
+			if (reliable && !resend)
+			{
+				const SendChannel &window = send_channels[fragment.channel];
+				if (fragment.message_id - window.oldest_unacked >= netgame_udp_message_window)
+					break;
+			}
+
+			bool fragmented = fragment.count > 1;
+			int header_size = fragmented ? netgame_udp_fragment_header_size : netgame_udp_message_header_size;
+			if (pos + header_size + fragment.size > netgame_udp_mtu)
+				break;
+
+			unsigned char *d = buffer + pos;
+			d[0] = fragment.channel | (fragmented ? 0x80 : 0);
+			write_uint16(d + 1, fragment.message_id & 0xffff);
+			if (fragmented)
+			{
+				d[3] = fragment.index;
+				d[4] = fragment.count;
+				write_uint16(d + 5, fragment.message.get_size() - 2);
+				write_uint16(d + 7, fragment.size);
+			}
+			else
+			{
+				write_uint16(d + 3, fragment.size);
+			}
+			memcpy(d + header_size, fragment.message.get_data<unsigned char>() + 2 + fragment.offset, fragment.size);
+			pos += header_size + fragment.size;
+
+			if (!resend)
+				queued_bytes -= fragment.size + (fragment.index == 0 ? 2 : 0);
+
+			if (reliable)
+				sent.fragments.push_back(fragment);
+			queue.pop_front();
+		}
+	}
+
+	void NetGameUDPConnectionState::read_packet(uint64_t now, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events)
+	{
+		if (size < netgame_udp_data_header_size)
+			invalid_data();
+
+		unsigned short sequence = read_uint16(data + 3);
+		unsigned short ack = read_uint16(data + 5);
+		uint32_t ack_bits = read_uint32(data + 7);
+
+		acknowledge(ack, now);
+		for (int i = 0; i < 32; i++)
+		{
+			if (ack_bits & (1u << i))
+				acknowledge(ack - 1 - i, now);
+		}
+
+		// Remember which packets arrived, so they can be acked and duplicates ignored
+		if (!received_any)
+		{
+			received_any = true;
+			remote_sequence = sequence;
+			received_bits = 0;
+		}
+		else
+		{
+			int diff = (short)(unsigned short)(sequence - remote_sequence);
+			if (diff > 0)
+			{
+				if (diff < 32)
+					received_bits = (received_bits << diff) | (1u << (diff - 1));
+				else if (diff == 32)
+					received_bits = 1u << 31;
+				else
+					received_bits = 0;
+				remote_sequence = sequence;
+			}
+			else if (diff == 0)
+			{
+				return;
+			}
+			else if (-diff - 1 < 32)
+			{
+				uint32_t bit = 1u << (-diff - 1);
+				if (received_bits & bit)
+					return;
+				received_bits |= bit;
+			}
+		}
+
+		if (size > netgame_udp_data_header_size)
+			received_since_ack++;
+
+		int pos = netgame_udp_data_header_size;
+		while (pos < size)
+		{
+			if (size - pos < netgame_udp_message_header_size)
+				invalid_data();
+
+			int channel_index = data[pos] & 0x7f;
+			bool fragmented = (data[pos] & 0x80) != 0;
+			if (channel_index > (int)NetGameChannel::unreliable_sequenced)
+				invalid_data();
+
+			NetGameChannel channel = (NetGameChannel)channel_index;
+			uint32_t message_id = expand_message_id(channel, read_uint16(data + pos + 1));
+			if (fragmented)
+			{
+				if (size - pos < netgame_udp_fragment_header_size)
+					invalid_data();
+
+				int index = data[pos + 3];
+				int count = data[pos + 4];
+				int total_size = read_uint16(data + pos + 5);
+				int fragment_size = read_uint16(data + pos + 7);
+				pos += netgame_udp_fragment_header_size;
+				if (fragment_size > size - pos)
+					invalid_data();
+
+				read_fragment(channel, message_id, index, count, total_size, data + pos, fragment_size, out_events);
+				pos += fragment_size;
+			}
+			else
+			{
+				int message_size = read_uint16(data + pos + 3);
+				pos += netgame_udp_message_header_size;
+				if (message_size > size - pos)
+					invalid_data();
+
+				read_message(channel, message_id, data + pos, message_size, out_events);
+				pos += message_size;
+			}
+		}
+	}
+
+	void NetGameUDPConnectionState::read_fragment(NetGameChannel channel, uint32_t message_id, int index, int count, int total_size, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events)
+	{
+		if (count < 2 || index >= count || total_size > netgame_udp_max_event_size)
+			invalid_data();
+
+		int fragment_size = (total_size + count - 1) / count;
+		int offset = index * fragment_size;
+		if (offset >= total_size || size != std::min(fragment_size, total_size - offset))
+			invalid_data();
+
+		if (!is_expected(channel, message_id))
+			return;
+
+		size_t reassembly_index;
+		for (reassembly_index = 0; reassembly_index < reassemblies.size(); reassembly_index++)
+		{
+			if (reassemblies[reassembly_index].channel == (unsigned char)channel && reassemblies[reassembly_index].message_id == message_id)
+				break;
+		}
+
+		if (reassembly_index == reassemblies.size())
+		{
+			// Fragments of acked packets are never sent again, so only unreliable reassemblies may be given up
+			if (!is_reliable(channel))
+			{
+				int unreliable_count = 0;
+				for (const auto &reassembly : reassemblies)
+					unreliable_count += is_reliable((NetGameChannel)reassembly.channel) ? 0 : 1;
+				if (unreliable_count >= netgame_udp_max_reassemblies)
+				{
+					auto it = std::find_if(reassemblies.begin(), reassemblies.end(), [](const Reassembly &r) { return !is_reliable((NetGameChannel)r.channel); });
+					reassemblies.erase(it);
+				}
+			}
+
+			Reassembly reassembly;
+			reassembly.channel = (unsigned char)channel;
+			reassembly.message_id = message_id;
+			reassembly.fragments_left = count;
+			reassembly.received.resize(count);
+			reassembly.payload.resize(total_size);
+			reassemblies.push_back(std::move(reassembly));
+			reassembly_index = reassemblies.size() - 1;
+		}
+
+		Reassembly &reassembly = reassemblies[reassembly_index];
+		if ((int)reassembly.received.size() != count || (int)reassembly.payload.size() != total_size)
+			invalid_data();
+
+		if (reassembly.received[index])
+			return;
+
+		memcpy(reassembly.payload.data() + offset, data, size);
+		reassembly.received[index] = true;
+		if (--reassembly.fragments_left == 0)
+		{
+			std::vector<unsigned char> payload;
+			payload.swap(reassembly.payload);
+			reassemblies.erase(reassemblies.begin() + reassembly_index);
+			read_message(channel, message_id, payload.data(), payload.size(), out_events);
+		}
+	}
+
+	void NetGameUDPConnectionState::read_message(NetGameChannel channel, uint32_t message_id, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events)
+	{
+		if (!is_expected(channel, message_id))
+			return;
+
+		NetGamePacketRef packet = NetGamePacketPool::acquire(data, size);
+		if (channel == NetGameChannel::reliable_ordered)
+		{
+			if (message_id != ordered_next)
+			{
+				ordered_pending[message_id] = std::move(packet);
+				return;
+			}
+
+			out_events.push_back(std::move(packet));
+			ordered_next++;
+			while (!ordered_pending.empty() && ordered_pending.begin()->first == ordered_next)
+			{
+				out_events.push_back(std::move(ordered_pending.begin()->second));
+				ordered_pending.erase(ordered_pending.begin());
+				ordered_next++;
+			}
+		}
+		else if (channel == NetGameChannel::reliable_unordered)
+		{
+			out_events.push_back(std::move(packet));
+			if (message_id != unordered_base)
+			{
+				unordered_received.insert(message_id);
+				return;
+			}
+
+			unordered_base++;
+			while (!unordered_received.empty() && *unordered_received.begin() == unordered_base)
+			{
+				unordered_received.erase(unordered_received.begin());
+				unordered_base++;
+			}
+		}
+		else
+		{
+			out_events.push_back(std::move(packet));
+			sequenced_newest = message_id;
+			sequenced_any = true;
+		}
+	}
+
+	bool NetGameUDPConnectionState::is_expected(NetGameChannel channel, uint32_t message_id) const
+	{
+		switch (channel)
+		{
+		case NetGameChannel::reliable_ordered:
+			return message_id - ordered_next < netgame_udp_message_window && ordered_pending.find(message_id) == ordered_pending.end();
+		case NetGameChannel::reliable_unordered:
+			return message_id - unordered_base < netgame_udp_message_window && unordered_received.find(message_id) == unordered_received.end();
+		default:
+			return !sequenced_any || (int32_t)(message_id - sequenced_newest) > 0;
+		}
+	}
+
+	uint32_t NetGameUDPConnectionState::expand_message_id(NetGameChannel channel, unsigned short wire_id) const
+	{
+		// Message ids are sent as their lower 16 bits. The full id is the one closest to where the channel is at
+		uint32_t reference;
+		switch (channel)
+		{
+		case NetGameChannel::reliable_ordered: reference = ordered_next; break;
+		case NetGameChannel::reliable_unordered: reference = unordered_base; break;
+		default: reference = sequenced_newest; break;
+		}
+		return reference + (short)(unsigned short)(wire_id - (unsigned short)reference);
+	}
+
+	void NetGameUDPConnectionState::acknowledge(unsigned short sequence, uint64_t now)
+	{
+		SentPacket &sent = sent_packets[sequence % netgame_udp_sent_packet_window];
+		if (!sent.in_use || sent.sequence != sequence)
+			return;
+
+		uint64_t sample = now > sent.send_time ? now - sent.send_time : 0;
+		if (!rtt_measured)
+		{
+			smoothed_rtt = sample;
+			rtt_variance = sample / 2;
+			rtt_measured = true;
+		}
+		else
+		{
+			uint64_t deviation = sample > smoothed_rtt ? sample - smoothed_rtt : smoothed_rtt - sample;
+			rtt_variance = (rtt_variance * 3 + deviation) / 4;
+			smoothed_rtt = (smoothed_rtt * 7 + sample) / 8;
+		}
+
+		for (const NetGameUDPFragment &fragment : sent.fragments)
+		{
+			SendChannel &send_channel = send_channels[fragment.channel];
+			uint32_t index = fragment.message_id - send_channel.oldest_unacked;
+			if (index < send_channel.unacked_fragments.size())
+				send_channel.unacked_fragments[index]--;
+			while (!send_channel.unacked_fragments.empty() && send_channel.unacked_fragments.front() == 0)
+			{
+				send_channel.unacked_fragments.pop_front();
+				send_channel.oldest_unacked++;
+			}
+		}
+
+		sent.fragments.clear();
+		sent.in_use = false;
+		packets_in_flight--;
+	}
+
+	void NetGameUDPConnectionState::requeue(SentPacket &packet)
+	{
+		for (const NetGameUDPFragment &fragment : packet.fragments)
+			resend_queue.push_back(fragment);
+		packet.fragments.clear();
+		packet.in_use = false;
+		packets_in_flight--;
+	}
+
+	void NetGameUDPConnectionState::detect_losses(uint64_t now)
+	{
+		uint64_t timeout = get_retransmit_timeout();
+		while (!sent_order.empty())
+		{
+			unsigned short sequence = sent_order.front();
+			SentPacket &sent = sent_packets[sequence % netgame_udp_sent_packet_window];
+			if (sent.in_use && sent.sequence == sequence)
+			{
+				if (now < sent.send_time + timeout)
+					break;
+				requeue(sent);
+			}
+			sent_order.pop_front();
+		}
+	}
+
+	uint64_t NetGameUDPConnectionState::get_loss_deadline() const
+	{
+		for (unsigned short sequence : sent_order)
+		{
+			const SentPacket &sent = sent_packets[sequence % netgame_udp_sent_packet_window];
+			if (sent.in_use && sent.sequence == sequence)
+				return sent.send_time + get_retransmit_timeout();
+		}
+		return 0;
+	}
+
+	uint64_t NetGameUDPConnectionState::get_retransmit_timeout() const
+	{
+		const uint64_t min_timeout = 10000;
+		const uint64_t max_timeout = 1000000;
+		return std::max(min_timeout, std::min(max_timeout, smoothed_rtt + 4 * rtt_variance));
+	}
+
+	bool NetGameUDPConnectionState::has_queued_data() const
+	{
+		if (!resend_queue.empty())
+			return true;
+		for (const SendChannel &send_channel : send_channels)
+		{
+			if (!send_channel.queue.empty())
+				return true;
+		}
+		return false;
+	}
+
+	bool NetGameUDPConnectionState::has_unacked_data() const
+	{
+		return !send_channels[(int)NetGameChannel::reliable_ordered].unacked_fragments.empty() ||
+			!send_channels[(int)NetGameChannel::reliable_unordered].unacked_fragments.empty();
+	}
+}
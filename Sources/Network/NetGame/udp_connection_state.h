@@ -0,0 +1,213 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/channel.h"
+#include "API/Core/System/databuffer.h"
+#include "packet_pool.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace clan
+{
+	enum
+	{
+		netgame_udp_protocol_id = 0x4e43,
+		netgame_udp_mtu = 1200,
+
+		// Protocol id, packet type, sequence, ack and ack bits
+		netgame_udp_data_header_size = 11,
+
+		// Protocol id, packet type and connection token
+		netgame_udp_control_packet_size = 7,
+
+		// Channel, message id and size, plus fragment index, count and total size when fragmented
+		netgame_udp_message_header_size = 5,
+		netgame_udp_fragment_header_size = 9,
+
+		// Packets remembered for acks and resends
+		netgame_udp_sent_packet_window = 1024,
+
+		// Packets with reliable data that may be waiting for an ack before new reliable data is held back
+		netgame_udp_max_packets_in_flight = 256,
+
+		// Reliable messages that may be in flight per channel, well below the 16 bit id space
+		netgame_udp_message_window = 8192,
+
+		netgame_udp_max_event_size = 32000,
+
+		netgame_udp_max_reassemblies = 64
+	};
+
+	enum class NetGameUDPPacketType : unsigned char
+	{
+		connect = 1,
+		accept = 2,
+		data = 3,
+		disconnect = 4
+	};
+
+	/// \brief Part of an event waiting to be sent, or sent and waiting for its packet to be acked
+	class NetGameUDPFragment
+	{
+	public:
+		DataBuffer message;	// Event as encoded by NetGameNetworkData::send_data
+		uint32_t message_id = 0;
+		unsigned char channel = 0;
+		unsigned char index = 0;
+		unsigned char count = 1;
+		unsigned short offset = 0;	// Into the event payload, which starts after the length prefix of message
+		unsigned short size = 0;
+	};
+
+	/// \brief Wire protocol of one UDP NetGame connection
+	///
+	/// Every data packet carries its own sequence number, the newest sequence number received from
+	/// the peer and a mask acking the 32 packets before that. Events are packed into packets as
+	/// messages, and events too large for one packet are split into fragments. Reliable fragments are
+	/// remembered by the sequence number of the packet they went out in, and are queued again when
+	/// that packet is not acked within the retransmission timeout.
+	///
+	/// Not thread safe. Only the I/O thread of the host touches it.
+	class NetGameUDPConnectionState
+	{
+	public:
+		NetGameUDPConnectionState();
+
+		/// \brief Queues an event encoded by NetGameNetworkData::send_data
+		void queue(const DataBuffer &packet, NetGameChannel channel);
+
+		/// \brief Writes the next data packet. Returns its size, or 0 if there is nothing to send
+		///
+		/// \param force = Write a packet even if it only carries acks
+		int write_packet(uint64_t now, unsigned char *buffer, bool force);
+
+		/// \brief Reads a data packet and appends the events it completed to out_events
+		///
+		/// Throws if the packet is malformed.
+		void read_packet(uint64_t now, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events);
+
+		/// \brief Queues reliable fragments again whose packets were not acked in time
+		void detect_losses(uint64_t now);
+
+		/// \brief Time (System::get_microseconds) when the oldest packet in flight times out, or 0 if none is in flight
+		uint64_t get_loss_deadline() const;
+
+		/// \brief True if events are queued that have not been sent yet
+		bool has_queued_data() const;
+
+		/// \brief True if reliable events were sent that the peer has not acked yet
+		bool has_unacked_data() const;
+
+		/// \brief True if packets were received since the last packet written
+		bool needs_ack() const { return received_since_ack > 0; }
+
+		/// \brief Packets received since the last packet written
+		int get_received_since_ack() const { return received_since_ack; }
+
+		/// \brief Smoothed round trip time in microseconds
+		uint64_t get_rtt() const { return smoothed_rtt; }
+
+		/// \brief Bytes of queued events not sent yet
+		int get_queued_bytes() const { return queued_bytes; }
+
+		static void write_uint16(unsigned char *d, unsigned int value) { d[0] = value & 0xff; d[1] = (value >> 8) & 0xff; }
+		static void write_uint32(unsigned char *d, uint32_t value) { write_uint16(d, value & 0xffff); write_uint16(d + 2, value >> 16); }
+		static unsigned int read_uint16(const unsigned char *d) { return d[0] | (d[1] << 8); }
+		static uint32_t read_uint32(const unsigned char *d) { return read_uint16(d) | ((uint32_t)read_uint16(d + 2) << 16); }
+
+	private:
+		class SentPacket
+		{
+		public:
+			bool in_use = false;
+			unsigned short sequence = 0;
+			uint64_t send_time = 0;
+			std::vector<NetGameUDPFragment> fragments;	// Reliable fragments only
+		};
+
+		class SendChannel
+		{
+		public:
+			std::deque<NetGameUDPFragment> queue;
+			uint32_t next_message_id = 0;
+			uint32_t oldest_unacked = 0;
+			std::deque<unsigned char> unacked_fragments;	// Per message from oldest_unacked to next_message_id
+		};
+
+		class Reassembly
+		{
+		public:
+			unsigned char channel = 0;
+			uint32_t message_id = 0;
+			int fragments_left = 0;
+			std::vector<bool> received;
+			std::vector<unsigned char> payload;
+		};
+
+		void write_fragments(std::deque<NetGameUDPFragment> &queue, bool resend, unsigned char *buffer, int &pos, SentPacket &sent);
+		void acknowledge(unsigned short sequence, uint64_t now);
+		void requeue(SentPacket &packet);
+		void read_fragment(NetGameChannel channel, uint32_t message_id, int index, int count, int total_size, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events);
+		void read_message(NetGameChannel channel, uint32_t message_id, const unsigned char *data, int size, std::vector<NetGamePacketRef> &out_events);
+		bool is_expected(NetGameChannel channel, uint32_t message_id) const;
+		uint64_t get_retransmit_timeout() const;
+		uint32_t expand_message_id(NetGameChannel channel, unsigned short wire_id) const;
+		static bool is_reliable(NetGameChannel channel) { return channel != NetGameChannel::unreliable_sequenced; }
+
+		// Sending
+		SendChannel send_channels[3];
+		std::deque<NetGameUDPFragment> resend_queue;
+		std::vector<SentPacket> sent_packets;
+		std::deque<unsigned short> sent_order;
+		unsigned short local_sequence = 0;
+		int packets_in_flight = 0;
+		int queued_bytes = 0;
+		uint64_t smoothed_rtt = 100000;
+		uint64_t rtt_variance = 50000;
+		bool rtt_measured = false;
+
+		// Receiving
+		unsigned short remote_sequence = 0xffff;
+		uint32_t received_bits = 0;
+		bool received_any = false;
+		int received_since_ack = 0;
+
+		uint32_t ordered_next = 0;
+		std::map<uint32_t, NetGamePacketRef> ordered_pending;
+		uint32_t unordered_base = 0;
+		std::set<uint32_t> unordered_received;
+		uint32_t sequenced_newest = 0;
+		bool sequenced_any = false;
+		std::vector<Reassembly> reassemblies;
+	};
+}
@@ -0,0 +1,493 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/connection_site.h"
+#include "API/Core/System/system.h"
+#include "network_event.h"
+#include "udp_host.h"
+#include <random>
+
+namespace clan
+{
+	namespace
+	{
+		const uint64_t keepalive_interval = 250000;
+		const uint64_t connect_interval = 100000;
+		const uint64_t connect_timeout = 5000000;
+		const uint64_t connection_timeout = 10000000;
+		const uint64_t close_timeout = 3000000;
+
+		// Receiving more packets than this without sending anything makes the host ack right away
+		const int max_unacked_packets = 16;
+
+		// Receive batches per pass, so a flood cannot starve the sending half
+		const int max_receive_batches = 16;
+
+		// Disconnects are not acked, so a few copies go out in case some are lost
+		const int disconnect_copies = 3;
+	}
+
+	bool NetGameUDPPeer::queue(const DataBuffer &packet, NetGameChannel channel)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (send_queue_overflow || disconnect_requested)
+			return false;
+
+		int size = packet.get_size();
+		if (send_queue_limit > 0 && send_queue_size + size > send_queue_limit)
+		{
+			send_queue_overflow = true;
+			return true;
+		}
+
+		// The I/O thread takes the whole queue per pass, so it only needs waking when the queue was empty
+		bool was_empty = send_queue.empty();
+		Message message;
+		message.packet = packet;
+		message.channel = channel;
+		send_queue.push_back(message);
+		send_queue_size += size;
+		return was_empty;
+	}
+
+	void NetGameUDPPeer::request_disconnect()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		disconnect_requested = true;
+	}
+
+	void NetGameUDPPeer::set_send_queue_limit(int bytes)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		send_queue_limit = bytes;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	NetGameUDPHost::NetGameUDPHost(const SocketName &bind_name, const std::function<void(const SocketName &)> &accept)
+		: accept(accept), receive_buffer(UDPSocket::max_batch * netgame_udp_mtu), receive_datagrams(UDPSocket::max_batch),
+		send_buffer(UDPSocket::max_batch * netgame_udp_mtu), send_datagrams(UDPSocket::max_batch)
+	{
+		socket.bind(bind_name);
+		for (int i = 0; i < UDPSocket::max_batch; i++)
+			send_datagrams[i].data = send_buffer.data() + i * netgame_udp_mtu;
+	}
+
+	NetGameUDPHost::~NetGameUDPHost()
+	{
+		stop();
+	}
+
+	void NetGameUDPHost::start()
+	{
+		thread = std::thread(&NetGameUDPHost::thread_main, this);
+	}
+
+	void NetGameUDPHost::stop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stop_flag = true;
+		lock.unlock();
+		worker_event.notify();
+		if (thread.joinable())
+			thread.join();
+
+		// With the I/O thread gone its state can be used here. Peers would otherwise only notice by timing out
+		lock.lock();
+		for (auto &it : peers)
+		{
+			NetGameUDPPeer *peer = it.second.get();
+			if (peer->state == NetGameUDPPeer::State::connected || peer->state == NetGameUDPPeer::State::closing)
+			{
+				for (int i = 0; i < disconnect_copies; i++)
+					send_control_packet(peer, NetGameUDPPacketType::disconnect);
+				peer->state = NetGameUDPPeer::State::finished;
+			}
+		}
+		lock.unlock();
+		flush();
+	}
+
+	std::shared_ptr<NetGameUDPPeer> NetGameUDPHost::add(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &remote, bool connect)
+	{
+		UDPDatagram endpoint;
+		endpoint.set_endpoint(remote);
+
+		auto peer = std::make_shared<NetGameUDPPeer>();
+		peer->base = base;
+		peer->site = site;
+		peer->address = endpoint.address;
+		peer->port = endpoint.port;
+
+		uint64_t now = System::get_microseconds();
+		peer->state_start = now;
+		peer->last_receive = now;
+		if (connect)
+		{
+			std::random_device random;
+			peer->state = NetGameUDPPeer::State::connecting;
+			peer->token = random() | 1;
+		}
+		else
+		{
+			peer->state = NetGameUDPPeer::State::connected;
+			peer->last_send = now;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!peers.insert(std::make_pair(get_key(peer->address, peer->port), peer)).second)
+			throw Exception("Already connected to end point");
+		return peer;
+	}
+
+	void NetGameUDPHost::remove(const std::shared_ptr<NetGameUDPPeer> &peer)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto it = peers.find(get_key(peer->address, peer->port));
+		if (it != peers.end() && it->second == peer)
+			peers.erase(it);
+	}
+
+	void NetGameUDPHost::wake()
+	{
+		worker_event.notify();
+	}
+
+	std::shared_ptr<NetGameUDPPeer> NetGameUDPHost::find(unsigned int address, unsigned short port)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto it = peers.find(get_key(address, port));
+		return it != peers.end() ? it->second : std::shared_ptr<NetGameUDPPeer>();
+	}
+
+	void NetGameUDPHost::thread_main()
+	{
+		try
+		{
+			while (true)
+			{
+				uint64_t deadline = process(System::get_microseconds());
+
+				int timeout = -1;
+				if (deadline != 0)
+				{
+					uint64_t now = System::get_microseconds();
+					timeout = deadline > now ? (int)((deadline - now + 999) / 1000) : 1;
+				}
+
+				std::unique_lock<std::mutex> lock(mutex);
+				if (stop_flag)
+					break;
+				NetworkEvent *events[] = { &socket };
+				worker_event.wait(lock, 1, events, timeout);
+			}
+		}
+		catch (const Exception &e)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			active_peers.clear();
+			for (auto &it : peers)
+				active_peers.push_back(it.second);
+			lock.unlock();
+
+			for (auto &peer : active_peers)
+			{
+				if (peer->state != NetGameUDPPeer::State::finished)
+					finish(peer.get(), e.message, false);
+			}
+			active_peers.clear();
+		}
+	}
+
+	uint64_t NetGameUDPHost::process(uint64_t now)
+	{
+		for (int batch = 0; batch < max_receive_batches; batch++)
+		{
+			for (int i = 0; i < UDPSocket::max_batch; i++)
+			{
+				receive_datagrams[i].data = receive_buffer.data() + i * netgame_udp_mtu;
+				receive_datagrams[i].size = netgame_udp_mtu;
+			}
+
+			int count = socket.read(receive_datagrams.data(), UDPSocket::max_batch);
+			for (int i = 0; i < count; i++)
+				receive_datagram(receive_datagrams[i], now);
+
+			if (count < UDPSocket::max_batch)
+				break;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		for (auto &it : peers)
+			active_peers.push_back(it.second);
+		lock.unlock();
+
+		uint64_t deadline = 0;
+		for (auto &peer : active_peers)
+		{
+			uint64_t peer_deadline = update(peer.get(), now);
+			if (peer_deadline != 0 && (deadline == 0 || peer_deadline < deadline))
+				deadline = peer_deadline;
+		}
+		flush();
+
+		active_peers.clear();
+		return deadline;
+	}
+
+	void NetGameUDPHost::receive_datagram(const UDPDatagram &datagram, uint64_t now)
+	{
+		const unsigned char *data = static_cast<const unsigned char *>(datagram.data);
+		if (datagram.size < 3 || NetGameUDPConnectionState::read_uint16(data) != netgame_udp_protocol_id)
+			return;
+
+		NetGameUDPPacketType type = (NetGameUDPPacketType)data[2];
+		if (type == NetGameUDPPacketType::data)
+		{
+			std::shared_ptr<NetGameUDPPeer> peer = find(datagram.address, datagram.port);
+			if (peer)
+				receive_data(peer.get(), datagram, now);
+			return;
+		}
+
+		if (datagram.size != netgame_udp_control_packet_size)
+			return;
+
+		uint32_t token = NetGameUDPConnectionState::read_uint32(data + 3);
+		if (type == NetGameUDPPacketType::connect)
+		{
+			receive_connect(datagram, token, now);
+		}
+		else if (type == NetGameUDPPacketType::accept)
+		{
+			std::shared_ptr<NetGameUDPPeer> peer = find(datagram.address, datagram.port);
+			if (peer && peer->state == NetGameUDPPeer::State::connecting && peer->token == token)
+			{
+				peer->state = NetGameUDPPeer::State::connected;
+				peer->state_start = now;
+				peer->last_receive = now;
+				peer->connect_announced = true;
+				peer->site->add_network_event(NetGameNetworkEvent(peer->base, NetGameNetworkEvent::Type::client_connected));
+			}
+		}
+		else if (type == NetGameUDPPacketType::disconnect)
+		{
+			std::shared_ptr<NetGameUDPPeer> peer = find(datagram.address, datagram.port);
+			if (peer && peer->token == token && peer->state != NetGameUDPPeer::State::finished)
+				finish(peer.get(), std::string(), false);
+		}
+	}
+
+	void NetGameUDPHost::receive_connect(const UDPDatagram &datagram, uint32_t token, uint64_t now)
+	{
+		std::shared_ptr<NetGameUDPPeer> peer = find(datagram.address, datagram.port);
+		if (!peer)
+		{
+			if (!accept)
+				return;
+
+			// The host mutex must not be held here, as the callback locks the server and then adds the connection
+			accept(datagram.get_endpoint());
+			peer = find(datagram.address, datagram.port);
+			if (!peer)
+				return;
+			peer->token = token;
+		}
+
+		// A different token is a client that restarted on the same end point. It keeps retrying until the old connection is removed
+		if (peer->token != token || peer->state != NetGameUDPPeer::State::connected)
+			return;
+
+		peer->last_receive = now;
+		if (!peer->connect_announced)
+		{
+			peer->connect_announced = true;
+			peer->site->add_network_event(NetGameNetworkEvent(peer->base, NetGameNetworkEvent::Type::client_connected));
+		}
+
+		// Also answers repeated requests, in case an earlier accept was lost
+		send_control_packet(peer.get(), NetGameUDPPacketType::accept);
+	}
+
+	void NetGameUDPHost::receive_data(NetGameUDPPeer *peer, const UDPDatagram &datagram, uint64_t now)
+	{
+		if (peer->state != NetGameUDPPeer::State::connected && peer->state != NetGameUDPPeer::State::closing)
+			return;
+
+		peer->last_receive = now;
+		try
+		{
+			peer->protocol.read_packet(now, static_cast<const unsigned char *>(datagram.data), datagram.size, received_events);
+		}
+		catch (const Exception &e)
+		{
+			received_events.clear();
+			finish(peer, e.message, true);
+			return;
+		}
+
+		for (const NetGamePacketRef &packet : received_events)
+			peer->site->add_network_event(NetGameNetworkEvent(peer->base, packet));
+		received_events.clear();
+
+		if (peer->protocol.get_received_since_ack() >= max_unacked_packets)
+			send_packets(peer, now, true);
+	}
+
+	uint64_t NetGameUDPHost::update(NetGameUDPPeer *peer, uint64_t now)
+	{
+		if (peer->state == NetGameUDPPeer::State::finished)
+			return 0;
+
+		if (peer->state == NetGameUDPPeer::State::connecting)
+		{
+			if (now - peer->state_start >= connect_timeout)
+			{
+				finish(peer, "Connection timed out", false);
+				return 0;
+			}
+
+			if (peer->last_send == 0 || now - peer->last_send >= connect_interval)
+			{
+				send_control_packet(peer, NetGameUDPPacketType::connect);
+				peer->last_send = now;
+			}
+			return peer->last_send + connect_interval;
+		}
+
+		std::unique_lock<std::mutex> lock(peer->mutex);
+		peer->send_batch.swap(peer->send_queue);
+		bool overflow = peer->send_queue_overflow;
+		bool disconnect = peer->disconnect_requested;
+		lock.unlock();
+
+		for (const auto &message : peer->send_batch)
+			peer->protocol.queue(message.packet, message.channel);
+		peer->send_batch.clear();
+
+		if (overflow)
+		{
+			finish(peer, "Send queue limit exceeded", true);
+			return 0;
+		}
+
+		if (disconnect && peer->state == NetGameUDPPeer::State::connected)
+		{
+			peer->state = NetGameUDPPeer::State::closing;
+			peer->state_start = now;
+		}
+
+		peer->protocol.detect_losses(now);
+		send_packets(peer, now, peer->protocol.needs_ack() || now - peer->last_send >= keepalive_interval);
+
+		if (now - peer->last_receive >= connection_timeout)
+		{
+			finish(peer, "Connection timed out", false);
+			return 0;
+		}
+
+		if (peer->state == NetGameUDPPeer::State::closing)
+		{
+			bool done = !peer->protocol.has_queued_data() && !peer->protocol.has_unacked_data();
+			if (done || now - peer->state_start >= close_timeout)
+			{
+				finish(peer, std::string(), true);
+				return 0;
+			}
+		}
+
+		uint64_t deadline = std::min(peer->last_send + keepalive_interval, peer->last_receive + connection_timeout);
+		uint64_t loss_deadline = peer->protocol.get_loss_deadline();
+		if (loss_deadline != 0)
+			deadline = std::min(deadline, loss_deadline);
+		if (peer->state == NetGameUDPPeer::State::closing)
+			deadline = std::min(deadline, peer->state_start + close_timeout);
+		return deadline;
+	}
+
+	void NetGameUDPHost::send_packets(NetGameUDPPeer *peer, uint64_t now, bool force)
+	{
+		int queued_before = peer->protocol.get_queued_bytes();
+		while (true)
+		{
+			int size = peer->protocol.write_packet(now, begin_datagram(), force);
+			if (size == 0)
+				break;
+			end_datagram(peer, size);
+			peer->last_send = now;
+			force = false;
+		}
+		peer->send_queue_size -= queued_before - peer->protocol.get_queued_bytes();
+	}
+
+	void NetGameUDPHost::send_control_packet(NetGameUDPPeer *peer, NetGameUDPPacketType type)
+	{
+		unsigned char *d = begin_datagram();
+		NetGameUDPConnectionState::write_uint16(d, netgame_udp_protocol_id);
+		d[2] = (unsigned char)type;
+		NetGameUDPConnectionState::write_uint32(d + 3, peer->token);
+		end_datagram(peer, netgame_udp_control_packet_size);
+	}
+
+	void NetGameUDPHost::finish(NetGameUDPPeer *peer, const std::string &reason, bool send_disconnect)
+	{
+		if (send_disconnect)
+		{
+			for (int i = 0; i < disconnect_copies; i++)
+				send_control_packet(peer, NetGameUDPPacketType::disconnect);
+		}
+
+		// Nothing is posted for the connection after this, so the site may delete it once it sees the event
+		peer->state = NetGameUDPPeer::State::finished;
+		peer->site->add_network_event(NetGameNetworkEvent(peer->base, NetGameNetworkEvent::Type::client_disconnected, NetGameEvent(reason)));
+	}
+
+	unsigned char *NetGameUDPHost::begin_datagram()
+	{
+		if (send_count == UDPSocket::max_batch)
+			flush();
+		return static_cast<unsigned char *>(send_datagrams[send_count].data);
+	}
+
+	void NetGameUDPHost::end_datagram(NetGameUDPPeer *peer, int size)
+	{
+		UDPDatagram &datagram = send_datagrams[send_count++];
+		datagram.size = size;
+		datagram.address = peer->address;
+		datagram.port = peer->port;
+	}
+
+	void NetGameUDPHost::flush()
+	{
+		// Datagrams the socket has no room for are dropped like any other lost packet
+		if (send_count > 0)
+			socket.send(send_datagrams.data(), send_count);
+		send_count = 0;
+	}
+}
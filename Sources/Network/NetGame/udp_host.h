@@ -0,0 +1,164 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/Socket/udp_socket.h"
+#include "API/Network/Socket/socket_name.h"
+#include "udp_connection_state.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace clan
+{
+	class NetGameConnection;
+	class NetGameConnectionSite;
+
+	/// \brief A connection of a UDP host
+	///
+	/// The queue half is shared with the NetGameConnection and guarded by mutex. Everything else
+	/// belongs to the I/O thread of the host.
+	class NetGameUDPPeer
+	{
+	public:
+		/// \brief Queues an encoded event. Returns true if the host has to be woken up
+		bool queue(const DataBuffer &packet, NetGameChannel channel);
+
+		/// \brief Sends what is queued and then closes the connection
+		void request_disconnect();
+
+		void set_send_queue_limit(int bytes);
+		int get_send_queue_size() const { return send_queue_size; }
+
+		enum class State
+		{
+			connecting,
+			connected,
+			closing,
+			finished
+		};
+
+		NetGameConnection *base = nullptr;
+		NetGameConnectionSite *site = nullptr;
+		unsigned int address = 0;
+		unsigned short port = 0;
+
+	private:
+		class Message
+		{
+		public:
+			DataBuffer packet;
+			NetGameChannel channel;
+		};
+
+		std::mutex mutex;
+		std::vector<Message> send_queue;
+		bool disconnect_requested = false;
+		bool send_queue_overflow = false;
+		int send_queue_limit = 0;
+		std::atomic<int> send_queue_size{0};
+
+		State state = State::connecting;
+		bool connect_announced = false;
+		uint32_t token = 0;
+		NetGameUDPConnectionState protocol;
+		std::vector<Message> send_batch;
+		uint64_t state_start = 0;
+		uint64_t last_receive = 0;
+		uint64_t last_send = 0;
+
+		friend class NetGameUDPHost;
+	};
+
+	/// \brief UDP socket and I/O thread shared by the connections of a server, or owned by a client connection
+	///
+	/// Each pass of the I/O thread reads all waiting datagrams with as few system calls as possible,
+	/// feeds them to their connections, and then sends everything the connections have to send in
+	/// batches, so that acks and events for many clients go out together.
+	class NetGameUDPHost
+	{
+	public:
+		/// \brief Creates a host with a socket bound to bind_name
+		///
+		/// \param accept = Called on the I/O thread when an unknown end point asks to connect. It should create a connection with add. If empty, connect requests are ignored.
+		NetGameUDPHost(const SocketName &bind_name, const std::function<void(const SocketName &)> &accept);
+		~NetGameUDPHost();
+
+		void start();
+
+		/// \brief Stops the I/O thread and tells the connected peers that the connections are closed
+		void stop();
+
+		/// \brief Adds a connection to remote. Connections that connect send connect requests until the remote accepts
+		std::shared_ptr<NetGameUDPPeer> add(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &remote, bool connect);
+
+		/// \brief Removes a connection. No events are posted for a finished connection, so it is safe to delete its NetGameConnection afterwards
+		void remove(const std::shared_ptr<NetGameUDPPeer> &peer);
+
+		void wake();
+
+	private:
+		void thread_main();
+		uint64_t process(uint64_t now);
+		void receive_datagram(const UDPDatagram &datagram, uint64_t now);
+		void receive_connect(const UDPDatagram &datagram, uint32_t token, uint64_t now);
+		void receive_data(NetGameUDPPeer *peer, const UDPDatagram &datagram, uint64_t now);
+		uint64_t update(NetGameUDPPeer *peer, uint64_t now);
+		void send_packets(NetGameUDPPeer *peer, uint64_t now, bool force);
+		void send_control_packet(NetGameUDPPeer *peer, NetGameUDPPacketType type);
+		void finish(NetGameUDPPeer *peer, const std::string &reason, bool send_disconnect);
+		std::shared_ptr<NetGameUDPPeer> find(unsigned int address, unsigned short port);
+		unsigned char *begin_datagram();
+		void end_datagram(NetGameUDPPeer *peer, int size);
+		void flush();
+
+		static uint64_t get_key(unsigned int address, unsigned short port) { return ((uint64_t)address << 16) | port; }
+
+		UDPSocket socket;
+		std::function<void(const SocketName &)> accept;
+		std::thread thread;
+		NetworkConditionVariable worker_event;
+		std::mutex mutex;
+		bool stop_flag = false;
+		std::unordered_map<uint64_t, std::shared_ptr<NetGameUDPPeer>> peers;
+
+		// Owned by the I/O thread
+		std::vector<std::shared_ptr<NetGameUDPPeer>> active_peers;
+		std::vector<unsigned char> receive_buffer;
+		std::vector<UDPDatagram> receive_datagrams;
+		std::vector<unsigned char> send_buffer;
+		std::vector<UDPDatagram> send_datagrams;
+		int send_count = 0;
+		std::vector<NetGamePacketRef> received_events;
+	};
+}
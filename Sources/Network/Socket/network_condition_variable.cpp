@@ -30,10 +30,17 @@
 #include "Network/precomp.h"
 #include "API/Network/Socket/network_condition_variable.h"
 #include "tcp_socket.h"
+#include <algorithm>
 
 #ifndef WIN32
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unordered_map>
+#endif
 #endif
 
 namespace clan
@@ -55,6 +62,7 @@ namespace clan
 		}
 
 		HANDLE notify_handle;
+		std::vector<NetworkEvent *> registered;
 	};
 
 	NetworkConditionVariable::NetworkConditionVariable() : impl(std::make_shared<NetworkConditionVariableImpl>())
@@ -86,6 +94,60 @@ namespace clan
 		return true;
 	}
 
+	void NetworkConditionVariable::add(NetworkEvent *event)
+	{
+		if (std::find(impl->registered.begin(), impl->registered.end(), event) == impl->registered.end())
+			impl->registered.push_back(event);
+	}
+
+	void NetworkConditionVariable::remove(NetworkEvent *event)
+	{
+		impl->registered.erase(std::remove(impl->registered.begin(), impl->registered.end(), event), impl->registered.end());
+	}
+
+	int NetworkConditionVariable::wait_ready_impl(NetworkEvent **out_events, int max_events, int timeout)
+	{
+		if (max_events <= 0)
+			return 0;
+
+		int count = (int)impl->registered.size();
+		if (count + 1 > MAXIMUM_WAIT_OBJECTS)
+			throw Exception("Too many sockets registered for WaitForMultipleObjects");
+
+		std::vector<HANDLE> handles;
+		handles.reserve(count + 1);
+		for (NetworkEvent *event : impl->registered)
+		{
+			handles.push_back(event->get_socket_handle()->wait_handle);
+		}
+		handles.push_back(impl->notify_handle);
+
+		DWORD result = WaitForMultipleObjects(handles.size(), &handles[0], FALSE, timeout >= 0 ? timeout : INFINITE);
+		if (result == WAIT_TIMEOUT)
+			return 0;
+		else if (result < WAIT_OBJECT_0 || result > WAIT_OBJECT_0 + count)
+			throw Exception("WaitForMultipleObjects failed");
+
+		int event_index = result - WAIT_OBJECT_0;
+		if (event_index == count)
+		{
+			ResetEvent(impl->notify_handle);
+			return 0;
+		}
+
+		// WaitForMultipleObjects only reports the first signaled handle, so the ones after it are checked as well
+		int ready_count = 0;
+		for (int i = event_index; i < count && ready_count < max_events; i++)
+		{
+			if (i == event_index || WaitForSingleObject(handles[i], 0) == WAIT_OBJECT_0)
+			{
+				impl->registered[i]->get_socket_handle()->reset_wait_handle();
+				out_events[ready_count++] = impl->registered[i];
+			}
+		}
+		return ready_count;
+	}
+
 	void NetworkConditionVariable::notify()
 	{
 		SetEvent(impl->notify_handle);
@@ -98,37 +160,105 @@ namespace clan
 	public:
 		NetworkConditionVariableImpl()
 		{
-			int result = pipe(notify_handle);
+#if defined(__linux__)
+			notify_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (notify_handle < 0)
+				throw Exception("Unable to create eventfd handle");
+#else
+			int result = pipe(notify_pipe);
 			if (result < 0)
 				throw Exception("Unable to create pipe handle");
 
-			result = fcntl(notify_handle[0], F_SETFL, O_NONBLOCK);
+			result = fcntl(notify_pipe[0], F_SETFL, O_NONBLOCK);
 			if (result < 0)
 			{
-				::close(notify_handle[0]);
-				::close(notify_handle[1]);
+				::close(notify_pipe[0]);
+				::close(notify_pipe[1]);
 				throw Exception("Unable to set pipe non-blocking mode");
 			}
+#endif
 		}
 
 		~NetworkConditionVariableImpl()
 		{
-			::close(notify_handle[0]);
-			::close(notify_handle[1]);
+#if defined(__linux__)
+			if (epoll_handle != -1)
+				::close(epoll_handle);
+			::close(notify_handle);
+#else
+			::close(notify_pipe[0]);
+			::close(notify_pipe[1]);
+#endif
+		}
+
+#if defined(__linux__)
+		int get_notify_handle() const
+		{
+			return notify_handle;
+		}
+
+		void reset_notify()
+		{
+			uint64_t value;
+			while (read(notify_handle, &value, sizeof(value)) == sizeof(value));
+		}
+
+		void set_notify()
+		{
+			uint64_t value = 1;
+			::write(notify_handle, &value, sizeof(value));
+		}
+
+		int get_epoll_handle()
+		{
+			if (epoll_handle == -1)
+			{
+				epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+				if (epoll_handle == -1)
+					throw Exception("Unable to create epoll handle");
+
+				// The notify handle is the only registration without an event pointer
+				epoll_event event = {};
+				event.events = EPOLLIN;
+				event.data.ptr = nullptr;
+				if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, notify_handle, &event) == -1)
+				{
+					::close(epoll_handle);
+					epoll_handle = -1;
+					throw Exception("Unable to register eventfd handle");
+				}
+			}
+			return epoll_handle;
+		}
+
+		int notify_handle = -1;
+		int epoll_handle = -1;
+
+		// Descriptor each event source had when it was registered
+		std::unordered_map<NetworkEvent *, int> registered;
+#else
+		int get_notify_handle() const
+		{
+			return notify_pipe[0];
 		}
 
 		void reset_notify()
 		{
 			unsigned char buf;
-			while (read(notify_handle[0], &buf, 1) == 1);
+			while (read(notify_pipe[0], &buf, 1) == 1);
 		}
 
 		void set_notify()
 		{
-			::write(notify_handle[1], "x", 1);
+			::write(notify_pipe[1], "x", 1);
 		}
 
-		int notify_handle[2];
+		int notify_pipe[2];
+
+		std::vector<NetworkEvent *> registered;
+		std::vector<pollfd> registered_fds;
+		size_t next_ready = 0;
+#endif
 	};
 
 	NetworkConditionVariable::NetworkConditionVariable() : impl(std::make_shared<NetworkConditionVariableImpl>())
@@ -137,30 +267,41 @@ namespace clan
 
 	bool NetworkConditionVariable::wait_impl(int count, NetworkEvent **events, int timeout_ms)
 	{
-		int max_fd = impl->notify_handle[0];
+		const int small_count = 16;
+		pollfd small_fds[small_count];
+		std::vector<pollfd> large_fds;
+		pollfd *fds = small_fds;
+		if (count + 1 > small_count)
+		{
+			large_fds.resize(count + 1);
+			fds = large_fds.data();
+		}
 
-		fd_set rfds, wfds;
-		FD_ZERO(&rfds);
-		FD_ZERO(&wfds);
-		FD_SET(impl->notify_handle[0], &rfds);
+		fds[0].fd = impl->get_notify_handle();
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->begin_wait(rfds, wfds, max_fd);
+			SocketHandle *socket = events[i]->get_socket_handle();
+			fds[i + 1].fd = socket->get_wait_handle();
+			fds[i + 1].events = POLLIN | (socket->is_write_pending() ? POLLOUT : 0);
+			fds[i + 1].revents = 0;
 		}
 
-		timeval tv;
-		tv.tv_sec = timeout_ms / 1000;
-		tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-		//FIXME - Should this have: Use "!impl->can_write ? &wfds : 0" ??
-		int result = select(max_fd + 1, &rfds, 0, 0, timeout_ms >= 0 ? &tv : 0);
+		int result = poll(fds, count + 1, timeout_ms >= 0 ? timeout_ms : -1);
 		if (result == -1)
-			throw Exception("select failed");
+		{
+			if (errno == EINTR)
+				return true;
+			throw Exception("poll failed");
+		}
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->end_wait(rfds, wfds);
+			short revents = fds[i + 1].revents;
+			if (revents)
+				events[i]->get_socket_handle()->wait_completed((revents & (POLLIN | POLLERR | POLLHUP)) != 0, (revents & (POLLOUT | POLLERR | POLLHUP)) != 0);
 		}
 
 		impl->reset_notify();
@@ -168,6 +309,138 @@ namespace clan
 		return result > 0;
 	}
 
+#if defined(__linux__)
+
+	void NetworkConditionVariable::add(NetworkEvent *event)
+	{
+		if (impl->registered.find(event) != impl->registered.end())
+			return;
+
+		int fd = event->get_socket_handle()->get_wait_handle();
+		if (fd == -1)
+			throw Exception("Socket is not open");
+
+		epoll_event registration = {};
+		registration.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		registration.data.ptr = event;
+		if (epoll_ctl(impl->get_epoll_handle(), EPOLL_CTL_ADD, fd, &registration) == -1)
+			throw Exception("Unable to register socket handle");
+
+		impl->registered[event] = fd;
+	}
+
+	void NetworkConditionVariable::remove(NetworkEvent *event)
+	{
+		auto it = impl->registered.find(event);
+		if (it == impl->registered.end())
+			return;
+
+		// Closing a socket already drops its registration, and the descriptor may since have been reused
+		if (event->get_socket_handle()->get_wait_handle() == it->second)
+			epoll_ctl(impl->epoll_handle, EPOLL_CTL_DEL, it->second, nullptr);
+
+		impl->registered.erase(it);
+	}
+
+	int NetworkConditionVariable::wait_ready_impl(NetworkEvent **out_events, int max_events, int timeout_ms)
+	{
+		if (max_events <= 0)
+			return 0;
+
+		const int max_batch = 64;
+		epoll_event ready[max_batch];
+		int result = epoll_wait(impl->get_epoll_handle(), ready, std::min(max_events, max_batch), timeout_ms >= 0 ? timeout_ms : -1);
+		if (result == -1)
+		{
+			if (errno == EINTR)
+				return 0;
+			throw Exception("epoll_wait failed");
+		}
+
+		int count = 0;
+		for (int i = 0; i < result; i++)
+		{
+			NetworkEvent *event = static_cast<NetworkEvent *>(ready[i].data.ptr);
+			if (!event)
+			{
+				impl->reset_notify();
+				continue;
+			}
+
+			bool failed = (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+			bool readable = failed || (ready[i].events & (EPOLLIN | EPOLLRDHUP)) != 0;
+			bool writable = failed || (ready[i].events & EPOLLOUT) != 0;
+			event->get_socket_handle()->wait_completed(readable, writable);
+			out_events[count++] = event;
+		}
+		return count;
+	}
+
+#else
+
+	void NetworkConditionVariable::add(NetworkEvent *event)
+	{
+		if (std::find(impl->registered.begin(), impl->registered.end(), event) == impl->registered.end())
+			impl->registered.push_back(event);
+	}
+
+	void NetworkConditionVariable::remove(NetworkEvent *event)
+	{
+		impl->registered.erase(std::remove(impl->registered.begin(), impl->registered.end(), event), impl->registered.end());
+	}
+
+	int NetworkConditionVariable::wait_ready_impl(NetworkEvent **out_events, int max_events, int timeout_ms)
+	{
+		if (max_events <= 0)
+			return 0;
+
+		// Without epoll the registered sockets are polled level triggered, which still satisfies the edge triggered contract.
+		// Writability is only asked for while a write is pending, as an idle socket is always writable.
+		size_t count = impl->registered.size();
+		std::vector<pollfd> &fds = impl->registered_fds;
+		fds.resize(count + 1);
+		for (size_t i = 0; i < count; i++)
+		{
+			SocketHandle *socket = impl->registered[i]->get_socket_handle();
+			fds[i].fd = socket->get_wait_handle();
+			fds[i].events = POLLIN | (socket->is_write_pending() ? POLLOUT : 0);
+			fds[i].revents = 0;
+		}
+		fds[count].fd = impl->get_notify_handle();
+		fds[count].events = POLLIN;
+		fds[count].revents = 0;
+
+		int result = poll(fds.data(), fds.size(), timeout_ms >= 0 ? timeout_ms : -1);
+		if (result == -1)
+		{
+			if (errno == EINTR)
+				return 0;
+			throw Exception("poll failed");
+		}
+
+		if (fds[count].revents)
+			impl->reset_notify();
+
+		// Rotate the starting point so busy sockets early in the list cannot starve the rest
+		int ready_count = 0;
+		for (size_t j = 0; j < count && ready_count < max_events; j++)
+		{
+			size_t i = (impl->next_ready + j) % count;
+			short revents = fds[i].revents;
+			if (revents)
+			{
+				NetworkEvent *event = impl->registered[i];
+				event->get_socket_handle()->wait_completed((revents & (POLLIN | POLLERR | POLLHUP)) != 0, (revents & (POLLOUT | POLLERR | POLLHUP)) != 0);
+				out_events[ready_count++] = event;
+			}
+		}
+		if (count > 0)
+			impl->next_ready = (impl->next_ready + 1) % count;
+		return ready_count;
+	}
+
+#endif
+
 	void NetworkConditionVariable::notify()
 	{
 		impl->set_notify();
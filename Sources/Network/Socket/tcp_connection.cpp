@@ -75,6 +75,29 @@ namespace clan
 		return result;
 	}
 
+	int TCPConnection::write(const void * const *data, const int *sizes, int count)
+	{
+		WSABUF buffers[max_write_buffers];
+		if (count > max_write_buffers)
+			count = max_write_buffers;
+		for (int i = 0; i < count; i++)
+		{
+			buffers[i].buf = static_cast<char *>(const_cast<void *>(data[i]));
+			buffers[i].len = sizes[i];
+		}
+
+		DWORD bytes_sent = 0;
+		int result = WSASend(impl->handle, buffers, count, &bytes_sent, 0, nullptr, nullptr);
+		if (result == SOCKET_ERROR)
+		{
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+				return -1;
+			else
+				throw Exception("Error writing to server");
+		}
+		return bytes_sent;
+	}
+
 	int TCPConnection::read(void *data, int size)
 	{
 		int result = ::recv(impl->handle, static_cast<char *>(data), size, 0);
@@ -198,6 +221,38 @@ namespace clan
 		return result;
 	}
 
+	int TCPConnection::write(const void * const *data, const int *sizes, int count)
+	{
+		iovec buffers[max_write_buffers];
+		if (count > max_write_buffers)
+			count = max_write_buffers;
+		for (int i = 0; i < count; i++)
+		{
+			buffers[i].iov_base = const_cast<void *>(data[i]);
+			buffers[i].iov_len = sizes[i];
+		}
+
+		msghdr message;
+		memset(&message, 0, sizeof(msghdr));
+		message.msg_iov = buffers;
+		message.msg_iovlen = count;
+
+		int result = ::sendmsg(impl->handle, &message, 0);
+		if (result == -1)
+		{
+			if (errno == EWOULDBLOCK)
+			{
+				impl->can_write = false;
+				return -1;
+			}
+			else
+			{
+				throw Exception("Error writing to server");
+			}
+		}
+		return result;
+	}
+
 	int TCPConnection::read(void *data, int size)
 	{
 		int result = ::recv(impl->handle, static_cast<char *>(data), size, 0);
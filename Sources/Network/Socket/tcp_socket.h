@@ -8,6 +8,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <netinet/in.h>
@@ -90,8 +91,14 @@ namespace clan
 	class SocketHandle
 	{
 	public:
-		virtual void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) = 0;
-		virtual void end_wait(fd_set &rfds, fd_set &wfds) = 0;
+		/// \brief Descriptor NetworkConditionVariable waits on
+		virtual int get_wait_handle() const = 0;
+
+		/// \brief True if a wait should also wake up when the socket becomes writable
+		virtual bool is_write_pending() const { return false; }
+
+		/// \brief Called with the readiness reported by a wait
+		virtual void wait_completed(bool readable, bool writable) { }
 	};
 
 	class TCPSocket : public SocketHandle
@@ -111,7 +118,7 @@ namespace clan
 		}
 
 		TCPSocket(int handle)
-			: handle(handle)
+			: handle(handle), can_write(false)
 		{
 		}
 
@@ -129,20 +136,20 @@ namespace clan
 			}
 		}
 
-		void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) override
+		int get_wait_handle() const override
 		{
-			FD_SET(handle, &rfds);
-			if (!can_write)
-				FD_SET(handle, &wfds);
-			max_fd = std::max(max_fd, handle);
+			return handle;
 		}
 
-		void end_wait(fd_set &rfds, fd_set &wfds) override
+		bool is_write_pending() const override
 		{
-			if (FD_ISSET(handle, &wfds))
-			{
+			return !can_write;
+		}
+
+		void wait_completed(bool readable, bool writable) override
+		{
+			if (writable)
 				can_write = true;
-			}
 		}
 
 		int handle;
@@ -110,6 +110,58 @@ namespace clan
 		return result;
 	}
 
+	int UDPSocket::send(const UDPDatagram *datagrams, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(sockaddr_in));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = datagrams[i].address;
+			addr.sin_port = datagrams[i].port;
+
+			int result = sendto(impl->handle, static_cast<const char*>(datagrams[i].data), datagrams[i].size, 0, (const sockaddr *)&addr, sizeof(sockaddr_in));
+			if (result == SOCKET_ERROR)
+			{
+				int last_error = WSAGetLastError();
+				if (last_error == WSAENOBUFS || last_error == WSAEWOULDBLOCK)
+					return i;
+				else if (last_error != WSAEMSGSIZE && last_error != WSAEHOSTUNREACH && last_error != WSAENETUNREACH)
+					throw Exception("Error writing to udp socket");
+			}
+		}
+		return count;
+	}
+
+	int UDPSocket::read(UDPDatagram *datagrams, int count)
+	{
+		int received = 0;
+		while (received < count)
+		{
+			sockaddr_in addr;
+			int addr_len = sizeof(sockaddr_in);
+
+			UDPDatagram &datagram = datagrams[received];
+			int result = recvfrom(impl->handle, static_cast<char*>(datagram.data), datagram.size, 0, (sockaddr *)&addr, &addr_len);
+			if (result == SOCKET_ERROR)
+			{
+				int last_error = WSAGetLastError();
+				if (last_error == WSAEWOULDBLOCK)
+					break;
+				else if (last_error == WSAEMSGSIZE || last_error == WSAECONNRESET || last_error == WSAENETRESET)
+					continue;
+				else
+					throw Exception("Error reading from udp socket");
+			}
+
+			datagram.size = result;
+			datagram.address = addr.sin_addr.s_addr;
+			datagram.port = addr.sin_port;
+			received++;
+		}
+		return received;
+	}
+
 	void UDPSocket::close()
 	{
 		impl->close();
@@ -149,14 +201,9 @@ namespace clan
 			}
 		}
 
-		void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) override
-		{
-			FD_SET(handle, &rfds);
-			max_fd = std::max(max_fd, handle);
-		}
-
-		void end_wait(fd_set &rfds, fd_set &wfds) override
+		int get_wait_handle() const override
 		{
+			return handle;
 		}
 
 		int handle;
@@ -217,5 +264,161 @@ namespace clan
 		return result;
 	}
 
+#if defined(__linux__)
+
+	int UDPSocket::send(const UDPDatagram *datagrams, int count)
+	{
+		sockaddr_in addrs[max_batch];
+		iovec iovecs[max_batch];
+		mmsghdr messages[max_batch];
+
+		int sent = 0;
+		while (sent < count)
+		{
+			int batch = std::min(count - sent, (int)max_batch);
+			for (int i = 0; i < batch; i++)
+			{
+				const UDPDatagram &datagram = datagrams[sent + i];
+				memset(&addrs[i], 0, sizeof(sockaddr_in));
+				addrs[i].sin_family = AF_INET;
+				addrs[i].sin_addr.s_addr = datagram.address;
+				addrs[i].sin_port = datagram.port;
+				iovecs[i].iov_base = datagram.data;
+				iovecs[i].iov_len = datagram.size;
+				memset(&messages[i], 0, sizeof(mmsghdr));
+				messages[i].msg_hdr.msg_name = &addrs[i];
+				messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+				messages[i].msg_hdr.msg_iov = &iovecs[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			int result = sendmmsg(impl->handle, messages, batch, 0);
+			if (result == -1)
+			{
+				if (errno == EWOULDBLOCK || errno == EAGAIN || errno == ENOBUFS)
+					break;
+				else if (errno == EINTR)
+					continue;
+
+				// Like sendto, other errors only drop the packet that failed
+				result = 1;
+			}
+			sent += result;
+		}
+		return sent;
+	}
+
+	int UDPSocket::read(UDPDatagram *datagrams, int count)
+	{
+		sockaddr_in addrs[max_batch];
+		iovec iovecs[max_batch];
+		mmsghdr messages[max_batch];
+
+		int batch = std::min(count, (int)max_batch);
+		for (int i = 0; i < batch; i++)
+		{
+			iovecs[i].iov_base = datagrams[i].data;
+			iovecs[i].iov_len = datagrams[i].size;
+			memset(&messages[i], 0, sizeof(mmsghdr));
+			messages[i].msg_hdr.msg_name = &addrs[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int result = recvmmsg(impl->handle, messages, batch, 0, nullptr);
+		if (result == -1)
+		{
+			if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR || errno == EMSGSIZE || errno == ECONNREFUSED || errno == ECONNRESET || errno == ENETRESET)
+				return 0;
+			else
+				throw Exception("Error reading from udp socket");
+		}
+
+		int received = 0;
+		for (int i = 0; i < result; i++)
+		{
+			if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+				continue;
+
+			datagrams[received].data = iovecs[i].iov_base;
+			datagrams[received].size = messages[i].msg_len;
+			datagrams[received].address = addrs[i].sin_addr.s_addr;
+			datagrams[received].port = addrs[i].sin_port;
+			received++;
+		}
+		return received;
+	}
+
+#else
+
+	int UDPSocket::send(const UDPDatagram *datagrams, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(sockaddr_in));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = datagrams[i].address;
+			addr.sin_port = datagrams[i].port;
+
+			int result = sendto(impl->handle, static_cast<const char*>(datagrams[i].data), datagrams[i].size, 0, (const sockaddr *)&addr, sizeof(sockaddr_in));
+			if (result == -1 && (errno == EWOULDBLOCK || errno == EAGAIN || errno == ENOBUFS))
+				return i;
+		}
+		return count;
+	}
+
+	int UDPSocket::read(UDPDatagram *datagrams, int count)
+	{
+		int received = 0;
+		while (received < count)
+		{
+			sockaddr_in addr;
+			socklen_t addr_len = sizeof(sockaddr_in);
+
+			UDPDatagram &datagram = datagrams[received];
+			int result = recvfrom(impl->handle, static_cast<char*>(datagram.data), datagram.size, 0, (sockaddr *)&addr, &addr_len);
+			if (result == -1)
+			{
+				if (errno == EWOULDBLOCK || errno == EAGAIN)
+					break;
+				else if (errno == EINTR || errno == EMSGSIZE || errno == ECONNREFUSED || errno == ECONNRESET || errno == ENETRESET)
+					continue;
+				else
+					throw Exception("Error reading from udp socket");
+			}
+
+			datagram.size = result;
+			datagram.address = addr.sin_addr.s_addr;
+			datagram.port = addr.sin_port;
+			received++;
+		}
+		return received;
+	}
+
+#endif
+
 #endif
+
+	void UDPDatagram::set_endpoint(const SocketName &endpoint)
+	{
+		sockaddr_in addr;
+		endpoint.to_sockaddr(AF_INET, (sockaddr *)&addr, sizeof(sockaddr_in));
+		address = addr.sin_addr.s_addr;
+		port = addr.sin_port;
+	}
+
+	SocketName UDPDatagram::get_endpoint() const
+	{
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(sockaddr_in));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = address;
+		addr.sin_port = port;
+
+		SocketName endpoint;
+		endpoint.from_sockaddr(AF_INET, (sockaddr *)&addr, sizeof(sockaddr_in));
+		return endpoint;
+	}
 }
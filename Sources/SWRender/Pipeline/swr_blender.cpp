@@ -0,0 +1,156 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_blender.h"
+
+namespace clan
+{
+	SWRBlendSettings SWRBlender::get_settings(const BlendStateDescription &desc)
+	{
+		SWRBlendSettings settings;
+		desc.get_blend_function(settings.src, settings.dest, settings.src_alpha, settings.dest_alpha);
+		desc.get_blend_equation(settings.equation_color, settings.equation_alpha);
+
+		bool red, green, blue, alpha;
+		desc.get_color_write(red, green, blue, alpha);
+		settings.write_mask = (red ? 0x000000ff : 0) | (green ? 0x0000ff00 : 0) | (blue ? 0x00ff0000 : 0) | (alpha ? 0xff000000 : 0);
+
+		bool add = settings.equation_color == BlendEquation::add && settings.equation_alpha == BlendEquation::add;
+		bool over_alpha = settings.src_alpha == BlendFunc::one && settings.dest_alpha == BlendFunc::one_minus_src_alpha;
+
+		if (!desc.is_blending_enabled())
+			settings.mode = SWRBlendMode::replace;
+		else if (add && over_alpha && settings.src == BlendFunc::one && settings.dest == BlendFunc::one_minus_src_alpha)
+			settings.mode = SWRBlendMode::premultiplied_over;
+		else if (add && over_alpha && settings.src == BlendFunc::src_alpha && settings.dest == BlendFunc::one_minus_src_alpha)
+			settings.mode = SWRBlendMode::over;
+		else
+			settings.mode = SWRBlendMode::generic;
+
+		return settings;
+	}
+
+	void SWRBlender::blend(const SWRBlendSettings &settings, const Vec4f &constant_color, const SWRFloat4 *src, uint32_t *dest, int count)
+	{
+		uint32_t write_mask = settings.write_mask;
+		uint32_t keep_mask = ~write_mask;
+		if (write_mask == 0)
+			return;
+
+		switch (settings.mode)
+		{
+		case SWRBlendMode::replace:
+			for (int i = 0; i < count; i++)
+				dest[i] = (src[i].to_rgba8() & write_mask) | (dest[i] & keep_mask);
+			break;
+
+		case SWRBlendMode::premultiplied_over:
+			for (int i = 0; i < count; i++)
+			{
+				SWRFloat4 s = SWRFloat4::clamp(src[i]);
+				SWRFloat4 d = SWRFloat4::from_rgba8(dest[i]);
+				SWRFloat4 result = s + d * (SWRFloat4(1.0f) - s.wwww());
+				dest[i] = (result.to_rgba8() & write_mask) | (dest[i] & keep_mask);
+			}
+			break;
+
+		case SWRBlendMode::over:
+		{
+			SWRFloat4 alpha_lane = SWRFloat4::mask(false, false, false, true);
+			for (int i = 0; i < count; i++)
+			{
+				SWRFloat4 s = SWRFloat4::clamp(src[i]);
+				SWRFloat4 d = SWRFloat4::from_rgba8(dest[i]);
+				SWRFloat4 a = s.wwww();
+				SWRFloat4 result = s * SWRFloat4::select(alpha_lane, SWRFloat4(1.0f), a) + d * (SWRFloat4(1.0f) - a);
+				dest[i] = (result.to_rgba8() & write_mask) | (dest[i] & keep_mask);
+			}
+			break;
+		}
+
+		case SWRBlendMode::generic:
+		{
+			SWRFloat4 alpha_lane = SWRFloat4::mask(false, false, false, true);
+			SWRFloat4 constant = SWRFloat4::clamp(SWRFloat4(constant_color));
+			for (int i = 0; i < count; i++)
+			{
+				SWRFloat4 s = SWRFloat4::clamp(src[i]);
+				SWRFloat4 d = SWRFloat4::from_rgba8(dest[i]);
+
+				SWRFloat4 src_factor = SWRFloat4::select(alpha_lane, factor(settings.src_alpha, s, d, constant, true), factor(settings.src, s, d, constant, false));
+				SWRFloat4 dest_factor = SWRFloat4::select(alpha_lane, factor(settings.dest_alpha, s, d, constant, true), factor(settings.dest, s, d, constant, false));
+
+				SWRFloat4 result = equation(settings.equation_color, s, src_factor, d, dest_factor);
+				if (settings.equation_alpha != settings.equation_color)
+					result = SWRFloat4::select(alpha_lane, equation(settings.equation_alpha, s, src_factor, d, dest_factor), result);
+
+				dest[i] = (result.to_rgba8() & write_mask) | (dest[i] & keep_mask);
+			}
+			break;
+		}
+		}
+	}
+
+	SWRFloat4 SWRBlender::factor(BlendFunc func, const SWRFloat4 &src, const SWRFloat4 &dest, const SWRFloat4 &constant, bool alpha)
+	{
+		SWRFloat4 one(1.0f);
+		switch (func)
+		{
+		default:
+		case BlendFunc::zero: return SWRFloat4(0.0f);
+		case BlendFunc::one: return one;
+		case BlendFunc::dest_color: return dest;
+		case BlendFunc::src_color: return src;
+		case BlendFunc::one_minus_dest_color: return one - dest;
+		case BlendFunc::one_minus_src_color: return one - src;
+		case BlendFunc::src_alpha: return src.wwww();
+		case BlendFunc::one_minus_src_alpha: return one - src.wwww();
+		case BlendFunc::dest_alpha: return dest.wwww();
+		case BlendFunc::one_minus_dest_alpha: return one - dest.wwww();
+		case BlendFunc::src_alpha_saturate: return alpha ? one : SWRFloat4::min(src.wwww(), one - dest.wwww());
+		case BlendFunc::constant_color: return constant;
+		case BlendFunc::one_minus_constant_color: return one - constant;
+		case BlendFunc::constant_alpha: return constant.wwww();
+		case BlendFunc::one_minus_constant_alpha: return one - constant.wwww();
+		}
+	}
+
+	SWRFloat4 SWRBlender::equation(BlendEquation equation, const SWRFloat4 &src, const SWRFloat4 &src_factor, const SWRFloat4 &dest, const SWRFloat4 &dest_factor)
+	{
+		switch (equation)
+		{
+		default:
+		case BlendEquation::add: return src * src_factor + dest * dest_factor;
+		case BlendEquation::subtract: return src * src_factor - dest * dest_factor;
+		case BlendEquation::reverse_subtract: return dest * dest_factor - src * src_factor;
+		case BlendEquation::min: return SWRFloat4::min(src, dest);
+		case BlendEquation::max: return SWRFloat4::max(src, dest);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_float4.h"
+#include "API/Display/Render/graphic_context.h"
+#include "API/Display/Render/blend_state_description.h"
+
+namespace clan
+{
+	enum class SWRBlendMode
+	{
+		replace,
+		premultiplied_over,
+		over,
+		generic
+	};
+
+	/// \brief Blend state as used by the pixel pipeline
+	struct SWRBlendSettings
+	{
+		SWRBlendMode mode = SWRBlendMode::replace;
+		BlendFunc src = BlendFunc::one;
+		BlendFunc dest = BlendFunc::zero;
+		BlendFunc src_alpha = BlendFunc::one;
+		BlendFunc dest_alpha = BlendFunc::zero;
+		BlendEquation equation_color = BlendEquation::add;
+		BlendEquation equation_alpha = BlendEquation::add;
+		uint32_t write_mask = 0xffffffff;
+	};
+
+	/// \brief Writes shaded spans of pixels into a rgba8 render target
+	class SWRBlender
+	{
+	public:
+		static SWRBlendSettings get_settings(const BlendStateDescription &desc);
+
+		static void blend(const SWRBlendSettings &settings, const Vec4f &constant_color, const SWRFloat4 *src, uint32_t *dest, int count);
+
+	private:
+		static SWRFloat4 factor(BlendFunc func, const SWRFloat4 &src, const SWRFloat4 &dest, const SWRFloat4 &constant, bool alpha);
+		static SWRFloat4 equation(BlendEquation equation, const SWRFloat4 &src, const SWRFloat4 &src_factor, const SWRFloat4 &dest, const SWRFloat4 &dest_factor);
+	};
+}
@@ -0,0 +1,103 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_sampler.h"
+#include "swr_blender.h"
+#include "API/Core/Math/rect.h"
+#include "API/Core/Math/vec2.h"
+#include <cstdint>
+
+namespace clan
+{
+	/// \brief Standard programs the pipeline can execute
+	enum class SWRProgramType
+	{
+		color_only,
+		single_texture,
+		sprite,
+		path
+	};
+
+	/// \brief Program, texture and blend state captured for a draw call
+	struct SWRDrawState
+	{
+		static const int max_samplers = 16;
+
+		SWRProgramType program = SWRProgramType::color_only;
+		float ypos_scale = 1.0f;
+		SWRBlendSettings blend;
+		Vec4f blend_color;
+		SWRSampler samplers[max_samplers];
+	};
+
+	/// \brief Flat (non-interpolated) outputs of the vertex stage
+	struct SWRFlatData
+	{
+		int texindex = 0;
+		Vec4f brush_data1;
+		Vec4f brush_data2;
+		Vec2i instance_offset;
+	};
+
+	/// \brief Output of the vertex stage
+	struct SWRVertex
+	{
+		Vec4f position;
+		Vec4f varying[2];
+		SWRFlatData flat;
+	};
+
+	/// \brief Triangle ready for rasterization
+	///
+	/// The edge functions are evaluated in 24.8 fixed point and are non-negative for covered pixel centers.
+	/// The varyings are planes relative to the center of the top left pixel of the bounding box.
+	/// For perspective correct interpolation the varyings are divided by w and varying[1].w holds 1/w.
+	struct SWRTriangle
+	{
+		int state;
+		Rect box;
+		int64_t edge_a[3];
+		int64_t edge_b[3];
+		int64_t edge_c[3];
+		bool perspective;
+		Vec4f varying[2];
+		Vec4f varying_dx[2];
+		Vec4f varying_dy[2];
+		SWRFlatData flat;
+	};
+
+	/// \brief Fill of a rectangle in the render target
+	struct SWRClear
+	{
+		Rect box;
+		uint32_t color;
+		uint32_t write_mask;
+	};
+}
@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/Math/vec4.h"
+#include <cstdint>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Four float lanes, used for colors and varyings in the pixel pipeline
+	class SWRFloat4
+	{
+	public:
+#ifndef CL_DISABLE_SSE2
+		SWRFloat4() { }
+		SWRFloat4(__m128 v) : v(v) { }
+		SWRFloat4(float s) : v(_mm_set1_ps(s)) { }
+		SWRFloat4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w)) { }
+		explicit SWRFloat4(const Vec4f &value) : v(_mm_loadu_ps(&value.x)) { }
+
+		Vec4f to_vec4f() const { Vec4f result; _mm_storeu_ps(&result.x, v); return result; }
+
+		float x() const { return _mm_cvtss_f32(v); }
+		float y() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))); }
+		float z() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))); }
+		float w() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+		SWRFloat4 xxxx() const { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+		SWRFloat4 wwww() const { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+
+		SWRFloat4 operator+(const SWRFloat4 &b) const { return _mm_add_ps(v, b.v); }
+		SWRFloat4 operator-(const SWRFloat4 &b) const { return _mm_sub_ps(v, b.v); }
+		SWRFloat4 operator*(const SWRFloat4 &b) const { return _mm_mul_ps(v, b.v); }
+		SWRFloat4 operator/(const SWRFloat4 &b) const { return _mm_div_ps(v, b.v); }
+
+		static SWRFloat4 min(const SWRFloat4 &a, const SWRFloat4 &b) { return _mm_min_ps(a.v, b.v); }
+		static SWRFloat4 max(const SWRFloat4 &a, const SWRFloat4 &b) { return _mm_max_ps(a.v, b.v); }
+		static SWRFloat4 clamp(const SWRFloat4 &a) { return _mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+
+		/// \brief Returns lanes of a where the mask lane is set, otherwise lanes of b
+		static SWRFloat4 select(const SWRFloat4 &mask, const SWRFloat4 &a, const SWRFloat4 &b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+		static SWRFloat4 mask(bool x, bool y, bool z, bool w) { return _mm_castsi128_ps(_mm_setr_epi32(x ? -1 : 0, y ? -1 : 0, z ? -1 : 0, w ? -1 : 0)); }
+
+		static SWRFloat4 from_rgba8(uint32_t color)
+		{
+			__m128i zero = _mm_setzero_si128();
+			__m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(color), zero), zero);
+			return _mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(1.0f / 255.0f));
+		}
+
+		uint32_t to_rgba8() const
+		{
+			__m128i c = _mm_cvtps_epi32(_mm_mul_ps(clamp(*this).v, _mm_set1_ps(255.0f)));
+			c = _mm_packs_epi32(c, c);
+			c = _mm_packus_epi16(c, c);
+			return _mm_cvtsi128_si32(c);
+		}
+
+		__m128 v;
+#else
+		SWRFloat4() { }
+		SWRFloat4(float s) { v[0] = s; v[1] = s; v[2] = s; v[3] = s; }
+		SWRFloat4(float x, float y, float z, float w) { v[0] = x; v[1] = y; v[2] = z; v[3] = w; }
+		explicit SWRFloat4(const Vec4f &value) { v[0] = value.x; v[1] = value.y; v[2] = value.z; v[3] = value.w; }
+
+		Vec4f to_vec4f() const { return Vec4f(v[0], v[1], v[2], v[3]); }
+
+		float x() const { return v[0]; }
+		float y() const { return v[1]; }
+		float z() const { return v[2]; }
+		float w() const { return v[3]; }
+		SWRFloat4 xxxx() const { return SWRFloat4(v[0]); }
+		SWRFloat4 wwww() const { return SWRFloat4(v[3]); }
+
+		SWRFloat4 operator+(const SWRFloat4 &b) const { return SWRFloat4(v[0] + b.v[0], v[1] + b.v[1], v[2] + b.v[2], v[3] + b.v[3]); }
+		SWRFloat4 operator-(const SWRFloat4 &b) const { return SWRFloat4(v[0] - b.v[0], v[1] - b.v[1], v[2] - b.v[2], v[3] - b.v[3]); }
+		SWRFloat4 operator*(const SWRFloat4 &b) const { return SWRFloat4(v[0] * b.v[0], v[1] * b.v[1], v[2] * b.v[2], v[3] * b.v[3]); }
+		SWRFloat4 operator/(const SWRFloat4 &b) const { return SWRFloat4(v[0] / b.v[0], v[1] / b.v[1], v[2] / b.v[2], v[3] / b.v[3]); }
+
+		static SWRFloat4 min(const SWRFloat4 &a, const SWRFloat4 &b) { return SWRFloat4(min1(a.v[0], b.v[0]), min1(a.v[1], b.v[1]), min1(a.v[2], b.v[2]), min1(a.v[3], b.v[3])); }
+		static SWRFloat4 max(const SWRFloat4 &a, const SWRFloat4 &b) { return SWRFloat4(max1(a.v[0], b.v[0]), max1(a.v[1], b.v[1]), max1(a.v[2], b.v[2]), max1(a.v[3], b.v[3])); }
+		static SWRFloat4 clamp(const SWRFloat4 &a) { return min(max(a, SWRFloat4(0.0f)), SWRFloat4(1.0f)); }
+
+		/// \brief Returns lanes of a where the mask lane is set, otherwise lanes of b
+		static SWRFloat4 select(const SWRFloat4 &mask, const SWRFloat4 &a, const SWRFloat4 &b) { return SWRFloat4(mask.v[0] != 0.0f ? a.v[0] : b.v[0], mask.v[1] != 0.0f ? a.v[1] : b.v[1], mask.v[2] != 0.0f ? a.v[2] : b.v[2], mask.v[3] != 0.0f ? a.v[3] : b.v[3]); }
+		static SWRFloat4 mask(bool x, bool y, bool z, bool w) { return SWRFloat4(x ? 1.0f : 0.0f, y ? 1.0f : 0.0f, z ? 1.0f : 0.0f, w ? 1.0f : 0.0f); }
+
+		static SWRFloat4 from_rgba8(uint32_t color)
+		{
+			return SWRFloat4((color & 0xff) / 255.0f, ((color >> 8) & 0xff) / 255.0f, ((color >> 16) & 0xff) / 255.0f, (color >> 24) / 255.0f);
+		}
+
+		uint32_t to_rgba8() const
+		{
+			SWRFloat4 c = clamp(*this) * SWRFloat4(255.0f);
+			return to_byte(c.v[0]) | (to_byte(c.v[1]) << 8) | (to_byte(c.v[2]) << 16) | (to_byte(c.v[3]) << 24);
+		}
+
+		float v[4];
+
+	private:
+		// Same NaN behavior as minps/maxps: the second operand is returned when unordered
+		static float min1(float a, float b) { return a < b ? a : b; }
+		static float max1(float a, float b) { return a > b ? a : b; }
+		static uint32_t to_byte(float c) { return (uint32_t)(c + 0.5f); }
+#endif
+	};
+}
@@ -0,0 +1,299 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_pixel_pipeline.h"
+#include "swr_standard_programs.h"
+#include "SWRender/swr_texture_data.h"
+#include <algorithm>
+
+namespace clan
+{
+	namespace
+	{
+		int64_t floor_div(int64_t n, int64_t d)
+		{
+			return n >= 0 ? n / d : -((-n + d - 1) / d);
+		}
+
+		int64_t ceil_div(int64_t n, int64_t d)
+		{
+			return -floor_div(-n, d);
+		}
+	}
+
+	SWRPixelPipeline::SWRPixelPipeline()
+	{
+	}
+
+	SWRPixelPipeline::~SWRPixelPipeline()
+	{
+		flush();
+	}
+
+	void SWRPixelPipeline::set_target(const std::shared_ptr<SWRTextureData> &new_target)
+	{
+		flush();
+		target = new_target;
+	}
+
+	void SWRPixelPipeline::set_state(const SWRDrawState &state)
+	{
+		states.push_back(state);
+	}
+
+	void SWRPixelPipeline::reference(const std::shared_ptr<SWRTextureData> &texture)
+	{
+		if (texture->pipeline == this)
+			return;
+		if (texture->pipeline)
+			texture->pipeline->flush();
+		texture->pipeline = this;
+		referenced.push_back(texture);
+	}
+
+	void SWRPixelPipeline::add_triangle(const SWRTriangle &triangle)
+	{
+		if (!target || states.empty())
+			return;
+		if (triangles.size() >= max_commands)
+			flush_full_batch();
+		if (target->pipeline != this)
+			reference(target);
+
+		triangles.push_back(triangle);
+		triangles.back().state = (int)states.size() - 1;
+		bin(triangle.box, (uint32_t)triangles.size() - 1, &triangles.back());
+	}
+
+	void SWRPixelPipeline::add_clear(const SWRClear &clear)
+	{
+		if (!target)
+			return;
+		if (clears.size() >= max_commands)
+			flush_full_batch();
+		if (target->pipeline != this)
+			reference(target);
+
+		clears.push_back(clear);
+		bin(clear.box, clear_command | (uint32_t)(clears.size() - 1), nullptr);
+	}
+
+	void SWRPixelPipeline::flush_full_batch()
+	{
+		// Keep the current state and textures for the rest of the draw call
+		std::vector<std::shared_ptr<SWRTextureData>> textures = referenced;
+		bool has_state = !states.empty();
+		SWRDrawState state;
+		if (has_state)
+			state = states.back();
+
+		flush();
+
+		if (has_state)
+			states.push_back(state);
+		for (auto &texture : textures)
+			reference(texture);
+	}
+
+	void SWRPixelPipeline::flush()
+	{
+		if (!active_tiles.empty())
+		{
+			if (active_tiles.size() == 1)
+			{
+				process_tile(active_tiles.front());
+			}
+			else
+			{
+				WorkGroup group(work_queue);
+				group.parallel_for(0, (int)active_tiles.size(), [this](int index) { process_tile(active_tiles[index]); });
+				group.wait();
+			}
+
+			for (int tile : active_tiles)
+				bins[tile].clear();
+			active_tiles.clear();
+		}
+
+		triangles.clear();
+		clears.clear();
+		states.clear();
+
+		for (auto &texture : referenced)
+			texture->pipeline = nullptr;
+		referenced.clear();
+	}
+
+	void SWRPixelPipeline::bin(const Rect &box, uint32_t command, const SWRTriangle *triangle)
+	{
+		int width = target->image.get_width();
+		int height = target->image.get_height();
+
+		// The target size can only change while nothing is queued for it
+		if (active_tiles.empty())
+		{
+			tiles_x = (width + tile_size - 1) / tile_size;
+			tiles_y = (height + tile_size - 1) / tile_size;
+			if (bins.size() != (size_t)(tiles_x * tiles_y))
+				bins.resize(tiles_x * tiles_y);
+		}
+
+		int left = clan::max(box.left, 0);
+		int top = clan::max(box.top, 0);
+		int right = clan::min(box.right, width);
+		int bottom = clan::min(box.bottom, height);
+		if (left >= right || top >= bottom)
+			return;
+
+		int tile_left = left / tile_size;
+		int tile_top = top / tile_size;
+		int tile_right = (right - 1) / tile_size;
+		int tile_bottom = (bottom - 1) / tile_size;
+		bool single_tile = tile_left == tile_right && tile_top == tile_bottom;
+
+		for (int tile_y = tile_top; tile_y <= tile_bottom; tile_y++)
+		{
+			for (int tile_x = tile_left; tile_x <= tile_right; tile_x++)
+			{
+				if (triangle && !single_tile)
+				{
+					Rect tile_box(tile_x * tile_size, tile_y * tile_size, clan::min((tile_x + 1) * tile_size, width), clan::min((tile_y + 1) * tile_size, height));
+					if (is_outside(*triangle, tile_box))
+						continue;
+				}
+
+				int tile = tile_x + tile_y * tiles_x;
+				if (bins[tile].empty())
+					active_tiles.push_back(tile);
+				bins[tile].push_back(command);
+			}
+		}
+	}
+
+	bool SWRPixelPipeline::is_outside(const SWRTriangle &triangle, const Rect &tile_box)
+	{
+		// The tile is outside if an edge function is negative at the pixel center of the tile most inside that edge
+		for (int i = 0; i < 3; i++)
+		{
+			int64_t x = (int64_t)(triangle.edge_a[i] >= 0 ? tile_box.right - 1 : tile_box.left) * 256 + 128;
+			int64_t y = (int64_t)(triangle.edge_b[i] >= 0 ? tile_box.bottom - 1 : tile_box.top) * 256 + 128;
+			if (triangle.edge_a[i] * x + triangle.edge_b[i] * y + triangle.edge_c[i] < 0)
+				return true;
+		}
+		return false;
+	}
+
+	void SWRPixelPipeline::process_tile(int tile)
+	{
+		int tile_x = tile % tiles_x;
+		int tile_y = tile / tiles_x;
+		Rect tile_box(tile_x * tile_size, tile_y * tile_size, clan::min((tile_x + 1) * tile_size, target->image.get_width()), clan::min((tile_y + 1) * tile_size, target->image.get_height()));
+
+		uint32_t *pixels = target->image.get_data_uint32();
+		int pitch = target->image.get_pitch() / 4;
+		SWRFloat4 span[tile_size];
+
+		for (uint32_t command : bins[tile])
+		{
+			if (command & clear_command)
+				draw_clear(clears[command & ~clear_command], tile_box, pixels, pitch);
+			else
+				draw_triangle(triangles[command], tile_box, pixels, pitch, span);
+		}
+	}
+
+	void SWRPixelPipeline::draw_triangle(const SWRTriangle &triangle, const Rect &tile_box, uint32_t *pixels, int pitch, SWRFloat4 *span)
+	{
+		const SWRDrawState &state = states[triangle.state];
+		int left = clan::max(triangle.box.left, tile_box.left);
+		int right = clan::min(triangle.box.right, tile_box.right);
+		int top = clan::max(triangle.box.top, tile_box.top);
+		int bottom = clan::min(triangle.box.bottom, tile_box.bottom);
+
+		for (int y = top; y < bottom; y++)
+		{
+			int x0, x1;
+			if (!get_span(triangle, y, x0, x1))
+				continue;
+			x0 = clan::max(x0, left);
+			x1 = clan::min(x1, right);
+			if (x0 >= x1)
+				continue;
+
+			SWRStandardPrograms::shade_span(state, triangle, x0, x1, y, span);
+			SWRBlender::blend(state.blend, state.blend_color, span, pixels + (size_t)y * pitch + x0, x1 - x0);
+		}
+	}
+
+	bool SWRPixelPipeline::get_span(const SWRTriangle &triangle, int y, int &out_x0, int &out_x1)
+	{
+		// Solve a * x + k >= 0 for each edge, where x is the pixel column
+		int64_t x0 = triangle.box.left;
+		int64_t x1 = triangle.box.right;
+		int64_t center_y = (int64_t)y * 256 + 128;
+		for (int i = 0; i < 3; i++)
+		{
+			int64_t a = triangle.edge_a[i] * 256;
+			int64_t k = triangle.edge_a[i] * 128 + triangle.edge_b[i] * center_y + triangle.edge_c[i];
+			if (a > 0)
+				x0 = std::max(x0, ceil_div(-k, a));
+			else if (a < 0)
+				x1 = std::min(x1, floor_div(k, -a) + 1);
+			else if (k < 0)
+				return false;
+		}
+		out_x0 = (int)x0;
+		out_x1 = (int)x1;
+		return x0 < x1;
+	}
+
+	void SWRPixelPipeline::draw_clear(const SWRClear &clear, const Rect &tile_box, uint32_t *pixels, int pitch)
+	{
+		int left = clan::max(clear.box.left, tile_box.left);
+		int right = clan::min(clear.box.right, tile_box.right);
+		int top = clan::max(clear.box.top, tile_box.top);
+		int bottom = clan::min(clear.box.bottom, tile_box.bottom);
+		uint32_t color = clear.color & clear.write_mask;
+		uint32_t keep_mask = ~clear.write_mask;
+
+		for (int y = top; y < bottom; y++)
+		{
+			uint32_t *line = pixels + (size_t)y * pitch;
+			if (keep_mask == 0)
+			{
+				std::fill(line + left, line + right, color);
+			}
+			else
+			{
+				for (int x = left; x < right; x++)
+					line[x] = color | (line[x] & keep_mask);
+			}
+		}
+	}
+}
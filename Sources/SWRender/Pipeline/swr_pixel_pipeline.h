@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_draw_state.h"
+#include "API/Core/System/work_queue.h"
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	class SWRTextureData;
+
+	/// \brief Tile binning rasterizer writing into a rgba8 render target
+	///
+	/// Triangles and clears are queued into bins of tile_size x tile_size pixels. When the pipeline is
+	/// flushed, the tiles are processed in parallel on a work queue, each tile executing its commands in
+	/// submission order. Textures used by queued commands are kept alive and flagged until the flush.
+	class SWRPixelPipeline
+	{
+	public:
+		SWRPixelPipeline();
+		~SWRPixelPipeline();
+
+		static const int tile_size = 64;
+
+		const std::shared_ptr<SWRTextureData> &get_target() const { return target; }
+
+		/// \brief Sets the render target, flushing commands queued for the previous one
+		void set_target(const std::shared_ptr<SWRTextureData> &target);
+
+		/// \brief Sets the state used by the following triangles
+		void set_state(const SWRDrawState &state);
+
+		/// \brief Keeps the texture alive and flags it as used until the next flush
+		void reference(const std::shared_ptr<SWRTextureData> &texture);
+
+		/// \brief Queues a triangle using the current state
+		void add_triangle(const SWRTriangle &triangle);
+
+		/// \brief Queues a clear of a rectangle within the target
+		void add_clear(const SWRClear &clear);
+
+		/// \brief Executes all queued commands
+		void flush();
+
+	private:
+		void flush_full_batch();
+		void bin(const Rect &box, uint32_t command, const SWRTriangle *triangle);
+		static bool is_outside(const SWRTriangle &triangle, const Rect &tile_box);
+		void process_tile(int tile);
+		void draw_triangle(const SWRTriangle &triangle, const Rect &tile_box, uint32_t *pixels, int pitch, SWRFloat4 *span);
+		void draw_clear(const SWRClear &clear, const Rect &tile_box, uint32_t *pixels, int pitch);
+		static bool get_span(const SWRTriangle &triangle, int y, int &x0, int &x1);
+
+		static const uint32_t clear_command = 0x80000000;
+		static const size_t max_commands = 1 << 16;
+
+		WorkQueue work_queue;
+		std::shared_ptr<SWRTextureData> target;
+		int tiles_x = 0;
+		int tiles_y = 0;
+		std::vector<std::vector<uint32_t>> bins;
+		std::vector<int> active_tiles;
+		std::vector<SWRDrawState> states;
+		std::vector<SWRTriangle> triangles;
+		std::vector<SWRClear> clears;
+		std::vector<std::shared_ptr<SWRTextureData>> referenced;
+	};
+}
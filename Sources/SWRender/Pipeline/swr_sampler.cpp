@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_sampler.h"
+#include "SWRender/swr_texture_data.h"
+#include <cmath>
+
+namespace clan
+{
+	void SWRSampler::set(const SWRTextureData *texture)
+	{
+		if (texture && !texture->image.is_null())
+		{
+			data = texture->image.get_data_uint8();
+			width = texture->image.get_width();
+			height = texture->image.get_height();
+			pitch = texture->image.get_pitch();
+			format = texture->image.get_format();
+			wrap_s = texture->wrap_s;
+			wrap_t = texture->wrap_t;
+			linear = texture->mag_filter != TextureFilter::nearest;
+		}
+		else
+		{
+			data = nullptr;
+			width = 0;
+			height = 0;
+			pitch = 0;
+		}
+	}
+
+	SWRFloat4 SWRSampler::sample(float u, float v) const
+	{
+		if (!data)
+			return SWRFloat4(0.0f, 0.0f, 0.0f, 1.0f);
+
+		// Keep the coordinates in a range where the conversions to int are defined (also catches NaN)
+		const float limit = 16384.0f;
+		u = (u > -limit) ? (u < limit ? u : limit) : -limit;
+		v = (v > -limit) ? (v < limit ? v : limit) : -limit;
+
+		if (linear)
+		{
+			float x = u * width - 0.5f;
+			float y = v * height - 0.5f;
+			float floor_x = std::floor(x);
+			float floor_y = std::floor(y);
+			SWRFloat4 fx(x - floor_x);
+			SWRFloat4 fy(y - floor_y);
+			int x0 = (int)floor_x;
+			int y0 = (int)floor_y;
+			int x1 = wrap(x0 + 1, width, wrap_s);
+			int y1 = wrap(y0 + 1, height, wrap_t);
+			x0 = wrap(x0, width, wrap_s);
+			y0 = wrap(y0, height, wrap_t);
+
+			SWRFloat4 t00 = texel(x0, y0);
+			SWRFloat4 t10 = texel(x1, y0);
+			SWRFloat4 t01 = texel(x0, y1);
+			SWRFloat4 t11 = texel(x1, y1);
+			SWRFloat4 top = t00 + (t10 - t00) * fx;
+			SWRFloat4 bottom = t01 + (t11 - t01) * fx;
+			return top + (bottom - top) * fy;
+		}
+		else
+		{
+			int x = wrap((int)std::floor(u * width), width, wrap_s);
+			int y = wrap((int)std::floor(v * height), height, wrap_t);
+			return texel(x, y);
+		}
+	}
+
+	SWRFloat4 SWRSampler::fetch(int x, int y) const
+	{
+		if (x < 0 || y < 0 || x >= width || y >= height)
+			return SWRFloat4(0.0f);
+		return texel(x, y);
+	}
+
+	SWRFloat4 SWRSampler::texel(int x, int y) const
+	{
+		const unsigned char *line = data + y * pitch;
+		switch (format)
+		{
+		case TextureFormat::r8:
+			return SWRFloat4(line[x] * (1.0f / 255.0f), 0.0f, 0.0f, 1.0f);
+		case TextureFormat::rgba32f:
+			return SWRFloat4(reinterpret_cast<const Vec4f *>(line)[x]);
+		default:
+			return SWRFloat4::from_rgba8(reinterpret_cast<const uint32_t *>(line)[x]);
+		}
+	}
+
+	int SWRSampler::wrap(int x, int size, TextureWrapMode mode)
+	{
+		switch (mode)
+		{
+		default:
+		case TextureWrapMode::clamp_to_edge:
+			return x < 0 ? 0 : (x >= size ? size - 1 : x);
+		case TextureWrapMode::repeat:
+			x %= size;
+			return x < 0 ? x + size : x;
+		case TextureWrapMode::mirrored_repeat:
+			x %= size * 2;
+			if (x < 0)
+				x += size * 2;
+			return x < size ? x : size * 2 - 1 - x;
+		}
+	}
+}
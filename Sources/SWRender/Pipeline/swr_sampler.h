@@ -0,0 +1,67 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_float4.h"
+#include "API/Display/Render/texture.h"
+#include "API/Display/Image/texture_format.h"
+
+namespace clan
+{
+	class SWRTextureData;
+
+	/// \brief Samples the level 0 image of a texture bound to a texture unit
+	class SWRSampler
+	{
+	public:
+		/// \brief Binds the texture, or unbinds the unit if texture is null
+		void set(const SWRTextureData *texture);
+
+		bool is_bound() const { return data != nullptr; }
+
+		/// \brief Filtered lookup at normalized coordinates (GLSL texture)
+		SWRFloat4 sample(float u, float v) const;
+
+		/// \brief Unfiltered lookup at integer texel coordinates (GLSL texelFetch)
+		SWRFloat4 fetch(int x, int y) const;
+
+	private:
+		SWRFloat4 texel(int x, int y) const;
+		static int wrap(int x, int size, TextureWrapMode mode);
+
+		const unsigned char *data = nullptr;
+		int width = 0;
+		int height = 0;
+		int pitch = 0;
+		TextureFormat format = TextureFormat::rgba8;
+		TextureWrapMode wrap_s = TextureWrapMode::clamp_to_edge;
+		TextureWrapMode wrap_t = TextureWrapMode::clamp_to_edge;
+		bool linear = false;
+	};
+}
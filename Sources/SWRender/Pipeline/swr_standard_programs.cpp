@@ -0,0 +1,228 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_standard_programs.h"
+#include <cmath>
+
+namespace clan
+{
+	struct SWRStandardPrograms::ColorOnly
+	{
+		static SWRFloat4 shade(const SWRDrawState &state, const SWRFlatData &flat, const SWRFloat4 &color, const SWRFloat4 &texcoord)
+		{
+			return color;
+		}
+	};
+
+	struct SWRStandardPrograms::SingleTexture
+	{
+		static SWRFloat4 shade(const SWRDrawState &state, const SWRFlatData &flat, const SWRFloat4 &color, const SWRFloat4 &texcoord)
+		{
+			return color * state.samplers[0].sample(texcoord.x(), texcoord.y());
+		}
+	};
+
+	struct SWRStandardPrograms::Sprite
+	{
+		static SWRFloat4 shade(const SWRDrawState &state, const SWRFlatData &flat, const SWRFloat4 &color, const SWRFloat4 &texcoord)
+		{
+			if (flat.texindex >= 0 && flat.texindex < SWRDrawState::max_samplers)
+				return color * state.samplers[flat.texindex].sample(texcoord.x(), texcoord.y());
+			else
+				return color;
+		}
+	};
+
+	struct SWRStandardPrograms::Path
+	{
+		static SWRFloat4 shade(const SWRDrawState &state, const SWRFlatData &flat, const SWRFloat4 &vary_data, const SWRFloat4 &mask_position)
+		{
+			SWRFloat4 color;
+			switch ((int)flat.brush_data1.x)
+			{
+			default:
+			case 0: // Solid fill
+				color = SWRFloat4(flat.brush_data2);
+				break;
+			case 1: // Linear gradient
+			{
+				float t = (vary_data.x() * flat.brush_data1.z + vary_data.y() * flat.brush_data1.w) * flat.brush_data2.x;
+				color = gradient_color(state, flat, (int)flat.brush_data2.y, (int)flat.brush_data2.z, t);
+				break;
+			}
+			case 2: // Radial gradient
+			{
+				float x = vary_data.x();
+				float y = vary_data.y();
+				float t = std::sqrt(x * x + y * y) * flat.brush_data2.x;
+				color = gradient_color(state, flat, (int)flat.brush_data2.y, (int)flat.brush_data2.z, t);
+				break;
+			}
+			case 3: // Image
+				color = state.samplers[2].sample(vary_data.z(), vary_data.w());
+				break;
+			}
+			return color * state.samplers[0].sample(mask_position.x(), mask_position.y()).xxxx();
+		}
+
+		static SWRFloat4 gradient_color(const SWRDrawState &state, const SWRFlatData &flat, int stop_start, int stop_end, float t)
+		{
+			const SWRSampler &instance_data = state.samplers[1];
+			int x = flat.instance_offset.x;
+			int y = flat.instance_offset.y;
+
+			SWRFloat4 color = instance_data.fetch(x + stop_start, y);
+			float last_stop_pos = instance_data.fetch(x + stop_start + 1, y).x();
+			for (int i = stop_start; i < stop_end; i += 2)
+			{
+				SWRFloat4 stop_color = instance_data.fetch(x + i, y);
+				float stop_pos = instance_data.fetch(x + i + 1, y).x();
+				float tt = (t - last_stop_pos) / (stop_pos - last_stop_pos);
+				tt = tt > 0.0f ? (tt < 1.0f ? tt : 1.0f) : 0.0f; // NaN becomes 0
+				color = color + (stop_color - color) * SWRFloat4(tt);
+				last_stop_pos = stop_pos;
+			}
+			return color;
+		}
+	};
+
+	void SWRStandardPrograms::run_vertex(const SWRDrawState &state, const SWRVertexAttribute *attributes, int vertex, SWRVertex &out)
+	{
+		switch (state.program)
+		{
+		case SWRProgramType::color_only:
+			out.position = attributes[0].load_float(vertex);
+			out.varying[0] = attributes[1].load_float(vertex);
+			out.varying[1] = Vec4f(0.0f);
+			break;
+
+		case SWRProgramType::single_texture:
+			out.position = attributes[0].load_float(vertex);
+			out.varying[0] = attributes[1].load_float(vertex);
+			out.varying[1] = attributes[2].load_float(vertex);
+			break;
+
+		case SWRProgramType::sprite:
+			out.position = attributes[0].load_float(vertex);
+			out.varying[0] = attributes[1].load_float(vertex);
+			out.varying[1] = attributes[2].load_float(vertex);
+			out.flat.texindex = attributes[3].load_int(vertex).x;
+			break;
+
+		case SWRProgramType::path:
+		{
+			const int mask_block_size = 16;
+			const int mask_width = 1024;
+			const int instance_width = 512;
+			const SWRSampler &instance_data = state.samplers[1];
+
+			Vec4i input = attributes[0].load_int(vertex);
+
+			SWRFloat4 canvas_data = instance_data.fetch(0, 0);
+			Vec2i size(input.z % 2, input.z / 2);
+			float xpos = (float)(input.x + size.x * mask_block_size);
+			float ypos = (float)(input.y + size.y * mask_block_size);
+			out.position = Vec4f(xpos * 2.0f / canvas_data.x() - 1.0f, state.ypos_scale * (ypos * -2.0f / canvas_data.y() + 1.0f), 0.0f, 1.0f);
+
+			int mask_offset = input.w % 65536;
+			int y_offset = (mask_offset * mask_block_size) / mask_width;
+			out.varying[1] = Vec4f(
+				(float)(mask_offset * mask_block_size - y_offset * mask_width + size.x * mask_block_size) / mask_width,
+				(float)(y_offset * mask_block_size + size.y * mask_block_size) / mask_width,
+				0.0f, 0.0f);
+
+			int instance_block = input.w / 65536;
+			y_offset = instance_block / instance_width;
+			Vec2i instance_offset(instance_block - y_offset * instance_width, y_offset);
+			out.flat.instance_offset = instance_offset;
+
+			Vec4f brush_data1 = instance_data.fetch(instance_offset.x, instance_offset.y).to_vec4f();
+			Vec4f brush_data2 = instance_data.fetch(instance_offset.x + 1, instance_offset.y).to_vec4f();
+			Vec4f column0 = instance_data.fetch(instance_offset.x + 2, instance_offset.y).to_vec4f();
+			Vec4f column1 = instance_data.fetch(instance_offset.x + 3, instance_offset.y).to_vec4f();
+			Vec4f column3 = instance_data.fetch(instance_offset.x + 5, instance_offset.y).to_vec4f();
+			out.flat.brush_data1 = brush_data1;
+			out.flat.brush_data2 = brush_data2;
+
+			// Linear and radial gradients use the position relative to brush_data3, images the inverse transform
+			Vec4f &vary_data = out.varying[0];
+			vary_data.x = xpos - column0.x;
+			vary_data.y = ypos - column0.y;
+			vary_data.z = column0.x * xpos + column1.x * ypos + column3.x;
+			vary_data.w = column0.y * xpos + column1.y * ypos + column3.y;
+			vary_data.z = (vary_data.z + brush_data1.x) / brush_data2.x;
+			vary_data.w = (vary_data.w + brush_data1.y) / brush_data2.y;
+			break;
+		}
+		}
+	}
+
+	void SWRStandardPrograms::shade_span(const SWRDrawState &state, const SWRTriangle &triangle, int x0, int x1, int y, SWRFloat4 *out)
+	{
+		switch (state.program)
+		{
+		case SWRProgramType::color_only: shade_span<ColorOnly>(state, triangle, x0, x1, y, out); break;
+		case SWRProgramType::single_texture: shade_span<SingleTexture>(state, triangle, x0, x1, y, out); break;
+		case SWRProgramType::sprite: shade_span<Sprite>(state, triangle, x0, x1, y, out); break;
+		case SWRProgramType::path: shade_span<Path>(state, triangle, x0, x1, y, out); break;
+		}
+	}
+
+	template<typename Program>
+	void SWRStandardPrograms::shade_span(const SWRDrawState &state, const SWRTriangle &triangle, int x0, int x1, int y, SWRFloat4 *out)
+	{
+		// Varyings are evaluated from the plane equations for each pixel, so the result does not depend on the tile size
+		SWRFloat4 row_y((float)(y - triangle.box.top));
+		SWRFloat4 row0 = SWRFloat4(triangle.varying[0]) + SWRFloat4(triangle.varying_dy[0]) * row_y;
+		SWRFloat4 row1 = SWRFloat4(triangle.varying[1]) + SWRFloat4(triangle.varying_dy[1]) * row_y;
+		SWRFloat4 dx0(triangle.varying_dx[0]);
+		SWRFloat4 dx1(triangle.varying_dx[1]);
+		const SWRFlatData &flat = triangle.flat;
+
+		if (triangle.perspective)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				SWRFloat4 column((float)(x - triangle.box.left));
+				SWRFloat4 varying0 = row0 + dx0 * column;
+				SWRFloat4 varying1 = row1 + dx1 * column;
+				SWRFloat4 w(1.0f / varying1.w());
+				out[x - x0] = Program::shade(state, flat, varying0 * w, varying1 * w);
+			}
+		}
+		else
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				SWRFloat4 column((float)(x - triangle.box.left));
+				out[x - x0] = Program::shade(state, flat, row0 + dx0 * column, row1 + dx1 * column);
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_draw_state.h"
+#include "swr_vertex_attribute.h"
+
+namespace clan
+{
+	/// \brief CPU implementations of the standard programs (color_only, single_texture, sprite and path)
+	///
+	/// The programs mirror the GLSL versions used by clanGL, including attribute locations and texture units.
+	class SWRStandardPrograms
+	{
+	public:
+		/// \brief Runs the vertex stage for one vertex
+		static void run_vertex(const SWRDrawState &state, const SWRVertexAttribute *attributes, int vertex, SWRVertex &out);
+
+		/// \brief Runs the fragment stage for the pixels x0 to x1 (exclusive) of row y
+		static void shade_span(const SWRDrawState &state, const SWRTriangle &triangle, int x0, int x1, int y, SWRFloat4 *out);
+
+	private:
+		template<typename Program>
+		static void shade_span(const SWRDrawState &state, const SWRTriangle &triangle, int x0, int x1, int y, SWRFloat4 *out);
+
+		struct ColorOnly;
+		struct SingleTexture;
+		struct Sprite;
+		struct Path;
+	};
+}
@@ -0,0 +1,391 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_triangle_setup.h"
+#include "swr_pixel_pipeline.h"
+#include <cmath>
+
+namespace clan
+{
+	namespace
+	{
+		// Vertices are snapped to 1/256 pixel and kept within this distance of the origin
+		const float guard_band = 1 << 20;
+
+		int64_t floor_div(int64_t n, int64_t d)
+		{
+			return n >= 0 ? n / d : -((-n + d - 1) / d);
+		}
+
+		int64_t ceil_div(int64_t n, int64_t d)
+		{
+			return -floor_div(-n, d);
+		}
+
+		int64_t to_fixed(float v)
+		{
+			return (int64_t)std::floor((double)v * 256.0 + 0.5);
+		}
+	}
+
+	SWRTriangleSetup::SWRTriangleSetup(SWRPixelPipeline *pipeline, const Rectf &viewport, const Rect &clip_box)
+		: pipeline(pipeline), viewport(viewport), clip_box(clip_box)
+	{
+	}
+
+	void SWRTriangleSetup::set_cull(bool new_cull_front, bool new_cull_back, bool new_front_counter_clockwise)
+	{
+		cull_front = new_cull_front;
+		cull_back = new_cull_back;
+		front_counter_clockwise = new_front_counter_clockwise;
+	}
+
+	void SWRTriangleSetup::draw_triangle(const SWRVertex &v0, const SWRVertex &v1, const SWRVertex &v2)
+	{
+		ClipVertex clipped[max_clip_vertices] = { to_clip_vertex(v0), to_clip_vertex(v1), to_clip_vertex(v2) };
+		int count = clip_polygon(clipped, 3);
+		if (count < 3)
+			return;
+
+		bool perspective = false;
+		for (int i = 1; i < count; i++)
+			perspective = perspective || clipped[i].position.w != clipped[0].position.w;
+
+		ScreenVertex screen[max_clip_vertices];
+		for (int i = 0; i < count; i++)
+			screen[i] = project(clipped[i], perspective);
+
+		draw_polygon(screen, count, perspective, v2.flat, true);
+	}
+
+	void SWRTriangleSetup::draw_line(const SWRVertex &v0, const SWRVertex &v1)
+	{
+		ClipVertex a = to_clip_vertex(v0);
+		ClipVertex b = to_clip_vertex(v1);
+
+		float t0 = 0.0f;
+		float t1 = 1.0f;
+		for (int plane = 0; plane < 3; plane++)
+		{
+			float d0 = plane_distance(a, plane);
+			float d1 = plane_distance(b, plane);
+			if (d0 < 0.0f && d1 < 0.0f)
+				return;
+			if (d0 < 0.0f)
+				t0 = clan::max(t0, d0 / (d0 - d1));
+			else if (d1 < 0.0f)
+				t1 = clan::min(t1, d0 / (d0 - d1));
+		}
+		if (t0 >= t1)
+			return;
+
+		ClipVertex start = lerp(a, b, t0);
+		ClipVertex end = lerp(a, b, t1);
+		bool perspective = start.position.w != end.position.w;
+		ScreenVertex s0 = project(start, perspective);
+		ScreenVertex s1 = project(end, perspective);
+
+		float dx = s1.x - s0.x;
+		float dy = s1.y - s0.y;
+		if (dx == 0.0f && dy == 0.0f)
+			return;
+
+		// Aliased lines cover one pixel across their major axis
+		float offset_x = std::abs(dx) >= std::abs(dy) ? 0.0f : 0.5f;
+		float offset_y = std::abs(dx) >= std::abs(dy) ? 0.5f : 0.0f;
+
+		ScreenVertex quad[max_clip_vertices] = { s0, s0, s1, s1 };
+		quad[0].x -= offset_x; quad[0].y -= offset_y;
+		quad[1].x += offset_x; quad[1].y += offset_y;
+		quad[2].x += offset_x; quad[2].y += offset_y;
+		quad[3].x -= offset_x; quad[3].y -= offset_y;
+		draw_polygon(quad, 4, perspective, v1.flat, false);
+	}
+
+	void SWRTriangleSetup::draw_point(const SWRVertex &v, float size)
+	{
+		ClipVertex clip = to_clip_vertex(v);
+		for (int plane = 0; plane < 3; plane++)
+		{
+			if (plane_distance(clip, plane) < 0.0f)
+				return;
+		}
+
+		ScreenVertex center = project(clip, false);
+		float half_size = clan::max(size, 1.0f) * 0.5f;
+
+		ScreenVertex quad[max_clip_vertices] = { center, center, center, center };
+		quad[0].x -= half_size; quad[0].y -= half_size;
+		quad[1].x += half_size; quad[1].y -= half_size;
+		quad[2].x += half_size; quad[2].y += half_size;
+		quad[3].x -= half_size; quad[3].y += half_size;
+		draw_polygon(quad, 4, false, v.flat, false);
+	}
+
+	void SWRTriangleSetup::draw_polygon(ScreenVertex *vertices, int count, bool perspective, const SWRFlatData &flat, bool allow_cull)
+	{
+		count = clip_guard_band(vertices, count);
+		for (int i = 0; i < count; i++)
+		{
+			// Also rejects NaN positions
+			if (!(std::abs(vertices[i].x) <= 2.0f * guard_band && std::abs(vertices[i].y) <= 2.0f * guard_band))
+				return;
+		}
+		for (int i = 2; i < count; i++)
+			setup(vertices[0], vertices[i - 1], vertices[i], perspective, flat, allow_cull);
+	}
+
+	void SWRTriangleSetup::setup(const ScreenVertex &sv0, const ScreenVertex &sv1, const ScreenVertex &sv2, bool perspective, const SWRFlatData &flat, bool allow_cull)
+	{
+		const ScreenVertex *v[3] = { &sv0, &sv1, &sv2 };
+		int64_t x[3], y[3];
+		for (int i = 0; i < 3; i++)
+		{
+			x[i] = to_fixed(v[i]->x);
+			y[i] = to_fixed(v[i]->y);
+		}
+
+		int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0)
+			return;
+
+		// The render target is y-down, so a negative area is counter clockwise as seen on screen
+		if (allow_cull && (cull_front || cull_back))
+		{
+			bool counter_clockwise = area < 0;
+			bool front = front_counter_clockwise ? counter_clockwise : !counter_clockwise;
+			if ((front && cull_front) || (!front && cull_back))
+				return;
+		}
+
+		if (area < 0)
+		{
+			std::swap(v[1], v[2]);
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			area = -area;
+		}
+
+		SWRTriangle triangle;
+		triangle.state = 0;
+		triangle.perspective = perspective;
+		triangle.flat = flat;
+
+		// Pixels with centers inside the bounding box of the vertices
+		int64_t min_x = std::min(std::min(x[0], x[1]), x[2]);
+		int64_t max_x = std::max(std::max(x[0], x[1]), x[2]);
+		int64_t min_y = std::min(std::min(y[0], y[1]), y[2]);
+		int64_t max_y = std::max(std::max(y[0], y[1]), y[2]);
+		triangle.box.left = (int)std::max((int64_t)clip_box.left, ceil_div(min_x - 128, 256));
+		triangle.box.right = (int)std::min((int64_t)clip_box.right, floor_div(max_x - 128, 256) + 1);
+		triangle.box.top = (int)std::max((int64_t)clip_box.top, ceil_div(min_y - 128, 256));
+		triangle.box.bottom = (int)std::min((int64_t)clip_box.bottom, floor_div(max_y - 128, 256) + 1);
+		if (triangle.box.left >= triangle.box.right || triangle.box.top >= triangle.box.bottom)
+			return;
+
+		// Edge functions, with the top-left fill rule applied by excluding pixels exactly on other edges
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			int64_t a = y[i] - y[j];
+			int64_t b = x[j] - x[i];
+			int64_t c = -a * x[i] - b * y[i];
+			bool top_left = a > 0 || (a == 0 && b > 0);
+			triangle.edge_a[i] = a;
+			triangle.edge_b[i] = b;
+			triangle.edge_c[i] = top_left ? c : c - 1;
+		}
+
+		// Varying planes, relative to the center of the top left pixel of the box
+		double x0 = x[0] / 256.0;
+		double y0 = y[0] / 256.0;
+		double x1 = x[1] / 256.0 - x0;
+		double y1 = y[1] / 256.0 - y0;
+		double x2 = x[2] / 256.0 - x0;
+		double y2 = y[2] / 256.0 - y0;
+		double rcp_det = 1.0 / (x1 * y2 - x2 * y1);
+		double start_x = triangle.box.left + 0.5 - x0;
+		double start_y = triangle.box.top + 0.5 - y0;
+		for (int k = 0; k < 2; k++)
+		{
+			const float *f0 = &v[0]->varying[k].x;
+			const float *f1 = &v[1]->varying[k].x;
+			const float *f2 = &v[2]->varying[k].x;
+			float *value = &triangle.varying[k].x;
+			float *dx = &triangle.varying_dx[k].x;
+			float *dy = &triangle.varying_dy[k].x;
+			for (int c = 0; c < 4; c++)
+			{
+				double d1 = (double)f1[c] - f0[c];
+				double d2 = (double)f2[c] - f0[c];
+				double dfdx = (d1 * y2 - d2 * y1) * rcp_det;
+				double dfdy = (d2 * x1 - d1 * x2) * rcp_det;
+				value[c] = (float)(f0[c] + dfdx * start_x + dfdy * start_y);
+				dx[c] = (float)dfdx;
+				dy[c] = (float)dfdy;
+			}
+		}
+
+		pipeline->add_triangle(triangle);
+	}
+
+	SWRTriangleSetup::ClipVertex SWRTriangleSetup::to_clip_vertex(const SWRVertex &v)
+	{
+		ClipVertex result;
+		result.position = v.position;
+		result.varying[0] = v.varying[0];
+		result.varying[1] = v.varying[1];
+		return result;
+	}
+
+	SWRTriangleSetup::ClipVertex SWRTriangleSetup::lerp(const ClipVertex &a, const ClipVertex &b, float t)
+	{
+		ClipVertex result;
+		result.position = a.position + (b.position - a.position) * t;
+		result.varying[0] = a.varying[0] + (b.varying[0] - a.varying[0]) * t;
+		result.varying[1] = a.varying[1] + (b.varying[1] - a.varying[1]) * t;
+		return result;
+	}
+
+	SWRTriangleSetup::ScreenVertex SWRTriangleSetup::lerp(const ScreenVertex &a, const ScreenVertex &b, float t)
+	{
+		ScreenVertex result;
+		result.x = a.x + (b.x - a.x) * t;
+		result.y = a.y + (b.y - a.y) * t;
+		result.varying[0] = a.varying[0] + (b.varying[0] - a.varying[0]) * t;
+		result.varying[1] = a.varying[1] + (b.varying[1] - a.varying[1]) * t;
+		return result;
+	}
+
+	float SWRTriangleSetup::plane_distance(const ClipVertex &v, int plane)
+	{
+		const float min_w = 1.0e-5f;
+		switch (plane)
+		{
+		default:
+		case 0: return v.position.w - min_w;
+		case 1: return v.position.z + v.position.w;
+		case 2: return v.position.w - v.position.z;
+		}
+	}
+
+	int SWRTriangleSetup::clip_polygon(ClipVertex *vertices, int count)
+	{
+		for (int plane = 0; plane < 3; plane++)
+		{
+			bool all_inside = true;
+			for (int i = 0; i < count; i++)
+				all_inside = all_inside && plane_distance(vertices[i], plane) >= 0.0f;
+			if (all_inside)
+				continue;
+
+			ClipVertex input[max_clip_vertices];
+			for (int i = 0; i < count; i++)
+				input[i] = vertices[i];
+
+			int output_count = 0;
+			for (int i = 0; i < count; i++)
+			{
+				const ClipVertex &a = input[i];
+				const ClipVertex &b = input[(i + 1) % count];
+				float da = plane_distance(a, plane);
+				float db = plane_distance(b, plane);
+				if (da >= 0.0f)
+					vertices[output_count++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f))
+					vertices[output_count++] = lerp(a, b, da / (da - db));
+			}
+			count = output_count;
+			if (count < 3)
+				return 0;
+		}
+		return count;
+	}
+
+	int SWRTriangleSetup::clip_guard_band(ScreenVertex *vertices, int count)
+	{
+		for (int plane = 0; plane < 4; plane++)
+		{
+			bool all_inside = true;
+			float distance[max_clip_vertices];
+			for (int i = 0; i < count; i++)
+			{
+				switch (plane)
+				{
+				default:
+				case 0: distance[i] = vertices[i].x + guard_band; break;
+				case 1: distance[i] = guard_band - vertices[i].x; break;
+				case 2: distance[i] = vertices[i].y + guard_band; break;
+				case 3: distance[i] = guard_band - vertices[i].y; break;
+				}
+				all_inside = all_inside && distance[i] >= 0.0f;
+			}
+			if (all_inside)
+				continue;
+
+			ScreenVertex input[max_clip_vertices];
+			for (int i = 0; i < count; i++)
+				input[i] = vertices[i];
+
+			int output_count = 0;
+			for (int i = 0; i < count; i++)
+			{
+				int j = (i + 1) % count;
+				if (distance[i] >= 0.0f)
+					vertices[output_count++] = input[i];
+				if ((distance[i] >= 0.0f) != (distance[j] >= 0.0f))
+					vertices[output_count++] = lerp(input[i], input[j], distance[i] / (distance[i] - distance[j]));
+			}
+			count = output_count;
+			if (count < 3)
+				return 0;
+		}
+		return count;
+	}
+
+	SWRTriangleSetup::ScreenVertex SWRTriangleSetup::project(const ClipVertex &v, bool perspective) const
+	{
+		float rcp_w = 1.0f / v.position.w;
+		ScreenVertex result;
+		result.x = viewport.left + (v.position.x * rcp_w + 1.0f) * 0.5f * viewport.get_width();
+		result.y = viewport.top + (1.0f - v.position.y * rcp_w) * 0.5f * viewport.get_height();
+		if (perspective)
+		{
+			result.varying[0] = v.varying[0] * rcp_w;
+			result.varying[1] = v.varying[1] * rcp_w;
+			result.varying[1].w = rcp_w;
+		}
+		else
+		{
+			result.varying[0] = v.varying[0];
+			result.varying[1] = v.varying[1];
+		}
+		return result;
+	}
+}
@@ -0,0 +1,88 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "swr_draw_state.h"
+
+namespace clan
+{
+	class SWRPixelPipeline;
+
+	/// \brief Clips, projects and sets up primitives for rasterization
+	///
+	/// Primitives are clipped against the near and far planes in clip space. Instead of clipping against
+	/// the side planes, pixels are limited to the clip box and vertices are only clipped against a large
+	/// guard band in screen space.
+	class SWRTriangleSetup
+	{
+	public:
+		/// \param viewport Viewport in render target pixels
+		/// \param clip_box Pixels that may be written (intersection of target, viewport and scissor box)
+		SWRTriangleSetup(SWRPixelPipeline *pipeline, const Rectf &viewport, const Rect &clip_box);
+
+		void set_cull(bool cull_front, bool cull_back, bool front_counter_clockwise);
+
+		void draw_triangle(const SWRVertex &v0, const SWRVertex &v1, const SWRVertex &v2);
+		void draw_line(const SWRVertex &v0, const SWRVertex &v1);
+		void draw_point(const SWRVertex &v, float size);
+
+	private:
+		struct ClipVertex
+		{
+			Vec4f position;
+			Vec4f varying[2];
+		};
+
+		struct ScreenVertex
+		{
+			float x, y;
+			Vec4f varying[2];
+		};
+
+		static const int max_clip_vertices = 16;
+
+		static ClipVertex to_clip_vertex(const SWRVertex &v);
+		static ClipVertex lerp(const ClipVertex &a, const ClipVertex &b, float t);
+		static ScreenVertex lerp(const ScreenVertex &a, const ScreenVertex &b, float t);
+		static float plane_distance(const ClipVertex &v, int plane);
+		static int clip_polygon(ClipVertex *vertices, int count);
+		static int clip_guard_band(ScreenVertex *vertices, int count);
+		ScreenVertex project(const ClipVertex &v, bool perspective) const;
+
+		void draw_polygon(ScreenVertex *vertices, int count, bool perspective, const SWRFlatData &flat, bool allow_cull);
+		void setup(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2, bool perspective, const SWRFlatData &flat, bool allow_cull);
+
+		SWRPixelPipeline *pipeline;
+		Rectf viewport;
+		Rect clip_box;
+		bool cull_front = false;
+		bool cull_back = false;
+		bool front_counter_clockwise = true;
+	};
+}
@@ -0,0 +1,138 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_vertex_attribute.h"
+
+namespace clan
+{
+	Vec4f SWRVertexAttribute::load_float(int vertex) const
+	{
+		Vec4f result(0.0f, 0.0f, 0.0f, 1.0f);
+		if (data)
+		{
+			const char *ptr = data + (size_t)vertex * stride;
+			if (type == VertexAttributeDataType::type_float)
+			{
+				const float *values = reinterpret_cast<const float *>(ptr);
+				for (int i = 0; i < size; i++)
+					(&result.x)[i] = values[i];
+			}
+			else
+			{
+				int type_size = get_type_size(type);
+				for (int i = 0; i < size; i++)
+					(&result.x)[i] = load_component(ptr + i * type_size, normalize);
+			}
+		}
+		return result;
+	}
+
+	Vec4i SWRVertexAttribute::load_int(int vertex) const
+	{
+		Vec4i result(0, 0, 0, 1);
+		if (data)
+		{
+			const char *ptr = data + (size_t)vertex * stride;
+			for (int i = 0; i < size; i++)
+			{
+				switch (type)
+				{
+				case VertexAttributeDataType::type_unsigned_byte: (&result.x)[i] = reinterpret_cast<const unsigned char *>(ptr)[i]; break;
+				case VertexAttributeDataType::type_byte: (&result.x)[i] = reinterpret_cast<const signed char *>(ptr)[i]; break;
+				case VertexAttributeDataType::type_unsigned_short: (&result.x)[i] = reinterpret_cast<const unsigned short *>(ptr)[i]; break;
+				case VertexAttributeDataType::type_short: (&result.x)[i] = reinterpret_cast<const short *>(ptr)[i]; break;
+				case VertexAttributeDataType::type_unsigned_int:
+				case VertexAttributeDataType::type_int: (&result.x)[i] = reinterpret_cast<const int *>(ptr)[i]; break;
+				case VertexAttributeDataType::type_float: (&result.x)[i] = (int)reinterpret_cast<const float *>(ptr)[i]; break;
+				}
+			}
+		}
+		return result;
+	}
+
+	bool SWRVertexAttribute::is_in_range(int vertex) const
+	{
+		return !data || (vertex >= 0 && (size_t)vertex * stride + size * get_type_size(type) <= data_size);
+	}
+
+	int SWRVertexAttribute::get_type_size(VertexAttributeDataType type)
+	{
+		switch (type)
+		{
+		case VertexAttributeDataType::type_unsigned_byte:
+		case VertexAttributeDataType::type_byte:
+			return 1;
+		case VertexAttributeDataType::type_unsigned_short:
+		case VertexAttributeDataType::type_short:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	float SWRVertexAttribute::load_component(const char *ptr, bool normalize) const
+	{
+		switch (type)
+		{
+		case VertexAttributeDataType::type_unsigned_byte:
+		{
+			unsigned char value = *reinterpret_cast<const unsigned char *>(ptr);
+			return normalize ? value / 255.0f : (float)value;
+		}
+		case VertexAttributeDataType::type_byte:
+		{
+			signed char value = *reinterpret_cast<const signed char *>(ptr);
+			return normalize ? clan::max(value / 127.0f, -1.0f) : (float)value;
+		}
+		case VertexAttributeDataType::type_unsigned_short:
+		{
+			unsigned short value = *reinterpret_cast<const unsigned short *>(ptr);
+			return normalize ? value / 65535.0f : (float)value;
+		}
+		case VertexAttributeDataType::type_short:
+		{
+			short value = *reinterpret_cast<const short *>(ptr);
+			return normalize ? clan::max(value / 32767.0f, -1.0f) : (float)value;
+		}
+		case VertexAttributeDataType::type_unsigned_int:
+		{
+			unsigned int value = *reinterpret_cast<const unsigned int *>(ptr);
+			return normalize ? (float)(value / 4294967295.0) : (float)value;
+		}
+		case VertexAttributeDataType::type_int:
+		{
+			int value = *reinterpret_cast<const int *>(ptr);
+			return normalize ? (float)clan::max(value / 2147483647.0, -1.0) : (float)value;
+		}
+		default:
+		case VertexAttributeDataType::type_float:
+			return *reinterpret_cast<const float *>(ptr);
+		}
+	}
+}
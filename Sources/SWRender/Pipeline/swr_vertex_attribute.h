@@ -0,0 +1,61 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Render/primitives_array.h"
+#include "API/Core/Math/vec4.h"
+
+namespace clan
+{
+	/// \brief Reads a vertex attribute from a vertex array buffer
+	class SWRVertexAttribute
+	{
+	public:
+		/// \brief Returns the attribute converted to float, with missing components taken from (0,0,0,1)
+		Vec4f load_float(int vertex) const;
+
+		/// \brief Returns the attribute converted to int, with missing components taken from (0,0,0,1)
+		Vec4i load_int(int vertex) const;
+
+		/// \brief Returns true if the attribute of the vertex is within the buffer
+		bool is_in_range(int vertex) const;
+
+		static int get_type_size(VertexAttributeDataType type);
+
+		const char *data = nullptr;
+		size_t data_size = 0;
+		int stride = 0;
+		VertexAttributeDataType type = VertexAttributeDataType::type_float;
+		int size = 4;
+		bool normalize = false;
+
+	private:
+		float load_component(const char *ptr, bool normalize) const;
+	};
+}
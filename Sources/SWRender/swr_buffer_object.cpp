@@ -0,0 +1,76 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_buffer_object.h"
+#include "swr_transfer_buffer_provider.h"
+
+namespace clan
+{
+	void SWRBufferObject::create(const void *new_data, int size)
+	{
+		if (size < 0)
+			throw Exception("Invalid buffer size");
+
+		data.assign((size_t)size, 0);
+		if (new_data && size > 0)
+			memcpy(data.data(), new_data, size);
+	}
+
+	void SWRBufferObject::upload_data(GraphicContext &gc, int offset, const void *new_data, int size)
+	{
+		if (offset < 0 || size < 0 || offset + size > get_size())
+			throw Exception("Upload data size is larger than the buffer");
+		if (size > 0)
+			memcpy(data.data() + offset, new_data, size);
+	}
+
+	void SWRBufferObject::copy_from(GraphicContext &gc, TransferBuffer &buffer, int dest_pos, int src_pos, int size)
+	{
+		if (dest_pos < 0 || size < 0 || dest_pos + size > get_size())
+			throw Exception("Copy size is larger than the buffer");
+		if (size > 0)
+			memcpy(data.data() + dest_pos, get_transfer_data(buffer, src_pos, size), size);
+	}
+
+	void SWRBufferObject::copy_to(GraphicContext &gc, TransferBuffer &buffer, int dest_pos, int src_pos, int size)
+	{
+		if (src_pos < 0 || size < 0 || src_pos + size > get_size())
+			throw Exception("Copy size is larger than the buffer");
+		if (size > 0)
+			memcpy(get_transfer_data(buffer, dest_pos, size), data.data() + src_pos, size);
+	}
+
+	char *SWRBufferObject::get_transfer_data(TransferBuffer &buffer, int pos, int size)
+	{
+		SWRTransferBufferProvider *provider = static_cast<SWRTransferBufferProvider *>(buffer.get_provider());
+		if (pos < 0 || size < 0 || pos + size > provider->get_size())
+			throw Exception("Copy size is larger than the transfer buffer");
+		return static_cast<char *>(provider->get_data()) + pos;
+	}
+}
@@ -0,0 +1,56 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Render/graphic_context.h"
+#include "API/Display/Render/transfer_buffer.h"
+#include <vector>
+
+namespace clan
+{
+	/// \brief Buffer memory shared by the software buffer providers
+	class SWRBufferObject
+	{
+	public:
+		void create(const void *data, int size);
+
+		char *get_data() { return data.empty() ? nullptr : data.data(); }
+		const char *get_data() const { return data.empty() ? nullptr : data.data(); }
+		int get_size() const { return (int)data.size(); }
+
+		void upload_data(GraphicContext &gc, int offset, const void *data, int size);
+		void copy_from(GraphicContext &gc, TransferBuffer &buffer, int dest_pos, int src_pos, int size);
+		void copy_to(GraphicContext &gc, TransferBuffer &buffer, int dest_pos, int src_pos, int size);
+
+		static char *get_transfer_data(TransferBuffer &buffer, int pos, int size);
+
+	private:
+		std::vector<char> data;
+	};
+}
@@ -0,0 +1,129 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_display_window_provider.h"
+#include "swr_graphic_context_provider.h"
+#include "swr_input_device_provider.h"
+#include "API/Display/Window/display_window_description.h"
+#include "API/Display/TargetProviders/cursor_provider.h"
+#include <cmath>
+
+namespace clan
+{
+	SWRDisplayWindowProvider::SWRDisplayWindowProvider()
+		: back_buffer(std::make_shared<SWRTextureData>())
+	{
+		keyboard = InputDevice(new SWRInputDeviceProvider(InputDevice::keyboard));
+		mouse = InputDevice(new SWRInputDeviceProvider(InputDevice::pointer));
+	}
+
+	SWRDisplayWindowProvider::~SWRDisplayWindowProvider()
+	{
+		if (!gc.is_null())
+			gc.flush();
+	}
+
+	Rect SWRDisplayWindowProvider::get_viewport() const
+	{
+		return Rect(0, 0, (int)std::round(geometry.get_width() * pixel_ratio), (int)std::round(geometry.get_height() * pixel_ratio));
+	}
+
+	Point SWRDisplayWindowProvider::client_to_screen(const Point &client)
+	{
+		return Point(client.x + geometry.left, client.y + geometry.top);
+	}
+
+	Point SWRDisplayWindowProvider::screen_to_client(const Point &screen)
+	{
+		return Point(screen.x - geometry.left, screen.y - geometry.top);
+	}
+
+	void SWRDisplayWindowProvider::request_repaint()
+	{
+		gc.flush();
+	}
+
+	void SWRDisplayWindowProvider::create(DisplayWindowSite *new_site, const DisplayWindowDescription &description)
+	{
+		site = new_site;
+		title = description.get_title();
+		visible = description.is_visible();
+
+		Rectf position = description.get_position();
+		geometry = Rect((int)position.left, (int)position.top, (int)position.right, (int)position.bottom);
+		resize_back_buffer();
+
+		gc = GraphicContext(new SWRGraphicContextProvider(this));
+	}
+
+	CursorProvider *SWRDisplayWindowProvider::create_cursor(const CursorDescription &cursor_description)
+	{
+		return new CursorProvider();
+	}
+
+	void SWRDisplayWindowProvider::set_position(const Rect &pos, bool client_area)
+	{
+		Size old_size = geometry.get_size();
+		geometry = pos;
+		if (geometry.get_size() != old_size)
+			set_size(pos.get_width(), pos.get_height(), client_area);
+	}
+
+	void SWRDisplayWindowProvider::set_size(int width, int height, bool client_area)
+	{
+		geometry = Rect(geometry.get_top_left(), Size(width, height));
+		resize_back_buffer();
+
+		if (!gc.is_null())
+			static_cast<SWRGraphicContextProvider *>(gc.get_provider())->on_window_resized();
+		if (site)
+			site->sig_resize((float)width, (float)height);
+	}
+
+	void SWRDisplayWindowProvider::set_pixel_ratio(float ratio)
+	{
+		pixel_ratio = ratio;
+		set_size(geometry.get_width(), geometry.get_height(), true);
+	}
+
+	void SWRDisplayWindowProvider::flip(int interval)
+	{
+		gc.flush();
+	}
+
+	void SWRDisplayWindowProvider::resize_back_buffer()
+	{
+		back_buffer->flush_pipeline();
+
+		Size size = get_viewport().get_size();
+		PixelBuffer image(clan::max(size.width, 1), clan::max(size.height, 1), TextureFormat::rgba8);
+		memset(image.get_data(), 0, image.get_data_size());
+		back_buffer->image = image;
+	}
+}
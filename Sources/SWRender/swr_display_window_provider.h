@@ -0,0 +1,141 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/display_window_provider.h"
+#include "API/Display/Render/graphic_context.h"
+#include "API/Display/Window/input_device.h"
+#include "swr_texture_data.h"
+
+namespace clan
+{
+	/// \brief Headless window rendering into a back buffer in system memory
+	///
+	/// The window is never shown on screen. It only exists to provide a graphic context and a back buffer
+	/// that can be read back with GraphicContext::get_pixeldata.
+	class SWRDisplayWindowProvider : public DisplayWindowProvider
+	{
+	public:
+		SWRDisplayWindowProvider();
+		~SWRDisplayWindowProvider();
+
+		Rect get_geometry() const override { return geometry; }
+		Rect get_viewport() const override;
+		float get_pixel_ratio() const override { return pixel_ratio; }
+
+		bool has_focus() const override { return false; }
+		bool is_minimized() const override { return false; }
+		bool is_maximized() const override { return false; }
+		bool is_visible() const override { return visible; }
+		bool is_fullscreen() const override { return false; }
+		Size get_minimum_size(bool client_area) const override { return minimum_size; }
+		Size get_maximum_size(bool client_area) const override { return maximum_size; }
+		std::string get_title() const override { return title; }
+
+		GraphicContext& get_gc() override { return gc; }
+		InputDevice &get_keyboard() override { return keyboard; }
+		InputDevice &get_mouse() override { return mouse; }
+		std::vector<InputDevice> &get_game_controllers() override { return game_controllers; }
+
+		DisplayWindowHandle get_handle() const override { return DisplayWindowHandle(); }
+
+		bool is_clipboard_text_available() const override { return !clipboard_text.empty(); }
+		bool is_clipboard_image_available() const override { return !clipboard_image.is_null(); }
+		std::string get_clipboard_text() const override { return clipboard_text; }
+		PixelBuffer get_clipboard_image() const override { return clipboard_image; }
+
+		/// \brief Returns the image the window renders to
+		const std::shared_ptr<SWRTextureData> &get_back_buffer() const { return back_buffer; }
+
+		Point client_to_screen(const Point &client) override;
+		Point screen_to_client(const Point &screen) override;
+
+		void capture_mouse(bool capture) override { }
+		void request_repaint() override;
+
+		void create(DisplayWindowSite *site, const DisplayWindowDescription &description) override;
+
+		void show_system_cursor() override { }
+		void hide_system_cursor() override { }
+		CursorProvider *create_cursor(const CursorDescription &cursor_description) override;
+		void set_cursor(CursorProvider *cursor) override { }
+		void set_cursor(StandardCursor type) override { }
+#ifdef WIN32
+		void set_cursor_handle(HCURSOR cursor) override { }
+#endif
+
+		void set_title(const std::string &new_title) override { title = new_title; }
+		void set_position(const Rect &pos, bool client_area) override;
+		void set_size(int width, int height, bool client_area) override;
+		void set_minimum_size(int width, int height, bool client_area) override { minimum_size = Size(width, height); }
+		void set_maximum_size(int width, int height, bool client_area) override { maximum_size = Size(width, height); }
+		void set_pixel_ratio(float ratio) override;
+		void set_enabled(bool enable) override { }
+
+		void minimize() override { }
+		void restore() override { }
+		void maximize() override { }
+		void toggle_fullscreen() override { }
+
+		void show(bool activate) override { visible = true; }
+		void hide() override { visible = false; }
+
+		void bring_to_front() override { }
+
+		void flip(int interval) override;
+
+		void set_clipboard_text(const std::string &text) override { clipboard_text = text; }
+		void set_clipboard_image(const PixelBuffer &buf) override { clipboard_image = buf.copy(); }
+
+		void set_large_icon(const PixelBuffer &image) override { }
+		void set_small_icon(const PixelBuffer &image) override { }
+
+		void enable_alpha_channel(const Rect &blur_rect) override { }
+		void extend_frame_into_client_area(int left, int top, int right, int bottom) override { }
+
+	private:
+		void resize_back_buffer();
+
+		DisplayWindowSite *site = nullptr;
+		Rect geometry;
+		float pixel_ratio = 1.0f;
+		bool visible = false;
+		Size minimum_size;
+		Size maximum_size;
+		std::string title;
+		std::string clipboard_text;
+		PixelBuffer clipboard_image;
+
+		std::shared_ptr<SWRTextureData> back_buffer;
+		GraphicContext gc;
+		InputDevice keyboard;
+		InputDevice mouse;
+		std::vector<InputDevice> game_controllers;
+	};
+}
@@ -0,0 +1,117 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_frame_buffer_provider.h"
+#include "swr_render_buffer_provider.h"
+#include "swr_texture_provider.h"
+#include "API/Display/Render/render_buffer.h"
+#include "API/Display/Render/texture_1d.h"
+#include "API/Display/Render/texture_2d.h"
+
+namespace clan
+{
+	SWRFrameBufferProvider::SWRFrameBufferProvider()
+	{
+	}
+
+	SWRFrameBufferProvider::~SWRFrameBufferProvider()
+	{
+	}
+
+	std::shared_ptr<SWRTextureData> SWRFrameBufferProvider::get_color_buffer() const
+	{
+		return color_buffers.empty() ? std::shared_ptr<SWRTextureData>() : color_buffers[0];
+	}
+
+	Size SWRFrameBufferProvider::get_size() const
+	{
+		std::shared_ptr<SWRTextureData> color_buffer = get_color_buffer();
+		return color_buffer ? color_buffer->image.get_size() : Size();
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const RenderBuffer &render_buffer)
+	{
+		attach_color(attachment_index, static_cast<SWRRenderBufferProvider *>(render_buffer.get_provider())->get_data(), 0);
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const Texture1D &texture, int level)
+	{
+		attach_color(attachment_index, static_cast<SWRTextureProvider *>(texture.get_provider())->get_data(), level);
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const Texture1DArray &texture, int array_index, int level)
+	{
+		throw_unsupported_attachment();
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const Texture2D &texture, int level)
+	{
+		attach_color(attachment_index, static_cast<SWRTextureProvider *>(texture.get_provider())->get_data(), level);
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const Texture2DArray &texture, int array_index, int level)
+	{
+		throw_unsupported_attachment();
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const Texture3D &texture, int depth, int level)
+	{
+		throw_unsupported_attachment();
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const TextureCube &texture, TextureSubtype subtype, int level)
+	{
+		throw_unsupported_attachment();
+	}
+
+	void SWRFrameBufferProvider::detach_color(int attachment_index)
+	{
+		if (attachment_index >= 0 && attachment_index < (int)color_buffers.size())
+			color_buffers[attachment_index].reset();
+	}
+
+	void SWRFrameBufferProvider::attach_color(int attachment_index, const std::shared_ptr<SWRTextureData> &data, int level)
+	{
+		if (attachment_index < 0)
+			throw Exception("Invalid attachment index");
+		if (level != 0)
+			throw Exception("The software renderer can only render to mipmap level 0");
+		if (data->image.is_null() || data->image.get_format() != TextureFormat::rgba8)
+			throw Exception("The software renderer can only render to rgba8 color attachments");
+
+		if (attachment_index >= (int)color_buffers.size())
+			color_buffers.resize(attachment_index + 1);
+		color_buffers[attachment_index] = data;
+	}
+
+	void SWRFrameBufferProvider::throw_unsupported_attachment()
+	{
+		throw Exception("The software renderer can only render to render buffers and 1D or 2D textures");
+	}
+}
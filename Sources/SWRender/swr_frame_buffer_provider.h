@@ -0,0 +1,85 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/frame_buffer_provider.h"
+#include "swr_texture_data.h"
+
+namespace clan
+{
+	/// \brief Frame buffer for the software renderer
+	///
+	/// Rendering goes to color attachment 0, which must be a 2D image with a rgba8 storage format.
+	/// Depth and stencil attachments are accepted but not used.
+	class SWRFrameBufferProvider : public FrameBufferProvider
+	{
+	public:
+		SWRFrameBufferProvider();
+		~SWRFrameBufferProvider();
+
+		/// \brief Returns the image rendered to, or null if color attachment 0 is not set
+		std::shared_ptr<SWRTextureData> get_color_buffer() const;
+
+		Size get_size() const override;
+		FrameBufferBindTarget get_bind_target() const override { return bind_target; }
+
+		void attach_color(int attachment_index, const RenderBuffer &render_buffer) override;
+		void attach_color(int attachment_index, const Texture1D &texture, int level) override;
+		void attach_color(int attachment_index, const Texture1DArray &texture, int array_index, int level) override;
+		void attach_color(int attachment_index, const Texture2D &texture, int level) override;
+		void attach_color(int attachment_index, const Texture2DArray &texture, int array_index, int level) override;
+		void attach_color(int attachment_index, const Texture3D &texture, int depth, int level) override;
+		void attach_color(int attachment_index, const TextureCube &texture, TextureSubtype subtype, int level) override;
+		void detach_color(int attachment_index) override;
+
+		void attach_stencil(const RenderBuffer &render_buffer) override { }
+		void attach_stencil(const Texture2D &texture, int level) override { }
+		void attach_stencil(const TextureCube &texture, TextureSubtype subtype, int level) override { }
+		void detach_stencil() override { }
+
+		void attach_depth(const RenderBuffer &render_buffer) override { }
+		void attach_depth(const Texture2D &texture, int level) override { }
+		void attach_depth(const TextureCube &texture, TextureSubtype subtype, int level) override { }
+		void detach_depth() override { }
+
+		void attach_depth_stencil(const RenderBuffer &render_buffer) override { }
+		void attach_depth_stencil(const Texture2D &texture, int level) override { }
+		void attach_depth_stencil(const TextureCube &texture, TextureSubtype subtype, int level) override { }
+		void detach_depth_stencil() override { }
+
+		void set_bind_target(FrameBufferBindTarget target) override { bind_target = target; }
+
+	private:
+		void attach_color(int attachment_index, const std::shared_ptr<SWRTextureData> &data, int level);
+		static void throw_unsupported_attachment();
+
+		std::vector<std::shared_ptr<SWRTextureData>> color_buffers;
+		FrameBufferBindTarget bind_target = FrameBufferBindTarget::draw;
+	};
+}
@@ -0,0 +1,568 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_graphic_context_provider.h"
+#include "swr_display_window_provider.h"
+#include "swr_texture_provider.h"
+#include "swr_occlusion_query_provider.h"
+#include "swr_program_object_provider.h"
+#include "swr_shader_object_provider.h"
+#include "swr_frame_buffer_provider.h"
+#include "swr_render_buffer_provider.h"
+#include "swr_vertex_array_buffer_provider.h"
+#include "swr_uniform_buffer_provider.h"
+#include "swr_storage_buffer_provider.h"
+#include "swr_element_array_buffer_provider.h"
+#include "swr_transfer_buffer_provider.h"
+#include "swr_pixel_buffer_provider.h"
+#include "swr_primitives_array_provider.h"
+#include "swr_blend_state_provider.h"
+#include "swr_rasterizer_state_provider.h"
+#include "swr_depth_stencil_state_provider.h"
+#include "Pipeline/swr_triangle_setup.h"
+#include "Pipeline/swr_standard_programs.h"
+#include "API/Display/Render/texture.h"
+#include "API/Display/Render/primitives_array.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "Display/2D/render_batch_triangle.h"
+#include <cmath>
+
+namespace clan
+{
+	SWRGraphicContextProvider::SWRGraphicContextProvider(SWRDisplayWindowProvider *window)
+		: window(window)
+	{
+		standard_programs[(int)StandardProgram::color_only] = ProgramObject(new SWRProgramObjectProvider(SWRProgramType::color_only));
+		standard_programs[(int)StandardProgram::single_texture] = ProgramObject(new SWRProgramObjectProvider(SWRProgramType::single_texture));
+		standard_programs[(int)StandardProgram::sprite] = ProgramObject(new SWRProgramObjectProvider(SWRProgramType::sprite));
+		standard_programs[(int)StandardProgram::path] = ProgramObject(new SWRProgramObjectProvider(SWRProgramType::path));
+
+		RenderBatchTriangle::max_textures = SWRDrawState::max_samplers;
+
+		Size size = get_display_window_size();
+		viewport = Rectf(0.0f, 0.0f, (float)size.width, (float)size.height);
+	}
+
+	SWRGraphicContextProvider::~SWRGraphicContextProvider()
+	{
+		pipeline.flush();
+	}
+
+	Size SWRGraphicContextProvider::get_display_window_size() const
+	{
+		return window->get_viewport().get_size();
+	}
+
+	float SWRGraphicContextProvider::get_pixel_ratio() const
+	{
+		return window->get_pixel_ratio();
+	}
+
+	ProgramObject SWRGraphicContextProvider::get_program_object(StandardProgram standard_program) const
+	{
+		return standard_programs[(int)standard_program];
+	}
+
+	PixelBuffer SWRGraphicContextProvider::get_pixeldata(const Rect& rect, TextureFormat texture_format, bool clamp) const
+	{
+		std::shared_ptr<SWRTextureData> target = get_read_target();
+		target->flush_pipeline();
+
+		PixelBuffer pixels(rect.get_width(), rect.get_height(), TextureFormat::rgba8);
+		memset(pixels.get_data(), 0, pixels.get_data_size());
+
+		Rect src_rect = rect;
+		src_rect.clip(target->image.get_size());
+		if (src_rect.get_width() > 0 && src_rect.get_height() > 0)
+			pixels.set_subimage(target->image, Point(src_rect.left - rect.left, src_rect.top - rect.top), src_rect);
+
+		if (texture_format == TextureFormat::rgba8)
+			return pixels;
+		else
+			return pixels.to_format(texture_format);
+	}
+
+	TextureProvider *SWRGraphicContextProvider::alloc_texture(TextureDimensions texture_dimensions)
+	{
+		return new SWRTextureProvider(texture_dimensions);
+	}
+
+	OcclusionQueryProvider *SWRGraphicContextProvider::alloc_occlusion_query()
+	{
+		return new SWROcclusionQueryProvider();
+	}
+
+	ProgramObjectProvider *SWRGraphicContextProvider::alloc_program_object()
+	{
+		return new SWRProgramObjectProvider();
+	}
+
+	ShaderObjectProvider *SWRGraphicContextProvider::alloc_shader_object()
+	{
+		return new SWRShaderObjectProvider();
+	}
+
+	FrameBufferProvider *SWRGraphicContextProvider::alloc_frame_buffer()
+	{
+		return new SWRFrameBufferProvider();
+	}
+
+	RenderBufferProvider *SWRGraphicContextProvider::alloc_render_buffer()
+	{
+		return new SWRRenderBufferProvider();
+	}
+
+	VertexArrayBufferProvider *SWRGraphicContextProvider::alloc_vertex_array_buffer()
+	{
+		return new SWRVertexArrayBufferProvider();
+	}
+
+	UniformBufferProvider *SWRGraphicContextProvider::alloc_uniform_buffer()
+	{
+		return new SWRUniformBufferProvider();
+	}
+
+	StorageBufferProvider *SWRGraphicContextProvider::alloc_storage_buffer()
+	{
+		return new SWRStorageBufferProvider();
+	}
+
+	ElementArrayBufferProvider *SWRGraphicContextProvider::alloc_element_array_buffer()
+	{
+		return new SWRElementArrayBufferProvider();
+	}
+
+	TransferBufferProvider *SWRGraphicContextProvider::alloc_transfer_buffer()
+	{
+		return new SWRTransferBufferProvider();
+	}
+
+	PixelBufferProvider *SWRGraphicContextProvider::alloc_pixel_buffer()
+	{
+		return new SWRPixelBufferProvider();
+	}
+
+	PrimitivesArrayProvider *SWRGraphicContextProvider::alloc_primitives_array()
+	{
+		return new SWRPrimitivesArrayProvider();
+	}
+
+	std::shared_ptr<RasterizerStateProvider> SWRGraphicContextProvider::create_rasterizer_state(const RasterizerStateDescription &desc)
+	{
+		auto it = rasterizer_states.find(desc);
+		if (it != rasterizer_states.end())
+		{
+			return it->second;
+		}
+		else
+		{
+			std::shared_ptr<RasterizerStateProvider> state(new SWRRasterizerStateProvider(desc));
+			rasterizer_states[desc.clone()] = state;
+			return state;
+		}
+	}
+
+	std::shared_ptr<BlendStateProvider> SWRGraphicContextProvider::create_blend_state(const BlendStateDescription &desc)
+	{
+		auto it = blend_states.find(desc);
+		if (it != blend_states.end())
+		{
+			return it->second;
+		}
+		else
+		{
+			std::shared_ptr<BlendStateProvider> state(new SWRBlendStateProvider(desc));
+			blend_states[desc.clone()] = state;
+			return state;
+		}
+	}
+
+	std::shared_ptr<DepthStencilStateProvider> SWRGraphicContextProvider::create_depth_stencil_state(const DepthStencilStateDescription &desc)
+	{
+		auto it = depth_stencil_states.find(desc);
+		if (it != depth_stencil_states.end())
+		{
+			return it->second;
+		}
+		else
+		{
+			std::shared_ptr<DepthStencilStateProvider> state(new SWRDepthStencilStateProvider(desc));
+			depth_stencil_states[desc.clone()] = state;
+			return state;
+		}
+	}
+
+	void SWRGraphicContextProvider::set_rasterizer_state(RasterizerStateProvider *state)
+	{
+		if (state)
+			rasterizer = static_cast<SWRRasterizerStateProvider *>(state)->desc;
+	}
+
+	void SWRGraphicContextProvider::set_blend_state(BlendStateProvider *state, const Colorf &new_blend_color, unsigned int sample_mask)
+	{
+		if (state)
+		{
+			blend = static_cast<SWRBlendStateProvider *>(state)->settings;
+			blend_color = new_blend_color;
+		}
+	}
+
+	void SWRGraphicContextProvider::set_program_object(StandardProgram standard_program)
+	{
+		program = standard_programs[(int)standard_program];
+	}
+
+	void SWRGraphicContextProvider::set_program_object(const ProgramObject &new_program)
+	{
+		program = new_program;
+	}
+
+	void SWRGraphicContextProvider::reset_program_object()
+	{
+		program = ProgramObject();
+	}
+
+	void SWRGraphicContextProvider::set_texture(int unit_index, const Texture &texture)
+	{
+		if (unit_index < 0 || unit_index >= SWRDrawState::max_samplers)
+			return;
+
+		if (texture.is_null())
+			textures[unit_index].reset();
+		else
+			textures[unit_index] = static_cast<SWRTextureProvider *>(texture.get_provider())->get_data();
+	}
+
+	void SWRGraphicContextProvider::reset_texture(int unit_index)
+	{
+		if (unit_index >= 0 && unit_index < SWRDrawState::max_samplers)
+			textures[unit_index].reset();
+	}
+
+	bool SWRGraphicContextProvider::is_frame_buffer_owner(const FrameBuffer &fb)
+	{
+		return dynamic_cast<SWRFrameBufferProvider *>(fb.get_provider()) != nullptr;
+	}
+
+	void SWRGraphicContextProvider::set_frame_buffer(const FrameBuffer &write_buffer, const FrameBuffer &read_buffer)
+	{
+		draw_buffer = write_buffer;
+		this->read_buffer = read_buffer;
+	}
+
+	void SWRGraphicContextProvider::reset_frame_buffer()
+	{
+		draw_buffer = FrameBuffer();
+		read_buffer = FrameBuffer();
+	}
+
+	bool SWRGraphicContextProvider::is_primitives_array_owner(const PrimitivesArray &prim_array)
+	{
+		return dynamic_cast<SWRPrimitivesArrayProvider *>(prim_array.get_provider()) != nullptr;
+	}
+
+	void SWRGraphicContextProvider::draw_primitives(PrimitivesType type, int num_vertices, const PrimitivesArray &primitives_array)
+	{
+		set_primitives_array(primitives_array);
+		draw_primitives_array(type, 0, num_vertices);
+		reset_primitives_array();
+	}
+
+	void SWRGraphicContextProvider::set_primitives_array(const PrimitivesArray &prim_array)
+	{
+		primitives_array = static_cast<SWRPrimitivesArrayProvider *>(prim_array.get_provider());
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_array(PrimitivesType type, int offset, int num_vertices)
+	{
+		draw_primitives_array_instanced(type, offset, num_vertices, 1);
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_array_instanced(PrimitivesType type, int offset, int num_vertices, int instance_count)
+	{
+		indices.resize(num_vertices);
+		for (int i = 0; i < num_vertices; i++)
+			indices[i] = offset + i;
+		draw(type, instance_count);
+	}
+
+	void SWRGraphicContextProvider::set_primitives_elements(ElementArrayBufferProvider *array_provider)
+	{
+		primitives_elements = array_provider;
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_elements(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset)
+	{
+		draw_primitives_elements_instanced(type, count, primitives_elements, indices_type, (void *)offset, 1);
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_elements_instanced(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset, int instance_count)
+	{
+		draw_primitives_elements_instanced(type, count, primitives_elements, indices_type, (void *)offset, instance_count);
+	}
+
+	void SWRGraphicContextProvider::reset_primitives_elements()
+	{
+		primitives_elements = nullptr;
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_elements(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset)
+	{
+		draw_primitives_elements_instanced(type, count, array_provider, indices_type, offset, 1);
+	}
+
+	void SWRGraphicContextProvider::draw_primitives_elements_instanced(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset, int instance_count)
+	{
+		load_element_indices(count, array_provider, indices_type, (size_t)offset);
+		draw(type, instance_count);
+	}
+
+	void SWRGraphicContextProvider::reset_primitives_array()
+	{
+		primitives_array = nullptr;
+	}
+
+	void SWRGraphicContextProvider::set_scissor(const Rect &rect)
+	{
+		if (!rasterizer.get_enable_scissor())
+			throw Exception("RasterizerState must be set with enable_scissor() for clipping to work");
+
+		scissor_enabled = true;
+		scissor = rect;
+	}
+
+	void SWRGraphicContextProvider::reset_scissor()
+	{
+		scissor_enabled = false;
+	}
+
+	void SWRGraphicContextProvider::dispatch(int x, int y, int z)
+	{
+		throw Exception("Compute shaders are not supported by the software renderer");
+	}
+
+	void SWRGraphicContextProvider::clear(const Colorf &color)
+	{
+		std::shared_ptr<SWRTextureData> target = get_draw_target();
+		pipeline.set_target(target);
+
+		SWRClear command;
+		command.box = Rect(Point(0, 0), target->image.get_size());
+		if (scissor_enabled)
+			command.box.clip(scissor);
+		command.color = SWRFloat4(color.r, color.g, color.b, color.a).to_rgba8();
+		command.write_mask = blend.write_mask;
+
+		if (command.box.get_width() > 0 && command.box.get_height() > 0)
+			pipeline.add_clear(command);
+	}
+
+	void SWRGraphicContextProvider::set_viewport(const Rectf &new_viewport)
+	{
+		viewport = new_viewport;
+	}
+
+	void SWRGraphicContextProvider::set_viewport(int index, const Rectf &new_viewport)
+	{
+		if (index <= 0)
+			viewport = new_viewport;
+	}
+
+	void SWRGraphicContextProvider::flush()
+	{
+		pipeline.flush();
+	}
+
+	void SWRGraphicContextProvider::on_window_resized()
+	{
+		window_resized_signal(window->get_viewport().get_size());
+	}
+
+	std::shared_ptr<SWRTextureData> SWRGraphicContextProvider::get_draw_target() const
+	{
+		if (draw_buffer.is_null())
+			return window->get_back_buffer();
+
+		std::shared_ptr<SWRTextureData> target = static_cast<SWRFrameBufferProvider *>(draw_buffer.get_provider())->get_color_buffer();
+		if (!target)
+			throw Exception("Frame buffer has no color attachment");
+		return target;
+	}
+
+	std::shared_ptr<SWRTextureData> SWRGraphicContextProvider::get_read_target() const
+	{
+		if (read_buffer.is_null())
+			return window->get_back_buffer();
+
+		std::shared_ptr<SWRTextureData> target = static_cast<SWRFrameBufferProvider *>(read_buffer.get_provider())->get_color_buffer();
+		if (!target)
+			throw Exception("Frame buffer has no color attachment");
+		return target;
+	}
+
+	void SWRGraphicContextProvider::load_element_indices(int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, size_t offset)
+	{
+		if (!array_provider)
+			throw Exception("No element array buffer set");
+
+		SWRElementArrayBufferProvider *elements = static_cast<SWRElementArrayBufferProvider *>(array_provider);
+		int index_size = SWRVertexAttribute::get_type_size(indices_type);
+		if (count < 0 || offset + (size_t)count * index_size > (size_t)elements->get_size())
+			throw Exception("Element array buffer overflow");
+
+		const char *data = elements->get_data() + offset;
+		indices.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			switch (indices_type)
+			{
+			case VertexAttributeDataType::type_unsigned_byte: indices[i] = reinterpret_cast<const unsigned char *>(data)[i]; break;
+			case VertexAttributeDataType::type_unsigned_short: indices[i] = reinterpret_cast<const unsigned short *>(data)[i]; break;
+			case VertexAttributeDataType::type_unsigned_int: indices[i] = reinterpret_cast<const int *>(data)[i]; break;
+			default: throw Exception("Unsupported element index type");
+			}
+		}
+	}
+
+	void SWRGraphicContextProvider::draw(PrimitivesType type, int instance_count)
+	{
+		if (!primitives_array)
+			throw Exception("No primitives array set");
+
+		SWRProgramObjectProvider *program_provider = program.is_null() ? nullptr : static_cast<SWRProgramObjectProvider *>(program.get_provider());
+		if (!program_provider || !program_provider->is_standard())
+			throw Exception("The software renderer can only execute the standard programs");
+
+		std::shared_ptr<SWRTextureData> target = get_draw_target();
+		pipeline.set_target(target);
+
+		SWRDrawState state;
+		state.program = program_provider->get_standard_type();
+		state.ypos_scale = program_provider->get_ypos_scale();
+		state.blend = blend;
+		state.blend_color = blend_color;
+		for (int i = 0; i < SWRDrawState::max_samplers; i++)
+		{
+			if (textures[i])
+			{
+				pipeline.reference(textures[i]);
+				state.samplers[i].set(textures[i].get());
+			}
+		}
+		pipeline.set_state(state);
+
+		SWRVertexAttribute attributes[max_attributes];
+		for (int i = 0; i < max_attributes; i++)
+			attributes[i] = primitives_array->get_attribute(i);
+
+		int max_index = -1;
+		for (int index : indices)
+		{
+			if (index < 0)
+				throw Exception("Invalid vertex index");
+			max_index = clan::max(max_index, index);
+		}
+		for (int i = 0; i < max_attributes; i++)
+		{
+			if (max_index >= 0 && attributes[i].data && !attributes[i].is_in_range(max_index))
+				throw Exception("Vertex array buffer overflow");
+		}
+
+		vertices.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+			SWRStandardPrograms::run_vertex(state, attributes, indices[i], vertices[i]);
+
+		Rect clip_box(Point(0, 0), target->image.get_size());
+		clip_box.clip(Rect((int)std::floor(viewport.left), (int)std::floor(viewport.top), (int)std::ceil(viewport.right), (int)std::ceil(viewport.bottom)));
+		if (scissor_enabled)
+			clip_box.clip(scissor);
+		if (clip_box.get_width() <= 0 || clip_box.get_height() <= 0)
+			return;
+
+		SWRTriangleSetup setup(&pipeline, viewport, clip_box);
+		if (rasterizer.get_culled())
+		{
+			CullMode cull_mode = rasterizer.get_face_cull_mode();
+			setup.set_cull(cull_mode != CullMode::back, cull_mode != CullMode::front, rasterizer.get_front_face() == FaceSide::counter_clockwise);
+		}
+
+		for (int instance = 0; instance < instance_count; instance++)
+			assemble(type, setup);
+	}
+
+	void SWRGraphicContextProvider::assemble(PrimitivesType type, SWRTriangleSetup &setup)
+	{
+		int count = (int)vertices.size();
+		switch (type)
+		{
+		case PrimitivesType::points:
+			for (int i = 0; i < count; i++)
+				setup.draw_point(vertices[i], rasterizer.get_point_size());
+			break;
+
+		case PrimitivesType::lines:
+			for (int i = 0; i + 1 < count; i += 2)
+				setup.draw_line(vertices[i], vertices[i + 1]);
+			break;
+
+		case PrimitivesType::line_strip:
+			for (int i = 0; i + 1 < count; i++)
+				setup.draw_line(vertices[i], vertices[i + 1]);
+			break;
+
+		case PrimitivesType::line_loop:
+			for (int i = 0; i + 1 < count; i++)
+				setup.draw_line(vertices[i], vertices[i + 1]);
+			if (count > 2)
+				setup.draw_line(vertices[count - 1], vertices[0]);
+			break;
+
+		case PrimitivesType::triangles:
+			for (int i = 0; i + 2 < count; i += 3)
+				setup.draw_triangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+			break;
+
+		case PrimitivesType::triangle_strip:
+			for (int i = 0; i + 2 < count; i++)
+			{
+				// Every other triangle is flipped to keep the winding of the strip
+				if (i % 2 == 0)
+					setup.draw_triangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+				else
+					setup.draw_triangle(vertices[i + 1], vertices[i], vertices[i + 2]);
+			}
+			break;
+
+		case PrimitivesType::triangle_fan:
+			for (int i = 1; i + 1 < count; i++)
+				setup.draw_triangle(vertices[0], vertices[i], vertices[i + 1]);
+			break;
+		}
+	}
+}
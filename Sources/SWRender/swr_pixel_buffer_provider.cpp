@@ -0,0 +1,64 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_pixel_buffer_provider.h"
+
+namespace clan
+{
+	SWRPixelBufferProvider::SWRPixelBufferProvider()
+	{
+	}
+
+	SWRPixelBufferProvider::~SWRPixelBufferProvider()
+	{
+	}
+
+	void SWRPixelBufferProvider::create(const void *new_data, const Size &new_size, PixelBufferDirection direction, TextureFormat new_format, BufferUsage usage)
+	{
+		size = new_size;
+		texture_format = new_format;
+		pitch = PixelBuffer::get_bytes_per_pixel(new_format) * size.width;
+
+		data.resize((size_t)pitch * size.height);
+		if (new_data)
+			memcpy(data.data(), new_data, data.size());
+	}
+
+	void SWRPixelBufferProvider::upload_data(GraphicContext &gc, const Rect &dest_rect, const void *src_data)
+	{
+		if (dest_rect.left < 0 || dest_rect.top < 0 || dest_rect.right > size.width || dest_rect.bottom > size.height)
+			throw Exception("Rectangle out of bounds");
+
+		int bytes_per_pixel = PixelBuffer::get_bytes_per_pixel(texture_format);
+		int row_size = dest_rect.get_width() * bytes_per_pixel;
+		const unsigned char *src = static_cast<const unsigned char *>(src_data);
+		for (int y = 0; y < dest_rect.get_height(); y++)
+			memcpy(data.data() + (size_t)(dest_rect.top + y) * pitch + dest_rect.left * bytes_per_pixel, src + (size_t)y * row_size, row_size);
+	}
+}
@@ -0,0 +1,63 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/pixel_buffer_provider.h"
+#include <vector>
+
+namespace clan
+{
+	/// \brief Transfer pixel buffer of the software renderer
+	///
+	/// The pixels are kept in system memory, so locking is not required to access them.
+	class SWRPixelBufferProvider : public PixelBufferProvider
+	{
+	public:
+		SWRPixelBufferProvider();
+		~SWRPixelBufferProvider();
+
+		void create(const void *data, const Size &new_size, PixelBufferDirection direction, TextureFormat new_format, BufferUsage usage) override;
+
+		void *get_data() override { return data.data(); }
+		int get_pitch() const override { return pitch; }
+		Size get_size() const override { return size; }
+		bool is_gpu() const override { return false; }
+		TextureFormat get_format() const override { return texture_format; };
+
+		void lock(GraphicContext &gc, BufferAccess access) override { }
+		void unlock() override { }
+		void upload_data(GraphicContext &gc, const Rect &dest_rect, const void *data) override;
+
+	private:
+		std::vector<unsigned char> data;
+		Size size;
+		TextureFormat texture_format = TextureFormat::rgba8;
+		int pitch = 0;
+	};
+}
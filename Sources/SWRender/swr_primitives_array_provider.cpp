@@ -0,0 +1,74 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_primitives_array_provider.h"
+#include "swr_vertex_array_buffer_provider.h"
+
+namespace clan
+{
+	SWRPrimitivesArrayProvider::SWRPrimitivesArrayProvider()
+	{
+	}
+
+	SWRPrimitivesArrayProvider::~SWRPrimitivesArrayProvider()
+	{
+	}
+
+	void SWRPrimitivesArrayProvider::set_attribute(int index, const VertexData &data, bool normalize)
+	{
+		if (index < 0)
+			throw Exception("Invalid vertex attribute index");
+		if (index >= (int)attributes.size())
+			attributes.resize(index + 1);
+
+		attributes[index].enabled = true;
+		attributes[index].data = data;
+		attributes[index].normalize = normalize;
+	}
+
+	SWRVertexAttribute SWRPrimitivesArrayProvider::get_attribute(int index) const
+	{
+		SWRVertexAttribute result;
+		if (index < (int)attributes.size() && attributes[index].enabled && attributes[index].data.array_provider)
+		{
+			const VertexData &data = attributes[index].data;
+			SWRVertexArrayBufferProvider *buffer = static_cast<SWRVertexArrayBufferProvider *>(data.array_provider);
+			if (data.offset <= (size_t)buffer->get_size() && buffer->get_data())
+			{
+				result.data = buffer->get_data() + data.offset;
+				result.data_size = buffer->get_size() - data.offset;
+			}
+			result.type = data.type;
+			result.size = data.size;
+			result.stride = data.stride != 0 ? data.stride : data.size * SWRVertexAttribute::get_type_size(data.type);
+			result.normalize = attributes[index].normalize;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,112 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_program_object_provider.h"
+#include <algorithm>
+
+namespace clan
+{
+	SWRProgramObjectProvider::SWRProgramObjectProvider()
+	{
+	}
+
+	SWRProgramObjectProvider::SWRProgramObjectProvider(SWRProgramType standard_type)
+		: standard(true), standard_type(standard_type), link_status(true)
+	{
+		switch (standard_type)
+		{
+		case SWRProgramType::sprite:
+			attribute_locations["TexIndex0"] = 3;
+			// Fall through
+		case SWRProgramType::single_texture:
+			attribute_locations["TexCoord0"] = 2;
+			// Fall through
+		case SWRProgramType::color_only:
+			attribute_locations["Position"] = 0;
+			attribute_locations["Color0"] = 1;
+			break;
+		case SWRProgramType::path:
+			attribute_locations["Vertex"] = 0;
+			break;
+		}
+	}
+
+	SWRProgramObjectProvider::~SWRProgramObjectProvider()
+	{
+	}
+
+	int SWRProgramObjectProvider::get_attribute_location(const std::string &name) const
+	{
+		auto it = attribute_locations.find(name);
+		return it != attribute_locations.end() ? it->second : -1;
+	}
+
+	int SWRProgramObjectProvider::get_uniform_location(const std::string &name) const
+	{
+		if (standard && standard_type == SWRProgramType::path && name == "ypos_scale")
+			return ypos_scale_location;
+		return -1;
+	}
+
+	void SWRProgramObjectProvider::attach(const ShaderObject &obj)
+	{
+		shaders.push_back(obj);
+	}
+
+	void SWRProgramObjectProvider::detach(const ShaderObject &obj)
+	{
+		shaders.erase(std::remove(shaders.begin(), shaders.end(), obj), shaders.end());
+	}
+
+	void SWRProgramObjectProvider::bind_attribute_location(int index, const std::string &name)
+	{
+		attribute_locations[name] = index;
+	}
+
+	void SWRProgramObjectProvider::link()
+	{
+		if (!standard)
+		{
+			link_status = false;
+			info_log = "Programs cannot be linked by the software renderer. Only the standard programs are available.";
+		}
+	}
+
+	void SWRProgramObjectProvider::set_uniform1f(int location, float value_a)
+	{
+		if (location == ypos_scale_location && standard && standard_type == SWRProgramType::path)
+			ypos_scale = value_a;
+	}
+
+	void SWRProgramObjectProvider::set_uniformfv(int location, int size, int count, const float *data)
+	{
+		if (size == 1 && count > 0)
+			set_uniform1f(location, data[0]);
+	}
+}
@@ -0,0 +1,100 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/program_object_provider.h"
+#include "API/Display/Render/shader_object.h"
+#include "Pipeline/swr_draw_state.h"
+#include <map>
+
+namespace clan
+{
+	/// \brief Program object for the software renderer
+	///
+	/// Only the standard programs can be executed. They use the same attribute locations and
+	/// texture units as the clanGL versions. Other programs fail to link.
+	class SWRProgramObjectProvider : public ProgramObjectProvider
+	{
+	public:
+		/// \brief Constructs a program that links from shader objects (which always fails)
+		SWRProgramObjectProvider();
+
+		/// \brief Constructs a linked standard program
+		SWRProgramObjectProvider(SWRProgramType standard_type);
+
+		~SWRProgramObjectProvider();
+
+		bool is_standard() const { return standard; }
+		SWRProgramType get_standard_type() const { return standard_type; }
+		float get_ypos_scale() const { return ypos_scale; }
+
+		unsigned int get_handle() const override { return 0; }
+		bool get_link_status() const override { return link_status; }
+		bool get_validate_status() const override { return link_status; }
+		std::string get_info_log() const override { return info_log; }
+		std::vector<ShaderObject> get_shaders() const override { return shaders; }
+		int get_attribute_location(const std::string &name) const override;
+		int get_uniform_location(const std::string &name) const override;
+		int get_uniform_buffer_size(int block_index) const override { return 0; }
+		int get_uniform_buffer_index(const std::string &block_name) const override { return -1; }
+		int get_storage_buffer_index(const std::string &name) const override { return -1; }
+
+		void attach(const ShaderObject &obj) override;
+		void detach(const ShaderObject &obj) override;
+		void bind_attribute_location(int index, const std::string &name) override;
+		void bind_frag_data_location(int color_number, const std::string &name) override { }
+		void link() override;
+		void validate() override { }
+
+		void set_uniform1i(int location, int value_a) override { }
+		void set_uniform2i(int location, int value_a, int value_b) override { }
+		void set_uniform3i(int location, int value_a, int value_b, int value_c) override { }
+		void set_uniform4i(int location, int value_a, int value_b, int value_c, int value_d) override { }
+		void set_uniformiv(int location, int size, int count, const int *data) override { }
+		void set_uniform1f(int location, float value_a) override;
+		void set_uniform2f(int location, float value_a, float value_b) override { }
+		void set_uniform3f(int location, float value_a, float value_b, float value_c) override { }
+		void set_uniform4f(int location, float value_a, float value_b, float value_c, float value_d) override { }
+		void set_uniformfv(int location, int size, int count, const float *data) override;
+		void set_uniform_matrix(int location, int size, int count, bool transpose, const float *data) override { }
+		void set_uniform_buffer_index(int block_index, int bind_index) override { }
+		void set_storage_buffer_index(int buffer_index, int bind_unit_index) override { }
+
+	private:
+		static const int ypos_scale_location = 0;
+
+		bool standard = false;
+		SWRProgramType standard_type = SWRProgramType::color_only;
+		bool link_status = false;
+		std::string info_log;
+		std::vector<ShaderObject> shaders;
+		std::map<std::string, int> attribute_locations;
+		float ypos_scale = 1.0f;
+	};
+}
@@ -0,0 +1,49 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/render_buffer_provider.h"
+#include "swr_texture_data.h"
+
+namespace clan
+{
+	class SWRRenderBufferProvider : public RenderBufferProvider
+	{
+	public:
+		SWRRenderBufferProvider();
+		~SWRRenderBufferProvider();
+
+		void create(int width, int height, TextureFormat texture_format, int multisample_samples) override;
+
+		const std::shared_ptr<SWRTextureData> &get_data() const { return data; }
+
+	private:
+		std::shared_ptr<SWRTextureData> data;
+	};
+}
@@ -0,0 +1,66 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_shader_object_provider.h"
+
+namespace clan
+{
+	SWRShaderObjectProvider::SWRShaderObjectProvider()
+	{
+	}
+
+	SWRShaderObjectProvider::~SWRShaderObjectProvider()
+	{
+	}
+
+	void SWRShaderObjectProvider::create(ShaderType new_type, const std::string &new_source)
+	{
+		type = new_type;
+		source = new_source;
+	}
+
+	void SWRShaderObjectProvider::create(ShaderType new_type, const void *new_source, int source_size)
+	{
+		type = new_type;
+		source = std::string(static_cast<const char *>(new_source), source_size);
+	}
+
+	void SWRShaderObjectProvider::create(ShaderType new_type, const std::vector<std::string> &sources)
+	{
+		type = new_type;
+		source.clear();
+		for (const auto &part : sources)
+			source += part;
+	}
+
+	void SWRShaderObjectProvider::compile()
+	{
+		info_log = "Shaders cannot be compiled by the software renderer. Only the standard programs are available.";
+	}
+}
@@ -0,0 +1,59 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/shader_object_provider.h"
+
+namespace clan
+{
+	/// \brief Shader object that keeps its source (the software renderer cannot compile shaders)
+	class SWRShaderObjectProvider : public ShaderObjectProvider
+	{
+	public:
+		SWRShaderObjectProvider();
+		~SWRShaderObjectProvider();
+
+		void create(ShaderType type, const std::string &source) override;
+		void create(ShaderType type, const void *source, int source_size) override;
+		void create(ShaderType type, const std::vector<std::string> &sources) override;
+
+		unsigned int get_handle() const override { return 0; }
+		bool get_compile_status() const override { return false; }
+		ShaderType get_shader_type() const override { return type; }
+		std::string get_info_log() const override { return info_log; }
+		std::string get_shader_source() const override { return source; }
+
+		void compile() override;
+
+	private:
+		ShaderType type = ShaderType::vertex;
+		std::string source;
+		std::string info_log;
+	};
+}
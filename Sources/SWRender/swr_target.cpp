@@ -0,0 +1,46 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "API/SWRender/swr_target.h"
+#include "API/Display/display_target.h"
+#include "swr_target_provider.h"
+
+namespace clan
+{
+	bool SWRTarget::is_current()
+	{
+		return std::dynamic_pointer_cast<SWRTargetProvider>(DisplayTarget::get_current_target()) ? true : false;
+	}
+
+	void SWRTarget::set_current()
+	{
+		static std::shared_ptr<SWRTargetProvider> target = std::make_shared<SWRTargetProvider>();
+		DisplayTarget::set_current_target(target);
+	}
+}
@@ -0,0 +1,62 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_texture_data.h"
+#include "Pipeline/swr_pixel_pipeline.h"
+
+namespace clan
+{
+	TextureFormat SWRTextureData::get_storage_format(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::r8:
+			return TextureFormat::r8;
+		case TextureFormat::r16f:
+		case TextureFormat::rg16f:
+		case TextureFormat::rgb16f:
+		case TextureFormat::rgba16f:
+		case TextureFormat::r32f:
+		case TextureFormat::rg32f:
+		case TextureFormat::rgb32f:
+		case TextureFormat::rgba32f:
+		case TextureFormat::r11f_g11f_b10f:
+		case TextureFormat::rgb9_e5:
+			return TextureFormat::rgba32f;
+		default:
+			return TextureFormat::rgba8;
+		}
+	}
+
+	void SWRTextureData::flush_pipeline()
+	{
+		if (pipeline)
+			pipeline->flush();
+	}
+}
@@ -0,0 +1,61 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Display/Render/texture.h"
+#include <memory>
+
+namespace clan
+{
+	class SWRPixelPipeline;
+
+	/// \brief Level 0 image and sampler settings of a software texture
+	class SWRTextureData
+	{
+	public:
+		/// \brief Returns the format images of the specified format are stored in (rgba8, r8 or rgba32f)
+		static TextureFormat get_storage_format(TextureFormat format);
+
+		/// \brief Finishes queued rendering that reads from or writes to this texture
+		///
+		/// Must be called before the image is modified or read back by the CPU.
+		void flush_pipeline();
+
+		PixelBuffer image;
+
+		TextureWrapMode wrap_s = TextureWrapMode::clamp_to_edge;
+		TextureWrapMode wrap_t = TextureWrapMode::clamp_to_edge;
+		TextureFilter min_filter = TextureFilter::linear;
+		TextureFilter mag_filter = TextureFilter::linear;
+
+		/// \brief Pipeline with queued commands using this texture, if any
+		SWRPixelPipeline *pipeline = nullptr;
+	};
+}
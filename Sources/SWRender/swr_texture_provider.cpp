@@ -0,0 +1,150 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_texture_provider.h"
+#include "swr_graphic_context_provider.h"
+
+namespace clan
+{
+	SWRTextureProvider::SWRTextureProvider(TextureDimensions texture_dimensions)
+		: texture_dimensions(texture_dimensions), data(std::make_shared<SWRTextureData>())
+	{
+		if (texture_dimensions != TextureDimensions::_1d && texture_dimensions != TextureDimensions::_2d)
+			throw Exception("The software renderer only supports 1D and 2D textures");
+	}
+
+	SWRTextureProvider::SWRTextureProvider(TextureDimensions texture_dimensions, const std::shared_ptr<SWRTextureData> &data)
+		: texture_dimensions(texture_dimensions), data(data)
+	{
+	}
+
+	SWRTextureProvider::~SWRTextureProvider()
+	{
+		if (data.use_count() == 1)
+			data->flush_pipeline();
+	}
+
+	void SWRTextureProvider::create(int width, int height, int depth, int array_size, TextureFormat texture_format, int levels)
+	{
+		if (texture_dimensions == TextureDimensions::_1d)
+			height = 1;
+
+		data->flush_pipeline();
+
+		PixelBuffer image(width, height, SWRTextureData::get_storage_format(texture_format));
+		memset(image.get_data(), 0, image.get_data_size());
+		data->image = image;
+	}
+
+	PixelBuffer SWRTextureProvider::get_pixeldata(GraphicContext &gc, TextureFormat texture_format, int level) const
+	{
+		if (level != 0)
+			throw Exception("The software renderer only stores mipmap level 0");
+
+		data->flush_pipeline();
+		return data->image.to_format(texture_format);
+	}
+
+	void SWRTextureProvider::copy_from(GraphicContext &gc, int x, int y, int slice, int level, const PixelBuffer &src, const Rect &src_rect)
+	{
+		if (level != 0)
+			return;
+
+		if (src_rect.left < 0 || src_rect.top < 0 || src_rect.right > src.get_width() || src_rect.bottom > src.get_height())
+			throw Exception("Rectangle out of bounds");
+		if (x < 0 || y < 0 || x + src_rect.get_width() > data->image.get_width() || y + src_rect.get_height() > data->image.get_height())
+			throw Exception("Rectangle out of bounds");
+
+		data->flush_pipeline();
+		data->image.set_subimage(src, Point(x, y), src_rect);
+	}
+
+	void SWRTextureProvider::copy_image_from(int x, int y, int width, int height, int level, TextureFormat texture_format, GraphicContextProvider *gc)
+	{
+		if (level != 0)
+			return;
+
+		PixelBuffer pixels = static_cast<SWRGraphicContextProvider *>(gc)->get_pixeldata(Rect(x, y, x + width, y + height), TextureFormat::rgba8, false);
+
+		data->flush_pipeline();
+		data->image = pixels.to_format(SWRTextureData::get_storage_format(texture_format));
+	}
+
+	void SWRTextureProvider::copy_subimage_from(int offset_x, int offset_y, int x, int y, int width, int height, int level, GraphicContextProvider *gc)
+	{
+		if (level != 0)
+			return;
+
+		if (offset_x < 0 || offset_y < 0 || offset_x + width > data->image.get_width() || offset_y + height > data->image.get_height())
+			throw Exception("Rectangle out of bounds");
+
+		PixelBuffer pixels = static_cast<SWRGraphicContextProvider *>(gc)->get_pixeldata(Rect(x, y, x + width, y + height), TextureFormat::rgba8, false);
+
+		data->flush_pipeline();
+		data->image.set_subimage(pixels, Point(offset_x, offset_y), pixels.get_size());
+	}
+
+	void SWRTextureProvider::set_wrap_mode(TextureWrapMode wrap_s, TextureWrapMode wrap_t, TextureWrapMode wrap_r)
+	{
+		set_wrap_mode(wrap_s, wrap_t);
+	}
+
+	void SWRTextureProvider::set_wrap_mode(TextureWrapMode wrap_s, TextureWrapMode wrap_t)
+	{
+		data->flush_pipeline();
+		data->wrap_s = wrap_s;
+		data->wrap_t = wrap_t;
+	}
+
+	void SWRTextureProvider::set_wrap_mode(TextureWrapMode wrap_s)
+	{
+		data->flush_pipeline();
+		data->wrap_s = wrap_s;
+	}
+
+	void SWRTextureProvider::set_min_filter(TextureFilter filter)
+	{
+		data->flush_pipeline();
+		data->min_filter = filter;
+	}
+
+	void SWRTextureProvider::set_mag_filter(TextureFilter filter)
+	{
+		data->flush_pipeline();
+		data->mag_filter = filter;
+	}
+
+	TextureProvider *SWRTextureProvider::create_view(TextureDimensions texture_dimensions, TextureFormat texture_format, int min_level, int num_levels, int min_layer, int num_layers)
+	{
+		if (min_level != 0 || min_layer != 0 || SWRTextureData::get_storage_format(texture_format) != data->image.get_format())
+			throw Exception("The software renderer only supports texture views of the whole texture in the same format");
+
+		return new SWRTextureProvider(texture_dimensions, data);
+	}
+}
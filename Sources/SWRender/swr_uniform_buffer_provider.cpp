@@ -0,0 +1,51 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "SWRender/precomp.h"
+#include "swr_uniform_buffer_provider.h"
+
+namespace clan
+{
+	SWRUniformBufferProvider::SWRUniformBufferProvider()
+	{
+	}
+
+	SWRUniformBufferProvider::~SWRUniformBufferProvider()
+	{
+	}
+
+	void SWRUniformBufferProvider::create(int size, BufferUsage usage)
+	{
+		create(nullptr, size, usage);
+	}
+
+	void SWRUniformBufferProvider::create(const void *data, int size, BufferUsage usage)
+	{
+		buffer.create(data, size);
+	}
+}
@@ -0,0 +1,282 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/sound_resampler.h"
+#include "API/Core/System/system.h"
+#include <atomic>
+#include <mutex>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		// Positions are stepped in 32.32 fixed point relative to the integer part of the start position,
+		// so long runs do not accumulate floating point error.
+		struct ResamplePosition
+		{
+			ResamplePosition(double position, double step)
+			{
+				base = (int64_t)std::floor(position);
+				fraction = (uint64_t)((position - base) * 4294967296.0);
+				fixed_step = (uint64_t)(step * 4294967296.0 + 0.5);
+			}
+
+			int64_t index(uint64_t pos) const { return base + (int64_t)(pos >> 32); }
+			static float frac(uint64_t pos) { return (float)(uint32_t)(pos >> 8 & 0xffffff) * (1.0f / 16777216.0f); }
+			double to_double(uint64_t pos) const { return base + (double)(pos >> 32) + (double)(uint32_t)pos / 4294967296.0; }
+
+			int64_t base;
+			uint64_t fraction;
+			uint64_t fixed_step;
+		};
+
+		const int sinc_taps = 16;
+		const int sinc_history = 7;
+		const double sinc_cutoff_scale = 0.9;
+		const int sinc_phase_bits = 8;
+		const int sinc_phases = 1 << sinc_phase_bits;
+		const int sinc_cutoff_buckets = 32;
+
+		// One table per cutoff, built on first use. Phase sinc_phases is included so rounding up never needs the next index.
+		std::atomic<float *> sinc_tables[sinc_cutoff_buckets + 1];
+		std::mutex sinc_tables_mutex;
+
+		const float *get_sinc_table(double step)
+		{
+			double cutoff = step > 1.0 ? sinc_cutoff_scale / step : sinc_cutoff_scale;
+			int bucket = (int)(cutoff * sinc_cutoff_buckets + 0.5);
+			if (bucket < 1)
+				bucket = 1;
+
+			float *table = sinc_tables[bucket].load(std::memory_order_acquire);
+			if (table)
+				return table;
+
+			std::unique_lock<std::mutex> lock(sinc_tables_mutex);
+			table = sinc_tables[bucket].load(std::memory_order_relaxed);
+			if (table)
+				return table;
+
+			const double pi = 3.14159265358979323846;
+			double table_cutoff = bucket / (double)sinc_cutoff_buckets;
+			table = static_cast<float *>(System::aligned_alloc(sizeof(float) * sinc_taps * (sinc_phases + 1), 16));
+			for (int phase = 0; phase <= sinc_phases; phase++)
+			{
+				double frac = phase / (double)sinc_phases;
+				double coefficients[sinc_taps];
+				double sum = 0.0;
+				for (int tap = 0; tap < sinc_taps; tap++)
+				{
+					double x = (tap - sinc_history) - frac;
+					double sinc = x == 0.0 ? 1.0 : std::sin(pi * table_cutoff * x) / (pi * table_cutoff * x);
+					double window = 0.42 + 0.5 * std::cos(pi * x / 8.0) + 0.08 * std::cos(2.0 * pi * x / 8.0); // Blackman
+					coefficients[tap] = std::abs(x) < 8.0 ? sinc * window : 0.0;
+					sum += coefficients[tap];
+				}
+				for (int tap = 0; tap < sinc_taps; tap++)
+					table[phase * sinc_taps + tap] = (float)(coefficients[tap] / sum);
+			}
+
+			sinc_tables[bucket].store(table, std::memory_order_release);
+			return table;
+		}
+
+		uint64_t resample_nearest(const float *input, const ResamplePosition &p, float *output, int size)
+		{
+			uint64_t pos = p.fraction;
+			for (int i = 0; i < size; i++, pos += p.fixed_step)
+				output[i] = input[p.index(pos)];
+			return pos;
+		}
+
+		uint64_t resample_linear(const float *input, const ResamplePosition &p, float *output, int size)
+		{
+			uint64_t pos = p.fraction;
+			int i = 0;
+#ifndef CL_DISABLE_SSE2
+			for (; i + 4 <= size; i += 4)
+			{
+				uint64_t pos0 = pos, pos1 = pos0 + p.fixed_step, pos2 = pos1 + p.fixed_step, pos3 = pos2 + p.fixed_step;
+				const float *s0 = input + p.index(pos0), *s1 = input + p.index(pos1), *s2 = input + p.index(pos2), *s3 = input + p.index(pos3);
+
+				__m128 a = _mm_set_ps(s3[0], s2[0], s1[0], s0[0]);
+				__m128 b = _mm_set_ps(s3[1], s2[1], s1[1], s0[1]);
+				__m128 t = _mm_set_ps(ResamplePosition::frac(pos3), ResamplePosition::frac(pos2), ResamplePosition::frac(pos1), ResamplePosition::frac(pos0));
+				_mm_storeu_ps(output + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+
+				pos = pos3 + p.fixed_step;
+			}
+#endif
+			for (; i < size; i++, pos += p.fixed_step)
+			{
+				const float *s = input + p.index(pos);
+				float t = ResamplePosition::frac(pos);
+				output[i] = s[0] + (s[1] - s[0]) * t;
+			}
+			return pos;
+		}
+
+		uint64_t resample_cubic(const float *input, const ResamplePosition &p, float *output, int size)
+		{
+			uint64_t pos = p.fraction;
+			int i = 0;
+#ifndef CL_DISABLE_SSE2
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 two = _mm_set1_ps(2.0f);
+			const __m128 three = _mm_set1_ps(3.0f);
+			const __m128 four = _mm_set1_ps(4.0f);
+			const __m128 five = _mm_set1_ps(5.0f);
+			for (; i + 4 <= size; i += 4)
+			{
+				uint64_t pos0 = pos, pos1 = pos0 + p.fixed_step, pos2 = pos1 + p.fixed_step, pos3 = pos2 + p.fixed_step;
+
+				// Load the four samples around each position and transpose, so each register holds one tap for all four outputs
+				__m128 y0 = _mm_loadu_ps(input + p.index(pos0) - 1);
+				__m128 y1 = _mm_loadu_ps(input + p.index(pos1) - 1);
+				__m128 y2 = _mm_loadu_ps(input + p.index(pos2) - 1);
+				__m128 y3 = _mm_loadu_ps(input + p.index(pos3) - 1);
+				_MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+				__m128 t = _mm_set_ps(ResamplePosition::frac(pos3), ResamplePosition::frac(pos2), ResamplePosition::frac(pos1), ResamplePosition::frac(pos0));
+
+				// y1 + 0.5 * t * (y2 - y0 + t * (2 * y0 - 5 * y1 + 4 * y2 - y3 + t * (3 * (y1 - y2) + y3 - y0)))
+				__m128 c3 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(three, _mm_sub_ps(y1, y2)), y3), y0);
+				__m128 c2 = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, y0), _mm_mul_ps(five, y1)), _mm_mul_ps(four, y2)), y3);
+				__m128 c1 = _mm_sub_ps(y2, y0);
+				__m128 result = _mm_add_ps(c1, _mm_mul_ps(t, _mm_add_ps(c2, _mm_mul_ps(t, c3))));
+				result = _mm_add_ps(y1, _mm_mul_ps(_mm_mul_ps(half, t), result));
+				_mm_storeu_ps(output + i, result);
+
+				pos = pos3 + p.fixed_step;
+			}
+#endif
+			for (; i < size; i++, pos += p.fixed_step)
+			{
+				const float *s = input + p.index(pos) - 1;
+				float t = ResamplePosition::frac(pos);
+				output[i] = s[1] + 0.5f * t * (s[2] - s[0] + t * (2.0f * s[0] - 5.0f * s[1] + 4.0f * s[2] - s[3] + t * (3.0f * (s[1] - s[2]) + s[3] - s[0])));
+			}
+			return pos;
+		}
+
+		uint64_t resample_sinc(const float *input, const ResamplePosition &p, double step, float *output, int size)
+		{
+			const float *table = get_sinc_table(step);
+			const int phase_shift = 32 - sinc_phase_bits;
+			const uint64_t phase_round = ((uint64_t)1) << (phase_shift - 1);
+
+			uint64_t pos = p.fraction;
+			int i = 0;
+#ifndef CL_DISABLE_SSE2
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128 sums[4];
+				for (int lane = 0; lane < 4; lane++, pos += p.fixed_step)
+				{
+					const float *s = input + p.index(pos) - sinc_history;
+					const float *c = table + (((pos & 0xffffffff) + phase_round) >> phase_shift) * sinc_taps;
+					__m128 sum = _mm_mul_ps(_mm_loadu_ps(s), _mm_load_ps(c));
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_load_ps(c + 4)));
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + 8), _mm_load_ps(c + 8)));
+					sums[lane] = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + 12), _mm_load_ps(c + 12)));
+				}
+
+				// Horizontal sums of all four lanes at once
+				_MM_TRANSPOSE4_PS(sums[0], sums[1], sums[2], sums[3]);
+				_mm_storeu_ps(output + i, _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3])));
+			}
+#endif
+			for (; i < size; i++, pos += p.fixed_step)
+			{
+				const float *s = input + p.index(pos) - sinc_history;
+				const float *c = table + (((pos & 0xffffffff) + phase_round) >> phase_shift) * sinc_taps;
+				float sum = 0.0f;
+				for (int tap = 0; tap < sinc_taps; tap++)
+					sum += s[tap] * c[tap];
+				output[i] = sum;
+			}
+			return pos;
+		}
+	}
+
+	int SoundResampler::get_history(SoundResampleMode mode)
+	{
+		switch (mode)
+		{
+		default:
+		case SoundResampleMode::nearest: return 0;
+		case SoundResampleMode::linear: return 0;
+		case SoundResampleMode::cubic: return 1;
+		case SoundResampleMode::sinc: return 7;
+		}
+	}
+
+	int SoundResampler::get_lookahead(SoundResampleMode mode)
+	{
+		switch (mode)
+		{
+		default:
+		case SoundResampleMode::nearest: return 0;
+		case SoundResampleMode::linear: return 1;
+		case SoundResampleMode::cubic: return 2;
+		case SoundResampleMode::sinc: return 8;
+		}
+	}
+
+	double SoundResampler::resample(SoundResampleMode mode, const float *input, double position, double step, float *output, int output_size)
+	{
+		if (output_size <= 0)
+			return position;
+
+		// Rates match and the position is on a sample: nothing to interpolate
+		if (step == 1.0 && position == std::floor(position))
+		{
+			memcpy(output, input + (int64_t)position, sizeof(float) * output_size);
+			return position + output_size;
+		}
+
+		ResamplePosition p(position, step);
+		uint64_t end;
+		switch (mode)
+		{
+		default:
+		case SoundResampleMode::nearest: end = resample_nearest(input, p, output, output_size); break;
+		case SoundResampleMode::linear: end = resample_linear(input, p, output, output_size); break;
+		case SoundResampleMode::cubic: end = resample_cubic(input, p, output, output_size); break;
+		case SoundResampleMode::sinc: end = resample_sinc(input, p, step, output, output_size); break;
+		}
+		return p.to_double(end);
+	}
+}
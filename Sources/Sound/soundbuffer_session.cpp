@@ -211,19 +211,31 @@ namespace clan
 	void SoundBuffer_Session::set_volume(float new_volume)
 	{
 		if (impl)
+		{
 			impl->volume = new_volume;
+			if (!impl->output.is_null())
+				impl->output.impl->queue_command(SoundOutput_Command(SoundOutput_Command::set_volume, impl, (float)new_volume));
+		}
 	}
 
 	void SoundBuffer_Session::set_frequency(int new_frequency)
 	{
 		if (impl)
+		{
 			impl->frequency = new_frequency;
+			if (!impl->output.is_null())
+				impl->output.impl->queue_command(SoundOutput_Command(SoundOutput_Command::set_frequency, impl, (float)new_frequency));
+		}
 	}
 
 	void SoundBuffer_Session::set_pan(float new_pan)
 	{
 		if (impl)
+		{
 			impl->pan = new_pan;
+			if (!impl->output.is_null())
+				impl->output.impl->queue_command(SoundOutput_Command(SoundOutput_Command::set_pan, impl, (float)new_pan));
+		}
 	}
 
 	void SoundBuffer_Session::play()
@@ -265,6 +277,28 @@ namespace clan
 		}
 	}
 
+	void SoundBuffer_Session::set_resample_mode(SoundResampleMode mode)
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			impl->resample_mode = mode;
+		}
+	}
+
+	SoundResampleMode SoundBuffer_Session::get_resample_mode() const
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			return impl->resample_mode;
+		}
+		else
+		{
+			return SoundResampleMode::linear;
+		}
+	}
+
 	void SoundBuffer_Session::add_filter(SoundFilter &filter)
 	{
 		if (impl)
@@ -35,6 +35,7 @@
 #include "API/Sound/SoundProviders/soundprovider.h"
 #include "API/Sound/SoundProviders/soundprovider_session.h"
 #include "API/Core/Text/logger.h"
+#include <algorithm>
 
 namespace clan
 {
@@ -47,13 +48,21 @@ namespace clan
 		provider_session->set_looping(looping);
 		frequency = provider_session->get_frequency();
 
+		mixer_volume = volume;
+		mixer_pan = pan;
+		mixer_frequency = frequency;
+		mixing_frequency = output.is_null() ? 0 : output.get_mixing_frequency();
+
 		num_buffer_samples = 16 * 1024;
 		num_buffer_channels = provider_session->get_num_channels();
-		buffer_position = 0.0;
-		buffer_samples_written = 0;
 
+		// Start after a stretch of silence, so the interpolation has history to read from
+		buffer_position = SoundResampler::max_history;
+		buffer_samples_written = SoundResampler::max_history;
+
+		// Room for the silence appended at the end of the data, plus one sample of rounding slack
 		float_buffer_data = new float*[num_buffer_channels];
-		for (int i = 0; i < num_buffer_channels; i++) float_buffer_data[i] = new float[num_buffer_samples];
+		for (int i = 0; i < num_buffer_channels; i++) float_buffer_data[i] = new float[num_buffer_samples + SoundResampler::max_lookahead + 1]();
 
 		float_buffer_data_offsetted.resize(num_buffer_channels);
 	}
@@ -78,19 +87,37 @@ namespace clan
 		return playing;
 	}
 
-	void SoundBuffer_Session_Impl::get_data()
+	bool SoundBuffer_Session_Impl::get_data()
 	{
 		int num_session_channels = provider_session->get_num_channels();
 		if (num_session_channels != num_buffer_channels)
 		{
 			log_event("mixer", "Number of session channels does not match the number of buffers");
-			return;
+			return false;
+		}
+
+		// Keep the samples the interpolation still needs:
+		int keep_from = std::min(std::max((int)buffer_position - (int)SoundResampler::max_history, 0), buffer_samples_written);
+		if (keep_from > 0)
+		{
+			for (int i = 0; i < num_buffer_channels; i++)
+				memmove(float_buffer_data[i], float_buffer_data[i] + keep_from, sizeof(float) * (buffer_samples_written - keep_from));
+			buffer_samples_written -= keep_from;
+			buffer_position -= keep_from;
+		}
+
+		if (end_of_data)
+		{
+			if (provider_session->eof())
+				return false;
+			end_of_data = false;
 		}
 
+		int samples_kept = buffer_samples_written;
 		if (num_session_channels > 0)
 		{
 			// Copy stream data to working buffer:
-			int samples_left = num_buffer_samples;
+			int samples_left = num_buffer_samples - samples_kept;
 			while (samples_left > 0)
 			{
 				for (int i = 0; i < num_session_channels; i++)
@@ -128,41 +155,60 @@ namespace clan
 
 			buffer_samples_written = num_buffer_samples - samples_left;
 		}
+
+		if (buffer_samples_written == samples_kept)
+		{
+			if (!provider_session->eof())
+				return false;
+
+			// Append silence so the interpolation can reach the last samples
+			int lookahead = SoundResampler::get_lookahead(resample_mode);
+			for (int i = 0; i < num_buffer_channels; i++)
+				memset(float_buffer_data[i] + buffer_samples_written, 0, sizeof(float) * lookahead);
+			buffer_samples_written += lookahead;
+			end_of_data = true;
+		}
+		return true;
 	}
 
 	void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data)
 	{
 		// Convert from session frequency to mixer frequency:
-		// This is done by copying data from the temporary session buffers (buffer_data) to
-		// the temporary mixing buffers (temp_data), and if buffer_data is exhausted, calling
-		// get_data() to fill it with new data from the soundprovider session object.
-		double speed = frequency / double(output.get_mixing_frequency());
-		int sample_count;
-		for (sample_count = 0; sample_count < num_samples; sample_count++)
+		// This is done by interpolating data from the temporary session buffers (buffer_data) into
+		// the temporary mixing buffers (temp_data), and if the interpolation would read past the
+		// buffered data, calling get_data() to fill it with new data from the soundprovider session object.
+		double speed = mixing_frequency > 0 ? mixer_frequency / double(mixing_frequency) : 0.0;
+		int lookahead = SoundResampler::get_lookahead(resample_mode);
+		int sample_count = 0;
+		while (sample_count < num_samples)
 		{
-			if (buffer_position < buffer_samples_written)
+			int samples_left = num_samples - sample_count;
+			double last_position = buffer_samples_written - 1 - lookahead;
+			int available = 0;
+			if (buffer_position <= last_position)
 			{
+				double count = speed > 0.0 ? (last_position - buffer_position) / speed + 1.0 : samples_left;
+				available = count >= samples_left ? samples_left : (int)count;
+			}
+
+			if (available > 0)
+			{
+				double end_position = buffer_position;
 				for (int chan = 0; chan < num_buffer_channels; chan++)
-				{
-					temp_data[chan][sample_count] = float_buffer_data[chan][int(buffer_position)];
-				}
+					end_position = SoundResampler::resample(resample_mode, float_buffer_data[chan], buffer_position, speed, temp_data[chan] + sample_count, available);
+				buffer_position = end_position;
+				sample_count += available;
 			}
-			else
+			else if (end_of_data && provider_session->eof())
 			{
-				if (provider_session->eof())
-				{
-					playing = false;
-					break;
-				}
-
-				// Out of data, get more from provider:
-				buffer_position -= buffer_samples_written;
-				get_data();
-				sample_count--;
-				continue;
+				playing = false;
+				break;
+			}
+			else if (!get_data())
+			{
+				// Out of data, and the provider has nothing more right now
+				break;
 			}
-
-			buffer_position += speed;
 		}
 
 		// Clear the remaining samples (if any)
@@ -185,8 +231,9 @@ namespace clan
 
 	void SoundBuffer_Session_Impl::get_channel_volume(float *channel_volume)
 	{
-		float left_pan = 1 - pan;
-		float right_pan = 1 + pan;
+		float volume = mixer_volume;
+		float left_pan = 1 - mixer_pan;
+		float right_pan = 1 + mixer_pan;
 		if (left_pan < 0.0f) left_pan = 0.0f;
 		if (left_pan > 1.0f) left_pan = 1.0f;
 		if (right_pan < 0.0f) right_pan = 0.0f;
@@ -32,6 +32,7 @@
 #include "API/Sound/soundformat.h"
 #include "API/Sound/soundoutput.h"
 #include "API/Sound/soundbuffer.h"
+#include "API/Sound/sound_resampler.h"
 #include <memory>
 #include <mutex>
 
@@ -60,9 +61,20 @@ namespace clan
 		float pan;
 		bool looping;
 		bool playing;
+		SoundResampleMode resample_mode = SoundResampleMode::linear;
 		std::vector<SoundFilter> filters;
 		mutable std::recursive_mutex mutex;
 
+		/// \brief Volume, panning and frequency used by the mixer thread.
+		///
+		/// Only touched by the mixer thread. Changes arrive through the output command queue.
+		float mixer_volume;
+		float mixer_pan;
+		float mixer_frequency;
+
+		/// \brief Index in the mixer session list, or -1 if not being mixed. Only touched by the mixer thread.
+		int mixer_index = -1;
+
 		bool mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels);
 
 	private:
@@ -78,8 +90,10 @@ namespace clan
 		/// \brief Runs the sample data through attached filters
 		void run_filters(float ** temp_data, int num_samples);
 
-		/// \brief Fills temporary buffers with data from provider.
-		void get_data();
+		/// \brief Moves the samples still needed to the front of the temporary buffers and fills the rest with data from provider.
+		///
+		/// Returns false if the provider had no data.
+		bool get_data();
 
 		/// \brief Temporary channel buffers containing sound data in provider frequency.
 		float **float_buffer_data;
@@ -97,5 +111,11 @@ namespace clan
 
 		/// \brief Number of samples currently written to buffer_data.
 		int buffer_samples_written;
+
+		/// \brief Frequency of the output mixer.
+		int mixing_frequency;
+
+		/// \brief True when the provider reached its end and silence was appended for the interpolation to read.
+		bool end_of_data = false;
 	};
 }
@@ -33,6 +33,8 @@
 #include "API/Sound/sound.h"
 #include "soundoutput_impl.h"
 #include "setupsound.h"
+#include "soundoutput_offline.h"
+#include <algorithm>
 
 #ifdef WIN32
 #include "Platform/Win32/soundoutput_win32.h"
@@ -66,6 +68,13 @@ namespace clan
 	SoundOutput::SoundOutput(const SoundOutput_Description &desc)
 	{
 		SetupSound::start();
+		if (desc.is_offline())
+		{
+			impl = std::make_shared<SoundOutput_Offline>(desc.get_mixing_frequency(), desc.get_mixing_latency(), desc.get_offline_filename());
+			Sound::select_output(*this);
+			return;
+		}
+
 #ifdef WIN32
 		try
 		{
@@ -154,6 +163,28 @@ namespace clan
 		return impl->pan;
 	}
 
+	int SoundOutput::get_mixing_threads() const
+	{
+		return impl->mixing_threads;
+	}
+
+	SoundOutput_Statistics SoundOutput::get_statistics() const
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+		return impl->statistics;
+	}
+
+	void SoundOutput::reset_statistics()
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+		impl->statistics = SoundOutput_Statistics();
+	}
+
+	void SoundOutput::render(float *out_samples, int num_samples)
+	{
+		impl->render(out_samples, num_samples);
+	}
+
 	void SoundOutput::stop_all()
 	{
 	}
@@ -176,6 +207,12 @@ namespace clan
 		}
 	}
 
+	void SoundOutput::set_mixing_threads(int count)
+	{
+		if (impl)
+			impl->mixing_threads = std::max(count, 1);
+	}
+
 	void SoundOutput::add_filter(SoundFilter &filter)
 	{
 		if (impl)
@@ -0,0 +1,140 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundoutput_command_queue.h"
+#include "soundbuffer_session_impl.h"
+#include <thread>
+
+namespace clan
+{
+	SoundOutput_CommandQueue::SoundOutput_CommandQueue(int capacity)
+		: enqueue_pos(0), dequeue_pos(0), overflow_active(false), overflow_popped_pos(0), overflow_ring_end(0)
+	{
+		size_t size = 1;
+		while (size < (size_t)capacity)
+			size <<= 1;
+
+		slots.reset(new Slot[size]);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	void SoundOutput_CommandQueue::push(SoundOutput_Command command)
+	{
+		if (!overflow_active.load(std::memory_order_acquire) && try_push(command))
+			return;
+
+		std::unique_lock<std::mutex> lock(overflow_mutex);
+
+		// The mixer may have drained the overflow list since we looked
+		if (!overflow_active.load(std::memory_order_relaxed) && try_push(command))
+			return;
+
+		overflow.push_back(std::move(command));
+		overflow_active.store(true, std::memory_order_release);
+	}
+
+	bool SoundOutput_CommandQueue::try_push(SoundOutput_Command &command)
+	{
+		size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		Slot *slot;
+		while (true)
+		{
+			slot = &slots[pos & mask];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->command = std::move(command);
+		slot->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool SoundOutput_CommandQueue::pop(SoundOutput_Command &out_command)
+	{
+		while (true)
+		{
+			if (overflow_popped_pos < overflow_popped.size())
+			{
+				// Commands that made it into the ring before the overflow list was taken come first
+				if (dequeue_pos < overflow_ring_end)
+				{
+					while (!try_pop(out_command))
+						std::this_thread::yield();
+					return true;
+				}
+
+				out_command = std::move(overflow_popped[overflow_popped_pos]);
+				overflow_popped[overflow_popped_pos++] = SoundOutput_Command();
+				return true;
+			}
+
+			if (try_pop(out_command))
+				return true;
+
+			// Ring is empty. Continue with the commands that did not fit in it:
+			overflow_popped.clear();
+			overflow_popped_pos = 0;
+			if (!overflow_active.load(std::memory_order_acquire))
+				return false;
+
+			std::unique_lock<std::mutex> lock(overflow_mutex);
+			overflow_popped.swap(overflow);
+			overflow_ring_end = enqueue_pos.load(std::memory_order_relaxed);
+			overflow_active.store(false, std::memory_order_release);
+		}
+	}
+
+	bool SoundOutput_CommandQueue::try_pop(SoundOutput_Command &out_command)
+	{
+		Slot *slot = &slots[dequeue_pos & mask];
+		if (slot->sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+			return false;
+
+		out_command = std::move(slot->command);
+		slot->command = SoundOutput_Command();
+		slot->sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+		dequeue_pos++;
+		return true;
+	}
+}
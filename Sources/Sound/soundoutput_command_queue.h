@@ -0,0 +1,98 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace clan
+{
+	class SoundBuffer_Session_Impl;
+
+	/// \brief Session change requested from an application thread, applied by the mixer thread
+	struct SoundOutput_Command
+	{
+		enum Type
+		{
+			play,
+			stop,
+			set_volume,
+			set_pan,
+			set_frequency
+		};
+
+		SoundOutput_Command() { }
+		SoundOutput_Command(Type type, std::shared_ptr<SoundBuffer_Session_Impl> session, float value = 0.0f) : type(type), session(std::move(session)), value(value) { }
+
+		Type type = play;
+		std::shared_ptr<SoundBuffer_Session_Impl> session;
+		float value = 0.0f;
+	};
+
+	/// \brief Bounded multi-producer, single-consumer command ring
+	///
+	/// Any thread may push, only the mixer thread may pop. Pushing and popping never block each
+	/// other. If the ring is full, commands go to an overflow list under a mutex until the mixer
+	/// has drained it, so commands from one thread are always popped in the order they were pushed.
+	class SoundOutput_CommandQueue
+	{
+	public:
+		SoundOutput_CommandQueue(int capacity = 1024);
+
+		/// \brief Adds a command to the queue
+		void push(SoundOutput_Command command);
+
+		/// \brief Removes the oldest command from the queue. Returns false if it is empty.
+		bool pop(SoundOutput_Command &out_command);
+
+	private:
+		bool try_push(SoundOutput_Command &command);
+		bool try_pop(SoundOutput_Command &out_command);
+
+		struct Slot
+		{
+			std::atomic<size_t> sequence;
+			SoundOutput_Command command;
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		size_t mask;
+		std::atomic<size_t> enqueue_pos;
+		size_t dequeue_pos;
+
+		std::atomic_bool overflow_active;
+		std::mutex overflow_mutex;
+		std::vector<SoundOutput_Command> overflow;
+		std::vector<SoundOutput_Command> overflow_popped;
+		size_t overflow_popped_pos;
+		size_t overflow_ring_end;
+	};
+}
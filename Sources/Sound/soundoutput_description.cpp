@@ -36,6 +36,8 @@ namespace clan
 	public:
 		int mixing_frequency;
 		int mixing_latency;
+		bool offline = false;
+		std::string offline_filename;
 	};
 
 	SoundOutput_Description::SoundOutput_Description() : impl(std::make_shared<SoundOutput_Description_Impl>())
@@ -58,6 +60,16 @@ namespace clan
 		return impl->mixing_latency;
 	}
 
+	bool SoundOutput_Description::is_offline() const
+	{
+		return impl->offline;
+	}
+
+	const std::string &SoundOutput_Description::get_offline_filename() const
+	{
+		return impl->offline_filename;
+	}
+
 	void SoundOutput_Description::set_mixing_frequency(int frequency)
 	{
 		impl->mixing_frequency = frequency;
@@ -67,4 +79,14 @@ namespace clan
 	{
 		impl->mixing_latency = latency;
 	}
+
+	void SoundOutput_Description::set_offline(bool offline)
+	{
+		impl->offline = offline;
+	}
+
+	void SoundOutput_Description::set_offline_filename(const std::string &filename)
+	{
+		impl->offline_filename = filename;
+	}
 }
@@ -30,7 +30,9 @@
 #include "soundoutput_impl.h"
 #include "soundbuffer_session_impl.h"
 #include "API/Sound/soundfilter.h"
+#include "API/Core/System/work_queue.h"
 #include <algorithm>
+#include <chrono>
 #include "API/Sound/sound_sse.h"
 
 namespace clan
@@ -40,7 +42,7 @@ namespace clan
 
 	SoundOutput_Impl::SoundOutput_Impl(int mixing_frequency, int latency)
 		: mixing_frequency(mixing_frequency), mixing_latency(latency), volume(1.0f),
-		pan(0.0f), mix_buffer_size(0)
+		pan(0.0f), mixing_threads(1), mix_buffer_size(0)
 	{
 		mix_buffers[0] = nullptr;
 		mix_buffers[1] = nullptr;
@@ -69,22 +71,22 @@ namespace clan
 
 	void SoundOutput_Impl::play_session(SoundBuffer_Session &session)
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
-		sessions.push_back(session);
+		queue_command(SoundOutput_Command(SoundOutput_Command::play, session.impl));
 	}
 
 	void SoundOutput_Impl::stop_session(SoundBuffer_Session &session)
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		queue_command(SoundOutput_Command(SoundOutput_Command::stop, session.impl));
+	}
 
-		for (auto it = sessions.begin(); it != sessions.end(); ++it)
-		{
-			if (session.impl.get() == it->impl.get())
-			{
-				sessions.erase(it);
-				break;
-			}
-		}
+	void SoundOutput_Impl::queue_command(SoundOutput_Command command)
+	{
+		commands.push(std::move(command));
+	}
+
+	void SoundOutput_Impl::render(float *out_samples, int num_samples)
+	{
+		throw Exception("Only offline sound outputs can be rendered");
 	}
 
 	void SoundOutput_Impl::start_mixer_thread()
@@ -105,13 +107,30 @@ namespace clan
 
 	void SoundOutput_Impl::mix_fragment()
 	{
+		typedef std::chrono::steady_clock clock;
+		auto start_time = clock::now();
+
 		resize_mix_buffers();
 		clear_mix_buffers();
+		process_commands();
 		fill_mix_buffers();
+		auto fill_time = clock::now();
 		filter_mix_buffers();
+		auto filter_time = clock::now();
 		apply_master_volume_on_mix_buffers();
+		auto volume_time = clock::now();
 		clamp_mix_buffers();
+		auto clamp_time = clock::now();
 		SoundSSE::pack_float_stereo(mix_buffers, mix_buffer_size, stereo_buffer);
+		auto end_time = clock::now();
+
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		statistics.samples_mixed += mix_buffer_size;
+		statistics.total_time += std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		statistics.fill_time += std::chrono::duration_cast<std::chrono::nanoseconds>(fill_time - start_time).count();
+		statistics.filter_time += std::chrono::duration_cast<std::chrono::nanoseconds>(filter_time - fill_time).count();
+		statistics.volume_time += std::chrono::duration_cast<std::chrono::nanoseconds>(volume_time - filter_time).count();
+		statistics.clamp_time += std::chrono::duration_cast<std::chrono::nanoseconds>(clamp_time - volume_time).count();
 	}
 
 	void SoundOutput_Impl::mixer_thread()
@@ -158,6 +177,8 @@ namespace clan
 			temp_buffers[1] = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
 			stereo_buffer = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size * 2);
 			SoundSSE::set_float(stereo_buffer, mix_buffer_size * 2, 0.0f);
+
+			jobs.clear();
 		}
 	}
 
@@ -168,21 +189,122 @@ namespace clan
 		SoundSSE::set_float(mix_buffers[1], mix_buffer_size, 0.0f);
 	}
 
+	void SoundOutput_Impl::process_commands()
+	{
+		SoundOutput_Command command;
+		while (commands.pop(command))
+		{
+			SoundBuffer_Session_Impl *session = command.session.get();
+			switch (command.type)
+			{
+			case SoundOutput_Command::play:
+				if (session->mixer_index == -1)
+				{
+					session->mixer_index = (int)sessions.size();
+					sessions.push_back(std::move(command.session));
+				}
+				break;
+
+			case SoundOutput_Command::stop:
+				if (session->mixer_index != -1)
+					remove_session(session->mixer_index);
+				break;
+
+			case SoundOutput_Command::set_volume:
+				session->mixer_volume = command.value;
+				break;
+
+			case SoundOutput_Command::set_pan:
+				session->mixer_pan = command.value;
+				break;
+
+			case SoundOutput_Command::set_frequency:
+				session->mixer_frequency = command.value;
+				break;
+			}
+		}
+	}
+
 	void SoundOutput_Impl::fill_mix_buffers()
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
-		std::vector< SoundBuffer_Session > ended_sessions;
-		std::vector< SoundBuffer_Session >::iterator it;
-		for (it = sessions.begin(); it != sessions.end(); ++it)
+		int num_sessions = sessions.size();
+		sessions_ended.assign(num_sessions, 0);
+
+		int num_jobs = std::min(mixing_threads.load(), (num_sessions + min_sessions_per_job - 1) / min_sessions_per_job);
+		if (num_jobs > 1)
+		{
+			if (!work_queue)
+				work_queue.reset(new WorkQueue());
+			while ((int)jobs.size() < num_jobs - 1)
+				jobs.push_back(std::unique_ptr<MixerJob>(new MixerJob(mix_buffer_size)));
+
+			// The mixer thread mixes the first share directly into the mixing buffers while the workers mix the rest into their own
+			WorkGroup group(*work_queue);
+			for (int job = 1; job < num_jobs; job++)
+			{
+				MixerJob *job_buffers = jobs[job - 1].get();
+				SoundSSE::set_float(job_buffers->mix_buffers[0], mix_buffer_size, 0.0f);
+				SoundSSE::set_float(job_buffers->mix_buffers[1], mix_buffer_size, 0.0f);
+				group.run([=]() { mix_sessions(job, num_jobs, job_buffers->mix_buffers, job_buffers->temp_buffers); });
+			}
+			mix_sessions(0, num_jobs, mix_buffers, temp_buffers);
+			group.wait();
+
+			// Sum in a fixed order so the result does not depend on thread timing
+			for (int job = 1; job < num_jobs; job++)
+			{
+				SoundSSE::mix_one_to_one(jobs[job - 1]->mix_buffers[0], mix_buffer_size, mix_buffers[0], 1.0f);
+				SoundSSE::mix_one_to_one(jobs[job - 1]->mix_buffers[1], mix_buffer_size, mix_buffers[1], 1.0f);
+			}
+		}
+		else
+		{
+			mix_sessions(0, 1, mix_buffers, temp_buffers);
+		}
+
+		// Release any sessions that ended:
+		for (int i = num_sessions - 1; i >= 0; i--)
+		{
+			if (sessions_ended[i])
+				remove_session(i);
+		}
+	}
+
+	void SoundOutput_Impl::remove_session(int index)
+	{
+		sessions[index]->mixer_index = -1;
+		if (index + 1 != (int)sessions.size())
+		{
+			sessions[index] = std::move(sessions.back());
+			sessions[index]->mixer_index = index;
+		}
+		sessions.pop_back();
+	}
+
+	void SoundOutput_Impl::mix_sessions(int first, int num_jobs, float **job_mix_buffers, float **job_temp_buffers)
+	{
+		int num_sessions = sessions.size();
+		for (int i = first; i < num_sessions; i += num_jobs)
 		{
-			SoundBuffer_Session session = *it;
-			bool playing = session.impl->mix_to(mix_buffers, temp_buffers, mix_buffer_size, 2);
-			if (!playing) ended_sessions.push_back(session);
+			bool playing = sessions[i]->mix_to(job_mix_buffers, job_temp_buffers, mix_buffer_size, 2);
+			if (!playing) sessions_ended[i] = 1;
 		}
+	}
 
-		// Release any sessions pending for removal:
-		int size_ended_sessions = ended_sessions.size();
-		for (int i = 0; i < size_ended_sessions; i++) stop_session(ended_sessions[i]);
+	SoundOutput_Impl::MixerJob::MixerJob(int size)
+	{
+		mix_buffers[0] = (float *)SoundSSE::aligned_alloc(sizeof(float) * size);
+		mix_buffers[1] = (float *)SoundSSE::aligned_alloc(sizeof(float) * size);
+		temp_buffers[0] = (float *)SoundSSE::aligned_alloc(sizeof(float) * size);
+		temp_buffers[1] = (float *)SoundSSE::aligned_alloc(sizeof(float) * size);
+	}
+
+	SoundOutput_Impl::MixerJob::~MixerJob()
+	{
+		SoundSSE::aligned_free(mix_buffers[0]);
+		SoundSSE::aligned_free(mix_buffers[1]);
+		SoundSSE::aligned_free(temp_buffers[0]);
+		SoundSSE::aligned_free(temp_buffers[1]);
 	}
 
 	void SoundOutput_Impl::filter_mix_buffers()
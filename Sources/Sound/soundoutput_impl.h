@@ -34,12 +34,15 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include "soundoutput_command_queue.h"
+#include "API/Sound/soundoutput.h"
 
 namespace clan
 {
 	class SoundFilter;
 	class SoundBuffer_Session_Impl;
 	class SoundBuffer_Session;
+	class WorkQueue;
 
 	class SoundOutput_Impl
 	{
@@ -50,6 +53,12 @@ namespace clan
 		void play_session(SoundBuffer_Session &session);
 		void stop_session(SoundBuffer_Session &session);
 
+		/// \brief Queues a session change for the mixer thread. Never blocks on the mixer.
+		void queue_command(SoundOutput_Command command);
+
+		/// \brief Mixes samples on the calling thread. Only supported by offline outputs.
+		virtual void render(float *out_samples, int num_samples);
+
 	protected:
 		std::string name;
 		int mixing_frequency;
@@ -59,7 +68,8 @@ namespace clan
 		std::vector<SoundFilter> filters;
 		std::thread thread;
 		std::atomic_bool stop_flag;
-		std::vector< SoundBuffer_Session > sessions;
+		std::atomic_int mixing_threads;
+		SoundOutput_Statistics statistics;
 
 		int mix_buffer_size;
 		float *mix_buffers[2];
@@ -94,6 +104,9 @@ namespace clan
 		/// \brief Mixes a single fragment and stores the result in stereo_buffer.
 		void mix_fragment();
 
+		/// \brief Applies the session changes queued since the last fragment
+		void process_commands();
+
 	private:
 		/// \brief Worker thread for output device. Mixes the audio and sends it to write_fragment.
 		void mixer_thread();
@@ -110,6 +123,12 @@ namespace clan
 		/// \brief Mixes soundbuffer sessions into the mixing buffers
 		void fill_mix_buffers();
 
+		/// \brief Removes a session from the list of sessions being mixed
+		void remove_session(int index);
+
+		/// \brief Mixes every num_jobs'th session, starting with session first, into the specified buffers
+		void mix_sessions(int first, int num_jobs, float **job_mix_buffers, float **job_temp_buffers);
+
 		/// \brief Applies filters to the mixing buffers
 		void filter_mix_buffers();
 
@@ -124,6 +143,27 @@ namespace clan
 
 		mutable std::recursive_mutex mutex;
 
+		/// \brief Mixing buffers of a worker thread when mixing in parallel
+		struct MixerJob
+		{
+			MixerJob(int size);
+			~MixerJob();
+
+			float *mix_buffers[2];
+			float *temp_buffers[2];
+		};
+
+		/// \brief Sessions currently being mixed. Only accessed by the mixer thread.
+		std::vector<std::shared_ptr<SoundBuffer_Session_Impl>> sessions;
+		std::vector<char> sessions_ended;
+		SoundOutput_CommandQueue commands;
+
+		std::unique_ptr<WorkQueue> work_queue;
+		std::vector<std::unique_ptr<MixerJob>> jobs;
+
+		/// \brief Fewest sessions worth handing to a worker thread
+		static const int min_sessions_per_job = 16;
+
 		friend class SoundOutput;
 	};
 }
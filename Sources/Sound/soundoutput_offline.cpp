@@ -0,0 +1,116 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundoutput_offline.h"
+#include "API/Sound/sound_sse.h"
+#include <cstring>
+
+namespace clan
+{
+	SoundOutput_Offline::SoundOutput_Offline(int mixing_frequency, int mixing_latency, const std::string &filename)
+		: SoundOutput_Impl(mixing_frequency, mixing_latency)
+	{
+		name = "Offline";
+		fragment_size = std::max(mixing_frequency * mixing_latency / 1000, 1);
+
+		if (!filename.empty())
+		{
+			file = File(filename, File::create_always, File::access_write);
+			write_wav = true;
+			write_wav_header();
+		}
+	}
+
+	SoundOutput_Offline::~SoundOutput_Offline()
+	{
+		if (write_wav)
+		{
+			file.seek(0);
+			write_wav_header();
+		}
+	}
+
+	void SoundOutput_Offline::render(float *out_samples, int num_samples)
+	{
+		// Apply session changes right away, so stopped sessions are released even if no new fragment is mixed
+		process_commands();
+
+		while (num_samples > 0)
+		{
+			if (fragment_samples_left == 0)
+			{
+				mix_fragment();
+				write_fragment(stereo_buffer);
+				fragment_samples_left = fragment_size;
+			}
+
+			int count = std::min(num_samples, fragment_samples_left);
+			if (out_samples)
+			{
+				memcpy(out_samples, stereo_buffer + (fragment_size - fragment_samples_left) * 2, sizeof(float) * 2 * count);
+				out_samples += count * 2;
+			}
+			fragment_samples_left -= count;
+			num_samples -= count;
+		}
+	}
+
+	void SoundOutput_Offline::write_fragment(float *data)
+	{
+		if (!write_wav)
+			return;
+
+		pcm_buffer.resize(mix_buffer_size * 2);
+		SoundSSE::pack_16bit_stereo(mix_buffers, mix_buffer_size, pcm_buffer.data());
+		file.write(pcm_buffer.data(), pcm_buffer.size() * sizeof(short));
+		data_size += pcm_buffer.size() * sizeof(short);
+	}
+
+	void SoundOutput_Offline::write_wav_header()
+	{
+		const int channels = 2;
+		const int bits = 16;
+
+		file.write("RIFF", 4);
+		file.write_uint32(36 + data_size);
+		file.write("WAVE", 4);
+
+		file.write("fmt ", 4);
+		file.write_uint32(16);
+		file.write_uint16(1); // PCM
+		file.write_uint16(channels);
+		file.write_uint32(mixing_frequency);
+		file.write_uint32(mixing_frequency * channels * bits / 8);
+		file.write_uint16(channels * bits / 8);
+		file.write_uint16(bits);
+
+		file.write("data", 4);
+		file.write_uint32(data_size);
+	}
+}
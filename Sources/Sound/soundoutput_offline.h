@@ -0,0 +1,65 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "soundoutput_impl.h"
+#include "API/Core/IOData/file.h"
+
+namespace clan
+{
+	/// \brief Sound output without a device, mixing only when asked to render
+	class SoundOutput_Offline : public SoundOutput_Impl
+	{
+	public:
+		SoundOutput_Offline(int mixing_frequency, int mixing_latency, const std::string &filename);
+		~SoundOutput_Offline();
+
+		void render(float *out_samples, int num_samples) override;
+
+	protected:
+		void silence() override { }
+		int get_fragment_size() override { return fragment_size; }
+		void write_fragment(float *data) override;
+		void wait() override { }
+
+	private:
+		/// \brief Writes the WAV header, with the sizes of the data written so far
+		void write_wav_header();
+
+		int fragment_size;
+
+		/// \brief Samples of the last mixed fragment not yet returned by render
+		int fragment_samples_left = 0;
+
+		bool write_wav = false;
+		File file;
+		uint32_t data_size = 0;
+		std::vector<short> pcm_buffer;
+	};
+}
@@ -41,6 +41,11 @@
 namespace clan
 {
 	Image Image::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc)
+	{
+		return Image::load(canvas, id, doc, [&](const std::string &filename, const FileSystem &fs) { return Texture2D(canvas, filename, fs); });
+	}
+
+	Image Image::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(const std::string &filename, const FileSystem &fs)> &load_texture)
 	{
 		Image image;
 
@@ -60,7 +65,7 @@ namespace clan
 			if (tag_name == "image" || tag_name == "image-file")
 			{
 				std::string image_name = cur_element.get_attribute("file");
-				Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), image_name), resource.get_file_system());
+				Texture2D texture = load_texture(PathHelp::combine(resource.get_base_path(), image_name), resource.get_file_system());
 
 				DomNode cur_child(cur_element.get_first_child());
 				if (cur_child.is_null())
@@ -42,6 +42,11 @@
 namespace clan
 {
 	Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc)
+	{
+		return Sprite::load(canvas, id, doc, [&](const std::string &filename, const FileSystem &fs) { return Texture2D(canvas, filename, fs); });
+	}
+
+	Sprite Sprite::load(Canvas &canvas, const std::string &id, const XMLResourceDocument &doc, const std::function<Texture2D(const std::string &filename, const FileSystem &fs)> &load_texture)
 	{
 		Sprite sprite(canvas);
 
@@ -105,7 +110,7 @@ namespace clan
 
 						try
 						{
-							Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), file_name), fs);
+							Texture2D texture = load_texture(PathHelp::combine(resource.get_base_path(), file_name), fs);
 							sprite.add_frame(texture);
 							found_initial = true;
 						}
@@ -125,7 +130,7 @@ namespace clan
 				{
 					std::string image_name = cur_element.get_attribute("file");
 					FileSystem fs = resource.get_file_system();
-					Texture2D texture = Texture2D(canvas, PathHelp::combine(resource.get_base_path(), image_name), fs);
+					Texture2D texture = load_texture(PathHelp::combine(resource.get_base_path(), image_name), fs);
 
 					DomNode cur_child(cur_element.get_first_child());
 					if (cur_child.is_null())
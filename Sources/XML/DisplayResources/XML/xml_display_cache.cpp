@@ -43,6 +43,7 @@
 #include "xml_display_cache.h"
 #include "API/XML/Resources/resource_factory.h"
 #include "API/XML/Resources/xml_resource_manager.h"
+#include "API/XML/Resources/xml_resource_node.h"
 
 namespace clan
 {
@@ -72,6 +73,9 @@ namespace clan
 		auto it = sprites.find(id);
 		if (it != sprites.end())
 		{
+			if (preloading.find(id) != preloading.end())
+				return it->second;
+
 			Resource<Sprite> sprite = it->second;
 			sprite.get() = sprite.get().clone();
 			return sprite;
@@ -88,6 +92,9 @@ namespace clan
 		auto it = images.find(id);
 		if (it != images.end())
 		{
+			if (preloading.find(id) != preloading.end())
+				return it->second;
+
 			Resource<Image> image = it->second;
 			image.get() = image.get().clone();
 			return image;
@@ -143,4 +150,94 @@ namespace clan
 
 		return font;
 	}
+
+	void XMLDisplayCache::preload(const std::vector<std::string> &ids, WorkQueue &queue, const std::function<void(const DisplayPreloadProgress &)> &progress)
+	{
+		preloader.set_progress_callback(progress);
+		for (const auto &id : ids)
+		{
+			XMLResourceNode resource = doc.get_resource(id);
+			std::string type = resource.get_type();
+
+			std::vector<std::string> files;
+			if (type == "sprite" && sprites.find(id) == sprites.end())
+			{
+				sprites[id] = Resource<Sprite>();
+				files = get_image_files(resource);
+			}
+			else if (type == "image" && images.find(id) == images.end())
+			{
+				images[id] = Resource<Image>();
+				files = get_image_files(resource);
+			}
+			else if (type == "texture" && textures.find(id) == textures.end())
+			{
+				textures[id] = Resource<Texture>();
+				files.push_back(PathHelp::combine(resource.get_base_path(), resource.get_element().get_attribute("file")));
+			}
+			else
+			{
+				continue;
+			}
+
+			preloading.insert(id);
+			preloader.add(queue, resource.get_file_system(), files, [this, id, type]() { preload_completed(id, type); });
+		}
+	}
+
+	DisplayPreloadProgress XMLDisplayCache::update_preload(Canvas &canvas, int budget_microseconds)
+	{
+		preload_canvas = &canvas;
+		return preloader.update(canvas, budget_microseconds);
+	}
+
+	std::vector<std::string> XMLDisplayCache::get_image_files(XMLResourceNode resource)
+	{
+		// File sequences are left out, as the number of files is only found by loading them
+		std::vector<std::string> files;
+		for (DomNode cur_node = resource.get_element().get_first_child(); !cur_node.is_null(); cur_node = cur_node.get_next_sibling())
+		{
+			if (!cur_node.is_element())
+				continue;
+
+			DomElement cur_element = cur_node.to_element();
+			std::string tag_name = cur_element.get_tag_name();
+			if ((tag_name == "image" || tag_name == "image-file") && cur_element.has_attribute("file"))
+				files.push_back(PathHelp::combine(resource.get_base_path(), cur_element.get_attribute("file")));
+		}
+		return files;
+	}
+
+	void XMLDisplayCache::preload_completed(const std::string &id, const std::string &type)
+	{
+		preloading.erase(id);
+
+		Canvas &canvas = *preload_canvas;
+		auto load_texture = [&](const std::string &filename, const FileSystem &fs) { return preloader.get_texture(canvas, filename, fs); };
+
+		try
+		{
+			if (type == "sprite")
+			{
+				sprites[id].set(Sprite::load(canvas, id, doc, load_texture));
+			}
+			else if (type == "image")
+			{
+				images[id].set(Image::load(canvas, id, doc, load_texture));
+			}
+			else
+			{
+				XMLResourceNode resource = doc.get_resource(id);
+				textures[id].set(load_texture(PathHelp::combine(resource.get_base_path(), resource.get_element().get_attribute("file")), resource.get_file_system()));
+			}
+		}
+		catch (...)
+		{
+			// Leave it to the next get call to load and report the error
+			sprites.erase(id);
+			images.erase(id);
+			textures.erase(id);
+			throw;
+		}
+	}
 }
@@ -29,7 +29,9 @@
 #pragma once
 
 #include "API/Display/Resources/display_cache.h"
+#include "API/Display/Resources/texture_preloader.h"
 #include "API/XML/Resources/xml_resource_document.h"
+#include <set>
 
 namespace clan
 {
@@ -46,11 +48,21 @@ namespace clan
 		Resource<Texture> get_texture(GraphicContext &gc, const std::string &id) override;
 		Resource<Font> get_font(Canvas &canvas, const std::string &family_name, const FontDescription &desc) override;
 
+		void preload(const std::vector<std::string> &ids, WorkQueue &queue, const std::function<void(const DisplayPreloadProgress &)> &progress) override;
+		DisplayPreloadProgress update_preload(Canvas &canvas, int budget_microseconds) override;
+
 		static void add_cache_factory(ResourceManager &manager, const XMLResourceDocument &doc);
 
 	private:
+		static std::vector<std::string> get_image_files(XMLResourceNode resource);
+		void preload_completed(const std::string &id, const std::string &type);
+
 		XMLResourceDocument doc;
 
+		TexturePreloader preloader;
+		std::set<std::string> preloading;
+		Canvas *preload_canvas = nullptr;
+
 		std::map<std::string, Resource<Sprite> > sprites;
 		std::map<std::string, Resource<Image> > images;
 		std::map<std::string, Resource<Texture> > textures;
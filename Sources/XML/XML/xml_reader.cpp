@@ -0,0 +1,719 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "XML/precomp.h"
+#include "API/XML/xml_reader.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Text/string_format.h"
+#include "API/Core/Text/string_help.h"
+#include "xml_reader_impl.h"
+#include <algorithm>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		struct XMLCharClasses
+		{
+			XMLCharClasses()
+			{
+				memset(classes, 0, sizeof(classes));
+				for (unsigned char c : std::string(" \r\n\t"))
+					classes[c] |= XMLReader_Impl::char_whitespace | XMLReader_Impl::char_name_end | XMLReader_Impl::char_attribute_name_end;
+				for (unsigned char c : std::string("?/>"))
+					classes[c] |= XMLReader_Impl::char_name_end;
+				classes[(unsigned char)'='] |= XMLReader_Impl::char_attribute_name_end;
+			}
+
+			unsigned char classes[256];
+		};
+
+		const XMLCharClasses xml_char_classes;
+
+		int count_lines(const char *data, size_t size)
+		{
+			size_t lines = 0;
+			size_t i = 0;
+#ifndef CL_DISABLE_SSE2
+			const __m128i newline = _mm_set1_epi8('\n');
+			while (i + 16 * 255 <= size)
+			{
+				// Each byte of the sum counts the newlines in its lane, for at most 255 iterations
+				__m128i sum = _mm_setzero_si128();
+				for (int j = 0; j < 255; j++, i += 16)
+					sum = _mm_sub_epi8(sum, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), newline));
+				sum = _mm_sad_epu8(sum, _mm_setzero_si128());
+				lines += _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+			}
+#endif
+			lines += std::count(data + i, data + size, '\n');
+			return (int)lines;
+		}
+	}
+
+	XMLReader::XMLReader()
+	{
+	}
+
+	XMLReader::XMLReader(IODevice &input) : impl(std::make_shared<XMLReader_Impl>(input))
+	{
+	}
+
+	XMLReader::~XMLReader()
+	{
+	}
+
+	void XMLReader::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("XMLReader is null");
+	}
+
+	bool XMLReader::get_eat_whitespace() const
+	{
+		return impl->eat_whitespace;
+	}
+
+	void XMLReader::set_eat_whitespace(bool enable)
+	{
+		impl->eat_whitespace = enable;
+	}
+
+	bool XMLReader::read()
+	{
+		return impl->read();
+	}
+
+	void XMLReader::skip()
+	{
+		if (impl->type != XMLToken::ELEMENT_TOKEN || impl->variant != XMLToken::BEGIN)
+			return;
+
+		int depth = impl->depth;
+		while (impl->read())
+		{
+			if (impl->type == XMLToken::ELEMENT_TOKEN && impl->variant == XMLToken::END && impl->depth == depth)
+				break;
+		}
+	}
+
+	XMLToken::TokenType XMLReader::get_type() const
+	{
+		return impl->type;
+	}
+
+	XMLToken::TokenVariant XMLReader::get_variant() const
+	{
+		return impl->variant;
+	}
+
+	int XMLReader::get_depth() const
+	{
+		return impl->depth;
+	}
+
+	XMLStringRef XMLReader::get_name() const
+	{
+		return impl->get_string(impl->name);
+	}
+
+	XMLStringRef XMLReader::get_value() const
+	{
+		return impl->get_string(impl->value);
+	}
+
+	int XMLReader::get_attribute_count() const
+	{
+		return (int)impl->attributes.size() / 2;
+	}
+
+	XMLStringRef XMLReader::get_attribute_name(int index) const
+	{
+		return impl->get_string(impl->attributes.at(index * 2));
+	}
+
+	XMLStringRef XMLReader::get_attribute_value(int index) const
+	{
+		return impl->get_string(impl->attributes.at(index * 2 + 1));
+	}
+
+	bool XMLReader::has_attribute(const char *name) const
+	{
+		size_t length = strlen(name);
+		for (size_t i = 0; i < impl->attributes.size(); i += 2)
+		{
+			if (impl->get_string(impl->attributes[i]).equals(name, length))
+				return true;
+		}
+		return false;
+	}
+
+	XMLStringRef XMLReader::get_attribute(const char *name) const
+	{
+		size_t length = strlen(name);
+		for (size_t i = 0; i < impl->attributes.size(); i += 2)
+		{
+			if (impl->get_string(impl->attributes[i]).equals(name, length))
+				return impl->get_string(impl->attributes[i + 1]);
+		}
+		return XMLStringRef();
+	}
+
+	void XMLReader::get_token(XMLToken *out_token) const
+	{
+		impl->get_token(out_token);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	bool XMLReader_Impl::read()
+	{
+		type = XMLToken::NULL_TOKEN;
+		variant = XMLToken::SINGLE;
+		name = Span();
+		value = Span();
+		attributes.clear();
+
+		if (descend)
+		{
+			depth++;
+			descend = false;
+		}
+
+		while (true)
+		{
+			size_t node_start = pos;
+			try
+			{
+				if (pos == end)
+				{
+					if (end_of_input)
+						return false;
+					throw NeedMoreData();
+				}
+
+				if (buffer[pos] != '<')
+				{
+					if (next_text_node())
+						break;
+				}
+				else
+				{
+					next_tag_node();
+					break;
+				}
+			}
+			catch (const NeedMoreData &)
+			{
+				// Parse the node again when the rest of it has been read
+				pos = node_start;
+				type = XMLToken::NULL_TOKEN;
+				variant = XMLToken::SINGLE;
+				name = Span();
+				value = Span();
+				attributes.clear();
+				fill();
+			}
+		}
+
+		// Entities are replaced after the whole node has been found, as parsing a node may have to start over
+		if (type == XMLToken::TEXT_TOKEN || type == XMLToken::COMMENT_TOKEN)
+			unescape(value);
+		for (size_t i = 1; i < attributes.size(); i += 2)
+			unescape(attributes[i]);
+
+		if (type == XMLToken::ELEMENT_TOKEN)
+		{
+			if (variant == XMLToken::BEGIN)
+				descend = true;
+			else if (variant == XMLToken::END && depth > 0)
+				depth--;
+		}
+		return true;
+	}
+
+	void XMLReader_Impl::get_token(XMLToken *out_token) const
+	{
+		out_token->type = type;
+		out_token->variant = variant;
+		out_token->name.assign(buffer.data() + name.start, name.length);
+		out_token->value.assign(buffer.data() + value.start, value.length);
+		out_token->attributes.resize(attributes.size() / 2);
+		for (size_t i = 0; i < out_token->attributes.size(); i++)
+		{
+			out_token->attributes[i].first.assign(buffer.data() + attributes[i * 2].start, attributes[i * 2].length);
+			out_token->attributes[i].second.assign(buffer.data() + attributes[i * 2 + 1].start, attributes[i * 2 + 1].length);
+		}
+	}
+
+	void XMLReader_Impl::fill()
+	{
+		// Move the unparsed data to the start of the buffer
+		if (pos > 0)
+		{
+			buffer_line += count_lines(buffer.data(), pos);
+			buffer_offset += pos;
+			memmove(buffer.data(), buffer.data() + pos, end - pos);
+			end -= pos;
+			pos = 0;
+		}
+
+		// A node larger than the buffer needs a larger buffer
+		if (end + block_size / 2 > buffer.size())
+			buffer.resize(std::max(buffer.size() * 2, block_size));
+
+		size_t received = input.receive(buffer.data() + end, buffer.size() - end, true);
+		if (received == 0)
+			end_of_input = true;
+		end += received;
+
+		if (first_block)
+		{
+			first_block = false;
+			switch (StringHelp::detect_bom(buffer.data(), end))
+			{
+			default:
+			case StringHelp::bom_none:
+				break;
+			case StringHelp::bom_utf32_be:
+			case StringHelp::bom_utf32_le:
+				throw Exception("UTF-32 XML files not supported yet");
+			case StringHelp::bom_utf16_be:
+			case StringHelp::bom_utf16_le:
+				throw Exception("UTF-16 XML files not supported yet");
+			case StringHelp::bom_utf8:
+				memmove(buffer.data(), buffer.data() + 3, end - 3);
+				end -= 3;
+				break;
+			}
+		}
+	}
+
+	bool XMLReader_Impl::next_text_node()
+	{
+		while (pos < end && buffer[pos] != '<')
+		{
+			size_t start_pos = pos;
+			size_t end_pos = find('<', start_pos);
+			if (end_pos == std::string::npos)
+			{
+				if (!end_of_input)
+					throw NeedMoreData();
+				end_pos = end;
+			}
+			pos = end_pos;
+
+			Span text(start_pos, end_pos - start_pos);
+			if (eat_whitespace)
+			{
+				text = trim_whitespace(text);
+				if (text.length == 0)
+					return false;
+			}
+
+			type = XMLToken::TEXT_TOKEN;
+			value = text;
+			return true;
+		}
+		return false;
+	}
+
+	void XMLReader_Impl::next_tag_node()
+	{
+		pos++;
+		if (pos == end)
+			premature_end();
+
+		// Try to early predict what sort of node it might be:
+		bool closing = (buffer[pos] == '/');
+		bool questionMark = (buffer[pos] == '?');
+		bool exclamationMark = (buffer[pos] == '!');
+
+		if (closing || questionMark || exclamationMark)
+		{
+			pos++;
+			if (pos == end)
+				premature_end();
+		}
+
+		if (exclamationMark) // check for cdata section, comments or doctype
+		{
+			if (next_exclamation_mark_node())
+				return;
+		}
+
+		// Extract the tag name:
+		size_t start_pos = pos;
+		size_t end_pos = find_first_of(char_name_end, start_pos);
+		if (end_pos == std::string::npos)
+			premature_end();
+		pos = end_pos;
+
+		type = questionMark ? XMLToken::PROCESSING_INSTRUCTION_TOKEN : XMLToken::ELEMENT_TOKEN;
+		variant = closing ? XMLToken::END : XMLToken::BEGIN;
+		name = Span(start_pos, end_pos - start_pos);
+
+		if (type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
+		{
+			// Strip whitespace:
+			pos = skip_whitespace(pos);
+			if (pos == std::string::npos)
+				premature_end();
+
+			end_pos = find('?', pos);
+			if (end_pos == std::string::npos)
+				premature_end();
+			value = Span(pos, end_pos - pos);
+			pos = end_pos;
+		}
+		else // type == XMLToken::ELEMENT_TOKEN
+		{
+			// Check for possible attributes:
+			while (true)
+			{
+				// Strip whitespace:
+				pos = skip_whitespace(pos);
+				if (pos == std::string::npos)
+					premature_end();
+
+				// End of tag, stop searching for more attributes:
+				if (buffer[pos] == '/' || buffer[pos] == '?' || buffer[pos] == '>')
+					break;
+
+				// Extract attribute name:
+				size_t start_pos = pos;
+				size_t end_pos = find_first_of(char_attribute_name_end, start_pos);
+				if (end_pos == std::string::npos)
+					premature_end();
+				pos = end_pos;
+
+				Span attribute_name(start_pos, end_pos - start_pos);
+
+				// Find seperator:
+				pos = skip_whitespace(pos);
+				if (pos == std::string::npos || pos == end - 1)
+					premature_end();
+				if (buffer[pos++] != '=')
+					throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), get_string(name).str(), get_string(attribute_name).str()));
+
+				// Strip whitespace:
+				pos = skip_whitespace(pos);
+				if (pos == std::string::npos)
+					premature_end();
+
+				// Extract attribute value:
+				char quote = 0;
+				if (buffer[pos] == '"' || buffer[pos] == '\'')
+				{
+					quote = buffer[pos];
+					pos++;
+					if (pos == end)
+						premature_end();
+				}
+
+				start_pos = pos;
+				end_pos = quote ? find(quote, start_pos) : find_first_of(char_whitespace, start_pos);
+				if (end_pos == std::string::npos)
+					premature_end();
+
+				pos = end_pos + 1;
+				if (pos == end)
+					premature_end();
+
+				attributes.push_back(attribute_name);
+				attributes.push_back(Span(start_pos, end_pos - start_pos));
+			}
+		}
+
+		// Check if its singular:
+		if (buffer[pos] == '/' || buffer[pos] == '?')
+		{
+			variant = XMLToken::SINGLE;
+			pos++;
+			if (pos == end)
+				premature_end();
+		}
+
+		// Data stream should be ending now.
+		if (buffer[pos] != '>')
+			throw_exception(string_format("Error in XML stream, line %1 (expected end of tag)", get_line_number()));
+		pos++;
+	}
+
+	bool XMLReader_Impl::next_exclamation_mark_node()
+	{
+		if (pos + 2 >= end)
+			premature_end();
+
+		if (compare(pos, "--", 2)) // comment block
+		{
+			size_t start_pos = pos + 2;
+			size_t end_pos = find("-->", 3, start_pos);
+			if (end_pos == std::string::npos)
+				premature_end();
+			pos = end_pos + 3;
+
+			type = XMLToken::COMMENT_TOKEN;
+			variant = XMLToken::SINGLE;
+			value = Span(start_pos, end_pos - start_pos);
+			if (eat_whitespace)
+				value = trim_whitespace(value);
+			return true;
+		}
+
+		if (pos + 7 >= end)
+			premature_end();
+
+		if (compare(pos, "DOCTYPE", 7))
+		{
+			// Strip whitespace:
+			pos = skip_whitespace(pos + 7);
+			if (pos == std::string::npos)
+				premature_end();
+
+			// Skip doctype name:
+			pos = find_first_of(char_name_end, pos);
+			if (pos == std::string::npos)
+				premature_end();
+
+			// Strip whitespace:
+			pos = skip_whitespace(pos);
+			if (pos == std::string::npos)
+				premature_end();
+
+			// Skip possible external id:
+			if (buffer[pos] != '[' && buffer[pos] != '>')
+			{
+				if (pos + 6 >= end)
+					premature_end();
+
+				int literals = 0;
+				if (compare(pos, "SYSTEM", 6))
+					literals = 1;
+				else if (compare(pos, "PUBLIC", 6))
+					literals = 2;
+				else
+					throw_exception(string_format("Error in XML stream, line %1 (unknown external identifier type in DOCTYPE)", get_line_number()));
+
+				pos += 6;
+				if (pos == end)
+					premature_end();
+
+				for (int i = 0; i < literals; i++)
+				{
+					// Strip whitespace:
+					pos = skip_whitespace(pos);
+					if (pos == std::string::npos)
+						premature_end();
+
+					// Skip public or system literal:
+					char literal_char = buffer[pos];
+					if (literal_char != '\'' && literal_char != '"')
+						throw_exception("Premature end of XML data!");
+
+					size_t literal_end = find(literal_char, pos + 1);
+					if (literal_end == std::string::npos)
+						premature_end();
+					pos = literal_end + 1;
+					if (pos >= end)
+						premature_end();
+				}
+
+				// Strip whitespace:
+				pos = skip_whitespace(pos);
+				if (pos == std::string::npos)
+					premature_end();
+			}
+
+			// Skip possible internal subset:
+			if (buffer[pos] == '[')
+			{
+				size_t end_pos = find('>', pos + 1);
+				if (end_pos == std::string::npos)
+					premature_end();
+
+				if (std::find(buffer.data() + pos, buffer.data() + end_pos, ']') == buffer.data() + end_pos)
+					throw_exception(string_format("Error in XML stream, line %1 (expected end of internal subset in DOCTYPE)", get_line_number()));
+
+				pos = end_pos;
+			}
+
+			// Expect DOCTYPE tag to end now:
+			if (buffer[pos] != '>')
+				throw_exception(string_format("Error in XML stream, line %1 (expected end of DOCTYPE)", get_line_number()));
+			pos++;
+
+			type = XMLToken::DOCUMENT_TYPE_TOKEN;
+			return true;
+		}
+		else if (compare(pos, "[CDATA[", 7))
+		{
+			size_t start_pos = pos + 7;
+			size_t end_pos = find("]]>", 3, start_pos);
+			if (end_pos == std::string::npos)
+				premature_end();
+			pos = end_pos + 3;
+
+			type = XMLToken::CDATA_SECTION_TOKEN;
+			variant = XMLToken::SINGLE;
+			value = Span(start_pos, end_pos - start_pos);
+			return true;
+		}
+		else
+		{
+			throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(buffer_offset + pos)));
+			return false;
+		}
+	}
+
+	size_t XMLReader_Impl::find(char c, size_t start) const
+	{
+		if (start >= end)
+			return std::string::npos;
+		const char *found = static_cast<const char *>(memchr(buffer.data() + start, c, end - start));
+		return found ? found - buffer.data() : std::string::npos;
+	}
+
+	size_t XMLReader_Impl::find(const char *str, size_t length, size_t start) const
+	{
+		while (true)
+		{
+			start = find(str[0], start);
+			if (start == std::string::npos || start + length > end)
+				return std::string::npos;
+			if (compare(start, str, length))
+				return start;
+			start++;
+		}
+	}
+
+	size_t XMLReader_Impl::find_first_of(int char_class, size_t start) const
+	{
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(buffer.data());
+		for (size_t i = start; i < end; i++)
+		{
+			if (xml_char_classes.classes[data[i]] & char_class)
+				return i;
+		}
+		return std::string::npos;
+	}
+
+	size_t XMLReader_Impl::skip_whitespace(size_t start) const
+	{
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(buffer.data());
+		for (size_t i = start; i < end; i++)
+		{
+			if (!(xml_char_classes.classes[data[i]] & char_whitespace))
+				return i;
+		}
+		return std::string::npos;
+	}
+
+	bool XMLReader_Impl::compare(size_t start, const char *str, size_t length) const
+	{
+		return start + length <= end && memcmp(buffer.data() + start, str, length) == 0;
+	}
+
+	void XMLReader_Impl::premature_end() const
+	{
+		if (!end_of_input)
+			throw NeedMoreData();
+		throw_exception("Premature end of XML data!");
+	}
+
+	void XMLReader_Impl::throw_exception(const std::string &str) const
+	{
+		throw Exception(str);
+	}
+
+	int XMLReader_Impl::get_line_number() const
+	{
+		size_t line_end = std::min(pos + 1, end);
+		return buffer_line + count_lines(buffer.data(), line_end);
+	}
+
+	void XMLReader_Impl::unescape(Span &span)
+	{
+		char *text = buffer.data() + span.start;
+		char *text_end = text + span.length;
+		char *src = static_cast<char *>(memchr(text, '&', span.length));
+		if (!src)
+			return;
+
+		static const struct { const char *search; size_t length; char replace; } entities[] =
+		{
+			{ "&quot;", 6, '"' },
+			{ "&apos;", 6, '\'' },
+			{ "&lt;", 4, '<' },
+			{ "&gt;", 4, '>' },
+			{ "&amp;", 5, '&' }
+		};
+
+		char *dest = src;
+		while (src != text_end)
+		{
+			if (*src == '&')
+			{
+				bool replaced = false;
+				for (const auto &entity : entities)
+				{
+					if ((size_t)(text_end - src) >= entity.length && memcmp(src, entity.search, entity.length) == 0)
+					{
+						*(dest++) = entity.replace;
+						src += entity.length;
+						replaced = true;
+						break;
+					}
+				}
+				if (replaced)
+					continue;
+			}
+			*(dest++) = *(src++);
+		}
+
+		// Blank the unused end so that it is not counted by get_line_number
+		memset(dest, ' ', text_end - dest);
+		span.length = dest - text;
+	}
+
+	XMLReader_Impl::Span XMLReader_Impl::trim_whitespace(Span span) const
+	{
+		size_t start = skip_whitespace(span.start);
+		if (start == std::string::npos || start >= span.start + span.length)
+			return Span(span.start, 0);
+
+		size_t last = span.start + span.length - 1;
+		while (buffer[last] == ' ' || buffer[last] == '\t' || buffer[last] == '\r' || buffer[last] == '\n')
+			last--;
+		return Span(start, last - start + 1);
+	}
+}
@@ -0,0 +1,106 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/XML/xml_reader.h"
+#include "API/XML/xml_token.h"
+#include "API/Core/IOData/iodevice.h"
+#include <vector>
+
+namespace clan
+{
+	class XMLReader_Impl
+	{
+	public:
+		/// \brief Location of a string in the buffer
+		struct Span
+		{
+			Span() { }
+			Span(size_t start, size_t length) : start(start), length(length) { }
+
+			size_t start = 0;
+			size_t length = 0;
+		};
+
+		/// \brief Thrown internally when a node continues past the data in the buffer
+		struct NeedMoreData { };
+
+		enum CharClass
+		{
+			char_whitespace = 1, // " \r\n\t"
+			char_name_end = 2, // " \r\n\t?/>"
+			char_attribute_name_end = 4 // " \r\n\t="
+		};
+
+		static const size_t block_size = 64 * 1024;
+
+		XMLReader_Impl(IODevice &input) : input(input) { }
+
+		bool read();
+		void get_token(XMLToken *out_token) const;
+		XMLStringRef get_string(const Span &span) const { return span.length ? XMLStringRef(buffer.data() + span.start, span.length) : XMLStringRef(); }
+
+		IODevice input;
+		bool eat_whitespace = true;
+
+		XMLToken::TokenType type = XMLToken::NULL_TOKEN;
+		XMLToken::TokenVariant variant = XMLToken::SINGLE;
+		int depth = 0;
+		Span name;
+		Span value;
+		std::vector<Span> attributes; // Name and value pairs
+
+	private:
+		void fill();
+		bool next_text_node();
+		void next_tag_node();
+		bool next_exclamation_mark_node();
+
+		size_t find(char c, size_t start) const;
+		size_t find(const char *str, size_t length, size_t start) const;
+		size_t find_first_of(int char_class, size_t start) const;
+		size_t skip_whitespace(size_t start) const;
+		bool compare(size_t start, const char *str, size_t length) const;
+
+		void premature_end() const;
+		void throw_exception(const std::string &str) const;
+		int get_line_number() const;
+
+		void unescape(Span &span);
+		Span trim_whitespace(Span span) const;
+
+		std::vector<char> buffer;
+		size_t pos = 0, end = 0; // Unparsed data in the buffer
+		size_t buffer_offset = 0; // Input position of the start of the buffer
+		int buffer_line = 1; // Line number of the start of the buffer
+		bool first_block = true;
+		bool end_of_input = false;
+		bool descend = false;
+	};
+}
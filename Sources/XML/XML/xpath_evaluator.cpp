@@ -31,11 +31,51 @@
 #include "API/XML/xpath_evaluator.h"
 #include "API/XML/xpath_exception.h"
 #include "API/XML/dom_node.h"
+#include "API/XML/xpath_expression.h"
 #include "xpath_evaluator_impl.h"
 #include "xpath_token.h"
+#include <mutex>
+#include <unordered_map>
 
 namespace clan
 {
+	namespace
+	{
+		// Expressions compiled by XPathEvaluator::evaluate, shared by all evaluators.
+		// DomNode::select_nodes creates a new evaluator for every call.
+		class XPathExpressionCache
+		{
+		public:
+			XPathExpression get(const std::string &expression)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				auto it = expressions.find(expression);
+				if (it != expressions.end())
+					return it->second;
+				lock.unlock();
+
+				XPathExpression compiled(expression);
+
+				lock.lock();
+				if (expressions.size() >= max_expressions)
+					expressions.clear();
+				expressions[expression] = compiled;
+				return compiled;
+			}
+
+			static XPathExpressionCache &instance()
+			{
+				static XPathExpressionCache cache;
+				return cache;
+			}
+
+		private:
+			static const size_t max_expressions = 256;
+			std::mutex mutex;
+			std::unordered_map<std::string, XPathExpression> expressions;
+		};
+	}
+
 	XPathEvaluator::XPathEvaluator()
 		: impl(std::make_shared<XPathEvaluator_Impl>())
 	{
@@ -43,11 +83,6 @@ namespace clan
 
 	XPathObject XPathEvaluator::evaluate(const std::string &expression, const DomNode &context_node) const
 	{
-		XPathToken prev_token;
-		std::vector<DomNode> nodelist(1, context_node);
-		XPathEvaluateResult result = impl->evaluate(expression, nodelist, 0, prev_token);
-		if (result.next_token.type != XPathToken::type_none)
-			throw XPathException("Expected end of expression", expression, result.next_token);
-		return result.result;
+		return XPathExpressionCache::instance().get(expression).evaluate(context_node);
 	}
 }
@@ -931,12 +931,17 @@ namespace clan
 			steps.push_back(step);
 
 			XPathToken next_token = read_token(expression, cur_token);
-			if ((next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_slash) ||
+			bool next_slash = next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_slash;
+			bool next_double_slash = next_token.type == XPathToken::type_operator && next_token.value.oper == XPathToken::operator_double_slash;
+			if (next_slash || next_double_slash ||
 				(cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash))
 			{
-				if (next_token.value.oper == XPathToken::operator_slash)
+				if (next_slash)
 					next_token = read_token(expression, next_token);
-				if (next_token.type == XPathToken::type_axis_name ||
+
+				// A '//' inside the path is a descendant-or-self::node() step
+				if (next_double_slash ||
+					next_token.type == XPathToken::type_axis_name ||
 					next_token.type == XPathToken::type_name_test ||
 					next_token.type == XPathToken::type_node_type ||
 					next_token.type == XPathToken::type_at_sign ||
@@ -1112,7 +1117,7 @@ namespace clan
 				select_nodes_descendant_or_self(context, context_node_index, steps, step_index, expression, nodes);
 			else if (steps[step_index].axis == "following")
 				select_nodes_following(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "follwing-sibling")
+			else if (steps[step_index].axis == "following-sibling")
 				select_nodes_following_sibling(context, context_node_index, steps, step_index, expression, nodes);
 			else if (steps[step_index].axis == "namespace")
 				select_nodes_namespace(context, context_node_index, steps, step_index, expression, nodes);
@@ -1223,7 +1228,10 @@ namespace clan
 		XPathNodeSet parentNodes;
 		XPathNodeSet nodeset;
 
-		DomNode cur_node = context[context_node_index];
+		if (confirm_step_requirements(context[context_node_index], steps[step_index], expression))
+			nodeset.push_back(context[context_node_index]);
+
+		DomNode cur_node = context[context_node_index].get_first_child();
 		while (!cur_node.is_null())
 		{
 			if (confirm_step_requirements(cur_node, steps[step_index], expression))
@@ -1412,7 +1420,13 @@ namespace clan
 
 	bool XPathEvaluator_Impl::confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const std::string &expression) const
 	{
-		XPathEvaluateResult result = evaluate(expression.substr(predicate.pos, predicate.length), context, context_node_index, XPathToken());
+		// Evaluate the predicate in place, so the tokens of the expression are reused. Evaluation stops at its ']'
+		XPathToken bracket_begin;
+		bracket_begin.type = XPathToken::type_bracket_begin;
+		bracket_begin.pos = predicate.pos - 1;
+		bracket_begin.length = 1;
+
+		XPathEvaluateResult result = evaluate(expression, context, context_node_index, bracket_begin);
 		bool include_in_nodeset = false;
 		switch (result.result.get_type())
 		{
@@ -1456,6 +1470,13 @@ namespace clan
 		const std::string &expression,
 		const XPathToken &previous_token) const
 	{
+		if (token_table)
+		{
+			const XPathToken *token = token_table->find_next(expression, previous_token);
+			if (token)
+				return *token;
+		}
+
 		std::string::size_type pos = previous_token.pos + previous_token.length;
 		pos = expression.find_first_not_of(" \t\r\n", pos);
 		if (pos == std::string::npos || expression.length() == pos)
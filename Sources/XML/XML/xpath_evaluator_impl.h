@@ -48,6 +48,8 @@ namespace clan
 		typedef std::vector<DomNode> XPathNodeSet;
 
 	public:
+		XPathEvaluator_Impl(const XPathTokenTable *token_table = nullptr) : token_table(token_table) { }
+
 		XPathEvaluateResult evaluate(
 			const std::string &expression,
 			const XPathNodeSet &context,
@@ -164,5 +166,9 @@ namespace clan
 		static inline bool boolean(const DomNode &node);
 		static inline double number(const DomNode &node);
 		static inline std::string string(const DomNode &node);
+
+		const XPathTokenTable *token_table;
+
+		friend class XPathExpression_Impl;
 	};
 }
@@ -0,0 +1,553 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "XML/precomp.h"
+#include "API/XML/xpath_expression.h"
+#include "API/XML/xpath_index.h"
+#include "API/XML/xpath_exception.h"
+#include "API/XML/dom_node.h"
+#include "API/Core/Text/string_help.h"
+#include "dom_document_generic.h"
+#include "dom_node_generic.h"
+#include "dom_tree_node.h"
+#include "xpath_expression_impl.h"
+#include "xpath_index_impl.h"
+
+namespace clan
+{
+	XPathExpression::XPathExpression()
+	{
+	}
+
+	XPathExpression::XPathExpression(const std::string &expression)
+		: impl(std::make_shared<XPathExpression_Impl>(expression))
+	{
+	}
+
+	void XPathExpression::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("XPathExpression is null");
+	}
+
+	const std::string &XPathExpression::get_expression() const
+	{
+		throw_if_null();
+		return impl->token_table.expression;
+	}
+
+	bool XPathExpression::is_location_path() const
+	{
+		throw_if_null();
+		return impl->location_path;
+	}
+
+	XPathObject XPathExpression::evaluate(const DomNode &context_node) const
+	{
+		throw_if_null();
+		return impl->evaluate(context_node, nullptr);
+	}
+
+	XPathObject XPathExpression::evaluate(const DomNode &context_node, const XPathIndex &index) const
+	{
+		throw_if_null();
+		return impl->evaluate(context_node, index.impl.get());
+	}
+
+	std::vector<DomNode> XPathExpression::select_nodes(const DomNode &context_node) const
+	{
+		throw_if_null();
+		return impl->select_nodes(context_node, nullptr);
+	}
+
+	std::vector<DomNode> XPathExpression::select_nodes(const DomNode &context_node, const XPathIndex &index) const
+	{
+		throw_if_null();
+		return impl->select_nodes(context_node, index.impl.get());
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	bool XPathCompiledStep::is_positional() const
+	{
+		for (const auto &predicate : predicates)
+		{
+			if (predicate.type == Predicate::type_position)
+				return true;
+		}
+		return false;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	XPathExpression_Impl::XPathExpression_Impl(const std::string &expression)
+		: evaluator(&token_table), location_path(false), absolute(false)
+	{
+		token_table.expression = expression;
+		read_tokens();
+		location_path = compile_location_path();
+		if (!location_path)
+			steps.clear();
+	}
+
+	XPathObject XPathExpression_Impl::evaluate(const DomNode &context_node, const XPathIndex_Impl *index) const
+	{
+		if (!location_path || !context_node.impl)
+			return interpret(context_node);
+
+		NodeIndexList nodes;
+		select_path(context_node, index, nodes);
+		return XPathObject(to_dom_nodes(context_node, nodes));
+	}
+
+	std::vector<DomNode> XPathExpression_Impl::select_nodes(const DomNode &context_node, const XPathIndex_Impl *index) const
+	{
+		if (!location_path || !context_node.impl)
+		{
+			XPathObject result = interpret(context_node);
+			if (result.get_type() != XPathObject::type_node_set)
+				return std::vector<DomNode>();
+			return result.get_node_set();
+		}
+
+		NodeIndexList nodes;
+		select_path(context_node, index, nodes);
+		return to_dom_nodes(context_node, nodes);
+	}
+
+	XPathObject XPathExpression_Impl::interpret(const DomNode &context_node) const
+	{
+		XPathToken prev_token;
+		std::vector<DomNode> nodelist(1, context_node);
+		XPathEvaluateResult result = evaluator.evaluate(token_table.expression, nodelist, 0, prev_token);
+		if (result.next_token.type != XPathToken::type_none)
+			throw XPathException("Expected end of expression", token_table.expression, result.next_token);
+		return result.result;
+	}
+
+	void XPathExpression_Impl::read_tokens()
+	{
+		const std::string &expression = token_table.expression;
+		token_table.token_after.resize(expression.length() + 1, -1);
+
+		XPathToken prev_token;
+		while (true)
+		{
+			XPathToken cur_token = evaluator.read_token(expression, prev_token);
+			token_table.token_after[prev_token.pos + prev_token.length] = (int)token_table.tokens.size();
+			token_table.tokens.push_back(cur_token);
+			if (cur_token.type == XPathToken::type_none)
+				break;
+			prev_token = cur_token;
+		}
+	}
+
+	const XPathToken &XPathExpression_Impl::token(std::vector<XPathToken>::size_type pos) const
+	{
+		// The last token is always type_none
+		return token_table.tokens[std::min(pos, token_table.tokens.size() - 1)];
+	}
+
+	bool XPathExpression_Impl::is_operator(std::vector<XPathToken>::size_type pos, XPathToken::Operator oper) const
+	{
+		return token(pos).type == XPathToken::type_operator && token(pos).value.oper == oper;
+	}
+
+	bool XPathExpression_Impl::compile_location_path()
+	{
+		std::vector<XPathToken>::size_type pos = 0;
+		if (is_operator(pos, XPathToken::operator_slash))
+		{
+			absolute = true;
+			pos++;
+			if (token(pos).type == XPathToken::type_none)
+				return false;
+		}
+		else if (is_operator(pos, XPathToken::operator_double_slash))
+		{
+			absolute = true;
+		}
+
+		while (true)
+		{
+			if (is_operator(pos, XPathToken::operator_double_slash))
+			{
+				XPathCompiledStep step;
+				step.axis = XPathCompiledStep::axis_descendant_or_self;
+				steps.push_back(step);
+				pos++;
+			}
+
+			XPathCompiledStep step;
+			if (!compile_step(pos, step))
+				return false;
+			steps.push_back(step);
+
+			if (is_operator(pos, XPathToken::operator_slash))
+				pos++;
+			else if (!is_operator(pos, XPathToken::operator_double_slash))
+				return token(pos).type == XPathToken::type_none;
+		}
+	}
+
+	bool XPathExpression_Impl::compile_step(std::vector<XPathToken>::size_type &pos, XPathCompiledStep &step) const
+	{
+		if (token(pos).type == XPathToken::type_dot || token(pos).type == XPathToken::type_double_dot)
+		{
+			step.axis = token(pos).type == XPathToken::type_dot ? XPathCompiledStep::axis_self : XPathCompiledStep::axis_parent;
+			pos++;
+			return true;
+		}
+
+		if (token(pos).type == XPathToken::type_axis_name)
+		{
+			const std::string &axis = token(pos).value.str;
+			if (axis == "child")
+				step.axis = XPathCompiledStep::axis_child;
+			else if (axis == "descendant")
+				step.axis = XPathCompiledStep::axis_descendant;
+			else if (axis == "descendant-or-self")
+				step.axis = XPathCompiledStep::axis_descendant_or_self;
+			else if (axis == "attribute")
+				step.axis = XPathCompiledStep::axis_attribute;
+			else if (axis == "self")
+				step.axis = XPathCompiledStep::axis_self;
+			else if (axis == "parent")
+				step.axis = XPathCompiledStep::axis_parent;
+			else
+				return false;
+
+			pos++;
+			if (token(pos).type != XPathToken::type_double_colon)
+				return false;
+			pos++;
+		}
+		else if (token(pos).type == XPathToken::type_at_sign)
+		{
+			step.axis = XPathCompiledStep::axis_attribute;
+			pos++;
+		}
+		else
+		{
+			step.axis = XPathCompiledStep::axis_child;
+		}
+
+		if (token(pos).type == XPathToken::type_name_test)
+		{
+			step.test_type = XPathLocationStep::type_name;
+			step.name = token(pos).value.str;
+			pos++;
+		}
+		else if (token(pos).type == XPathToken::type_node_type)
+		{
+			step.test_type = XPathLocationStep::type_node;
+			step.node_type = token(pos).value.node_type;
+			if (!is_operator(pos + 1, XPathToken::operator_parenthesis_begin) || !is_operator(pos + 2, XPathToken::operator_parenthesis_end))
+				return false;
+			pos += 3;
+		}
+		else
+		{
+			return false;
+		}
+
+		while (token(pos).type == XPathToken::type_bracket_begin)
+		{
+			XPathCompiledStep::Predicate predicate;
+			if (!compile_predicate(pos, predicate))
+				return false;
+			step.predicates.push_back(predicate);
+		}
+		return true;
+	}
+
+	bool XPathExpression_Impl::compile_predicate(std::vector<XPathToken>::size_type &pos, XPathCompiledStep::Predicate &predicate) const
+	{
+		// Supported forms are [number], [@name] and [@name='literal']
+		pos++;
+		if (token(pos).type == XPathToken::type_number)
+		{
+			predicate.type = XPathCompiledStep::Predicate::type_position;
+			predicate.position = StringHelp::text_to_double(token(pos).value.str);
+			pos++;
+		}
+		else if (token(pos).type == XPathToken::type_at_sign && token(pos + 1).type == XPathToken::type_name_test)
+		{
+			predicate.attribute = token(pos + 1).value.str;
+			pos += 2;
+			if (is_operator(pos, XPathToken::operator_compare_equal) && token(pos + 1).type == XPathToken::type_literal)
+			{
+				predicate.type = XPathCompiledStep::Predicate::type_attribute_equals;
+				predicate.value = token(pos + 1).value.str;
+				pos += 2;
+			}
+			else
+			{
+				predicate.type = XPathCompiledStep::Predicate::type_has_attribute;
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		if (token(pos).type != XPathToken::type_bracket_end)
+			return false;
+		pos++;
+		return true;
+	}
+
+	void XPathExpression_Impl::select_path(const DomNode &context_node, const XPathIndex_Impl *index, NodeIndexList &out_nodes) const
+	{
+		std::shared_ptr<DomNode_Impl> doc_ptr = context_node.impl->owner_document.lock();
+		const DomDocument_Impl *doc = (const DomDocument_Impl *)doc_ptr.get();
+
+		unsigned int node_index = context_node.impl->node_index;
+		if (absolute)
+		{
+			while (doc->nodes[node_index]->parent != cl_null_node_index)
+				node_index = doc->nodes[node_index]->parent;
+		}
+
+		std::vector<NodeIndexList> candidates(steps.size());
+		if (absolute && index && select_indexed(doc, node_index, index, candidates, out_nodes))
+			return;
+
+		select_step(doc, node_index, 0, candidates, out_nodes);
+	}
+
+	bool XPathExpression_Impl::select_indexed(const DomDocument_Impl *doc, unsigned int root_index, const XPathIndex_Impl *index, std::vector<NodeIndexList> &candidates, NodeIndexList &out_nodes) const
+	{
+		// The index holds the result of '//name', which is descendant-or-self::node() followed by child::name
+		if (index->document.lock().get() != doc || root_index != doc->node_index || steps.size() < 2)
+			return false;
+
+		const XPathCompiledStep &any_node = steps[0];
+		const XPathCompiledStep &step = steps[1];
+		if (any_node.axis != XPathCompiledStep::axis_descendant_or_self || any_node.test_type != XPathLocationStep::type_node || any_node.node_type != XPathToken::node_type_node || !any_node.predicates.empty())
+			return false;
+
+		// Position predicates count per parent, which the index does not know
+		if (step.axis != XPathCompiledStep::axis_child || step.test_type != XPathLocationStep::type_name || step.name == "*" || step.is_positional())
+			return false;
+
+		const NodeIndexList *indexed_nodes = nullptr;
+		const XPathCompiledStep::Predicate *used_predicate = nullptr;
+		for (const auto &predicate : step.predicates)
+		{
+			if (predicate.type == XPathCompiledStep::Predicate::type_attribute_equals && (predicate.attribute == "id" || predicate.attribute == "name"))
+			{
+				indexed_nodes = XPathIndex_Impl::find(predicate.attribute == "id" ? index->ids : index->names, predicate.value);
+				used_predicate = &predicate;
+				break;
+			}
+		}
+		if (!used_predicate)
+			indexed_nodes = XPathIndex_Impl::find(index->elements, step.name);
+
+		if (!indexed_nodes)
+			return true;
+
+		NodeIndexList &nodes = candidates[1];
+		if (used_predicate)
+		{
+			for (unsigned int node_index : *indexed_nodes)
+			{
+				if (doc->nodes[node_index]->node_name == step.name)
+					nodes.push_back(node_index);
+			}
+		}
+		else
+		{
+			nodes = *indexed_nodes;
+		}
+
+		filter(doc, step, used_predicate, nodes);
+		for (unsigned int node_index : nodes)
+			select_step(doc, node_index, 2, candidates, out_nodes);
+		return true;
+	}
+
+	void XPathExpression_Impl::select_step(const DomDocument_Impl *doc, unsigned int node_index, std::vector<XPathCompiledStep>::size_type step_index, std::vector<NodeIndexList> &candidates, NodeIndexList &out_nodes) const
+	{
+		if (step_index == steps.size())
+		{
+			out_nodes.push_back(node_index);
+			return;
+		}
+
+		// Each step has its own list, so deeper steps do not overwrite the nodes being iterated here
+		NodeIndexList &nodes = candidates[step_index];
+		nodes.clear();
+		select_axis(doc, node_index, steps[step_index], nodes);
+		filter(doc, steps[step_index], nullptr, nodes);
+		for (NodeIndexList::size_type i = 0; i < nodes.size(); i++)
+			select_step(doc, nodes[i], step_index + 1, candidates, out_nodes);
+	}
+
+	void XPathExpression_Impl::select_axis(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep &step, NodeIndexList &nodes) const
+	{
+		const DomTreeNode *tree_node = doc->nodes[node_index];
+		switch (step.axis)
+		{
+		case XPathCompiledStep::axis_child:
+			for (unsigned int child = tree_node->first_child; child != cl_null_node_index; child = doc->nodes[child]->next_sibling)
+			{
+				if (test_node(doc, child, step))
+					nodes.push_back(child);
+			}
+			break;
+
+		case XPathCompiledStep::axis_descendant_or_self:
+			if (test_node(doc, node_index, step))
+				nodes.push_back(node_index);
+			// fall through
+		case XPathCompiledStep::axis_descendant:
+			{
+				unsigned int cur = tree_node->first_child;
+				while (cur != cl_null_node_index)
+				{
+					if (test_node(doc, cur, step))
+						nodes.push_back(cur);
+
+					if (doc->nodes[cur]->first_child != cl_null_node_index)
+					{
+						cur = doc->nodes[cur]->first_child;
+						continue;
+					}
+
+					while (cur != node_index && doc->nodes[cur]->next_sibling == cl_null_node_index)
+						cur = doc->nodes[cur]->parent;
+					if (cur == node_index)
+						break;
+					cur = doc->nodes[cur]->next_sibling;
+				}
+			}
+			break;
+
+		case XPathCompiledStep::axis_attribute:
+			if (tree_node->node_type == DomNode::ELEMENT_NODE)
+			{
+				for (unsigned int attribute = tree_node->first_attribute; attribute != cl_null_node_index; attribute = doc->nodes[attribute]->next_sibling)
+				{
+					if (test_node(doc, attribute, step))
+						nodes.push_back(attribute);
+				}
+			}
+			break;
+
+		case XPathCompiledStep::axis_self:
+			if (test_node(doc, node_index, step))
+				nodes.push_back(node_index);
+			break;
+
+		case XPathCompiledStep::axis_parent:
+			if (tree_node->parent != cl_null_node_index && test_node(doc, tree_node->parent, step))
+				nodes.push_back(tree_node->parent);
+			break;
+		}
+	}
+
+	void XPathExpression_Impl::filter(const DomDocument_Impl *doc, const XPathCompiledStep &step, const XPathCompiledStep::Predicate *skip_predicate, NodeIndexList &nodes) const
+	{
+		for (const auto &predicate : step.predicates)
+		{
+			if (&predicate == skip_predicate)
+				continue;
+
+			NodeIndexList::size_type count = 0;
+			for (NodeIndexList::size_type i = 0; i < nodes.size(); i++)
+			{
+				bool keep;
+				if (predicate.type == XPathCompiledStep::Predicate::type_position)
+					keep = predicate.position == i + 1;
+				else
+					keep = test_predicate(doc, nodes[i], predicate);
+
+				if (keep)
+					nodes[count++] = nodes[i];
+			}
+			nodes.resize(count);
+		}
+	}
+
+	bool XPathExpression_Impl::test_node(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep &step) const
+	{
+		const DomTreeNode *tree_node = doc->nodes[node_index];
+		if (step.test_type == XPathLocationStep::type_name)
+		{
+			return (tree_node->node_type == DomNode::ELEMENT_NODE || tree_node->node_type == DomNode::ATTRIBUTE_NODE) && (step.name == "*" || tree_node->node_name == step.name);
+		}
+		else
+		{
+			switch (step.node_type)
+			{
+			case XPathToken::node_type_node:
+				return true;
+			case XPathToken::node_type_comment:
+				return tree_node->node_type == DomNode::COMMENT_NODE;
+			case XPathToken::node_type_text:
+				return tree_node->node_type == DomNode::TEXT_NODE;
+			case XPathToken::node_type_processing_instruction:
+				return tree_node->node_type == DomNode::PROCESSING_INSTRUCTION_NODE;
+			}
+			return false;
+		}
+	}
+
+	bool XPathExpression_Impl::test_predicate(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep::Predicate &predicate) const
+	{
+		const DomTreeNode *tree_node = doc->nodes[node_index];
+		if (tree_node->node_type != DomNode::ELEMENT_NODE)
+			return false;
+
+		for (const DomTreeNode *attribute = tree_node->get_first_attribute((DomDocument_Impl *)doc); attribute; attribute = attribute->get_next_sibling((DomDocument_Impl *)doc))
+		{
+			if (predicate.attribute != "*" && attribute->node_name != predicate.attribute)
+				continue;
+			if (predicate.type == XPathCompiledStep::Predicate::type_has_attribute || attribute->node_value == predicate.value)
+				return true;
+		}
+		return false;
+	}
+
+	std::vector<DomNode> XPathExpression_Impl::to_dom_nodes(const DomNode &context_node, const NodeIndexList &nodes) const
+	{
+		DomDocument_Impl *doc = (DomDocument_Impl *)context_node.impl->owner_document.lock().get();
+
+		std::vector<DomNode> dom_nodes;
+		dom_nodes.reserve(nodes.size());
+		for (unsigned int node_index : nodes)
+		{
+			DomNode_Impl *dom_node = doc->allocate_dom_node();
+			dom_node->node_index = node_index;
+			dom_nodes.push_back(DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc))));
+		}
+		return dom_nodes;
+	}
+}
@@ -0,0 +1,116 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/XML/xpath_object.h"
+#include "xpath_token.h"
+#include "xpath_location_step.h"
+#include "xpath_evaluator_impl.h"
+
+namespace clan
+{
+	class DomNode;
+	class DomDocument_Impl;
+	class XPathIndex_Impl;
+
+	/// \brief Location step of a compiled location path
+	class XPathCompiledStep
+	{
+	public:
+		enum Axis
+		{
+			axis_child,
+			axis_descendant,
+			axis_descendant_or_self,
+			axis_attribute,
+			axis_self,
+			axis_parent
+		};
+
+		struct Predicate
+		{
+			enum Type
+			{
+				type_position,
+				type_has_attribute,
+				type_attribute_equals
+			};
+
+			Type type;
+			double position;
+			std::string attribute;
+			std::string value;
+		};
+
+		Axis axis = axis_child;
+		XPathLocationStep::TestType test_type = XPathLocationStep::type_node;
+		std::string name;
+		XPathToken::NodeType node_type = XPathToken::node_type_node;
+		std::vector<Predicate> predicates;
+
+		bool is_positional() const;
+	};
+
+	class XPathExpression_Impl
+	{
+	public:
+		XPathExpression_Impl(const std::string &expression);
+
+		XPathObject evaluate(const DomNode &context_node, const XPathIndex_Impl *index) const;
+		std::vector<DomNode> select_nodes(const DomNode &context_node, const XPathIndex_Impl *index) const;
+
+		XPathTokenTable token_table;
+		XPathEvaluator_Impl evaluator;
+
+		/// \brief True if the expression is a location path that is evaluated with steps
+		bool location_path;
+		bool absolute;
+		std::vector<XPathCompiledStep> steps;
+
+	private:
+		typedef std::vector<unsigned int> NodeIndexList;
+
+		void read_tokens();
+		bool compile_location_path();
+		bool compile_step(std::vector<XPathToken>::size_type &pos, XPathCompiledStep &step) const;
+		bool compile_predicate(std::vector<XPathToken>::size_type &pos, XPathCompiledStep::Predicate &predicate) const;
+		const XPathToken &token(std::vector<XPathToken>::size_type pos) const;
+		bool is_operator(std::vector<XPathToken>::size_type pos, XPathToken::Operator oper) const;
+
+		XPathObject interpret(const DomNode &context_node) const;
+		void select_path(const DomNode &context_node, const XPathIndex_Impl *index, NodeIndexList &out_nodes) const;
+		bool select_indexed(const DomDocument_Impl *doc, unsigned int root_index, const XPathIndex_Impl *index, std::vector<NodeIndexList> &candidates, NodeIndexList &out_nodes) const;
+		void select_step(const DomDocument_Impl *doc, unsigned int node_index, std::vector<XPathCompiledStep>::size_type step_index, std::vector<NodeIndexList> &candidates, NodeIndexList &out_nodes) const;
+		void select_axis(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep &step, NodeIndexList &nodes) const;
+		void filter(const DomDocument_Impl *doc, const XPathCompiledStep &step, const XPathCompiledStep::Predicate *skip_predicate, NodeIndexList &nodes) const;
+		bool test_node(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep &step) const;
+		bool test_predicate(const DomDocument_Impl *doc, unsigned int node_index, const XPathCompiledStep::Predicate &predicate) const;
+		std::vector<DomNode> to_dom_nodes(const DomNode &context_node, const NodeIndexList &nodes) const;
+	};
+}
@@ -0,0 +1,93 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "XML/precomp.h"
+#include "API/XML/xpath_index.h"
+#include "API/XML/dom_document.h"
+#include "dom_document_generic.h"
+#include "dom_node_generic.h"
+#include "dom_tree_node.h"
+#include "xpath_index_impl.h"
+
+namespace clan
+{
+	XPathIndex::XPathIndex()
+	{
+	}
+
+	XPathIndex::XPathIndex(const DomDocument &document)
+		: impl(std::make_shared<XPathIndex_Impl>(document))
+	{
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	XPathIndex_Impl::XPathIndex_Impl(const DomDocument &document_node)
+	{
+		if (!document_node.impl)
+			return;
+
+		document = document_node.impl->owner_document;
+		DomDocument_Impl *doc_impl = (DomDocument_Impl *)document.lock().get();
+
+		std::vector<unsigned int> parents(1, document_node.impl->node_index);
+		std::vector<unsigned int> children;
+		while (!parents.empty())
+		{
+			unsigned int parent_index = parents.back();
+			parents.pop_back();
+
+			children.clear();
+			for (unsigned int child_index = doc_impl->nodes[parent_index]->first_child; child_index != cl_null_node_index; child_index = doc_impl->nodes[child_index]->next_sibling)
+			{
+				const DomTreeNode *child = doc_impl->nodes[child_index];
+				children.push_back(child_index);
+				if (child->node_type != DomNode::ELEMENT_NODE)
+					continue;
+
+				elements[child->node_name].push_back(child_index);
+				for (const DomTreeNode *attribute = child->get_first_attribute(doc_impl); attribute; attribute = attribute->get_next_sibling(doc_impl))
+				{
+					if (attribute->node_name == "id")
+						ids[attribute->node_value].push_back(child_index);
+					else if (attribute->node_name == "name")
+						names[attribute->node_value].push_back(child_index);
+				}
+			}
+
+			// Visit the children in document order
+			parents.insert(parents.end(), children.rbegin(), children.rend());
+		}
+	}
+
+	const std::vector<unsigned int> *XPathIndex_Impl::find(const NodeMap &map, const std::string &key)
+	{
+		NodeMap::const_iterator it = map.find(key);
+		return it != map.end() ? &it->second : nullptr;
+	}
+}
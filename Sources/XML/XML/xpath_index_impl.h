@@ -0,0 +1,64 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+namespace clan
+{
+	class DomDocument;
+	class DomNode_Impl;
+
+	class XPathIndex_Impl
+	{
+	public:
+		typedef std::unordered_map<std::string, std::vector<unsigned int> > NodeMap;
+
+		XPathIndex_Impl(const DomDocument &document);
+
+		static const std::vector<unsigned int> *find(const NodeMap &map, const std::string &key);
+
+		std::weak_ptr<DomNode_Impl> document;
+
+		/// \brief Elements by name, as tree node indices
+		///
+		/// Nodes are grouped by parent, with the parents in document order. This is the order
+		/// in which /descendant-or-self::node()/child::name selects them.
+		NodeMap elements;
+
+		/// \brief Elements by the value of their 'id' attribute, in the same order
+		NodeMap ids;
+
+		/// \brief Elements by the value of their 'name' attribute, in the same order
+		NodeMap names;
+	};
+}
@@ -100,4 +100,25 @@ namespace clan
 		{
 		}
 	};
+
+	/// \brief All tokens of an expression, read once when it is compiled
+	class XPathTokenTable
+	{
+	public:
+		std::string expression;
+		std::vector<XPathToken> tokens;
+
+		/// \brief Index of the token following the token that ends at an offset, or -1 if no token ends there
+		std::vector<int> token_after;
+
+		const XPathToken *find_next(const std::string &expr, const XPathToken &previous_token) const
+		{
+			if (&expr != &expression)
+				return nullptr;
+			std::string::size_type offset = previous_token.pos + previous_token.length;
+			if (offset >= token_after.size() || token_after[offset] == -1)
+				return nullptr;
+			return &tokens[token_after[offset]];
+		}
+	};
 }
@@ -56,6 +56,8 @@ int TestApp::main()
 		test_aes128();
 		test_aes192();
 		test_aes256();
+		test_aes_ctr();
+		test_aes_gcm();
 		test_sha1();
 		test_sha224();
 		test_sha256();
@@ -63,6 +65,13 @@ int TestApp::main()
 		test_sha512();
 		test_sha512_224();
 		test_sha512_256();
+		test_sha_many();
+		test_tls();
+
+		benchmark_aes();
+		benchmark_sha();
+		benchmark_rsa();
+		benchmark_tls();
 
 		Console::write_line("All Tests Complete");
 		console.display_close_message();
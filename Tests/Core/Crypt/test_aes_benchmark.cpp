@@ -0,0 +1,92 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	double megabytes_per_second(uint64_t bytes, uint64_t microseconds)
+	{
+		return bytes / (double)max(microseconds, (uint64_t)1);
+	}
+}
+
+void TestApp::benchmark_aes()
+{
+	Console::write_line(" AES throughput (single core):");
+
+	const int data_size = 16 * 1024 * 1024;
+	std::vector<unsigned char> data(data_size, 0x5a);
+	unsigned char key[32] = { 0 };
+	unsigned char iv[16] = { 0 };
+
+	uint64_t start = System::get_microseconds();
+	AES128_Encrypt aes128_encrypt;
+	aes128_encrypt.set_padding(false);
+	aes128_encrypt.set_iv(iv);
+	aes128_encrypt.set_key(key);
+	aes128_encrypt.add(&data[0], data_size);
+	aes128_encrypt.calculate();
+	uint64_t elapsed = System::get_microseconds() - start;
+	Console::write_line("  AES-128 CBC encrypt: %1 MB/s", (int)megabytes_per_second(data_size, elapsed));
+
+	for (int key_size = 16; key_size <= 32; key_size += 16)
+	{
+		AES_CTR aes_ctr;
+		aes_ctr.set_key(key, key_size);
+		aes_ctr.set_iv(iv);
+		start = System::get_microseconds();
+		aes_ctr.process(&data[0], data_size);
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  AES-%1 CTR: %2 MB/s", key_size * 8, (int)megabytes_per_second(data_size, elapsed));
+
+		AES_GCM aes_gcm;
+		aes_gcm.set_key(key, key_size);
+		aes_gcm.set_iv(iv);
+		start = System::get_microseconds();
+		aes_gcm.encrypt(&data[0], data_size);
+		unsigned char tag[AES_GCM::tag_size];
+		aes_gcm.get_tag(tag);
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  AES-%1 GCM encrypt: %2 MB/s", key_size * 8, (int)megabytes_per_second(data_size, elapsed));
+
+		// 16 KB records, as used by TLS
+		const int record_size = 16 * 1024;
+		start = System::get_microseconds();
+		for (int pos = 0; pos < data_size; pos += record_size)
+		{
+			aes_gcm.set_iv(iv);
+			aes_gcm.add_aad(iv, 13);
+			aes_gcm.decrypt(&data[pos], record_size);
+			aes_gcm.verify_tag(tag);
+		}
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  AES-%1 GCM decrypt, 16 KB records: %2 MB/s", key_size * 8, (int)megabytes_per_second(data_size, elapsed));
+	}
+}
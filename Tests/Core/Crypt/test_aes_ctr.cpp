@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_aes_ctr()
+{
+	Console::write_line(" Header: aes_ctr.h");
+	Console::write_line("  Class: AES_CTR");
+	Console::write_line(string_format("  Hardware accelerated: %1", AES_CTR::is_hardware_accelerated() ? "yes" : "no"));
+
+	// Test data from http://csrc.nist.gov/publications/nistpubs/800-38a/sp800-38a.pdf
+
+	const char *plaintext =
+		"6bc1bee22e409f96e93d7e117393172a"
+		"ae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52ef"
+		"f69f2445df4f9b17ad2b417be66c3710";
+
+	test_aes_ctr_helper(
+		"2b7e151628aed2a6abf7158809cf4f3c",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// COUNTER
+		plaintext,
+		"874d6191b620e3261bef6864990db6ce"	// CIPHERTEXT
+		"9806f66b7970fdff8617187bb9fffdff"
+		"5ae4df3edbd5d35e5b4f09020db03eab"
+		"1e031dda2fbe03d1792170a0f3009cee"
+		);
+
+	test_aes_ctr_helper(
+		"8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+		plaintext,
+		"1abc932417521ca24f2b0459fe7e6e0b"
+		"090339ec0aa6faefd5ccc2c6f4ce8e94"
+		"1e36b26bd1ebc670d1bd1d665620abf7"
+		"4f78a7f6d29809585a97daec58c6b050"
+		);
+
+	test_aes_ctr_helper(
+		"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+		plaintext,
+		"601ec313775789a5b7a7f504bbf3d228"
+		"f443e3ca4d62b59aca84e990cacaf5c5"
+		"2b0930daa23de94ce87017ba2d84988d"
+		"dfc9c58db67aada613c2dd08457941a6"
+		);
+
+	// The counter must carry across all 16 bytes
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> counter;
+	convert_ascii("2b7e151628aed2a6abf7158809cf4f3c", key);
+	convert_ascii("0000000000000000ffffffffffffffff", counter);
+
+	std::vector<unsigned char> data(20 * AES_CTR::block_size, 0);
+	AES_CTR aes_ctr;
+	aes_ctr.set_key(&key[0], key.size());
+	aes_ctr.set_iv(&counter[0]);
+	aes_ctr.process(&data[0], data.size());
+
+	for (int block = 0; block < 20; block++)
+	{
+		std::vector<unsigned char> single(AES_CTR::block_size, 0);
+		aes_ctr.set_iv(&counter[0]);
+		aes_ctr.process(&single[0], single.size());
+		if (memcmp(&single[0], &data[block * AES_CTR::block_size], AES_CTR::block_size))
+			fail();
+
+		for (int cnt = 15; cnt >= 0; cnt--)
+		{
+			if (++counter[cnt] != 0)
+				break;
+		}
+	}
+}
+
+void TestApp::test_aes_ctr_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr)
+{
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	std::vector<unsigned char> plaintext;
+	std::vector<unsigned char> ciphertext;
+
+	convert_ascii(key_ptr, key);
+	convert_ascii(iv_ptr, iv);
+	convert_ascii(plaintext_ptr, plaintext);
+	convert_ascii(ciphertext_ptr, ciphertext);
+
+	// Encrypt in place in one call
+	AES_CTR aes_ctr;
+	aes_ctr.set_key(&key[0], key.size());
+	aes_ctr.set_iv(&iv[0]);
+	std::vector<unsigned char> buffer = plaintext;
+	aes_ctr.process(&buffer[0], buffer.size());
+	if (buffer != ciphertext)
+		fail();
+
+	// Decrypt in pieces that do not line up with the blocks
+	aes_ctr.set_iv(&iv[0]);
+	std::vector<unsigned char> output(buffer.size());
+	int pos = 0;
+	for (int piece = 1; pos < (int)buffer.size(); piece += 7)
+	{
+		int size = min(piece, (int)buffer.size() - pos);
+		aes_ctr.process(&buffer[pos], &output[pos], size);
+		pos += size;
+	}
+	if (output != plaintext)
+		fail();
+}
@@ -0,0 +1,205 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_aes_gcm()
+{
+	Console::write_line(" Header: aes_gcm.h");
+	Console::write_line("  Class: AES_GCM");
+	Console::write_line(string_format("  Hardware accelerated: %1", AES_GCM::is_hardware_accelerated() ? "yes" : "no"));
+
+	// Test cases from "The Galois/Counter Mode of Operation (GCM)", McGrew and Viega
+
+	const char *plaintext =
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39";
+	const char *aad = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+
+	// Test case 1
+	test_aes_gcm_helper("00000000000000000000000000000000", "000000000000000000000000", "", "", "", "58e2fccefa7e3061367f1d57a4e7455a");
+
+	// Test case 2
+	test_aes_gcm_helper("00000000000000000000000000000000", "000000000000000000000000", "",
+		"00000000000000000000000000000000",
+		"0388dace60b6a392f328c2b971b2fe78",
+		"ab6e47d42cec13bdf53a67b21257bddf");
+
+	// Test case 3
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+		"4d5c2af327cd64a62cf35abd2ba6fab4");
+
+	// Test case 4
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", aad, plaintext,
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47");
+
+	// Test case 5 (short IV)
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308", "cafebabefacedbad", aad, plaintext,
+		"61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c742373806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+		"3612d2e79e3b0785561be14aaca2fccb");
+
+	// Test case 6 (long IV)
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308",
+		"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+		aad, plaintext,
+		"8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+		"619cc5aefffe0bfa462af43c1699d050");
+
+	// Test case 10 (AES-192)
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308feffe9928665731c", "cafebabefacedbaddecaf888", aad, plaintext,
+		"3980ca0b3c00e841eb06fac4872a2757859e1ceaa6efd984628593b40ca1e19c7d773d00c144c525ac619d18c84a3f4718e2448b2fe324d9ccda2710",
+		"2519498e80f1478f37ba55bd6d27618c");
+
+	// Test case 16 (AES-256)
+	test_aes_gcm_helper("feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", aad, plaintext,
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+		"76fc6ece0f4e1768cddf8853bb2d551b");
+
+	// Larger messages, in pieces that do not line up with the blocks, must give the same result as one call
+	std::vector<unsigned char> key(32);
+	std::vector<unsigned char> iv(AES_GCM::iv_size);
+	std::vector<unsigned char> header(100);
+	std::vector<unsigned char> message(5000);
+	for (size_t cnt = 0; cnt < message.size(); cnt++)
+		message[cnt] = (unsigned char)(cnt * 7 + 3);
+	for (size_t cnt = 0; cnt < header.size(); cnt++)
+		header[cnt] = (unsigned char)(cnt * 13 + 1);
+	for (size_t cnt = 0; cnt < key.size(); cnt++)
+		key[cnt] = (unsigned char)cnt;
+
+	AES_GCM aes_gcm;
+	aes_gcm.set_key(&key[0], key.size());
+	aes_gcm.set_iv(&iv[0]);
+	aes_gcm.add_aad(&header[0], header.size());
+	std::vector<unsigned char> whole = message;
+	aes_gcm.encrypt(&whole[0], whole.size());
+	unsigned char whole_tag[AES_GCM::tag_size];
+	aes_gcm.get_tag(whole_tag);
+
+	aes_gcm.set_iv(&iv[0]);
+	for (int pos = 0, piece = 1; pos < (int)header.size(); pos += piece, piece += 3)
+		aes_gcm.add_aad(&header[pos], min(piece, (int)header.size() - pos));
+	std::vector<unsigned char> pieces(message.size());
+	for (int pos = 0, piece = 1; pos < (int)message.size(); pos += piece, piece += 37)
+		aes_gcm.encrypt(&message[pos], &pieces[pos], min(piece, (int)message.size() - pos));
+	unsigned char pieces_tag[AES_GCM::tag_size];
+	aes_gcm.get_tag(pieces_tag);
+
+	if (pieces != whole || memcmp(pieces_tag, whole_tag, AES_GCM::tag_size))
+		fail();
+
+	// Decrypt and detect tampering
+	aes_gcm.set_iv(&iv[0]);
+	aes_gcm.add_aad(&header[0], header.size());
+	aes_gcm.decrypt(&pieces[0], pieces.size());
+	if (!aes_gcm.verify_tag(whole_tag) || pieces != message)
+		fail();
+
+	// Truncated tags down to 12 bytes are accepted, shorter ones are rejected
+	pieces = whole;
+	aes_gcm.set_iv(&iv[0]);
+	aes_gcm.add_aad(&header[0], header.size());
+	aes_gcm.decrypt(&pieces[0], pieces.size());
+	if (!aes_gcm.verify_tag(whole_tag, 12))
+		fail();
+
+	aes_gcm.set_iv(&iv[0]);
+	aes_gcm.add_aad(&header[0], header.size());
+	aes_gcm.decrypt(&pieces[0], pieces.size());
+	bool short_tag_rejected = false;
+	try
+	{
+		aes_gcm.verify_tag(whole_tag, 8);
+	}
+	catch (const Exception &)
+	{
+		short_tag_rejected = true;
+	}
+	if (!short_tag_rejected)
+		fail();
+
+	whole[1234] ^= 0x10;
+	aes_gcm.set_iv(&iv[0]);
+	aes_gcm.add_aad(&header[0], header.size());
+	aes_gcm.decrypt(&whole[0], whole.size());
+	if (aes_gcm.verify_tag(whole_tag))
+		fail();
+
+	// A tag can only be calculated once per IV
+	bool exception_thrown = false;
+	try
+	{
+		aes_gcm.get_tag(whole_tag);
+	}
+	catch (const Exception &)
+	{
+		exception_thrown = true;
+	}
+	if (!exception_thrown)
+		fail();
+}
+
+void TestApp::test_aes_gcm_helper(const char *key_ptr, const char *iv_ptr, const char *aad_ptr, const char *plaintext_ptr, const char *ciphertext_ptr, const char *tag_ptr)
+{
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	std::vector<unsigned char> aad;
+	std::vector<unsigned char> plaintext;
+	std::vector<unsigned char> ciphertext;
+	std::vector<unsigned char> tag;
+
+	convert_ascii(key_ptr, key);
+	convert_ascii(iv_ptr, iv);
+	convert_ascii(aad_ptr, aad);
+	convert_ascii(plaintext_ptr, plaintext);
+	convert_ascii(ciphertext_ptr, ciphertext);
+	convert_ascii(tag_ptr, tag);
+
+	AES_GCM aes_gcm;
+	aes_gcm.set_key(&key[0], key.size());
+	aes_gcm.set_iv(&iv[0], iv.size());
+	aes_gcm.add_aad(aad.data(), aad.size());
+	std::vector<unsigned char> buffer = plaintext;
+	aes_gcm.encrypt(buffer.data(), buffer.size());
+	unsigned char calculated_tag[AES_GCM::tag_size];
+	aes_gcm.get_tag(calculated_tag);
+	if (buffer != ciphertext || memcmp(calculated_tag, &tag[0], AES_GCM::tag_size))
+		fail();
+
+	aes_gcm.set_iv(&iv[0], iv.size());
+	aes_gcm.add_aad(aad.data(), aad.size());
+	aes_gcm.decrypt(buffer.data(), buffer.size());
+	if (!aes_gcm.verify_tag(&tag[0]) || buffer != plaintext)
+		fail();
+}
@@ -118,6 +118,24 @@ void TestApp::test_rsa()
 	if (memcmp(server.m_CryptKey.get_data(), client.m_CryptKey.get_data(), server.m_CryptKey.get_size()))
 		fail();
 
-}
+	Console::write_line("   ... Decrypting with the Chinese remainder theorem");
 
+	Random random;
+	Secret private_exponent, prime1, prime2, exponent1, exponent2, coefficient;
+	DataBuffer public_exponent, modulus;
+	RSA::create_keypair(random, private_exponent, public_exponent, modulus, prime1, prime2, exponent1, exponent2, coefficient);
 
+	for (int size = 1; size <= modulus.get_size() - 11; size += 29)
+	{
+		Secret message(size);
+		random.get_random_bytes(message.get_data(), size);
+		DataBuffer encrypted = RSA::encrypt(2, random, public_exponent, modulus, message);
+
+		Secret decrypted = RSA::decrypt(private_exponent, modulus, encrypted);
+		Secret decrypted_crt = RSA::decrypt(prime1, prime2, exponent1, exponent2, coefficient, modulus, encrypted);
+		if (decrypted.get_size() != size || decrypted_crt.get_size() != size)
+			fail();
+		if (memcmp(decrypted.get_data(), message.get_data(), size) || memcmp(decrypted_crt.get_data(), message.get_data(), size))
+			fail();
+	}
+}
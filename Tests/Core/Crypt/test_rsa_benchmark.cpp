@@ -0,0 +1,93 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	// Runs func repeatedly for about a second
+	double operations_per_second(const std::function<void()> &func)
+	{
+		int count = 0;
+		uint64_t start = System::get_microseconds();
+		uint64_t elapsed = 0;
+		while (elapsed < 1000000)
+		{
+			func();
+			count++;
+			elapsed = System::get_microseconds() - start;
+		}
+		return count * 1000000.0 / elapsed;
+	}
+
+	BigInt make_benchmark_number(Random &random, int num_bytes)
+	{
+		std::vector<unsigned char> bytes(num_bytes);
+		random.get_random_bytes(bytes.data(), num_bytes);
+		bytes[0] |= 0x80;
+		bytes[num_bytes - 1] |= 0x01;
+		BigInt value;
+		value.read_unsigned_octets(bytes.data(), num_bytes);
+		return value;
+	}
+}
+
+void TestApp::benchmark_rsa()
+{
+	Console::write_line(" RSA and modular exponentiation (single core, operations per second):");
+
+	Random random;
+	for (int bits = 2048; bits <= 4096; bits *= 2)
+	{
+		BigInt modulus = make_benchmark_number(random, bits / 8);
+		BigInt base = make_benchmark_number(random, bits / 8 - 1);
+		BigInt private_exponent = make_benchmark_number(random, bits / 8);
+		BigInt public_exponent(65537);
+		BigInt result;
+
+		double private_rate = operations_per_second([&]() { base.exptmod(&private_exponent, &modulus, &result); });
+		double public_rate = operations_per_second([&]() { base.exptmod(&public_exponent, &modulus, &result); });
+		Console::write_line("  %1 bit exptmod: %2 with a %3 bit exponent, %4 with exponent 65537", bits, StringHelp::double_to_text(private_rate, 1), bits, (int)public_rate);
+	}
+
+	Secret private_exponent, prime1, prime2, exponent1, exponent2, coefficient;
+	DataBuffer public_exponent, modulus;
+	uint64_t start = System::get_microseconds();
+	RSA::create_keypair(random, private_exponent, public_exponent, modulus, prime1, prime2, exponent1, exponent2, coefficient, 2048);
+	uint64_t elapsed = System::get_microseconds() - start;
+	Console::write_line("  RSA-2048 key pair created in %1 ms", (int)(elapsed / 1000));
+
+	Secret message(48);
+	random.get_random_bytes(message.get_data(), message.get_size());
+	DataBuffer encrypted;
+	double encrypt_rate = operations_per_second([&]() { encrypted = RSA::encrypt(2, random, public_exponent, modulus, message); });
+	double decrypt_rate = operations_per_second([&]() { RSA::decrypt(private_exponent, modulus, encrypted); });
+	double decrypt_crt_rate = operations_per_second([&]() { RSA::decrypt(prime1, prime2, exponent1, exponent2, coefficient, modulus, encrypted); });
+	Console::write_line("  RSA-2048 encrypt: %1, decrypt: %2, decrypt with CRT: %3", (int)encrypt_rate, StringHelp::double_to_text(decrypt_rate, 1), StringHelp::double_to_text(decrypt_crt_rate, 1));
+}
@@ -0,0 +1,97 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	double megabytes_per_second(uint64_t bytes, uint64_t microseconds)
+	{
+		return bytes / (double)max(microseconds, (uint64_t)1);
+	}
+
+	template<typename HashType>
+	void benchmark_hash(const char *name, const std::vector<unsigned char> &data, int buffer_size, WorkQueue &work_queue)
+	{
+		int data_size = (int)data.size();
+		unsigned char hash[HashType::hash_size];
+
+		uint64_t start = System::get_microseconds();
+		HashType single;
+		single.add(data.data(), data_size);
+		single.calculate();
+		single.get_hash(hash);
+		uint64_t elapsed = System::get_microseconds() - start;
+		Console::write_line("  %1 single stream: %2 MB/s", name, (int)megabytes_per_second(data_size, elapsed));
+
+		// The data split into independent buffers, like the assets of a content addressed cache
+		int count = data_size / buffer_size;
+		std::vector<const void *> buffers(count);
+		std::vector<int> sizes(count, buffer_size);
+		for (int i = 0; i < count; i++)
+			buffers[i] = &data[i * buffer_size];
+		std::vector<unsigned char> hashes(count * HashType::hash_size);
+
+		start = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+		{
+			HashType hash_one;
+			hash_one.add(buffers[i], sizes[i]);
+			hash_one.calculate();
+			hash_one.get_hash(&hashes[i * HashType::hash_size]);
+		}
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  %1 %2 byte buffers, one at a time: %3 MB/s", name, buffer_size, (int)megabytes_per_second(data_size, elapsed));
+
+		start = System::get_microseconds();
+		HashType::hash_many(count, buffers.data(), sizes.data(), hashes.data());
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  %1 %2 byte buffers, hash_many: %3 MB/s", name, buffer_size, (int)megabytes_per_second(data_size, elapsed));
+
+		start = System::get_microseconds();
+		HashType::hash_many(count, buffers.data(), sizes.data(), hashes.data(), &work_queue);
+		elapsed = System::get_microseconds() - start;
+		Console::write_line("  %1 %2 byte buffers, hash_many on %3 workers: %4 MB/s", name, buffer_size, work_queue.get_num_workers(), (int)megabytes_per_second(data_size, elapsed));
+	}
+}
+
+void TestApp::benchmark_sha()
+{
+	Console::write_line(" SHA throughput (SHA extensions: %1, AVX2: %2):",
+		System::detect_cpu_extension(System::sha) ? "yes" : "no",
+		System::detect_cpu_extension(System::avx2) ? "yes" : "no");
+
+	const int data_size = 32 * 1024 * 1024;
+	std::vector<unsigned char> data(data_size, 0x5a);
+	WorkQueue work_queue;
+
+	benchmark_hash<SHA1>("SHA-1", data, 4096, work_queue);
+	benchmark_hash<SHA256>("SHA-256", data, 4096, work_queue);
+	benchmark_hash<SHA256>("SHA-256", data, 256, work_queue);
+}
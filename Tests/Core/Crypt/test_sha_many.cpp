@@ -0,0 +1,122 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	template<typename HashType>
+	void hash_single(const std::vector<std::vector<unsigned char>> &buffers, std::vector<unsigned char> &out_hashes)
+	{
+		out_hashes.resize(buffers.size() * HashType::hash_size);
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			HashType hash;
+			hash.add(buffers[i].data(), (int)buffers[i].size());
+			hash.calculate();
+			hash.get_hash(&out_hashes[i * HashType::hash_size]);
+		}
+	}
+
+	template<typename HashType>
+	bool test_hash_many(const std::vector<std::vector<unsigned char>> &buffers, WorkQueue *work_queue)
+	{
+		std::vector<const void *> data;
+		std::vector<int> sizes;
+		for (auto &buffer : buffers)
+		{
+			data.push_back(buffer.data());
+			sizes.push_back((int)buffer.size());
+		}
+
+		std::vector<unsigned char> expected;
+		hash_single<HashType>(buffers, expected);
+
+		// Hashing a single buffer and subsets of different sizes must give the same results as the full set
+		for (int count = 1; count <= (int)buffers.size(); count = count * 3 + 1)
+		{
+			std::vector<unsigned char> hashes(count * HashType::hash_size, 0xcc);
+			HashType::hash_many(count, data.data(), sizes.data(), hashes.data(), work_queue);
+			if (memcmp(hashes.data(), expected.data(), hashes.size()))
+				return false;
+		}
+
+		std::vector<unsigned char> hashes(buffers.size() * HashType::hash_size, 0xcc);
+		HashType::hash_many((int)buffers.size(), data.data(), sizes.data(), hashes.data(), work_queue);
+		return hashes == expected;
+	}
+}
+
+void TestApp::test_sha_many()
+{
+	Console::write_line(" Function: SHA1::hash_many() and SHA256::hash_many()");
+
+	// All sizes around the padding boundaries, in a mixed order so lanes finish at different times
+	std::vector<std::vector<unsigned char>> buffers;
+	unsigned int seed = 1;
+	for (int i = 0; i < 200; i++)
+	{
+		int size = (i * 37) % 200;
+		if (i % 50 == 49)
+			size = 10000 + i;
+
+		std::vector<unsigned char> buffer(size);
+		for (auto &value : buffer)
+		{
+			seed = seed * 1103515245 + 12345;
+			value = (unsigned char)(seed >> 16);
+		}
+		buffers.push_back(buffer);
+	}
+
+	if (!test_hash_many<SHA1>(buffers, nullptr))
+		fail();
+	if (!test_hash_many<SHA256>(buffers, nullptr))
+		fail();
+
+	WorkQueue work_queue;
+	if (!test_hash_many<SHA1>(buffers, &work_queue))
+		fail();
+	if (!test_hash_many<SHA256>(buffers, &work_queue))
+		fail();
+
+	// Splitting the data over several add() calls must not change the result
+	const std::vector<unsigned char> &large = buffers[49];
+	SHA256 sha256;
+	for (int pos = 0; pos < (int)large.size(); pos += 100)
+		sha256.add(&large[pos], min(100, (int)large.size() - pos));
+	sha256.calculate();
+	unsigned char split_hash[SHA256::hash_size];
+	sha256.get_hash(split_hash);
+
+	std::vector<unsigned char> expected;
+	hash_single<SHA256>(buffers, expected);
+	if (memcmp(split_hash, &expected[49 * SHA256::hash_size], SHA256::hash_size))
+		fail();
+}
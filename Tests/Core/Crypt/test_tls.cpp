@@ -0,0 +1,761 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations so the benchmark can report allocations per TLS record
+namespace
+{
+	std::atomic<uint64_t> allocation_count(0);
+}
+
+void *operator new(size_t size)
+{
+	allocation_count++;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+namespace
+{
+	typedef std::vector<unsigned char> Bytes;
+
+	const int suite_aes128_cbc_sha = 0x2F;
+	const int suite_aes128_cbc_sha256 = 0x3C;
+	const int suite_aes128_gcm_sha256 = 0x9C;
+	const int suite_aes256_gcm_sha384 = 0x9D;
+
+	const char *suite_name(int suite)
+	{
+		switch (suite)
+		{
+		case suite_aes128_cbc_sha: return "TLS_RSA_WITH_AES_128_CBC_SHA";
+		case suite_aes128_cbc_sha256: return "TLS_RSA_WITH_AES_128_CBC_SHA256";
+		case suite_aes128_gcm_sha256: return "TLS_RSA_WITH_AES_128_GCM_SHA256";
+		case suite_aes256_gcm_sha384: return "TLS_RSA_WITH_AES_256_GCM_SHA384";
+		default: return "Unknown";
+		}
+	}
+
+	void append(Bytes &dest, const void *data, size_t size)
+	{
+		dest.insert(dest.end(), (const unsigned char *)data, (const unsigned char *)data + size);
+	}
+
+	void append_uint(Bytes &dest, unsigned int value, int num_bytes)
+	{
+		for (int i = num_bytes - 1; i >= 0; i--)
+			dest.push_back(value >> (i * 8));
+	}
+
+	void set_sequence_number(unsigned char *dest, uint64_t sequence_number)
+	{
+		for (int i = 0; i < 8; i++)
+			dest[i] = sequence_number >> ((7 - i) * 8);
+	}
+
+	// DER encoding of a tag and its content
+	Bytes der(unsigned char tag, const Bytes &content)
+	{
+		Bytes result;
+		result.push_back(tag);
+		if (content.size() < 0x80)
+		{
+			append_uint(result, content.size(), 1);
+		}
+		else if (content.size() < 0x100)
+		{
+			result.push_back(0x81);
+			append_uint(result, content.size(), 1);
+		}
+		else
+		{
+			result.push_back(0x82);
+			append_uint(result, content.size(), 2);
+		}
+		append(result, content.data(), content.size());
+		return result;
+	}
+
+	Bytes der_sequence(std::initializer_list<Bytes> items, unsigned char tag = 0x30)
+	{
+		Bytes content;
+		for (const auto &item : items)
+			append(content, item.data(), item.size());
+		return der(tag, content);
+	}
+
+	Bytes der_integer(const void *data, size_t size)
+	{
+		Bytes content;
+		if (size == 0 || (((const unsigned char *)data)[0] & 0x80))
+			content.push_back(0);
+		append(content, data, size);
+		return der(0x02, content);
+	}
+
+	Bytes der_text(unsigned char tag, const std::string &text)
+	{
+		return der(tag, Bytes(text.begin(), text.end()));
+	}
+
+	// Self-signed style certificate carrying the RSA public key. TLSClient does not verify the signature, so it is left empty
+	DataBuffer create_certificate(const DataBuffer &public_exponent, const DataBuffer &modulus)
+	{
+		const unsigned char version = 2, serial = 1;
+		Bytes sha256_with_rsa = der_sequence({ Bytes{ 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B }, Bytes{ 0x05, 0x00 } });
+		Bytes rsa_encryption = der_sequence({ Bytes{ 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01 }, Bytes{ 0x05, 0x00 } });
+		Bytes name = der_sequence({ der_sequence({ der_sequence({ Bytes{ 0x06, 0x03, 0x55, 0x04, 0x03 }, der_text(0x13, "localhost") }) }, 0x31) });
+		Bytes validity = der_sequence({ der_text(0x17, "200101000000Z"), der_text(0x17, "491231235959Z") });
+
+		Bytes public_key = der_sequence({ der_integer(modulus.get_data(), modulus.get_size()), der_integer(public_exponent.get_data(), public_exponent.get_size()) });
+		Bytes bit_string(1, 0);
+		append(bit_string, public_key.data(), public_key.size());
+		Bytes subject_public_key_info = der_sequence({ rsa_encryption, der(0x03, bit_string) });
+
+		Bytes tbs = der_sequence({ der_sequence({ der_integer(&version, 1) }, 0xA0), der_integer(&serial, 1), sha256_with_rsa, name, validity, name, subject_public_key_info });
+		Bytes certificate = der_sequence({ tbs, sha256_with_rsa, der(0x03, Bytes(1, 0)) });
+		return DataBuffer(certificate.data(), certificate.size());
+	}
+
+	template<typename HashFunction>
+	void hmac(const Bytes &key, const void *data1, int size1, const void *data2, int size2, unsigned char *output)
+	{
+		HashFunction hash;
+		hash.set_hmac(key.data(), key.size());
+		hash.add(data1, size1);
+		hash.add(data2, size2);
+		hash.calculate();
+		hash.get_hash(output);
+	}
+
+	// TLS 1.2 PRF (RFC 5246 section 5)
+	template<typename HashFunction>
+	Bytes prf(const Bytes &secret, const std::string &label, const Bytes &seed, int size)
+	{
+		Bytes label_seed(label.begin(), label.end());
+		append(label_seed, seed.data(), seed.size());
+
+		Bytes a(HashFunction::hash_size);
+		hmac<HashFunction>(secret, label_seed.data(), label_seed.size(), nullptr, 0, a.data());
+
+		Bytes output;
+		unsigned char block[HashFunction::hash_size];
+		while ((int)output.size() < size)
+		{
+			hmac<HashFunction>(secret, a.data(), a.size(), label_seed.data(), label_seed.size(), block);
+			append(output, block, HashFunction::hash_size);
+			hmac<HashFunction>(secret, a.data(), a.size(), nullptr, 0, a.data());
+		}
+		output.resize(size);
+		return output;
+	}
+
+	// Just enough of a TLS 1.2 server (RSA key exchange with one chosen cipher suite) to drive TLSClient over an in-memory loopback
+	class TLSStandInServer
+	{
+	public:
+		TLSStandInServer(int cipher_suite, const DataBuffer &certificate, const Secret &private_exponent, const DataBuffer &modulus)
+			: cipher_suite(cipher_suite), certificate(certificate), private_exponent(private_exponent), modulus(modulus)
+		{
+			is_aead = cipher_suite == suite_aes128_gcm_sha256 || cipher_suite == suite_aes256_gcm_sha384;
+			key_size = cipher_suite == suite_aes256_gcm_sha384 ? 32 : 16;
+			mac_size = cipher_suite == suite_aes128_cbc_sha ? SHA1::hash_size : cipher_suite == suite_aes128_cbc_sha256 ? SHA256::hash_size : 0;
+			fixed_iv_size = is_aead ? 4 : 0;
+			outgoing.reserve(256 * 1024);
+		}
+
+		bool is_connected() const { return connected; }
+
+		const void *get_outgoing_data() const { return outgoing.data() + outgoing_read_pos; }
+		int get_outgoing_data_available() const { return outgoing.size() - outgoing_read_pos; }
+
+		void outgoing_data_consumed(int size)
+		{
+			outgoing_read_pos += size;
+			if (outgoing_read_pos == outgoing.size())
+			{
+				outgoing.clear();
+				outgoing_read_pos = 0;
+			}
+		}
+
+		// Returns the last record queued for the client, to let tests tamper with it
+		unsigned char *get_last_record(int &out_size)
+		{
+			out_size = outgoing.size() - last_record_pos;
+			return outgoing.data() + last_record_pos;
+		}
+
+		void receive(const void *data, int size)
+		{
+			append(incoming, data, size);
+
+			size_t pos = 0;
+			while (incoming.size() - pos >= 5)
+			{
+				unsigned char *header = incoming.data() + pos;
+				int length = header[3] << 8 | header[4];
+				if (incoming.size() - pos < 5 + (size_t)length)
+					break;
+
+				int plaintext_size = open_record(header, header + 5, length);
+				const unsigned char *plaintext = header + 5 + (receive_encrypted && is_aead ? 8 : 0);
+				if (receive_encrypted && !is_aead)
+					plaintext = cbc_plaintext.data();
+
+				switch (header[0])
+				{
+				case 20:	// Change cipher spec
+					receive_encrypted = true;
+					read_sequence_number = 0;
+					break;
+				case 21:
+					throw Exception("Stand-in server received an alert");
+				case 22:
+					handshake_received(plaintext, plaintext_size);
+					break;
+				case 23:
+					received_bytes += plaintext_size;
+					if (keep_application_data)
+						append(application_data, plaintext, plaintext_size);
+					break;
+				}
+				pos += 5 + length;
+			}
+			incoming.erase(incoming.begin(), incoming.begin() + pos);
+		}
+
+		void send_application_data(const void *data, int size)
+		{
+			for (int pos = 0; pos < size; pos += 16384)
+				send_record(23, (const unsigned char *)data + pos, std::min(size - pos, 16384));
+		}
+
+		bool keep_application_data = true;
+		Bytes application_data;
+		uint64_t received_bytes = 0;
+
+	private:
+		void handshake_received(const unsigned char *data, int size)
+		{
+			int length = data[1] << 16 | data[2] << 8 | data[3];
+			if (length + 4 != size)
+				throw Exception("Stand-in server expects one handshake message per record");
+
+			switch (data[0])
+			{
+			case 1:	// Client hello
+				append(transcript, data, size);
+				client_hello_received(data + 4, length);
+				break;
+			case 16:	// Client key exchange
+				append(transcript, data, size);
+				client_key_exchange_received(data + 4, length);
+				break;
+			case 20:	// Finished
+				if (Bytes(data + 4, data + size) != verify_data("client finished"))
+					throw Exception("Stand-in server: client finished verify data is wrong");
+				append(transcript, data, size);
+				send_finished();
+				connected = true;
+				break;
+			default:
+				throw Exception("Stand-in server received an unexpected handshake message");
+			}
+		}
+
+		void client_hello_received(const unsigned char *data, int size)
+		{
+			if (data[0] != 3 || data[1] != 3)
+				throw Exception("Stand-in server expects a TLS 1.2 client hello");
+			client_random.assign(data + 2, data + 34);
+
+			const unsigned char *pos = data + 34;
+			pos += 1 + pos[0];	// Session id
+			int suites_length = pos[0] << 8 | pos[1];
+			bool found = false;
+			for (int i = 0; i < suites_length; i += 2)
+				found = found || (pos[2 + i] == 0 && pos[3 + i] == cipher_suite);
+			if (!found)
+				throw Exception("Client did not offer the cipher suite");
+
+			server_random.resize(32);
+			random.get_random_bytes(server_random.data(), 32);
+
+			// Server hello, certificate and server hello done are coalesced into one record like most servers do
+			Bytes messages, body;
+			body = { 3, 3 };
+			append(body, server_random.data(), 32);
+			append_uint(body, 0, 1);	// Session id
+			append_uint(body, cipher_suite, 2);
+			append_uint(body, 0, 1);	// Compression
+			append_handshake(messages, 2, body);
+
+			body.clear();
+			append_uint(body, certificate.get_size() + 3, 3);
+			append_uint(body, certificate.get_size(), 3);
+			append(body, certificate.get_data(), certificate.get_size());
+			append_handshake(messages, 11, body);
+
+			append_handshake(messages, 14, Bytes());
+			send_record(22, messages.data(), messages.size());
+		}
+
+		void client_key_exchange_received(const unsigned char *data, int size)
+		{
+			int length = data[0] << 8 | data[1];
+			Secret pre_master_secret = RSA::decrypt(private_exponent, modulus, DataBuffer(data + 2, length));
+			if (pre_master_secret.get_size() != 48 || pre_master_secret.get_data()[0] != 3 || pre_master_secret.get_data()[1] != 3)
+				throw Exception("Stand-in server: invalid pre-master secret");
+
+			Bytes seed = client_random;
+			append(seed, server_random.data(), 32);
+			master_secret = run_prf(Bytes(pre_master_secret.get_data(), pre_master_secret.get_data() + 48), "master secret", seed, 48);
+
+			seed = server_random;
+			append(seed, client_random.data(), 32);
+			Bytes key_block = run_prf(master_secret, "key expansion", seed, 2 * (mac_size + key_size + fixed_iv_size));
+			auto next = key_block.begin();
+			client_mac_key.assign(next, next + mac_size);	next += mac_size;
+			server_mac_key.assign(next, next + mac_size);	next += mac_size;
+			client_key.assign(next, next + key_size);	next += key_size;
+			server_key.assign(next, next + key_size);	next += key_size;
+			client_fixed_iv.assign(next, next + fixed_iv_size);	next += fixed_iv_size;
+			server_fixed_iv.assign(next, next + fixed_iv_size);
+
+			if (is_aead)
+			{
+				write_cipher.set_key(server_key.data(), key_size);
+				read_cipher.set_key(client_key.data(), key_size);
+			}
+		}
+
+		void send_finished()
+		{
+			const unsigned char change_cipher_spec = 1;
+			send_record(20, &change_cipher_spec, 1);
+			send_encrypted = true;
+			write_sequence_number = 0;
+
+			Bytes finished;
+			append_handshake(finished, 20, verify_data("server finished"));
+			send_record(22, finished.data(), finished.size());
+		}
+
+		Bytes verify_data(const std::string &label)
+		{
+			Bytes handshake_hash;
+			if (cipher_suite == suite_aes256_gcm_sha384)
+			{
+				handshake_hash.resize(SHA384::hash_size);
+				SHA384 sha384;
+				sha384.add(transcript.data(), transcript.size());
+				sha384.calculate();
+				sha384.get_hash(handshake_hash.data());
+			}
+			else
+			{
+				handshake_hash.resize(SHA256::hash_size);
+				SHA256 sha256;
+				sha256.add(transcript.data(), transcript.size());
+				sha256.calculate();
+				sha256.get_hash(handshake_hash.data());
+			}
+			return run_prf(master_secret, label, handshake_hash, 12);
+		}
+
+		Bytes run_prf(const Bytes &secret, const std::string &label, const Bytes &seed, int size)
+		{
+			if (cipher_suite == suite_aes256_gcm_sha384)
+				return prf<SHA384>(secret, label, seed, size);
+			else
+				return prf<SHA256>(secret, label, seed, size);
+		}
+
+		void append_handshake(Bytes &dest, unsigned char type, const Bytes &body)
+		{
+			size_t pos = dest.size();
+			dest.push_back(type);
+			append_uint(dest, body.size(), 3);
+			append(dest, body.data(), body.size());
+			append(transcript, dest.data() + pos, dest.size() - pos);
+		}
+
+		void set_additional_data(unsigned char *dest, uint64_t sequence_number, unsigned char type, int length)
+		{
+			set_sequence_number(dest, sequence_number);
+			dest[8] = type;
+			dest[9] = 3;
+			dest[10] = 3;
+			dest[11] = length >> 8;
+			dest[12] = length;
+		}
+
+		void send_record(unsigned char type, const unsigned char *data, int size)
+		{
+			last_record_pos = outgoing.size();
+			Bytes fragment;
+			const unsigned char *fragment_data = data;
+			int fragment_size = size;
+
+			if (send_encrypted && is_aead)
+			{
+				size_t pos = outgoing.size();
+				outgoing.resize(pos + 5 + 8 + size + AES_GCM::tag_size);
+				unsigned char *record = outgoing.data() + pos;
+				set_sequence_number(record + 5, write_sequence_number);
+
+				unsigned char nonce[AES_GCM::iv_size], additional_data[13];
+				memcpy(nonce, server_fixed_iv.data(), 4);
+				memcpy(nonce + 4, record + 5, 8);
+				set_additional_data(additional_data, write_sequence_number, type, size);
+				write_cipher.set_iv(nonce);
+				write_cipher.add_aad(additional_data, 13);
+				write_cipher.encrypt(data, record + 13, size);
+				write_cipher.get_tag(record + 13 + size);
+
+				fill_header(record, type, 8 + size + AES_GCM::tag_size);
+				write_sequence_number++;
+				return;
+			}
+			else if (send_encrypted)
+			{
+				// MAC-then-encrypt with an explicit IV
+				unsigned char mac_input[13], mac[SHA256::hash_size], iv[16];
+				set_additional_data(mac_input, write_sequence_number, type, size);
+				if (cipher_suite == suite_aes128_cbc_sha)
+					hmac<SHA1>(server_mac_key, mac_input, 13, data, size, mac);
+				else
+					hmac<SHA256>(server_mac_key, mac_input, 13, data, size, mac);
+				random.get_random_bytes(iv, 16);
+
+				AES128_Encrypt encrypt;
+				encrypt.set_iv(iv);
+				encrypt.set_key(server_key.data());
+				encrypt.set_padding(true, false);
+				encrypt.add(data, size);
+				encrypt.add(mac, mac_size);
+				encrypt.calculate();
+				DataBuffer ciphertext = encrypt.get_data();
+
+				fragment.assign(iv, iv + 16);
+				append(fragment, ciphertext.get_data(), ciphertext.get_size());
+				fragment_data = fragment.data();
+				fragment_size = fragment.size();
+			}
+
+			size_t pos = outgoing.size();
+			outgoing.resize(pos + 5 + fragment_size);
+			fill_header(outgoing.data() + pos, type, fragment_size);
+			memcpy(outgoing.data() + pos + 5, fragment_data, fragment_size);
+			if (send_encrypted)
+				write_sequence_number++;
+		}
+
+		void fill_header(unsigned char *record, unsigned char type, int length)
+		{
+			record[0] = type;
+			record[1] = 3;
+			record[2] = 3;
+			record[3] = length >> 8;
+			record[4] = length;
+		}
+
+		// Decrypts in place for AEAD suites and into cbc_plaintext for CBC suites, returns the plaintext size
+		int open_record(const unsigned char *header, unsigned char *fragment, int size)
+		{
+			if (!receive_encrypted)
+				return size;
+
+			if (is_aead)
+			{
+				int plaintext_size = size - 8 - AES_GCM::tag_size;
+				unsigned char nonce[AES_GCM::iv_size], additional_data[13];
+				memcpy(nonce, client_fixed_iv.data(), 4);
+				memcpy(nonce + 4, fragment, 8);
+				set_additional_data(additional_data, read_sequence_number++, header[0], plaintext_size);
+				read_cipher.set_iv(nonce);
+				read_cipher.add_aad(additional_data, 13);
+				read_cipher.decrypt(fragment + 8, plaintext_size);
+				if (!read_cipher.verify_tag(fragment + 8 + plaintext_size))
+					throw Exception("Stand-in server: record authentication failed");
+				return plaintext_size;
+			}
+
+			AES128_Decrypt decrypt;
+			decrypt.set_iv(fragment);
+			decrypt.set_key(client_key.data());
+			decrypt.set_padding(true, false);
+			decrypt.add(fragment + 16, size - 16);
+			if (!decrypt.calculate())
+				throw Exception("Stand-in server: CBC padding is wrong");
+			DataBuffer decrypted = decrypt.get_data();
+			int plaintext_size = decrypted.get_size() - mac_size;
+
+			unsigned char mac_input[13], mac[SHA256::hash_size];
+			set_additional_data(mac_input, read_sequence_number++, header[0], plaintext_size);
+			if (cipher_suite == suite_aes128_cbc_sha)
+				hmac<SHA1>(client_mac_key, mac_input, 13, decrypted.get_data(), plaintext_size, mac);
+			else
+				hmac<SHA256>(client_mac_key, mac_input, 13, decrypted.get_data(), plaintext_size, mac);
+			if (memcmp(mac, decrypted.get_data() + plaintext_size, mac_size))
+				throw Exception("Stand-in server: record MAC is wrong");
+
+			cbc_plaintext.assign(decrypted.get_data(), decrypted.get_data() + plaintext_size);
+			return plaintext_size;
+		}
+
+		int cipher_suite;
+		DataBuffer certificate;
+		Secret private_exponent;
+		DataBuffer modulus;
+		Random random;
+
+		bool is_aead;
+		int key_size;
+		int mac_size;
+		int fixed_iv_size;
+
+		Bytes incoming;
+		Bytes outgoing;
+		size_t outgoing_read_pos = 0;
+		size_t last_record_pos = 0;
+		Bytes cbc_plaintext;
+
+		Bytes transcript;
+		Bytes client_random, server_random, master_secret;
+		Bytes client_mac_key, server_mac_key, client_key, server_key, client_fixed_iv, server_fixed_iv;
+		AES_GCM write_cipher, read_cipher;
+		uint64_t write_sequence_number = 0;
+		uint64_t read_sequence_number = 0;
+		bool send_encrypted = false;
+		bool receive_encrypted = false;
+		bool connected = false;
+	};
+
+	// Moves data between the client and the stand-in server until neither has anything left to deliver.
+	// Time and allocations spent inside TLSClient are added to client_microseconds and client_allocations
+	void pump(TLSClient &client, TLSStandInServer &server, Bytes *client_received, uint64_t &client_microseconds, uint64_t &client_allocations)
+	{
+		while (true)
+		{
+			uint64_t start_time = System::get_microseconds();
+			uint64_t start_allocations = allocation_count;
+
+			bool progress = false;
+			int available = client.get_encrypted_data_available();
+			if (available > 0)
+			{
+				client_microseconds += System::get_microseconds() - start_time;
+				client_allocations += allocation_count - start_allocations;
+				server.receive(client.get_encrypted_data(), available);
+				start_time = System::get_microseconds();
+				start_allocations = allocation_count;
+				client.encrypted_data_consumed(available);
+				progress = true;
+			}
+
+			available = server.get_outgoing_data_available();
+			if (available > 0)
+			{
+				int consumed = client.decrypt(server.get_outgoing_data(), available);
+				server.outgoing_data_consumed(consumed);
+				progress = progress || consumed > 0;
+			}
+
+			available = client.get_decrypted_data_available();
+			if (available > 0)
+			{
+				if (client_received)
+					append(*client_received, client.get_decrypted_data(), available);
+				client.decrypted_data_consumed(available);
+				progress = true;
+			}
+
+			client_microseconds += System::get_microseconds() - start_time;
+			client_allocations += allocation_count - start_allocations;
+			if (!progress)
+				break;
+		}
+	}
+
+	void pump(TLSClient &client, TLSStandInServer &server, Bytes *client_received = nullptr)
+	{
+		uint64_t microseconds = 0, allocations = 0;
+		pump(client, server, client_received, microseconds, allocations);
+	}
+
+	struct TLSTestKey
+	{
+		TLSTestKey()
+		{
+			Random random;
+			RSA::create_keypair(random, private_exponent, public_exponent, modulus, 1024);
+			certificate = create_certificate(public_exponent, modulus);
+		}
+
+		Secret private_exponent;
+		DataBuffer public_exponent, modulus, certificate;
+	};
+
+	void connect(TLSClient &client, TLSStandInServer &server)
+	{
+		const char hello[] = "hello";
+		client.encrypt(hello, 5);
+		pump(client, server);
+		if (!server.is_connected() || server.application_data != Bytes(hello, hello + 5))
+			throw Exception("TLS handshake with the stand-in server failed");
+		server.application_data.clear();
+		server.received_bytes = 0;
+	}
+}
+
+void TestApp::test_tls()
+{
+	Console::write_line(" Header: tls_client.h");
+	Console::write_line("  Class: TLSClient");
+	Console::write_line("   Function: handshake and records against a local stand-in server");
+
+	TLSTestKey key;
+	Random random;
+	const int sizes[] = { 1, 15, 16, 100, 16383, 16384, 16385, 50000, 200000 };
+	const int suites[] = { suite_aes128_gcm_sha256, suite_aes256_gcm_sha384, suite_aes128_cbc_sha256, suite_aes128_cbc_sha };
+	for (int suite : suites)
+	{
+		TLSClient client;
+		TLSStandInServer server(suite, key.certificate, key.private_exponent, key.modulus);
+		connect(client, server);
+
+		for (int size : sizes)
+		{
+			Bytes data(size);
+			random.get_random_bytes(data.data(), size);
+
+			// The client may not take all of a large block at once
+			for (int pos = 0; pos < size; )
+			{
+				pos += client.encrypt(data.data() + pos, size - pos);
+				pump(client, server);
+			}
+			if (server.application_data != data)
+				fail();
+			server.application_data.clear();
+
+			Bytes received;
+			server.send_application_data(data.data(), size);
+			pump(client, server, &received);
+			if (received != data)
+				fail();
+		}
+	}
+
+	Console::write_line("   Function: rejects a tampered AES-GCM record");
+	{
+		TLSClient client;
+		TLSStandInServer server(suite_aes128_gcm_sha256, key.certificate, key.private_exponent, key.modulus);
+		connect(client, server);
+
+		const char message[] = "tampered";
+		server.send_application_data(message, 8);
+		int record_size = 0;
+		unsigned char *record = server.get_last_record(record_size);
+		record[record_size - 1] ^= 1;
+
+		bool rejected = false;
+		try
+		{
+			pump(client, server);
+		}
+		catch (const Exception &)
+		{
+			rejected = true;
+		}
+		if (!rejected)
+			fail();
+	}
+}
+
+void TestApp::benchmark_tls()
+{
+	Console::write_line(" TLS record layer over an in-memory loopback (time spent in TLSClient only):");
+
+	TLSTestKey key;
+	const int total_size = 64 * 1024 * 1024;
+	const int block_size = 64 * 1024;
+	const int records = total_size / 16384;
+	Bytes block(block_size, 'x');
+
+	const int suites[] = { suite_aes128_gcm_sha256, suite_aes256_gcm_sha384, suite_aes128_cbc_sha256, suite_aes128_cbc_sha };
+	for (int suite : suites)
+	{
+		TLSClient client;
+		TLSStandInServer server(suite, key.certificate, key.private_exponent, key.modulus);
+		connect(client, server);
+		server.keep_application_data = false;
+
+		uint64_t send_microseconds = 0, send_allocations = 0;
+		for (int sent = 0; sent < total_size; )
+		{
+			uint64_t start_time = System::get_microseconds();
+			uint64_t start_allocations = allocation_count;
+			int consumed = client.encrypt(block.data(), block_size);
+			send_microseconds += System::get_microseconds() - start_time;
+			send_allocations += allocation_count - start_allocations;
+			sent += consumed;
+			pump(client, server, nullptr, send_microseconds, send_allocations);
+		}
+		if (server.received_bytes != (uint64_t)total_size)
+			fail();
+
+		uint64_t receive_microseconds = 0, receive_allocations = 0;
+		for (int received = 0; received < total_size; received += block_size)
+		{
+			server.send_application_data(block.data(), block_size);
+			pump(client, server, nullptr, receive_microseconds, receive_allocations);
+		}
+
+		Console::write_line("  %1: send %2 MB/s, receive %3 MB/s, %4 and %5 allocations per record",
+			suite_name(suite),
+			(int)(total_size / std::max(send_microseconds, (uint64_t)1)),
+			(int)(total_size / std::max(receive_microseconds, (uint64_t)1)),
+			StringHelp::double_to_text(send_allocations / (double)records, 2),
+			StringHelp::double_to_text(receive_allocations / (double)records, 2));
+	}
+}
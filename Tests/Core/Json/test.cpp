@@ -0,0 +1,257 @@
+#include <ClanLib/core.h>
+#include <cmath>
+#include <random>
+
+using namespace clan;
+
+// Correctness checks and parse throughput benchmark for JsonValue, JsonReader and JsonDocument
+//
+// Usage: json [megabytes of generated level data] [iterations]
+
+namespace
+{
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	// Writes every event as text, so that two parses can be compared
+	class RecordingHandler : public JsonHandler
+	{
+	public:
+		std::string events;
+
+		void null_value() override { events += "n;"; }
+		void boolean_value(bool value) override { events += value ? "t;" : "f;"; }
+		void number_value(double value) override { events += StringHelp::double_to_text(value, 17) + ";"; }
+		void string_value(const char *data, size_t length) override { events += "s" + std::string(data, length) + ";"; }
+		void begin_object() override { events += "{"; }
+		void object_key(const char *data, size_t length) override { events += "k" + std::string(data, length) + ":"; }
+		void end_object() override { events += "}"; }
+		void begin_array() override { events += "["; }
+		void end_array() override { events += "]"; }
+	};
+
+	// Counts values, as the least work a SAX user would do
+	class CountingHandler : public JsonHandler
+	{
+	public:
+		size_t values = 0;
+		double sum = 0.0;
+
+		void null_value() override { values++; }
+		void boolean_value(bool value) override { values++; }
+		void number_value(double value) override { values++; sum += value; }
+		void string_value(const char *data, size_t length) override { values++; }
+	};
+
+	// Hands out the data in small pieces, to test values split between reads
+	class TrickleProvider : public IODeviceProvider
+	{
+	public:
+		TrickleProvider(const std::string &data, size_t piece) : data(data), piece(piece) { }
+
+		size_t get_size() const override { return data.size(); }
+		size_t get_position() const override { return position; }
+		size_t send(const void *, size_t, bool) override { return 0; }
+		size_t receive(void *buffer, size_t size, bool) override
+		{
+			size_t length = std::min(std::min(size, piece), data.size() - position);
+			memcpy(buffer, data.data() + position, length);
+			position += length;
+			return length;
+		}
+		size_t peek(void *, size_t) override { return 0; }
+		bool seek(int, IODevice::SeekMode) override { return false; }
+		IODeviceProvider *duplicate() override { return nullptr; }
+
+	private:
+		std::string data;
+		size_t piece;
+		size_t position = 0;
+	};
+
+	// A level file with entities, components and some text
+	std::string generate_level(size_t target_size)
+	{
+		std::minstd_rand random;
+		std::uniform_real_distribution<double> coordinate(-4096.0, 4096.0);
+		const char *types[] = { "tree", "rock", "enemy", "pickup", "light", "trigger" };
+
+		std::string json = "{\"name\":\"Generated level\",\"version\":3,\"gravity\":-9.81,\"entities\":[";
+		for (int id = 0; json.size() < target_size; id++)
+		{
+			if (id > 0)
+				json += ",";
+			json += string_format("\n  {\"id\":%1,\"type\":\"%2\",\"visible\":%3,\"parent\":null,", id, types[id % 6], id % 7 ? "true" : "false");
+			json += string_format("\"position\":[%1,%2,%3],", StringHelp::double_to_text(coordinate(random), 3), StringHelp::double_to_text(coordinate(random), 3), StringHelp::double_to_text(coordinate(random), 3));
+			json += string_format("\"rotation\":%1,\"scale\":1.5e0,", StringHelp::double_to_text(coordinate(random) / 1000.0, 6));
+			json += string_format("\"tags\":[\"static\",\"layer%1\"],", id % 16);
+			json += string_format("\"components\":{\"health\":%1,\"speed\":%2,\"script\":\"on_spawn(\\\"entity %3\\\")\\n\",\"label\":\"Caf\\u00e9 %3\"}}", 100 + id % 50, StringHelp::double_to_text(id * 0.25, 2), id);
+		}
+		json += "\n]}";
+		return json;
+	}
+
+	void test_values()
+	{
+		JsonDocument doc = JsonDocument::parse("{ \"b\": [1, -2.5, 1e3, 3E-2, 0, -0, 12345678901234567890, 1.7976931348623157e308],\n\t\"a\": \"x\\\"y\\\\z\\/\\b\\f\\n\\r\\t\\u00e6\\u20ac\\ud83d\\ude00\", \"c\": {\"t\": true, \"f\": false, \"n\": null}, \"a\": \"last\" }");
+		JsonNode root = doc.root();
+		if (!root.is_object() || root.size() != 3)
+			fail("Object not parsed");
+		if (root.key(0) != "a" || root.key(1) != "b" || root.key(2) != "c")
+			fail("Properties are not sorted");
+		if (root["a"].to_string() != "last")
+			fail("Duplicate property did not keep the last value");
+
+		JsonNode b = root["b"];
+		double expected[] = { 1, -2.5, 1000, 0.03, 0, 0, 12345678901234567890.0, 1.7976931348623157e308 };
+		if (b.size() != 8)
+			fail("Array not parsed");
+		for (int i = 0; i < 8; i++)
+		{
+			if (b[i].to_number() != expected[i])
+				fail(string_format("Number %1 parsed as %2", i, StringHelp::double_to_text(b[i].to_number(), 17)));
+		}
+		if (!std::signbit(b[5].to_number()))
+			fail("Negative zero lost its sign");
+
+		if (!root["c"]["t"].to_boolean() || root["c"]["f"].to_boolean() || !root["c"]["n"].is_null() || !root["c"]["missing"].is_undefined() || !root["b"][8].is_undefined())
+			fail("Literals or missing values not handled");
+
+		RecordingHandler handler;
+		JsonReader::parse(std::string("[\"x\\\"y\\\\z\\/\\b\\f\\n\\r\\t\\u00e6\\u20ac\\ud83d\\ude00\"]"), handler);
+		if (handler.events != "[sx\"y\\z/\b\f\n\r\t\xc3\xa6\xe2\x82\xac\xf0\x9f\x98\x80;]")
+			fail("Escape sequences decoded incorrectly");
+	}
+
+	void test_errors()
+	{
+		const char *bad[] =
+		{
+			"", "{", "[1,", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "[tru]", "\"abc", "\"\\q\"", "\"\\u12g4\"", "-", "1.", "1e", "{1:2}", "[1}",
+			"1 2", "{} x", "[1]]", "truex", "\"a\" \"b\"", "{\"a\":1}\n,",
+			"\"a\nb\"", "\"\t\"", "{\"a\x01\":1}", "[\"0123456789abcdefghij\x1f" "0123456789\"]"
+		};
+		for (auto json : bad)
+		{
+			int thrown = 0;
+			try
+			{
+				JsonDocument::parse(std::string(json));
+			}
+			catch (const JsonException &)
+			{
+				thrown++;
+			}
+			try
+			{
+				IODevice device(new TrickleProvider(json, 1));
+				CountingHandler handler;
+				JsonReader::parse(device, handler);
+			}
+			catch (const JsonException &)
+			{
+				thrown++;
+			}
+			if (thrown != 2)
+				fail(string_format("No exception for malformed JSON '%1'", json));
+		}
+
+		// Trailing whitespace and bytes above the control characters are allowed
+		const char *good[] = { "1 ", "{}\r\n\t ", "\"\x7f\xc3\xa9 0123456789abcdef\xe2\x82\xac\"" };
+		for (auto json : good)
+		{
+			JsonDocument::parse(std::string(json));
+			IODevice device(new TrickleProvider(json, 1));
+			CountingHandler handler;
+			JsonReader::parse(device, handler);
+		}
+
+		// Nesting is not limited by the call stack
+		std::string deep(100000, '[');
+		deep += std::string(100000, ']');
+		CountingHandler handler;
+		JsonReader::parse(deep, handler);
+	}
+
+	// Every event must be the same when values are split between reads of an IODevice
+	void test_streaming(const std::string &json)
+	{
+		RecordingHandler memory_events;
+		JsonReader::parse(json, memory_events);
+
+		size_t pieces[] = { 1, 7, 4096 };
+		for (size_t piece : pieces)
+		{
+			IODevice device(new TrickleProvider(json, piece));
+			RecordingHandler stream_events;
+			JsonReader::parse(device, stream_events);
+			if (stream_events.events != memory_events.events)
+				fail(string_format("Streamed parse in pieces of %1 bytes differs from parsing in memory", (int)piece));
+		}
+	}
+
+	// The document must hold exactly what JsonValue::parse produces
+	void test_equivalence(const std::string &json)
+	{
+		std::string expected = JsonValue::parse(json).to_json();
+		std::string actual = JsonDocument::parse(json).root().to_value().to_json();
+		if (expected != actual)
+			fail("JsonDocument differs from JsonValue::parse");
+	}
+
+	template<typename Func>
+	void measure(const char *name, const std::string &json, int iterations, Func func)
+	{
+		uint64_t best = ~(uint64_t)0;
+		for (int i = 0; i < iterations; i++)
+		{
+			uint64_t start = System::get_microseconds();
+			func();
+			best = std::min(best, System::get_microseconds() - start);
+		}
+		best = std::max(best, (uint64_t)1);
+		Console::write_line("  %1 %2 ms, %3 MB/s", name, StringHelp::double_to_text(best / 1000.0, 1), StringHelp::double_to_text(json.size() / (double)best, 1));
+	}
+
+	void benchmark(const std::string &json, int iterations)
+	{
+		Console::write_line("Parsing %1 KB of level data, best of %2:", (int)(json.size() / 1024), iterations);
+
+		measure("JsonValue::parse:             ", json, iterations, [&]() { JsonValue::parse(json); });
+		measure("JsonDocument::parse:          ", json, iterations, [&]() { JsonDocument::parse(json); });
+		measure("JsonReader::parse:            ", json, iterations, [&]() { CountingHandler handler; JsonReader::parse(json, handler); });
+		measure("JsonReader::parse (IODevice): ", json, iterations, [&]()
+		{
+			IODevice device(new TrickleProvider(json, 1 << 20));
+			CountingHandler handler;
+			JsonReader::parse(device, handler);
+		});
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int megabytes = argc > 1 ? StringHelp::text_to_int(argv[1]) : 16;
+		int iterations = argc > 2 ? StringHelp::text_to_int(argv[2]) : 5;
+
+		test_values();
+		test_errors();
+
+		std::string small_level = generate_level(200 * 1024);
+		test_streaming(small_level);
+		test_equivalence(small_level);
+
+		benchmark(generate_level(megabytes * 1024 * 1024), iterations);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -29,6 +29,47 @@
 
 #include "test.h"
 
+namespace
+{
+	BigInt make_random_bigint(unsigned int &seed, int num_bytes)
+	{
+		std::vector<unsigned char> bytes(num_bytes);
+		for (auto &value : bytes)
+		{
+			seed = seed * 1103515245 + 12345;
+			value = (unsigned char)(seed >> 16);
+		}
+		bytes[0] |= 0x80;
+		BigInt value;
+		value.read_unsigned_octets(bytes.data(), num_bytes);
+		return value;
+	}
+
+	BigInt power_of_two(unsigned int bit)
+	{
+		BigInt value(0);
+		value.set_bit(bit, 1);
+		return value;
+	}
+
+	// a * b from the products with 1024 bit pieces of b, which are all too small for Karatsuba
+	BigInt piecewise_product(BigInt a, BigInt b)
+	{
+		BigInt piece_size = power_of_two(1024);
+		std::vector<BigInt> pieces;
+		while (b.cmp_z() > 0)
+		{
+			pieces.push_back(b % piece_size);
+			b = b / piece_size;
+		}
+
+		BigInt product(0);
+		for (auto it = pieces.rbegin(); it != pieces.rend(); ++it)
+			product = product * piece_size + a * (*it);
+		return product;
+	}
+}
+
 void TestApp::test_bigint(void)
 {
 	Console::write_line(" Header: bigint.h");
@@ -330,4 +371,86 @@ void TestApp::test_bigint(void)
 		if (!value.is_even())
 			fail();
 	}
+	Console::write_line("   Function: operator * (large operands)");
+	{
+		// Karatsuba products must match the sum of schoolbook products
+		unsigned int seed = 1;
+		for (int bytes = 200; bytes <= 600; bytes += 100)
+		{
+			BigInt a = make_random_bigint(seed, 512);
+			BigInt b = make_random_bigint(seed, bytes);
+			BigInt expected = piecewise_product(a, b);
+			BigInt expected_square = piecewise_product(a, a);
+
+			BigInt product = a * b;
+			if (product.cmp(&expected) != 0)
+				fail();
+			BigInt square;
+			a.sqr(&square);
+			if (square.cmp(&expected_square) != 0)
+				fail();
+			if ((product / b).cmp(&a) != 0)
+				fail();
+		}
+	}
+
+	Console::write_line("   Function: exptmod()");
+	{
+		unsigned int seed = 2;
+		BigInt one(1), zero(0), result;
+
+		// Fermat's little theorem for the Mersenne prime 2^521 - 1
+		BigInt prime = power_of_two(521) - 1;
+		BigInt prime_minus_one = prime - 1;
+		BigInt base = make_random_bigint(seed, 60);
+		base.exptmod(&prime_minus_one, &prime, &result);
+		if (result.cmp(&one) != 0)
+			fail();
+
+		base.exptmod(&zero, &prime, &result);
+		if (result.cmp(&one) != 0)
+			fail();
+		base.exptmod(&prime_minus_one, &one, &result);
+		if (result.cmp_z() != 0)
+			fail();
+
+		for (int bytes = 64; bytes <= 256; bytes += 64)
+		{
+			BigInt modulus = make_random_bigint(seed, bytes);
+			if (modulus.is_even())
+				modulus += 1;
+			BigInt base = make_random_bigint(seed, bytes + 8);
+
+			// Small exponents against repeated multiplication
+			BigInt expected = one;
+			for (uint32_t exponent = 0; exponent < 20; exponent++)
+			{
+				BigInt e(exponent);
+				base.exptmod(&e, &modulus, &result);
+				if (result.cmp(&expected) != 0)
+					fail();
+				expected = (expected * base) % modulus;
+			}
+
+			// Odd moduli use Montgomery multiplication and even moduli Barrett reduction, which must agree
+			BigInt exponent = make_random_bigint(seed, bytes);
+			BigInt even_modulus = modulus * 2;
+			BigInt even_result;
+			base.exptmod(&exponent, &modulus, &result);
+			base.exptmod(&exponent, &even_modulus, &even_result);
+			even_result = even_result % modulus;
+			if (result.cmp(&even_result) != 0)
+				fail();
+
+			// a^(e1 + e2) = a^e1 * a^e2
+			BigInt exponent2 = make_random_bigint(seed, bytes / 2);
+			BigInt exponent_sum = exponent + exponent2;
+			BigInt result2, result_sum;
+			base.exptmod(&exponent2, &modulus, &result2);
+			base.exptmod(&exponent_sum, &modulus, &result_sum);
+			BigInt combined = (result * result2) % modulus;
+			if (result_sum.cmp(&combined) != 0)
+				fail();
+		}
+	}
 }
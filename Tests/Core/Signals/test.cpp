@@ -0,0 +1,225 @@
+#include <ClanLib/core.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace clan;
+
+// Correctness checks and emit benchmark for Signal
+//
+// Usage: signals [emits]
+//
+// The benchmark compares the emit cost with 0, 1 and 32 connected slots against a signal that
+// copies its list of weak slot pointers on every emit, as Signal used to.
+
+namespace
+{
+	std::atomic<size_t> allocation_count(0);
+}
+
+void *operator new(size_t size)
+{
+	allocation_count++;
+	void *data = malloc(size ? size : 1);
+	if (!data)
+		throw std::bad_alloc();
+	return data;
+}
+
+void operator delete(void *data) noexcept
+{
+	free(data);
+}
+
+namespace
+{
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	class Receiver
+	{
+	public:
+		void on_value(int value) { sum += value; }
+		int on_value_returning(int value) { sum += value; return sum; }
+
+		int sum = 0;
+	};
+
+	// Signal as it was before slots were stored in place
+	template<typename FuncType>
+	class CopyingSignal
+	{
+	public:
+		template<typename... Args>
+		void operator()(Args&&... args)
+		{
+			std::vector<std::weak_ptr<std::function<FuncType>>> copy = slots;
+			for (auto &weak_slot : copy)
+			{
+				std::shared_ptr<std::function<FuncType>> slot = weak_slot.lock();
+				if (slot)
+					(*slot)(std::forward<Args>(args)...);
+			}
+		}
+
+		std::shared_ptr<std::function<FuncType>> connect(const std::function<FuncType> &func)
+		{
+			auto slot = std::make_shared<std::function<FuncType>>(func);
+			slots.push_back(slot);
+			return slot;
+		}
+
+	private:
+		std::vector<std::weak_ptr<std::function<FuncType>>> slots;
+	};
+}
+
+void test_emit()
+{
+	Signal<void(int)> signal;
+	if (signal.has_slots())
+		fail("New signal has slots");
+
+	std::string order;
+	Slot a = signal.connect([&](int value) { order += "a" + StringHelp::int_to_text(value); });
+	Receiver receiver;
+	Slot b = signal.connect(&receiver, &Receiver::on_value);
+	Slot c = signal.connect(&receiver, &Receiver::on_value_returning);
+
+	signal(5);
+	if (order != "a5" || receiver.sum != 10)
+		fail("Slots were not called with the emitted value");
+
+	b = Slot();
+	c = Slot();
+	a = Slot();
+	signal(1);
+	if (order != "a5" || receiver.sum != 10 || signal.has_slots())
+		fail("Disconnected slots were called");
+
+	// A callable that does not fit the inline storage
+	char padding[100] = { 1 };
+	int large_calls = 0;
+	Slot large = signal.connect([&, padding](int value) { large_calls += padding[0] * value; });
+	signal(2);
+	if (large_calls != 2)
+		fail("Large callback was not called");
+}
+
+void test_mutation_during_emit()
+{
+	Signal<void()> signal;
+	std::string calls;
+	Slot first, second, third, added;
+
+	first = signal.connect([&]() { calls += "1"; first = Slot(); third = Slot(); });
+	second = signal.connect([&]() { calls += "2"; if (!added) added = signal.connect([&]() { calls += "+"; }); });
+	third = signal.connect([&]() { calls += "3"; });
+
+	signal();
+	if (calls != "12")
+		fail("Slots disconnected or connected during an emit were called by it");
+
+	calls.clear();
+	signal();
+	if (calls != "2+")
+		fail("Slot connected during an emit was not called by the next one");
+
+	// A reused entry must not be disconnected by the handle of the slot it replaced
+	Slot stale = signal.connect([&]() { calls += "s"; });
+	Slot copy = stale;
+	stale = Slot();
+	copy = Slot();
+	Slot reused = signal.connect([&]() { calls += "r"; });
+	calls.clear();
+	signal();
+	if (calls != "2+r")
+		fail("Reused slot entry was not called");
+
+	// The signal may be destroyed by one of its slots
+	std::unique_ptr<Signal<void()>> owned(new Signal<void()>());
+	int owned_calls = 0;
+	Slot destroyer = owned->connect([&]() { owned_calls++; owned.reset(); });
+	Slot after = owned->connect([&]() { owned_calls++; });
+	(*owned)();
+	if (owned || owned_calls != 2)
+		fail("Signal destroyed during its emit did not finish the emit");
+}
+
+void test_allocations()
+{
+	for (int slot_count : { 0, 1, 32 })
+	{
+		Signal<void(int)> signal;
+		Receiver receiver;
+		std::vector<Slot> slots;
+		for (int i = 0; i < slot_count; i++)
+			slots.push_back(signal.connect(&receiver, &Receiver::on_value));
+
+		size_t before = allocation_count;
+		for (int i = 0; i < 1000; i++)
+			signal(1);
+		if (allocation_count != before)
+			fail("Signal emit allocated memory");
+		if (receiver.sum != slot_count * 1000)
+			fail("Slots were not called once per emit");
+	}
+}
+
+void benchmark(int emits)
+{
+	for (int slot_count : { 0, 1, 32 })
+	{
+		Receiver receiver;
+
+		Signal<void(int)> signal;
+		std::vector<Slot> slots;
+		for (int i = 0; i < slot_count; i++)
+			slots.push_back(signal.connect(&receiver, &Receiver::on_value));
+
+		CopyingSignal<void(int)> copying_signal;
+		std::vector<std::shared_ptr<std::function<void(int)>>> copying_slots;
+		for (int i = 0; i < slot_count; i++)
+			copying_slots.push_back(copying_signal.connect(bind_member(&receiver, &Receiver::on_value)));
+
+		uint64_t start = System::get_microseconds();
+		for (int i = 0; i < emits; i++)
+			signal(1);
+		uint64_t signal_time = System::get_microseconds() - start;
+
+		start = System::get_microseconds();
+		for (int i = 0; i < emits; i++)
+			copying_signal(1);
+		uint64_t copying_time = System::get_microseconds() - start;
+
+		Console::write_line("  %1 slots: %2 ns per emit, copying signal %3 ns per emit", slot_count, (int)(signal_time * 1000 / emits), (int)(copying_time * 1000 / emits));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int emits = argc > 1 ? StringHelp::text_to_int(argv[1]) : 1000000;
+
+		Console::write_line("Emit");
+		test_emit();
+		Console::write_line("Mutation during emit");
+		test_mutation_during_emit();
+		Console::write_line("Allocations");
+		test_allocations();
+
+		Console::write_line("Emit cost:");
+		benchmark(emits);
+
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -72,6 +72,7 @@ public:
 	int main();
 private:
 	void test_datetime();
+	void test_work_queue();
 
 	std::string convert_time(DateTime &datetime);
 	void fail(void);
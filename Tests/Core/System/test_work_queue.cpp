@@ -0,0 +1,179 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2020 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+void TestApp::test_work_queue()
+{
+	Console::write_line(" Header: work_queue.h");
+	Console::write_line("  Class: WorkQueue");
+
+	Console::write_line("   Function: queue() and process_work_completed()");
+	{
+		WorkQueue queue;
+		std::atomic_int counter(0);
+		for (int i = 0; i < 100; i++)
+			queue.queue([&]() { counter++; });
+
+		uint64_t start_time = System::get_time();
+		while (queue.get_items_queued() > 0)
+		{
+			queue.process_work_completed();
+			if (System::get_time() - start_time > 5000) fail();
+			System::sleep(1);
+		}
+		if (counter != 100) fail();
+	}
+
+	Console::write_line("   Function: serial queue keeps order");
+	{
+		WorkQueue queue(true);
+		std::mutex order_mutex;
+		std::vector<int> order;
+		std::vector<std::thread::id> threads;
+		std::atomic_int running(0);
+		std::atomic_bool overlapped(false);
+		for (int i = 0; i < 100; i++)
+		{
+			queue.queue([&, i]()
+			{
+				if (++running != 1)
+					overlapped = true;
+				System::sleep(0);
+				std::unique_lock<std::mutex> lock(order_mutex);
+				order.push_back(i);
+				threads.push_back(std::this_thread::get_id());
+				lock.unlock();
+				--running;
+			});
+		}
+
+		// Waiting on a group from another thread must not run the serial items on the waiting thread
+		WorkGroup group(queue);
+		group.run([]() { });
+		group.wait();
+		while (queue.get_items_queued() > 0)
+			queue.process_work_completed();
+
+		if (overlapped) fail();
+		if (order.size() != 100) fail();
+		for (int i = 0; i < 100; i++)
+		{
+			if (order[i] != i) fail();
+			if (threads[i] != threads[0]) fail();
+		}
+		if (threads[0] == std::this_thread::get_id()) fail();
+	}
+
+	Console::write_line("   Function: parallel_for()");
+	{
+		WorkQueue queue;
+		std::vector<int> values(10000, 0);
+		queue.parallel_for(0, (int)values.size(), [&](int index) { values[index] = index * 2; }, 64);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i] != (int)i * 2) fail();
+		}
+		if (queue.get_items_queued() != 0) fail();
+	}
+
+	Console::write_line("  Class: WorkGroup");
+
+	Console::write_line("   Function: run() nested inside a worker and wait()");
+	{
+		WorkQueue queue;
+		std::atomic_int counter(0);
+		WorkGroup outer(queue);
+		for (int i = 0; i < 8; i++)
+		{
+			outer.run([&]()
+			{
+				WorkGroup inner(queue);
+				for (int j = 0; j < 100; j++)
+					inner.run([&]() { counter++; });
+				inner.wait();
+			});
+		}
+		outer.wait();
+		if (counter != 800) fail();
+		if (!outer.is_done()) fail();
+	}
+
+	Console::write_line("   Function: then()");
+	{
+		WorkQueue queue;
+		std::atomic_int counter(0);
+		std::atomic_int seen_by_continuation(-1);
+		WorkGroup group(queue);
+		group.parallel_for(0, 1000, [&](int) { counter++; });
+		group.then([&]() { seen_by_continuation = counter.load(); });
+		group.wait();
+		if (seen_by_continuation != 1000) fail();
+
+		// Continuation on an idle group runs right away
+		std::atomic_bool idle_continuation(false);
+		group.then([&]() { idle_continuation = true; });
+		group.wait();
+		if (!idle_continuation) fail();
+	}
+
+	Console::write_line("   Function: wait() rethrows exceptions");
+	{
+		WorkQueue queue;
+		WorkGroup group(queue);
+		group.run([]() { throw Exception("Work failed"); });
+		bool caught = false;
+		try
+		{
+			group.wait();
+		}
+		catch (const Exception &)
+		{
+			caught = true;
+		}
+		if (!caught) fail();
+	}
+
+	Console::write_line("   Benchmark: 100000 small items");
+	{
+		WorkQueue queue;
+		std::atomic_int counter(0);
+		uint64_t start_time = System::get_microseconds();
+		WorkGroup group(queue);
+		for (int i = 0; i < 100000; i++)
+			group.run([&]() { counter++; });
+		group.wait();
+		uint64_t elapsed = System::get_microseconds() - start_time;
+		if (counter != 100000) fail();
+		Console::write_line("    %1 workers, %2 ms", queue.get_num_workers(), (int)(elapsed / 1000));
+	}
+}
@@ -0,0 +1,302 @@
+#include <ClanLib/core.h>
+#include <ClanLib/xml.h>
+#include <cstdlib>
+#include <new>
+using namespace clan;
+
+// Correctness checks and memory/throughput comparison for XMLReader
+//
+// Usage: xmlreader [megabytes of generated XML]
+
+namespace
+{
+	size_t allocations = 0;
+	size_t allocated_bytes = 0;
+	size_t peak_bytes = 0;
+
+	// Allocations are prefixed with their size so that the peak can be tracked
+	const size_t header_size = 16;
+}
+
+void *operator new(size_t size)
+{
+	char *block = static_cast<char *>(malloc(size + header_size));
+	if (!block)
+		throw std::bad_alloc();
+	*reinterpret_cast<size_t *>(block) = size;
+	allocations++;
+	allocated_bytes += size;
+	peak_bytes = std::max(peak_bytes, allocated_bytes);
+	return block + header_size;
+}
+
+void operator delete(void *data) noexcept
+{
+	if (!data)
+		return;
+	char *block = static_cast<char *>(data) - header_size;
+	allocated_bytes -= *reinterpret_cast<size_t *>(block);
+	free(block);
+}
+
+namespace
+{
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	DataBuffer to_buffer(const std::string &text)
+	{
+		return DataBuffer(text.data(), text.size());
+	}
+
+	std::string describe(const XMLToken &token)
+	{
+		std::string text = string_format("type %1, variant %2, name '%3', value '%4'", token.type, token.variant, token.name, token.value);
+		for (const auto &attribute : token.attributes)
+			text += string_format(", %1='%2'", attribute.first, attribute.second);
+		return text;
+	}
+
+	bool same_token(const XMLToken &a, const XMLToken &b)
+	{
+		return a.type == b.type && a.variant == b.variant && a.name == b.name && a.value == b.value && a.attributes == b.attributes;
+	}
+
+	// A document with every kind of node, entities and whitespace, large enough to cross many buffer refills
+	std::string generate_mixed(int items)
+	{
+		std::string xml = "\xef\xbb\xbf<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<!DOCTYPE resources SYSTEM \"resources.dtd\">\n<resources>\n";
+		for (int i = 0; i < items; i++)
+		{
+			xml += string_format("\t<!-- item %1 &amp; more -->\n", i);
+			xml += string_format("\t<item id=\"%1\" name='n&lt;%2&gt;' flag=yes >\n", i, i * 7);
+			xml += string_format("\t\t<text>  Fish &amp; chips &quot;%1&quot; &apos;x&apos; &unknown; </text>\n", i);
+			xml += "\t\t<![CDATA[<raw> &amp; ]] data]]>\n";
+			xml += string_format("\t\t<?process value %1?>\n", i);
+			xml += string_format("\t\t<empty a=\"%1\"/><empty />\n", std::string(i % 50, 'x'));
+			xml += "\t</item>\n";
+		}
+		xml += "</resources>\n";
+		return xml;
+	}
+
+	// A sprite description file of the kind loaded by the resource manager
+	std::string generate_resources(size_t megabytes)
+	{
+		std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<resources>\n";
+		for (int i = 0; xml.size() < megabytes * 1024 * 1024; i++)
+		{
+			xml += string_format("\t<sprite name=\"Sprites/unit%1\" base_angle=\"%2\">\n", i, i % 360);
+			for (int frame = 0; frame < 4; frame++)
+				xml += string_format("\t\t<image file=\"Gfx/unit%1_%2.png\"><grid pos=\"0,0\" size=\"32,32\" array=\"8,1\"/></image>\n", i, frame);
+			xml += "\t\t<animation speed=\"100\" loop=\"yes\" pingpong=\"no\"/>\n\t</sprite>\n";
+		}
+		xml += "</resources>\n";
+		return xml;
+	}
+
+	// The reader must return exactly the tokens of XMLTokenizer
+	void test_tokens(const std::string &xml, bool eat_whitespace)
+	{
+		DataBuffer buffer = to_buffer(xml);
+		MemoryDevice tokenizer_input(buffer);
+		MemoryDevice reader_input(buffer);
+
+		XMLTokenizer tokenizer(tokenizer_input);
+		tokenizer.set_eat_whitespace(eat_whitespace);
+		XMLReader reader(reader_input);
+		reader.set_eat_whitespace(eat_whitespace);
+
+		int count = 0;
+		while (true)
+		{
+			// XMLTokenizer::next(XMLToken *) leaves the name and value of the previous token on doctypes
+			XMLToken expected = tokenizer.next();
+			XMLToken token;
+			bool more = reader.read();
+			reader.get_token(&token);
+			if (!same_token(expected, token))
+				fail(string_format("Token %1 is {%2} instead of {%3}", count, describe(token), describe(expected)));
+			if (more != (expected.type != XMLToken::NULL_TOKEN))
+				fail("read() did not stop at the end of the input");
+			if (!more)
+				break;
+			count++;
+		}
+		Console::write_line("  %1 tokens match, eat whitespace %2", count, eat_whitespace ? "on" : "off");
+	}
+
+	void test_navigation()
+	{
+		DataBuffer buffer = to_buffer("<a><b x='1'><c><d/></c><c/></b><b x=\"2\" y=3 >text</b></a>");
+		MemoryDevice input(buffer);
+		XMLReader reader(input);
+
+		if (!reader.read() || reader.get_name() != "a" || reader.get_depth() != 0 || reader.get_variant() != XMLToken::BEGIN)
+			fail("Expected root element at depth 0");
+		if (!reader.read() || reader.get_name() != "b" || reader.get_depth() != 1 || reader.get_attribute("x") != "1")
+			fail("Expected first b element at depth 1");
+		reader.skip();
+		if (reader.get_name() != "b" || reader.get_variant() != XMLToken::END || reader.get_depth() != 1)
+			fail("skip() did not stop at the end of the element");
+		if (!reader.read() || reader.get_attribute_count() != 2 || reader.get_attribute_name(1) != "y" || reader.get_attribute_value(1) != "3" || reader.has_attribute("z"))
+			fail("Wrong attributes on second b element");
+		if (!reader.read() || reader.get_type() != XMLToken::TEXT_TOKEN || reader.get_value() != "text" || reader.get_depth() != 2)
+			fail("Expected text at depth 2");
+		if (!reader.read() || !reader.read() || reader.get_name() != "a" || reader.get_depth() != 0 || reader.read())
+			fail("Expected end of root element and then end of input");
+	}
+
+	void test_errors()
+	{
+		// Line numbers in errors after the first buffer refills must also match
+		std::string long_document = generate_mixed(2000) + "\n<b attr value='1'/>";
+		std::vector<std::string> documents = { "<a><b attr=\"value", "<a><!-- comment", "<a><![CDATA[ data", "<a x >", "<a>\n\n<b x y>", "<a><!foo></a>", long_document };
+		for (const auto &document : documents)
+		{
+			std::string expected, message;
+			try
+			{
+				DataBuffer buffer = to_buffer(document);
+				MemoryDevice input(buffer);
+				XMLTokenizer tokenizer(input);
+				while (tokenizer.next().type != XMLToken::NULL_TOKEN);
+			}
+			catch (const Exception &e)
+			{
+				expected = e.message;
+			}
+			try
+			{
+				DataBuffer buffer = to_buffer(document);
+				MemoryDevice input(buffer);
+				XMLReader reader(input);
+				while (reader.read());
+			}
+			catch (const Exception &e)
+			{
+				message = e.message;
+			}
+			if (message.empty() || message != expected)
+				fail(string_format("'%1' gave the error '%2' instead of '%3'", document.substr(0, 40), message, expected));
+		}
+	}
+
+	int count_elements(const DomNode &node, const std::string &name)
+	{
+		int elements = 0;
+		for (DomNode child = node.get_first_child(); !child.is_null(); child = child.get_next_sibling())
+		{
+			if (child.is_element())
+				elements += (child.get_node_name() == name ? 1 : 0) + count_elements(child, name);
+		}
+		return elements;
+	}
+
+	struct Measurement
+	{
+		uint64_t microseconds = 0;
+		size_t allocations = 0;
+		size_t peak_bytes = 0;
+		int elements = 0;
+	};
+
+	template<typename Func>
+	Measurement measure(const DataBuffer &buffer, Func func)
+	{
+		Measurement result;
+		size_t start_allocations = allocations;
+		size_t start_bytes = allocated_bytes;
+		peak_bytes = allocated_bytes;
+		uint64_t start = System::get_microseconds();
+
+		result.elements = func();
+
+		result.microseconds = std::max(System::get_microseconds() - start, (uint64_t)1);
+		result.allocations = allocations - start_allocations;
+		result.peak_bytes = peak_bytes - start_bytes;
+		return result;
+	}
+
+	void print(const char *name, const Measurement &m, size_t size)
+	{
+		Console::write_line("  %1 %2 MB/s, %3 KB peak memory, %4 allocations, %5 elements",
+			name, (int)(size / (double)m.microseconds), (int)(m.peak_bytes / 1024), (int)m.allocations, m.elements);
+	}
+
+	void benchmark(size_t megabytes)
+	{
+		DataBuffer buffer = to_buffer(generate_resources(megabytes));
+		Console::write_line("Loading %1 MB of sprite descriptions:", (int)(buffer.get_size() / (1024 * 1024)));
+
+		// Every method counts the image elements so that the work is comparable
+		Measurement dom = measure(buffer, [&]()
+		{
+			MemoryDevice input(const_cast<DataBuffer &>(buffer));
+			DomDocument document;
+			document.load(input);
+			return count_elements(document, "image");
+		});
+
+		Measurement tokenizer = measure(buffer, [&]()
+		{
+			MemoryDevice input(const_cast<DataBuffer &>(buffer));
+			XMLTokenizer tokenizer(input);
+			XMLToken token;
+			int elements = 0;
+			while (tokenizer.next(&token), token.type != XMLToken::NULL_TOKEN)
+			{
+				if (token.type == XMLToken::ELEMENT_TOKEN && token.variant != XMLToken::END && token.name == "image")
+					elements++;
+			}
+			return elements;
+		});
+
+		Measurement reader = measure(buffer, [&]()
+		{
+			MemoryDevice input(const_cast<DataBuffer &>(buffer));
+			XMLReader reader(input);
+			int elements = 0;
+			while (reader.read())
+			{
+				if (reader.get_type() == XMLToken::ELEMENT_TOKEN && reader.get_variant() != XMLToken::END && reader.get_name() == "image")
+					elements++;
+			}
+			return elements;
+		});
+
+		if (dom.elements != reader.elements || tokenizer.elements != reader.elements)
+			fail("The element counts differ");
+
+		print("DomDocument::load:", dom, buffer.get_size());
+		print("XMLTokenizer:     ", tokenizer, buffer.get_size());
+		print("XMLReader:        ", reader, buffer.get_size());
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		size_t megabytes = argc > 1 ? StringHelp::text_to_int(argv[1]) : 32;
+
+		Console::write_line("Comparing tokens with XMLTokenizer:");
+		std::string mixed = generate_mixed(5000);
+		test_tokens(mixed, true);
+		test_tokens(mixed, false);
+		test_tokens("<a>text without end", true);
+		test_navigation();
+		test_errors();
+
+		benchmark(megabytes);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -1,7 +1,185 @@
 
 #include <ClanLib/core.h>
+#include <ClanLib/xml.h>
 using namespace clan;
 
+// Usage: xpath [resources in generated document] [lookups per measurement]
+
+namespace
+{
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	DomDocument load(const std::string &filename)
+	{
+		File file(filename, File::open_existing, File::access_read);
+		DomDocument document;
+		document.load(file);
+		return document;
+	}
+
+	std::string describe(const std::vector<DomNode> &nodes)
+	{
+		std::string text;
+		for (const auto &node : nodes)
+		{
+			std::string value = node.is_element() ? node.to_element().get_text() : node.get_node_value();
+			text += string_format("[%1] %2; ", node.get_node_name(), value);
+		}
+		return text;
+	}
+
+	bool same_nodes(const std::vector<DomNode> &a, const std::vector<DomNode> &b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i] != b[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Location paths must select the same nodes in the same order as the interpreter, with and without an index
+	void test_location_paths(const DomDocument &document, const DomNode &context)
+	{
+		const char *paths[] =
+		{
+			"root/child/childchild", "/root/child/childchild", "/child::root/child::child/child::childchild",
+			"child::root/child::child[@foo]/child::childchild", "child::root/child::child[2]/child::childchild",
+			"root//childchild", "//childchild", "//childchild[1]", "//child[@foo='barism']/childchild",
+			"root/child[@foo=\"bar\"]/childchild", "root/com:child/foobar", "root/child[1]/childchild[2]",
+			"/root/child[1]/childchild[1]/text()", "//child/attribute::*", "//child/@foo", "//*[@ID]",
+			"//childchild/..", "//foobar/../..", "/descendant::childchild[2]", "root/child/descendant-or-self::node()",
+			"//child[@ID='Test']", "//child[@type='numbers']/number[3]", "//node()", "//comment()", "//*", ".", "..",
+			"root/*[@age][2]/foobar", "root/child[@age='10'][1]/foobar"
+		};
+
+		XPathIndex index(document);
+		for (auto path : paths)
+		{
+			XPathExpression compiled(path);
+			if (!compiled.is_location_path())
+				fail(string_format("'%1' was not compiled to a location path", path));
+
+			XPathExpression interpreted(string_format("(%1)", path));
+			std::vector<DomNode> expected = interpreted.select_nodes(context);
+			std::vector<DomNode> nodes = compiled.select_nodes(context);
+			std::vector<DomNode> indexed_nodes = compiled.select_nodes(context, index);
+			if (!same_nodes(expected, nodes) || !same_nodes(expected, indexed_nodes))
+				fail(string_format("'%1' selected %2 instead of %3", path, describe(nodes), describe(expected)));
+		}
+	}
+
+	void test_results(const DomDocument &document)
+	{
+		XPathIndex index(document);
+		if (XPathExpression("root//childchild").select_nodes(document).size() != 13)
+			fail("'//' inside a path did not select all descendants");
+		if (XPathExpression("//child[@ID='Test']").select_nodes(document, index).size() != 1)
+			fail("Attribute predicate did not select the element");
+		if (XPathExpression("//childchild[@ID='Test72']").select_nodes(document).at(0).to_element().get_text() != "Test7.2")
+			fail("Attribute predicate selected the wrong element");
+
+		// Descendants of a context node do not include its siblings
+		DomNode first_child = XPathExpression("/root/child[1]").select_nodes(document).at(0);
+		if (XPathExpression(".//childchild").select_nodes(first_child).size() != 3)
+			fail("descendant-or-self included nodes outside the context node");
+		if (XPathExpression("root/child[@age='10']/following-sibling::child").select_nodes(document).size() != 3)
+			fail("following-sibling gave the wrong result");
+
+		// Expressions that are not location paths are evaluated by the interpreter
+		XPathEvaluator evaluator;
+		const char *numbers[] = { "count(root/child[position() mod 2 = 0])", "sum(root/child[@type='numbers']/number)", "string-length(root/*[local-name()='child'][position()=last()-2]/foobar)", "6 mod 4" };
+		double expected[] = { 4, 45, 11, 2 };
+		for (int i = 0; i < 4; i++)
+		{
+			XPathExpression expression(numbers[i]);
+			if (expression.is_location_path() || expression.evaluate(document).get_number() != expected[i] || evaluator.evaluate(numbers[i], document).get_number() != expected[i])
+				fail(string_format("'%1' did not evaluate to %2", numbers[i], expected[i]));
+		}
+		if (XPathExpression("translate('bare', 'abr', 'AB')").evaluate(document).get_string() != "BAe")
+			fail("translate() gave the wrong result");
+		if (XPathExpression("root/child[last()]/foobar | root/child[not(@foo) and not(@age)]/foobar").select_nodes(document).size() != 1)
+			fail("Union gave the wrong result");
+
+		bool thrown = false;
+		try
+		{
+			XPathExpression("//child[@foo='bar");
+		}
+		catch (const XPathException &)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+			fail("Unterminated literal did not throw when compiling");
+	}
+
+	// A resource document with sections of sprites that each have an image
+	DomDocument generate_resources(int count)
+	{
+		std::string xml = "<resources>\n";
+		for (int section = 0; section * 100 < count; section++)
+		{
+			xml += string_format("<section name=\"section%1\">\n", section);
+			for (int i = section * 100; i < std::min(count, (section + 1) * 100); i++)
+				xml += string_format("  <sprite name=\"sprite%1\"><image file=\"sprite%2.png\"/><translation origin=\"center\"/></sprite>\n", i, i);
+			xml += "</section>\n";
+		}
+		xml += "</resources>\n";
+
+		DataBuffer data(xml.data(), xml.size());
+		MemoryDevice device(data);
+		DomDocument document;
+		document.load(device);
+		return document;
+	}
+
+	template<typename Func>
+	void measure(const char *name, int lookups, Func func)
+	{
+		uint64_t start = System::get_microseconds();
+		for (int i = 0; i < lookups; i++)
+			func(i);
+		uint64_t elapsed = std::max(System::get_microseconds() - start, (uint64_t)1);
+		Console::write_line("  %1 %2 us per lookup", name, StringHelp::double_to_text(elapsed / (double)lookups, 2));
+	}
+
+	void benchmark(int count, int lookups)
+	{
+		DomDocument document = generate_resources(count);
+		uint64_t start = System::get_microseconds();
+		XPathIndex index(document);
+		Console::write_line("%1 resources, index built in %2 ms", count, StringHelp::double_to_text((System::get_microseconds() - start) / 1000.0, 2));
+
+		const char *queries[] = { "//sprite[@name='sprite%1']", "/resources/section/sprite[@name='sprite%1']/image/@file" };
+		for (auto query : queries)
+		{
+			std::string expression = string_format(query, count / 2);
+			Console::write_line("%1:", expression);
+
+			XPathExpression compiled(expression);
+			XPathEvaluator evaluator;
+			size_t selected = compiled.select_nodes(document).size();
+			if (selected != 1 || compiled.select_nodes(document, index).size() != 1 || XPathExpression("(" + expression + ")").select_nodes(document).size() != 1)
+				fail("Lookup did not select exactly one node");
+
+			int slow_lookups = std::max(lookups / 100, 1);
+			measure("Interpreter:                ", slow_lookups, [&](int) { XPathExpression("(" + expression + ")").select_nodes(document); });
+			measure("XPathEvaluator::evaluate:   ", slow_lookups, [&](int) { evaluator.evaluate(expression, document); });
+			measure("Compiled:                   ", slow_lookups, [&](int) { compiled.select_nodes(document); });
+			measure("Compiled with index:        ", lookups, [&](int) { compiled.select_nodes(document, index); });
+		}
+
+		// Different names every lookup, compiled each time
+		measure("Compile and look up by name:", lookups, [&](int i) { XPathExpression(string_format("//sprite[@name='sprite%1']", i % count)).select_nodes(document, index); });
+	}
+}
+
 void evaluate(const std::string &xpath, const DomDocument &document)
 {
 	Console::write_line("Evaluating XPath '%1'", xpath);
@@ -36,10 +214,22 @@ void evaluate(const std::string &xpath, const DomDocument &document)
 		Console::write_line("Result: boolean (%1)", result.get_boolean() ? "true" : "false");
 		break;
 	}
+
+	// Location paths also run compiled, with and without an index, and must select what the interpreter selects
+	XPathExpression compiled(xpath);
+	if (compiled.is_location_path())
+	{
+		std::vector<DomNode> expected = XPathExpression("(" + xpath + ")").select_nodes(document);
+		std::vector<DomNode> nodes = compiled.select_nodes(document);
+		std::vector<DomNode> indexed_nodes = compiled.select_nodes(document, XPathIndex(document));
+		Console::write_line("Compiled: node-set (%1), indexed: node-set (%2)", (int)nodes.size(), (int)indexed_nodes.size());
+		if (!same_nodes(expected, nodes) || !same_nodes(expected, indexed_nodes))
+			fail(string_format("'%1' selected %2 instead of %3", xpath, describe(nodes), describe(expected)));
+	}
 	Console::write_line("");
 }
 
-int main(int, char**)
+int main(int argc, char **argv)
 {
 	try
 	{
@@ -92,6 +282,17 @@ int main(int, char**)
 // 		evaluate("local-name(/root/child[1])", document);
 // 		evaluate("id(/root/child[1]/childchild[1])", document);
 // 		evaluate("//childchild[1]", document);
+
+		test_location_paths(document, document);
+		test_location_paths(document, XPathExpression("/root/child[2]").select_nodes(document).at(0));
+		DomDocument document2 = load("test2.xml");
+		test_location_paths(document2, document2);
+		test_results(document);
+
+		int count = argc > 1 ? StringHelp::text_to_int(argv[1]) : 5000;
+		int lookups = argc > 2 ? StringHelp::text_to_int(argv[2]) : 10000;
+		benchmark(count, lookups);
+		Console::write_line("All Tests Complete");
 	}
 	catch(Exception &error)
 	{
@@ -0,0 +1,351 @@
+#include <ClanLib/core.h>
+#include <algorithm>
+using namespace clan;
+
+// Correctness checks and benchmark for ZipMappedArchive
+//
+// Usage: zipmappedarchive [files in generated archive]
+//
+// Writes an archive of small files, half of them stored and half of them deflated, and
+// compares opening and reading it with ZipArchive and ZipMappedArchive.
+
+namespace
+{
+	const char *archive_filename = "zipmappedarchive_test.zip";
+
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	std::string get_filename(int index)
+	{
+		return string_format("Data/Level%1/Objects/object%2.xml", index % 10, index);
+	}
+
+	std::string get_contents(int index)
+	{
+		std::string contents = string_format("<object id=\"%1\">", index);
+		for (int i = 0; i < 20 + index % 40; i++)
+			contents += string_format("<property name=\"p%1\" value=\"%2\"/>\n", i, (index * 31 + i) % 1000);
+		return contents + "</object>\n";
+	}
+
+	bool is_compressed(int index)
+	{
+		return index % 2 == 1;
+	}
+
+	void write_archive(int num_files)
+	{
+		File file(archive_filename, File::create_always, File::access_write);
+		ZipWriter writer(file, true);
+		for (int i = 0; i < num_files; i++)
+		{
+			std::string contents = get_contents(i);
+			writer.begin_file(get_filename(i), is_compressed(i));
+			writer.write_file_data(contents.data(), contents.size());
+			writer.end_file();
+		}
+		writer.write_toc();
+	}
+
+	std::string to_string(const DataBuffer &buffer)
+	{
+		return std::string(buffer.get_data(), buffer.get_size());
+	}
+
+	std::string read_all(IODevice device)
+	{
+		DataBuffer buffer(device.get_size());
+		device.read(buffer.get_data(), buffer.get_size());
+		return to_string(buffer);
+	}
+
+	void test_contents(ZipMappedArchive &archive, int num_files)
+	{
+		if (archive.get_file_count() != num_files)
+			fail("Wrong number of files in archive");
+
+		for (int i = 0; i < num_files; i++)
+		{
+			std::string filename = get_filename(i);
+			std::string contents = get_contents(i);
+			if (!archive.has_file(filename) || archive.get_file_size(filename) != (int64_t)contents.size())
+				fail(string_format("%1 not found", filename));
+			if (to_string(archive.read_file(filename)) != contents || read_all(archive.open_file("/" + filename)) != contents)
+				fail(string_format("Wrong contents in %1", filename));
+
+			size_t size = 0;
+			const char *data = static_cast<const char *>(archive.get_stored_data(filename, size));
+			if (is_compressed(i) ? data != nullptr : std::string(data, size) != contents)
+				fail(string_format("Wrong stored data for %1", filename));
+		}
+
+		if (archive.has_file("Data/Level1/Objects/missing.xml") || archive.has_file("Data/Level1"))
+			fail("Found a file that does not exist");
+	}
+
+	void test_file_system(ZipMappedArchive &archive, int num_files)
+	{
+		FileSystem vfs;
+		vfs.mount("Packs/Main", FileSystem(archive));
+		if (read_all(vfs.open_file("Packs/Main/" + get_filename(3))) != get_contents(3))
+			fail("Wrong contents opened through FileSystem");
+
+		std::vector<std::string> expected;
+		for (auto &entry : ZipArchive(archive_filename).get_file_list("Data/Level3/Objects"))
+			expected.push_back(entry.get_archive_filename());
+
+		std::vector<std::string> listed;
+		DirectoryListing listing = vfs.get_directory_listing("Packs/Main/Data/Level3/Objects");
+		while (listing.next())
+			listed.push_back(listing.get_filename());
+
+		if (listed != expected || (int)listed.size() != (num_files + 6) / 10)
+			fail("Directory listing differs from ZipArchive");
+
+		if (!vfs.has_directory("Packs/Main/Data/Level3") || vfs.has_directory("Packs/Main/Data/Level11"))
+			fail("Wrong directories in listing");
+	}
+
+	void test_prefetch(ZipMappedArchive &archive, int num_files)
+	{
+		std::vector<std::string> filenames;
+		for (int i = 0; i < num_files; i += 3)
+			filenames.push_back(get_filename(i));
+
+		WorkQueue queue;
+		archive.prefetch(filenames, queue);
+		for (int i = 0; i < num_files; i += 3)
+		{
+			if (read_all(archive.open_file(get_filename(i))) != get_contents(i))
+				fail("Wrong contents in prefetched file");
+		}
+		archive.clear_prefetched();
+	}
+
+	// ZipWriter stores names without the UTF-8 flag with a unicode path extra field
+	void test_code_page_names()
+	{
+		std::string name = "Fonts/\xc3\xa6\xc3\xb8\xc3\xa5.txt";
+		{
+			File file(archive_filename, File::create_always, File::access_write);
+			ZipWriter writer(file, false);
+			writer.begin_file(name, false);
+			writer.write_file_data("text", 4);
+			writer.end_file();
+			writer.write_toc();
+		}
+
+		ZipMappedArchive archive(archive_filename);
+		if (to_string(archive.read_file(name)) != "text")
+			fail("File with a DOS code page name not found");
+	}
+
+	// Writes an archive with a single stored file
+	void write_stored_archive()
+	{
+		File file(archive_filename, File::create_always, File::access_write);
+		ZipWriter writer(file, false);
+		writer.begin_file("damaged.txt", false);
+		writer.write_file_data("stored text", 11);
+		writer.end_file();
+		writer.write_toc();
+	}
+
+	// Writes an archive with a single stored file and overwrites a 32 bit field of its central directory record
+	void write_damaged_archive(int field_offset, uint32_t value)
+	{
+		write_stored_archive();
+
+		DataBuffer bytes = File::read_bytes(archive_filename);
+		unsigned char *data = bytes.get_data<unsigned char>();
+		for (unsigned int pos = 0; pos + 46 <= bytes.get_size(); pos++)
+		{
+			if (data[pos] == 0x50 && data[pos + 1] == 0x4b && data[pos + 2] == 0x01 && data[pos + 3] == 0x02)
+			{
+				for (int i = 0; i < 4; i++)
+					data[pos + field_offset + i] = (value >> (i * 8)) & 0xff;
+				break;
+			}
+		}
+		File::write_bytes(archive_filename, bytes);
+	}
+
+	void expect_rejected(const std::string &description)
+	{
+		ZipMappedArchive archive(archive_filename);
+
+		bool rejected = false;
+		try
+		{
+			size_t size = 0;
+			archive.get_stored_data("damaged.txt", size);
+		}
+		catch (const Exception &)
+		{
+			rejected = true;
+		}
+		if (!rejected)
+			fail(string_format("get_stored_data accepted %1", description));
+
+		rejected = false;
+		try
+		{
+			archive.open_file("damaged.txt");
+		}
+		catch (const Exception &)
+		{
+			rejected = true;
+		}
+		if (!rejected)
+			fail(string_format("open_file accepted %1", description));
+	}
+
+	// Writes an archive with a single stored file and a zip64 end record claiming num_entries entries
+	void write_zip64_archive(uint64_t num_entries)
+	{
+		write_stored_archive();
+
+		DataBuffer bytes = File::read_bytes(archive_filename);
+		unsigned char *data = bytes.get_data<unsigned char>();
+		unsigned int end_record_pos = bytes.get_size() - 22;
+		uint64_t directory_size = data[end_record_pos + 12] | (data[end_record_pos + 13] << 8) | (data[end_record_pos + 14] << 16) | ((uint64_t)data[end_record_pos + 15] << 24);
+		uint64_t directory_offset = data[end_record_pos + 16] | (data[end_record_pos + 17] << 8) | (data[end_record_pos + 18] << 16) | ((uint64_t)data[end_record_pos + 19] << 24);
+
+		std::vector<unsigned char> zip64(56 + 20);
+		auto write = [&](int offset, uint64_t value, int length) { for (int i = 0; i < length; i++) zip64[offset + i] = (value >> (i * 8)) & 0xff; };
+		write(0, 0x06064b50, 4);
+		write(4, 44, 8);
+		write(24, num_entries, 8);
+		write(32, num_entries, 8);
+		write(40, directory_size, 8);
+		write(48, directory_offset, 8);
+		write(56, 0x07064b50, 4);
+		write(64, end_record_pos, 8);
+		write(72, 1, 4);
+
+		DataBuffer archive(bytes.get_size() + zip64.size());
+		memcpy(archive.get_data(), data, end_record_pos);
+		memcpy(archive.get_data() + end_record_pos, zip64.data(), zip64.size());
+		memcpy(archive.get_data() + end_record_pos + zip64.size(), data + end_record_pos, 22);
+		File::write_bytes(archive_filename, archive);
+	}
+
+	void test_damaged_archives()
+	{
+		write_damaged_archive(24, 0x100000);
+		expect_rejected("a stored entry larger than its data");
+
+		write_damaged_archive(42, 0xfffffff0);
+		expect_rejected("a local header past the end of the archive");
+
+		// The entry count must not be trusted when reserving memory
+		write_zip64_archive(0x0fffffffffffffffULL);
+		bool rejected = false;
+		try
+		{
+			ZipMappedArchive archive(archive_filename);
+		}
+		catch (const Exception &)
+		{
+			rejected = true;
+		}
+		if (!rejected)
+			fail("Archive with a zip64 entry count larger than its central directory was accepted");
+
+		write_zip64_archive(1);
+		ZipMappedArchive archive(archive_filename);
+		if (to_string(archive.read_file("damaged.txt")) != "stored text")
+			fail("Zip64 end record not read");
+	}
+
+	void benchmark(int num_files)
+	{
+		Console::write_line("Archive with %1 files:", num_files);
+
+		uint64_t start = System::get_microseconds();
+		ZipMappedArchive mapped_archive(archive_filename);
+		uint64_t mapped_open_time = System::get_microseconds() - start;
+
+		size_t bytes = 0;
+		start = System::get_microseconds();
+		for (int i = 0; i < num_files; i++)
+			bytes += mapped_archive.read_file(get_filename(i)).get_size();
+		uint64_t mapped_read_time = std::max(System::get_microseconds() - start, (uint64_t)1);
+
+		Console::write_line("  ZipMappedArchive: open %1 ms, open and read a file %2 us (%3 MB/s)",
+			StringHelp::double_to_text(mapped_open_time / 1000.0, 2), StringHelp::double_to_text(mapped_read_time / (double)num_files, 2), (int)(bytes / (double)mapped_read_time));
+
+		start = System::get_microseconds();
+		ZipArchive zip_archive(archive_filename);
+		uint64_t zip_open_time = System::get_microseconds() - start;
+
+		// ZipWriter does not write zip64 records, and ZipArchive reads the 16 bit entry count as signed
+		int zip_files = (int)zip_archive.get_file_list().size();
+		if (zip_files == num_files)
+		{
+			// ZipArchive searches the file list linearly, so only a sample of its lookups is timed
+			int zip_samples = std::min(num_files, 1000);
+			start = System::get_microseconds();
+			for (int i = 0; i < zip_samples; i++)
+				read_all(zip_archive.open_file(get_filename(i * (num_files / zip_samples))));
+			double zip_file_time = (System::get_microseconds() - start) / (double)zip_samples;
+
+			Console::write_line("  ZipArchive:       open %1 ms, open and read a file %2 us", (int)(zip_open_time / 1000), StringHelp::double_to_text(zip_file_time, 1));
+		}
+		else
+		{
+			Console::write_line("  ZipArchive:       open %1 ms, but only %2 of the entries were found", (int)(zip_open_time / 1000), zip_files);
+		}
+
+		std::vector<std::string> filenames;
+		for (int i = 0; i < num_files; i++)
+			filenames.push_back(get_filename(i));
+
+		WorkQueue queue;
+		start = System::get_microseconds();
+		mapped_archive.prefetch(filenames, queue);
+		uint64_t prefetch_time = std::max(System::get_microseconds() - start, (uint64_t)1);
+
+		bytes = 0;
+		start = System::get_microseconds();
+		for (int i = 0; i < num_files; i++)
+			bytes += mapped_archive.open_file(get_filename(i)).get_size();
+		uint64_t prefetched_time = std::max(System::get_microseconds() - start, (uint64_t)1);
+
+		Console::write_line("  Prefetch %1 compressed files on %2 workers: %3 ms, then opening all files: %4 us per file",
+			num_files / 2, queue.get_num_workers(), (int)(prefetch_time / 1000), StringHelp::double_to_text(prefetched_time / (double)num_files, 2));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int num_files = argc > 1 ? StringHelp::text_to_int(argv[1]) : 100000;
+
+		write_archive(1000);
+		ZipMappedArchive archive(archive_filename);
+		test_contents(archive, 1000);
+		test_file_system(archive, 1000);
+		test_prefetch(archive, 1000);
+		archive = ZipMappedArchive();
+
+		test_code_page_names();
+		test_damaged_archives();
+
+		write_archive(num_files);
+		benchmark(num_files);
+
+		FileHelp::delete_file(archive_filename);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
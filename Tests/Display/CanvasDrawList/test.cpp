@@ -0,0 +1,152 @@
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/swrender.h>
+
+using namespace clan;
+
+// Canvas draw list benchmark
+//
+// Draws a busy user interface of panels, borders, icons, text and separators, first in painter's
+// order and then with the deferred draw list, and reports the draw calls and time per frame of each.
+// The two images are compared to make sure the draw list only reordered primitives that do not overlap.
+
+class App : public clan::Application
+{
+public:
+	App();
+	bool update() override;
+
+private:
+	void draw_scene();
+	int measure(bool draw_list, int frames, uint64_t &out_time);
+	void on_window_close();
+
+	bool quit = false;
+	SlotContainer sc;
+	DisplayWindow window;
+	Canvas canvas;
+	Font font;
+	std::vector<Image> icons;
+};
+
+clan::ApplicationInstance<App> clanapp;
+
+App::App()
+{
+	clan::SWRTarget::set_current();
+
+	window = DisplayWindow("ClanLib Canvas Draw List", 1024, 768);
+	sc.connect(window.sig_window_close(), this, &App::on_window_close);
+	canvas = Canvas(window);
+	canvas.set_map_mode(MapMode::_2d_upper_left);
+
+	FontDescription desc;
+	desc.set_height(13);
+	font = Font("Tahoma", desc);
+
+	// Each icon in its own texture, as if loaded from separate files
+	for (int i = 0; i < 6; i++)
+	{
+		PixelBuffer pixels(16, 16, TextureFormat::rgba8);
+		uint32_t *data = pixels.get_data_uint32();
+		for (int y = 0; y < 16; y++)
+		{
+			for (int x = 0; x < 16; x++)
+			{
+				bool inside = (x - 8) * (x - 8) + (y - 8) * (y - 8) < 49;
+				data[x + y * 16] = inside ? (0xff000000 | (0x3f << (i % 3 * 8)) | (i * 0x202020)) : 0;
+			}
+		}
+		icons.push_back(Image(canvas, pixels, pixels.get_size()));
+	}
+}
+
+void App::draw_scene()
+{
+	canvas.clear(Colorf(0.15f, 0.15f, 0.18f));
+
+	// A grid of list items: background, border, icon, two lines of text and a separator each
+	for (int row = 0; row < 24; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			Rectf item(8.0f + column * 252.0f, 8.0f + row * 31.0f, 252.0f + column * 252.0f, 36.0f + row * 31.0f);
+			int index = row * 4 + column;
+
+			canvas.fill_rect(item, (index % 2) ? Colorf(0.22f, 0.22f, 0.26f) : Colorf(0.25f, 0.25f, 0.3f));
+			canvas.draw_box(item, Colorf(0.4f, 0.4f, 0.45f));
+			icons[index % icons.size()].draw(canvas, item.left + 6.0f, item.top + 6.0f);
+			font.draw_text(canvas, item.left + 28.0f, item.top + 13.0f, string_format("Item %1", index), Colorf::white);
+			font.draw_text(canvas, item.left + 28.0f, item.top + 25.0f, "Description text", Colorf(0.7f, 0.7f, 0.7f));
+			canvas.draw_line(item.right - 40.0f, item.top + 4.0f, item.right - 40.0f, item.bottom - 4.0f, Colorf(0.5f, 0.5f, 0.5f));
+			canvas.fill_rect(item.right - 34.0f, item.top + 10.0f, item.right - 6.0f, item.bottom - 10.0f, Colorf(0.2f, 0.5f, 0.8f));
+		}
+	}
+
+	// A status bar drawn above the items in a higher layer, as if it was drawn by another component
+	int layer = canvas.get_draw_layer();
+	canvas.set_draw_layer(layer + 1);
+	canvas.fill_rect(0.0f, 748.0f, 1024.0f, 768.0f, Colorf(0.1f, 0.1f, 0.1f));
+	font.draw_text(canvas, 8.0f, 762.0f, "Ready", Colorf::white);
+	canvas.set_draw_layer(layer);
+
+	canvas.flush();
+}
+
+int App::measure(bool draw_list, int frames, uint64_t &out_time)
+{
+	canvas.set_draw_list_enabled(draw_list);
+	int first_count = canvas.get_draw_call_count();
+	uint64_t start = System::get_microseconds();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		draw_scene();
+		window.get_gc().flush();
+	}
+	out_time = (System::get_microseconds() - start) / frames;
+	return (canvas.get_draw_call_count() - first_count) / frames;
+}
+
+bool App::update()
+{
+	// The first frame creates the glyphs, so it is not measured
+	draw_scene();
+
+	uint64_t immediate_time, deferred_time;
+	int immediate_calls = measure(false, 100, immediate_time);
+	int deferred_calls = measure(true, 100, deferred_time);
+	Console::write_line("Painter's order: %1 draw calls, %2 us per frame", immediate_calls, (int)immediate_time);
+	Console::write_line("Draw list:       %1 draw calls, %2 us per frame", deferred_calls, (int)deferred_time);
+
+	canvas.set_draw_list_enabled(false);
+	draw_scene();
+	PixelBuffer immediate_image = canvas.get_pixeldata();
+	canvas.set_draw_list_enabled(true);
+	draw_scene();
+	PixelBuffer deferred_image = canvas.get_pixeldata();
+	canvas.set_draw_list_enabled(false);
+
+	int different_pixels = 0;
+	const uint32_t *a = immediate_image.get_data_uint32();
+	const uint32_t *b = deferred_image.get_data_uint32();
+	for (int i = 0; i < immediate_image.get_width() * immediate_image.get_height(); i++)
+	{
+		if (a[i] != b[i])
+			different_pixels++;
+	}
+	Console::write_line("Pixels that differ: %1", different_pixels);
+
+	if (deferred_calls >= immediate_calls || different_pixels != 0)
+		throw Exception("Draw list test failed");
+
+	Console::write_line("All Tests Complete");
+	window.flip(0);
+	quit = true;
+	return !quit;
+}
+
+void App::on_window_close()
+{
+	quit = true;
+}
@@ -0,0 +1,178 @@
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cstdlib>
+#include <random>
+
+using namespace clan;
+
+// Correctness checks and benchmark for parallel JPEG decoding
+//
+// Usage: jpegdecode [benchmark image size] [iterations]
+//
+// Encodes generated images with and without restart markers and checks that loading them
+// on a WorkQueue gives exactly the same pixels as a serial load.
+
+namespace
+{
+	// Smooth gradients with some noise, so the entropy coded data is not trivially small
+	PixelBuffer make_image(int width, int height)
+	{
+		PixelBuffer image(width, height, TextureFormat::rgb8);
+		std::minstd_rand random;
+		std::uniform_int_distribution<int> noise(-24, 24);
+		for (int y = 0; y < height; y++)
+		{
+			unsigned char *line = image.get_data<unsigned char>() + y * image.get_pitch();
+			for (int x = 0; x < width; x++)
+			{
+				line[x * 3 + 0] = (unsigned char)clamp(x * 255 / width + noise(random), 0, 255);
+				line[x * 3 + 1] = (unsigned char)clamp(y * 255 / height + noise(random), 0, 255);
+				line[x * 3 + 2] = (unsigned char)clamp(((x + y) & 255) + noise(random), 0, 255);
+			}
+		}
+		return image;
+	}
+
+	DataBuffer encode(const PixelBuffer &image, int restart_interval)
+	{
+		MemoryDevice device;
+		JPEGProvider::save(image, device, 85, restart_interval);
+		return device.get_data();
+	}
+
+	PixelBuffer decode(DataBuffer jpeg, WorkQueue *queue)
+	{
+		MemoryDevice device(jpeg);
+		return queue ? JPEGProvider::load(device, *queue) : JPEGProvider::load(device);
+	}
+
+	bool same_pixels(const PixelBuffer &a, const PixelBuffer &b)
+	{
+		if (a.get_width() != b.get_width() || a.get_height() != b.get_height())
+			return false;
+		for (int y = 0; y < a.get_height(); y++)
+		{
+			if (memcmp(a.get_line(y), b.get_line(y), a.get_width() * 4) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// Average absolute difference per channel between an rgb8 source and an rgba8 decoded image
+	double average_error(const PixelBuffer &source, const PixelBuffer &decoded)
+	{
+		double sum = 0.0;
+		for (int y = 0; y < source.get_height(); y++)
+		{
+			const unsigned char *s = source.get_line_uint8(y);
+			const unsigned char *d = decoded.get_line_uint8(y);
+			for (int x = 0; x < source.get_width(); x++)
+			{
+				for (int c = 0; c < 3; c++)
+					sum += std::abs(s[x * 3 + c] - d[x * 4 + c]);
+				if (d[x * 4 + 3] != 255)
+					throw Exception("Decoded alpha is not opaque");
+			}
+		}
+		return sum / (source.get_width() * source.get_height() * 3.0);
+	}
+}
+
+// Image sizes that are not multiples of the MCU size exercise the partial edge blocks
+void test_correctness(WorkQueue &queue)
+{
+	const int sizes[][2] = { { 1, 1 }, { 17, 9 }, { 640, 480 }, { 1001, 747 } };
+	const int restart_intervals[] = { 0, 1, 7, 64 };
+
+	for (auto &size : sizes)
+	{
+		PixelBuffer source = make_image(size[0], size[1]);
+		PixelBuffer reference = decode(encode(source, 0), nullptr);
+
+		double error = average_error(source, reference);
+		Console::write_line("  %1x%2: average error %3", size[0], size[1], StringHelp::double_to_text(error, 2));
+		if (error > 16.0)
+			throw Exception("Decoded image differs too much from the source");
+
+		for (int restart_interval : restart_intervals)
+		{
+			DataBuffer jpeg = encode(source, restart_interval);
+
+			// Restart markers only reset the DC prediction, so the decoded pixels must not change
+			if (!same_pixels(decode(jpeg, nullptr), reference))
+				throw Exception(string_format("Serial load with restart interval %1 differs", restart_interval));
+			if (!same_pixels(decode(jpeg, &queue), reference))
+				throw Exception(string_format("Parallel load with restart interval %1 differs", restart_interval));
+		}
+	}
+}
+
+// Restart markers missing from the entropy data must be reported, not decoded past
+void test_truncated(WorkQueue &queue)
+{
+	DataBuffer jpeg = encode(make_image(256, 256), 4);
+	DataBuffer truncated(jpeg.get_data(), jpeg.get_size() / 2);
+	for (int i = 0; i < 2; i++)
+	{
+		bool thrown = false;
+		try
+		{
+			decode(truncated, i == 0 ? nullptr : &queue);
+		}
+		catch (const Exception &)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+			throw Exception("Loading a truncated JPEG did not fail");
+	}
+}
+
+void benchmark(WorkQueue &queue, int size, int iterations)
+{
+	PixelBuffer source = make_image(size, size);
+	for (int restart_interval : { 0, size / 16 })
+	{
+		DataBuffer jpeg = encode(source, restart_interval);
+		uint64_t times[2] = { 0, 0 };
+		for (int i = 0; i < iterations; i++)
+		{
+			for (int parallel = 0; parallel < 2; parallel++)
+			{
+				uint64_t start = System::get_microseconds();
+				decode(jpeg, parallel ? &queue : nullptr);
+				times[parallel] += System::get_microseconds() - start;
+			}
+		}
+
+		Console::write_line("  %1 KB, restart interval %2: serial %3 ms, %4 workers %5 ms (%6x)",
+			(int)(jpeg.get_size() / 1024), restart_interval,
+			(int)(times[0] / iterations / 1000), queue.get_num_workers(), (int)(times[1] / iterations / 1000),
+			StringHelp::double_to_text(times[0] / (double)std::max(times[1], (uint64_t)1), 2));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int size = argc > 1 ? StringHelp::text_to_int(argv[1]) : 4096;
+		int iterations = argc > 2 ? StringHelp::text_to_int(argv[2]) : 3;
+
+		WorkQueue queue;
+
+		Console::write_line("Serial and parallel loads:");
+		test_correctness(queue);
+		test_truncated(queue);
+
+		Console::write_line("Decoding a %1x%2 image:", size, size);
+		benchmark(queue, size, iterations);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
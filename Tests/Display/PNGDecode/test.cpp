@@ -0,0 +1,414 @@
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <random>
+
+using namespace clan;
+
+// Correctness checks and benchmark for the streaming PNG decoder
+//
+// Usage: pngdecode [benchmark image size] [iterations]
+//
+// Encodes images with every color type, bit depth and filter type, with and without
+// interlacing, and checks that both the PixelBuffer and the row callback loaders return
+// exactly the source pixels.
+
+namespace
+{
+	// Raw PNG samples of an image, before filtering
+	struct SourceImage
+	{
+		int width = 0;
+		int height = 0;
+		int bit_depth = 8;
+		int color_type = 6;
+		std::vector<std::vector<unsigned char>> rows;
+		std::vector<unsigned char> palette; // rgb triplets
+		std::vector<unsigned char> trns;
+
+		int channels() const
+		{
+			switch (color_type)
+			{
+			case 0: return 1;
+			case 2: return 3;
+			case 3: return 1;
+			case 4: return 2;
+			default: return 4;
+			}
+		}
+
+		int bytes_per_pixel() const { return std::max(channels() * bit_depth / 8, 1); }
+		int row_size(int pixels) const { return (pixels * channels() * bit_depth + 7) / 8; }
+
+		unsigned int sample(int x, int y, int channel) const
+		{
+			const unsigned char *row = rows[y].data();
+			if (bit_depth == 16)
+				return (row[(x * channels() + channel) * 2] << 8) | row[(x * channels() + channel) * 2 + 1];
+			else if (bit_depth == 8)
+				return row[x * channels() + channel];
+			int bit = x * bit_depth;
+			return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1 << bit_depth) - 1);
+		}
+
+		// What the loader should return for a pixel, in 16 bit for 16 bit images and 8 bit otherwise
+		Vec4ui expected(int x, int y) const
+		{
+			unsigned int max_value = bit_depth == 16 ? 65535 : 255;
+			unsigned int scale = bit_depth == 16 ? 1 : 255 / ((1 << bit_depth) - 1);
+			switch (color_type)
+			{
+			case 0:
+			{
+				unsigned int v = sample(x, y, 0);
+				bool transparent = trns.size() == 2 && v == (unsigned int)((trns[0] << 8) | trns[1]);
+				return Vec4ui(v * scale, v * scale, v * scale, transparent ? 0 : max_value);
+			}
+			case 2:
+			{
+				Vec4ui c(sample(x, y, 0), sample(x, y, 1), sample(x, y, 2), max_value);
+				if (trns.size() == 6 && c.r == (unsigned int)((trns[0] << 8) | trns[1]) && c.g == (unsigned int)((trns[2] << 8) | trns[3]) && c.b == (unsigned int)((trns[4] << 8) | trns[5]))
+					c.a = 0;
+				return c;
+			}
+			case 3:
+			{
+				unsigned int i = sample(x, y, 0);
+				return Vec4ui(palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2], i < trns.size() ? trns[i] : 255);
+			}
+			case 4:
+			{
+				unsigned int v = sample(x, y, 0);
+				return Vec4ui(v, v, v, sample(x, y, 1));
+			}
+			default:
+				return Vec4ui(sample(x, y, 0), sample(x, y, 1), sample(x, y, 2), sample(x, y, 3));
+			}
+		}
+	};
+
+	SourceImage make_image(int width, int height, int bit_depth, int color_type, unsigned int seed)
+	{
+		SourceImage image;
+		image.width = width;
+		image.height = height;
+		image.bit_depth = bit_depth;
+		image.color_type = color_type;
+
+		// Gradients with noise give the predictors something to work with, while still covering all values
+		std::minstd_rand random(seed);
+		std::uniform_int_distribution<int> noise(-8, 8);
+		int row_size = image.row_size(width);
+		for (int y = 0; y < height; y++)
+		{
+			std::vector<unsigned char> row(row_size);
+			for (int i = 0; i < row_size; i++)
+				row[i] = (unsigned char)(i * 3 + y * 5 + noise(random));
+			image.rows.push_back(row);
+		}
+
+		if (color_type == 3)
+		{
+			for (int i = 0; i < 256 * 3; i++)
+				image.palette.push_back((unsigned char)(random() & 0xff));
+			image.palette.resize((1 << bit_depth) * 3);
+			for (int i = 0; i < (1 << bit_depth) / 2; i++)
+				image.trns.push_back((unsigned char)(i * 16));
+		}
+		else if (color_type == 0 && bit_depth == 8)
+		{
+			image.trns = { 0, 100 };
+		}
+		else if (color_type == 2 && bit_depth == 8)
+		{
+			image.trns = { 0, image.rows[0][0], 0, image.rows[0][1], 0, image.rows[0][2] };
+		}
+		return image;
+	}
+
+	class ChunkWriter
+	{
+	public:
+		ChunkWriter()
+		{
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+				crc_table[n] = c;
+			}
+			const unsigned char magic[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+			output.write(magic, 8);
+		}
+
+		void write(const char *name, const void *data, int size)
+		{
+			unsigned char header[8] = { (unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size };
+			memcpy(header + 4, name, 4);
+			output.write(header, 8);
+			output.write(data, size);
+
+			unsigned int c = 0xffffffff;
+			for (int i = 4; i < 8; i++)
+				c = crc_table[(c ^ header[i]) & 0xff] ^ (c >> 8);
+			for (int i = 0; i < size; i++)
+				c = crc_table[(c ^ static_cast<const unsigned char*>(data)[i]) & 0xff] ^ (c >> 8);
+			c ^= 0xffffffff;
+			unsigned char crc[4] = { (unsigned char)(c >> 24), (unsigned char)(c >> 16), (unsigned char)(c >> 8), (unsigned char)c };
+			output.write(crc, 4);
+		}
+
+		MemoryDevice output;
+
+	private:
+		unsigned int crc_table[256];
+	};
+
+	int predict(int filter_type, int a, int b, int c)
+	{
+		switch (filter_type)
+		{
+		case 1: return a;
+		case 2: return b;
+		case 3: return (a + b) / 2;
+		case 4:
+		{
+			int p = a + b - c;
+			int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+			return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+		}
+		default: return 0;
+		}
+	}
+
+	// Appends a filter type byte and the filtered scanlines of one image (or one Adam7 pass) to data
+	void filter_rows(const SourceImage &image, const std::vector<std::vector<unsigned char>> &rows, int filter_type, std::vector<unsigned char> &data)
+	{
+		int bpp = image.bytes_per_pixel();
+		std::vector<unsigned char> prev;
+		for (size_t y = 0; y < rows.size(); y++)
+		{
+			const std::vector<unsigned char> &row = rows[y];
+			prev.resize(row.size(), 0);
+			int type = filter_type >= 0 ? filter_type : (int)(y % 5);
+			data.push_back((unsigned char)type);
+			for (size_t i = 0; i < row.size(); i++)
+			{
+				int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+				int c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+				data.push_back((unsigned char)(row[i] - predict(type, a, prev[i], c)));
+			}
+			prev = row;
+		}
+	}
+
+	// Encodes with the given filter type for every scanline, or cycles through all of them if filter_type is -1
+	DataBuffer encode(const SourceImage &image, bool interlaced, int filter_type, int idat_size = 1000)
+	{
+		std::vector<unsigned char> data;
+		if (!interlaced)
+		{
+			filter_rows(image, image.rows, filter_type, data);
+		}
+		else
+		{
+			const int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
+			const int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
+			const int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
+			const int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
+			int bpp = image.bytes_per_pixel();
+			for (int pass = 0; pass < 7; pass++)
+			{
+				std::vector<std::vector<unsigned char>> rows;
+				for (int y = starting_row[pass]; y < image.height; y += row_increment[pass])
+				{
+					std::vector<unsigned char> row;
+					for (int x = starting_col[pass]; x < image.width; x += col_increment[pass])
+						row.insert(row.end(), image.rows[y].begin() + x * bpp, image.rows[y].begin() + (x + 1) * bpp);
+					if (!row.empty())
+						rows.push_back(row);
+				}
+				filter_rows(image, rows, filter_type, data);
+			}
+		}
+
+		unsigned char ihdr[13] = {
+			(unsigned char)(image.width >> 24), (unsigned char)(image.width >> 16), (unsigned char)(image.width >> 8), (unsigned char)image.width,
+			(unsigned char)(image.height >> 24), (unsigned char)(image.height >> 16), (unsigned char)(image.height >> 8), (unsigned char)image.height,
+			(unsigned char)image.bit_depth, (unsigned char)image.color_type, 0, 0, (unsigned char)(interlaced ? 1 : 0) };
+
+		ChunkWriter writer;
+		writer.write("IHDR", ihdr, 13);
+		if (!image.palette.empty())
+			writer.write("PLTE", image.palette.data(), (int)image.palette.size());
+		if (!image.trns.empty())
+			writer.write("tRNS", image.trns.data(), (int)image.trns.size());
+
+		// Small IDAT chunks make scanlines span chunk boundaries
+		DataBuffer compressed = ZLibCompression::compress(DataBuffer(data.data(), (int)data.size()), false, 6);
+		for (int pos = 0; pos < compressed.get_size(); pos += idat_size)
+			writer.write("IDAT", compressed.get_data() + pos, std::min(idat_size, (int)compressed.get_size() - pos));
+		writer.write("IEND", nullptr, 0);
+		return writer.output.get_data();
+	}
+
+	void verify(const SourceImage &source, const PixelBuffer &image, const std::string &description)
+	{
+		if (image.get_width() != source.width || image.get_height() != source.height)
+			throw Exception(description + ": wrong size");
+
+		for (int y = 0; y < source.height; y++)
+		{
+			for (int x = 0; x < source.width; x++)
+			{
+				Vec4ui expected = source.expected(x, y);
+				Vec4ui actual;
+				if (source.bit_depth == 16)
+				{
+					const unsigned short *p = image.get_line_uint16(y) + x * 4;
+					actual = Vec4ui(p[0], p[1], p[2], p[3]);
+				}
+				else
+				{
+					const unsigned char *p = image.get_line_uint8(y) + x * 4;
+					actual = Vec4ui(p[0], p[1], p[2], p[3]);
+				}
+
+				if (actual != expected)
+					throw Exception(string_format("%1: pixel %2,%3 is wrong", description, x, y));
+			}
+		}
+	}
+
+	PixelBuffer collect_rows(DataBuffer png)
+	{
+		MemoryDevice device(png);
+		PixelBuffer image;
+		int next_y = 0;
+		PNGProvider::load_rows(device, [&](int y, const PixelBuffer &row)
+		{
+			if (y != next_y++)
+				throw Exception("Rows were not delivered in order");
+			if (image.is_null())
+				image = PixelBuffer(row.get_width(), 1, row.get_format());
+			PixelBuffer grown(row.get_width(), y + 1, row.get_format());
+			for (int i = 0; i < y; i++)
+				memcpy(grown.get_line(i), image.get_line(i), row.get_pitch());
+			memcpy(grown.get_line(y), row.get_data(), row.get_pitch());
+			image = grown;
+		});
+		return image;
+	}
+}
+
+void test_formats()
+{
+	struct Format { int color_type; int bit_depth; };
+	const Format formats[] = { { 0, 1 }, { 0, 2 }, { 0, 4 }, { 0, 8 }, { 0, 16 }, { 2, 8 }, { 2, 16 }, { 3, 1 }, { 3, 2 }, { 3, 4 }, { 3, 8 }, { 4, 8 }, { 4, 16 }, { 6, 8 }, { 6, 16 } };
+	const int sizes[][2] = { { 1, 1 }, { 3, 2 }, { 37, 29 } };
+
+	for (const Format &format : formats)
+	{
+		for (auto &size : sizes)
+		{
+			SourceImage source = make_image(size[0], size[1], format.bit_depth, format.color_type, size[0] * 1000 + format.color_type * 10 + format.bit_depth);
+			for (int interlaced = 0; interlaced < 2; interlaced++)
+			{
+				// Adam7 sub-images of packed pixels are not supported by the encoder in this test
+				if (interlaced && format.bit_depth < 8)
+					continue;
+
+				for (int filter_type = -1; filter_type < 5; filter_type++)
+				{
+					std::string description = string_format("color type %1, %2 bit, %3x%4%5, filter %6", format.color_type, format.bit_depth, size[0], size[1], interlaced ? " interlaced" : "", filter_type);
+					DataBuffer png = encode(source, interlaced != 0, filter_type);
+
+					MemoryDevice device(png);
+					verify(source, PNGProvider::load(device), description);
+					verify(source, collect_rows(png), description + " (rows)");
+				}
+			}
+		}
+		Console::write_line("  color type %1, %2 bit: ok", format.color_type, format.bit_depth);
+	}
+}
+
+void test_corrupt()
+{
+	SourceImage source = make_image(64, 64, 8, 6, 1);
+	DataBuffer png = encode(source, false, 4);
+
+	// Missing image data, a broken CRC and garbage in the zlib stream must all fail
+	DataBuffer truncated(png.get_data(), png.get_size() / 2);
+	DataBuffer bad_crc(png.get_data(), png.get_size());
+	bad_crc.get_data()[png.get_size() / 2] ^= 0x55;
+
+	for (DataBuffer data : { truncated, bad_crc })
+	{
+		bool thrown = false;
+		try
+		{
+			MemoryDevice device(data);
+			PNGProvider::load(device);
+		}
+		catch (const Exception &)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+			throw Exception("Loading a corrupt PNG did not fail");
+	}
+}
+
+void benchmark(int size, int iterations)
+{
+	SourceImage source = make_image(size, size, 8, 6, 1);
+	const char *filter_names[] = { "none", "sub", "up", "average", "paeth" };
+	for (int filter_type = 0; filter_type < 5; filter_type++)
+	{
+		DataBuffer png = encode(source, false, filter_type, 64 * 1024);
+
+		uint64_t load_time = 0, rows_time = 0;
+		for (int i = 0; i < iterations; i++)
+		{
+			uint64_t start = System::get_microseconds();
+			MemoryDevice device(png);
+			PNGProvider::load(device);
+			load_time += System::get_microseconds() - start;
+
+			start = System::get_microseconds();
+			MemoryDevice device2(png);
+			PNGProvider::load_rows(device2, [](int y, const PixelBuffer &row) { });
+			rows_time += System::get_microseconds() - start;
+		}
+
+		double megapixels = size * (double)size / 1000000.0;
+		Console::write_line("  %1: %2 ms (%3 MP/s), row callback %4 ms",
+			filter_names[filter_type], (int)(load_time / iterations / 1000),
+			(int)(megapixels / (load_time / (double)iterations / 1000000.0)), (int)(rows_time / iterations / 1000));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int size = argc > 1 ? StringHelp::text_to_int(argv[1]) : 4096;
+		int iterations = argc > 2 ? StringHelp::text_to_int(argv[2]) : 3;
+
+		Console::write_line("Formats:");
+		test_formats();
+		test_corrupt();
+
+		Console::write_line("Decoding a %1x%2 rgba image:", size, size);
+		benchmark(size, iterations);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
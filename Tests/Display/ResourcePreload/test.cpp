@@ -0,0 +1,175 @@
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/xml.h>
+#include <ClanLib/gl.h>
+
+using namespace clan;
+
+// Resource preload benchmark for the display caches
+//
+// Writes a resource file with many generated images, then loads every resource of it on
+// first use, as a level load does without preloading, and once more with DisplayCache::preload
+// while a loading screen keeps drawing frames with a fixed upload budget.
+
+class App : public clan::Application
+{
+public:
+	App();
+	bool update() override;
+
+private:
+	void create_resources();
+	ResourceManager create_manager();
+	void on_window_close();
+
+	static const int image_count = 240;
+	static const int image_size = 256;
+	static const int frame_budget = 4000;
+
+	bool quit = false;
+	int frame = 0;
+	SlotContainer sc;
+	DisplayWindow window;
+	Canvas canvas;
+	WorkQueue queue;
+
+	std::vector<std::string> ids;
+	std::vector<Size> serial_sizes;
+
+	ResourceManager preload_resources;
+	uint64_t preload_start = 0;
+	uint64_t longest_frame = 0;
+	int preload_frames = 0;
+	int reported_resources = 0;
+};
+
+clan::ApplicationInstance<App> clanapp;
+
+App::App()
+{
+	clan::OpenGLTarget::set_current();
+	clan::XMLResourceFactory::set_display();
+
+	window = DisplayWindow("ClanLib Resource Preload", 1024, 768);
+	sc.connect(window.sig_window_close(), this, &App::on_window_close);
+	canvas = Canvas(window);
+
+	Console::write_line("Worker threads: %1", queue.get_num_workers());
+	create_resources();
+}
+
+void App::create_resources()
+{
+	Directory::create("PreloadImages");
+
+	// Noise does not compress, so decoding costs about the same as for real art
+	unsigned int seed = 1;
+	std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<resources>\n<section name=\"level\">\n";
+	for (int i = 0; i < image_count; i++)
+	{
+		PixelBuffer pixels(image_size, image_size, TextureFormat::rgba8);
+		unsigned int *data = pixels.get_data<unsigned int>();
+		for (int j = 0; j < image_size * image_size; j++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			data[j] = seed | 0xff000000;
+		}
+
+		std::string filename = string_format("PreloadImages/image%1.png", i);
+		PNGProvider::save(pixels, filename);
+
+		std::string name = string_format("resource%1", i);
+		ids.push_back("level/" + name);
+		if (i % 3 == 0)
+			xml += string_format("<sprite name=\"%1\"><image file=\"%2\"><grid pos=\"0,0\" size=\"64,64\" array=\"4,4\"/></image></sprite>\n", name, filename);
+		else if (i % 3 == 1)
+			xml += string_format("<image name=\"%1\"><image file=\"%2\"/></image>\n", name, filename);
+		else
+			xml += string_format("<texture name=\"%1\" file=\"%2\"/>\n", name, filename);
+	}
+	xml += "</section>\n</resources>\n";
+	File::write_text("preload.xml", xml);
+}
+
+ResourceManager App::create_manager()
+{
+	return XMLResourceManager::create(XMLResourceDocument("preload.xml"));
+}
+
+bool App::update()
+{
+	canvas.clear(Colorf::black);
+
+	if (frame == 0)
+	{
+		// Everything decoded and uploaded on this thread as it is requested
+		ResourceManager resources = create_manager();
+		DisplayCache &cache = DisplayCache::get(resources);
+		uint64_t start = System::get_microseconds();
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			if (i % 3 == 0)
+				serial_sizes.push_back(Size(cache.get_sprite(canvas, ids[i])->get_size()));
+			else if (i % 3 == 1)
+				serial_sizes.push_back(Size(cache.get_image(canvas, ids[i])->get_size()));
+			else
+				serial_sizes.push_back(cache.get_texture(canvas, ids[i])->to_texture_2d().get_size());
+		}
+		uint64_t time = System::get_microseconds() - start;
+		Console::write_line("Serial load of %1 resources: %2 ms, all in one frame", (int)ids.size(), (int)(time / 1000));
+
+		preload_resources = create_manager();
+		preload_start = System::get_microseconds();
+		DisplayCache::get(preload_resources).preload(ids, queue, [&](const DisplayPreloadProgress &progress)
+		{
+			if (progress.resources_loaded * 4 / progress.resources_total != reported_resources * 4 / progress.resources_total)
+				Console::write_line("  %1 of %2 resources, %3 of %4 images decoded", progress.resources_loaded, progress.resources_total, progress.images_decoded, progress.images_total);
+			reported_resources = progress.resources_loaded;
+		});
+		Console::write_line("Preload started in %1 ms", (int)((System::get_microseconds() - preload_start) / 1000));
+	}
+	else
+	{
+		// A loading screen that uploads within a fixed part of every frame
+		uint64_t frame_start = System::get_microseconds();
+		DisplayCache &cache = DisplayCache::get(preload_resources);
+		DisplayPreloadProgress progress = cache.update_preload(canvas, frame_budget);
+		longest_frame = std::max(longest_frame, System::get_microseconds() - frame_start);
+		preload_frames++;
+
+		float done = progress.resources_total ? progress.resources_loaded / (float)progress.resources_total : 1.0f;
+		canvas.fill_rect(Rectf(100.0f, 370.0f, 100.0f + 824.0f * done, 398.0f), Colorf::white);
+
+		if (progress.is_done())
+		{
+			Console::write_line("Parallel preload of %1 resources: %2 ms over %3 frames, longest frame %4 ms",
+				progress.resources_total, (int)(progress.microseconds / 1000), preload_frames, StringHelp::double_to_text(longest_frame / 1000.0, 2));
+
+			for (size_t i = 0; i < ids.size(); i++)
+			{
+				Size size;
+				if (i % 3 == 0)
+					size = Size(cache.get_sprite(canvas, ids[i])->get_size());
+				else if (i % 3 == 1)
+					size = Size(cache.get_image(canvas, ids[i])->get_size());
+				else
+					size = cache.get_texture(canvas, ids[i])->to_texture_2d().get_size();
+				if (size != serial_sizes[i])
+					throw Exception("Preloaded resource " + ids[i] + " differs from the serially loaded one");
+			}
+
+			Console::write_line("All Tests Complete");
+			quit = true;
+		}
+	}
+
+	frame++;
+	window.flip(0);
+	return !quit;
+}
+
+void App::on_window_close()
+{
+	quit = true;
+}
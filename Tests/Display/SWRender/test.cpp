@@ -0,0 +1,219 @@
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/swrender.h>
+
+using namespace clan;
+
+// Software renderer test
+//
+// Renders a frame using the standard programs (solid fills, gradients, paths, images, text, clipping and
+// a frame buffer canvas) without any window system or GPU, and compares selected pixels with the expected
+// colors. Afterwards the application loop keeps running to measure the time per frame, which also checks
+// that the display message queue works without an X display.
+
+class App : public clan::Application
+{
+public:
+	App();
+	bool update() override;
+
+private:
+	void draw_scene();
+	void check_pixel(const PixelBuffer &pixels, int x, int y, int r, int g, int b, int tolerance = 0);
+	void check_text(const PixelBuffer &pixels, const Rect &box);
+
+	SlotContainer sc;
+	DisplayWindow window;
+	Canvas canvas;
+	Font font;
+	Image checker;
+	Texture2D fb_texture;
+	FrameBuffer fb;
+	Canvas fb_canvas;
+	int failed = 0;
+	int frame = 0;
+	uint64_t start_time = 0;
+};
+
+clan::ApplicationInstance<App> clanapp;
+
+App::App()
+{
+	clan::SWRTarget::set_current();
+
+	DisplayWindowDescription desc;
+	desc.set_title("ClanLib SWRender Test");
+	desc.set_size(Size(320, 240), true);
+	window = DisplayWindow(desc);
+	canvas = Canvas(window);
+
+	FontDescription font_desc;
+	font_desc.set_height(16);
+	font = Font("Tahoma", font_desc);
+
+	// 4x4 image with a distinct color in every pixel
+	PixelBuffer pixels(4, 4, TextureFormat::rgba8);
+	uint8_t *data = pixels.get_data_uint8();
+	for (int i = 0; i < 16; i++)
+	{
+		data[i * 4 + 0] = i * 16;
+		data[i * 4 + 1] = 255 - i * 16;
+		data[i * 4 + 2] = (i % 2) * 255;
+		data[i * 4 + 3] = 255;
+	}
+	checker = Image(canvas, pixels, pixels.get_size());
+
+	GraphicContext gc = canvas.get_gc();
+	fb_texture = Texture2D(gc, 64, 64);
+	fb = FrameBuffer(gc);
+	fb.attach_color(0, fb_texture);
+	fb_canvas = Canvas(canvas, fb);
+}
+
+void App::draw_scene()
+{
+	canvas.clear(Colorf(0.0f, 0.0f, 1.0f));
+
+	// Solid and translucent fills
+	canvas.fill_rect(10.0f, 10.0f, 50.0f, 50.0f, Colorf(1.0f, 0.0f, 0.0f));
+	canvas.fill_rect(10.0f, 10.0f, 30.0f, 30.0f, Colorf(0.0f, 1.0f, 0.0f, 0.5f));
+
+	// Vertical gradient
+	canvas.fill_rect(60.0f, 10.0f, 160.0f, 50.0f, Gradient(Colorf(0.0f, 0.0f, 0.0f), Colorf(1.0f, 1.0f, 1.0f)));
+
+	// Paths with a solid and a linear gradient brush
+	Path::circle(220.0f, 30.0f, 20.0f).fill(canvas, Brush::solid(1.0f, 1.0f, 0.0f));
+	Brush gradient;
+	gradient.type = BrushType::linear;
+	gradient.start_point = Pointf(250.0f, 0.0f);
+	gradient.end_point = Pointf(310.0f, 0.0f);
+	gradient.stops.push_back(BrushGradientStop(Colorf(1.0f, 0.0f, 0.0f), 0.0f));
+	gradient.stops.push_back(BrushGradientStop(Colorf(0.0f, 1.0f, 0.0f), 1.0f));
+	Path::rect(250.0f, 10.0f, 60.0f, 40.0f).fill(canvas, gradient);
+
+	// Unscaled image
+	checker.draw(canvas, 10.0f, 60.0f);
+
+	// Clipped fill
+	canvas.set_cliprect(Rectf(100.0f, 60.0f, 120.0f, 80.0f));
+	canvas.fill_rect(90.0f, 50.0f, 130.0f, 90.0f, Colorf(1.0f, 1.0f, 1.0f));
+	canvas.reset_cliprect();
+
+	// Rendering to a texture and drawing it
+	fb_canvas.clear(Colorf(0.0f, 1.0f, 0.0f));
+	fb_canvas.fill_rect(0.0f, 0.0f, 32.0f, 32.0f, Colorf(1.0f, 0.0f, 0.0f));
+	fb_canvas.flush();
+	Image(fb_texture, Rect(0, 0, 64, 64)).draw(canvas, 200.0f, 60.0f);
+
+	// Text
+	font.draw_text(canvas, 10.0f, 200.0f, "Hello World", Colorf(1.0f, 1.0f, 1.0f));
+
+	canvas.flush();
+}
+
+void App::check_pixel(const PixelBuffer &pixels, int x, int y, int r, int g, int b, int tolerance)
+{
+	const uint8_t *p = pixels.get_data_uint8() + (x + y * pixels.get_width()) * 4;
+	if (std::abs(p[0] - r) > tolerance || std::abs(p[1] - g) > tolerance || std::abs(p[2] - b) > tolerance || p[3] != 255)
+	{
+		Console::write_line("Pixel at %1,%2 is %3 - expected %4",
+			x, y, string_format("%1,%2,%3,%4", p[0], p[1], p[2], p[3]), string_format("%1,%2,%3", r, g, b));
+		failed++;
+	}
+}
+
+void App::check_text(const PixelBuffer &pixels, const Rect &box)
+{
+	// The text must be drawn within the box and nowhere else in the bottom part of the window
+	int inside = 0, outside = 0;
+	for (int y = 130; y < pixels.get_height(); y++)
+	{
+		for (int x = 0; x < pixels.get_width(); x++)
+		{
+			const uint8_t *p = pixels.get_data_uint8() + (x + y * pixels.get_width()) * 4;
+			if (p[0] != 0 || p[1] != 0 || p[2] != 255)
+			{
+				if (box.contains(Point(x, y)))
+					inside++;
+				else
+					outside++;
+			}
+		}
+	}
+	if (inside < 50 || outside != 0)
+	{
+		Console::write_line("Text pixels: %1 inside, %2 outside", inside, outside);
+		failed++;
+	}
+}
+
+bool App::update()
+{
+	const int frames = 200;
+	if (frame > 0)
+	{
+		draw_scene();
+		window.flip(0);
+		if (frame++ < frames)
+			return true;
+
+		uint64_t frame_time = (System::get_microseconds() - start_time) / frames;
+		Console::write_line("%1 us per frame", (int)frame_time);
+		Console::write_line("All Tests Complete");
+		return false;
+	}
+
+	draw_scene();
+	PixelBuffer pixels = canvas.get_pixeldata();
+
+	check_pixel(pixels, 1, 1, 0, 0, 255);
+	check_pixel(pixels, 40, 40, 255, 0, 0);
+	check_pixel(pixels, 49, 49, 255, 0, 0);
+	check_pixel(pixels, 50, 50, 0, 0, 255);
+	check_pixel(pixels, 9, 9, 0, 0, 255);
+	check_pixel(pixels, 20, 20, 128, 128, 0, 2);
+
+	check_pixel(pixels, 100, 10, 3, 3, 3, 3);
+	check_pixel(pixels, 100, 30, 131, 131, 131, 4);
+	check_pixel(pixels, 100, 49, 252, 252, 252, 3);
+
+	check_pixel(pixels, 220, 30, 255, 255, 0);
+	check_pixel(pixels, 220, 8, 0, 0, 255);
+	check_pixel(pixels, 251, 30, 251, 4, 0, 4);
+	check_pixel(pixels, 280, 30, 128, 128, 0, 4);
+	check_pixel(pixels, 308, 30, 4, 251, 0, 4);
+
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			int i = x + y * 4;
+			check_pixel(pixels, 10 + x, 60 + y, i * 16, 255 - i * 16, (i % 2) * 255);
+		}
+	}
+
+	check_pixel(pixels, 110, 70, 255, 255, 255);
+	check_pixel(pixels, 100, 60, 255, 255, 255);
+	check_pixel(pixels, 99, 70, 0, 0, 255);
+	check_pixel(pixels, 120, 70, 0, 0, 255);
+	check_pixel(pixels, 110, 80, 0, 0, 255);
+
+	check_pixel(pixels, 210, 70, 255, 0, 0);
+	check_pixel(pixels, 250, 110, 0, 255, 0);
+	check_pixel(pixels, 231, 91, 255, 0, 0);
+	check_pixel(pixels, 232, 92, 0, 255, 0);
+
+	check_text(pixels, Rect(8, 180, 200, 210));
+
+	PixelBuffer fb_pixels = fb_texture.get_pixeldata(canvas, TextureFormat::rgba8);
+	check_pixel(fb_pixels, 0, 0, 255, 0, 0);
+	check_pixel(fb_pixels, 63, 63, 0, 255, 0);
+
+	if (failed != 0)
+		throw Exception(string_format("%1 software renderer checks failed", failed));
+
+	start_time = System::get_microseconds();
+	frame++;
+	return true;
+}
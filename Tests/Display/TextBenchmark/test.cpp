@@ -0,0 +1,274 @@
+#include <ClanLib/core.h>
+#include <ClanLib/application.h>
+#include <ClanLib/display.h>
+#include <ClanLib/gl.h>
+#include <ClanLib/swrender.h>
+#include <algorithm>
+
+using namespace clan;
+
+// Checks and text drawing benchmark for the glyph cache
+//
+// Usage: textbenchmark [-gl]
+//
+// Checks the glyph atlas and TextureGroup first. Then measures drawing text in fonts that have not
+// been used yet, with and without preparing the glyphs on a work queue first, then the cost of drawing
+// cached text every frame, and finally drawing so many font sizes that the shared glyph atlas has to
+// evict glyphs. Runs on the software renderer unless -gl is given.
+
+class App : public clan::Application
+{
+public:
+	App();
+	bool update() override;
+
+private:
+	std::vector<Font> create_fonts(const std::string &typeface, int first_height, int last_height, int step);
+	uint64_t draw_all(const std::vector<Font> &draw_fonts, int lines);
+	void on_window_close();
+
+	void check(bool condition, const std::string &message);
+	void check_texture_group_add();
+	void check_atlas_eviction();
+	void check_invalid_glyphs();
+	PixelBuffer draw_glyph(Font &font, const std::string &glyph);
+	static bool same_pixels(const PixelBuffer &a, const PixelBuffer &b);
+
+	bool quit = false;
+	int frame = 0;
+	SlotContainer sc;
+	DisplayWindow window;
+	Canvas canvas;
+	WorkQueue queue;
+
+	std::string text;
+	std::vector<Font> fonts;
+	uint64_t warm_time = 0;
+	int warm_frames = 0;
+	int failed = 0;
+};
+
+clan::ApplicationInstance<App> clanapp;
+
+App::App()
+{
+	const std::vector<std::string> &args = main_args();
+	if (std::find(args.begin(), args.end(), std::string("-gl")) != args.end())
+		clan::OpenGLTarget::set_current();
+	else
+		clan::SWRTarget::set_current();
+
+	window = DisplayWindow("ClanLib Text Benchmark", 1024, 768);
+	sc.connect(window.sig_window_close(), this, &App::on_window_close);
+	canvas = Canvas(window);
+
+	text = "The quick brown fox jumps over the lazy dog 0123456789 ÆØÅæøå àéîõü ΑΒΓΔΕαβγδε АБВГДабвгд";
+	Console::write_line("Worker threads: %1", queue.get_num_workers());
+}
+
+std::vector<Font> App::create_fonts(const std::string &typeface, int first_height, int last_height, int step)
+{
+	std::vector<Font> new_fonts;
+	for (int height = first_height; height <= last_height; height += step)
+	{
+		FontDescription desc;
+		desc.set_height(height);
+		desc.set_subpixel(false);
+		new_fonts.push_back(Font(typeface, desc));
+	}
+	return new_fonts;
+}
+
+uint64_t App::draw_all(const std::vector<Font> &draw_fonts, int lines)
+{
+	uint64_t start = System::get_microseconds();
+	for (int line = 0; line < lines; line++)
+	{
+		Font font = draw_fonts[line % draw_fonts.size()];
+		font.draw_text(canvas, 10.0f, 20.0f + (line % 40) * 18.0f, text, Colorf::white);
+	}
+	canvas.flush();
+	return System::get_microseconds() - start;
+}
+
+void App::check(bool condition, const std::string &message)
+{
+	if (!condition)
+	{
+		Console::write_line("Failed: %1", message);
+		failed++;
+	}
+}
+
+// add() must return the texture the space was found in, also when it is an older one than the active texture
+void App::check_texture_group_add()
+{
+	GraphicContext gc = canvas.get_gc();
+	TextureGroup group(Size(64, 64));
+	group.set_texture_allocation_policy(TextureGroup::search_previous_textures);
+
+	Subtexture left = group.add(gc, Size(32, 64));
+	Subtexture full = group.add(gc, Size(64, 64));
+	Subtexture right = group.add(gc, Size(32, 64));
+
+	std::vector<Texture2D> textures = group.get_textures();
+	check(textures.size() == 2, "TextureGroup created a texture although an older one had space");
+	check(textures.size() == 2 && left.get_texture() == textures[0] && full.get_texture() == textures[1], "TextureGroup::add returned the wrong texture for a new texture");
+	check(textures.size() == 2 && right.get_texture() == textures[0] && group.get_subtexture_count(0) == 2, "TextureGroup::add did not return the older texture its space was found in");
+}
+
+PixelBuffer App::draw_glyph(Font &font, const std::string &glyph)
+{
+	canvas.clear(Colorf::black);
+	font.draw_text(canvas, 10.0f, 60.0f, glyph, Colorf::white);
+	canvas.flush();
+	return canvas.get_pixeldata(Rect(0, 0, 80, 80));
+}
+
+bool App::same_pixels(const PixelBuffer &a, const PixelBuffer &b)
+{
+	if (a.get_size() != b.get_size())
+		return false;
+	for (int y = 0; y < a.get_height(); y++)
+	{
+		if (memcmp(a.get_line(y), b.get_line(y), a.get_width() * 4) != 0)
+			return false;
+	}
+	return true;
+}
+
+// Two families sharing a texture group share one atlas, so filling it with the glyphs of one family evicts the
+// least recently used glyphs of the other. Those are then rasterized again when they are used.
+void App::check_atlas_eviction()
+{
+	TextureGroup group(Size(128, 128));
+	FontDescription desc;
+	desc.set_height(40);
+	desc.set_subpixel(false);
+
+	FontFamily family_a("Atlas check A", group);
+	family_a.add("Tahoma", desc);
+	FontFamily family_b("Atlas check B", group);
+	family_b.add("Tahoma", desc);
+
+	Font font_a(family_a, desc);
+	PixelBuffer first_image = draw_glyph(font_a, "A");
+	check(group.get_subtexture_count() == 1, "Glyph was not placed in the texture group of its family");
+	draw_glyph(font_a, "A");
+	check(group.get_subtexture_count() == 1, "Cached glyph was rasterized again");
+
+	bool evicted = false;
+	for (int height = 20; height < 64 && !evicted; height++)
+	{
+		FontDescription flood_desc = desc.clone();
+		flood_desc.set_height(height);
+		Font font_b(family_b, flood_desc);
+
+		int count = group.get_subtexture_count();
+		canvas.clear(Colorf::black);
+		font_b.draw_text(canvas, 10.0f, 100.0f, "BCDEFGHIJKLMNOPQRSTUVWXYZ", Colorf::white);
+		canvas.flush();
+		evicted = group.get_subtexture_count() < count;
+		check(group.get_texture_count() <= 8, "Glyph atlas grew beyond its texture limit");
+	}
+	check(evicted, "Glyph atlas never evicted any glyphs");
+
+	int count = group.get_subtexture_count();
+	PixelBuffer evicted_image = draw_glyph(font_a, "A");
+	check(group.get_subtexture_count() == count + 1, "Glyph evicted by another family sharing the texture group was not rasterized again");
+	check(!same_pixels(first_image, draw_glyph(font_a, " ")), "Glyph was not drawn");
+	check(same_pixels(first_image, evicted_image), "Glyph rasterized again after eviction looks different");
+}
+
+// Glyphs the font engine cannot create are remembered. U+0000 is never inserted into a glyph cache, so looking
+// it up again must cost a hash lookup, not a call to the font engine.
+void App::check_invalid_glyphs()
+{
+	FontDescription desc;
+	desc.set_height(60);
+	desc.set_subpixel(false);
+	Font font("Tahoma", desc);
+	font.get_metrics(canvas, 'A');
+
+	const int raster_count = 64;
+	uint64_t start = System::get_microseconds();
+	for (int i = 0; i < raster_count; i++)
+		font.get_metrics(canvas, 0x4e00 + i);
+	double raster_time = (System::get_microseconds() - start) / (double)raster_count;
+
+	GlyphMetrics metrics = font.get_metrics(canvas, 0);
+	check(metrics.advance.width == 0.0f, "Invalid glyph has metrics");
+
+	const int lookup_count = 1000;
+	start = System::get_microseconds();
+	for (int i = 0; i < lookup_count; i++)
+		font.get_metrics(canvas, 0);
+	double lookup_time = (System::get_microseconds() - start) / (double)lookup_count;
+	check(lookup_time * 10.0 < raster_time, string_format("Invalid glyph lookups take %1 us, rasterizing a glyph %2 us", StringHelp::double_to_text(lookup_time, 3), StringHelp::double_to_text(raster_time, 1)));
+
+	std::string text("A\0A", 3);
+	check(font.measure_text(canvas, text).advance.width == font.measure_text(canvas, "AA").advance.width, "Invalid glyph changed the measured text width");
+}
+
+bool App::update()
+{
+	canvas.clear(Colorf::black);
+
+	if (frame == 0)
+	{
+		check_texture_group_add();
+		check_atlas_eviction();
+		check_invalid_glyphs();
+		if (failed != 0)
+			throw Exception(string_format("%1 glyph cache checks failed", failed));
+		canvas.clear(Colorf::black);
+
+		// Glyphs are rasterized one at a time as the text is drawn
+		std::vector<Font> cold_fonts = create_fonts("Tahoma", 10, 40, 2);
+		uint64_t time = draw_all(cold_fonts, (int)cold_fonts.size());
+		Console::write_line("Cold draw of %1 font sizes: %2 ms", (int)cold_fonts.size(), (int)(time / 1000));
+	}
+	else if (frame == 1)
+	{
+		// The same amount of new glyphs, rasterized as one batch per font first
+		fonts = create_fonts("Tahoma", 11, 41, 2);
+		uint64_t start = System::get_microseconds();
+		for (auto &font : fonts)
+			font.prepare_glyphs(canvas, text, queue);
+		uint64_t prepare_time = System::get_microseconds() - start;
+		uint64_t time = draw_all(fonts, (int)fonts.size());
+		Console::write_line("Prepared draw of %1 font sizes: %2 ms (prepare %3 ms)", (int)fonts.size(), (int)((prepare_time + time) / 1000), (int)(prepare_time / 1000));
+	}
+	else if (frame < 102)
+	{
+		// Every glyph is cached now
+		warm_time += draw_all(fonts, 400);
+		warm_frames++;
+		if (frame == 101)
+		{
+			double glyphs = (double)warm_frames * 400 * StringHelp::utf8_length(text);
+			Console::write_line("Cached draw: %1 ms per frame of 400 lines, %2 million glyphs per second", StringHelp::double_to_text(warm_time / 1000.0 / warm_frames, 2), StringHelp::double_to_text(glyphs / warm_time, 2));
+		}
+	}
+	else
+	{
+		// Two families in every size up to 120 pixels do not fit the atlas at once
+		std::vector<Font> many_fonts = create_fonts("Tahoma", 8, 120, 1);
+		std::vector<Font> serif_fonts = create_fonts("Times New Roman", 8, 120, 1);
+		many_fonts.insert(many_fonts.end(), serif_fonts.begin(), serif_fonts.end());
+		uint64_t time = draw_all(many_fonts, (int)many_fonts.size());
+		time += draw_all(many_fonts, (int)many_fonts.size());
+		Console::write_line("Two passes over %1 fonts with eviction: %2 ms", (int)many_fonts.size(), (int)(time / 1000));
+		Console::write_line("All Tests Complete");
+		quit = true;
+	}
+
+	frame++;
+	window.flip(0);
+	return !quit;
+}
+
+void App::on_window_close()
+{
+	quit = true;
+}
@@ -0,0 +1,179 @@
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <algorithm>
+
+using namespace clan;
+
+// Loopback load test for NetGameServer
+//
+// Usage: netgameload [clients] [io threads] [seconds] [flush delay ms]
+//
+// Every client keeps one "ping" in flight. The server echoes it back and the client
+// measures the round trip. An io thread count of zero uses one thread per connection.
+// Measuring starts once the server has accepted every client.
+// Afterwards the server broadcasts a burst of events to all clients. The test fails if any are not delivered.
+// The clients still wait with select(), so keep the total descriptor count below FD_SETSIZE.
+
+class LoadTest
+{
+public:
+	LoadTest(int num_clients, int io_threads, int seconds, int flush_delay) : num_clients(num_clients), io_threads(io_threads), seconds(seconds), flush_delay(flush_delay), server(io_threads)
+	{
+	}
+
+	void run()
+	{
+		Console::write_line("Clients: %1, I/O threads: %2 (%3), flush delay: %4 ms", num_clients, io_threads, io_threads > 0 ? "reactor" : "thread per connection", flush_delay);
+
+		server.set_flush_delay(flush_delay);
+
+		sc.connect(server.sig_client_connected(), [&](NetGameConnection *) { clients_connected++; });
+		sc.connect(server.sig_event_view_received(), [&](NetGameConnection *connection, const NetGameEventView &e) { connection->send_event(NetGameEvent("pong", { e.get_argument(0).get_uinteger() })); });
+		server.start("localhost", "4557");
+
+		start_time = System::get_microseconds();
+
+		for (int i = 0; i < num_clients; i++)
+		{
+			std::unique_ptr<NetGameClient> client(new NetGameClient());
+			NetGameClient *client_ptr = client.get();
+			sc.connect(client->sig_connected(), [this, client_ptr]() { send_ping(client_ptr); });
+			sc.connect(client->sig_event_view_received(), [this, client_ptr](const NetGameEventView &e) { if (e.name_equals("pong")) on_pong(client_ptr, e); else broadcasts_received++; });
+			client->connect("localhost", "4557");
+			clients.push_back(std::move(client));
+		}
+
+		// Do not count the connection storm
+		uint64_t connect_start = System::get_microseconds();
+		while (clients_connected < num_clients && System::get_microseconds() - connect_start < 30000000)
+		{
+			process();
+			System::sleep(0);
+		}
+		if (clients_connected < num_clients)
+			throw Exception(string_format("Only %1 of %2 clients connected", clients_connected, num_clients));
+		Console::write_line("Connected in %1 seconds", StringHelp::double_to_text((System::get_microseconds() - connect_start) / 1000000.0, 2));
+		latencies.clear();
+		uint64_t measure_start = System::get_microseconds();
+
+		while (System::get_microseconds() - measure_start < (uint64_t)seconds * 1000000)
+		{
+			process();
+			System::sleep(0);
+		}
+
+		uint64_t elapsed = System::get_microseconds() - measure_start;
+		report(elapsed);
+
+		run_broadcast();
+
+		for (auto &client : clients)
+			client->disconnect();
+		server.stop();
+	}
+
+private:
+	void process()
+	{
+		server.process_events();
+		for (auto &client : clients)
+			client->process_events();
+	}
+
+	void run_broadcast()
+	{
+		const int num_events = 2000;
+		int expected = num_events * (int)clients.size();
+
+		// Let the echo traffic drain so it does not mix with the burst
+		stop_pinging = true;
+		System::sleep(200);
+		process();
+
+		broadcasts_received = 0;
+		uint64_t broadcast_start = System::get_microseconds();
+		for (int i = 0; i < num_events; i++)
+			server.send_event(NetGameEvent("state", { i, "broadcast payload" }));
+
+		while (broadcasts_received < expected && System::get_microseconds() - broadcast_start < 10000000)
+		{
+			process();
+			System::sleep(0);
+		}
+
+		if (broadcasts_received < expected)
+			throw Exception(string_format("Broadcast: only %1 of %2 events delivered", broadcasts_received, expected));
+
+		double seconds_elapsed = (System::get_microseconds() - broadcast_start) / 1000000.0;
+		Console::write_line("Broadcast: %1 events delivered in %2 seconds (%3 events/sec)", expected, StringHelp::double_to_text(seconds_elapsed, 3), (int)(expected / seconds_elapsed));
+	}
+
+	void send_ping(NetGameClient *client)
+	{
+		unsigned int timestamp = (unsigned int)(System::get_microseconds() - start_time);
+		client->send_event(NetGameEvent("ping", { timestamp }));
+	}
+
+	void on_pong(NetGameClient *client, const NetGameEventView &e)
+	{
+		unsigned int now = (unsigned int)(System::get_microseconds() - start_time);
+		unsigned int sent = e.get_argument(0).get_uinteger();
+		latencies.push_back(now - sent);
+		if (!stop_pinging)
+			send_ping(client);
+	}
+
+	void report(uint64_t elapsed_microseconds)
+	{
+		if (latencies.empty())
+		{
+			Console::write_line("No messages were echoed");
+			return;
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		double seconds_elapsed = elapsed_microseconds / 1000000.0;
+		double messages_per_second = latencies.size() / seconds_elapsed;
+		unsigned int p50 = latencies[latencies.size() / 2];
+		unsigned int p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+
+		Console::write_line("Round trips: %1 in %2 seconds", (int)latencies.size(), StringHelp::double_to_text(seconds_elapsed, 2));
+		Console::write_line("Messages/sec: %1 (each round trip is two messages)", (int)(messages_per_second * 2));
+		Console::write_line("Latency p50: %1 us, p99: %2 us, max: %3 us", p50, p99, latencies.back());
+	}
+
+	int num_clients;
+	int io_threads;
+	int seconds;
+	int flush_delay;
+	uint64_t start_time = 0;
+	bool stop_pinging = false;
+	int clients_connected = 0;
+	int broadcasts_received = 0;
+
+	NetGameServer server;
+	std::vector<std::unique_ptr<NetGameClient>> clients;
+	std::vector<unsigned int> latencies;
+	SlotContainer sc;
+};
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int num_clients = argc > 1 ? StringHelp::text_to_int(argv[1]) : 200;
+		int io_threads = argc > 2 ? StringHelp::text_to_int(argv[2]) : 2;
+		int seconds = argc > 3 ? StringHelp::text_to_int(argv[3]) : 5;
+		int flush_delay = argc > 4 ? StringHelp::text_to_int(argv[4]) : 0;
+
+		LoadTest test(num_clients, io_threads, seconds, flush_delay);
+		test.run();
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,220 @@
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <algorithm>
+#include <random>
+
+using namespace clan;
+
+// Bandwidth and CPU benchmark for the NetGame snapshot channel
+//
+// Usage: netgamesnapshot [entities] [ticks] [percent moving per tick]
+//
+// Simulates a world where a fraction of the entities move every tick and a few spawn or
+// despawn. Prints what one tick costs with the tagged NetGameEvent encoding, a full snapshot
+// and a delta snapshot, and then replicates the world to a client over loopback and verifies
+// that the client ends up with exactly the server state.
+
+class SnapshotTest
+{
+public:
+	SnapshotTest(int num_entities, int ticks, int percent_moving) : num_entities(num_entities), ticks(ticks), percent_moving(percent_moving)
+	{
+		field_x = schema.add_float(0.0f, 4096.0f, 16);
+		field_y = schema.add_float(0.0f, 4096.0f, 16);
+		field_angle = schema.add_float(0.0f, 6.2832f, 10);
+		field_health = schema.add_int();
+		field_type = schema.add_int();
+	}
+
+	void run()
+	{
+		Console::write_line("Entities: %1, ticks: %2, moving per tick: %3%%", num_entities, ticks, percent_moving);
+
+		NetGameSnapshot world(schema);
+		for (int i = 0; i < num_entities; i++)
+			spawn(world, next_id++);
+
+		measure_codec(world);
+		measure_loopback(world);
+	}
+
+private:
+	void spawn(NetGameSnapshot &world, unsigned int id)
+	{
+		std::uniform_real_distribution<float> position(0.0f, 4096.0f);
+		world.set_float(id, field_x, position(random));
+		world.set_float(id, field_y, position(random));
+		world.set_float(id, field_angle, 0.0f);
+		world.set_int(id, field_health, 100);
+		world.set_int(id, field_type, id % 8);
+	}
+
+	void tick(NetGameSnapshot &world)
+	{
+		std::uniform_int_distribution<int> percent(0, 99);
+		std::uniform_real_distribution<float> step(-4.0f, 4.0f);
+
+		for (int i = 0; i < world.get_entity_count(); i++)
+		{
+			unsigned int id = world.get_entity_id(i);
+			if (percent(random) >= percent_moving)
+				continue;
+
+			world.set_float(id, field_x, world.get_float(id, field_x) + step(random));
+			world.set_float(id, field_y, world.get_float(id, field_y) + step(random));
+			world.set_float(id, field_angle, std::fmod(world.get_float(id, field_angle) + 0.1f, 6.28f));
+			if (percent(random) < 5)
+				world.set_int(id, field_health, std::max(world.get_int(id, field_health) - 1, 0));
+		}
+
+		// A few entities despawn and spawn every tick
+		for (int i = 0; i < 2 && world.get_entity_count() > 0; i++)
+			world.remove_entity(world.get_entity_id(random() % world.get_entity_count()));
+		for (int i = 0; i < 2; i++)
+			spawn(world, next_id++);
+	}
+
+	void measure_codec(NetGameSnapshot world)
+	{
+		// Tagged encoding: the id and every field as a 1 byte type plus 4 byte value, in events of at most 32000 bytes
+		uint64_t tagged_bytes = 0;
+		uint64_t full_bytes = 0;
+		uint64_t delta_bytes = 0;
+		uint64_t zlib_bytes = 0;
+		uint64_t encode_time = 0;
+		uint64_t decode_time = 0;
+
+		NetGameSnapshot baseline = world;
+		NetGameSnapshot client_baseline = world;
+		for (int t = 0; t < ticks; t++)
+		{
+			tick(world);
+
+			uint64_t entity_bytes = (uint64_t)world.get_entity_count() * (1 + schema.get_field_count()) * 5;
+			tagged_bytes += entity_bytes + (entity_bytes / 32000 + 1) * 16;
+
+			full_bytes += NetGameSnapshot::encode(world, nullptr).get_size();
+
+			uint64_t start = System::get_microseconds();
+			DataBuffer delta = NetGameSnapshot::encode(world, &baseline);
+			encode_time += System::get_microseconds() - start;
+			delta_bytes += delta.get_size();
+			zlib_bytes += std::min(ZLibCompression::compress(delta, true, 1).get_size(), delta.get_size());
+
+			start = System::get_microseconds();
+			client_baseline = NetGameSnapshot::decode(schema, delta.get_data(), delta.get_size(), &client_baseline);
+			decode_time += System::get_microseconds() - start;
+
+			baseline = world;
+		}
+
+		if (!equals(world, client_baseline))
+			throw Exception("Decoded snapshot does not match the encoded one");
+
+		Console::write_line("Bytes per tick:");
+		Console::write_line("  Tagged events:  %1", (int)(tagged_bytes / ticks));
+		Console::write_line("  Full snapshot:  %1", (int)(full_bytes / ticks));
+		Console::write_line("  Delta:          %1", (int)(delta_bytes / ticks));
+		Console::write_line("  Delta and zlib: %1 (%2x smaller than tagged events)", (int)(zlib_bytes / ticks), StringHelp::double_to_text(tagged_bytes / (double)zlib_bytes, 1));
+		Console::write_line("Delta encode: %1 us/tick, decode: %2 us/tick", (int)(encode_time / ticks), (int)(decode_time / ticks));
+	}
+
+	void measure_loopback(NetGameSnapshot world)
+	{
+		NetGameServer server;
+		NetGameClient client;
+		client.set_snapshot_schema(schema);
+
+		std::vector<NetGameSnapshot> sent;
+		int received = 0;
+		bool connected = false;
+		SlotContainer sc;
+		sc.connect(server.sig_client_connected(), [&](NetGameConnection *) { connected = true; });
+		sc.connect(client.sig_snapshot_received(), [&](const NetGameSnapshot &snapshot)
+		{
+			if (!equals(snapshot, sent.at(snapshot.get_sequence() - 1)))
+				throw Exception("Client snapshot does not match the server state");
+			received++;
+		});
+
+		server.start("localhost", "4559");
+		client.connect("localhost", "4559");
+		while (!connected)
+		{
+			System::sleep(10);
+			server.process_events();
+			client.process_events();
+		}
+
+		uint64_t start = System::get_microseconds();
+		for (int t = 0; t < ticks; t++)
+		{
+			tick(world);
+			sent.push_back(world);
+			server.send_snapshot(world);
+			server.process_events();
+			client.process_events();
+		}
+
+		while (received < ticks && System::get_microseconds() - start < 10000000)
+		{
+			System::sleep(1);
+			server.process_events();
+			client.process_events();
+		}
+		uint64_t elapsed = System::get_microseconds() - start;
+
+		Console::write_line("Loopback: %1 of %2 snapshots replicated and verified in %3 ms", received, ticks, (int)(elapsed / 1000));
+
+		client.disconnect();
+		server.stop();
+	}
+
+	bool equals(const NetGameSnapshot &a, const NetGameSnapshot &b)
+	{
+		if (a.get_entity_count() != b.get_entity_count())
+			return false;
+
+		for (int i = 0; i < a.get_entity_count(); i++)
+		{
+			unsigned int id = a.get_entity_id(i);
+			if (b.get_entity_id(i) != id)
+				return false;
+			for (int field = 0; field < schema.get_field_count(); field++)
+			{
+				bool same = schema.is_float(field) ? a.get_float(id, field) == b.get_float(id, field) : a.get_int(id, field) == b.get_int(id, field);
+				if (!same)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	int num_entities;
+	int ticks;
+	int percent_moving;
+	unsigned int next_id = 1;
+	std::minstd_rand random;
+
+	NetGameSnapshotSchema schema;
+	int field_x, field_y, field_angle, field_health, field_type;
+};
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int num_entities = argc > 1 ? StringHelp::text_to_int(argv[1]) : 10000;
+		int ticks = argc > 2 ? StringHelp::text_to_int(argv[2]) : 200;
+		int percent_moving = argc > 3 ? StringHelp::text_to_int(argv[3]) : 10;
+
+		SnapshotTest test(num_entities, ticks, percent_moving);
+		test.run();
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
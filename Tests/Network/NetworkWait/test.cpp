@@ -0,0 +1,209 @@
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <thread>
+
+using namespace clan;
+
+// Tests and benchmark for NetworkConditionVariable with many sockets
+//
+// Usage: networkwait [idle sockets] [wakeups]
+//
+// A few active UDP sockets receive datagrams while thousands of idle sockets are waited on as
+// well. Waiting with wait() passes every socket on each call, while wait_ready() keeps them
+// registered and only returns the sockets that became ready.
+
+namespace
+{
+	const int active_count = 4;
+	const int first_active_port = 4570;
+
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	int drain(UDPSocket *socket)
+	{
+		char buffer[64];
+		SocketName from;
+		int count = 0;
+		while (socket->read(buffer, sizeof(buffer), from) > 0)
+			count++;
+		return count;
+	}
+}
+
+class WaitTest
+{
+public:
+	WaitTest(int idle_count)
+	{
+		for (int i = 0; i < active_count; i++)
+		{
+			active.push_back(std::unique_ptr<UDPSocket>(new UDPSocket()));
+			active.back()->bind(SocketName("127.0.0.1", StringHelp::int_to_text(first_active_port + i)));
+			endpoints.push_back(SocketName("127.0.0.1", StringHelp::int_to_text(first_active_port + i)));
+		}
+
+		for (int i = 0; i < idle_count; i++)
+		{
+			idle.push_back(std::unique_ptr<UDPSocket>(new UDPSocket()));
+			idle.back()->bind(SocketName("127.0.0.1", "0"));
+		}
+
+		for (auto &socket : idle)
+			all_events.push_back(socket.get());
+		for (auto &socket : active)
+			all_events.push_back(socket.get());
+	}
+
+	void test_wait_ready()
+	{
+		NetworkConditionVariable condition;
+		std::mutex mutex;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (NetworkEvent *event : all_events)
+			condition.add(event);
+
+		NetworkEvent *ready[16];
+
+		// Sockets are reported writable when first registered
+		while (condition.wait_ready(lock, ready, 16, 0) > 0);
+
+		if (condition.wait_ready(lock, ready, 16, 0) != 0)
+			fail("wait_ready reported a socket without pending data");
+
+		sender.send("x", 1, endpoints[2]);
+		int count = condition.wait_ready(lock, ready, 16, 1000);
+		if (count != 1 || ready[0] != active[2].get())
+			fail("wait_ready did not report exactly the socket that received data");
+		if (drain(active[2].get()) != 1)
+			fail("Datagram was not received");
+
+		if (condition.wait_ready(lock, ready, 16, 0) != 0)
+			fail("wait_ready reported a drained socket again");
+
+		for (int i = 0; i < active_count; i++)
+			sender.send("x", 1, endpoints[i]);
+		count = 0;
+		uint64_t start = System::get_microseconds();
+		while (count < active_count && System::get_microseconds() - start < 1000000)
+		{
+			int ready_count = condition.wait_ready(lock, ready, 16, 100);
+			for (int i = 0; i < ready_count; i++)
+				count += drain(static_cast<UDPSocket *>(ready[i]));
+		}
+		if (count != active_count)
+			fail("wait_ready missed one of several ready sockets");
+
+		std::thread notifier([&]() { System::sleep(50); condition.notify(); });
+		start = System::get_microseconds();
+		count = condition.wait_ready(lock, ready, 16, 5000);
+		notifier.join();
+		if (count != 0 || System::get_microseconds() - start > 2000000)
+			fail("notify did not wake wait_ready");
+
+		condition.remove(active[0].get());
+		sender.send("x", 1, endpoints[0]);
+		if (condition.wait_ready(lock, ready, 16, 100) != 0)
+			fail("wait_ready reported a removed socket");
+		drain(active[0].get());
+
+		for (NetworkEvent *event : all_events)
+			condition.remove(event);
+	}
+
+	void test_wait()
+	{
+		NetworkConditionVariable condition;
+		std::mutex mutex;
+		std::unique_lock<std::mutex> lock(mutex);
+
+		sender.send("x", 1, endpoints[3]);
+		if (!condition.wait(lock, all_events.size(), all_events.data(), 1000))
+			fail("wait did not wake up for a socket beyond FD_SETSIZE");
+		if (drain(active[3].get()) != 1)
+			fail("Datagram was not received");
+	}
+
+	void benchmark(int wakeups)
+	{
+		NetworkConditionVariable condition;
+		std::mutex mutex;
+		std::unique_lock<std::mutex> lock(mutex);
+
+		uint64_t start = System::get_microseconds();
+		for (int i = 0; i < wakeups; i++)
+		{
+			sender.send("x", 1, endpoints[i % active_count]);
+			int received = 0;
+			while (received == 0)
+			{
+				condition.wait(lock, all_events.size(), all_events.data(), 1000);
+				for (auto &socket : active)
+					received += drain(socket.get());
+			}
+		}
+		uint64_t wait_time = System::get_microseconds() - start;
+
+		for (NetworkEvent *event : all_events)
+			condition.add(event);
+
+		NetworkEvent *ready[16];
+		while (condition.wait_ready(lock, ready, 16, 0) > 0);
+
+		start = System::get_microseconds();
+		for (int i = 0; i < wakeups; i++)
+		{
+			sender.send("x", 1, endpoints[i % active_count]);
+			int received = 0;
+			while (received == 0)
+			{
+				int count = condition.wait_ready(lock, ready, 16, 1000);
+				for (int j = 0; j < count; j++)
+					received += drain(static_cast<UDPSocket *>(ready[j]));
+			}
+		}
+		uint64_t wait_ready_time = System::get_microseconds() - start;
+
+		for (NetworkEvent *event : all_events)
+			condition.remove(event);
+
+		Console::write_line("  wait:       %1 us per wakeup", (int)(wait_time / wakeups));
+		Console::write_line("  wait_ready: %1 us per wakeup", (int)(wait_ready_time / wakeups));
+	}
+
+private:
+	UDPSocket sender;
+	std::vector<std::unique_ptr<UDPSocket>> active;
+	std::vector<std::unique_ptr<UDPSocket>> idle;
+	std::vector<SocketName> endpoints;
+	std::vector<NetworkEvent *> all_events;
+};
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int idle_count = argc > 1 ? StringHelp::text_to_int(argv[1]) : 5000;
+		int wakeups = argc > 2 ? StringHelp::text_to_int(argv[2]) : 2000;
+
+		WaitTest test(idle_count);
+
+		Console::write_line("Registered waits");
+		test.test_wait_ready();
+		Console::write_line("Waits on every socket");
+		test.test_wait();
+
+		Console::write_line("Wakeups with %1 idle and %2 active sockets:", idle_count, active_count);
+		test.benchmark(wakeups);
+
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -1,6 +0,0 @@
-
-#pragma once
-
-#include <vector>
-#include <ClanLib/core.h>
-#include <ClanLib/network.h>
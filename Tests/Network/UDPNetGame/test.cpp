@@ -0,0 +1,384 @@
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>
+
+using namespace clan;
+
+// Tests for the UDP transport of NetGameServer and NetGameClient
+//
+// Usage: udpnetgame [loss percent] [seconds per latency measurement]
+//
+// The client talks to the server through a relay that drops and delays datagrams, so the
+// reliable channels have to resend and the ordered channel has to put events back in order.
+// Afterwards a ping is sent every two milliseconds and its round trip is measured over TCP
+// and over each UDP channel. Under loss the reliable ordered channel shows the same head of
+// line blocking as TCP, while pings on the other channels do not wait for lost ones.
+
+namespace
+{
+	const std::string server_port = "4560";
+	const std::string relay_port = "4561";
+	const std::string tcp_port = "4562";
+
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+
+	template<typename Condition>
+	bool process_until(NetGameServer &server, NetGameClient &client, Condition condition, int timeout_ms)
+	{
+		uint64_t start = System::get_microseconds();
+		while (!condition())
+		{
+			if (System::get_microseconds() - start > (uint64_t)timeout_ms * 1000)
+				return false;
+			server.process_events();
+			client.process_events();
+			System::sleep(1);
+		}
+		return true;
+	}
+}
+
+// Forwards datagrams between one client and the server, dropping some and delaying the rest by a random amount
+class LossyRelay
+{
+public:
+	LossyRelay(int loss_percent, int max_delay_ms) : loss_percent(loss_percent), max_delay_ms(max_delay_ms)
+	{
+		socket.bind(SocketName("127.0.0.1", relay_port));
+		server.set_endpoint(SocketName("127.0.0.1", server_port));
+		thread = std::thread(&LossyRelay::thread_main, this);
+	}
+
+	~LossyRelay()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stop_flag = true;
+		lock.unlock();
+		worker_event.notify();
+		thread.join();
+	}
+
+	int forwarded = 0;
+	int dropped = 0;
+
+private:
+	class DelayedDatagram
+	{
+	public:
+		std::vector<unsigned char> data;
+		unsigned int address;
+		unsigned short port;
+	};
+
+	void thread_main()
+	{
+		std::mt19937 random(1234);
+		std::vector<unsigned char> buffer(UDPSocket::max_batch * 1500);
+		std::vector<UDPDatagram> datagrams(UDPSocket::max_batch);
+		std::multimap<uint64_t, DelayedDatagram> delayed;
+		UDPDatagram client;
+
+		while (true)
+		{
+			for (int i = 0; i < UDPSocket::max_batch; i++)
+			{
+				datagrams[i].data = buffer.data() + i * 1500;
+				datagrams[i].size = 1500;
+			}
+
+			uint64_t now = System::get_microseconds();
+			int count = socket.read(datagrams.data(), UDPSocket::max_batch);
+			for (int i = 0; i < count; i++)
+			{
+				bool from_server = datagrams[i].address == server.address && datagrams[i].port == server.port;
+				if (!from_server)
+					client = datagrams[i];
+				else if (client.port == 0)
+					continue;
+
+				if ((int)(random() % 100) < loss_percent)
+				{
+					dropped++;
+					continue;
+				}
+
+				DelayedDatagram d;
+				const unsigned char *data = static_cast<const unsigned char *>(datagrams[i].data);
+				d.data.assign(data, data + datagrams[i].size);
+				d.address = from_server ? client.address : server.address;
+				d.port = from_server ? client.port : server.port;
+				delayed.insert(std::make_pair(now + random() % (max_delay_ms * 1000 + 1), std::move(d)));
+			}
+
+			// Everything due goes out in one batch
+			UDPDatagram due[UDPSocket::max_batch];
+			int due_count = 0;
+			auto it = delayed.begin();
+			while (it != delayed.end() && it->first <= now && due_count < UDPSocket::max_batch)
+			{
+				due[due_count].data = it->second.data.data();
+				due[due_count].size = it->second.data.size();
+				due[due_count].address = it->second.address;
+				due[due_count].port = it->second.port;
+				due_count++;
+				++it;
+			}
+			socket.send(due, due_count);
+			delayed.erase(delayed.begin(), it);
+			forwarded += due_count;
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if (stop_flag)
+				break;
+			NetworkEvent *events[] = { &socket };
+			worker_event.wait(lock, 1, events, 1);
+		}
+	}
+
+	int loss_percent;
+	int max_delay_ms;
+	UDPSocket socket;
+	UDPDatagram server;
+	std::thread thread;
+	NetworkConditionVariable worker_event;
+	std::mutex mutex;
+	bool stop_flag = false;
+};
+
+// Every channel must keep its promise while the relay drops and reorders datagrams
+void test_channels(int loss_percent)
+{
+	const int num_events = 1000;
+	const int num_large_events = 10;
+	const int large_size = 20000;
+
+	NetGameServer server;
+	NetGameClient client;
+	SlotContainer sc;
+
+	std::vector<int> ordered, unordered, sequenced, large, downstream;
+	bool large_intact = true;
+	sc.connect(server.sig_event_view_received(), [&](NetGameConnection *, const NetGameEventView &e)
+	{
+		int value = e.get_argument(0).get_integer();
+		if (e.name_equals("ordered"))
+			ordered.push_back(value);
+		else if (e.name_equals("unordered"))
+			unordered.push_back(value);
+		else if (e.name_equals("sequenced"))
+			sequenced.push_back(value);
+		else if (e.name_equals("large"))
+		{
+			large.push_back(value);
+			NetGameEventValueView data = e.get_argument(1);
+			const unsigned char *bytes = static_cast<const unsigned char *>(data.get_binary_data());
+			if (data.get_binary_size() != large_size)
+				large_intact = false;
+			for (int i = 0; large_intact && i < large_size; i++)
+				large_intact = bytes[i] == (unsigned char)(value + i * 7);
+		}
+	});
+	sc.connect(client.sig_event_view_received(), [&](const NetGameEventView &e) { downstream.push_back(e.get_argument(0).get_integer()); });
+
+	bool connected = false;
+	sc.connect(client.sig_connected(), [&]() { connected = true; });
+
+	server.start_udp("127.0.0.1", server_port);
+	LossyRelay relay(loss_percent, 20);
+	client.connect_udp("127.0.0.1", relay_port);
+	if (!process_until(server, client, [&]() { return connected; }, 5000))
+		fail("Client did not connect");
+
+	for (int i = 0; i < num_events; i++)
+	{
+		client.send_event(NetGameEvent("ordered", { i }), NetGameChannel::reliable_ordered);
+		client.send_event(NetGameEvent("unordered", { i }), NetGameChannel::reliable_unordered);
+		client.send_event(NetGameEvent("sequenced", { i }), NetGameChannel::unreliable_sequenced);
+		server.send_event(NetGameEvent("downstream", { i }), NetGameChannel::reliable_ordered);
+
+		if (i % (num_events / num_large_events) == 0)
+		{
+			int index = i / (num_events / num_large_events);
+			DataBuffer data(large_size);
+			for (int j = 0; j < large_size; j++)
+				data.get_data<unsigned char>()[j] = (unsigned char)(index + j * 7);
+			client.send_event(NetGameEvent("large", { index, data }), NetGameChannel::reliable_unordered);
+		}
+
+		if (i % 10 == 0)
+		{
+			server.process_events();
+			client.process_events();
+			System::sleep(1);
+		}
+	}
+
+	bool complete = process_until(server, client, [&]() { return ordered.size() == num_events && unordered.size() == num_events && large.size() == num_large_events && downstream.size() == num_events; }, 30000);
+	Console::write_line("  %1%% loss: %2 datagrams forwarded, %3 dropped", loss_percent, relay.forwarded, relay.dropped);
+	if (!complete)
+		fail(string_format("Reliable events were lost (ordered %1, unordered %2, large %3, downstream %4 of %5)", (int)ordered.size(), (int)unordered.size(), (int)large.size(), (int)downstream.size(), num_events));
+
+	for (int i = 0; i < num_events; i++)
+	{
+		if (ordered[i] != i || downstream[i] != i)
+			fail("Reliable ordered events arrived out of order");
+	}
+
+	std::sort(unordered.begin(), unordered.end());
+	for (int i = 0; i < num_events; i++)
+	{
+		if (unordered[i] != i)
+			fail("Reliable unordered events were duplicated");
+	}
+
+	if (!large_intact)
+		fail("Fragmented event was corrupted");
+
+	for (size_t i = 1; i < sequenced.size(); i++)
+	{
+		if (sequenced[i] <= sequenced[i - 1])
+			fail("Unreliable sequenced events arrived out of order");
+	}
+	Console::write_line("  Unreliable sequenced: %1 of %2 delivered", (int)sequenced.size(), num_events);
+}
+
+// Both ends must see a graceful close, with an empty reason, without waiting for a timeout
+void test_disconnect()
+{
+	NetGameServer server;
+	NetGameClient client;
+	SlotContainer sc;
+
+	std::vector<NetGameConnection *> connections;
+	int server_disconnects = 0;
+	std::string reason = "none";
+	bool client_connected = false, client_disconnected = false;
+	sc.connect(server.sig_client_connected(), [&](NetGameConnection *connection) { connections.push_back(connection); });
+	sc.connect(server.sig_client_disconnected(), [&](NetGameConnection *, const std::string &r) { server_disconnects++; reason = r; });
+	sc.connect(client.sig_connected(), [&]() { client_connected = true; });
+	sc.connect(client.sig_disconnected(), [&]() { client_disconnected = true; });
+
+	server.start_udp("127.0.0.1", server_port);
+
+	// Client closes
+	client.connect_udp("127.0.0.1", server_port);
+	if (!process_until(server, client, [&]() { return connections.size() == 1; }, 5000))
+		fail("Client did not connect");
+	client.disconnect();
+	if (!process_until(server, client, [&]() { return server_disconnects == 1; }, 1000))
+		fail("Server did not notice the client disconnecting");
+	if (!reason.empty())
+		fail("Graceful disconnect reported an error: " + reason);
+
+	// Server closes
+	client.connect_udp("127.0.0.1", server_port);
+	if (!process_until(server, client, [&]() { return connections.size() == 2 && client_connected; }, 5000))
+		fail("Client did not reconnect");
+	connections.back()->disconnect();
+	if (!process_until(server, client, [&]() { return client_disconnected && server_disconnects == 2; }, 1000))
+		fail("Client did not notice the server disconnecting it");
+
+	// Nobody listening
+	server.stop();
+	client_disconnected = false;
+	client.connect_udp("127.0.0.1", server_port);
+	if (!process_until(server, client, [&]() { return client_disconnected; }, 7000))
+		fail("Connecting to a closed port did not time out");
+}
+
+// Round trip of a ping sent every two milliseconds
+void measure_latency(const std::string &name, bool udp, NetGameChannel channel, int loss_percent, int seconds)
+{
+	NetGameServer server;
+	NetGameClient client;
+	SlotContainer sc;
+	uint64_t start_time = System::get_microseconds();
+	std::vector<unsigned int> latencies;
+	bool connected = false;
+
+	sc.connect(server.sig_event_view_received(), [&](NetGameConnection *connection, const NetGameEventView &e) { connection->send_event(NetGameEvent("pong", { e.get_argument(0).get_uinteger() }), channel); });
+	sc.connect(client.sig_event_view_received(), [&](const NetGameEventView &e) { latencies.push_back((unsigned int)(System::get_microseconds() - start_time) - e.get_argument(0).get_uinteger()); });
+	sc.connect(client.sig_connected(), [&]() { connected = true; });
+
+	std::unique_ptr<LossyRelay> relay;
+	if (udp)
+	{
+		server.start_udp("127.0.0.1", server_port);
+		if (loss_percent > 0)
+			relay.reset(new LossyRelay(loss_percent, 0));
+		client.connect_udp("127.0.0.1", relay ? relay_port : server_port);
+	}
+	else
+	{
+		server.start("127.0.0.1", tcp_port);
+		client.connect("127.0.0.1", tcp_port);
+	}
+
+	if (!process_until(server, client, [&]() { return connected; }, 5000))
+		fail("Client did not connect");
+
+	int sent = 0;
+	uint64_t measure_start = System::get_microseconds();
+	uint64_t next_ping = measure_start;
+	while (System::get_microseconds() - measure_start < (uint64_t)seconds * 1000000)
+	{
+		uint64_t now = System::get_microseconds();
+		if (now >= next_ping)
+		{
+			client.send_event(NetGameEvent("ping", { (unsigned int)(now - start_time) }), channel);
+			sent++;
+			next_ping += 2000;
+		}
+		server.process_events();
+		client.process_events();
+		System::sleep(0);
+	}
+	process_until(server, client, [&]() { return (int)latencies.size() == sent; }, 1000);
+
+	if (latencies.empty())
+		fail("No pings were answered");
+
+	std::sort(latencies.begin(), latencies.end());
+	unsigned int p50 = latencies[latencies.size() / 2];
+	unsigned int p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+	Console::write_line("  %1: p50 %2 us, p99 %3 us, max %4 us, %5 of %6 answered", name, p50, p99, latencies.back(), (int)latencies.size(), sent);
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int loss_percent = argc > 1 ? StringHelp::text_to_int(argv[1]) : 5;
+		int seconds = argc > 2 ? StringHelp::text_to_int(argv[2]) : 3;
+
+		Console::write_line("Channels without loss:");
+		test_channels(0);
+		Console::write_line("Channels with loss and reordering:");
+		test_channels(std::max(loss_percent, 10));
+		Console::write_line("Disconnects");
+		test_disconnect();
+
+		Console::write_line("Ping round trip without loss:");
+		measure_latency("TCP", false, NetGameChannel::reliable_ordered, 0, seconds);
+		measure_latency("UDP reliable ordered", true, NetGameChannel::reliable_ordered, 0, seconds);
+
+		Console::write_line("Ping round trip with %1%% loss:", loss_percent);
+		measure_latency("UDP reliable ordered", true, NetGameChannel::reliable_ordered, loss_percent, seconds);
+		measure_latency("UDP reliable unordered", true, NetGameChannel::reliable_unordered, loss_percent, seconds);
+		measure_latency("UDP unreliable sequenced", true, NetGameChannel::unreliable_sequenced, loss_percent, seconds);
+
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
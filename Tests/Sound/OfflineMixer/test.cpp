@@ -0,0 +1,227 @@
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace clan;
+
+// Offline rendering checks and mixer throughput benchmark
+//
+// Usage: offlinemixer [voices] [seconds] [wav file]
+//
+// Renders through an offline SoundOutput, so no sound device is needed. Checks that a session
+// is resampled to the mixing frequency correctly and that rendering is deterministic, then
+// measures how fast the mixer runs with many looping voices, serially and in parallel.
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+
+	SoundBuffer make_sine(double frequency, int rate, int length)
+	{
+		std::vector<short> samples(length);
+		for (int i = 0; i < length; i++)
+			samples[i] = (short)std::lround(std::sin(2.0 * pi * frequency * i / rate) * 32767.0);
+		return SoundBuffer(new SoundProvider_Raw(samples.data(), length, 2, false, rate));
+	}
+
+	SoundOutput make_output(int frequency, const std::string &filename = std::string())
+	{
+		SoundOutput_Description desc;
+		desc.set_mixing_frequency(frequency);
+		desc.set_offline(true);
+		desc.set_offline_filename(filename);
+		return SoundOutput(desc);
+	}
+
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+}
+
+// A 1 kHz tone at 44.1 kHz played on a 48 kHz output
+void test_session_resampling()
+{
+	SoundOutput output = make_output(48000);
+	SoundBuffer buffer = make_sine(1000.0, 44100, 44100);
+
+	SoundResampleMode modes[] = { SoundResampleMode::linear, SoundResampleMode::cubic, SoundResampleMode::sinc };
+	const char *names[] = { "linear", "cubic", "sinc" };
+	for (int m = 0; m < 3; m++)
+	{
+		SoundBuffer_Session session = buffer.prepare(false, &output);
+		session.set_resample_mode(modes[m]);
+		session.play();
+
+		std::vector<float> samples(48000 * 2);
+		output.render(samples.data(), 48000);
+
+		// Skip the start, where the filters see the silence before the sound
+		double error = 0.0;
+		for (int i = 16; i < 47000; i++)
+		{
+			double expected = std::sin(2.0 * pi * 1000.0 * i / 48000.0);
+			error = std::max(error, std::abs(samples[i * 2] - expected));
+			error = std::max(error, std::abs(samples[i * 2 + 1] - expected));
+		}
+		Console::write_line("  %1: max error %2", names[m], StringHelp::double_to_text(error, 5));
+		if (error > 0.01)
+			fail(string_format("%1 session resampling error too large", names[m]));
+
+		if (session.is_playing())
+			fail("Session did not end");
+	}
+}
+
+// Volume changes queued before play must apply from the first sample
+void test_command_order()
+{
+	SoundOutput output = make_output(44100);
+	SoundBuffer buffer = make_sine(441.0, 44100, 44100);
+
+	SoundBuffer_Session session = buffer.prepare(false, &output);
+	session.set_volume(0.5f);
+	session.play();
+
+	std::vector<float> samples(100 * 2);
+	output.render(samples.data(), 100);
+	for (int i = 0; i < 100; i++)
+	{
+		float expected = 0.5f * std::round(std::sin(2.0 * pi * 441.0 * i / 44100.0) * 32767.0) / 32767.0;
+		if (std::abs(samples[i * 2] - expected) > 1e-4f)
+			fail("Volume was not applied before the session started playing");
+	}
+
+	session.stop();
+	output.render(nullptr, 1);
+}
+
+class VoiceScene
+{
+public:
+	VoiceScene(SoundOutput &output, int num_voices, SoundResampleMode mode)
+	{
+		for (int i = 0; i < 8; i++)
+			buffers.push_back(make_sine(220.0 * (i + 1), i % 2 ? 22050 : 44100, 20000 + i * 1000));
+
+		for (int i = 0; i < num_voices; i++)
+		{
+			SoundBuffer_Session session = buffers[i % buffers.size()].prepare(true, &output);
+			session.set_resample_mode(mode);
+			session.set_volume(1.0f / num_voices);
+			session.set_pan((i % 17) / 8.0f - 1.0f);
+			session.play();
+			sessions.push_back(session);
+		}
+	}
+
+	~VoiceScene()
+	{
+		for (auto &session : sessions)
+			session.stop();
+	}
+
+	std::vector<SoundBuffer> buffers;
+	std::vector<SoundBuffer_Session> sessions;
+};
+
+std::vector<float> render_scene(int num_voices, int threads, int samples)
+{
+	SoundOutput output = make_output(48000);
+	output.set_mixing_threads(threads);
+	std::vector<float> result(samples * 2);
+	{
+		VoiceScene scene(output, num_voices, SoundResampleMode::cubic);
+		// Odd block sizes must not change the result
+		for (int pos = 0; pos < samples; pos += 777)
+			output.render(result.data() + pos * 2, std::min(777, samples - pos));
+	}
+	output.render(nullptr, 1);
+	return result;
+}
+
+// Rendering the same scene twice must give the same samples, and parallel mixing must match serial mixing
+void test_determinism()
+{
+	std::vector<float> first = render_scene(64, 1, 48000);
+	std::vector<float> second = render_scene(64, 1, 48000);
+	std::vector<float> parallel = render_scene(64, 4, 48000);
+
+	if (first != second)
+		fail("Rendering is not deterministic");
+
+	float difference = 0.0f;
+	for (size_t i = 0; i < first.size(); i++)
+		difference = std::max(difference, std::abs(first[i] - parallel[i]));
+	if (difference > 1e-5f)
+		fail("Parallel mixing does not match serial mixing");
+	if (render_scene(64, 4, 48000) != parallel)
+		fail("Parallel rendering is not deterministic");
+}
+
+void print_statistics(const std::string &title, const SoundOutput_Statistics &stats)
+{
+	double seconds = stats.samples_mixed / 48000.0;
+	Console::write_line("  %1: %2 samples/s (%3x real time)", title, (int)stats.get_samples_per_second(), StringHelp::double_to_text(stats.get_samples_per_second() / 48000.0, 1));
+	Console::write_line("    per second of audio: fill %1 ms, filter %2 ms, volume %3 ms, clamp %4 ms",
+		StringHelp::double_to_text(stats.fill_time / seconds / 1e6, 3),
+		StringHelp::double_to_text(stats.filter_time / seconds / 1e6, 3),
+		StringHelp::double_to_text(stats.volume_time / seconds / 1e6, 3),
+		StringHelp::double_to_text(stats.clamp_time / seconds / 1e6, 3));
+}
+
+void benchmark(int num_voices, int seconds, const std::string &filename)
+{
+	int max_threads = std::max((int)std::thread::hardware_concurrency(), 2);
+	SoundResampleMode modes[] = { SoundResampleMode::linear, SoundResampleMode::sinc };
+	const char *names[] = { "linear", "sinc" };
+
+	for (int m = 0; m < 2; m++)
+	{
+		for (int threads = 1; threads <= max_threads; threads = threads == 1 ? max_threads : max_threads + 1)
+		{
+			SoundOutput output = make_output(48000, m == 0 && threads == 1 ? filename : std::string());
+			output.set_mixing_threads(threads);
+
+			EchoFilter echo;
+			output.add_filter(echo);
+			{
+				VoiceScene scene(output, num_voices, modes[m]);
+				output.render(nullptr, 4800);
+				output.reset_statistics();
+				output.render(nullptr, 48000 * seconds);
+				print_statistics(string_format("%1, %2 thread(s)", names[m], threads), output.get_statistics());
+			}
+			output.render(nullptr, 1);
+			output.remove_filter(echo);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+
+		int num_voices = argc > 1 ? StringHelp::text_to_int(argv[1]) : 256;
+		int seconds = argc > 2 ? StringHelp::text_to_int(argv[2]) : 10;
+		std::string filename = argc > 3 ? argv[3] : std::string();
+
+		Console::write_line("Session resampling, 1 kHz from 44.1 to 48 kHz:");
+		test_session_resampling();
+		test_command_order();
+		test_determinism();
+
+		Console::write_line("Mixing %1 looping voices at 48 kHz with an echo filter:", num_voices);
+		benchmark(num_voices, seconds, filename);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,169 @@
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <cmath>
+#include <vector>
+
+using namespace clan;
+
+// Quality checks and voices-per-core benchmark for SoundResampler
+//
+// Usage: resampler [seconds of audio per measurement]
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+	const SoundResampleMode modes[] = { SoundResampleMode::nearest, SoundResampleMode::linear, SoundResampleMode::cubic, SoundResampleMode::sinc };
+	const char *mode_names[] = { "nearest", "linear", "cubic", "sinc" };
+
+	// Sine with silent history and lookahead margins around it
+	std::vector<float> make_sine(double frequency, double rate, int length)
+	{
+		std::vector<float> samples(length + SoundResampler::max_history + SoundResampler::max_lookahead + 1, 0.0f);
+		for (int i = 0; i < length; i++)
+			samples[SoundResampler::max_history + i] = (float)std::sin(2.0 * pi * frequency * i / rate);
+		return samples;
+	}
+
+	void fail(const std::string &message)
+	{
+		throw Exception(message);
+	}
+}
+
+// Interpolation error of a 1 kHz tone converted from 44.1 kHz to 48 kHz
+void test_accuracy()
+{
+	const double in_rate = 44100.0, out_rate = 48000.0;
+	const double max_error[] = { 0.15, 0.005, 0.001, 0.01 };
+
+	std::vector<float> input = make_sine(1000.0, in_rate, 44100);
+	std::vector<float> output(40000);
+	for (int m = 0; m < 4; m++)
+	{
+		double step = in_rate / out_rate;
+		SoundResampler::resample(modes[m], input.data(), SoundResampler::max_history, step, output.data(), (int)output.size());
+
+		// Skip the edges where the filters see the silent margins
+		double error = 0.0;
+		for (size_t i = 16; i < output.size() - 16; i++)
+			error = std::max(error, std::abs(output[i] - std::sin(2.0 * pi * 1000.0 * i / out_rate)));
+
+		Console::write_line("  %1: max error %2", mode_names[m], StringHelp::double_to_text(error, 5));
+		if (error > max_error[m])
+			fail(string_format("%1 interpolation error too large", mode_names[m]));
+	}
+}
+
+// Matching rates must copy the input untouched
+void test_fast_path()
+{
+	std::vector<float> input = make_sine(440.0, 48000.0, 1000);
+	std::vector<float> output(1000);
+	for (int m = 0; m < 4; m++)
+	{
+		double end = SoundResampler::resample(modes[m], input.data(), SoundResampler::max_history, 1.0, output.data(), (int)output.size());
+		if (end != SoundResampler::max_history + 1000.0)
+			fail("Wrong end position for matching rates");
+		for (size_t i = 0; i < output.size(); i++)
+		{
+			if (output[i] != input[SoundResampler::max_history + i])
+				fail("Matching rates did not copy the input");
+		}
+	}
+}
+
+// Splitting a conversion into blocks must give the same result as one call
+void test_blocks()
+{
+	std::vector<float> input = make_sine(440.0, 22050.0, 20000);
+	std::vector<float> whole(15000), blocks(15000);
+	double step = 22050.0 / 29999.0;
+	for (int m = 0; m < 4; m++)
+	{
+		SoundResampler::resample(modes[m], input.data(), SoundResampler::max_history, step, whole.data(), (int)whole.size());
+
+		double position = SoundResampler::max_history;
+		for (int pos = 0; pos < (int)blocks.size(); pos += 333)
+			position = SoundResampler::resample(modes[m], input.data(), position, step, blocks.data() + pos, std::min(333, (int)blocks.size() - pos));
+
+		for (size_t i = 0; i < whole.size(); i++)
+		{
+			if (std::abs(whole[i] - blocks[i]) > 1e-5f)
+				fail(string_format("%1 gives different results when converting in blocks", mode_names[m]));
+		}
+	}
+}
+
+// A 20 kHz tone converted from 48 kHz to 32 kHz is above the new Nyquist limit and should mostly vanish
+void test_aliasing()
+{
+	std::vector<float> input = make_sine(20000.0, 48000.0, 48000);
+	std::vector<float> output(30000);
+	double rms[4];
+	for (int m = 0; m < 4; m++)
+	{
+		SoundResampler::resample(modes[m], input.data(), SoundResampler::max_history, 1.5, output.data(), (int)output.size());
+		double sum = 0.0;
+		for (size_t i = 16; i < output.size() - 16; i++)
+			sum += output[i] * output[i];
+		rms[m] = std::sqrt(sum / (output.size() - 32));
+		Console::write_line("  %1: aliased tone RMS %2", mode_names[m], StringHelp::double_to_text(rms[m], 4));
+	}
+	if (rms[3] > rms[1] * 0.1)
+		fail("sinc does not suppress aliasing");
+}
+
+// How many mono voices one core can resample in real time from 44.1 kHz to 48 kHz
+void benchmark(int seconds)
+{
+	const int block = 1024;
+	std::vector<float> input = make_sine(440.0, 44100.0, 44100 * 2);
+	std::vector<float> output(block);
+	double step = 44100.0 / 48000.0;
+
+	for (int m = 0; m < 5; m++)
+	{
+		bool matching = m == 4;
+		SoundResampleMode mode = matching ? SoundResampleMode::sinc : modes[m];
+		double mode_step = matching ? 1.0 : step;
+
+		int blocks = seconds * 48000 / block;
+		double position = SoundResampler::max_history;
+		uint64_t start = System::get_microseconds();
+		for (int i = 0; i < blocks; i++)
+		{
+			position = SoundResampler::resample(mode, input.data(), position, mode_step, output.data(), block);
+			if (position > 44100)
+				position -= 44100;
+		}
+		uint64_t elapsed = std::max(System::get_microseconds() - start, (uint64_t)1);
+
+		double voices = (blocks * (double)block / 48000.0) / (elapsed / 1000000.0);
+		Console::write_line("  %1: %2 voices per core", matching ? "matching rates" : mode_names[m], (int)voices);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int seconds = argc > 1 ? StringHelp::text_to_int(argv[1]) : 60;
+
+		Console::write_line("Accuracy, 1 kHz from 44.1 to 48 kHz:");
+		test_accuracy();
+		test_fast_path();
+		test_blocks();
+		Console::write_line("Aliasing, 20 kHz from 48 to 32 kHz:");
+		test_aliasing();
+
+		Console::write_line("Mono voices resampled from 44.1 to 48 kHz in real time:");
+		benchmark(seconds);
+		Console::write_line("All Tests Complete");
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}